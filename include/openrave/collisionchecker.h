@@ -170,6 +170,26 @@ public:
     /// \brief checks collision of two links. Attached bodies are ignored. CO_ActiveDOFs option is ignored.
     virtual bool CheckCollision(KinBody::LinkConstPtr plink1, KinBody::LinkConstPtr plink2, CollisionReportPtr report = CollisionReportPtr())=0;
 
+    /// \brief checks collision of a list of link pairs in one call. Attached bodies are ignored. CO_ActiveDOFs option is ignored.
+    ///
+    /// Equivalent to calling CheckCollision(plink1, plink2) for every pair and stopping at the first collision (unless CO_AllLinkCollisions is set),
+    /// but lets the checker cull and test all the pairs together. Disabled links are ignored.
+    /// \param vlinkpairs the pairs of links to test, the links can belong to different bodies
+    /// \param[out] report [optional] collision report to be filled with data about the collision.
+    virtual bool CheckCollisionLinkPairs(const std::vector<std::pair<KinBody::LinkConstPtr, KinBody::LinkConstPtr> >& vlinkpairs, CollisionReportPtr report = CollisionReportPtr())
+    {
+        bool bCollision = false;
+        for(size_t ipair = 0; ipair < vlinkpairs.size(); ++ipair) {
+            if( CheckCollision(vlinkpairs[ipair].first, vlinkpairs[ipair].second, report) ) {
+                bCollision = true;
+                if( !(GetCollisionOptions() & CO_AllLinkCollisions) ) {
+                    break;
+                }
+            }
+        }
+        return bCollision;
+    }
+
     /// \brief checks collision of a link and a body. Attached bodies for pbody are respected. CO_ActiveDOFs option is ignored.
     virtual bool CheckCollision(KinBody::LinkConstPtr plink, KinBodyConstPtr pbody, CollisionReportPtr report = CollisionReportPtr())=0;
 
@@ -179,6 +199,17 @@ public:
     /// \brief checks collision of a body and a scene. Attached bodies are respected. If CO_ActiveDOFs is set, will only check affected links of pbody.
     virtual bool CheckCollision(KinBodyConstPtr pbody, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<KinBody::LinkConstPtr>& vlinkexcluded, CollisionReportPtr report = CollisionReportPtr())=0;
 
+    /// \brief checks collision of a body and a scene while the DOF values of the body move linearly from q0 to q1. Grabbed bodies move with the body. Self collisions are not checked.
+    ///
+    /// The state of the body is not changed. Instead of checking discrete configurations at the DOF resolutions, the checker sweeps the geometry of the
+    /// links along their motion, so a whole segment can be validated in one call. If CO_ActiveDOFs is set, will only check affected links of pbody.
+    /// Like CheckCollision, the collision callbacks of the environment are called for every contact that would become the first one, and contacts they ignore are skipped.
+    /// \param q0 DOF values at the start of the motion, the size has to be pbody->GetDOF()
+    /// \param q1 DOF values at the end of the motion, the size has to be pbody->GetDOF()
+    /// \param[out] ftimeofcontact if in collision, the fraction in [0,1] of the motion at which the body first touches the scene, otherwise 1.
+    /// \param[out] report [optional] collision report to be filled with the links in contact at ftimeofcontact, and their contacts at that time if CO_Contacts is set.
+    virtual bool CheckContinuousCollision(KinBodyConstPtr pbody, const std::vector<dReal>& q0, const std::vector<dReal>& q1, dReal& ftimeofcontact, CollisionReportPtr report = CollisionReportPtr()) OPENRAVE_DUMMY_IMPLEMENTATION;
+
     /// \brief Check collision with a link and a ray with a specified length. CO_ActiveDOFs option is ignored.
     ///
     /// \param ray holds the origin and direction. The length of the ray is the length of the direction.
@@ -200,6 +231,51 @@ public:
     /// \param[out] report [optional] collision report to be filled with data about the collision. If a body was hit, CollisionReport::plink1 contains the hit link pointer.
     virtual bool CheckCollision(const RAY& ray, CollisionReportPtr report = CollisionReportPtr()) = 0;
 
+    /** \brief Check collision of a batch of rays with the scene or a body. The collision callbacks of the environment are not called.
+
+        Equivalent to calling CheckCollision(ray, report) or CheckCollision(ray, pbody, report) for every ray, but lets the checker share
+        the broadphase between the rays and run them in parallel.
+        \param vrays holds the origins and directions. The length of a ray is the length of its direction.
+        \param[out] vdistances distance along every ray to its first hit, -1 if the ray does not hit anything.
+        \param[out] vnormals normal of the surface at every hit, zero if the ray does not hit anything.
+        \param[out] vbodyids environment id of the body hit by every ray, 0 if the ray does not hit anything.
+        \param pbody [optional] if set, the rays are only checked against this body. If CO_ActiveDOFs is set, will only check affected links of the body.
+        \return the number of rays that hit something
+     */
+    virtual int CheckCollisionRays(const std::vector<RAY>& vrays, std::vector<dReal>& vdistances, std::vector<Vector>& vnormals, std::vector<int>& vbodyids, KinBodyConstPtr pbody = KinBodyConstPtr())
+    {
+        vdistances.resize(vrays.size());
+        vnormals.resize(vrays.size());
+        vbodyids.resize(vrays.size());
+        CollisionReportPtr report(new CollisionReport());
+        int oldoptions = GetCollisionOptions();
+        SetCollisionOptions(oldoptions|CO_Distance|CO_Contacts);
+        int numhits = 0;
+        for(size_t iray = 0; iray < vrays.size(); ++iray) {
+            bool bhit;
+            try {
+                bhit = !!pbody ? CheckCollision(vrays[iray], pbody, report) : CheckCollision(vrays[iray], report);
+            }
+            catch(...) {
+                SetCollisionOptions(oldoptions);
+                throw;
+            }
+            if( bhit && !!report->plink1 ) {
+                vdistances[iray] = report->minDistance;
+                vnormals[iray] = report->contacts.size() > 0 ? report->contacts[0].norm : Vector();
+                vbodyids[iray] = report->plink1->GetParent()->GetEnvironmentId();
+                ++numhits;
+            }
+            else {
+                vdistances[iray] = -1;
+                vnormals[iray] = Vector();
+                vbodyids[iray] = 0;
+            }
+        }
+        SetCollisionOptions(oldoptions);
+        return numhits;
+    }
+
     /// \brief Check collision with a triangle mesh and a body in the scene.
     ///
     /// \param trimesh Holds a dynamic triangle mesh to check collision with the body.
@@ -76,6 +76,8 @@ public:
     /// \brief Clones the reference environment into the current environment
     ///
     /// Tries to preserve computation by re-using bodies/interfaces that are already similar between the current and reference environments.
+    /// Bodies are matched by name and kinematics geometry hash, matched bodies keep their links, geometries and collision checker data and only have their state
+    /// (transforms, dof values, enable states, grabbed bodies) copied. Keeping a pool of environments and cloning into them is much faster than calling \ref CloneSelf for every task.
     /// \param[in] cloningoptions The parts of the environment to clone. Parts not specified are left as is.
     virtual void Clone(EnvironmentBaseConstPtr preference, int cloningoptions) = 0;
 
@@ -560,6 +562,54 @@ public:
     /// is locked, the user is guaranteed that nnothing will change in the environment.
     virtual EnvironmentMutex& GetMutex() const = 0;
 
+    /// \brief Counters of how long threads waited on the environment mutex inside the environment calls.
+    ///
+    /// Only the waits of the environment methods are counted, locking GetMutex() directly from user code is not measured.
+    struct LockStatistics
+    {
+        LockStatistics() : numcontended(0), waittime(0), maxwaittime(0) {
+        }
+        uint64_t numcontended; ///< number of times the mutex was held by another thread and the caller had to wait
+        uint64_t waittime; ///< total time spent waiting in microseconds
+        uint64_t maxwaittime; ///< longest single wait in microseconds
+    };
+
+    /// \brief Enables concurrent read-only collision queries on a frozen scene. <b>[multi-thread safe]</b>
+    ///
+    /// By default every CheckCollision and CheckStandaloneSelfCollision call of the environment locks the environment mutex, so only one thread
+    /// can query the environment at a time. When enabled, these calls only take a shared lock and any number of threads can query at the same time.
+    /// Every querying thread runs on its own copy of the environment collision checker, so the caches of the checker are never shared. The copies
+    /// are created on the first query of a thread and destroyed when bodies are added or removed, the checker changes or the mode is disabled.
+    ///
+    /// Changing the scene blocks the queries until the change is done: the environment methods that add, remove or simulate bodies, and the
+    /// KinBody state setters (SetDOFValues, SetTransform, SetLinkTransformations, Enable) do this with \ref ConcurrentQueriesWriteGuard. Other changes of
+    /// the bodies have to hold a ConcurrentQueriesWriteGuard themselves. As for any change, the environment mutex has to be locked.
+    /// Calling the collision checker directly instead of the environment methods is not covered. Toggling the mode waits for all running queries to finish.
+    virtual void SetConcurrentQueries(bool bConcurrent) = 0;
+
+    /// \brief returns true if concurrent collision queries are enabled, see \ref SetConcurrentQueries
+    virtual bool IsConcurrentQueries() const = 0;
+
+    /// \brief Blocks the concurrent queries while the calling thread changes the scene, see \ref SetConcurrentQueries
+    ///
+    /// The environment mutex has to be locked. Can be nested, queries of the calling thread are still allowed.
+    /// \return a handle that releases the queries when destroyed, empty if concurrent queries are disabled or the thread already blocks them
+    virtual UserDataPtr LockConcurrentQueries() = 0;
+
+    /// \brief Blocks the concurrent queries like \ref LockConcurrentQueries without allocating a handle, prefer \ref ConcurrentQueriesWriteGuard.
+    ///
+    /// \return true if the queries were blocked and \ref UnlockConcurrentQueries has to be called, false if concurrent queries are disabled or the thread already blocks them
+    virtual bool TryLockConcurrentQueries() = 0;
+
+    /// \brief Releases the queries blocked by a successful \ref TryLockConcurrentQueries
+    virtual void UnlockConcurrentQueries() = 0;
+
+    /// \brief Returns the contention statistics of the environment mutex. <b>[multi-thread safe]</b>
+    virtual void GetLockStatistics(LockStatistics& stats) const = 0;
+
+    /// \brief Resets the contention statistics of the environment mutex. <b>[multi-thread safe]</b>
+    virtual void ResetLockStatistics() = 0;
+
     /// \name 3D plotting methods.
     /// \anchor env_plotting
     //@{
@@ -706,6 +756,27 @@ private:
     int __nUniqueId;         ///< \see RaveGetEnvironmentId
 };
 
+/// \brief Blocks the concurrent queries of an environment while in scope, see \ref EnvironmentBase::LockConcurrentQueries
+///
+/// Lives on the stack, so the state setters of the bodies do not allocate when concurrent queries are enabled.
+class ConcurrentQueriesWriteGuard
+{
+public:
+    ConcurrentQueriesWriteGuard(EnvironmentBase& env) : _penv(env.TryLockConcurrentQueries() ? &env : NULL) {
+    }
+    ~ConcurrentQueriesWriteGuard() {
+        if( !!_penv ) {
+            _penv->UnlockConcurrentQueries();
+        }
+    }
+
+private:
+    ConcurrentQueriesWriteGuard(const ConcurrentQueriesWriteGuard&);
+    ConcurrentQueriesWriteGuard& operator=(const ConcurrentQueriesWriteGuard&);
+
+    EnvironmentBase* _penv; ///< NULL if the queries were not blocked by this guard
+};
+
 } // end namespace OpenRAVE
 
 #endif
@@ -282,6 +282,18 @@ public:
      */
     virtual bool SolveAll(const IkParameterization& param, const std::vector<dReal>& vFreeParameters, int filteroptions, std::vector<IkReturnPtr>& ikreturns);
 
+    /** \brief Return all joint configurations for each of many end effector poses.
+
+        Solvers can override this to solve the poses in parallel. Poses that need only kinematic validity, i.e. the filter
+        options contain IKFO_IgnoreSelfCollisions and not IKFO_CheckEnvCollisions and no custom filter is run, can then
+        be solved without changing the robot state. The default implementation calls \ref SolveAll for every pose.
+        \param[in] vparams the poses the end effector has to achieve in the manipulator base's coordinate system.
+        \param[in] filteroptions A bitmask of \ref IkFilterOptions values controlling what is checked for each ik solution.
+        \param[out] vsolutions vsolutions[i] holds all solutions of vparams[i]
+        \return the number of poses with at least one solution
+     */
+    virtual int SolveAllBatch(const std::vector<IkParameterization>& vparams, int filteroptions, std::vector< std::vector< std::vector<dReal> > >& vsolutions);
+
     /// \brief returns true if the solver supports a particular ik parameterization as input.
     virtual bool Supports(IkParameterizationType iktype) const OPENRAVE_DUMMY_IMPLEMENTATION;
 
@@ -321,79 +321,86 @@ public:
 
             /// \brief get local geometry transform
             inline const Transform& GetTransform() const {
-                return _info._t;
+                return _pinfo->_t;
             }
             inline GeometryType GetType() const {
-                return _info._type;
+                return _pinfo->_type;
             }
             inline const Vector& GetRenderScale() const {
-                return _info._vRenderScale;
+                return _pinfo->_vRenderScale;
             }
 
             inline const std::string& GetRenderFilename() const {
-                return _info._filenamerender;
+                return _pinfo->_filenamerender;
             }
             inline float GetTransparency() const {
-                return _info._fTransparency;
+                return _pinfo->_fTransparency;
             }
             /// \deprecated (12/1/12)
             inline bool IsDraw() const RAVE_DEPRECATED {
-                return _info._bVisible;
+                return _pinfo->_bVisible;
             }
             inline bool IsVisible() const {
-                return _info._bVisible;
+                return _pinfo->_bVisible;
             }
             inline bool IsModifiable() const {
-                return _info._bModifiable;
+                return _pinfo->_bModifiable;
             }
 
             inline dReal GetSphereRadius() const {
-                return _info._vGeomData.x;
+                return _pinfo->_vGeomData.x;
             }
             inline dReal GetCylinderRadius() const {
-                return _info._vGeomData.x;
+                return _pinfo->_vGeomData.x;
             }
             inline dReal GetCylinderHeight() const {
-                return _info._vGeomData.y;
+                return _pinfo->_vGeomData.y;
             }
             inline const Vector& GetBoxExtents() const {
-                return _info._vGeomData;
+                return _pinfo->_vGeomData;
             }
             inline const Vector& GetContainerOuterExtents() const {
-                return _info._vGeomData;
+                return _pinfo->_vGeomData;
             }
             inline const Vector& GetContainerInnerExtents() const {
-                return _info._vGeomData2;
+                return _pinfo->_vGeomData2;
             }
             inline const Vector& GetContainerBottomCross() const {
-                return _info._vGeomData3;
+                return _pinfo->_vGeomData3;
             }
             inline const Vector& GetContainerBottom() const {
-                return _info._vGeomData4;
+                return _pinfo->_vGeomData4;
             }
             inline const RaveVector<float>& GetDiffuseColor() const {
-                return _info._vDiffuseColor;
+                return _pinfo->_vDiffuseColor;
             }
             inline const RaveVector<float>& GetAmbientColor() const {
-                return _info._vAmbientColor;
+                return _pinfo->_vAmbientColor;
             }
             inline const std::string& GetName() const {
-                return _info._name;
+                return _pinfo->_name;
             }
 
             /// \brief returns the local collision mesh
             inline const TriMesh& GetCollisionMesh() const {
-                return _info._meshcollision;
+                return _pinfo->_meshcollision;
             }
 
             inline const KinBody::GeometryInfo& GetInfo() const {
-                return _info;
+                return *_pinfo;
+            }
+
+            /// \brief true if the info of this geometry, including the collision mesh, is the same object as the info of other.
+            ///
+            /// The geometries of a cloned body share the infos of the reference body until one of them is modified.
+            inline bool SharesInfo(const Geometry& other) const {
+                return _pinfo == other._pinfo;
             }
 
             /// cage
             //@{
             inline const Vector& GetCageBaseExtents() const {
-                return _info._vGeomData;
+                return _pinfo->_vGeomData;
             }
 
             /// \brief compute the inner empty volume in the parent link coordinate system
@@ -443,8 +450,14 @@ public:
             virtual void SetName(const std::string& name);
 
 protected:
+            /// \brief shares the info of refgeom, used when cloning bodies
+            Geometry(boost::shared_ptr<Link> parent, const Geometry& refgeom);
+
+            /// \brief returns the info to modify, copies it first if it is shared with other geometries
+            KinBody::GeometryInfo& _GetInfoToModify();
+
             boost::weak_ptr<Link> _parent;
-            KinBody::GeometryInfo _info; ///< geometry info
+            KinBody::GeometryInfoPtr _pinfo; ///< geometry info, never empty. Shared copy-on-write with the geometries of cloned bodies, so has to be modified through _GetInfoToModify
 #ifdef RAVE_PRIVATE
 #ifdef _MSC_VER
             friend class OpenRAVEXMLParser::LinkXMLReader;
@@ -1702,6 +1715,21 @@ private:
 
     typedef boost::shared_ptr<KinBodyStateSaverRef> KinBodyStateSaverRefPtr;
 
+    /// \brief Helper class to coalesce the change callbacks of a body into one dispatch.
+    ///
+    /// While a deferrer is alive, the changed properties of the body are accumulated instead of calling the registered
+    /// callbacks. The body state, update stamp and hashes are still updated immediately. When the outermost deferrer of the
+    /// body is destroyed, every callback registered for any of the accumulated properties is called once, even if it tracks several of them. Deferrers can be nested.
+    /// Users that rely on the callbacks (like collision checkers tracking Prop_LinkTransforms) will not see the changes until the scope ends.
+    class OPENRAVE_API ChangeCallbackDeferrer
+    {
+public:
+        ChangeCallbackDeferrer(KinBody& body);
+        virtual ~ChangeCallbackDeferrer();
+protected:
+        KinBody& _body;
+    };
+
     virtual ~KinBody();
 
     /// return the static interface type this class points to (used for safe casting)
@@ -2006,6 +2034,22 @@ private:
     /// Knowing the dof branches allows the robot to recover the full state of the joints with SetLinkTransformations
     virtual void GetLinkTransformations(std::vector<Transform>& transforms, std::vector<dReal>& doflastsetvalues) const;
 
+    /** \brief computes the link transformations of many configurations at once without changing the state of the body.
+
+        The configurations are evaluated in blocks laid out as structure-of-arrays, so the transform compositions run as
+        tight loops across the configurations of a block. Joint limits are not checked, non-mimic passive joints keep
+        their current values and the base link keeps its current transform. No change callbacks are called.
+        Several threads can call this on the same body at the same time as long as no thread changes the body, every
+        thread uses its own scratch space. Mimic joints are evaluated one thread at a time.
+        \param[in] pconfigs numconfigs*GetDOF() dof values, configuration i starts at pconfigs[i*GetDOF()]
+        \param[in] numconfigs number of configurations
+        \param[out] ptransforms numconfigs*GetLinks().size() transforms, link j of configuration i is at ptransforms[i*GetLinks().size()+j]
+     */
+    virtual void ComputeLinkTransformationsBatch(const dReal* pconfigs, size_t numconfigs, Transform* ptransforms) const;
+
+    /// \brief \see ComputeLinkTransformationsBatch, vconfigs holds the configurations back to back and vtransforms is resized to hold all the link transformations
+    virtual void ComputeLinkTransformationsBatch(const std::vector<dReal>& vconfigs, std::vector<Transform>& vtransforms) const;
+
     /// \brief gets the enable states of all links
     virtual void GetLinkEnableStates(std::vector<uint8_t>& enablestates) const;
 
@@ -2599,6 +2643,9 @@ protected:
     /// recomputes the hashes if geometry changed.
     virtual void _PostprocessChangedParameters(uint32_t parameters);
 
+    /// \brief Calls every registered callback tracking any of the parameters once, or accumulates the parameters if a \ref ChangeCallbackDeferrer is alive.
+    virtual void _NotifyChangeCallbacks(uint32_t parameters);
+
     /// \brief Return true if two bodies should be considered as one during collision (ie one is grabbing the other)
     virtual bool _IsAttached(const KinBody &body, std::set<KinBodyConstPtr>& setChecked) const;
 
@@ -2627,11 +2674,58 @@ protected:
     /// Can only be called before internal robot hierarchy is initialized
     virtual void _InitAndAddJoint(JointPtr pjoint);
 
+    /// \brief one precompiled step of the forward kinematics. \see _vForwardKinematicsProgram
+    struct ForwardKinematicsOp
+    {
+        Joint* pjoint; ///< the joint the step was compiled from, used to write back _doflastsetvalues and evaluate mimic equations. Owned by _vTopologicallySortedJointsAll.
+        int type; ///< the JointType of the joint
+        int dof; ///< number of axes of the joint
+        int dofindex; ///< start index of the joint values in the dof values, -1 if the joint is passive
+        int passiveindex; ///< index into _vPassiveJoints if the joint is passive, otherwise -1
+        int parentlinkindex; ///< index of the hierarchy parent link, -1 if the joint is attached to the base link
+        int childlinkindex; ///< index of the hierarchy child link whose transform is computed by this step. If -1, the step only evaluates the mimic values since the child link is set by a previous step (closed chains).
+        bool bmimic; ///< true if any of the axes is mimic
+        boost::array<uint8_t,3> vmimic; ///< non-zero if the axis is mimic
+        boost::array<uint8_t,3> vrevolute; ///< non-zero if the axis is revolute
+        boost::array<Vector,3> vaxes; ///< same as Joint::GetInternalHierarchyAxis
+        Transform tleft, tright; ///< same as Joint::GetInternalHierarchyLeftTransform and Joint::GetInternalHierarchyRightTransform
+    };
+
+    /// \brief compiles _vTopologicallySortedJointsAll into _vForwardKinematicsProgram.
+    virtual void _BuildForwardKinematicsProgram() const;
+
+    /// \brief sets the link transformations by running _vForwardKinematicsProgram.
+    ///
+    /// Only mimic and trajectory joints allocate memory, everything else works on preallocated buffers.
+    /// \param pJointValues the dof values with the limits already checked
+    virtual void _RunForwardKinematicsProgram(const dReal* pJointValues, uint32_t checklimits);
+
+    /// \brief computes the values of all non-mimic passive joints from the current link transformations
+    ///
+    /// \param[out] vPassiveJointValues 3 values for each joint in _vPassiveJoints
+    /// \param vtempvalues scratch space for Joint::GetValues
+    virtual void _ComputePassiveJointValues(std::vector<dReal>& vPassiveJointValues, std::vector<dReal>& vtempvalues) const;
+
+    /// \brief evaluates the mimic equation of one axis of a joint and applies the joint limits.
+    ///
+    /// \param pPassiveJointValues 3 values for each joint in _vPassiveJoints
+    /// \return false if the equation could not be evaluated, in which case fvalue is not touched
+    virtual bool _EvalMimicJointValue(Joint& joint, int iaxis, const dReal* pJointValues, const dReal* pPassiveJointValues, uint32_t checklimits, dReal& fvalue) const;
+
+    /// \brief computes the relative transform of the joint given its values, does not change any state
+    ///
+    /// \param vtempdata scratch space for sampling trajectory joints
+    virtual Transform _ComputeJointTransform(const ForwardKinematicsOp& op, const dReal* pvalues, std::vector<dReal>& vtempdata) const;
+
+    /// \brief command to enable/disable _vForwardKinematicsProgram, used for comparing against the generic forward kinematics
+    virtual bool _SetUseForwardKinematicsProgramCommand(std::ostream& sout, std::istream& sinput);
+
     std::string _name; ///< name of body
     std::vector<JointPtr> _vecjoints; ///< \see GetJoints
     std::vector<JointPtr> _vTopologicallySortedJoints; ///< \see GetDependencyOrderedJoints
     std::vector<JointPtr> _vTopologicallySortedJointsAll; ///< Similar to _vDependencyOrderedJoints except includes _vecjoints and _vPassiveJoints
     std::vector<int> _vTopologicallySortedJointIndicesAll; ///< the joint indices of the joints in _vTopologicallySortedJointsAll. Passive joint indices have _vecjoints.size() added to them.
+    mutable std::vector<ForwardKinematicsOp> _vForwardKinematicsProgram; ///< precompiled forward kinematics used by SetDOFValues, one step for each joint that computes a link transform or mimic value in topological order
     std::vector<JointPtr> _vDOFOrderedJoints; ///< all joints of the body ordered on how they are arranged within the degrees of freedom
     std::vector<LinkPtr> _veclinks; ///< \see GetLinks
     std::vector<int> _vDOFIndices; ///< cached start joint indices, indexed by dof indices
@@ -2647,7 +2741,16 @@ protected:
 
     std::vector<UserDataPtr> _vGrabbedBodies; ///< vector of grabbed bodies
 
-    mutable std::vector<std::list<UserDataWeakPtr> > _vlistRegisteredCallbacks; ///< callbacks to call when particular properties of the body change. _vlistRegisteredCallbacks[index] is the list of change callbacks where 1<<index is part of KinBodyProperty, this makes it easy to find out if any particular bits have callbacks. The registration/de-registration of the lists can happen at any point and does not modify the kinbody state exposed to the user, hence it is mutable.
+    /// \brief immutable table of the registered change callbacks, [index] are the callbacks where 1<<index is part of KinBodyProperty.
+    ///
+    /// Registering or unregistering a callback builds a new table under the interface mutex and atomically swaps it in, so dispatching only loads the current table without locking or copying.
+    typedef std::vector< std::vector<UserDataWeakPtr> > ChangeCallbackTable;
+    typedef boost::shared_ptr<ChangeCallbackTable const> ChangeCallbackTableConstPtr;
+
+    mutable ChangeCallbackTableConstPtr _pRegisteredCallbacks; ///< callbacks to call when particular properties of the body change, always access with boost::atomic_load/atomic_store. The registration/de-registration can happen at any point and does not modify the kinbody state exposed to the user, hence it is mutable.
+    mutable std::atomic<uint32_t> _nRegisteredCallbackProperties; ///< mask of the properties that have at least one callback in _pRegisteredCallbacks, lets the dispatch return without touching the table when nothing is registered
+    int _nDeferChangeCallbacks; ///< number of alive ChangeCallbackDeferrer of the body
+    uint32_t _nDeferredParametersChanged; ///< parameters that changed while the callbacks were deferred
 
     mutable boost::array<std::vector<int>, 4> _vNonAdjacentLinks; ///< contains cached versions of the non-adjacent links depending on values in AdjacentOptions. Declared as mutable since data is cached.
     mutable boost::array<std::set<int>, 4> _cacheSetNonAdjacentLinks; ///< used for caching return value of GetNonAdjacentLinks.
@@ -2664,9 +2767,16 @@ protected:
     uint32_t _nHierarchyComputed; ///< 2 if the joint heirarchy and other cached information is computed. 1 if the hierarchy information is computing
     bool _bMakeJoinedLinksAdjacent; ///< if true, then automatically add adjacent links to the adjacency list so that their self-collisions are ignored.
     bool _bAreAllJoints1DOFAndNonCircular; ///< if true, then all controllable joints  of the robot are guaranteed to be either revolute or prismatic and non-circular. This allows certain functions that do operations on the joint values (like SubtractActiveDOFValues) to be optimized without calling Joint functions.
+    mutable std::atomic<bool> _bForwardKinematicsProgramValid; ///< if false, _vForwardKinematicsProgram has to be rebuilt before it can be used (joint internal information changed)
+    mutable boost::mutex _mutexForwardKinematicsProgram; ///< protects rebuilding _vForwardKinematicsProgram and evaluating the mimic equations from ComputeLinkTransformationsBatch
+    bool _bUseForwardKinematicsProgram; ///< if false, SetDOFValues always goes through the generic forward kinematics
 private:
     mutable std::string __hashkinematics;
     mutable std::vector<dReal> _vTempJoints;
+    mutable std::vector<dReal> _vPassiveJointValuesCache; ///< scratch space of 3 values per passive joint used by SetDOFValues
+    mutable std::vector<dReal> _vTempPassiveJointValues; ///< scratch space for Joint::GetValues used by SetDOFValues
+    std::vector<uint8_t> _vLinksComputedCache; ///< scratch space used by SetDOFValues
+    mutable std::vector<dReal> _vTempMimicValues, _vTempMimicEval, _vTempMimicEvalCopy; ///< scratch space for evaluating mimic equations and trajectory joints
     virtual const char* GetHash() const {
         return OPENRAVE_KINBODY_HASH;
     }
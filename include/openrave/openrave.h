@@ -55,6 +55,7 @@
 #include <set>
 #include <string>
 #include <exception>
+#include <atomic>
 
 #include <iomanip>
 #include <fstream>
@@ -548,7 +548,7 @@ typedef boost::shared_ptr<TrajectoryTimingParameters const> TrajectoryTimingPara
 class OPENRAVE_API ConstraintTrajectoryTimingParameters : public TrajectoryTimingParameters
 {
 public:
-    ConstraintTrajectoryTimingParameters() : TrajectoryTimingParameters(), maxlinkspeed(0), maxlinkaccel(0), maxmanipspeed(0), maxmanipaccel(0), vConstraintManipDir(0,0,1), vConstraintGlobalDir(0,0,1), fCosManipAngleThresh(-1), mingripperdistance(0), velocitydistancethresh(0), maxmergeiterations(1000), minswitchtime(0.2),nshortcutcycles(1), fSearchVelAccelMult(0.8), durationImprovementCutoffRatio(0.001), _bCProcessing(false) {
+    ConstraintTrajectoryTimingParameters() : TrajectoryTimingParameters(), maxlinkspeed(0), maxlinkaccel(0), maxmanipspeed(0), maxmanipaccel(0), vConstraintManipDir(0,0,1), vConstraintGlobalDir(0,0,1), fCosManipAngleThresh(-1), mingripperdistance(0), velocitydistancethresh(0), maxmergeiterations(1000), minswitchtime(0.2),nshortcutcycles(1), nshortcutthreads(0), fSearchVelAccelMult(0.8), durationImprovementCutoffRatio(0.001), _bCProcessing(false) {
         _vXMLParameters.push_back("maxlinkspeed");
         _vXMLParameters.push_back("maxlinkaccel");
         _vXMLParameters.push_back("manipname");
@@ -562,6 +562,7 @@ public:
         _vXMLParameters.push_back("maxmergeiterations");
         _vXMLParameters.push_back("minswitchtime");
         _vXMLParameters.push_back("nshortcutcycles");
+        _vXMLParameters.push_back("nshortcutthreads");
         _vXMLParameters.push_back("searchvelaccelmult");
         _vXMLParameters.push_back("durationimprovementcutoffratio");
     }
@@ -584,6 +585,7 @@ public:
     int maxmergeiterations; ///< when merging several ramps together, the order that they are merged in depends. This parameters pecifies how many permutations to test before giving up.
     dReal minswitchtime; ///< the minimum time between switching accelerations of any joint (waypoints).
     int nshortcutcycles; ///< the minimum number of times the shortcut cycle is repeated.
+    int nshortcutthreads; ///< if greater than 1, the number of threads (at most 8) that check the shortcut candidates in parallel, each in its own cloned environment. 0 or 1 checks one candidate at a time. The candidates are checked in batches of 8, so any number greater than 1 gives the same path for a seed. Parameters with custom state, neighbor or velocity constraint functions are always checked one candidate at a time, and the threads check collisions with the default filter of DynamicsCollisionConstraint.
 
     dReal fSearchVelAccelMult; ///< a number in [0.0001,0.99999] that is the multipler of the velocity/acceleration limits when time-based constraints are invalidated (manip speed and/or dynamics). The closer to 1 it is, the more optimal the trajectory will be, but it will take more time to compute. A value around 0.5-0.8 is best.
     dReal durationImprovementCutoffRatio; ///< Whenever shortcut is accepted, if change is less than diff/iterations, then do not do anymore shortcutting.
@@ -608,6 +610,7 @@ protected:
         O << "<maxmergeiterations>" << maxmergeiterations << "</maxmergeiterations>" << std::endl;
         O << "<minswitchtime>" << minswitchtime << "</minswitchtime>" << std::endl;
         O << "<nshortcutcycles>" << nshortcutcycles << "</nshortcutcycles>" << std::endl;
+        O << "<nshortcutthreads>" << nshortcutthreads << "</nshortcutthreads>" << std::endl;
         O << "<searchvelaccelmult>" << fSearchVelAccelMult << "</searchvelaccelmult>" << std::endl;
         O << "<durationimprovementcutoffratio>" << durationImprovementCutoffRatio << "</durationimprovementcutoffratio>" << std::endl;
         if( !(options & 1) ) {
@@ -627,7 +630,7 @@ protected:
         case PE_Support: return PE_Support;
         case PE_Ignore: return PE_Ignore;
         }
-        _bCProcessing = name=="maxlinkspeed" || name =="maxlinkaccel" || name=="manipname" || name=="maxmanipspeed" || name =="maxmanipaccel" || name=="mingripperdistance" || name=="velocitydistancethresh" || name=="maxmergeiterations" || name=="minswitchtime"|| name=="nshortcutcycles" || name=="constraintmanipdir" || name=="constraintglobaldir" || name=="cosmanipanglethresh" || name=="searchvelaccelmult" || name=="durationimprovementcutoffratio";
+        _bCProcessing = name=="maxlinkspeed" || name =="maxlinkaccel" || name=="manipname" || name=="maxmanipspeed" || name =="maxmanipaccel" || name=="mingripperdistance" || name=="velocitydistancethresh" || name=="maxmergeiterations" || name=="minswitchtime"|| name=="nshortcutcycles" || name=="nshortcutthreads" || name=="constraintmanipdir" || name=="constraintglobaldir" || name=="cosmanipanglethresh" || name=="searchvelaccelmult" || name=="durationimprovementcutoffratio";
         return _bCProcessing ? PE_Support : PE_Pass;
     }
 
@@ -664,6 +667,9 @@ protected:
             else if( name == "nshortcutcycles") {
                 _ss >> nshortcutcycles;
             }
+            else if( name == "nshortcutthreads") {
+                _ss >> nshortcutthreads;
+            }
             else if( name == "searchvelaccelmult") {
                 _ss >> fSearchVelAccelMult;
             }
@@ -854,6 +860,78 @@ protected:
 
 typedef boost::shared_ptr<BasicRRTParameters> BasicRRTParametersPtr;
 
+/// \brief how the workers of a parallel planner derive their random generator seeds
+enum ParallelSeedStrategy
+{
+    PSS_Sequential = 0, ///< worker i uses _nRandomGeneratorSeed+i, so planning is reproducible given the number of threads
+    PSS_Time = 1, ///< every worker is seeded from the current time, so every call explores differently
+};
+
+/// \brief parameters for planners that run several randomized planners in parallel and return the first solution.
+class OPENRAVE_API ParallelRRTParameters : public RRTParameters
+{
+public:
+    ParallelRRTParameters() : RRTParameters(), _nNumThreads(0), _nSeedStrategy(PSS_Sequential), _bProcessingParallel(false) {
+        _vXMLParameters.push_back("numthreads");
+        _vXMLParameters.push_back("seedstrategy");
+    }
+
+    int _nNumThreads; ///< number of workers planning in parallel, each in its own cloned environment. If 0 or less, uses the number of hardware threads.
+    int _nSeedStrategy; ///< one of \ref ParallelSeedStrategy
+
+protected:
+    bool _bProcessingParallel;
+    virtual bool serialize(std::ostream& O, int options=0) const
+    {
+        if( !RRTParameters::serialize(O, options|1) ) {
+            return false;
+        }
+        O << "<numthreads>" << _nNumThreads << "</numthreads>" << std::endl;
+        O << "<seedstrategy>" << _nSeedStrategy << "</seedstrategy>" << std::endl;
+        if( !(options & 1) ) {
+            O << _sExtraParameters << std::endl;
+        }
+        return !!O;
+    }
+
+    ProcessElement startElement(const std::string& name, const AttributesList& atts)
+    {
+        if( _bProcessingParallel ) {
+            return PE_Ignore;
+        }
+        switch( RRTParameters::startElement(name,atts) ) {
+        case PE_Pass: break;
+        case PE_Support: return PE_Support;
+        case PE_Ignore: return PE_Ignore;
+        }
+
+        _bProcessingParallel = name=="numthreads" || name=="seedstrategy";
+        return _bProcessingParallel ? PE_Support : PE_Pass;
+    }
+
+    virtual bool endElement(const std::string& name)
+    {
+        if( _bProcessingParallel ) {
+            if( name == "numthreads") {
+                _ss >> _nNumThreads;
+            }
+            else if( name == "seedstrategy" ) {
+                _ss >> _nSeedStrategy;
+            }
+            else {
+                RAVELOG_WARN(str(boost::format("unknown tag %s\n")%name));
+            }
+            _bProcessingParallel = false;
+            return false;
+        }
+
+        // give a chance for the rrt parameters to get processed
+        return RRTParameters::endElement(name);
+    }
+};
+
+typedef boost::shared_ptr<ParallelRRTParameters> ParallelRRTParametersPtr;
+
 } // OpenRAVE
 
 #endif
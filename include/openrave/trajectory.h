@@ -94,6 +94,26 @@ public:
      */
     virtual void SamplePoints(std::vector<dReal>& data, const std::vector<dReal>& times, const ConfigurationSpecification& spec) const;
 
+    /** \brief bulk samples the trajectory at evenly spaced times using the trajectory's specification.
+
+        The times are tstart + i*deltatime for all i such that the time is <= tend. The default implementation builds the times and calls SamplePoints.
+        \param data[out] the sampled points for every time
+        \param tstart[in] the first time to sample
+        \param tend[in] the last time to sample, included if it lies on the grid
+        \param deltatime[in] the time between two samples, has to be positive
+     */
+    virtual void SampleRange(std::vector<dReal>& data, dReal tstart, dReal tend, dReal deltatime) const;
+
+    /** \brief bulk samples the trajectory at evenly spaced times and returns data in a specific configuration specification.
+
+        \param data[out] the sampled points for every time
+        \param tstart[in] the first time to sample
+        \param tend[in] the last time to sample, included if it lies on the grid
+        \param deltatime[in] the time between two samples, has to be positive
+        \param spec[in] the specification format to return the data in
+     */
+    virtual void SampleRange(std::vector<dReal>& data, dReal tstart, dReal tend, dReal deltatime, const ConfigurationSpecification& spec) const;
+
     virtual const ConfigurationSpecification& GetConfigurationSpecification() const = 0;
 
     /// \brief return the number of waypoints
@@ -178,6 +198,9 @@ protected:
         return boost::static_pointer_cast<TrajectoryBase const>(shared_from_this());
     }
 
+    /// \brief returns the number of times SampleRange samples, throws if deltatime is not positive
+    static size_t _GetNumRangeSamples(dReal tstart, dReal tend, dReal deltatime);
+
 private:
     virtual const char* GetHash() const {
         return OPENRAVE_TRAJECTORY_HASH;
@@ -0,0 +1,330 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 agent <agent@local>
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef OPENRAVE_BASEDEPTHCAMERA_H
+#define OPENRAVE_BASEDEPTHCAMERA_H
+
+#include "basecamera.h"
+
+/// \brief pinhole camera that renders depth images and organized point clouds by casting rays against the collision geometry, so it does not need a viewer.
+///
+/// The camera looks along its z-axis, the x-axis points to the right of the image and the y-axis down.
+class BaseDepthCameraSensor : public BaseCameraSensor
+{
+protected:
+    class BaseDepthCameraXMLReader : public BaseCameraXMLReader
+    {
+public:
+        BaseDepthCameraXMLReader(boost::shared_ptr<BaseDepthCameraSensor> psensor) : BaseCameraXMLReader(psensor), _bProcessing(false) {
+        }
+
+        virtual ProcessElement startElement(const std::string& name, const AttributesList& atts)
+        {
+            if( _bProcessing ) {
+                return PE_Ignore;
+            }
+            switch( BaseCameraXMLReader::startElement(name,atts) ) {
+            case PE_Pass: break;
+            case PE_Support: return PE_Support;
+            case PE_Ignore: return PE_Ignore;
+            }
+
+            _bProcessing = name == "max_range" || name == "maxrange" || name == "progressive";
+            if( _bProcessing ) {
+                ss.str("");
+            }
+            return _bProcessing ? PE_Support : PE_Pass;
+        }
+
+        virtual bool endElement(const string& name)
+        {
+            if( _bProcessing ) {
+                boost::shared_ptr<BaseDepthCameraSensor> psensor = boost::dynamic_pointer_cast<BaseDepthCameraSensor>(_psensor);
+                if( name == "max_range" || name == "maxrange" ) {
+                    ss >> psensor->_fMaxRange;
+                }
+                else if( name == "progressive" ) {
+                    ss >> psensor->_bProgressive;
+                }
+                else {
+                    RAVELOG_WARN("invalid tag\n");
+                }
+                if( !ss ) {
+                    RAVELOG_WARN(str(boost::format("error parsing %s\n")%name));
+                }
+                _bProcessing = false;
+                return false;
+            }
+            return BaseCameraXMLReader::endElement(name);
+        }
+
+private:
+        bool _bProcessing;
+    };
+
+public:
+    static BaseXMLReaderPtr CreateXMLReader(InterfaceBasePtr ptr, const AttributesList& atts)
+    {
+        return BaseXMLReaderPtr(new BaseDepthCameraXMLReader(boost::dynamic_pointer_cast<BaseDepthCameraSensor>(ptr)));
+    }
+
+    BaseDepthCameraSensor(EnvironmentBasePtr penv) : BaseCameraSensor(penv) {
+        __description = ":Interface Author: agent\n\nProvides a simulated depth camera that casts rays against the collision geometry of the environment, so it works without a viewer. Includes all the XML parameters from :ref:`sensor-basecamera` along with:\n\
+* max_range - maximum distance of the measurements (default 10)\n\
+* progressive - if 1, every image is first cast at a quarter of the resolution and refined over the next simulation steps (default 0)\n\
+\n\
+The ST_Camera data holds the depth along the optical axis of every pixel as 32-bit floats in the rows of the image, 0 where nothing was hit. \
+The ST_Laser data holds the organized point cloud: the ranges are the direction*distance of every pixel in world coordinates in the same order as the image, the intensity is 1 where something was hit.";
+        RegisterCommand("SetProgressive",boost::bind(&BaseDepthCameraSensor::_SetProgressiveCommand,this,_1,_2),
+                        "Set progressive casting of the images (1 or 0).");
+        _plaserdata.reset(new LaserSensorData());
+        _channelformat = "float32";
+        _fMaxRange = 10;
+        _bProgressive = false;
+        _beamwidth = _beamheight = 0;
+        _fImageStamp = 0;
+        _nStride = 0;
+        _nCastStride = 1;
+    }
+
+    virtual bool SimulationStep(dReal fTimeElapsed)
+    {
+        _RenderGeometry();
+        if( _pgeom->width <= 0 || _pgeom->height <= 0 || !_bPower ) {
+            return true;
+        }
+        _fTimeToImage -= fTimeElapsed;
+        if( _fTimeToImage <= 0 ) {
+            _fTimeToImage = 1 / (float)framerate;
+            if( _pgeom->width != _beamwidth || _pgeom->height != _beamheight || _pgeom->KK.fx != _beamKK[0] || _pgeom->KK.fy != _beamKK[1] || _pgeom->KK.cx != _beamKK[2] || _pgeom->KK.cy != _beamKK[3] ) {
+                _UpdateBeams();
+            }
+            // start a new image
+            _tImage = _trans;
+            _fImageStamp = GetEnv()->GetSimulationTime();
+            _nStride = _bProgressive ? s_nCoarseStride : 1;
+            _nCastStride = _nStride; // nothing of the new image is cast yet, the previous image could have stopped at any stride
+        }
+        else if( _nStride > 1 ) {
+            // refine the current image
+            _nStride /= 2;
+        }
+        else {
+            return true;
+        }
+
+        _CastPixels(_nStride);
+        _PublishImage();
+        if( _nStride == 1 ) {
+            _nStride = 0;
+        }
+        return true;
+    }
+
+    virtual SensorDataPtr CreateSensorData(SensorType type)
+    {
+        if( type == ST_Laser ) {
+            return SensorDataPtr(new LaserSensorData());
+        }
+        return BaseCameraSensor::CreateSensorData(type);
+    }
+
+    virtual bool GetSensorData(SensorDataPtr psensordata)
+    {
+        if( _bPower && psensordata->GetType() == ST_Laser ) {
+            boost::mutex::scoped_lock lock(_mutexdata);
+            if( _plaserdata->ranges.size() > 0 ) {
+                *boost::dynamic_pointer_cast<LaserSensorData>(psensordata) = *_plaserdata;
+                return true;
+            }
+            return false;
+        }
+        return BaseCameraSensor::GetSensorData(psensordata);
+    }
+
+    virtual bool Supports(SensorType type) {
+        return type == ST_Camera || type == ST_Laser;
+    }
+
+    virtual void Clone(InterfaceBaseConstPtr preference, int cloningoptions)
+    {
+        boost::shared_ptr<BaseDepthCameraSensor const> r = boost::dynamic_pointer_cast<BaseDepthCameraSensor const>(preference);
+        _fMaxRange = r->_fMaxRange;
+        _bProgressive = r->_bProgressive;
+        BaseCameraSensor::Clone(preference,cloningoptions);
+    }
+
+    virtual void _Reset()
+    {
+        BaseCameraSensor::_Reset();
+        {
+            boost::mutex::scoped_lock lock(_mutexdata);
+            _plaserdata->positions.resize(0);
+            _plaserdata->ranges.resize(0);
+            _plaserdata->intensity.resize(0);
+        }
+        _nStride = 0;
+        _nCastStride = 1;
+        _beamwidth = _beamheight = 0;
+    }
+
+protected:
+    /// \brief computes the unit directions of the rays of all the pixels in the camera frame and the order the pixels are cast in
+    ///
+    /// The pixels are cast in square tiles of s_nTileSize, so that the consecutive rays handed out to the threads of the collision checker are close to each other.
+    void _UpdateBeams()
+    {
+        int width = _pgeom->width, height = _pgeom->height;
+        _beamwidth = width;
+        _beamheight = height;
+        _beamKK[0] = _pgeom->KK.fx; _beamKK[1] = _pgeom->KK.fy; _beamKK[2] = _pgeom->KK.cx; _beamKK[3] = _pgeom->KK.cy;
+        _vBeamDirections.resize(width*height);
+        for(int v = 0; v < height; ++v) {
+            for(int u = 0; u < width; ++u) {
+                Vector vdir((u-_pgeom->KK.cx)/_pgeom->KK.fx, (v-_pgeom->KK.cy)/_pgeom->KK.fy, 1);
+                _vBeamDirections[v*width+u] = vdir.normalize3();
+            }
+        }
+        _vTileOrder.resize(0);
+        _vTileOrder.reserve(width*height);
+        for(int vtile = 0; vtile < height; vtile += s_nTileSize) {
+            for(int utile = 0; utile < width; utile += s_nTileSize) {
+                for(int v = vtile; v < min(height, vtile+s_nTileSize); ++v) {
+                    for(int u = utile; u < min(width, utile+s_nTileSize); ++u) {
+                        _vTileOrder.push_back(v*width+u);
+                    }
+                }
+            }
+        }
+        _vdistances.resize(width*height);
+        _vbodyids.resize(width*height);
+        _vdepth.resize(width*height);
+    }
+
+    /// \brief casts the pixels on the grid of the stride that were not cast by the coarser grids and fills the other pixels of the grid cells with their values
+    void _CastPixels(int stride)
+    {
+        int width = _beamwidth;
+        _vcastpixels.resize(0);
+        FOREACHC(itpixel, _vTileOrder) {
+            int u = *itpixel % width, v = *itpixel / width;
+            if( u % stride != 0 || v % stride != 0 ) {
+                continue;
+            }
+            if( stride < _nCastStride && u % (2*stride) == 0 && v % (2*stride) == 0 ) {
+                continue; // already cast with the coarser grid of this image
+            }
+            _vcastpixels.push_back(*itpixel);
+        }
+        _nCastStride = stride;
+
+        _vrays.resize(_vcastpixels.size());
+        for(size_t i = 0; i < _vcastpixels.size(); ++i) {
+            _vrays[i].pos = _tImage.trans;
+            _vrays[i].dir = _fMaxRange*_tImage.rotate(_vBeamDirections[_vcastpixels[i]]);
+        }
+        {
+            EnvironmentMutex::scoped_lock lockenv(GetEnv()->GetMutex());
+            GetEnv()->GetCollisionChecker()->CheckCollisionRays(_vrays, _vraydistances, _vraynormals, _vraybodyids);
+        }
+        for(size_t i = 0; i < _vcastpixels.size(); ++i) {
+            int index = _vcastpixels[i];
+            _vdistances[index] = _vraybodyids[i] != 0 ? _vraydistances[i] : -1;
+            _vbodyids[index] = _vraybodyids[i];
+        }
+
+        if( stride > 1 ) {
+            // fill every pixel with the value of the closest grid pixel above and to the left of it
+            for(int index = 0; index < width*_beamheight; ++index) {
+                int u = index % width, v = index / width;
+                int gridindex = (v - v % stride)*width + (u - u % stride);
+                if( gridindex != index ) {
+                    _vdistances[index] = _vdistances[gridindex];
+                    _vbodyids[index] = _vbodyids[gridindex];
+                }
+            }
+        }
+    }
+
+    /// \brief copies the current image to the depth image and the point cloud
+    void _PublishImage()
+    {
+        size_t numpixels = _vBeamDirections.size();
+        for(size_t index = 0; index < numpixels; ++index) {
+            // the z-coordinate of the unit direction converts the distance along the ray to the depth along the optical axis
+            _vdepth[index] = _vdistances[index] >= 0 ? float(_vdistances[index]*_vBeamDirections[index].z) : 0.0f;
+        }
+
+        boost::mutex::scoped_lock lock(_mutexdata);
+        _pdata->vimagedata.resize(numpixels*sizeof(float));
+        if( numpixels > 0 ) {
+            memcpy(&_pdata->vimagedata[0], &_vdepth[0], numpixels*sizeof(float));
+        }
+        _pdata->__stamp = _fImageStamp;
+        _pdata->__trans = _tImage;
+
+        _plaserdata->__stamp = _fImageStamp;
+        _plaserdata->__trans = _tImage;
+        _plaserdata->positions.resize(1);
+        _plaserdata->positions[0] = _tImage.trans;
+        _plaserdata->ranges.resize(numpixels);
+        _plaserdata->intensity.resize(numpixels);
+        for(size_t index = 0; index < numpixels; ++index) {
+            Vector vdir = _tImage.rotate(_vBeamDirections[index]);
+            if( _vdistances[index] >= 0 ) {
+                _plaserdata->ranges[index] = vdir*_vdistances[index];
+                _plaserdata->intensity[index] = 1;
+            }
+            else {
+                _plaserdata->ranges[index] = vdir*_fMaxRange;
+                _plaserdata->intensity[index] = 0;
+            }
+        }
+    }
+
+    bool _SetProgressiveCommand(ostream& sout, istream& sinput)
+    {
+        sinput >> _bProgressive;
+        return !!sinput;
+    }
+
+    static const int s_nTileSize = 8; ///< side of the square tiles of pixels cast together, 64 rays
+    static const int s_nCoarseStride = 4; ///< stride of the first grid of pixels cast in progressive mode
+
+    boost::shared_ptr<LaserSensorData> _plaserdata; ///< organized point cloud, protected by _mutexdata
+    dReal _fMaxRange;
+    bool _bProgressive;
+
+    int _beamwidth, _beamheight; ///< image dimensions _vBeamDirections was computed for
+    dReal _beamKK[4]; ///< intrinsics _vBeamDirections was computed for
+    vector<Vector> _vBeamDirections; ///< unit direction of the ray of every pixel in the camera frame, in the order of the image
+    vector<int> _vTileOrder; ///< indices of all the pixels in the order they are cast
+
+    Transform _tImage; ///< transform of the camera when the current image was started
+    dReal _fImageStamp;
+    int _nStride; ///< stride of the last grid cast for the current image, 0 if the image is complete
+    int _nCastStride; ///< stride of the last grid cast, used by _CastPixels to skip the pixels of the coarser grids
+    vector<dReal> _vdistances; ///< distance along the ray of every pixel of the current image, -1 if nothing was hit
+    vector<int> _vbodyids; ///< id of the body hit by every pixel of the current image
+    vector<float> _vdepth;
+
+    vector<int> _vcastpixels; ///< pixels cast in the current call of _CastPixels
+    vector<RAY> _vrays;
+    vector<dReal> _vraydistances;
+    vector<Vector> _vraynormals;
+    vector<int> _vraybodyids;
+};
+
+#endif
@@ -143,7 +143,6 @@ public:
 
         _pgeom.reset(new BaseFlashLidar3DGeom());
         _pdata.reset(new LaserSensorData());
-        _report.reset(new CollisionReport());
 
         _bRenderData = false;
         _bRenderGeometry = true;
@@ -205,54 +204,42 @@ public:
         if(( _fTimeToScan <= 0) && _bPower ) {
             _fTimeToScan = _pgeom->time_scan;
 
-            RAY r;
-
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(CO_Distance);
             Transform t;
 
             {
                 // Lock the data mutex and fill with the range data (get all in one timestep)
                 boost::mutex::scoped_lock lock(_mutexdata);
+                if( (int)_vBeamDirections.size() != _pgeom->width*_pgeom->height ) {
+                    _UpdateBeams();
+                }
                 t = GetTransform();
                 _pdata->__trans = t;
                 _pdata->__stamp = GetEnv()->GetSimulationTime();
-
-                r.pos = t.trans;
                 _pdata->positions.at(0) = t.trans;
 
-                for(int w = 0; w < _pgeom->width; ++w) {
-                    for(int h = 0; h < _pgeom->height; ++h) {
-                        Vector vdir;
-                        vdir.x = (float)w*_iKK[0] + _iKK[2];
-                        vdir.y = (float)h*_iKK[1] + _iKK[3];
-                        vdir.z = 1.0f;
-                        vdir = t.rotate(vdir.normalize3());
-                        r.dir = _pgeom->max_range*vdir;
-
-                        int index = w*_pgeom->height+h;
-
-                        if( GetEnv()->CheckCollision(r, _report)) {
-                            _pdata->ranges[index] = vdir*_report->minDistance;
-                            _pdata->intensity[index] = 1;
-                            // store the colliding bodies
-                            KinBody::LinkConstPtr plink = !!_report->plink1 ? _report->plink1 : _report->plink2;
-                            if( !!plink ) {
-                                _databodyids[index] = plink->GetParent()->GetEnvironmentId();
-                            }
-                        }
-                        else {
-                            _databodyids[index] = 0;
-                            _pdata->ranges[index] = vdir*_pgeom->max_range;
-                            _pdata->intensity[index] = 0;
-                        }
+                // cast all the beams of the image in one query
+                _vrays.resize(_vBeamDirections.size());
+                for(size_t index = 0; index < _vBeamDirections.size(); ++index) {
+                    _vrays[index].pos = t.trans;
+                    _vrays[index].dir = _pgeom->max_range*t.rotate(_vBeamDirections[index]);
+                }
+                {
+                    EnvironmentMutex::scoped_lock lockenv(GetEnv()->GetMutex());
+                    GetEnv()->GetCollisionChecker()->CheckCollisionRays(_vrays, _vdistances, _vnormals, _databodyids);
+                }
+                for(size_t index = 0; index < _vrays.size(); ++index) {
+                    Vector vdir = t.rotate(_vBeamDirections[index]);
+                    if( _databodyids[index] != 0 ) {
+                        _pdata->ranges[index] = vdir*_vdistances[index];
+                        _pdata->intensity[index] = 1;
+                    }
+                    else {
+                        _pdata->ranges[index] = vdir*_pgeom->max_range;
+                        _pdata->intensity[index] = 0;
                     }
                 }
-
-                _report->Reset();
             }
 
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(0);
-
             if( _bRenderData ) {
                 // If can render, check if some time passed before last update
                 list<GraphHandlePtr> listhandles;
@@ -373,15 +360,9 @@ public:
 protected:
     virtual void _Reset()
     {
-        _iKK[0] = 1.0f / _pgeom->KK.fx;
-        _iKK[1] = 1.0f / _pgeom->KK.fy;
-        _iKK[2] = -_pgeom->KK.cx / _pgeom->KK.fx;
-        _iKK[3] = -_pgeom->KK.cy / _pgeom->KK.fy;
         _listGraphicsHandles.clear();
         _pdata->positions.resize(1);
-        _pdata->ranges.resize(_pgeom->width*_pgeom->height);
-        _pdata->intensity.resize(_pgeom->width*_pgeom->height);
-        _databodyids.resize(_pgeom->width*_pgeom->height);
+        _UpdateBeams();
         FOREACH(it, _pdata->ranges) {
             *it = Vector(0,0,0);
         }
@@ -390,6 +371,25 @@ protected:
         }
     }
 
+    /// \brief computes _iKK, resizes the scan data and computes the directions of the beams in the sensor frame
+    void _UpdateBeams()
+    {
+        _iKK[0] = 1.0f / _pgeom->KK.fx;
+        _iKK[1] = 1.0f / _pgeom->KK.fy;
+        _iKK[2] = -_pgeom->KK.cx / _pgeom->KK.fx;
+        _iKK[3] = -_pgeom->KK.cy / _pgeom->KK.fy;
+        _pdata->ranges.resize(_pgeom->width*_pgeom->height);
+        _pdata->intensity.resize(_pgeom->width*_pgeom->height);
+        _databodyids.resize(_pgeom->width*_pgeom->height);
+        _vBeamDirections.resize(_pgeom->width*_pgeom->height);
+        for(int w = 0; w < _pgeom->width; ++w) {
+            for(int h = 0; h < _pgeom->height; ++h) {
+                Vector vdir((dReal)w*_iKK[0] + _iKK[2], (dReal)h*_iKK[1] + _iKK[3], 1);
+                _vBeamDirections[w*_pgeom->height+h] = vdir.normalize3();
+            }
+        }
+    }
+
     void _RenderGeometry()
     {
         if( !_bRenderGeometry ) {
@@ -425,7 +425,10 @@ protected:
     boost::shared_ptr<BaseFlashLidar3DGeom> _pgeom;
     boost::shared_ptr<LaserSensorData> _pdata;
     vector<int> _databodyids;     ///< if non 0, for each point in _data, specifies the body that was hit
-    CollisionReportPtr _report;
+    vector<Vector> _vBeamDirections; ///< unit directions of the beams in the sensor frame, recomputed by _UpdateBeams
+    vector<RAY> _vrays; ///< rays of the current scan
+    vector<dReal> _vdistances;
+    vector<Vector> _vnormals;
     // more geom stuff
     RaveVector<float> _vColor;
     dReal _iKK[4];     // inverse of KK
@@ -144,7 +144,6 @@ public:
         _pgeom->max_range = 100;
         _fTimeToScan = 0;
         _vColor = RaveVector<float>(0.5f,0.5f,1,1);
-        _report.reset(new CollisionReport());
         _bPower = false;
         _bRenderData = false;
         _bRenderGeometry = true;
@@ -197,47 +196,43 @@ public:
         _fTimeToScan -= fTimeElapsed;
         if( _bPower &&( _fTimeToScan <= 0) ) {
             _fTimeToScan = _pgeom->time_scan;
-            Vector rotaxis(0,0,1);
-            RAY r;
-
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(CO_Distance);
             Transform t;
 
             {
                 // Lock the data mutex and fill with the range data (get all in one timestep)
                 boost::mutex::scoped_lock lock(_mutexdata);
+                if( _pgeom->min_angle[0] != _vBeamAngles[0] || _pgeom->max_angle[0] != _vBeamAngles[1] || _pgeom->resolution[0] != _vBeamAngles[2] ) {
+                    _UpdateBeams();
+                }
                 _pdata->__trans = GetTransform();
                 _pdata->__stamp = GetEnv()->GetSimulationTime();
                 t = GetLaserPlaneTransform();
                 _pdata->positions.at(0) = t.trans;
-                size_t index = 0;
-                for(dReal frotangle = _pgeom->min_angle[0]; frotangle <= _pgeom->max_angle[0]; frotangle += _pgeom->resolution[0], ++index) {
-                    if( index >= _pdata->ranges.size() ) {
-                        break;
-                    }
-                    Vector vdir(t.rotate(quatRotate(quatFromAxisAngle(rotaxis, (dReal)frotangle),Vector(1,0,0))));
-                    r.pos = t.trans+_pgeom->min_range*vdir;
-                    r.dir = (_pgeom->max_range-_pgeom->min_range)*vdir;
 
-                    if( GetEnv()->CheckCollision(r, _report)) {
-                        _pdata->ranges[index] = vdir*(_report->minDistance+_pgeom->min_range);
+                // cast all the beams of the scan in one query
+                _vrays.resize(_vBeamDirections.size());
+                for(size_t index = 0; index < _vBeamDirections.size(); ++index) {
+                    Vector vdir = t.rotate(_vBeamDirections[index]);
+                    _vrays[index].pos = t.trans+_pgeom->min_range*vdir;
+                    _vrays[index].dir = (_pgeom->max_range-_pgeom->min_range)*vdir;
+                }
+                {
+                    EnvironmentMutex::scoped_lock lockenv(GetEnv()->GetMutex());
+                    GetEnv()->GetCollisionChecker()->CheckCollisionRays(_vrays, _vdistances, _vnormals, _databodyids);
+                }
+                for(size_t index = 0; index < _vrays.size(); ++index) {
+                    Vector vdir = t.rotate(_vBeamDirections[index]);
+                    if( _databodyids[index] != 0 ) {
+                        _pdata->ranges[index] = vdir*(_vdistances[index]+_pgeom->min_range);
                         _pdata->intensity[index] = 1;
-                        // store the colliding bodies
-                        KinBody::LinkConstPtr plink = !!_report->plink1 ? _report->plink1 : _report->plink2;
-                        if( !!plink ) {
-                            _databodyids[index] = plink->GetParent()->GetEnvironmentId();
-                        }
                     }
                     else {
-                        _databodyids[index] = 0;
                         _pdata->ranges[index] = vdir*_pgeom->max_range;
                         _pdata->intensity[index] = 0;
                     }
                 }
             }
 
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(0);
-
             if( _bRenderData ) {
                 // If can render, check if some time passed before last update
                 list<GraphHandlePtr> listhandles;
@@ -279,8 +274,6 @@ public:
             else {
                 _listGraphicsHandles.clear();
             }
-
-            _report->Reset();
         }
 
         return true;
@@ -370,17 +363,8 @@ protected:
     virtual void _Reset()
     {
         boost::mutex::scoped_lock lock(_mutexdata);
-        int N;
-        if( _pgeom->resolution[0] > 0 ) {
-            N = (int)( (_pgeom->max_angle[0]-_pgeom->min_angle[0])/_pgeom->resolution[0] + 0.5f)+1;
-        }
-        else {
-            N = 1;
-        }
+        _UpdateBeams();
         _pdata->positions.resize(1);
-        _pdata->ranges.resize(N);
-        _pdata->intensity.resize(N);
-        _databodyids.resize(N);
         FOREACH(it, _pdata->ranges) {
             *it = Vector(0,0,0);
         }
@@ -393,6 +377,29 @@ protected:
         _RenderGeometry();
     }
 
+    /// \brief resizes the scan data and computes the directions of the beams in the laser plane from the angles of _pgeom. _mutexdata has to be locked.
+    void _UpdateBeams()
+    {
+        int N;
+        if( _pgeom->resolution[0] > 0 ) {
+            N = (int)( (_pgeom->max_angle[0]-_pgeom->min_angle[0])/_pgeom->resolution[0] + 0.5f)+1;
+        }
+        else {
+            N = 1;
+        }
+        _pdata->ranges.resize(N);
+        _pdata->intensity.resize(N);
+        _databodyids.resize(N);
+        _vBeamDirections.resize(N);
+        for(int i = 0; i < N; ++i) {
+            dReal fangle = _pgeom->min_angle[0] + i*_pgeom->resolution[0];
+            _vBeamDirections[i] = Vector(RaveCos(fangle), RaveSin(fangle), 0);
+        }
+        _vBeamAngles[0] = _pgeom->min_angle[0];
+        _vBeamAngles[1] = _pgeom->max_angle[0];
+        _vBeamAngles[2] = _pgeom->resolution[0];
+    }
+
     void _RenderGeometry()
     {
         if( !_bRenderGeometry ) {
@@ -431,7 +438,11 @@ protected:
     boost::shared_ptr<LaserGeomData> _pgeom;
     boost::shared_ptr<LaserSensorData> _pdata;
     vector<int> _databodyids;     ///< if non 0, for each point in _data, specifies the body that was hit
-    CollisionReportPtr _report;
+    vector<Vector> _vBeamDirections; ///< unit directions of the beams in the laser plane, recomputed by _UpdateBeams
+    dReal _vBeamAngles[3]; ///< min angle, max angle and resolution _vBeamDirections was computed with
+    vector<RAY> _vrays; ///< rays of the current scan
+    vector<dReal> _vdistances;
+    vector<Vector> _vnormals;
 
     // more geom stuff
     RaveVector<float> _vColor;
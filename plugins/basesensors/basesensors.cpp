@@ -16,6 +16,7 @@
 #include "baselaser.h"
 #include "baseflashlidar3d.h"
 #include "basecamera.h"
+#include "basedepthcamera.h"
 #include <openrave/plugin.h>
 
 static list< UserDataPtr >* s_listRegisteredReaders = NULL; ///< have to make it a pointer in order to prevent static object destruction from taking precedence
@@ -30,6 +31,7 @@ InterfaceBasePtr CreateInterfaceValidated(InterfaceType type, const std::string&
         s_listRegisteredReaders->push_back(RaveRegisterXMLReader(PT_Sensor,"base_laser3d",BaseFlashLidar3DSensor::CreateXMLReader));
         s_listRegisteredReaders->push_back(RaveRegisterXMLReader(PT_Sensor,"basecamera",BaseCameraSensor::CreateXMLReader));
         s_listRegisteredReaders->push_back(RaveRegisterXMLReader(PT_Sensor,"base_pinhole_camera",BaseCameraSensor::CreateXMLReader));
+        s_listRegisteredReaders->push_back(RaveRegisterXMLReader(PT_Sensor,"basedepthcamera",BaseDepthCameraSensor::CreateXMLReader));
     }
     switch(type) {
     case PT_Sensor:
@@ -45,6 +47,9 @@ InterfaceBasePtr CreateInterfaceValidated(InterfaceType type, const std::string&
         else if((interfacename == "basecamera")||(interfacename == "base_pinhole_camera")) {
             return InterfaceBasePtr(new BaseCameraSensor(penv));
         }
+        else if( interfacename == "basedepthcamera" ) {
+            return InterfaceBasePtr(new BaseDepthCameraSensor(penv));
+        }
         break;
     default:
         break;
@@ -61,6 +66,7 @@ void GetPluginAttributesValidated(PLUGININFO& info)
     info.interfacenames[OpenRAVE::PT_Sensor].push_back("base_laser3d");
     info.interfacenames[OpenRAVE::PT_Sensor].push_back("BaseCamera");
     info.interfacenames[OpenRAVE::PT_Sensor].push_back("base_pinhole_camera");
+    info.interfacenames[OpenRAVE::PT_Sensor].push_back("BaseDepthCamera");
 }
 
 OPENRAVE_PLUGIN_API void DestroyPlugin()
@@ -47,9 +47,11 @@ public:
         RegisterCommand("UpdateFreeConfigurations",boost::bind(&CacheCollisionChecker::_UpdateFreeConfigurationsCommand,this,_1,_2),
                         "remove all free nodes that overlap with this body. [bodyname]");
         RegisterCommand("SaveCache",boost::bind(&CacheCollisionChecker::_SaveCacheCommand,this,_1,_2),
-                        "save self collision cache");
+                        "merge the self collision cache, the cache file on disk and its write-ahead log into the cache file. Returns the number of logged configurations merged.");
         RegisterCommand("LoadCache",boost::bind(&CacheCollisionChecker::_LoadCacheCommand,this,_1,_2),
-                        "load self collision cache");
+                        "load the self collision cache file into memory");
+        RegisterCommand("SetSelfCacheConcurrent",boost::bind(&CacheCollisionChecker::_SetSelfCacheConcurrentCommand,this,_1,_2),
+                        "if 1, the self collision cache can be used from several threads and is shared with the clones of this checker that track a robot with the same geometry. [0|1]");
         RegisterCommand("GetCacheTimes",boost::bind(&CacheCollisionChecker::_GetCacheTimesCommand,this,_1,_2),
                         "get the cache times: insert, query, collision checking, load");
         std::string collisionname="ode";
@@ -120,6 +122,10 @@ public:
             }
         }
         _pintchecker->SetGeometryGroup(groupname);
+        if( !!_probot && !!_selfcache ) {
+            // the self collision cache files are per geometry group
+            _OpenSelfCacheFiles();
+        }
     }
 
     virtual const std::string& GetGeometryGroup() const
@@ -138,7 +144,13 @@ public:
             _cache->Reset();
         }
         if( !!_selfcache ) {
-            _selfcache->Reset();
+            if( _selfcache->IsConcurrent() ) {
+                // might be shared with the clones of this checker
+                _selfcache.reset();
+            }
+            else {
+                _selfcache->Reset();
+            }
         }
         if( !!_pintchecker ) {
             _pintchecker->DestroyEnvironment();
@@ -167,6 +179,13 @@ public:
 
         _strRobotName = clone->_strRobotName;
         _probot.reset(); // have to rest to force creating a new cache
+        _pclonedselfcache.reset();
+        if( !!clone->_selfcache && clone->_selfcache->IsConcurrent() && !!clone->_probot ) {
+            // clones are usually handed to other threads, so let them all warm up the same self collision cache. the
+            // robot is usually cloned after the checker, so share once it is found.
+            _pclonedselfcache = clone->_selfcache;
+            _clonedrobothash = clone->_probot->GetKinematicsGeometryHash();
+        }
         _probot = GetRobot();
 
         _cachedcollisionchecks=clone->_cachedcollisionchecks;
@@ -325,8 +344,10 @@ public:
         KinBody::LinkConstPtr robotlink, collidinglink;
         dReal closestdist=0;
 
+        // query with the state of the robot of this environment, the cache might be shared with the clones of this checker
         _stime = utils::GetMilliTime();
-        int ret = _selfcache->CheckCollision(robotlink, collidinglink, closestdist);
+        probot->GetDOFValues(_dofvals);
+        int ret = _selfcache->CheckCollision(_dofvals, robotlink, collidinglink, closestdist);
         _selfquerytime += utils::GetMilliTime()-_stime;
 
         ++_selfcachedcollisionchecks;
@@ -344,19 +365,16 @@ public:
             }
         }
 
-        // save cache every other iteration if its size has increased by 1.5
+        // new configurations go to the write-ahead log of the cache file, make sure they reach it every now and then
         if (_selfcachedcollisionchecks % 4000 == 0) {
-            if (_size*1.5 < _selfcache->GetNumKnownNodes()) {
-                _selfcache->SaveCache(GetCacheHash());
-                _size = _selfcache->GetNumKnownNodes();
-            }
+            _selfcache->FlushWriteAheadLog();
         }
         if( ret == 1 ) {
             ++_selfcachedcollisionhits;
             // in collision
             if( !!report ) {
-                report->plink1 = robotlink;
-                report->plink2 = collidinglink;
+                report->plink1 = _RemapLink(robotlink);
+                report->plink2 = _RemapLink(collidinglink);
             }
             return true;
         }
@@ -376,7 +394,6 @@ public:
         _selfrawtime += utils::GetMilliTime()-_stime;
 
         _stime = utils::GetMilliTime();
-        _selfcache->GetDOFValues(_dofvals);
         _selfcache->InsertConfiguration(_dofvals, !col ? CollisionReportPtr() : report, closestdist);
         _selfintime += utils::GetMilliTime()-_stime;
 
@@ -401,7 +418,7 @@ protected:
         }
 
         // if there is no cache, create one
-        if (_selfcache->GetNumKnownNodes() == 0) {
+        if (!_selfcache || _selfcache->GetNumKnownNodes() == 0) {
             // _cache is the environment collision cache, envupdates is true, i.e., the cache will be updated on changes and it will not save/load
             _cache.reset(new ConfigurationCache(_probot));
             // _selfcache is the selfcollision cache, envupdates is false, i.e., the cache will not be updated when the environment changes it will save and load the cache
@@ -410,17 +427,7 @@ protected:
             _SetParams();
         }
 
-        // check if a selfcache for this robot exists on this disk
-        std::string fulldirname = RaveFindDatabaseFile(("selfcache."+GetCacheHash()));
-        if (fulldirname != "" && _selfcache->GetNumKnownNodes() == 0) {
-            _stime = utils::GetMilliTime();
-            _selfcache->LoadCache(GetCacheHash(), GetEnv());
-            _loadtime = utils::GetMilliTime()-_stime;
-            _size = _selfcache->GetNumKnownNodes();
-            RAVELOG_VERBOSE_FORMAT("Loaded %d configurations in %d ms from %s", _size%_loadtime%fulldirname);
-
-            __cachehash = "";
-        }
+        _OpenSelfCacheFiles();
 
         RAVELOG_DEBUG_FORMAT("Now tracking robot %s", bodyname);
 
@@ -505,6 +512,10 @@ protected:
         _selfcache->SetFreeSpaceThresh(selffreethresh);
         _selfcache->SetInsertionDistanceMult(selfindist);
         _selfcache->SetBase(selfbase);
+        if( !!_probot ) {
+            // the parameters are part of the hash of the cache files
+            _OpenSelfCacheFiles();
+        }
 
         sout << " " << _selfcache->GetCollisionThresh() << " " << _selfcache->GetFreeSpaceThresh() << " " << _selfcache->GetInsertionDistanceMult() << " " << _selfcache->GetBase();
         return true;
@@ -578,17 +589,85 @@ protected:
 
     virtual bool _SaveCacheCommand(std::ostream& sout, std::istream& sinput)
     {
-        _selfcache->SaveCache(GetCacheHash());
+        std::string filename = _GetSelfCacheFilename();
+        if( filename.size() == 0 ) {
+            return false;
+        }
+        sout << _selfcache->MergeCache(filename, filename + ".log");
         return true;
     }
 
 
     virtual bool _LoadCacheCommand(std::ostream& sout, std::istream& sinput)
     {
-        _selfcache->LoadCache(GetCacheHash(), GetEnv());
+        std::string filename = _GetSelfCacheFilename();
+        return filename.size() > 0 && _selfcache->LoadCache(filename, GetEnv()) != 0;
+    }
+
+    virtual bool _SetSelfCacheConcurrentCommand(std::ostream& sout, std::istream& sinput)
+    {
+        bool bConcurrent = true;
+        sinput >> bConcurrent;
+        if( !_selfcache ) {
+            return false;
+        }
+        _selfcache->SetConcurrent(bConcurrent);
         return true;
     }
 
+    /// \brief returns the link of this environment with the same body name and index as a link returned by the self collision cache, which can come from the environment of another checker sharing the cache
+    KinBody::LinkConstPtr _RemapLink(KinBody::LinkConstPtr plink)
+    {
+        if( !plink ) {
+            return plink;
+        }
+        KinBodyPtr pbody = plink->GetParent(true);
+        if( !!pbody && pbody->GetEnv() == GetEnv() ) {
+            return plink;
+        }
+        KinBodyPtr plocalbody = !!pbody ? GetEnv()->GetKinBody(pbody->GetName()) : KinBodyPtr();
+        if( !plocalbody || plink->GetIndex() >= (int)plocalbody->GetLinks().size() ) {
+            return KinBody::LinkConstPtr();
+        }
+        return plocalbody->GetLinks()[plink->GetIndex()];
+    }
+
+    /// \brief returns the self collision cache file of the tracked robot in the database, empty if it cannot be written
+    std::string _GetSelfCacheFilename()
+    {
+        return RaveFindDatabaseFile("selfcache."+GetCacheHash(), false);
+    }
+
+    /// \brief maps the self collision cache file of the tracked robot if it exists and logs the new self collision configurations next to it
+    ///
+    /// All processes with the same robot geometry, geometry group and cache parameters share the file, and append to the same write-ahead log until it is merged with the SaveCache command.
+    void _OpenSelfCacheFiles()
+    {
+        _selfcache->UnmapCache();
+        std::string filename = _GetSelfCacheFilename();
+        _selfcache->SetWriteAheadLog(filename.size() > 0 ? filename + ".log" : std::string());
+        std::string fulldirname = RaveFindDatabaseFile("selfcache."+GetCacheHash());
+        if (fulldirname != "" && _selfcache->GetNumKnownNodes() == 0) {
+            _stime = utils::GetMilliTime();
+            if( _selfcache->MapCache(fulldirname) ) {
+                _loadtime = utils::GetMilliTime()-_stime;
+                _size = _selfcache->GetMappedCache()->GetNumNodes();
+                RAVELOG_VERBOSE_FORMAT("Mapped %d configurations in %d ms from %s", _size%_loadtime%fulldirname);
+            }
+        }
+    }
+
+    /// \brief returns the geometry group of the internal checker, empty if it does not support geometry groups
+    std::string _GetGeometryGroup() const
+    {
+        try {
+            return _pintchecker->GetGeometryGroup();
+        }
+        catch(const openrave_exception&) {
+            return std::string();
+        }
+    }
+
     RobotBasePtr GetRobot()
     {
         if( !_probot && _strRobotName.size() > 0 ) {
@@ -596,22 +675,28 @@ protected:
             if( !!_probot ) {
                 // initialized! so also initialize the cache
                 _InitializeCache();
+                if( !!_pclonedselfcache ) {
+                    if( _probot->GetKinematicsGeometryHash() == _clonedrobothash ) {
+                        _selfcache = _pclonedselfcache;
+                    }
+                    _pclonedselfcache.reset();
+                }
             }
         }
         return _probot;
     }
 
-    /// \brief generate a string to be used to save/load selfcollision cache. hash considers: robot, grabbed bodies, parameters for the cache, and DOF
+    /// \brief generate a string to be used to save/load selfcollision cache. hash considers: robot geometry, grabbed bodies, geometry group, parameters for the cache, and DOF
     std::string GetCacheHash()
     {
-        _robothash = GetRobot()->GetRobotStructureHash();
+        _robothash = GetRobot()->GetKinematicsGeometryHash();
 
         _vGrabbedBodies.resize(0);
         GetRobot()->GetGrabbed(_vGrabbedBodies);
         FOREACH(newbody, _vGrabbedBodies){
             _robothash += (*newbody)->GetKinematicsGeometryHash();
         }
-
+        _robothash += _GetGeometryGroup();
 
         _oss << _selfcache->GetCollisionThresh() << _selfcache->GetFreeSpaceThresh() << _selfcache->GetInsertionDistanceMult() << _selfcache->GetBase();
 
@@ -678,6 +763,8 @@ protected:
     std::vector<int> _dofindices;
     ConfigurationCachePtr _cache;
     ConfigurationCachePtr _selfcache;
+    ConfigurationCachePtr _pclonedselfcache; ///< concurrent self collision cache of the cloned checker, shared once the robot is found
+    std::string _clonedrobothash; ///< kinematics geometry hash of the robot of the cloned checker
     CollisionCheckerBasePtr _pintchecker;
     std::string _strRobotName; ///< the robot name to track
     std::string __cachehash;
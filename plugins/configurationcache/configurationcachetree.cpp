@@ -14,7 +14,11 @@
 /// \author Alejandro Perez & Rosen Diankov
 #include "configurationcachetree.h"
 #include <sstream>
+#include <fstream>
+#include <cstdio>
 #include <boost/lexical_cast.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <boost/multi_array.hpp>
 #include <algorithm>
@@ -28,6 +32,71 @@ inline dReal Sqr(dReal x) {
     return x*x;
 }
 
+/// \brief header of every record of the write-ahead log of ConfigurationCache, followed by the name of the colliding body and the state
+struct CacheLogRecordHeader
+{
+    uint32_t magic; ///< CACHELOG_MAGIC_NUMBER
+    int32_t statedof;
+    int32_t conftype;
+    int32_t robotlinkindex;
+    int32_t collidinglinkindex;
+    int32_t bodynamelength;
+};
+
+static const uint32_t CACHELOG_MAGIC_NUMBER = 0x4c524643; ///< "CFRL"
+static const size_t CACHELOG_FLUSH_SIZE = 4096; ///< bytes of records buffered before they are appended to the log
+
+/// \brief exclusive lock of a write-ahead log between the caches of all processes, taken while a log is appended to or renamed by MergeCache
+///
+/// The file lock lives in logfilename.lock. File locks are owned by the process, so the caches of the same process are serialized by a mutex as well.
+class CacheLogLock
+{
+public:
+    CacheLogLock(const std::string& logfilename) : _lock(_GetMutex())
+    {
+        std::string lockfilename = logfilename + ".lock";
+        FILE* pfile = fopen(lockfilename.c_str(), "ab");
+        if( !!pfile ) {
+            fclose(pfile);
+        }
+        try {
+            _filelock = boost::interprocess::file_lock(lockfilename.c_str());
+            _filelock.lock();
+            _bLocked = true;
+        }
+        catch(const boost::interprocess::interprocess_exception& ex) {
+            RAVELOG_WARN_FORMAT("failed to lock cache log %s: %s", logfilename%ex.what());
+            _bLocked = false;
+        }
+    }
+    ~CacheLogLock() {
+        if( _bLocked ) {
+            _filelock.unlock();
+        }
+    }
+
+private:
+    static boost::mutex& _GetMutex() {
+        static boost::mutex s_mutex;
+        return s_mutex;
+    }
+
+    boost::mutex::scoped_lock _lock;
+    boost::interprocess::file_lock _filelock;
+    bool _bLocked;
+};
+
+/// \brief reads the whole file, returns false if it cannot be opened
+static bool ReadCacheLog(const std::string& filename, std::vector<char>& vdata)
+{
+    std::ifstream f(filename.c_str(), std::ios::binary);
+    if( !f ) {
+        return false;
+    }
+    vdata.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    return true;
+}
+
 CacheTreeNode::CacheTreeNode(const std::vector<dReal>& cs, Vector* plinkspheres)
 {
     std::copy(cs.begin(), cs.end(), _pcstate);
@@ -114,6 +183,7 @@ CacheTree::CacheTree(int statedof)
     _collidingbodyname.resize(0);
 
     _statedof=statedof;
+    _bConcurrentQueries = false;
     _weights.resize(_statedof, 1.0);
     Init(_weights, 1);
 }
@@ -238,6 +308,19 @@ dReal CacheTree::_ComputeDistance2(const dReal* cstatei, const dReal* cstatef) c
     return distance;
 }
 
+CacheTree::QueryBuffers& CacheTree::_GetQueryBuffers() const
+{
+    if( !_bConcurrentQueries ) {
+        return _querybuffers;
+    }
+    QueryBuffers* pbuffers = _pthreadquerybuffers.get();
+    if( !pbuffers ) {
+        pbuffers = new QueryBuffers();
+        _pthreadquerybuffers.reset(pbuffers);
+    }
+    return *pbuffers;
+}
+
 void CacheTree::SetWeights(const std::vector<dReal>& weights)
 {
     Reset();
@@ -280,6 +363,9 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
         return make_pair(CacheTreeNodeConstPtr(), dReal(0));
     }
 
+    QueryBuffers& buffers = _GetQueryBuffers();
+    std::vector< std::pair<CacheTreeNodePtr, dReal> >& vCurrentLevelNodes = buffers._vCurrentLevelNodes;
+    std::vector< std::pair<CacheTreeNodePtr, dReal> >& vNextLevelNodes = buffers._vNextLevelNodes;
     CacheTreeNodeConstPtr pbestnode=NULL;
     dReal bestdist2 = std::numeric_limits<dReal>::infinity();
     OPENRAVE_ASSERT_OP(vquerystate.size(),==,_weights.size());
@@ -289,17 +375,17 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
     int currentlevel = _maxlevel; // where the root node is
     // traverse all levels gathering up the children at each level
     dReal fLevelBound2 = Sqr(_fMaxLevelBound);
-    _vCurrentLevelNodes.resize(1);
-    _vCurrentLevelNodes[0].first = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
-    _vCurrentLevelNodes[0].second = _ComputeDistance2(pquerystate, _vCurrentLevelNodes[0].first->GetConfigurationState());
-    if( (conftype == CNT_Any || _vCurrentLevelNodes[0].first->GetType() == conftype) && _vCurrentLevelNodes[0].first->_usenn ) {
-        pbestnode = _vCurrentLevelNodes[0].first;
-        bestdist2 = _vCurrentLevelNodes[0].second;
-    }
-    while(_vCurrentLevelNodes.size() > 0 ) {
-        _vNextLevelNodes.resize(0);
+    vCurrentLevelNodes.resize(1);
+    vCurrentLevelNodes[0].first = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
+    vCurrentLevelNodes[0].second = _ComputeDistance2(pquerystate, vCurrentLevelNodes[0].first->GetConfigurationState());
+    if( (conftype == CNT_Any || vCurrentLevelNodes[0].first->GetType() == conftype) && vCurrentLevelNodes[0].first->_usenn ) {
+        pbestnode = vCurrentLevelNodes[0].first;
+        bestdist2 = vCurrentLevelNodes[0].second;
+    }
+    while(vCurrentLevelNodes.size() > 0 ) {
+        vNextLevelNodes.resize(0);
         dReal minchilddist2 = std::numeric_limits<dReal>::infinity();
-        FOREACH(itcurrentnode, _vCurrentLevelNodes) {
+        FOREACH(itcurrentnode, vCurrentLevelNodes) {
             // only take the children whose distances are within the bound
             FOREACHC(itchild, itcurrentnode->first->_vchildren) {
                 dReal curdist2 = _ComputeDistance2(pquerystate, (*itchild)->GetConfigurationState());
@@ -308,27 +394,29 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
                         bestdist2 = curdist2;
                         pbestnode = *itchild;
                         if( distancebound > 0 && bestdist2 <= distancebound2 ) {
-                            (*itchild)->IncreaseHitCount();
+                            if( !_bConcurrentQueries ) {
+                                (*itchild)->IncreaseHitCount();
+                            }
                             return make_pair(pbestnode, RaveSqrt(bestdist2));
                         }
                     }
                 }
-                _vNextLevelNodes.emplace_back(*itchild,  curdist2);
+                vNextLevelNodes.emplace_back(*itchild,  curdist2);
                 if( minchilddist2 > curdist2 ) {
                     minchilddist2 = curdist2;
                 }
             }
         }
 
-        _vCurrentLevelNodes.resize(0);
+        vCurrentLevelNodes.resize(0);
         // have to compute dist < RaveSqrt(minchilddist2) + fLevelBound
         // dist2 < m2 + 2mL + L2
 
         dReal ftestbound2 = 4*minchilddist2*fLevelBound2;
-        FOREACH(itnode, _vNextLevelNodes) {
+        FOREACH(itnode, vNextLevelNodes) {
             dReal f = itnode->second - minchilddist2 - fLevelBound2;
             if( f <= 0 || Sqr(f) <= ftestbound2 ) {
-                _vCurrentLevelNodes.push_back(*itnode);
+                vCurrentLevelNodes.push_back(*itnode);
             }
         }
         currentlevel -= 1;
@@ -351,6 +439,9 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
     }
 
     OPENRAVE_ASSERT_OP(vquerystate.size(),==,_weights.size());
+    QueryBuffers& buffers = _GetQueryBuffers();
+    std::vector< std::pair<CacheTreeNodePtr, dReal> >& vCurrentLevelNodes = buffers._vCurrentLevelNodes;
+    std::vector< std::pair<CacheTreeNodePtr, dReal> >& vNextLevelNodes = buffers._vNextLevelNodes;
     // first localmax is distance from this node to the root
     const dReal* pquerystate = &vquerystate[0];
 
@@ -364,7 +455,9 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
         if( proot->_usenn ) {
             ConfigurationNodeType cntype = proot->GetType();
             if( cntype == CNT_Collision && curdist2 <= collisionthresh2 ) {
-                proot->_hitcount++;
+                if( !_bConcurrentQueries ) {
+                    proot->_hitcount++;
+                }
                 return make_pair(proot,RaveSqrt(curdist2));
             }
             else if( cntype == CNT_Free && curdist2 <= freespacethresh2 ) {
@@ -372,15 +465,15 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
                 bestnode = make_pair(proot,RaveSqrt(curdist2));
             }
         }
-        _vCurrentLevelNodes.resize(1);
-        _vCurrentLevelNodes[0].first = proot;
-        _vCurrentLevelNodes[0].second = curdist2;
+        vCurrentLevelNodes.resize(1);
+        vCurrentLevelNodes[0].first = proot;
+        vCurrentLevelNodes[0].second = curdist2;
     }
-    dReal pruneradius2 = Sqr(_maxdistance); // the radius to prune all _vCurrentLevelNodes when going through them. Equivalent to min(query,children) + levelbound from the previous iteration
-    while(_vCurrentLevelNodes.size() > 0 ) {
-        _vNextLevelNodes.resize(0);
+    dReal pruneradius2 = Sqr(_maxdistance); // the radius to prune all vCurrentLevelNodes when going through them. Equivalent to min(query,children) + levelbound from the previous iteration
+    while(vCurrentLevelNodes.size() > 0 ) {
+        vNextLevelNodes.resize(0);
         dReal minchilddist=_maxdistance;
-        FOREACH(itcurrentnode, _vCurrentLevelNodes) {
+        FOREACH(itcurrentnode, vCurrentLevelNodes) {
             if( itcurrentnode->second > pruneradius2 ) {
                 continue;
             }
@@ -391,7 +484,9 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
                 if( (*itchild)->_usenn ) {
                     ConfigurationNodeType cntype = (*itchild)->GetType();
                     if( cntype == CNT_Collision && curdist2 <= collisionthresh2 ) {
-                        (*itchild)->_hitcount++;
+                        if( !_bConcurrentQueries ) {
+                            (*itchild)->_hitcount++;
+                        }
                         return make_pair(*itchild, RaveSqrt(curdist2));
                     }
                     else if( cntype == CNT_Free && curdist2 <= freespacethresh2 ) {
@@ -402,7 +497,7 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
                     }
                 }
                 if( curdist2 < comparedist2 ) {
-                    _vNextLevelNodes.emplace_back(*itchild,  curdist2);
+                    vNextLevelNodes.emplace_back(*itchild,  curdist2);
                     if( Sqr(minchilddist) > curdist2 ) {
                         minchilddist = RaveSqrt(curdist2);
                         comparedist2 = Sqr(minchilddist + fLevelBound);
@@ -411,7 +506,7 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
             }
         }
 
-        _vCurrentLevelNodes.swap(_vNextLevelNodes);
+        vCurrentLevelNodes.swap(vNextLevelNodes);
         pruneradius2 = Sqr(minchilddist + fLevelBound);
         currentlevel -= 1;
         fLevelBound *= _fBaseInv;
@@ -788,165 +883,391 @@ int CacheTree::RemoveCollisionConfigurations()
     return nremoved;
 }
 
-int CacheTree::SaveCache(std::string filename)
+/// \brief rounds offset up to the alignment of the arrays in the flat cache files
+inline uint64_t _AlignFlatCacheOffset(uint64_t offset)
+{
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+/// \brief writes zeros until the stream is at offset
+static void _WriteFlatCachePadding(std::ostream& f, uint64_t offset)
 {
-    //boost::mutex::scoped_lock lock(_mutexpool);
+    while( (uint64_t)f.tellp() < offset ) {
+        f.put(0);
+    }
+}
+
+int CacheTree::SaveCache(const std::string& filename)
+{
+    // number the nodes and the colliding bodies
+    std::vector<CacheTreeNodePtr> vnodes;
+    vnodes.reserve(_numnodes);
     _mapNodeIndices.clear();
-    int index=0;
-    int knownnodes=0;
     FOREACH(itlevelnodes, _vsetLevelNodes) {
         FOREACH(itnode, *itlevelnodes) {
-            if( (*itnode)->_conftype != CNT_Unknown) {
-                knownnodes++;
+            _mapNodeIndices[*itnode] = vnodes.size();
+            vnodes.push_back(*itnode);
+        }
+    }
+
+    FlatCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = FLATCACHE_MAGIC_NUMBER;
+    header.version = FLATCACHE_VERSION;
+    header.realsize = sizeof(dReal);
+    header.statedof = _statedof;
+    header.maxlevel = _maxlevel;
+    header.minlevel = _minlevel;
+    header.numnodes = vnodes.size();
+    header.base = _base;
+    header.maxdistance = _maxdistance;
+    if( vnodes.size() > 0 ) {
+        header.rootindex = _mapNodeIndices[*_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin()];
+    }
+
+    std::vector<FlatCacheNode> vflatnodes(vnodes.size());
+    std::vector<uint32_t> vchildren;
+    vchildren.reserve(vnodes.size());
+    std::vector<std::string> vbodynames;
+    std::map<std::string, int> mapBodyIndices;
+    for(size_t inode = 0; inode < vnodes.size(); ++inode) {
+        CacheTreeNodePtr pnode = vnodes[inode];
+        FlatCacheNode& flatnode = vflatnodes[inode];
+        memset(&flatnode, 0, sizeof(flatnode));
+        flatnode.level = pnode->_level;
+        flatnode.conftype = pnode->_conftype;
+        flatnode.hasselfchild = pnode->_hasselfchild;
+        flatnode.usenn = pnode->_usenn;
+        flatnode.robotlinkindex = pnode->_robotlinkindex;
+        flatnode.hitcount = pnode->_hitcount;
+        flatnode.collidingbodyindex = -1;
+        flatnode.collidinglinkindex = -1;
+        KinBodyPtr pcollidingbody = pnode->_conftype == CNT_Collision && !!pnode->_collidinglink ? pnode->_collidinglink->GetParent(true) : KinBodyPtr();
+        if( !!pcollidingbody ) {
+            // note, this assumes the colliding body name never changes across environments, which is a false assumption
+            const std::string& bodyname = pcollidingbody->GetName();
+            std::map<std::string, int>::iterator itbody = mapBodyIndices.find(bodyname);
+            if( itbody == mapBodyIndices.end() ) {
+                itbody = mapBodyIndices.insert(std::make_pair(bodyname, (int)vbodynames.size())).first;
+                vbodynames.push_back(bodyname);
             }
-            _mapNodeIndices[*itnode] = index++;
+            flatnode.collidingbodyindex = itbody->second;
+            flatnode.collidinglinkindex = pnode->_collidinglink->GetIndex();
+        }
+        flatnode.firstchild = vchildren.size();
+        flatnode.numchildren = pnode->_vchildren.size();
+        FOREACHC(itchild, pnode->_vchildren) {
+            vchildren.push_back(_mapNodeIndices[*itchild]);
         }
     }
+    header.numchildren = vchildren.size();
+    header.numbodynames = vbodynames.size();
 
-    _numnodes = knownnodes;
-    _fulldirname = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
+    header.weightsoffset = _AlignFlatCacheOffset(sizeof(header));
+    header.nodesoffset = _AlignFlatCacheOffset(header.weightsoffset + _statedof*sizeof(dReal));
+    header.statesoffset = _AlignFlatCacheOffset(header.nodesoffset + vflatnodes.size()*sizeof(FlatCacheNode));
+    header.childrenoffset = _AlignFlatCacheOffset(header.statesoffset + vnodes.size()*_statedof*sizeof(dReal));
+    header.bodynamesoffset = _AlignFlatCacheOffset(header.childrenoffset + vchildren.size()*sizeof(uint32_t));
+    header.filesize = header.bodynamesoffset;
+    FOREACHC(itname, vbodynames) {
+        header.filesize += sizeof(uint32_t) + itname->size();
+    }
 
-    RAVELOG_DEBUG_FORMAT("Writing cache to %s, size=%d", _fulldirname%_numnodes);
-    
-    FILE* pfile;
-    pfile = fopen(_fulldirname.c_str(),"wb");
+    // write next to the file and rename, so that processes mapping the old file never see a partial file
+    std::string tempfilename = str(boost::format("%s.%d.tmp")%filename%RaveRandomInt());
+    RAVELOG_DEBUG_FORMAT("Writing cache to %s, size=%d", filename%vnodes.size());
+    {
+        std::ofstream f(tempfilename.c_str(), std::ios::binary);
+        if( !f ) {
+            RAVELOG_WARN_FORMAT("failed to open %s for writing the cache", tempfilename);
+            return 0;
+        }
+        f.write((const char*)&header, sizeof(header));
+        _WriteFlatCachePadding(f, header.weightsoffset);
+        f.write((const char*)&_weights[0], _statedof*sizeof(dReal));
+        _WriteFlatCachePadding(f, header.nodesoffset);
+        if( vflatnodes.size() > 0 ) {
+            f.write((const char*)&vflatnodes[0], vflatnodes.size()*sizeof(FlatCacheNode));
+        }
+        _WriteFlatCachePadding(f, header.statesoffset);
+        FOREACHC(itnode, vnodes) {
+            f.write((const char*)(*itnode)->GetConfigurationState(), _statedof*sizeof(dReal));
+        }
+        _WriteFlatCachePadding(f, header.childrenoffset);
+        if( vchildren.size() > 0 ) {
+            f.write((const char*)&vchildren[0], vchildren.size()*sizeof(uint32_t));
+        }
+        _WriteFlatCachePadding(f, header.bodynamesoffset);
+        FOREACHC(itname, vbodynames) {
+            uint32_t namelength = itname->size();
+            f.write((const char*)&namelength, sizeof(namelength));
+            f.write(itname->c_str(), namelength);
+        }
+        if( !f ) {
+            RAVELOG_WARN_FORMAT("failed to write the cache to %s", tempfilename);
+            f.close();
+            std::remove(tempfilename.c_str());
+            return 0;
+        }
+    }
+#ifdef _WIN32
+    std::remove(filename.c_str());
+#endif
+    if( std::rename(tempfilename.c_str(), filename.c_str()) != 0 ) {
+        RAVELOG_WARN_FORMAT("failed to rename %s to %s", tempfilename%filename);
+        std::remove(tempfilename.c_str());
+        return 0;
+    }
+    return 1;
+}
 
-    fwrite(&_statedof, sizeof(_statedof), 1, pfile);
-    fwrite(&_weights[0], sizeof(_weights[0])*_weights.size(), 1, pfile);
-    fwrite(&_base, sizeof(_base), 1, pfile);
-    fwrite(&_fBaseInv, sizeof(_fBaseInv), 1, pfile);
-    fwrite(&_fBaseInv2, sizeof(_fBaseInv2), 1, pfile);
-    fwrite(&_fBaseChildMult, sizeof(_fBaseChildMult), 1, pfile);
-    fwrite(&_maxdistance, sizeof(_maxdistance), 1, pfile);
-    fwrite(&_maxlevel, sizeof(_maxlevel), 1, pfile);
-    fwrite(&_minlevel, sizeof(_minlevel), 1, pfile);
-    fwrite(&_numnodes, sizeof(_numnodes), 1, pfile);
-    fwrite(&_fMaxLevelBound, sizeof(_fMaxLevelBound), 1, pfile);
+int CacheTree::LoadCache(const std::string& filename, EnvironmentBasePtr penv)
+{
+    if( !std::ifstream(filename.c_str()) ) {
+        return 0;
+    }
+    try {
+        MappedCacheTree mappedtree(filename);
+        return LoadCache(mappedtree, penv);
+    }
+    catch(const openrave_exception& ex) {
+        RAVELOG_WARN_FORMAT("failed to load cache: %s", ex.what());
+        return 0;
+    }
+}
 
-    FOREACH(itlevelnodes, _vsetLevelNodes) {
-        FOREACH(itnode, *itlevelnodes) {
-            _newnode = *itnode;
-            // TODO save only configuration != CNT_Unknown without losing the validity of the tree
-            if (true) { //_newnode->_conftype != CNT_Unknown) {
-                fwrite(&_newnode->_level, sizeof(_newnode->_level), 1, pfile);
-                fwrite(_newnode->GetConfigurationState(), sizeof(dReal)*_statedof, 1, pfile);
-                fwrite(&_newnode->_conftype, sizeof(_newnode->_conftype), 1, pfile);
-
-                if (_newnode->_conftype == CNT_Collision ) {
-                    // note, this assumes the colliding body name never changes across environments, which is a false assumption
-                    _collidingbodyname = _newnode->GetCollidingLink()->GetParent()->GetName();
-                    int namelength = _collidingbodyname.size();
-                    fwrite(&namelength, sizeof(namelength), 1, pfile);
-                    fwrite(_collidingbodyname.c_str(), _collidingbodyname.size(), 1, pfile);
-                    int linkindex = _newnode->GetCollidingLink()->GetIndex();
-                    fwrite(&linkindex, sizeof(linkindex), 1, pfile);
-                    fwrite(&_newnode->_robotlinkindex, sizeof(_newnode->_robotlinkindex), 1, pfile);
-                }
+int CacheTree::LoadCache(const MappedCacheTree& mappedtree, EnvironmentBasePtr penv)
+{
+    const FlatCacheHeader& header = mappedtree.GetHeader();
+    if( header.statedof != _statedof ) {
+        RAVELOG_WARN_FORMAT("cache %s has %d dof, but the tree has %d", mappedtree.GetFilename()%header.statedof%_statedof);
+        return 0;
+    }
+    // the indices of the nodes were validated by MappedCacheTree
+    Reset();
+    _weights = mappedtree.GetWeights();
+    _curconf.resize(_statedof,1.0);
+    _base = header.base;
+    _fBaseInv = 1/_base;
+    _fBaseInv2 = 1/Sqr(_base);
+    _fBaseChildMult = 1/(_base-1);
+    _maxdistance = header.maxdistance;
+    _maxlevel = header.maxlevel;
+    _minlevel = header.minlevel;
+    _fMaxLevelBound = RavePow(_base, _maxlevel);
+    _vsetLevelNodes.resize(max(_EncodeLevel(_maxlevel), _EncodeLevel(_minlevel))+1);
 
-                fwrite(&_newnode->_hasselfchild, sizeof(_newnode->_hasselfchild), 1, pfile);
-                fwrite(&_newnode->_usenn, sizeof(_newnode->_usenn), 1, pfile);
-                int numchildren = _newnode->_vchildren.size();
-                fwrite(&numchildren, sizeof(numchildren), 1, pfile);
+    std::vector<KinBodyPtr> vcollidingbodies(mappedtree.GetBodyNames().size());
+    for(size_t ibody = 0; ibody < vcollidingbodies.size(); ++ibody) {
+        vcollidingbodies[ibody] = penv->GetKinBody(mappedtree.GetBodyNames()[ibody]);
+        if( !vcollidingbodies[ibody] ) {
+            RAVELOG_WARN_FORMAT("loading cache expected colliding body %s, but none found", mappedtree.GetBodyNames()[ibody]);
+        }
+    }
 
-                FOREACHC(itchild, (*itnode)->_vchildren) {
-                    int cindex = _mapNodeIndices[*itchild];
-                    fwrite(&cindex, sizeof(cindex), 1, pfile);
-                }
+    _vnodes.resize(mappedtree.GetNumNodes());
+    for(size_t inode = 0; inode < _vnodes.size(); ++inode) {
+        void* pmemory = _poolNodes->malloc();
+        _vnodes[inode] = new (pmemory) CacheTreeNode(mappedtree.GetConfigurationState(inode), _statedof, NULL);
+    }
+    for(size_t inode = 0; inode < _vnodes.size(); ++inode) {
+        const FlatCacheNode& flatnode = mappedtree.GetNode(inode);
+        _newnode = _vnodes[inode];
+        _newnode->_level = flatnode.level;
+        _newnode->_conftype = (ConfigurationNodeType)flatnode.conftype;
+        _newnode->_hasselfchild = flatnode.hasselfchild;
+        _newnode->_usenn = flatnode.usenn;
+        _newnode->_robotlinkindex = flatnode.robotlinkindex;
+        _newnode->_hitcount = flatnode.hitcount;
+        if( flatnode.collidingbodyindex >= 0 ) {
+            KinBodyPtr pcollidingbody = vcollidingbodies[flatnode.collidingbodyindex];
+            if( !!pcollidingbody && flatnode.collidinglinkindex >= 0 && flatnode.collidinglinkindex < (int)pcollidingbody->GetLinks().size() ) {
+                _newnode->_collidinglink = pcollidingbody->GetLinks()[flatnode.collidinglinkindex];
             }
         }
+        _newnode->_vchildren.resize(flatnode.numchildren);
+        const uint32_t* pchildren = mappedtree.GetChildren(flatnode);
+        for(uint32_t ichild = 0; ichild < flatnode.numchildren; ++ichild) {
+            _newnode->_vchildren[ichild] = _vnodes[pchildren[ichild]];
+        }
+        int enclevel = _EncodeLevel(_newnode->_level);
+        if( enclevel >= (int)_vsetLevelNodes.size() ) {
+            _vsetLevelNodes.resize(enclevel+1);
+        }
+        _vsetLevelNodes[enclevel].insert(_newnode);
     }
-
-    fclose(pfile);
-
+    _numnodes = _vnodes.size();
+    _vnodes.resize(0);
     return 1;
 }
 
-int CacheTree::LoadCache(std::string filename, EnvironmentBasePtr penv)
+/// \brief true if count elements of elementsize bytes starting at offset fit in filesize bytes
+static inline bool _IsFlatCacheRangeInFile(uint64_t offset, uint64_t count, uint64_t elementsize, uint64_t filesize)
 {
-    //boost::mutex::scoped_lock lock(_mutexpool);
-    _fulldirname = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
-
-    FILE* pfile = fopen(_fulldirname.c_str(),"rb");
-    size_t outs;
+    return offset <= filesize && count <= (filesize - offset)/elementsize;
+}
 
-    if (!pfile) {
-        return 0;
+MappedCacheTree::MappedCacheTree(const std::string& filename) : _filename(filename)
+{
+    try {
+        boost::interprocess::file_mapping filemapping(filename.c_str(), boost::interprocess::read_only);
+        _pmappedregion.reset(new boost::interprocess::mapped_region(filemapping, boost::interprocess::read_only));
+    }
+    catch(const boost::interprocess::interprocess_exception& ex) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("failed to map %s: %s"),filename%ex.what(),ORE_InvalidArguments);
+    }
+    const char* pfiledata = (const char*)_pmappedregion->get_address();
+    const uint64_t filesize = _pmappedregion->get_size();
+    if( filesize < sizeof(_header) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("%s is too small to be a cache file"),filename,ORE_InvalidArguments);
+    }
+    memcpy(&_header, pfiledata, sizeof(_header));
+    if( _header.magic != FLATCACHE_MAGIC_NUMBER || _header.version != FLATCACHE_VERSION || _header.realsize != sizeof(dReal) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("%s is not a cache file of version %d"),filename%FLATCACHE_VERSION,ORE_InvalidArguments);
+    }
+    // the sizes are compared by division so that corrupted counts cannot overflow
+    if( _header.filesize != filesize || _header.statedof <= 0 || (_header.numnodes > 0 && _header.rootindex >= _header.numnodes)
+        || _header.maxlevel < _header.minlevel || !(_header.base > 1) || !(_header.maxdistance > 0)
+        || !_IsFlatCacheRangeInFile(_header.weightsoffset, _header.statedof, sizeof(dReal), filesize)
+        || !_IsFlatCacheRangeInFile(_header.nodesoffset, _header.numnodes, sizeof(FlatCacheNode), filesize)
+        || !_IsFlatCacheRangeInFile(_header.statesoffset, _header.numnodes, _header.statedof*sizeof(dReal), filesize)
+        || !_IsFlatCacheRangeInFile(_header.childrenoffset, _header.numchildren, sizeof(uint32_t), filesize)
+        || _header.bodynamesoffset > filesize
+        || (_header.nodesoffset|_header.statesoffset|_header.childrenoffset) % 8 != 0 ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("cache file %s is truncated or corrupted"),filename,ORE_InvalidArguments);
+    }
+
+    _vweights.resize(_header.statedof);
+    memcpy(&_vweights[0], pfiledata + _header.weightsoffset, _header.statedof*sizeof(dReal));
+    _pnodes = (const FlatCacheNode*)(pfiledata + _header.nodesoffset);
+    _pstates = (const dReal*)(pfiledata + _header.statesoffset);
+    _pchildren = (const uint32_t*)(pfiledata + _header.childrenoffset);
+
+    // FindNearestNode and CacheTree::LoadCache follow the indices of the nodes without checking them. Children are always at a lower
+    // level than their parent, which also rules out cycles that would make the queries loop forever.
+    for(uint32_t inode = 0; inode < _header.numnodes; ++inode) {
+        const FlatCacheNode& node = _pnodes[inode];
+        bool bvalid = node.level >= _header.minlevel && node.level <= _header.maxlevel && node.conftype <= CNT_Free
+                      && node.collidingbodyindex >= -1 && node.collidingbodyindex < (int)_header.numbodynames
+                      && node.firstchild <= _header.numchildren && node.numchildren <= _header.numchildren - node.firstchild;
+        for(uint32_t ichild = 0; ichild < node.numchildren && bvalid; ++ichild) {
+            uint32_t childindex = _pchildren[node.firstchild+ichild];
+            bvalid = childindex < _header.numnodes && _pnodes[childindex].level < node.level;
+        }
+        if( !bvalid ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("cache file %s has inconsistent node %d"),filename%inode,ORE_InvalidArguments);
+        }
     }
 
-    Reset();
-    outs = fread(&_statedof, sizeof(_statedof), 1, pfile);
+    uint64_t offset = _header.bodynamesoffset;
+    _vbodynames.resize(_header.numbodynames);
+    FOREACH(itname, _vbodynames) {
+        uint32_t namelength = 0;
+        if( offset + sizeof(namelength) <= filesize ) {
+            memcpy(&namelength, pfiledata + offset, sizeof(namelength));
+            offset += sizeof(namelength);
+        }
+        if( offset + namelength > filesize ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("cache file %s is truncated or corrupted"),filename,ORE_InvalidArguments);
+        }
+        itname->assign(pfiledata + offset, namelength);
+        offset += namelength;
+    }
 
-    _weights.resize(_statedof,1.0);
-    _curconf.resize(_statedof,1.0);
-    outs = fread(&_weights[0], sizeof(_weights[0])*_weights.size(), 1, pfile);
+    _fMaxLevelBound = RavePow(dReal(_header.base), dReal(_header.maxlevel));
+    _fBaseInv = 1/_header.base;
+}
 
-    outs = fread(&_base, sizeof(_base), 1, pfile);
-    outs = fread(&_fBaseInv, sizeof(_fBaseInv), 1, pfile);
-    outs = fread(&_fBaseInv2, sizeof(_fBaseInv2), 1, pfile);
-    outs = fread(&_fBaseChildMult, sizeof(_fBaseChildMult), 1, pfile);
-    outs = fread(&_maxdistance, sizeof(_maxdistance), 1, pfile);
-    outs = fread(&_maxlevel, sizeof(_maxlevel), 1, pfile);
-    outs = fread(&_minlevel, sizeof(_minlevel), 1, pfile);
-    outs = fread(&_numnodes, sizeof(_numnodes), 1, pfile);
-    outs = fread(&_fMaxLevelBound, sizeof(_fMaxLevelBound), 1, pfile);
+dReal MappedCacheTree::_ComputeDistance2(const dReal* cstatei, const dReal* cstatef) const
+{
+    dReal distance = 0;
+    for (size_t i = 0; i < _vweights.size(); ++i) {
+        dReal f = (cstatei[i] - cstatef[i]) * _vweights[i];
+        distance += f*f;
+    }
+    return distance;
+}
 
-    int maxenclevel = max(_EncodeLevel(_maxlevel), _EncodeLevel(_minlevel));
-    _vsetLevelNodes.resize(maxenclevel+1);
+std::pair<int, dReal> MappedCacheTree::FindNearestNode(const std::vector<dReal>& vquerystate, dReal collisionthresh, dReal freespacethresh) const
+{
+    // bestnode.second holds the squared distance until the end
+    std::pair<int, dReal> bestnode(-1, std::numeric_limits<dReal>::infinity());
+    if( _header.numnodes == 0 ) {
+        return bestnode;
+    }
 
-    _vnodes.resize(_numnodes);
-    _dummycs.resize(_statedof, 0);
+    OPENRAVE_ASSERT_OP((int)vquerystate.size(),==,_header.statedof);
+    const dReal* pquerystate = &vquerystate[0];
 
-    for(int i = 0; i < _numnodes; ++i) {
-        _vnodes[i] = _CreateCacheTreeNode(_dummycs, CollisionReportPtr());
+    // the mapped tree is shared, so every thread queries with its own buffers
+    QueryBuffers* pbuffers = _pthreadquerybuffers.get();
+    if( !pbuffers ) {
+        pbuffers = new QueryBuffers();
+        _pthreadquerybuffers.reset(pbuffers);
     }
+    std::vector< std::pair<int, dReal> >& vCurrentLevelNodes = pbuffers->_vCurrentLevelNodes;
+    std::vector< std::pair<int, dReal> >& vNextLevelNodes = pbuffers->_vNextLevelNodes;
 
-    for (int inode = 0; inode < _numnodes; ++inode)
+    dReal collisionthresh2 = Sqr(collisionthresh), freespacethresh2 = Sqr(freespacethresh);
+    dReal fLevelBound = _fMaxLevelBound;
     {
-        _newnode = _vnodes.at(inode);
-        outs = fread(&_newnode->_level, sizeof(_newnode->_level), 1, pfile);
-        outs = fread(_newnode->_pcstate, sizeof(dReal)*_statedof, 1, pfile);
-        outs = fread(&_newnode->_conftype, sizeof(_newnode->_conftype), 1, pfile);
-
-        if( _newnode->_conftype == CNT_Collision ) {
-            int namelength;
-            outs = fread(&namelength, sizeof(namelength), 1, pfile);
-            _collidingbodyname.resize(namelength);
-            outs = fread(&_collidingbodyname[0], namelength, 1, pfile);
-            int collidinglinkindex;
-            outs = fread(&collidinglinkindex, sizeof(collidinglinkindex), 1, pfile);
-            _pcollidingbody = penv->GetKinBody(_collidingbodyname);
-            if( !_pcollidingbody ) {
-                RAVELOG_WARN_FORMAT("loading cache expected colliding body %s, but none found", _collidingbodyname);
+        int rootindex = _header.rootindex;
+        const FlatCacheNode& root = _pnodes[rootindex];
+        dReal curdist2 = _ComputeDistance2(pquerystate, GetConfigurationState(rootindex));
+        if( root.usenn ) {
+            if( root.conftype == CNT_Collision && curdist2 <= collisionthresh2 ) {
+                return std::make_pair(rootindex, RaveSqrt(curdist2));
             }
-            else {
-                _newnode->_collidinglink = _pcollidingbody->GetLinks().at(collidinglinkindex);
+            else if( root.conftype == CNT_Free && curdist2 <= freespacethresh2 ) {
+                // there still could be a node lower in the hierarchy whose collision is closer...
+                bestnode = std::make_pair(rootindex, curdist2);
             }
-            outs = fread(&_newnode->_robotlinkindex, sizeof(_newnode->_robotlinkindex), 1, pfile);
         }
-
-        outs = fread(&_newnode->_hasselfchild, sizeof(_newnode->_hasselfchild), 1, pfile);
-        outs = fread(&_newnode->_usenn, sizeof(_newnode->_usenn), 1, pfile);
-        int numchildren;
-        outs = fread(&numchildren, sizeof(numchildren), 1, pfile);
-        _newnode->_vchildren.resize(numchildren);
-
-        // create the copies of the children and insert them
-        for(int i = 0; i < numchildren; ++i) {
-            int childid;
-            outs = fread(&childid, sizeof(childid), 1, pfile);
-            _newnode->_vchildren[i] = _vnodes.at(childid);
+        vCurrentLevelNodes.resize(1);
+        vCurrentLevelNodes[0] = std::make_pair(rootindex, curdist2);
+    }
+    dReal pruneradius2 = Sqr(dReal(_header.maxdistance));
+    while(vCurrentLevelNodes.size() > 0 ) {
+        vNextLevelNodes.resize(0);
+        dReal minchilddist = _header.maxdistance;
+        FOREACHC(itcurrentnode, vCurrentLevelNodes) {
+            if( itcurrentnode->second > pruneradius2 ) {
+                continue;
+            }
+            dReal comparedist2 = Sqr(minchilddist + fLevelBound);
+            const FlatCacheNode& node = _pnodes[itcurrentnode->first];
+            const uint32_t* pchildren = GetChildren(node);
+            // only take the children whose distances are within the bound
+            for(uint32_t ichild = 0; ichild < node.numchildren; ++ichild) {
+                int childindex = pchildren[ichild];
+                const FlatCacheNode& child = _pnodes[childindex];
+                dReal curdist2 = _ComputeDistance2(pquerystate, GetConfigurationState(childindex));
+                if( child.usenn ) {
+                    if( child.conftype == CNT_Collision && curdist2 <= collisionthresh2 ) {
+                        return std::make_pair(childindex, RaveSqrt(curdist2));
+                    }
+                    else if( child.conftype == CNT_Free && curdist2 <= freespacethresh2 && curdist2 < bestnode.second ) {
+                        bestnode = std::make_pair(childindex, curdist2);
+                    }
+                }
+                if( curdist2 < comparedist2 ) {
+                    vNextLevelNodes.push_back(std::make_pair(childindex, curdist2));
+                    if( Sqr(minchilddist) > curdist2 ) {
+                        minchilddist = RaveSqrt(curdist2);
+                        comparedist2 = Sqr(minchilddist + fLevelBound);
+                    }
+                }
+            }
         }
 
-        _vsetLevelNodes.at(_EncodeLevel(_newnode->_level)).insert(_newnode);
+        vCurrentLevelNodes.swap(vNextLevelNodes);
+        pruneradius2 = Sqr(minchilddist + fLevelBound);
+        fLevelBound *= _fBaseInv;
     }
-
-    fclose(pfile);
-
-    _vnodes.resize(0);
-
-    int numloaded = GetNumKnownNodes();
-    OPENRAVE_ASSERT_OP(numloaded,==,_numnodes);
-    return 1;
+    if( bestnode.first >= 0 ) {
+        bestnode.second = RaveSqrt(bestnode.second);
+    }
+    return bestnode;
 }
 
 int CacheTree::UpdateCollisionConfigurations(KinBodyPtr pbody)
@@ -956,7 +1277,7 @@ int CacheTree::UpdateCollisionConfigurations(KinBodyPtr pbody)
         FOREACH(itlevelnodes, _vsetLevelNodes) {
             FOREACH(itnode, *itlevelnodes) {
                 _newnode = *itnode;
-                if ((_newnode->GetType() == CNT_Collision) && (pbody == _newnode->GetCollidingLink()->GetParent())) {
+                if ((_newnode->GetType() == CNT_Collision) && (pbody == _newnode->GetCollidingLink()->GetParent(true))) {
                     _newnode->SetType(CNT_Unknown);
                     nremoved += 1;
                 }
@@ -1131,6 +1452,7 @@ ConfigurationCache::ConfigurationCache(RobotBasePtr pstaterobot, bool envupdates
     _penv = pstaterobot->GetEnv();
 
     _envupdates = envupdates;
+    _bConcurrent = false;
 
     _vgrabbedbodies.resize(0);
     _vnewenvbodies.resize(0);
@@ -1225,6 +1547,7 @@ ConfigurationCache::ConfigurationCache(RobotBasePtr pstaterobot, bool envupdates
 
 ConfigurationCache::~ConfigurationCache()
 {
+    _FlushWriteAheadLog();
     _cachetree.Reset();
     // have to destroy all the change callbacks!
     FOREACH(it, _listCachedData) {
@@ -1238,43 +1561,68 @@ ConfigurationCache::~ConfigurationCache()
 
 void ConfigurationCache::SetWeights(const std::vector<dReal>& weights)
 {
+    UpdateLock lock(*this);
     _cachetree.SetWeights(weights);
 }
 
 bool ConfigurationCache::InsertConfiguration(const std::vector<dReal>& conf, CollisionReportPtr report, dReal distin)
 {
+    UpdateLock lock(*this);
     if( !!report ) {
-        if( !!report->plink2 && report->plink2->GetParent() == _pstaterobot ) {
+        if( _IsStateRobotLink(report->plink2) ) {
             std::swap(report->plink1, report->plink2);
         }
+        KinBody::LinkConstPtr pcollidinglink = _GetCacheLink(report->plink2);
+        if( pcollidinglink != report->plink2 ) {
+            if( !pcollidinglink ) {
+                return false;
+            }
+            // keep the robot link of the report for the transform of the node, only the colliding link is stored
+            CollisionReportPtr pcachereport(new CollisionReport());
+            pcachereport->plink1 = report->plink1;
+            pcachereport->plink2 = pcollidinglink;
+            report = pcachereport;
+        }
     }
     int ret = _cachetree.InsertNode(conf, report, !report ? _freespacethresh*_insertiondistancemult : _collisionthresh*_insertiondistancemult);
     BOOST_ASSERT(ret!=0);
+    if( ret == 1 && _logfilename.size() > 0 ) {
+        _LogConfiguration(conf, report);
+    }
     return ret==1;
 }
 
 int ConfigurationCache::GetNumKnownNodes()
 {
+    QueryLock lock(*this);
     return _cachetree.GetNumKnownNodes();
 }
 
 int ConfigurationCache::RemoveCollisionConfigurations()
 {
+    UpdateLock lock(*this);
+    _pmappedtree.reset();
     return _cachetree.RemoveCollisionConfigurations();
 }
 
 int ConfigurationCache::UpdateCollisionConfigurations(KinBodyPtr pbody)
 {
+    UpdateLock lock(*this);
+    _pmappedtree.reset();
     return _cachetree.UpdateCollisionConfigurations(pbody);
 }
 
 int ConfigurationCache::UpdateFreeConfigurations(KinBodyPtr pbody)
 {
+    UpdateLock lock(*this);
+    _pmappedtree.reset();
     return _cachetree.UpdateFreeConfigurations(pbody);
 }
 
 int ConfigurationCache::RemoveFreeConfigurations()
 {
+    UpdateLock lock(*this);
+    _pmappedtree.reset();
     return _cachetree.RemoveFreeConfigurations();
 }
 
@@ -1302,6 +1650,7 @@ void ConfigurationCache::GetDOFValues(std::vector<dReal>& values)
 
 int ConfigurationCache::CheckCollision(const std::vector<dReal>& conf, KinBody::LinkConstPtr& robotlink, KinBody::LinkConstPtr& collidinglink, dReal& closestdist)
 {
+    QueryLock lock(*this);
     std::pair<CacheTreeNodeConstPtr, dReal> knn = _cachetree.FindNearestNode(conf, _collisionthresh, _freespacethresh);
 
     if( !!knn.first ) {
@@ -1320,11 +1669,31 @@ int ConfigurationCache::CheckCollision(const std::vector<dReal>& conf, KinBody::
         }
         return 0;
     }
+    if( !!_pmappedtree ) {
+        std::pair<int, dReal> mappednn = _pmappedtree->FindNearestNode(conf, _collisionthresh, _freespacethresh);
+        if( mappednn.first >= 0 ) {
+            closestdist = mappednn.second;
+            const FlatCacheNode& node = _pmappedtree->GetNode(mappednn.first);
+            if( node.conftype == CNT_Collision ) {
+                robotlink.reset();
+                if( node.robotlinkindex >= 0 && node.robotlinkindex < (int)_pstaterobot->GetLinks().size() ) {
+                    robotlink = _pstaterobot->GetLinks()[node.robotlinkindex];
+                }
+                collidinglink.reset();
+                if( node.collidingbodyindex >= 0 ) {
+                    collidinglink = _FindLink(_pmappedtree->GetBodyNames().at(node.collidingbodyindex), node.collidinglinkindex);
+                }
+                return 1;
+            }
+            return 0;
+        }
+    }
     return -1;
 }
 
 std::pair<std::vector<dReal>, dReal> ConfigurationCache::FindNearestNode(const std::vector<dReal>& conf, dReal dist)
 {
+    QueryLock lock(*this);
     std::pair<CacheTreeNodeConstPtr, dReal> knn = _cachetree.FindNearestNode(conf, dist, CNT_Any);
 
     if( !!knn.first ) {
@@ -1343,14 +1712,264 @@ int ConfigurationCache::CheckCollision(KinBody::LinkConstPtr& robotlink, KinBody
 void ConfigurationCache::Reset()
 {
     RAVELOG_DEBUG("Resetting cache\n");
+    UpdateLock lock(*this);
+    _pmappedtree.reset();
     _cachetree.Reset();
 }
 
 bool ConfigurationCache::Validate()
 {
+    UpdateLock lock(*this);
     return _cachetree.Validate();
 }
 
+void ConfigurationCache::SetConcurrent(bool bConcurrent)
+{
+    boost::unique_lock<boost::shared_mutex> lock(_mutexcache); // wait for all running queries
+    _bConcurrent = bConcurrent;
+    _cachetree.SetConcurrentQueries(bConcurrent);
+}
+
+bool ConfigurationCache::MapCache(const std::string& filename)
+{
+    UpdateLock lock(*this);
+    MappedCacheTreePtr pmappedtree;
+    try {
+        pmappedtree.reset(new MappedCacheTree(filename));
+    }
+    catch(const openrave_exception& ex) {
+        RAVELOG_WARN_FORMAT("failed to map cache: %s", ex.what());
+        return false;
+    }
+    if( pmappedtree->GetStateDOF() != (int)_cachetree.GetWeights().size() ) {
+        RAVELOG_WARN_FORMAT("cache %s has %d dof, but the cache has %d", filename%pmappedtree->GetStateDOF()%_cachetree.GetWeights().size());
+        return false;
+    }
+    _pmappedtree = pmappedtree;
+    return true;
+}
+
+void ConfigurationCache::UnmapCache()
+{
+    UpdateLock lock(*this);
+    _pmappedtree.reset();
+}
+
+void ConfigurationCache::SetWriteAheadLog(const std::string& logfilename)
+{
+    UpdateLock lock(*this);
+    _FlushWriteAheadLog();
+    _logfilename = logfilename;
+}
+
+void ConfigurationCache::FlushWriteAheadLog()
+{
+    UpdateLock lock(*this);
+    _FlushWriteAheadLog();
+}
+
+void ConfigurationCache::_FlushWriteAheadLog()
+{
+    if( _vlogbuffer.size() == 0 || _logfilename.size() == 0 ) {
+        return;
+    }
+    // open the log for every flush under the lock of the log, so records are never appended to a log that MergeCache has already renamed
+    CacheLogLock loglock(_logfilename);
+    FILE* pfile = fopen(_logfilename.c_str(), "ab");
+    if( !pfile ) {
+        RAVELOG_WARN_FORMAT("failed to open cache log %s, dropping %d bytes", _logfilename%_vlogbuffer.size());
+        _vlogbuffer.resize(0);
+        return;
+    }
+    // unbuffered, so the records go out in one append and do not interleave with the records of other processes
+    setvbuf(pfile, NULL, _IONBF, 0);
+    if( fwrite(&_vlogbuffer[0], _vlogbuffer.size(), 1, pfile) != 1 ) {
+        RAVELOG_WARN_FORMAT("failed to write cache log %s", _logfilename);
+    }
+    fclose(pfile);
+    _vlogbuffer.resize(0);
+}
+
+void ConfigurationCache::_LogConfiguration(const std::vector<dReal>& conf, CollisionReportPtr report)
+{
+    CacheLogRecordHeader record;
+    record.magic = CACHELOG_MAGIC_NUMBER;
+    record.statedof = conf.size();
+    record.conftype = !report ? CNT_Free : CNT_Collision;
+    record.robotlinkindex = !!report && !!report->plink1 ? report->plink1->GetIndex() : -1;
+    record.collidinglinkindex = -1;
+    std::string collidingbodyname;
+    if( !!report && !!report->plink2 ) {
+        collidingbodyname = report->plink2->GetParent()->GetName();
+        record.collidinglinkindex = report->plink2->GetIndex();
+    }
+    record.bodynamelength = collidingbodyname.size();
+
+    size_t offset = _vlogbuffer.size();
+    _vlogbuffer.resize(offset + sizeof(record) + collidingbodyname.size() + conf.size()*sizeof(dReal));
+    memcpy(&_vlogbuffer[offset], &record, sizeof(record));
+    offset += sizeof(record);
+    if( collidingbodyname.size() > 0 ) {
+        memcpy(&_vlogbuffer[offset], collidingbodyname.c_str(), collidingbodyname.size());
+        offset += collidingbodyname.size();
+    }
+    if( conf.size() > 0 ) {
+        memcpy(&_vlogbuffer[offset], &conf[0], conf.size()*sizeof(dReal));
+    }
+    if( _vlogbuffer.size() >= CACHELOG_FLUSH_SIZE ) {
+        _FlushWriteAheadLog();
+    }
+}
+
+KinBody::LinkConstPtr ConfigurationCache::_FindLink(const std::string& bodyname, int linkindex) const
+{
+    KinBodyPtr pbody = _penv->GetKinBody(bodyname);
+    if( !pbody || linkindex < 0 || linkindex >= (int)pbody->GetLinks().size() ) {
+        return KinBody::LinkConstPtr();
+    }
+    return pbody->GetLinks()[linkindex];
+}
+
+KinBody::LinkConstPtr ConfigurationCache::_GetCacheLink(KinBody::LinkConstPtr plink) const
+{
+    if( !plink ) {
+        return plink;
+    }
+    KinBodyPtr pbody = plink->GetParent(true);
+    if( !pbody ) {
+        return KinBody::LinkConstPtr();
+    }
+    if( pbody->GetEnv() == _penv ) {
+        return plink;
+    }
+    return _FindLink(pbody->GetName(), plink->GetIndex());
+}
+
+bool ConfigurationCache::_IsStateRobotLink(KinBody::LinkConstPtr plink) const
+{
+    if( !plink ) {
+        return false;
+    }
+    KinBodyPtr pbody = plink->GetParent(true);
+    return !!pbody && (pbody == _pstaterobot || (pbody->GetEnv() != _penv && pbody->GetName() == _pstaterobot->GetName()));
+}
+
+int ConfigurationCache::_InsertConfiguration(const std::vector<dReal>& conf, ConfigurationNodeType conftype, KinBody::LinkConstPtr robotlink, KinBody::LinkConstPtr collidinglink)
+{
+    CollisionReportPtr report;
+    if( conftype == CNT_Collision ) {
+        if( !robotlink || !collidinglink ) {
+            return -1;
+        }
+        report.reset(new CollisionReport());
+        report->plink1 = robotlink;
+        report->plink2 = collidinglink;
+    }
+    return _cachetree.InsertNode(conf, report, !report ? _freespacethresh*_insertiondistancemult : _collisionthresh*_insertiondistancemult);
+}
+
+int ConfigurationCache::MergeCache(const std::string& filename, const std::string& logfilename)
+{
+    UpdateLock lock(*this);
+    if( logfilename == _logfilename ) {
+        _FlushWriteAheadLog();
+    }
+    int statedof = _cachetree.GetWeights().size();
+
+    // keep the current nodes, loading the file replaces them
+    std::vector<CacheTreeNodePtr> vnodes;
+    _cachetree.GetNodeValuesList(vnodes);
+    std::vector<dReal> vstates;
+    std::vector<ConfigurationNodeType> vtypes;
+    std::vector<KinBody::LinkConstPtr> vrobotlinks, vcollidinglinks;
+    FOREACHC(itnode, vnodes) {
+        if( (*itnode)->GetType() == CNT_Unknown ) {
+            continue;
+        }
+        vstates.insert(vstates.end(), (*itnode)->GetConfigurationState(), (*itnode)->GetConfigurationState()+statedof);
+        vtypes.push_back((*itnode)->GetType());
+        int robotlinkindex = (*itnode)->GetRobotLinkIndex();
+        vrobotlinks.push_back(robotlinkindex >= 0 && robotlinkindex < (int)_pstaterobot->GetLinks().size() ? _pstaterobot->GetLinks()[robotlinkindex] : KinBody::LinkConstPtr());
+        vcollidinglinks.push_back((*itnode)->GetCollidingLink());
+    }
+
+    _pmappedtree.reset();
+    if( !_cachetree.LoadCache(filename, _penv) ) {
+        _cachetree.Reset();
+    }
+
+    // take the log out of the way of the writers. A log left by a merge that did not finish is replayed together with the current log.
+    std::string mergelogfilename = logfilename + ".merge";
+    {
+        CacheLogLock loglock(logfilename);
+        std::vector<char> vcurrentlogdata;
+        if( !std::ifstream(mergelogfilename.c_str()) ) {
+            std::rename(logfilename.c_str(), mergelogfilename.c_str());
+        }
+        else if( ReadCacheLog(logfilename, vcurrentlogdata) ) {
+            FILE* pfile = fopen(mergelogfilename.c_str(), "ab");
+            if( !!pfile ) {
+                bool bwritten = vcurrentlogdata.size() == 0 || fwrite(&vcurrentlogdata[0], vcurrentlogdata.size(), 1, pfile) == 1;
+                fclose(pfile);
+                if( bwritten ) {
+                    std::remove(logfilename.c_str());
+                }
+            }
+            else {
+                RAVELOG_WARN_FORMAT("failed to open cache log %s, %s is merged next time", mergelogfilename%logfilename);
+            }
+        }
+    }
+
+    int numinserted = 0, numrecords = 0, numskipped = 0;
+    std::vector<char> vlogdata;
+    ReadCacheLog(mergelogfilename, vlogdata);
+    std::vector<dReal> conf(statedof);
+    std::string collidingbodyname;
+    size_t offset = 0;
+    while( offset + sizeof(CacheLogRecordHeader) <= vlogdata.size() ) {
+        CacheLogRecordHeader record;
+        memcpy(&record, &vlogdata[offset], sizeof(record));
+        if( record.magic != CACHELOG_MAGIC_NUMBER || record.bodynamelength < 0 || offset + sizeof(record) + record.bodynamelength + record.statedof*sizeof(dReal) > vlogdata.size() ) {
+            RAVELOG_WARN_FORMAT("cache log %s is corrupted after %d records", mergelogfilename%numrecords);
+            break;
+        }
+        offset += sizeof(record);
+        collidingbodyname.assign(&vlogdata[offset], record.bodynamelength);
+        offset += record.bodynamelength;
+        if( record.statedof == statedof ) {
+            memcpy(&conf[0], &vlogdata[offset], statedof*sizeof(dReal));
+            KinBody::LinkConstPtr robotlink;
+            if( record.robotlinkindex >= 0 && record.robotlinkindex < (int)_pstaterobot->GetLinks().size() ) {
+                robotlink = _pstaterobot->GetLinks()[record.robotlinkindex];
+            }
+            int ret = _InsertConfiguration(conf, (ConfigurationNodeType)record.conftype, robotlink, _FindLink(collidingbodyname, record.collidinglinkindex));
+            if( ret == 1 ) {
+                ++numinserted;
+            }
+            else if( ret < 0 ) {
+                ++numskipped;
+            }
+        }
+        else {
+            ++numskipped;
+        }
+        offset += record.statedof*sizeof(dReal);
+        ++numrecords;
+    }
+
+    for(size_t inode = 0; inode < vtypes.size(); ++inode) {
+        std::copy(vstates.begin()+inode*statedof, vstates.begin()+(inode+1)*statedof, conf.begin());
+        _InsertConfiguration(conf, vtypes[inode], vrobotlinks[inode], vcollidinglinks[inode]);
+    }
+
+    RAVELOG_DEBUG_FORMAT("merged %d/%d logged configurations (%d skipped) into %s", numinserted%numrecords%numskipped%filename);
+    if( _cachetree.SaveCache(filename) ) {
+        std::remove(mergelogfilename.c_str());
+    }
+    return numinserted;
+}
+
 void ConfigurationCache::_UpdateUntrackedBody(KinBodyPtr pbody)
 {
     // body's state has changed, so remove collision space and invalidate free space.
@@ -1391,6 +2010,7 @@ void ConfigurationCache::_UpdateRobotJointLimits()
 
     if (_envupdates) {
         RAVELOG_VERBOSE("Updating robot joint limits\n");
+        UpdateLock lock(*this);
 
         _pstaterobot->SetActiveDOFs(_vRobotActiveIndices, _nRobotAffineDOF);
         _pstaterobot->GetActiveDOFLimits(_newlowerlimit, _newupperlimit);
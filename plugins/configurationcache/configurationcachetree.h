@@ -18,6 +18,11 @@
 #include "openraveplugindefs.h"
 #include <deque>
 #include <boost/pool/pool.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <atomic>
 
 #define _(msgid) OpenRAVE::RaveGetLocalizedTextForDomain("openrave_plugins_configurationcache", msgid)
 
@@ -149,6 +154,116 @@ private:
     friend class CacheTree;
 };
 
+/// \brief header of the flat cache files written by CacheTree::SaveCache
+///
+/// The header is followed by the weights, the node records, the node states, the child indices and the names of the colliding bodies at the given offsets. Nodes refer to each other by index, so the file can be mapped read-only by any number of processes and queried in place by MappedCacheTree.
+struct FlatCacheHeader
+{
+    uint32_t magic; ///< FLATCACHE_MAGIC_NUMBER
+    uint16_t version; ///< FLATCACHE_VERSION
+    uint16_t realsize; ///< sizeof(dReal) of the process that wrote the file
+    int32_t statedof;
+    int32_t maxlevel, minlevel;
+    uint32_t numnodes;
+    uint32_t numchildren; ///< total number of child indices
+    uint32_t rootindex; ///< index of the node at maxlevel
+    uint32_t numbodynames;
+    uint32_t reserved;
+    double base, maxdistance;
+    uint64_t weightsoffset, nodesoffset, statesoffset, childrenoffset, bodynamesoffset, filesize;
+};
+
+/// \brief fixed size node record of the flat cache files
+struct FlatCacheNode
+{
+    int16_t level;
+    uint8_t conftype; ///< ConfigurationNodeType
+    uint8_t hasselfchild;
+    uint8_t usenn;
+    uint8_t reserved[3];
+    int32_t robotlinkindex;
+    int32_t collidingbodyindex; ///< index into the body names of the file, -1 if the node has no colliding link
+    int32_t collidinglinkindex;
+    uint32_t firstchild; ///< index of the first child in the child indices of the file
+    uint32_t numchildren;
+    int32_t hitcount;
+};
+
+static const uint32_t FLATCACHE_MAGIC_NUMBER = 0x43524643; ///< "CFRC"
+static const uint16_t FLATCACHE_VERSION = 1;
+
+/// \brief read-only cache tree of a flat cache file mapped into memory.
+///
+/// Queries run directly on the mapped pages, so opening a cache of any size is immediate and the pages are shared between all processes mapping the same file.
+class MappedCacheTree
+{
+public:
+    /// \brief maps filename, throws openrave_exception if it is not a flat cache file
+    MappedCacheTree(const std::string& filename);
+
+    const std::string& GetFilename() const {
+        return _filename;
+    }
+
+    const FlatCacheHeader& GetHeader() const {
+        return _header;
+    }
+
+    int GetNumNodes() const {
+        return _header.numnodes;
+    }
+
+    int GetStateDOF() const {
+        return _header.statedof;
+    }
+
+    const FlatCacheNode& GetNode(int index) const {
+        return _pnodes[index];
+    }
+
+    const dReal* GetConfigurationState(int index) const {
+        return _pstates + (size_t)index*_header.statedof;
+    }
+
+    const uint32_t* GetChildren(const FlatCacheNode& node) const {
+        return _pchildren + node.firstchild;
+    }
+
+    const std::vector<dReal>& GetWeights() const {
+        return _vweights;
+    }
+
+    const std::vector<std::string>& GetBodyNames() const {
+        return _vbodynames;
+    }
+
+    /// \brief same query as CacheTree::FindNearestNode(cs, collisionthresh, freespacethresh)
+    ///
+    /// \return the index of the node and its distance, the index is -1 if no node is within the thresholds
+    std::pair<int, dReal> FindNearestNode(const std::vector<dReal>& cs, dReal collisionthresh, dReal freespacethresh) const;
+
+private:
+    dReal _ComputeDistance2(const dReal* cstatei, const dReal* cstatef) const;
+
+    std::string _filename;
+    OPENRAVE_SHARED_PTR<boost::interprocess::mapped_region> _pmappedregion;
+    FlatCacheHeader _header;
+    const FlatCacheNode* _pnodes; ///< points into _pmappedregion
+    const dReal* _pstates; ///< points into _pmappedregion
+    const uint32_t* _pchildren; ///< points into _pmappedregion
+    std::vector<dReal> _vweights;
+    std::vector<std::string> _vbodynames;
+    dReal _fMaxLevelBound, _fBaseInv;
+
+    struct QueryBuffers
+    {
+        std::vector< std::pair<int, dReal> > _vCurrentLevelNodes, _vNextLevelNodes;
+    };
+    mutable boost::thread_specific_ptr<QueryBuffers> _pthreadquerybuffers;
+};
+
+typedef OPENRAVE_SHARED_PTR<MappedCacheTree> MappedCacheTreePtr;
+
 typedef CacheTreeNode* CacheTreeNodePtr; ///< OPENRAVE_SHARED_PTR might be too slow, and we never expose the pointers outside of CacheTree, so can use raw pointers.
 typedef const CacheTreeNode* CacheTreeNodeConstPtr;
 
@@ -243,6 +358,17 @@ public:
     /// \brief for debug purposes, validates the tree as described in Beygelzimer et al. 2006 http://hunch.net/~jl/projects/cover_tree/icml_final/final-icml.pdf
     bool Validate();
 
+    /// \brief if true, FindNearestNode can be called from several threads at the same time as long as no thread modifies the tree.
+    ///
+    /// The queries then use buffers local to every thread and do not update the hit counts, so they never write to the tree.
+    void SetConcurrentQueries(bool bConcurrent) {
+        _bConcurrentQueries = bConcurrent;
+    }
+
+    bool IsConcurrentQueries() const {
+        return _bConcurrentQueries;
+    }
+
     /// \brief sets all collision configurations in the tree to CNT_Unknown
     int RemoveCollisionConfigurations();
 
@@ -258,13 +384,31 @@ public:
     /// \brief returns the number of configurations in the tree that are not CNT_Unknown
     int GetNumKnownNodes();
 
-    /// \brief save cache to disk
-    int SaveCache(std::string filename);
+    /// \brief saves all the nodes to a flat cache file, see FlatCacheHeader
+    ///
+    /// The file is written next to filename and renamed over it, so processes that mapped the previous file keep a consistent view.
+    /// \return 1 if saved, 0 if the file could not be written
+    int SaveCache(const std::string& filename);
+
+    /// \brief replaces the nodes with the nodes of a flat cache file written by SaveCache
+    ///
+    /// The tree is copied from the file in one pass without reinserting the nodes. The colliding links are looked up by body name in penv.
+    /// \return 1 if loaded, 0 if the file does not exist or is not compatible with the tree
+    int LoadCache(const std::string& filename, EnvironmentBasePtr penv);
 
-    /// \brief load cache from disk
-    int LoadCache(std::string filename, EnvironmentBasePtr penv);
+    /// \brief replaces the nodes with the nodes of a mapped flat cache file
+    int LoadCache(const MappedCacheTree& mappedtree, EnvironmentBasePtr penv);
 
 private:
+    /// \brief the buffers of the level by level traversals of the queries
+    struct QueryBuffers
+    {
+        std::vector< std::pair<CacheTreeNodePtr, dReal> > _vCurrentLevelNodes, _vNextLevelNodes;
+    };
+
+    /// \brief returns the buffers the queries of the calling thread should use
+    QueryBuffers& _GetQueryBuffers() const;
+
     /// \brief creates new node on the pool
     CacheTreeNodePtr _CreateCacheTreeNode(const std::vector<dReal>& cs, CollisionReportPtr report);
     CacheTreeNodePtr _CloneCacheTreeNode(CacheTreeNodeConstPtr refnode);
@@ -337,7 +481,10 @@ private:
     dReal _fMaxLevelBound; ///< pow(_base, _maxlevel)
 
     // cache cache
-    mutable std::vector< std::pair<CacheTreeNodePtr, dReal> > _vCurrentLevelNodes, _vNextLevelNodes;
+    std::vector< std::pair<CacheTreeNodePtr, dReal> > _vCurrentLevelNodes, _vNextLevelNodes; ///< used by the insertion
+    mutable QueryBuffers _querybuffers; ///< used by the queries unless _bConcurrentQueries is set
+    mutable boost::thread_specific_ptr<QueryBuffers> _pthreadquerybuffers; ///< used by the queries when _bConcurrentQueries is set
+    bool _bConcurrentQueries;
     mutable std::vector< std::vector<CacheTreeNodePtr> > _vvCacheNodes;
 
     std::vector<CacheTreeNodePtr> _vnodes; ///< for loading
@@ -387,6 +534,15 @@ public:
     /// \brief invalidate the entire cache
     void Reset();
 
+    /// \brief if true, the cache can be queried and updated from several threads.
+    ///
+    /// The queries share a lock and run at the same time, every update of the cache takes the lock exclusively. CheckCollision has to be given the configuration, since the threads cannot share the state of the robot.
+    void SetConcurrent(bool bConcurrent);
+
+    inline bool IsConcurrent() const {
+        return _bConcurrent;
+    }
+
     void GetDOFValues(std::vector<dReal>& values);
 
     //int SynchronizeAll(KinBodyConstPtr pbody = KinBodyConstPtr());
@@ -401,6 +557,7 @@ public:
 
     /// \brief return configuration values for all nodes in the tree, calls cachetree's function
     void GetNodeValues(std::vector<dReal>& vals) const {
+        QueryLock lock(*this);
         _cachetree.GetNodeValues(vals);
     }
 
@@ -427,6 +584,7 @@ public:
     /// \brief set the base parameter
     inline void SetBase(dReal base)
     {
+        UpdateLock lock(*this);
         _cachetree.SetBase(base);
     }
 
@@ -489,19 +647,98 @@ public:
         _cachetree.UpdateCollisionNodes(pbody);
     }
 
-    /// \brief saves the cache to disk
-    inline void SaveCache(std::string filename)
+    /// \brief saves the cache to a flat cache file
+    inline int SaveCache(const std::string& filename)
     {
-        _cachetree.SaveCache(filename);
+        UpdateLock lock(*this);
+        return _cachetree.SaveCache(filename);
     }
 
-    /// \brief loads cache from disk
-    inline void LoadCache(std::string filename, EnvironmentBasePtr penv)
+    /// \brief loads a flat cache file into the cache
+    inline int LoadCache(const std::string& filename, EnvironmentBasePtr penv)
     {
-        _cachetree.LoadCache(filename, penv);
+        UpdateLock lock(*this);
+        return _cachetree.LoadCache(filename, penv);
+    }
+
+    /// \brief maps a flat cache file written by SaveCache read-only. CheckCollision queries it whenever the cache tree does not have an answer.
+    ///
+    /// The mapping is dropped as soon as the cache invalidates any of its configurations.
+    /// \return true if the file was mapped
+    bool MapCache(const std::string& filename);
+
+    /// \brief releases the mapped cache file
+    void UnmapCache();
+
+    /// \brief returns the mapped cache file, empty if nothing is mapped
+    inline MappedCacheTreePtr GetMappedCache() const {
+        return _pmappedtree;
     }
 
+    /// \brief appends every configuration inserted from now on to a write-ahead log, so that processes sharing a flat cache file can contribute to it. If empty, stops logging.
+    void SetWriteAheadLog(const std::string& logfilename);
+
+    /// \brief writes the buffered records of the write-ahead log to the file
+    void FlushWriteAheadLog();
+
+    /// \brief merges the flat cache file, the write-ahead log and the current nodes, saves the result to filename and removes the merged log
+    ///
+    /// The log is renamed before it is read, so processes can keep appending to a new log while the merge runs. The rename and every append of the log are guarded by a file lock on logfilename.lock, so no record is appended to the renamed log. A renamed log left by a merge that did not finish is replayed together with the current log.
+    /// Afterwards the cache tree holds all the nodes, so the mapped file is released.
+    /// \return the number of logged configurations inserted into the cache
+    int MergeCache(const std::string& filename, const std::string& logfilename);
+
 private:
+    /// \brief shared lock of _mutexcache taken by the queries of a concurrent cache
+    class QueryLock
+    {
+public:
+        QueryLock(const ConfigurationCache& cache) : _lock(cache._mutexcache, boost::defer_lock) {
+            if( cache._bConcurrent ) {
+                _lock.lock();
+            }
+        }
+
+private:
+        boost::shared_lock<boost::shared_mutex> _lock;
+    };
+
+    /// \brief exclusive lock of _mutexcache taken by the updates of a concurrent cache
+    class UpdateLock
+    {
+public:
+        UpdateLock(const ConfigurationCache& cache) : _lock(cache._mutexcache, boost::defer_lock) {
+            if( cache._bConcurrent ) {
+                _lock.lock();
+            }
+        }
+
+private:
+        boost::unique_lock<boost::shared_mutex> _lock;
+    };
+
+    /// \brief writes the buffered records of the write-ahead log, assumes the cache is locked
+    void _FlushWriteAheadLog();
+
+    /// \brief inserts a configuration without logging it, used by MergeCache
+    ///
+    /// \return the result of CacheTree::InsertNode, or -1 if conftype is CNT_Collision and one of the links is empty
+    int _InsertConfiguration(const std::vector<dReal>& conf, ConfigurationNodeType conftype, KinBody::LinkConstPtr robotlink, KinBody::LinkConstPtr collidinglink);
+
+    /// \brief appends a record of an inserted configuration to the write-ahead log buffer
+    void _LogConfiguration(const std::vector<dReal>& conf, CollisionReportPtr report);
+
+    /// \brief returns the link with the index of the body with the given name, or empty if it does not exist
+    KinBody::LinkConstPtr _FindLink(const std::string& bodyname, int linkindex) const;
+
+    /// \brief returns the link of the environment of the cache with the same body name and index as plink.
+    ///
+    /// Reports inserted by the checkers of cloned environments sharing the cache have links of their own environments, which must not be stored in the tree since those environments can be destroyed before the cache.
+    KinBody::LinkConstPtr _GetCacheLink(KinBody::LinkConstPtr plink) const;
+
+    /// \brief returns true if plink is a link of the state robot, or of the robot with the same name in a cloned environment
+    bool _IsStateRobotLink(KinBody::LinkConstPtr plink) const;
+
     /// \brief called when body has changed state.
     void _UpdateUntrackedBody(KinBodyPtr pbody);
 
@@ -515,6 +752,9 @@ private:
     void _UpdateRobotGrabbed();
 
     CacheTree _cachetree; ///< cache tree datastructure with configurations and their collision information
+    MappedCacheTreePtr _pmappedtree; ///< read-only flat cache file queried when _cachetree misses
+    std::string _logfilename; ///< write-ahead log of the inserted configurations, empty if not logging
+    std::vector<char> _vlogbuffer; ///< records not written to _logfilename yet
 
     RobotBasePtr _pstaterobot;
     std::vector<int> _vRobotActiveIndices;
@@ -551,6 +791,9 @@ public:
 
     bool _envupdates; ///< if set to true, cache will update itself when the environment changes; should be set to false for selfcollision cache
 
+    mutable boost::shared_mutex _mutexcache; ///< protects the cache when _bConcurrent is set
+    std::atomic<bool> _bConcurrent; ///< if true, the cache is used from several threads. Read by the locks without holding _mutexcache
+
 };
 
 typedef OPENRAVE_SHARED_PTR<ConfigurationCache> ConfigurationCachePtr;
@@ -181,6 +181,34 @@ public:
         return _cache->ComputeDistance(openravepy::ExtractArray<dReal>(oconfi), openravepy::ExtractArray<dReal>(oconff));
     }
 
+    int SaveCache(const std::string& filename) {
+        return _cache->SaveCache(filename);
+    }
+
+    int LoadCache(const std::string& filename) {
+        return _cache->LoadCache(filename, _cache->GetRobot()->GetEnv());
+    }
+
+    bool MapCache(const std::string& filename) {
+        return _cache->MapCache(filename);
+    }
+
+    void UnmapCache() {
+        _cache->UnmapCache();
+    }
+
+    void SetWriteAheadLog(const std::string& logfilename) {
+        _cache->SetWriteAheadLog(logfilename);
+    }
+
+    void FlushWriteAheadLog() {
+        _cache->FlushWriteAheadLog();
+    }
+
+    int MergeCache(const std::string& filename, const std::string& logfilename) {
+        return _cache->MergeCache(filename, logfilename);
+    }
+
 protected:
     object _pyenv;
     configurationcache::ConfigurationCachePtr _cache;
@@ -224,6 +252,13 @@ OPENRAVE_PYTHON_MODULE(openravepy_configurationcache)
     .def("GetNodeValues", &PyConfigurationCache::GetNodeValues)
     .def("FindNearestNode", &PyConfigurationCache::FindNearestNode)
     .def("ComputeDistance", &PyConfigurationCache::ComputeDistance)
+    .def("SaveCache", &PyConfigurationCache::SaveCache, PY_ARGS("filename") "Saves the cache to a flat cache file")
+    .def("LoadCache", &PyConfigurationCache::LoadCache, PY_ARGS("filename") "Loads a flat cache file into the cache")
+    .def("MapCache", &PyConfigurationCache::MapCache, PY_ARGS("filename") "Maps a flat cache file read-only, it is queried when the cache misses")
+    .def("UnmapCache", &PyConfigurationCache::UnmapCache)
+    .def("SetWriteAheadLog", &PyConfigurationCache::SetWriteAheadLog, PY_ARGS("logfilename") "Appends the inserted configurations to a log, empty to stop")
+    .def("FlushWriteAheadLog", &PyConfigurationCache::FlushWriteAheadLog)
+    .def("MergeCache", &PyConfigurationCache::MergeCache, PY_ARGS("filename", "logfilename") "Merges the flat cache file, the log and the cache into the flat cache file")
 
     .def("GetCollisionThresh", &PyConfigurationCache::GetCollisionThresh)
     .def("GetFreeSpaceThresh", &PyConfigurationCache::GetFreeSpaceThresh)
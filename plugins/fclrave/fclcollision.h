@@ -9,6 +9,8 @@
 
 #include "fclspace.h"
 #include "fclmanagercache.h"
+#include "fclthreadpool.h"
+#include "fclraycast.h"
 
 #include "fclstatistics.h"
 
@@ -123,6 +125,7 @@ public:
         // TODO : Should we put a more reasonable arbitrary value ?
         _numMaxContacts = std::numeric_limits<int>::max();
         _nGetEnvManagerCacheClearCount = 100000;
+        _fContinuousStepLength = 0.2;
         __description = ":Interface Author: Kenji Maillard\n\nFlexible Collision Library collision checker";
 
         SETUP_STATISTICS(_statistics, _userdatakey, GetEnv()->GetId());
@@ -130,6 +133,9 @@ public:
         // TODO : Consider removing these which could be more harmful than anything else
         RegisterCommand("SetBroadphaseAlgorithm", boost::bind(&FCLCollisionChecker::SetBroadphaseAlgorithmCommand, this, _1, _2), "sets the broadphase algorithm (Naive, SaP, SSaP, IntervalTree, DynamicAABBTree, DynamicAABBTree_Array)");
         RegisterCommand("SetBVHRepresentation", boost::bind(&FCLCollisionChecker::_SetBVHRepresentation, this, _1, _2), "sets the Bouding Volume Hierarchy representation for meshes (AABB, OBB, OBBRSS, RSS, kIDS)");
+        RegisterCommand("GetMeshCacheStatistics", boost::bind(&FCLCollisionChecker::_GetMeshCacheStatisticsCommand, this, _1, _2), "returns the statistics of the process-wide mesh BVH cache shared by all fcl checkers: \"hits misses entries residentbytes\"");
+        RegisterCommand("SetNarrowPhaseThreads", boost::bind(&FCLCollisionChecker::_SetNarrowPhaseThreadsCommand, this, _1, _2), "sets the number of threads running the narrow phase tests of batched link pair checks and the rays of CheckCollisionRays, 1 or less disables the thread pool");
+        RegisterCommand("SetContinuousStepLength", boost::bind(&FCLCollisionChecker::_SetContinuousStepLengthCommand, this, _1, _2), "sets the maximum change of any DOF value between two screw motions of the links in CheckContinuousCollision (default 0.2)");
 
         RAVELOG_VERBOSE_FORMAT("FCLCollisionChecker %s created in env %d", _userdatakey%penv->GetId());
 
@@ -179,6 +185,8 @@ public:
         // We don't want to clone _bIsSelfCollisionChecker since a self collision checker can be created by cloning a environment collision checker
         _options = r->_options;
         _numMaxContacts = r->_numMaxContacts;
+        _fContinuousStepLength = r->_fContinuousStepLength;
+        _SetNarrowPhaseThreads(!!r->_pNarrowPhasePool ? r->_pNarrowPhasePool->GetNumThreads() : 1);
         RAVELOG_VERBOSE(str(boost::format("FCL User data cloning env %d into env %d") % r->GetEnv()->GetId() % GetEnv()->GetId()));
     }
 
@@ -213,11 +221,6 @@ public:
     virtual bool SetCollisionOptions(int collision_options)
     {
         _options = collision_options;
-
-        if( _options & OpenRAVE::CO_RayAnyHit ) {
-            return false;
-        }
-
         return true;
     }
 
@@ -319,6 +322,49 @@ public:
         return _fclspace->GetBVHRepresentation();
     }
 
+    bool _GetMeshCacheStatisticsCommand(ostream& sout, istream& sinput)
+    {
+        FCLGeometryCache::Statistics stats;
+        FCLGeometryCache::GetInstance().GetStatistics(stats);
+        sout << stats.numhits << " " << stats.nummisses << " " << stats.numentries << " " << stats.residentbytes;
+        return true;
+    }
+
+    bool _SetNarrowPhaseThreadsCommand(ostream& sout, istream& sinput)
+    {
+        int numthreads = 1;
+        sinput >> numthreads;
+        if( !sinput ) {
+            return false;
+        }
+        _SetNarrowPhaseThreads(numthreads);
+        return true;
+    }
+
+    bool _SetContinuousStepLengthCommand(ostream& sout, istream& sinput)
+    {
+        dReal fsteplength = 0;
+        sinput >> fsteplength;
+        if( !sinput || fsteplength <= 0 ) {
+            return false;
+        }
+        _fContinuousStepLength = fsteplength;
+        return true;
+    }
+
+    void _SetNarrowPhaseThreads(int numthreads)
+    {
+        int numcurrent = !!_pNarrowPhasePool ? _pNarrowPhasePool->GetNumThreads() : 1;
+        if( numthreads == numcurrent || (numthreads <= 1 && numcurrent <= 1) ) {
+            return;
+        }
+        _pNarrowPhasePool.reset();
+        if( numthreads > 1 ) {
+            // the calling thread runs iterations too
+            _pNarrowPhasePool.reset(new FCLThreadPool(numthreads-1));
+        }
+    }
+
 
     virtual bool InitEnvironment()
     {
@@ -337,6 +383,7 @@ public:
     {
         RAVELOG_VERBOSE(str(boost::format("FCL User data destroying %s in env %d") % _userdatakey % GetEnv()->GetId()));
         _fclspace->DestroyEnvironment();
+        _mapContinuousGeometries.clear();
     }
 
     virtual bool InitKinBody(OpenRAVE::KinBodyPtr pbody)
@@ -468,6 +515,58 @@ public:
         return query._bCollision;
     }
 
+    virtual bool CheckCollisionLinkPairs(const std::vector<std::pair<LinkConstPtr, LinkConstPtr> >& vlinkpairs, CollisionReportPtr report = CollisionReportPtr())
+    {
+        START_TIMING_OPT(_statistics, "LinkPairs",_options,false);
+        if( _options & OpenRAVE::CO_Distance ) {
+            // distance has to be computed for every pair, nothing can be culled
+            return CollisionCheckerBase::CheckCollisionLinkPairs(vlinkpairs, report);
+        }
+        if( !!report ) {
+            report->Reset(_options);
+        }
+
+        // synchronize every body only once
+        _vCachedPairBodies.resize(0);
+        FOREACHC(itlinkpair, vlinkpairs) {
+            for(int ilink = 0; ilink < 2; ++ilink) {
+                const LinkConstPtr& plink = ilink == 0 ? itlinkpair->first : itlinkpair->second;
+                KinBodyPtr pparent = plink->GetParent(true);
+                if( !pparent ) {
+                    throw OPENRAVE_EXCEPTION_FORMAT("Failed to get link %s parent", plink->GetName(), OpenRAVE::ORE_InvalidArguments);
+                }
+                if( !IsIn<const KinBody*>(pparent.get(), _vCachedPairBodies) ) {
+                    _vCachedPairBodies.push_back(pparent.get());
+                    _fclspace->SynchronizeWithAttached(*pparent);
+                }
+            }
+        }
+
+        _vCachedLinkInfoPairs.resize(0);
+        FOREACHC(itlinkpair, vlinkpairs) {
+            if( !itlinkpair->first->IsEnabled() || !itlinkpair->second->IsEnabled() ) {
+                continue;
+            }
+            KinBodyInfoPtr pinfo1 = _fclspace->GetInfo(*itlinkpair->first->GetParent()), pinfo2 = _fclspace->GetInfo(*itlinkpair->second->GetParent());
+            if( !pinfo1 || !pinfo2 ) {
+                continue;
+            }
+            FCLSpace::KinBodyInfo::LinkInfo* pLINK1 = pinfo1->vlinks.at(itlinkpair->first->GetIndex()).get();
+            FCLSpace::KinBodyInfo::LinkInfo* pLINK2 = pinfo2->vlinks.at(itlinkpair->second->GetIndex()).get();
+            if( !pLINK1->linkBV.second || !pLINK2->linkBV.second ) {
+                continue;
+            }
+            _vCachedLinkInfoPairs.push_back(std::make_pair(pLINK1, pLINK2));
+        }
+
+        const std::vector<KinBodyConstPtr> vbodyexcluded;
+        const std::vector<LinkConstPtr> vlinkexcluded;
+        CollisionCallbackData query(shared_checker(), report, vbodyexcluded, vlinkexcluded);
+        ADD_TIMING(_statistics);
+        query.bselfCollision = true;  // for ignoring attached information!
+        return _CheckLinkInfoPairs(query);
+    }
+
     virtual bool CheckCollision(LinkConstPtr plink, KinBodyConstPtr pbody,CollisionReportPtr report = CollisionReportPtr())
     {
         START_TIMING_OPT(_statistics, "Link/Body",_options,pbody->IsRobot());
@@ -594,20 +693,70 @@ public:
 
     virtual bool CheckCollision(const RAY& ray, LinkConstPtr plink,CollisionReportPtr report = CollisionReportPtr())
     {
-        RAVELOG_WARN("fcl doesn't support Ray collisions\n");
-        return false; //TODO
+        if( !!report ) {
+            report->Reset(_options);
+        }
+
+        _vRayCastLinks.resize(0);
+        _vRayCastGeoms.resize(0);
+        if( !plink->IsEnabled() ) {
+            return false;
+        }
+        _fclspace->SynchronizeWithAttached(*plink->GetParent());
+        LinkInfoPtr pLINK = _fclspace->GetLinkInfo(*plink);
+        if( !pLINK || !pLINK->linkBV.second ) {
+            return false;
+        }
+        _AddRayCastLink(*pLINK, plink);
+        return _CheckRayCollision(ray, report);
     }
 
     virtual bool CheckCollision(const RAY& ray, KinBodyConstPtr pbody, CollisionReportPtr report = CollisionReportPtr())
     {
-        RAVELOG_WARN("fcl doesn't support Ray collisions\n");
-        return false; //TODO
+        if( !!report ) {
+            report->Reset(_options);
+        }
+
+        _SetupRayCastLinks(pbody);
+        return _CheckRayCollision(ray, report);
     }
 
     virtual bool CheckCollision(const RAY& ray, CollisionReportPtr report = CollisionReportPtr())
     {
-        RAVELOG_WARN("fcl doesn't support Ray collisions\n");
-        return false; //TODO
+        if( !!report ) {
+            report->Reset(_options);
+        }
+
+        _SetupRayCastLinks(KinBodyConstPtr());
+        return _CheckRayCollision(ray, report);
+    }
+
+    virtual int CheckCollisionRays(const std::vector<RAY>& vrays, std::vector<dReal>& vdistances, std::vector<Vector>& vnormals, std::vector<int>& vbodyids, KinBodyConstPtr pbody = KinBodyConstPtr()) override
+    {
+        vdistances.resize(vrays.size());
+        vnormals.resize(vrays.size());
+        vbodyids.resize(vrays.size());
+        _SetupRayCastLinks(pbody);
+
+        // hand out the rays in blocks so that the threads do not contend on every ray
+        size_t numblocks = (vrays.size() + s_nRayBlockSize - 1)/s_nRayBlockSize;
+        boost::function<void(size_t)> fn = boost::bind(&FCLCollisionChecker::_CheckRayBlock, this, _1, boost::cref(vrays), boost::ref(vdistances), boost::ref(vnormals), boost::ref(vbodyids));
+        if( !!_pNarrowPhasePool && numblocks > 1 && _vRayCastLinks.size() > 0 ) {
+            _pNarrowPhasePool->ParallelFor(numblocks, fn);
+        }
+        else {
+            for(size_t iblock = 0; iblock < numblocks; ++iblock) {
+                fn(iblock);
+            }
+        }
+
+        int numhits = 0;
+        FOREACHC(itbodyid, vbodyids) {
+            if( *itbodyid != 0 ) {
+                ++numhits;
+            }
+        }
+        return numhits;
     }
 
     virtual bool CheckCollision(const OpenRAVE::TriMesh& trimesh, KinBodyConstPtr pbody, CollisionReportPtr report = CollisionReportPtr()) override
@@ -772,6 +921,173 @@ public:
         return query._bCollision;
     }
     
+    virtual bool CheckContinuousCollision(KinBodyConstPtr pbody, const std::vector<dReal>& q0, const std::vector<dReal>& q1, dReal& ftimeofcontact, CollisionReportPtr report = CollisionReportPtr())
+    {
+        START_TIMING_OPT(_statistics, "BodyContinuous",_options,pbody->IsRobot());
+        if( !!report ) {
+            report->Reset(_options);
+        }
+        ftimeofcontact = 1;
+        OPENRAVE_ASSERT_OP((int)q0.size(),==,pbody->GetDOF());
+        OPENRAVE_ASSERT_OP((int)q1.size(),==,pbody->GetDOF());
+        if( _options & OpenRAVE::CO_Distance ) {
+            throw OPENRAVE_EXCEPTION_FORMAT0("CheckContinuousCollision does not support CO_Distance", OpenRAVE::ORE_InvalidArguments);
+        }
+        if( pbody->GetLinks().size() == 0 || !_IsEnabled(*pbody) ) {
+            return false;
+        }
+        if( pbody->GetDOF() == 0 ) {
+            // nothing moves
+            if( CheckCollision(pbody, report) ) {
+                ftimeofcontact = 0;
+                return true;
+            }
+            return false;
+        }
+
+        // the links do not follow screw motions when the joints are interpolated linearly, so split the motion into steps
+        // that are short enough for the screw motion between the ends of a step to stay close to the real motion
+        size_t dof = q0.size(), numlinks = pbody->GetLinks().size();
+        dReal fmaxdelta = 0;
+        for(size_t idof = 0; idof < dof; ++idof) {
+            fmaxdelta = std::max(fmaxdelta, RaveFabs(q1[idof]-q0[idof]));
+        }
+        int numsteps = std::max(1, (int)ceil(fmaxdelta/_fContinuousStepLength));
+        _vContinuousConfigs.resize((numsteps+1)*dof);
+        for(int istep = 0; istep <= numsteps; ++istep) {
+            dReal fraction = dReal(istep)/dReal(numsteps);
+            for(size_t idof = 0; idof < dof; ++idof) {
+                _vContinuousConfigs[istep*dof+idof] = q0[idof] + fraction*(q1[idof]-q0[idof]);
+            }
+        }
+        pbody->ComputeLinkTransformationsBatch(_vContinuousConfigs, _vContinuousLinkTransforms);
+
+        _fclspace->SynchronizeWithAttached(*pbody);
+        KinBodyInfoPtr pinfo = _fclspace->GetInfo(*pbody);
+        if( !pinfo ) {
+            return false;
+        }
+        // like the body manager of the discrete check, only the links moved by the active DOFs are checked with CO_ActiveDOFs
+        _vContinuousActiveLinks.resize(0);
+        if( (_options & OpenRAVE::CO_ActiveDOFs) && pbody->IsRobot() ) {
+            RobotBaseConstPtr probot = OpenRAVE::RaveInterfaceConstCast<RobotBase>(pbody);
+            _vContinuousActiveLinks.resize(numlinks, 0);
+            for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+                FOREACHC(itindex, probot->GetActiveDOFIndices()) {
+                    if( probot->DoesAffect(probot->GetJointFromDOFIndex(*itindex)->GetJointIndex(), ilink) ) {
+                        _vContinuousActiveLinks[ilink] = 1;
+                        break;
+                    }
+                }
+            }
+        }
+        _vContinuousMovingGeoms.resize(0);
+        for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+            if( !pbody->GetLinks()[ilink]->IsEnabled() || (_vContinuousActiveLinks.size() > 0 && !_vContinuousActiveLinks[ilink]) ) {
+                continue;
+            }
+            FCLSpace::KinBodyInfo::LinkInfo* plinkinfo = pinfo->vlinks.at(ilink).get();
+            FOREACH(itgeom, plinkinfo->vgeoms) {
+                _vContinuousMovingGeoms.push_back(ContinuousMovingGeom(plinkinfo, _GetContinuousGeometry(itgeom->second->collisionGeometry()), ilink, itgeom->first));
+            }
+        }
+        // grabbed bodies move rigidly with the links grabbing them
+        pbody->GetGrabbed(_vCachedGrabbedBodies);
+        FOREACH(itgrabbed, _vCachedGrabbedBodies) {
+            KinBody::LinkPtr pgrabbinglink = pbody->IsGrabbing(**itgrabbed);
+            KinBodyInfoPtr pgrabbedinfo = _fclspace->GetInfo(**itgrabbed);
+            if( !pgrabbinglink || !pgrabbedinfo ) {
+                continue;
+            }
+            Transform tgrabbinginv = pgrabbinglink->GetTransform().inverse();
+            FOREACHC(itlink, (*itgrabbed)->GetLinks()) {
+                if( !(*itlink)->IsEnabled() ) {
+                    continue;
+                }
+                FCLSpace::KinBodyInfo::LinkInfo* plinkinfo = pgrabbedinfo->vlinks.at((*itlink)->GetIndex()).get();
+                Transform trelative = tgrabbinginv * (*itlink)->GetTransform();
+                FOREACH(itgeom, plinkinfo->vgeoms) {
+                    _vContinuousMovingGeoms.push_back(ContinuousMovingGeom(plinkinfo, _GetContinuousGeometry(itgeom->second->collisionGeometry()), pgrabbinglink->GetIndex(), trelative * itgeom->first));
+                }
+            }
+        }
+
+        std::set<KinBodyConstPtr> attachedBodies;
+        pbody->GetAttached(attachedBodies);
+        _vContinuousStaticGeoms.resize(0);
+        FOREACHC(itbody, _fclspace->GetEnvBodies()) {
+            if( !(*itbody)->IsEnabled() || attachedBodies.count(*itbody) > 0 ) {
+                continue;
+            }
+            _fclspace->Synchronize(**itbody);
+            KinBodyInfoPtr pbodyinfo = _fclspace->GetInfo(**itbody);
+            if( !pbodyinfo ) {
+                continue;
+            }
+            FOREACHC(itlink, (*itbody)->GetLinks()) {
+                if( !(*itlink)->IsEnabled() ) {
+                    continue;
+                }
+                FCLSpace::KinBodyInfo::LinkInfo* plinkinfo = pbodyinfo->vlinks.at((*itlink)->GetIndex()).get();
+                FOREACH(itgeom, plinkinfo->vgeoms) {
+                    _vContinuousStaticGeoms.push_back(ContinuousStaticGeom(plinkinfo, itgeom->second.get(), _GetContinuousGeometry(itgeom->second->collisionGeometry())));
+                }
+            }
+        }
+
+        _listContinuousCallbacks.clear();
+        if( GetEnv()->HasRegisteredCollisionCallbacks() ) {
+            GetEnv()->GetRegisteredCollisionCallbacks(_listContinuousCallbacks);
+        }
+
+        ADD_TIMING(_statistics);
+        // conservative advancement never steps over a contact, unlike CCDC_NAIVE which only samples the motion
+        fcl::ContinuousCollisionRequest request;
+        request.ccd_motion_type = fcl::CCDM_SCREW;
+        request.ccd_solver_type = fcl::CCDC_CONSERVATIVE_ADVANCEMENT;
+        request.gjk_solver_type = fcl::GST_LIBCCD;
+        fcl::ContinuousCollisionResult result, contactresult;
+        // the steps are checked in order, so the first step with a contact holds the first time of contact
+        for(int istep = 0; istep < numsteps; ++istep) {
+            const Transform* ptransforms0 = &_vContinuousLinkTransforms[istep*numlinks];
+            const Transform* ptransforms1 = &_vContinuousLinkTransforms[(istep+1)*numlinks];
+            fcl::FCL_REAL fsteptimeofcontact = 2;
+            const ContinuousMovingGeom* pcontactmoving = NULL;
+            const ContinuousStaticGeom* pcontactstatic = NULL;
+            FOREACHC(itmoving, _vContinuousMovingGeoms) {
+                Transform tbeg = ptransforms0[itmoving->ilink] * itmoving->tlocal, tend = ptransforms1[itmoving->ilink] * itmoving->tlocal;
+                fcl::AABB sweptaabb = _ComputeSweptAABB(*itmoving->pgeom, tbeg, tend);
+                fcl::Transform3f tfbeg(ConvertQuaternionToFCL(tbeg.rot), ConvertVectorToFCL(tbeg.trans)), tfend(ConvertQuaternionToFCL(tend.rot), ConvertVectorToFCL(tend.trans));
+                FOREACHC(itstatic, _vContinuousStaticGeoms) {
+                    if( !sweptaabb.overlap(itstatic->pobj->getAABB()) ) {
+                        continue;
+                    }
+                    const fcl::Transform3f& tfstatic = itstatic->pobj->getTransform();
+                    result = fcl::ContinuousCollisionResult();
+                    fcl::continuousCollide(itmoving->pgeom, tfbeg, tfend, itstatic->pgeom, tfstatic, tfstatic, request, result);
+                    if( result.is_collide && result.time_of_contact < fsteptimeofcontact && !_IsContinuousContactIgnored(*itmoving, *itstatic, result) ) {
+                        fsteptimeofcontact = result.time_of_contact;
+                        pcontactmoving = &*itmoving;
+                        pcontactstatic = &*itstatic;
+                        contactresult = result;
+                    }
+                }
+            }
+            if( !!pcontactmoving ) {
+                ftimeofcontact = (dReal(istep) + dReal(fsteptimeofcontact))/dReal(numsteps);
+                if( !!report ) {
+                    report->plink1 = pcontactmoving->plinkinfo->GetLink();
+                    report->plink2 = pcontactstatic->plinkinfo->GetLink();
+                    if( _options & (OpenRAVE::CO_Contacts | OpenRAVE::CO_AllGeometryContacts) ) {
+                        _FillContinuousContacts(*pcontactmoving->pgeom, contactresult.contact_tf1, *pcontactstatic->pgeom, contactresult.contact_tf2, *report);
+                    }
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
     virtual bool CheckStandaloneSelfCollision(KinBodyConstPtr pbody, CollisionReportPtr report = CollisionReportPtr())
     {
         START_TIMING_OPT(_statistics, "BodySelf",_options,pbody->IsRobot());
@@ -802,6 +1118,14 @@ public:
         boost::shared_ptr<void> onexit((void*) 0, boost::bind(&FCLCollisionChecker::_PrintCollisionManagerInstanceSelf, this, boost::ref(*pbody)));
 #endif            
         KinBodyInfoPtr pinfo = _fclspace->GetInfo(*pbody);
+        if( !(_options & OpenRAVE::CO_Distance) ) {
+            _vCachedLinkInfoPairs.resize(0);
+            FOREACH(itset, nonadjacent) {
+                // We don't need to check if the links are enabled since we got adjacency information with AO_Enabled
+                _vCachedLinkInfoPairs.push_back(std::make_pair(pinfo->vlinks.at(*itset&0xffff).get(), pinfo->vlinks.at(*itset>>16).get()));
+            }
+            return _CheckLinkInfoPairs(query);
+        }
         FOREACH(itset, nonadjacent) {
             size_t index1 = *itset&0xffff, index2 = *itset>>16;
             // We don't need to check if the links are enabled since we got adjacency information with AO_Enabled
@@ -897,6 +1221,458 @@ private:
         return boost::static_pointer_cast<FCLCollisionChecker>(shared_from_this());
     }
 
+    /// \brief geometry of a link moving in CheckContinuousCollision
+    struct ContinuousMovingGeom
+    {
+        ContinuousMovingGeom(FCLSpace::KinBodyInfo::LinkInfo* plinkinfo, const fcl::CollisionGeometry* pgeom, int ilink, const Transform& tlocal) : plinkinfo(plinkinfo), pgeom(pgeom), ilink(ilink), tlocal(tlocal) {
+        }
+        FCLSpace::KinBodyInfo::LinkInfo* plinkinfo; ///< link owning the geometry, can be a link of a grabbed body
+        const fcl::CollisionGeometry* pgeom;
+        int ilink; ///< index of the link of the checked body that moves the geometry
+        Transform tlocal; ///< transform of the geometry in the frame of link ilink
+    };
+
+    /// \brief geometry of the scene in CheckContinuousCollision
+    struct ContinuousStaticGeom
+    {
+        ContinuousStaticGeom(FCLSpace::KinBodyInfo::LinkInfo* plinkinfo, fcl::CollisionObject* pobj, const fcl::CollisionGeometry* pgeom) : plinkinfo(plinkinfo), pobj(pobj), pgeom(pgeom) {
+        }
+        FCLSpace::KinBodyInfo::LinkInfo* plinkinfo;
+        fcl::CollisionObject* pobj; ///< holds the transform and the AABB of the geometry
+        const fcl::CollisionGeometry* pgeom; ///< geometry used in the continuous check, see _GetContinuousGeometry
+    };
+
+    /// \brief calls the collision callbacks of the environment with a contact found by CheckContinuousCollision, like
+    /// CheckNarrowPhaseGeomCollision does for the discrete checks.
+    ///
+    /// \return true if a callback returned CA_Ignore, so the contact does not count
+    bool _IsContinuousContactIgnored(const ContinuousMovingGeom& moving, const ContinuousStaticGeom& scene, const fcl::ContinuousCollisionResult& result)
+    {
+        if( _listContinuousCallbacks.size() == 0 ) {
+            return false;
+        }
+        _reportcache.Reset(_options);
+        _reportcache.plink1 = moving.plinkinfo->GetLink();
+        _reportcache.plink2 = scene.plinkinfo->GetLink();
+        if( _options & (OpenRAVE::CO_Contacts | OpenRAVE::CO_AllGeometryContacts) ) {
+            _FillContinuousContacts(*moving.pgeom, result.contact_tf1, *scene.pgeom, result.contact_tf2, _reportcache);
+        }
+        CollisionReportPtr preport(&_reportcache, OpenRAVE::utils::null_deleter());
+        FOREACH(itcallback, _listContinuousCallbacks) {
+            if( (*itcallback)(preport, false) == OpenRAVE::CA_Ignore ) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// \brief bounds the geometry along a screw motion between tbeg and tend.
+    ///
+    /// Uses the bounding spheres at both ends padded by half the distance traveled by the center, which covers the arc of short screw motions.
+    static fcl::AABB _ComputeSweptAABB(const fcl::CollisionGeometry& geom, const Transform& tbeg, const Transform& tend)
+    {
+        Vector vlocalcenter = ConvertVectorFromFCL(geom.aabb_center);
+        Vector vcenter0 = tbeg * vlocalcenter, vcenter1 = tend * vlocalcenter;
+        fcl::FCL_REAL fradius = geom.aabb_radius + 0.5*RaveSqrt((vcenter1-vcenter0).lengthsqr3());
+        fcl::AABB aabb(ConvertVectorToFCL(vcenter0), ConvertVectorToFCL(vcenter1));
+        aabb.min_ -= fcl::Vec3f(fradius, fradius, fradius);
+        aabb.max_ += fcl::Vec3f(fradius, fradius, fradius);
+        return aabb;
+    }
+
+    /// \brief fcl only implements conservative advancement for shapes and RSS/OBBRSS hierarchies
+    static bool _HasConservativeAdvancement(const fcl::CollisionGeometry& geom)
+    {
+        if( geom.getObjectType() == fcl::OT_GEOM ) {
+            return geom.getNodeType() != fcl::GEOM_PLANE && geom.getNodeType() != fcl::GEOM_HALFSPACE;
+        }
+        return geom.getNodeType() == fcl::BV_RSS || geom.getNodeType() == fcl::BV_OBBRSS;
+    }
+
+    /// \brief copies the triangles of a mesh into a RSS hierarchy, returns an empty pointer if geom is not a BVHModel<BV>
+    template <typename BV>
+    static CollisionGeometryPtr _ConvertMeshToRSS(const fcl::CollisionGeometry& geom)
+    {
+        const fcl::BVHModel<BV>* pmodel = dynamic_cast<const fcl::BVHModel<BV>*>(&geom);
+        if( !pmodel ) {
+            return CollisionGeometryPtr();
+        }
+        std::vector<fcl::Vec3f> vpoints(pmodel->vertices, pmodel->vertices+pmodel->num_vertices);
+        std::vector<fcl::Triangle> vtriangles(pmodel->tri_indices, pmodel->tri_indices+pmodel->num_tris);
+        std::shared_ptr< fcl::BVHModel<fcl::RSS> > prssmodel = make_shared< fcl::BVHModel<fcl::RSS> >();
+        prssmodel->beginModel(vtriangles.size(), vpoints.size());
+        prssmodel->addSubModel(vpoints, vtriangles);
+        prssmodel->endModel();
+        prssmodel->computeLocalAABB();
+        return prssmodel;
+    }
+
+    /// \brief returns the geometry that CheckContinuousCollision uses for pgeom.
+    ///
+    /// Meshes whose hierarchy does not support conservative advancement (the default OBB one for example) are copied into a RSS hierarchy,
+    /// which is cached as long as the mesh lives. Throws for the geometries that cannot be swept, instead of sampling the motion and missing thin obstacles.
+    const fcl::CollisionGeometry* _GetContinuousGeometry(const CollisionGeometryPtr& pgeom)
+    {
+        if( _HasConservativeAdvancement(*pgeom) ) {
+            return pgeom.get();
+        }
+        std::map<const fcl::CollisionGeometry*, std::pair<std::weak_ptr<fcl::CollisionGeometry>, CollisionGeometryPtr> >::iterator it = _mapContinuousGeometries.find(pgeom.get());
+        if( it != _mapContinuousGeometries.end() && it->second.first.lock() == pgeom ) {
+            return it->second.second.get();
+        }
+        CollisionGeometryPtr prssgeom;
+        if( pgeom->getObjectType() == fcl::OT_BVH ) {
+            switch(pgeom->getNodeType()) {
+            case fcl::BV_AABB: prssgeom = _ConvertMeshToRSS<fcl::AABB>(*pgeom); break;
+            case fcl::BV_OBB: prssgeom = _ConvertMeshToRSS<fcl::OBB>(*pgeom); break;
+            case fcl::BV_kIOS: prssgeom = _ConvertMeshToRSS<fcl::kIOS>(*pgeom); break;
+            case fcl::BV_KDOP16: prssgeom = _ConvertMeshToRSS< fcl::KDOP<16> >(*pgeom); break;
+            case fcl::BV_KDOP18: prssgeom = _ConvertMeshToRSS< fcl::KDOP<18> >(*pgeom); break;
+            case fcl::BV_KDOP24: prssgeom = _ConvertMeshToRSS< fcl::KDOP<24> >(*pgeom); break;
+            default: break;
+            }
+        }
+        if( !prssgeom ) {
+            throw OPENRAVE_EXCEPTION_FORMAT("env=%d, CheckContinuousCollision does not support fcl geometries of object type %d and node type %d", GetEnv()->GetId()%pgeom->getObjectType()%pgeom->getNodeType(), OpenRAVE::ORE_NotImplemented);
+        }
+        // drop the copies of the meshes that were destroyed
+        for(it = _mapContinuousGeometries.begin(); it != _mapContinuousGeometries.end(); ) {
+            if( it->second.first.expired() ) {
+                _mapContinuousGeometries.erase(it++);
+            }
+            else {
+                ++it;
+            }
+        }
+        _mapContinuousGeometries[pgeom.get()] = std::make_pair(std::weak_ptr<fcl::CollisionGeometry>(pgeom), prssgeom);
+        return prssgeom.get();
+    }
+
+    /// \brief fills the contacts of report with the geometries at the time of contact of CheckContinuousCollision.
+    ///
+    /// Conservative advancement stops when the geometries are within its tolerance, so they usually touch without overlapping. In that case the
+    /// contact is placed between the closest points and depth is minus their distance.
+    void _FillContinuousContacts(const fcl::CollisionGeometry& geom1, const fcl::Transform3f& tf1, const fcl::CollisionGeometry& geom2, const fcl::Transform3f& tf2, CollisionReport& report)
+    {
+        fcl::CollisionRequest request(_numMaxContacts, true);
+        request.gjk_solver_type = fcl::GST_LIBCCD;
+        fcl::CollisionResult result;
+        size_t numContacts = fcl::collide(&geom1, tf1, &geom2, tf2, request, result);
+        report.contacts.resize(0);
+        if( numContacts > 0 ) {
+            report.contacts.resize(numContacts);
+            for(size_t i = 0; i < numContacts; ++i) {
+                const fcl::Contact& c = result.getContact(i);
+                report.contacts[i] = CollisionReport::CONTACT(ConvertVectorFromFCL(c.pos), ConvertVectorFromFCL(c.normal), c.penetration_depth);
+            }
+            return;
+        }
+        fcl::DistanceRequest distancerequest(true);
+        distancerequest.gjk_solver_type = fcl::GST_LIBCCD;
+        fcl::DistanceResult distanceresult;
+        fcl::distance(&geom1, tf1, &geom2, tf2, distancerequest, distanceresult);
+        Vector p1 = ConvertVectorFromFCL(distanceresult.nearest_points[0]), p2 = ConvertVectorFromFCL(distanceresult.nearest_points[1]);
+        Vector vnormal = p2 - p1;
+        dReal flength = RaveSqrt(vnormal.lengthsqr3());
+        if( flength > g_fEpsilon ) {
+            vnormal *= 1/flength;
+        }
+        report.contacts.push_back(CollisionReport::CONTACT(0.5*(p1+p2), vnormal, -distanceresult.min_distance));
+    }
+
+    /// \brief checks the link pairs of _vCachedLinkInfoPairs, returns true if any of them collide.
+    ///
+    /// The pairs are first culled by testing the bounding OBBs of their links, then the geometry pairs with overlapping AABBs go through the narrow phase.
+    /// When only the first collision is needed and no collision callbacks are registered, the narrow phase is shared with _pNarrowPhasePool and the
+    /// threads skip the pairs after the lowest colliding pair found so far. That pair is then tested again on the calling thread with the same request
+    /// to fill the report, so the report is the one of the serial check.
+    bool _CheckLinkInfoPairs(CollisionCallbackData& query)
+    {
+        size_t numpairs = _vCachedLinkInfoPairs.size();
+        if( numpairs == 0 ) {
+            return false;
+        }
+        _vOBBData.resize(30*numpairs);
+        _vOBBOverlaps.resize(numpairs);
+        for(size_t ipair = 0; ipair < numpairs; ++ipair) {
+            _FillOBBData(*_vCachedLinkInfoPairs[ipair].first->linkBV.second, ipair, numpairs, &_vOBBData[0]);
+            _FillOBBData(*_vCachedLinkInfoPairs[ipair].second->linkBV.second, ipair, numpairs, &_vOBBData[15*numpairs]);
+        }
+        _TestOBBOverlaps(&_vOBBData[0], numpairs, &_vOBBOverlaps[0]);
+
+        _vCachedGeomPairs.resize(0);
+        for(size_t ipair = 0; ipair < numpairs; ++ipair) {
+            if( !_vOBBOverlaps[ipair] ) {
+                continue;
+            }
+            FOREACH(itgeom1, _vCachedLinkInfoPairs[ipair].first->vgeoms) {
+                FOREACH(itgeom2, _vCachedLinkInfoPairs[ipair].second->vgeoms) {
+                    if( (*itgeom1).second->getAABB().overlap((*itgeom2).second->getAABB()) ) {
+                        _vCachedGeomPairs.push_back(std::make_pair((*itgeom1).second.get(), (*itgeom2).second.get()));
+                    }
+                }
+            }
+        }
+
+        bool bParallel = !!_pNarrowPhasePool && _vCachedGeomPairs.size() > 1 && !query._bHasCallbacks && !(_options & (OpenRAVE::CO_AllLinkCollisions|OpenRAVE::CO_AllGeometryContacts));
+#ifdef NARROW_COLLISION_CACHING
+        bParallel = false; // the gjk guesses are cached in a map shared by all the queries
+#endif
+        if( !bParallel ) {
+            FOREACH(itgeompair, _vCachedGeomPairs) {
+                CheckNarrowPhaseGeomCollision(itgeompair->first, itgeompair->second, &query);
+                if( query._bStopChecking ) {
+                    break;
+                }
+            }
+            return query._bCollision;
+        }
+
+        std::atomic<size_t> nFirstHit(_vCachedGeomPairs.size());
+        _pNarrowPhasePool->ParallelFor(_vCachedGeomPairs.size(), boost::bind(&FCLCollisionChecker::_CheckGeomPairParallel, this, _1, boost::cref(query._request), boost::ref(nFirstHit)));
+        size_t ihit = nFirstHit.load();
+        if( ihit < _vCachedGeomPairs.size() ) {
+            CheckNarrowPhaseGeomCollision(_vCachedGeomPairs[ihit].first, _vCachedGeomPairs[ihit].second, &query);
+        }
+        return query._bCollision;
+    }
+
+    /// \brief narrow phase of one geometry pair of _vCachedGeomPairs called from the threads of _pNarrowPhasePool. Only uses local data.
+    ///
+    /// \param nFirstHit lowered to index if the pair collides, so it ends as the lowest colliding index
+    void _CheckGeomPairParallel(size_t index, const fcl::CollisionRequest& request, std::atomic<size_t>& nFirstHit)
+    {
+        if( nFirstHit.load() < index ) {
+            return; // a pair checked before this one already collides
+        }
+        fcl::CollisionResult result;
+        if( fcl::collide(_vCachedGeomPairs[index].first, _vCachedGeomPairs[index].second, request, result) > 0 ) {
+            size_t nexpected = nFirstHit.load();
+            while( index < nexpected && !nFirstHit.compare_exchange_weak(nexpected, index) ) {
+            }
+        }
+    }
+
+    /// \brief sets _vRayCastLinks to the links the rays are checked against, the whole scene if pbody is empty.
+    void _SetupRayCastLinks(KinBodyConstPtr pbody)
+    {
+        _vRayCastLinks.resize(0);
+        _vRayCastGeoms.resize(0);
+        if( !pbody ) {
+            _fclspace->Synchronize();
+            std::set<KinBodyConstPtr> attachedBodies;
+            _AddRayCastLinks(_GetEnvManager(attachedBodies));
+        }
+        else if( pbody->GetLinks().size() > 0 && _IsEnabled(*pbody) ) {
+            _fclspace->SynchronizeWithAttached(*pbody);
+            _AddRayCastLinks(_GetBodyManager(pbody, !!(_options & OpenRAVE::CO_ActiveDOFs)));
+        }
+    }
+
+    /// \brief adds the enabled links registered in a synchronized manager to _vRayCastLinks
+    void _AddRayCastLinks(const FCLCollisionManagerInstance& manager)
+    {
+        _vRayCastObjects.resize(0);
+        manager.GetManager()->getObjects(_vRayCastObjects);
+        FOREACH(itobj, _vRayCastObjects) {
+            FCLSpace::KinBodyInfo::LinkInfo* plinkinfo = static_cast<FCLSpace::KinBodyInfo::LinkInfo *>((*itobj)->getUserData());
+            if( !plinkinfo ) {
+                continue;
+            }
+            LinkConstPtr plink = plinkinfo->GetLink();
+            if( !!plink && plink->IsEnabled() ) {
+                _AddRayCastLink(*plinkinfo, plink);
+            }
+        }
+    }
+
+    /// \brief copies the world AABBs of a link and its geometries to _vRayCastLinks and _vRayCastGeoms. The ray meshes are looked up here so that the rays do not lock the cache.
+    void _AddRayCastLink(const FCLSpace::KinBodyInfo::LinkInfo& linkinfo, LinkConstPtr plink)
+    {
+        _vRayCastLinks.push_back(RayCastLink());
+        RayCastLink& raylink = _vRayCastLinks.back();
+        raylink.plink = plink;
+        _CopyAABB(linkinfo.linkBV.second->getAABB(), raylink.vmin, raylink.vmax);
+        raylink.geomstart = _vRayCastGeoms.size();
+        FOREACHC(itgeom, linkinfo.vgeoms) {
+            _vRayCastGeoms.push_back(RayCastGeom());
+            RayCastGeom& raygeom = _vRayCastGeoms.back();
+            raygeom.pobj = itgeom->second.get();
+            _CopyAABB(raygeom.pobj->getAABB(), raygeom.vmin, raygeom.vmax);
+            if( raygeom.pobj->collisionGeometry()->getObjectType() == fcl::OT_BVH ) {
+                raygeom.praymesh = FCLRayMeshCache::GetInstance().GetRayMesh(raygeom.pobj->collisionGeometry());
+            }
+        }
+        raylink.geomend = _vRayCastGeoms.size();
+    }
+
+    static void _CopyAABB(const fcl::AABB& ab, dReal* pmin, dReal* pmax)
+    {
+        for(int i = 0; i < 3; ++i) {
+            pmin[i] = ab.min_[i];
+            pmax[i] = ab.max_[i];
+        }
+    }
+
+    /// \brief casts a ray on the links of _vRayCastLinks. Only reads the members, so it can run on many threads.
+    ///
+    /// The links and then the geometries are culled by their AABBs, the closest hit so far shortens the ray for the remaining tests.
+    /// With CO_RayAnyHit, the first hit found is returned instead of the closest one.
+    /// \param[out] distance distance along the ray to the hit
+    /// \param[out] normal normal of the surface at the hit
+    /// \param[out] plinkhit the link that was hit
+    bool _RayCast(const RAY& ray, dReal& distance, Vector& normal, LinkConstPtr& plinkhit) const
+    {
+        dReal fmaxdist = RaveSqrt(ray.dir.lengthsqr3());
+        if( fmaxdist <= g_fEpsilon ) {
+            return false;
+        }
+        Vector dir = ray.dir*(1/fmaxdist);
+        const dReal porigin[3] = { ray.pos.x, ray.pos.y, ray.pos.z };
+        dReal pinvdir[3];
+        for(int i = 0; i < 3; ++i) {
+            pinvdir[i] = dir[i] != 0 ? 1/dir[i] : std::numeric_limits<dReal>::infinity();
+        }
+        bool bAnyHit = !!(_options & OpenRAVE::CO_RayAnyHit);
+        bool bHit = false;
+        distance = fmaxdist;
+        dReal tnear, geomdistance;
+        Vector geomnormal;
+        FOREACHC(itlink, _vRayCastLinks) {
+            if( !IntersectRayAABB(porigin, pinvdir, itlink->vmin, itlink->vmax, distance, tnear) ) {
+                continue;
+            }
+            for(size_t igeom = itlink->geomstart; igeom < itlink->geomend; ++igeom) {
+                const RayCastGeom& raygeom = _vRayCastGeoms[igeom];
+                if( !IntersectRayAABB(porigin, pinvdir, raygeom.vmin, raygeom.vmax, distance, tnear) ) {
+                    continue;
+                }
+                if( RayCastCollisionObject(*raygeom.pobj, raygeom.praymesh.get(), ray.pos, dir, distance, geomdistance, geomnormal) ) {
+                    distance = geomdistance;
+                    normal = geomnormal;
+                    plinkhit = itlink->plink;
+                    bHit = true;
+                    if( bAnyHit ) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return bHit;
+    }
+
+    /// \brief casts one ray on _vRayCastLinks, fills the report and calls the collision callbacks of the environment
+    bool _CheckRayCollision(const RAY& ray, CollisionReportPtr report)
+    {
+        dReal distance;
+        Vector normal;
+        LinkConstPtr plinkhit;
+        if( !_RayCast(ray, distance, normal, plinkhit) ) {
+            return false;
+        }
+
+        bool bHasCallbacks = GetEnv()->HasRegisteredCollisionCallbacks();
+        if( !report && !bHasCallbacks ) {
+            return true;
+        }
+        CollisionReport& hitreport = !!report ? *report : _reportcache;
+        hitreport.Reset(_options);
+        hitreport.plink1 = plinkhit;
+        hitreport.minDistance = distance;
+        hitreport.contacts.push_back(CollisionReport::CONTACT(ray.pos + ray.dir*(distance/RaveSqrt(ray.dir.lengthsqr3())), normal, distance));
+        if( bHasCallbacks ) {
+            std::list<EnvironmentBase::CollisionCallbackFn> listcallbacks;
+            GetEnv()->GetRegisteredCollisionCallbacks(listcallbacks);
+            CollisionReportPtr preport(&hitreport, OpenRAVE::utils::null_deleter());
+            FOREACHC(itfn, listcallbacks) {
+                if( (*itfn)(preport, false) != OpenRAVE::CA_DefaultAction ) {
+                    hitreport.Reset(_options);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /// \brief casts the rays of one block of CheckCollisionRays, called from the threads of _pNarrowPhasePool
+    void _CheckRayBlock(size_t iblock, const std::vector<RAY>& vrays, std::vector<dReal>& vdistances, std::vector<Vector>& vnormals, std::vector<int>& vbodyids) const
+    {
+        size_t iend = min(vrays.size(), (iblock+1)*s_nRayBlockSize);
+        LinkConstPtr plinkhit;
+        for(size_t iray = iblock*s_nRayBlockSize; iray < iend; ++iray) {
+            if( _RayCast(vrays[iray], vdistances[iray], vnormals[iray], plinkhit) ) {
+                vbodyids[iray] = plinkhit->GetParent()->GetEnvironmentId();
+            }
+            else {
+                vdistances[iray] = -1;
+                vnormals[iray] = Vector();
+                vbodyids[iray] = 0;
+            }
+        }
+    }
+
+    /// \brief writes the center, rotation and half extents of the OBB of a link at index of the 15 arrays of num elements starting at pdata
+    static void _FillOBBData(const fcl::CollisionObject& collobj, size_t index, size_t num, fcl::FCL_REAL* pdata)
+    {
+        const fcl::Box& box = static_cast<const fcl::Box&>(*collobj.collisionGeometry());
+        const fcl::Vec3f& trans = collobj.getTranslation();
+        const fcl::Matrix3f& rot = collobj.getRotation();
+        for(int i = 0; i < 3; ++i) {
+            pdata[i*num+index] = trans[i];
+            for(int j = 0; j < 3; ++j) {
+                pdata[(3+3*i+j)*num+index] = rot(i,j);
+            }
+            pdata[(12+i)*num+index] = 0.5*box.side[i];
+        }
+    }
+
+    /// \brief separating axis test of many pairs of OBBs, poverlaps[k] is set to 1 if the boxes of pair k overlap.
+    ///
+    /// pdata holds 30 arrays of num elements, the 15 arrays of the first boxes followed by the 15 arrays of the second boxes (see _FillOBBData).
+    /// The loop has no branches and only reads contiguous arrays so that the compiler can vectorize it across the pairs.
+    static void _TestOBBOverlaps(const fcl::FCL_REAL* pdata, size_t num, uint8_t* poverlaps)
+    {
+        const fcl::FCL_REAL* pcenter0 = pdata, *prot0 = pdata + 3*num, *pextents0 = pdata + 12*num;
+        const fcl::FCL_REAL* pcenter1 = pdata + 15*num, *prot1 = pdata + 18*num, *pextents1 = pdata + 27*num;
+        const fcl::FCL_REAL feps = 1e-6; // robustness for nearly parallel axes
+        for(size_t k = 0; k < num; ++k) {
+            // R is the rotation of box 1 in the frame of box 0, t is the center of box 1 in the frame of box 0
+            fcl::FCL_REAL R[3][3], absR[3][3], t[3], d[3];
+            for(int i = 0; i < 3; ++i) {
+                d[i] = pcenter1[i*num+k] - pcenter0[i*num+k];
+            }
+            for(int i = 0; i < 3; ++i) {
+                t[i] = prot0[(0+i)*num+k]*d[0] + prot0[(3+i)*num+k]*d[1] + prot0[(6+i)*num+k]*d[2];
+                for(int j = 0; j < 3; ++j) {
+                    R[i][j] = prot0[(0+i)*num+k]*prot1[(0+j)*num+k] + prot0[(3+i)*num+k]*prot1[(3+j)*num+k] + prot0[(6+i)*num+k]*prot1[(6+j)*num+k];
+                    absR[i][j] = std::abs(R[i][j]) + feps;
+                }
+            }
+            const fcl::FCL_REAL a0 = pextents0[k], a1 = pextents0[num+k], a2 = pextents0[2*num+k];
+            const fcl::FCL_REAL b0 = pextents1[k], b1 = pextents1[num+k], b2 = pextents1[2*num+k];
+            bool bSeparated = false;
+            // axes of box 0
+            bSeparated |= std::abs(t[0]) > a0 + b0*absR[0][0] + b1*absR[0][1] + b2*absR[0][2];
+            bSeparated |= std::abs(t[1]) > a1 + b0*absR[1][0] + b1*absR[1][1] + b2*absR[1][2];
+            bSeparated |= std::abs(t[2]) > a2 + b0*absR[2][0] + b1*absR[2][1] + b2*absR[2][2];
+            // axes of box 1
+            bSeparated |= std::abs(t[0]*R[0][0] + t[1]*R[1][0] + t[2]*R[2][0]) > a0*absR[0][0] + a1*absR[1][0] + a2*absR[2][0] + b0;
+            bSeparated |= std::abs(t[0]*R[0][1] + t[1]*R[1][1] + t[2]*R[2][1]) > a0*absR[0][1] + a1*absR[1][1] + a2*absR[2][1] + b1;
+            bSeparated |= std::abs(t[0]*R[0][2] + t[1]*R[1][2] + t[2]*R[2][2]) > a0*absR[0][2] + a1*absR[1][2] + a2*absR[2][2] + b2;
+            // cross products of the axes
+            bSeparated |= std::abs(t[2]*R[1][0] - t[1]*R[2][0]) > a1*absR[2][0] + a2*absR[1][0] + b1*absR[0][2] + b2*absR[0][1];
+            bSeparated |= std::abs(t[2]*R[1][1] - t[1]*R[2][1]) > a1*absR[2][1] + a2*absR[1][1] + b0*absR[0][2] + b2*absR[0][0];
+            bSeparated |= std::abs(t[2]*R[1][2] - t[1]*R[2][2]) > a1*absR[2][2] + a2*absR[1][2] + b0*absR[0][1] + b1*absR[0][0];
+            bSeparated |= std::abs(t[0]*R[2][0] - t[2]*R[0][0]) > a0*absR[2][0] + a2*absR[0][0] + b1*absR[1][2] + b2*absR[1][1];
+            bSeparated |= std::abs(t[0]*R[2][1] - t[2]*R[0][1]) > a0*absR[2][1] + a2*absR[0][1] + b0*absR[1][2] + b2*absR[1][0];
+            bSeparated |= std::abs(t[0]*R[2][2] - t[2]*R[0][2]) > a0*absR[2][2] + a2*absR[0][2] + b0*absR[1][1] + b1*absR[1][0];
+            bSeparated |= std::abs(t[1]*R[0][0] - t[0]*R[1][0]) > a0*absR[1][0] + a1*absR[0][0] + b1*absR[2][2] + b2*absR[2][1];
+            bSeparated |= std::abs(t[1]*R[0][1] - t[0]*R[1][1]) > a0*absR[1][1] + a1*absR[0][1] + b0*absR[2][2] + b2*absR[2][0];
+            bSeparated |= std::abs(t[1]*R[0][2] - t[0]*R[1][2]) > a0*absR[1][2] + a1*absR[0][2] + b0*absR[2][1] + b1*absR[2][0];
+            poverlaps[k] = !bSeparated;
+        }
+    }
+
     static bool CheckNarrowPhaseCollision(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data) {
         CollisionCallbackData* pcb = static_cast<CollisionCallbackData *>(data);
         return pcb->_pchecker->CheckNarrowPhaseCollision(o1, o2, pcb);
@@ -1396,6 +2172,44 @@ private:
     std::vector<fcl::Vec3f> _fclPointsCache;
     std::vector<fcl::Triangle> _fclTrianglesCache;
     std::vector<KinBodyPtr> _vCachedGrabbedBodies;
+    std::vector<const KinBody*> _vCachedPairBodies;
+    std::vector< std::pair<FCLSpace::KinBodyInfo::LinkInfo*, FCLSpace::KinBodyInfo::LinkInfo*> > _vCachedLinkInfoPairs; ///< link pairs checked by _CheckLinkInfoPairs
+    std::vector<fcl::FCL_REAL> _vOBBData; ///< link OBBs of _vCachedLinkInfoPairs laid out for _TestOBBOverlaps
+    std::vector<uint8_t> _vOBBOverlaps;
+    std::vector< std::pair<fcl::CollisionObject*, fcl::CollisionObject*> > _vCachedGeomPairs; ///< geometry pairs that go through the narrow phase
+
+    std::vector<dReal> _vContinuousConfigs; ///< configurations at the steps of CheckContinuousCollision
+    std::vector<Transform> _vContinuousLinkTransforms; ///< link transformations at the steps of CheckContinuousCollision
+    std::vector<ContinuousMovingGeom> _vContinuousMovingGeoms;
+    std::vector<ContinuousStaticGeom> _vContinuousStaticGeoms;
+    std::map<const fcl::CollisionGeometry*, std::pair<std::weak_ptr<fcl::CollisionGeometry>, CollisionGeometryPtr> > _mapContinuousGeometries; ///< RSS copies of the meshes for CheckContinuousCollision, see _GetContinuousGeometry
+    dReal _fContinuousStepLength; ///< maximum change of any DOF value in one step of CheckContinuousCollision
+    std::vector<uint8_t> _vContinuousActiveLinks; ///< with CO_ActiveDOFs, 1 for the links of the body moved by the active DOFs, otherwise empty
+    std::list<EnvironmentBase::CollisionCallbackFn> _listContinuousCallbacks; ///< callbacks of the environment during CheckContinuousCollision
+
+    /// \brief link tested by _RayCast
+    struct RayCastLink
+    {
+        dReal vmin[3], vmax[3]; ///< world AABB of the bounding volume of the link
+        LinkConstPtr plink;
+        size_t geomstart, geomend; ///< range of the geometries of the link in _vRayCastGeoms
+    };
+
+    /// \brief geometry tested by _RayCast
+    struct RayCastGeom
+    {
+        dReal vmin[3], vmax[3]; ///< world AABB of the geometry
+        const fcl::CollisionObject* pobj;
+        FCLRayMeshPtr praymesh; ///< set if the geometry is a BVH model
+    };
+
+    static const size_t s_nRayBlockSize = 64; ///< number of rays of CheckCollisionRays handed out to a thread at once
+
+    std::vector<RayCastLink> _vRayCastLinks; ///< links the rays are checked against
+    std::vector<RayCastGeom> _vRayCastGeoms;
+    std::vector<fcl::CollisionObject*> _vRayCastObjects;
+
+    FCLThreadPoolPtr _pNarrowPhasePool; ///< if set, runs the narrow phase of _CheckLinkInfoPairs and the rays of CheckCollisionRays. Set by the SetNarrowPhaseThreads command
 
     bool _bIsSelfCollisionChecker; // Currently not used
     bool _bParentlessCollisionObject; ///< if set to true, the last collision command ran into colliding with an unknown object
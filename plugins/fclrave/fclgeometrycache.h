@@ -0,0 +1,187 @@
+// -*- coding: utf-8 -*-
+#ifndef OPENRAVE_FCL_GEOMETRYCACHE
+#define OPENRAVE_FCL_GEOMETRYCACHE
+
+#include "plugindefs.h"
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace fclrave {
+
+typedef std::shared_ptr<fcl::CollisionGeometry> CollisionGeometryPtr;
+
+/// \brief process-wide cache of the BVH models built from trimeshes, shared by all the FCLCollisionChecker instances of all environments.
+///
+/// The models are keyed by the BVH type and the content of the mesh. The cache only keeps weak references, so a model is freed
+/// as soon as no collision object uses it anymore. The models are never modified after they are built, so they can be shared
+/// between checkers and threads.
+class FCLGeometryCache
+{
+public:
+    /// \brief counters reported by the GetMeshCacheStatistics command
+    struct Statistics
+    {
+        Statistics() : numhits(0), nummisses(0), numentries(0), residentbytes(0) {
+        }
+        uint64_t numhits; ///< number of meshes that were found in the cache
+        uint64_t nummisses; ///< number of meshes whose model had to be built
+        uint64_t numentries; ///< number of models currently alive
+        uint64_t residentbytes; ///< approximate memory used by the models currently alive
+    };
+
+    typedef CollisionGeometryPtr (*MeshBuilderFn)(std::vector<fcl::Vec3f> const &points, std::vector<fcl::Triangle> const &triangles);
+    typedef bool (*MeshCompareFn)(const fcl::CollisionGeometry& geom, std::vector<fcl::Vec3f> const &points, std::vector<fcl::Triangle> const &triangles);
+
+    static FCLGeometryCache& GetInstance()
+    {
+        static FCLGeometryCache s_cache;
+        return s_cache;
+    }
+
+    /// \brief returns the model of the mesh, building it with builder if it is not cached
+    ///
+    /// \param bvhtype unique name of the BVH type built by builder
+    /// \param comparer checks that a cached model holds exactly points and triangles, protects against hash collisions
+    /// \param bvnodesize size of one node of the BVH, used to estimate the memory of the model
+    CollisionGeometryPtr GetMesh(const std::string& bvhtype, std::vector<fcl::Vec3f> const &points, std::vector<fcl::Triangle> const &triangles, MeshBuilderFn builder, MeshCompareFn comparer, size_t bvnodesize)
+    {
+        size_t hash = _ComputeHash(bvhtype, points, triangles);
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            CollisionGeometryPtr pgeom = _Find(hash, bvhtype, points, triangles, comparer);
+            if( !!pgeom ) {
+                _statistics.numhits++;
+                return pgeom;
+            }
+        }
+
+        // build outside of the lock since it is the expensive part
+        CollisionGeometryPtr pnewgeom = builder(points, triangles);
+        if( !pnewgeom ) {
+            return pnewgeom;
+        }
+
+        boost::mutex::scoped_lock lock(_mutex);
+        // another thread could have built the same model in the meantime
+        CollisionGeometryPtr pgeom = _Find(hash, bvhtype, points, triangles, comparer);
+        if( !!pgeom ) {
+            _statistics.numhits++;
+            return pgeom;
+        }
+        _statistics.nummisses++;
+        if( ++_nInsertionsSincePurge > 256 ) {
+            _PurgeExpired();
+        }
+        Entry entry;
+        entry.bvhtype = bvhtype;
+        entry.pgeom = pnewgeom;
+        entry.bytes = points.size()*sizeof(fcl::Vec3f) + triangles.size()*(sizeof(fcl::Triangle)+sizeof(unsigned int)) + (2*triangles.size())*bvnodesize;
+        _mapGeometries.insert(std::make_pair(hash, entry));
+        return pnewgeom;
+    }
+
+    void GetStatistics(Statistics& stats)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _PurgeExpired();
+        stats = _statistics;
+        stats.numentries = _mapGeometries.size();
+        stats.residentbytes = 0;
+        FOREACHC(itentry, _mapGeometries) {
+            stats.residentbytes += itentry->second.bytes;
+        }
+    }
+
+private:
+    struct Entry
+    {
+        std::string bvhtype;
+        std::weak_ptr<fcl::CollisionGeometry> pgeom;
+        size_t bytes;
+    };
+    typedef boost::unordered_multimap<size_t, Entry> GeometryMap;
+
+    FCLGeometryCache() : _nInsertionsSincePurge(0) {
+    }
+
+    static size_t _ComputeHash(const std::string& bvhtype, std::vector<fcl::Vec3f> const &points, std::vector<fcl::Triangle> const &triangles)
+    {
+        size_t hash = boost::hash_value(bvhtype);
+        boost::hash_combine(hash, points.size());
+        boost::hash_combine(hash, triangles.size());
+        FOREACHC(itpoint, points) {
+            boost::hash_combine(hash, (*itpoint)[0]);
+            boost::hash_combine(hash, (*itpoint)[1]);
+            boost::hash_combine(hash, (*itpoint)[2]);
+        }
+        FOREACHC(ittri, triangles) {
+            boost::hash_combine(hash, (*ittri)[0]);
+            boost::hash_combine(hash, (*ittri)[1]);
+            boost::hash_combine(hash, (*ittri)[2]);
+        }
+        return hash;
+    }
+
+    /// \brief assumes _mutex is locked
+    CollisionGeometryPtr _Find(size_t hash, const std::string& bvhtype, std::vector<fcl::Vec3f> const &points, std::vector<fcl::Triangle> const &triangles, MeshCompareFn comparer)
+    {
+        std::pair<GeometryMap::iterator, GeometryMap::iterator> range = _mapGeometries.equal_range(hash);
+        for(GeometryMap::iterator it = range.first; it != range.second; ) {
+            CollisionGeometryPtr pgeom = it->second.pgeom.lock();
+            if( !pgeom ) {
+                it = _mapGeometries.erase(it);
+                continue;
+            }
+            if( it->second.bvhtype == bvhtype && comparer(*pgeom, points, triangles) ) {
+                return pgeom;
+            }
+            ++it;
+        }
+        return CollisionGeometryPtr();
+    }
+
+    /// \brief removes the models that are not used anymore, assumes _mutex is locked
+    void _PurgeExpired()
+    {
+        for(GeometryMap::iterator it = _mapGeometries.begin(); it != _mapGeometries.end(); ) {
+            if( it->second.pgeom.expired() ) {
+                it = _mapGeometries.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        _nInsertionsSincePurge = 0;
+    }
+
+    boost::mutex _mutex; ///< protects all the members
+    GeometryMap _mapGeometries; ///< content hash -> models with that hash
+    Statistics _statistics;
+    int _nInsertionsSincePurge;
+};
+
+/// \brief checks if the BVH model built by ConvertMeshToFCL<T> holds exactly points and triangles
+template <class T>
+bool IsSameMeshFCL(const fcl::CollisionGeometry& geom, std::vector<fcl::Vec3f> const &points, std::vector<fcl::Triangle> const &triangles)
+{
+    const fcl::BVHModel<T>& model = static_cast<const fcl::BVHModel<T>&>(geom);
+    if( model.num_vertices != (int)points.size() || model.num_tris != (int)triangles.size() ) {
+        return false;
+    }
+    for(size_t ipoint = 0; ipoint < points.size(); ++ipoint) {
+        if( model.vertices[ipoint][0] != points[ipoint][0] || model.vertices[ipoint][1] != points[ipoint][1] || model.vertices[ipoint][2] != points[ipoint][2] ) {
+            return false;
+        }
+    }
+    for(size_t itri = 0; itri < triangles.size(); ++itri) {
+        if( model.tri_indices[itri][0] != triangles[itri][0] || model.tri_indices[itri][1] != triangles[itri][1] || model.tri_indices[itri][2] != triangles[itri][2] ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+#endif
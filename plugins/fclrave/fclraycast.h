@@ -0,0 +1,455 @@
+// -*- coding: utf-8 -*-
+#ifndef OPENRAVE_FCL_RAYCAST
+#define OPENRAVE_FCL_RAYCAST
+
+#include "fclspace.h"
+#include <atomic>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace fclrave {
+
+using OpenRAVE::dReal;
+using OpenRAVE::RaveSqrt;
+
+/// \brief intersects a ray with an axis aligned box
+///
+/// \param porigin origin of the ray
+/// \param pinvdir inverse of the direction of the ray, components can be infinite
+/// \param[out] tnear distance along the ray where it enters the box, can be negative if the origin is inside
+/// \return true if the box intersects the ray in [0,fmaxdist]
+inline bool IntersectRayAABB(const dReal* porigin, const dReal* pinvdir, const dReal* pmin, const dReal* pmax, dReal fmaxdist, dReal& tnear)
+{
+    dReal tmin = 0, tmax = fmaxdist;
+    for(int i = 0; i < 3; ++i) {
+        dReal t1 = (pmin[i]-porigin[i])*pinvdir[i];
+        dReal t2 = (pmax[i]-porigin[i])*pinvdir[i];
+        // written so that NaNs of 0*inf do not cull the box
+        tmin = max(tmin, min(t1, t2));
+        tmax = min(tmax, max(t1, t2));
+    }
+    tnear = tmin;
+    return tmin <= tmax;
+}
+
+/// \brief first crossing of a ray with the surface of a box centered at the origin, the normal points out of the box
+inline bool IntersectRayBox(const Vector& origin, const Vector& dir, const Vector& halfextents, dReal fmaxdist, dReal& distance, Vector& normal)
+{
+    dReal tnear = -std::numeric_limits<dReal>::max(), tfar = std::numeric_limits<dReal>::max();
+    int nearaxis = -1, faraxis = -1;
+    dReal nearsign = 0, farsign = 0;
+    for(int i = 0; i < 3; ++i) {
+        if( RaveFabs(dir[i]) <= g_fEpsilon ) {
+            if( origin[i] < -halfextents[i] || origin[i] > halfextents[i] ) {
+                return false;
+            }
+            continue;
+        }
+        dReal finv = 1/dir[i];
+        dReal tenter = (-halfextents[i]-origin[i])*finv, texit = (halfextents[i]-origin[i])*finv;
+        dReal entersign = -1;
+        if( tenter > texit ) {
+            std::swap(tenter, texit);
+            entersign = 1;
+        }
+        if( tenter > tnear ) {
+            tnear = tenter;
+            nearaxis = i;
+            nearsign = entersign;
+        }
+        if( texit < tfar ) {
+            tfar = texit;
+            faraxis = i;
+            farsign = -entersign;
+        }
+    }
+    if( tnear > tfar || faraxis < 0 ) {
+        return false;
+    }
+    normal = Vector(0,0,0);
+    if( tnear >= 0 && nearaxis >= 0 ) {
+        distance = tnear;
+        normal[nearaxis] = nearsign;
+    }
+    else if( tfar >= 0 ) {
+        // origin is inside
+        distance = tfar;
+        normal[faraxis] = farsign;
+    }
+    else {
+        return false;
+    }
+    return distance <= fmaxdist;
+}
+
+/// \brief first crossing of a ray with the surface of a sphere centered at the origin
+inline bool IntersectRaySphere(const Vector& origin, const Vector& dir, dReal fradius, dReal fmaxdist, dReal& distance, Vector& normal)
+{
+    dReal b = origin.dot3(dir);
+    dReal c = origin.lengthsqr3() - fradius*fradius;
+    dReal disc = b*b - c;
+    if( disc < 0 ) {
+        return false;
+    }
+    dReal s = RaveSqrt(disc);
+    distance = -b - s >= 0 ? -b - s : -b + s;
+    if( distance < 0 || distance > fmaxdist ) {
+        return false;
+    }
+    normal = (origin + dir*distance)*(1/fradius);
+    return true;
+}
+
+/// \brief first crossing of a ray with the surface of a cylinder centered at the origin with its axis along z
+inline bool IntersectRayCylinder(const Vector& origin, const Vector& dir, dReal fradius, dReal fhalfheight, dReal fmaxdist, dReal& distance, Vector& normal)
+{
+    bool bhit = false;
+    distance = fmaxdist;
+    dReal a = dir.x*dir.x + dir.y*dir.y;
+    if( a > g_fEpsilon ) {
+        dReal b = origin.x*dir.x + origin.y*dir.y;
+        dReal c = origin.x*origin.x + origin.y*origin.y - fradius*fradius;
+        dReal disc = b*b - a*c;
+        if( disc >= 0 ) {
+            dReal s = RaveSqrt(disc);
+            dReal troots[2] = { (-b-s)/a, (-b+s)/a };
+            for(int iroot = 0; iroot < 2; ++iroot) {
+                dReal t = troots[iroot];
+                if( t >= 0 && t <= distance && RaveFabs(origin.z + t*dir.z) <= fhalfheight ) {
+                    distance = t;
+                    normal = Vector((origin.x + t*dir.x)/fradius, (origin.y + t*dir.y)/fradius, 0);
+                    bhit = true;
+                    break;
+                }
+            }
+        }
+    }
+    if( RaveFabs(dir.z) > g_fEpsilon ) {
+        for(int icap = 0; icap < 2; ++icap) {
+            dReal z = icap == 0 ? -fhalfheight : fhalfheight;
+            dReal t = (z - origin.z)/dir.z;
+            if( t >= 0 && t <= distance ) {
+                dReal x = origin.x + t*dir.x, y = origin.y + t*dir.y;
+                if( x*x + y*y <= fradius*fradius ) {
+                    distance = t;
+                    normal = Vector(0, 0, icap == 0 ? -1 : 1);
+                    bhit = true;
+                }
+            }
+        }
+    }
+    return bhit;
+}
+
+/// \brief triangles of a mesh sorted in a bounding box tree for casting rays, built from the vertices and triangles of a BVH model
+///
+/// Holds copies of the vertices, so it stays valid even if the model is freed. Immutable once built.
+class FCLRayMesh
+{
+public:
+    FCLRayMesh(const fcl::Vec3f* pvertices, const fcl::Triangle* ptriangles, int numtriangles) : _nMaxDepth(0)
+    {
+        _vtriangles.resize(3*numtriangles);
+        std::vector<int> vindices(numtriangles);
+        for(int itri = 0; itri < numtriangles; ++itri) {
+            for(int j = 0; j < 3; ++j) {
+                const fcl::Vec3f& v = pvertices[ptriangles[itri][j]];
+                _vtriangles[3*itri+j] = Vector(v[0], v[1], v[2]);
+            }
+            vindices[itri] = itri;
+        }
+        if( numtriangles > 0 ) {
+            _vnodes.reserve(2*numtriangles/_nMaxLeafTriangles+1);
+            _Build(vindices, 0, numtriangles, 0);
+        }
+        // store the triangles in the order of the leaves
+        std::vector<Vector> vsorted(_vtriangles.size());
+        for(size_t i = 0; i < vindices.size(); ++i) {
+            std::copy(_vtriangles.begin()+3*vindices[i], _vtriangles.begin()+3*vindices[i]+3, vsorted.begin()+3*i);
+        }
+        _vtriangles.swap(vsorted);
+    }
+
+    /// \brief first triangle hit by a ray in the frame of the mesh, the normal follows the winding of the triangle
+    bool Intersect(const Vector& origin, const Vector& dir, dReal fmaxdist, dReal& distance, Vector& normal) const
+    {
+        if( _vnodes.size() == 0 ) {
+            return false;
+        }
+        const dReal porigin[3] = { origin.x, origin.y, origin.z };
+        dReal pinvdir[3];
+        for(int i = 0; i < 3; ++i) {
+            pinvdir[i] = dir[i] != 0 ? 1/dir[i] : std::numeric_limits<dReal>::infinity();
+        }
+        bool bhit = false;
+        distance = fmaxdist;
+        // every visited inner node replaces itself by its two children, so the stack never holds more than _nMaxDepth+1 nodes
+        int stackbuffer[64];
+        std::vector<int> vstack;
+        int* stack = stackbuffer;
+        if( _nMaxDepth+1 > 64 ) {
+            vstack.resize(_nMaxDepth+1);
+            stack = &vstack[0];
+        }
+        int nstack = 0;
+        stack[nstack++] = 0;
+        while( nstack > 0 ) {
+            const Node& node = _vnodes[stack[--nstack]];
+            dReal tnear;
+            if( !IntersectRayAABB(porigin, pinvdir, node.vmin, node.vmax, distance, tnear) ) {
+                continue;
+            }
+            if( node.numtriangles > 0 ) {
+                for(int itri = node.start; itri < node.start+node.numtriangles; ++itri) {
+                    if( _IntersectTriangle(origin, dir, itri, distance, normal) ) {
+                        bhit = true;
+                    }
+                }
+            }
+            else {
+                stack[nstack++] = node.start;
+                stack[nstack++] = (&node - &_vnodes[0]) + 1;
+            }
+        }
+        if( bhit ) {
+            normal.normalize3();
+        }
+        return bhit;
+    }
+
+    size_t GetNumTriangles() const {
+        return _vtriangles.size()/3;
+    }
+
+private:
+    /// \brief node of the tree, the left child is right after the node
+    struct Node
+    {
+        dReal vmin[3], vmax[3];
+        int start; ///< index of the first triangle for leaves, index of the right child otherwise
+        int numtriangles; ///< 0 if not a leaf
+    };
+
+    static const int _nMaxLeafTriangles = 4;
+
+    void _Build(std::vector<int>& vindices, int start, int end, int depth)
+    {
+        _nMaxDepth = max(_nMaxDepth, depth);
+        int inode = _vnodes.size();
+        _vnodes.push_back(Node());
+        Vector vmin(1e30,1e30,1e30), vmax(-1e30,-1e30,-1e30), vcmin = vmin, vcmax = vmax;
+        for(int i = start; i < end; ++i) {
+            Vector vcenter;
+            for(int j = 0; j < 3; ++j) {
+                const Vector& v = _vtriangles[3*vindices[i]+j];
+                for(int k = 0; k < 3; ++k) {
+                    vmin[k] = min(vmin[k], v[k]);
+                    vmax[k] = max(vmax[k], v[k]);
+                }
+                vcenter += v;
+            }
+            for(int k = 0; k < 3; ++k) {
+                vcmin[k] = min(vcmin[k], vcenter[k]);
+                vcmax[k] = max(vcmax[k], vcenter[k]);
+            }
+        }
+        for(int k = 0; k < 3; ++k) {
+            _vnodes[inode].vmin[k] = vmin[k];
+            _vnodes[inode].vmax[k] = vmax[k];
+        }
+        if( end-start <= _nMaxLeafTriangles ) {
+            _vnodes[inode].start = start;
+            _vnodes[inode].numtriangles = end-start;
+            return;
+        }
+
+        // split at the median of the triangle centers along the longest axis
+        int axis = 0;
+        for(int k = 1; k < 3; ++k) {
+            if( vcmax[k]-vcmin[k] > vcmax[axis]-vcmin[axis] ) {
+                axis = k;
+            }
+        }
+        int mid = (start+end)/2;
+        std::nth_element(vindices.begin()+start, vindices.begin()+mid, vindices.begin()+end, boost::bind(&FCLRayMesh::_CompareCenters, this, axis, _1, _2));
+        _vnodes[inode].numtriangles = 0;
+        _Build(vindices, start, mid, depth+1);
+        _vnodes[inode].start = _vnodes.size();
+        _Build(vindices, mid, end, depth+1);
+    }
+
+    bool _CompareCenters(int axis, int itri0, int itri1) const
+    {
+        return _vtriangles[3*itri0][axis] + _vtriangles[3*itri0+1][axis] + _vtriangles[3*itri0+2][axis] < _vtriangles[3*itri1][axis] + _vtriangles[3*itri1+1][axis] + _vtriangles[3*itri1+2][axis];
+    }
+
+    /// \brief Moller-Trumbore test, updates distance and normal if the triangle is hit closer than distance
+    inline bool _IntersectTriangle(const Vector& origin, const Vector& dir, int itri, dReal& distance, Vector& normal) const
+    {
+        const Vector& v0 = _vtriangles[3*itri];
+        Vector e1 = _vtriangles[3*itri+1] - v0, e2 = _vtriangles[3*itri+2] - v0;
+        Vector p = dir.cross(e2);
+        dReal det = e1.dot3(p);
+        if( RaveFabs(det) <= g_fEpsilon ) {
+            return false;
+        }
+        dReal invdet = 1/det;
+        Vector s = origin - v0;
+        dReal u = s.dot3(p)*invdet;
+        if( u < 0 || u > 1 ) {
+            return false;
+        }
+        Vector q = s.cross(e1);
+        dReal v = dir.dot3(q)*invdet;
+        if( v < 0 || u + v > 1 ) {
+            return false;
+        }
+        dReal t = e2.dot3(q)*invdet;
+        if( t < 0 || t > distance ) {
+            return false;
+        }
+        distance = t;
+        normal = e1.cross(e2);
+        return true;
+    }
+
+    std::vector<Node> _vnodes;
+    std::vector<Vector> _vtriangles; ///< 3 vertices per triangle
+    int _nMaxDepth; ///< number of inner nodes on the longest path from the root to a leaf
+};
+
+typedef boost::shared_ptr<FCLRayMesh> FCLRayMeshPtr;
+
+/// \brief process-wide cache of the ray meshes of the BVH models, the models are shared between checkers by FCLGeometryCache.
+///
+/// Only keeps weak references to the models, so an entry is rebuilt if its model is freed and another model reuses its address.
+class FCLRayMeshCache
+{
+public:
+    static FCLRayMeshCache& GetInstance()
+    {
+        static FCLRayMeshCache s_cache;
+        return s_cache;
+    }
+
+    /// \brief returns the ray mesh of a BVH model, building it if needed. Thread safe.
+    FCLRayMeshPtr GetRayMesh(const std::shared_ptr<const fcl::CollisionGeometry>& pgeom)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        RayMeshMap::iterator it = _mapRayMeshes.find(pgeom.get());
+        if( it != _mapRayMeshes.end() ) {
+            if( it->second.first.lock() == pgeom ) {
+                return it->second.second;
+            }
+            _mapRayMeshes.erase(it);
+        }
+        if( ++_nInsertionsSincePurge > 256 ) {
+            _PurgeExpired();
+        }
+        FCLRayMeshPtr praymesh = _CreateRayMesh(*pgeom);
+        _mapRayMeshes[pgeom.get()] = std::make_pair(std::weak_ptr<const fcl::CollisionGeometry>(pgeom), praymesh);
+        return praymesh;
+    }
+
+private:
+    typedef boost::unordered_map<const fcl::CollisionGeometry*, std::pair<std::weak_ptr<const fcl::CollisionGeometry>, FCLRayMeshPtr> > RayMeshMap;
+
+    FCLRayMeshCache() : _nInsertionsSincePurge(0) {
+    }
+
+    template <class T>
+    static FCLRayMeshPtr _CreateRayMeshFromModel(const fcl::CollisionGeometry& geom)
+    {
+        const fcl::BVHModel<T>& model = static_cast<const fcl::BVHModel<T>&>(geom);
+        return FCLRayMeshPtr(new FCLRayMesh(model.vertices, model.tri_indices, model.num_tris));
+    }
+
+    static FCLRayMeshPtr _CreateRayMesh(const fcl::CollisionGeometry& geom)
+    {
+        switch(geom.getNodeType()) {
+        case fcl::BV_AABB: return _CreateRayMeshFromModel<fcl::AABB>(geom);
+        case fcl::BV_OBB: return _CreateRayMeshFromModel<fcl::OBB>(geom);
+        case fcl::BV_RSS: return _CreateRayMeshFromModel<fcl::RSS>(geom);
+        case fcl::BV_OBBRSS: return _CreateRayMeshFromModel<fcl::OBBRSS>(geom);
+        case fcl::BV_kIOS: return _CreateRayMeshFromModel<fcl::kIOS>(geom);
+        case fcl::BV_KDOP16: return _CreateRayMeshFromModel< fcl::KDOP<16> >(geom);
+        case fcl::BV_KDOP18: return _CreateRayMeshFromModel< fcl::KDOP<18> >(geom);
+        case fcl::BV_KDOP24: return _CreateRayMeshFromModel< fcl::KDOP<24> >(geom);
+        default:
+            RAVELOG_WARN_FORMAT("fcl ray casting does not support BVH node type %d", (int)geom.getNodeType());
+            return FCLRayMeshPtr();
+        }
+    }
+
+    /// \brief assumes _mutex is locked
+    void _PurgeExpired()
+    {
+        for(RayMeshMap::iterator it = _mapRayMeshes.begin(); it != _mapRayMeshes.end(); ) {
+            if( it->second.first.expired() ) {
+                it = _mapRayMeshes.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        _nInsertionsSincePurge = 0;
+    }
+
+    boost::mutex _mutex; ///< protects all the members
+    RayMeshMap _mapRayMeshes;
+    int _nInsertionsSincePurge;
+};
+
+/// \brief casts a ray on a geometry collision object whose transform is up to date
+///
+/// \param praymesh the ray mesh of the geometry if it is a BVH model, see FCLRayMeshCache
+/// \param pos origin of the ray in the world frame
+/// \param dir unit direction of the ray in the world frame
+/// \param[out] distance distance of the first crossing of the surface along the ray
+/// \param[out] normal normal of the surface at the hit in the world frame, points out of the geometry
+inline bool RayCastCollisionObject(const fcl::CollisionObject& collobj, const FCLRayMesh* praymesh, const Vector& pos, const Vector& dir, dReal fmaxdist, dReal& distance, Vector& normal)
+{
+    Transform t(ConvertQuaternionFromFCL(collobj.getQuatRotation()), ConvertVectorFromFCL(collobj.getTranslation()));
+    Transform tinv = t.inverse();
+    Vector localpos = tinv*pos, localdir = tinv.rotate(dir), localnormal;
+    const fcl::CollisionGeometry& geom = *collobj.collisionGeometry();
+    bool bhit = false;
+    if( geom.getObjectType() == fcl::OT_BVH ) {
+        bhit = !!praymesh && praymesh->Intersect(localpos, localdir, fmaxdist, distance, localnormal);
+    }
+    else {
+        switch(geom.getNodeType()) {
+        case fcl::GEOM_BOX: {
+            const fcl::Box& box = static_cast<const fcl::Box&>(geom);
+            bhit = IntersectRayBox(localpos, localdir, Vector(0.5*box.side[0], 0.5*box.side[1], 0.5*box.side[2]), fmaxdist, distance, localnormal);
+            break;
+        }
+        case fcl::GEOM_SPHERE:
+            bhit = IntersectRaySphere(localpos, localdir, static_cast<const fcl::Sphere&>(geom).radius, fmaxdist, distance, localnormal);
+            break;
+        case fcl::GEOM_CYLINDER: {
+            const fcl::Cylinder& cylinder = static_cast<const fcl::Cylinder&>(geom);
+            bhit = IntersectRayCylinder(localpos, localdir, cylinder.radius, 0.5*cylinder.lz, fmaxdist, distance, localnormal);
+            break;
+        }
+        default: {
+            // fclspace only creates boxes, spheres, cylinders and meshes, so any other shape was added outside of openrave and is never hit.
+            // warn once per shape type since this runs for every ray
+            static std::atomic<uint32_t> s_nWarnedNodeTypes(0);
+            uint32_t nodetypebit = 1u << ((uint32_t)geom.getNodeType() & 31);
+            if( !(s_nWarnedNodeTypes.fetch_or(nodetypebit) & nodetypebit) ) {
+                RAVELOG_WARN_FORMAT("fcl ray casting does not support geometry node type %d, rays do not hit it", (int)geom.getNodeType());
+            }
+            break;
+        }
+        }
+    }
+    if( bhit ) {
+        normal = t.rotate(localnormal);
+    }
+    return bhit;
+}
+
+}
+
+#endif
@@ -5,6 +5,9 @@
 #include <boost/shared_ptr.hpp>
 #include <memory> // c++11
 #include <vector>
+#include <typeinfo>
+
+#include "fclgeometrycache.h"
 
 namespace fclrave {
 
@@ -57,6 +60,13 @@ CollisionGeometryPtr ConvertMeshToFCL(std::vector<fcl::Vec3f> const &points,std:
     return model;
 }
 
+/// \brief same as ConvertMeshToFCL, but shares the models of identical meshes across all the checkers of the process
+template <class T>
+CollisionGeometryPtr ConvertMeshToFCLCached(std::vector<fcl::Vec3f> const &points,std::vector<fcl::Triangle> const &triangles)
+{
+    return FCLGeometryCache::GetInstance().GetMesh(typeid(fcl::BVHModel<T>).name(), points, triangles, &ConvertMeshToFCL<T>, &IsSameMeshFCL<T>, sizeof(fcl::BVNode<T>));
+}
+
 /// \brief fcl spaces manages the individual collision objects and sets up callbacks to track their changes.
 ///
 /// It does not know or manage the broadphase manager
@@ -393,28 +403,28 @@ public:
 
         if (type == "AABB") {
             _bvhRepresentation = type;
-            _meshFactory = &ConvertMeshToFCL<fcl::AABB>;
+            _meshFactory = &ConvertMeshToFCLCached<fcl::AABB>;
         } else if (type == "OBB") {
             _bvhRepresentation = type;
-            _meshFactory = &ConvertMeshToFCL<fcl::OBB>;
+            _meshFactory = &ConvertMeshToFCLCached<fcl::OBB>;
         } else if (type == "RSS") {
             _bvhRepresentation = type;
-            _meshFactory = &ConvertMeshToFCL<fcl::RSS>;
+            _meshFactory = &ConvertMeshToFCLCached<fcl::RSS>;
         } else if (type == "OBBRSS") {
             _bvhRepresentation = type;
-            _meshFactory = &ConvertMeshToFCL<fcl::OBBRSS>;
+            _meshFactory = &ConvertMeshToFCLCached<fcl::OBBRSS>;
         } else if (type == "kDOP16") {
             _bvhRepresentation = type;
-            _meshFactory = &ConvertMeshToFCL< fcl::KDOP<16> >;
+            _meshFactory = &ConvertMeshToFCLCached< fcl::KDOP<16> >;
         } else if (type == "kDOP18") {
             _bvhRepresentation = type;
-            _meshFactory = &ConvertMeshToFCL< fcl::KDOP<18> >;
+            _meshFactory = &ConvertMeshToFCLCached< fcl::KDOP<18> >;
         } else if (type == "kDOP24") {
             _bvhRepresentation = type;
-            _meshFactory = &ConvertMeshToFCL< fcl::KDOP<24> >;
+            _meshFactory = &ConvertMeshToFCLCached< fcl::KDOP<24> >;
         } else if (type == "kIOS") {
             _bvhRepresentation = type;
-            _meshFactory = &ConvertMeshToFCL<fcl::kIOS>;
+            _meshFactory = &ConvertMeshToFCLCached<fcl::kIOS>;
         } else {
             RAVELOG_WARN(str(boost::format("Unknown BVH representation '%s', keeping '%s' representation") % type % _bvhRepresentation));
             return;
@@ -0,0 +1,125 @@
+// -*- coding: utf-8 -*-
+#ifndef OPENRAVE_FCL_THREADPOOL
+#define OPENRAVE_FCL_THREADPOOL
+
+#include "plugindefs.h"
+#include <atomic>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace fclrave {
+
+/// \brief fixed set of worker threads that run the iterations of a loop together with the calling thread.
+///
+/// Used by FCLCollisionChecker to fan out the narrow phase tests of a batch of link pairs. ParallelFor is not re-entrant, only one
+/// thread at a time can call it.
+class FCLThreadPool
+{
+public:
+    /// \param numworkers number of threads created in addition to the calling thread
+    FCLThreadPool(int numworkers) : _nextindex(0), _num(0), _pfn(NULL), _nGeneration(0), _numActive(0), _bShutdown(false)
+    {
+        for(int i = 0; i < numworkers; ++i) {
+            _vthreads.push_back(boost::shared_ptr<boost::thread>(new boost::thread(boost::bind(&FCLThreadPool::_WorkerThread, this))));
+        }
+    }
+
+    virtual ~FCLThreadPool()
+    {
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _bShutdown = true;
+        }
+        _condWork.notify_all();
+        FOREACH(itthread, _vthreads) {
+            (*itthread)->join();
+        }
+    }
+
+    /// \brief number of threads that run the iterations, including the calling thread
+    int GetNumThreads() const {
+        return (int)_vthreads.size()+1;
+    }
+
+    /// \brief calls fn(i) for every i in [0,num) and returns once all the calls are done.
+    ///
+    /// The iterations are handed out one at a time, so fn can skip the remaining work by returning immediately once it sees its own stop flag.
+    void ParallelFor(size_t num, const boost::function<void(size_t)>& fn)
+    {
+        if( _vthreads.size() == 0 || num <= 1 ) {
+            for(size_t i = 0; i < num; ++i) {
+                fn(i);
+            }
+            return;
+        }
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _pfn = &fn;
+            _num = num;
+            _nextindex = 0;
+            _numActive = _vthreads.size();
+            ++_nGeneration;
+        }
+        _condWork.notify_all();
+        _RunIterations(fn, num);
+
+        boost::mutex::scoped_lock lock(_mutex);
+        while( _numActive > 0 ) {
+            _condDone.wait(lock);
+        }
+        _pfn = NULL;
+    }
+
+private:
+    void _WorkerThread()
+    {
+        uint64_t generation = 0;
+        while(1) {
+            const boost::function<void(size_t)>* pfn = NULL;
+            size_t num = 0;
+            {
+                boost::mutex::scoped_lock lock(_mutex);
+                while( !_bShutdown && _nGeneration == generation ) {
+                    _condWork.wait(lock);
+                }
+                if( _bShutdown ) {
+                    return;
+                }
+                generation = _nGeneration;
+                pfn = _pfn;
+                num = _num;
+            }
+            _RunIterations(*pfn, num);
+            {
+                boost::mutex::scoped_lock lock(_mutex);
+                if( --_numActive == 0 ) {
+                    _condDone.notify_all();
+                }
+            }
+        }
+    }
+
+    inline void _RunIterations(const boost::function<void(size_t)>& fn, size_t num)
+    {
+        for(size_t i = _nextindex++; i < num; i = _nextindex++) {
+            fn(i);
+        }
+    }
+
+    std::vector< boost::shared_ptr<boost::thread> > _vthreads;
+    boost::mutex _mutex; ///< protects the job description below
+    boost::condition_variable _condWork, _condDone;
+    std::atomic<size_t> _nextindex; ///< next iteration to hand out
+    size_t _num; ///< number of iterations of the current job
+    const boost::function<void(size_t)>* _pfn; ///< function of the current job
+    uint64_t _nGeneration; ///< incremented for every job, lets the workers know that there is new work
+    size_t _numActive; ///< number of workers still running the current job
+    bool _bShutdown;
+};
+
+typedef boost::shared_ptr<FCLThreadPool> FCLThreadPoolPtr;
+
+}
+
+#endif
@@ -16,6 +16,7 @@
 #include "plugindefs.h"
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
 
 #ifdef Boost_IOSTREAMS_FOUND
 #include <boost/iostreams/device/file_descriptor.hpp>
@@ -335,7 +336,8 @@ public:
         RegisterCommand("PerfTiming",boost::bind(&IkFastModule::PerfTiming,this,_1,_2),
                         "Times the ik call of a given library.\n"
                         "Usage::\n\n  PerfTiming [options] iklibrarypath\n\n"
-                        "return the set of time measurements made in nano-seconds");
+                        "Options are num (number of ik calls), maxtime (seconds) and threads. If threads is > 0, num random poses are solved across that many threads.\n\n"
+                        "return the set of time measurements made in nano-seconds, or the solves per second if threads is > 0");
         RegisterCommand("IKTest",boost::bind(&IkFastModule::IKtest,this,_1,_2),
                         "Tests for an IK solution if active manipulation has an IK solver attached");
         RegisterCommand("DebugIK",boost::bind(&IkFastModule::DebugIK,this,_1,_2),
@@ -711,7 +713,7 @@ public:
     {
         EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
         string cmd, libraryname;
-        int num=1000;
+        int num=1000, numthreads = 0;
         dReal maxtime = 1200;
         while(!sinput.eof()) {
             istream::streampos pos = sinput.tellg();
@@ -727,6 +729,9 @@ public:
             else if( cmd == "maxtime" ) {
                 sinput >> maxtime;
             }
+            else if( cmd == "threads" ) {
+                sinput >> numthreads;
+            }
             else {
                 sinput.clear();     // have to clear eof bit
                 sinput.seekg(pos);
@@ -747,11 +752,17 @@ public:
 
 #ifdef OPENRAVE_IKFAST_FLOAT32
         if( !!lib->_ikfloat ) {
+            if( numthreads > 0 ) {
+                return _PerfTimingBatch<float>(sout,lib->_ikfloat,num,numthreads);
+            }
             return _PerfTiming<float>(sout,lib->_ikfloat,num, maxtime);
         }
         else
 #endif
         if( !!lib->_ikdouble ) {
+            if( numthreads > 0 ) {
+                return _PerfTimingBatch<double>(sout,lib->_ikdouble,num,numthreads);
+            }
             return _PerfTiming<double>(sout,lib->_ikdouble,num, maxtime);
         }
         else {
@@ -805,6 +816,65 @@ public:
         return true;
     }
 
+    /// \brief solves num random poses across numthreads threads, each with its own solution list, and outputs the solves per second
+    template<typename T> bool _PerfTimingBatch(ostream& sout, boost::shared_ptr<ikfast::IkFastFunctions<T> > ikfunctions, int num, int numthreads)
+    {
+        OPENRAVE_ASSERT_OP(ikfunctions->_GetIkRealSize(),==,sizeof(T));
+        BOOST_ASSERT((!!ikfunctions->_ComputeIk || !!ikfunctions->_ComputeIk2) && !!ikfunctions->_ComputeFk);
+
+        // every pose is 12 values: translation and rotation matrix, followed by the free values
+        int numjoints = ikfunctions->_GetNumJoints(), numfree = ikfunctions->_GetNumFreeParameters();
+        int posesize = 12+numfree;
+        vector<T> vposes(num*posesize), vjoints(numjoints);
+        for(int i = 0; i < num; ++i) {
+            for(int j = 0; j < numjoints; ++j) {
+                vjoints[j] = RaveRandomDouble()*2*PI;
+            }
+            T* ppose = &vposes[i*posesize];
+            ikfunctions->_ComputeFk(&vjoints[0],ppose,ppose+3);
+            for(int j = 0; j < numfree; ++j) {
+                ppose[12+j] = vjoints[ikfunctions->_GetFreeIndices()[j]];
+            }
+        }
+
+        vector<int> vnumsolved(numthreads, 0);
+        uint64_t starttime = utils::GetNanoPerformanceTime();
+        boost::thread_group workerthreads;
+        for(int ithread = 0; ithread < numthreads; ++ithread) {
+            workerthreads.create_thread(boost::bind(&IkFastModule::_PerfTimingBatchWorker<T>, ikfunctions, boost::cref(vposes), posesize, ithread, numthreads, boost::ref(vnumsolved[ithread])));
+        }
+        workerthreads.join_all();
+        uint64_t elapsedtime = utils::GetNanoPerformanceTime()-starttime;
+
+        int numsolved = 0;
+        FOREACHC(itnumsolved, vnumsolved) {
+            numsolved += *itnumsolved;
+        }
+        RAVELOG_DEBUG_FORMAT("solved %d/%d poses with %d threads in %fs", numsolved%num%numthreads%(elapsedtime*1e-9));
+        sout << (elapsedtime > 0 ? 1e9*num/elapsedtime : 0.0);
+        return true;
+    }
+
+    template<typename T> static void _PerfTimingBatchWorker(boost::shared_ptr<ikfast::IkFastFunctions<T> > ikfunctions, const vector<T>& vposes, int posesize, int startindex, int stride, int& numsolved)
+    {
+        ikfast::IkSolutionList<T> solutions; // reused for all the poses of this thread
+        int numposes = (int)vposes.size()/posesize;
+        for(int i = startindex; i < numposes; i += stride) {
+            const T* ppose = &vposes[i*posesize];
+            solutions.Clear();
+            bool bsuccess;
+            if( !!ikfunctions->_ComputeIk2 ) {
+                bsuccess = ikfunctions->_ComputeIk2(ppose, ppose+3, posesize > 12 ? ppose+12 : NULL, solutions, NULL);
+            }
+            else {
+                bsuccess = ikfunctions->_ComputeIk(ppose, ppose+3, posesize > 12 ? ppose+12 : NULL, solutions);
+            }
+            if( bsuccess ) {
+                ++numsolved;
+            }
+        }
+    }
+
     bool IKtest(ostream& sout, istream& sinput)
     {
         EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
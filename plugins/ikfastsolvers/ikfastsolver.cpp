@@ -18,6 +18,7 @@
 #include <boost/bind.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
 
 #ifdef OPENRAVE_HAS_LAPACK
 #include "jacobianinverse.h"
@@ -81,8 +82,18 @@ public:
         RegisterCommand("SetBackTraceSelfCollisionLinks",boost::bind(&IkFastSolver<IkReal>::_SetBackTraceSelfCollisionLinksCommand,this,_1,_2),
                         "format: int int\n\n\
 for numBacktraceLinksForSelfCollisionWithNonMoving numBacktraceLinksForSelfCollisionWithFree, when pruning self collisions, the number of links to look at. If the tip of the manip self collides with the base, then can safely quit the IK.");
+        RegisterCommand("SetFreeSearchTolerance",boost::bind(&IkFastSolver<IkReal>::_SetFreeSearchToleranceCommand,this,_1,_2),
+                        "when solving close to a configuration, search the free joints best-first and stop once a solution is within this weighted joint distance of it. The default 1e30 stops at the first solution, walking the free joints outward from the configuration without sorting them.");
+        RegisterCommand("SetSolutionCache",boost::bind(&IkFastSolver<IkReal>::_SetSolutionCacheCommand,this,_1,_2),
+                        "format: size quantization\n\nremembers the free joint values of the solutions of the last size poses, poses whose ik parameterization values are the same after dividing by quantization and rounding share an entry. When solving close to a configuration, the remembered free values of the pose are tried first. A size of 0 disables the cache (default).");
+        RegisterCommand("SetBatchThreads",boost::bind(&IkFastSolver<IkReal>::_SetBatchThreadsCommand,this,_1,_2),
+                        "sets the number of threads SolveAllBatch uses for poses that only need kinematic validity. 0 uses all cores (default).");
         _numBacktraceLinksForSelfCollisionWithNonMoving = 2;
         _numBacktraceLinksForSelfCollisionWithFree = 0;
+        _nBatchThreads = 0;
+        _fFreeSearchTolerance = 1e30;
+        _nSolutionCacheSize = 0;
+        _fSolutionCacheQuantization = 0.01;
     }
     virtual ~IkFastSolver() {
     }
@@ -203,6 +214,33 @@ for numBacktraceLinksForSelfCollisionWithNonMoving numBacktraceLinksForSelfColli
         return true;
     }
 
+    bool _SetFreeSearchToleranceCommand(ostream& sout, istream& sinput)
+    {
+        sinput >> _fFreeSearchTolerance;
+        return !!sinput;
+    }
+
+    bool _SetSolutionCacheCommand(ostream& sout, istream& sinput)
+    {
+        size_t size = 0;
+        dReal quantization = _fSolutionCacheQuantization;
+        sinput >> size >> quantization;
+        if( quantization <= 0 ) {
+            return false;
+        }
+        _nSolutionCacheSize = size;
+        _fSolutionCacheQuantization = quantization;
+        _listSolutionCache.clear();
+        _mapSolutionCache.clear();
+        return true;
+    }
+
+    bool _SetBatchThreadsCommand(ostream& sout, istream& sinput)
+    {
+        sinput >> _nBatchThreads;
+        return !!sinput;
+    }
+
     bool _SetBackTraceSelfCollisionLinksCommand(ostream& sout, istream& sinput)
     {
         sinput >> _numBacktraceLinksForSelfCollisionWithNonMoving >> _numBacktraceLinksForSelfCollisionWithFree;
@@ -676,7 +714,13 @@ protected:
         std::vector<IkReal> vfree(_vfreeparams.size());
         StateCheckEndEffector stateCheck(probot,_vchildlinks,_vindependentlinks,filteroptions);
         CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
-        IkReturnAction retaction = ComposeSolution(_vfreeparams, vfree, 0, q0, boost::bind(&IkFastSolver::_SolveSingle,shared_solver(), boost::ref(param),boost::ref(vfree),boost::ref(q0),filteroptions,ikreturn,boost::ref(stateCheck)), _vFreeInc);
+        IkReturnAction retaction;
+        if( _vfreeparams.size() > 0 && q0.size() == _qlower.size() ) {
+            retaction = _SolveBestFirst(param, q0, filteroptions, ikreturn, stateCheck);
+        }
+        else {
+            retaction = ComposeSolution(_vfreeparams, vfree, 0, q0, boost::bind(&IkFastSolver::_SolveSingle,shared_solver(), boost::ref(param),boost::ref(vfree),boost::ref(q0),filteroptions,ikreturn,boost::ref(stateCheck)), _vFreeInc);
+        }
         if( !!ikreturn ) {
             ikreturn->_action = retaction;
         }
@@ -756,6 +800,55 @@ protected:
         return vikreturns.size()>0;
     }
 
+    virtual int SolveAllBatch(const std::vector<IkParameterization>& vrawparams, int filteroptions, std::vector< std::vector< std::vector<dReal> > >& vsolutions)
+    {
+        if( (filteroptions & IKFO_CheckEnvCollisions) || !(filteroptions & IKFO_IgnoreSelfCollisions) || (!(filteroptions & IKFO_IgnoreCustomFilters) && _HasFilterInRange(IKSP_MinPriority, IKSP_MaxPriority)) || _fRefineWithJacobianInverseAllowedError > 0 ) {
+            // the solutions have to be checked with the robot, so cannot leave the thread of the caller
+            return IkSolverBase::SolveAllBatch(vrawparams, filteroptions, vsolutions);
+        }
+
+        RobotBase::ManipulatorPtr pmanip(_pmanip);
+        std::vector<IkParameterization> vparams(vrawparams.size());
+        IkParameterization ikparamdummy;
+        for(size_t i = 0; i < vrawparams.size(); ++i) {
+            vparams[i] = _ConvertIkParameterization(vrawparams[i], ikparamdummy);
+        }
+
+        // the free values of the solver do not depend on the pose, so enumerate them once instead of for every pose
+        std::vector<IkReal> vfree(_vfreeparams.size()), vallfree;
+        ComposeSolution(_vfreeparams, vfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_AppendFreeValues, boost::cref(vfree), boost::ref(vallfree)), _vFreeInc);
+
+        // the threads sort the solutions like _SortSolutions, so read the joint weights of the arm here
+        RobotBasePtr probot = pmanip->GetRobot();
+        std::vector<dReal> viweights; viweights.reserve(pmanip->GetArmIndices().size());
+        FOREACHC(it, pmanip->GetArmIndices()) {
+            KinBody::JointPtr pjoint = probot->GetJointFromDOFIndex(*it);
+            viweights.push_back(1/pjoint->GetWeight(*it-pjoint->GetDOFIndex()));
+        }
+
+        vsolutions.resize(vparams.size());
+        Transform tLocalTool = pmanip->GetLocalToolTransform();
+        int numthreads = _nBatchThreads > 0 ? _nBatchThreads : (int)boost::thread::hardware_concurrency();
+        numthreads = max(1, min(numthreads, (int)vparams.size()/16)); // not worth starting a thread for a few poses
+        std::vector<int> vnumsolved(numthreads, 0);
+        if( numthreads == 1 ) {
+            _SolveAllBatchKinematics(vparams, vallfree, filteroptions, tLocalTool, viweights, 0, 1, vsolutions, vnumsolved[0]);
+        }
+        else {
+            boost::thread_group workerthreads;
+            for(int ithread = 0; ithread < numthreads; ++ithread) {
+                workerthreads.create_thread(boost::bind(&IkFastSolver::_SolveAllBatchKinematics, this, boost::cref(vparams), boost::cref(vallfree), filteroptions, boost::cref(tLocalTool), boost::cref(viweights), ithread, numthreads, boost::ref(vsolutions), boost::ref(vnumsolved[ithread])));
+            }
+            workerthreads.join_all();
+        }
+
+        int numsolved = 0;
+        FOREACHC(itnumsolved, vnumsolved) {
+            numsolved += *itnumsolved;
+        }
+        return numsolved;
+    }
+
     virtual int GetNumFreeParameters() const
     {
         return (int)_vfreeparams.size();
@@ -839,6 +932,12 @@ protected:
 #endif
 
         _bEmptyTransform6D = r->_bEmptyTransform6D;
+        _nBatchThreads = r->_nBatchThreads;
+        _fFreeSearchTolerance = r->_fFreeSearchTolerance;
+        _nSolutionCacheSize = r->_nSolutionCacheSize;
+        _fSolutionCacheQuantization = r->_fSolutionCacheQuantization;
+        _listSolutionCache.clear();
+        _mapSolutionCache.clear();
     }
 
 protected:
@@ -849,11 +948,34 @@ protected:
         }
 
         // start searching for phi close to q0, as soon as a solution is found for the curphi, return it
-        dReal startphi = q0.size() == _qlower.size() ? q0.at(vfreeparams.at(freeindex)) : 0;
-        dReal upperphi = _qupper.at(vfreeparams.at(freeindex)), lowerphi = _qlower.at(vfreeparams.at(freeindex)), deltaphi = 0;
+        std::vector<dReal> vfreevalues;
+        _ComputeFreeValues(vfreeparams.at(freeindex), q0, vFreeInc.at(freeindex), vfreevalues);
+        int allres = IKRA_Reject;
+        FOREACHC(itvalue, vfreevalues) {
+            vfree.at(freeindex) = *itvalue;
+            IkReturnAction res = ComposeSolution(vfreeparams, vfree, freeindex+1,q0, fn, vFreeInc);
+            if( !(res & IKRA_Reject) ) {
+                return res;
+            }
+            if( res & IKRA_Quit ) {
+                return res;
+            }
+            allres |= res;
+        }
+        return static_cast<IkReturnAction>(allres);
+    }
+
+    /// \brief computes the values of a free joint to search, starting from its value in q0 and going outwards in both directions
+    ///
+    /// \param ifreejoint index into the manipulator arm indices
+    void _ComputeFreeValues(int ifreejoint, const vector<dReal>& q0, dReal fFreeInc, std::vector<dReal>& vvalues) const
+    {
+        vvalues.resize(0);
+        dReal startphi = q0.size() == _qlower.size() ? q0.at(ifreejoint) : 0;
+        dReal upperphi = _qupper.at(ifreejoint), lowerphi = _qlower.at(ifreejoint), deltaphi = 0;
         dReal lowerChecked = startphi; // lowest value checked
         dReal upperChecked = startphi; // uppermost value checked
-        int isJointRevolute = _vjointrevolute.at(vfreeparams.at(freeindex));
+        int isJointRevolute = _vjointrevolute.at(ifreejoint);
         if( isJointRevolute == 2 ) {
             startphi = utils::NormalizeCircularAngle(startphi, -PI, PI);
             lowerphi = startphi-PI;
@@ -862,8 +984,6 @@ protected:
 
         bool bIsZeroTested = false;
         int iter = 0;
-        dReal fFreeInc = vFreeInc.at(freeindex);
-        int allres = IKRA_Reject;
         while(1) {
             dReal curphi = startphi;
             if( iter & 1 ) { // increment
@@ -905,31 +1025,190 @@ protected:
             if( RaveFabs(curphi) <= g_fEpsilonJointLimit ) {
                 bIsZeroTested = true;
             }
-            //RAVELOG_VERBOSE_FORMAT("index=%d curphi=%.16e, range=%.16e", freeindex%curphi%(upperChecked - lowerChecked));
-            vfree.at(freeindex) = curphi;
-            IkReturnAction res = ComposeSolution(vfreeparams, vfree, freeindex+1,q0, fn, vFreeInc);
-            if( !(res & IKRA_Reject) ) {
-                return res;
-            }
-            if( res & IKRA_Quit ) {
-                return res;
-            }
-            allres |= res;
+            //RAVELOG_VERBOSE_FORMAT("index=%d curphi=%.16e, range=%.16e", ifreejoint%curphi%(upperChecked - lowerChecked));
+            vvalues.push_back(curphi);
         }
 
         // explicitly test 0 since many edge cases involve 0s
-        if( !bIsZeroTested && _qlower[vfreeparams[freeindex]] <= 0 && _qupper[vfreeparams[freeindex]] >= 0 ) {
-            vfree.at(freeindex) = 0;
-            IkReturnAction res = ComposeSolution(vfreeparams, vfree, freeindex+1,q0, fn, vFreeInc);
-            if( !(res & IKRA_Reject) ) {
-                return res;
+        if( !bIsZeroTested && _qlower[ifreejoint] <= 0 && _qupper[ifreejoint] >= 0 ) {
+            vvalues.push_back(0);
+        }
+    }
+
+    /// \brief searches the free values of the solver best-first, ordered by how close their solutions can get to q0.
+    ///
+    /// The squared weighted distance of the free joints to q0 is a lower bound of the distance of a solution to q0, so
+    /// the search stops once the next free values cannot beat the best solution found, or once a solution is within
+    /// _fFreeSearchTolerance of q0. The free values of the last solution of a nearby pose are tried first.
+    /// With the default unbounded tolerance any solution is accepted, so the free values are walked outward from q0 like
+    /// ComposeSolution always did instead of sorting all their combinations first.
+    IkReturnAction _SolveBestFirst(const IkParameterization& param, const vector<dReal>& q0, int filteroptions, IkReturnPtr ikreturn, StateCheckEndEffector& stateCheck)
+    {
+        RobotBase::ManipulatorPtr pmanip(_pmanip);
+        RobotBasePtr probot = pmanip->GetRobot();
+        size_t numfree = _vfreeparams.size();
+        if( _fFreeSearchTolerance >= 1e30 ) {
+            std::vector<IkReal> vfree(numfree);
+            IkReturnPtr pfirstreturn = !!ikreturn ? ikreturn : IkReturnPtr(new IkReturn(IKRA_Reject)); // to cache the free values of the solution
+            IkReturnAction res = IKRA_Reject;
+            std::vector<dReal> vcachedfree;
+            if( _GetCachedFreeValues(param, vcachedfree) ) {
+                std::copy(vcachedfree.begin(), vcachedfree.end(), vfree.begin());
+                res = _SolveSingle(param, vfree, q0, filteroptions, pfirstreturn, stateCheck);
+            }
+            if( res != IKRA_Success && !(res & IKRA_Quit) ) {
+                res = ComposeSolution(_vfreeparams, vfree, 0, q0, boost::bind(&IkFastSolver::_SolveSingle,shared_solver(), boost::ref(param),boost::ref(vfree),boost::ref(q0),filteroptions,pfirstreturn,boost::ref(stateCheck)), _vFreeInc);
+            }
+            if( res == IKRA_Success ) {
+                _CacheFreeValues(param, pfirstreturn->_vsolution);
+            }
+            return res;
+        }
+
+        std::vector< std::vector<dReal> > vvfreevalues(numfree);
+        std::vector<dReal> vfreeweights2(numfree);
+        size_t numcandidates = 1;
+        for(size_t ifree = 0; ifree < numfree; ++ifree) {
+            _ComputeFreeValues(_vfreeparams[ifree], q0, _vFreeInc.at(ifree), vvfreevalues[ifree]);
+            numcandidates *= vvfreevalues[ifree].size();
+            int dofindex = pmanip->GetArmIndices().at(_vfreeparams[ifree]);
+            KinBody::JointPtr pjoint = probot->GetJointFromDOFIndex(dofindex);
+            dReal fweight = pjoint->GetWeight(dofindex-pjoint->GetDOFIndex());
+            vfreeweights2[ifree] = fweight*fweight;
+        }
+
+        std::vector<IkReal> vfree(numfree);
+        if( numcandidates > 0x100000 ) {
+            // too many combinations to sort, so search depth first
+            return ComposeSolution(_vfreeparams, vfree, 0, q0, boost::bind(&IkFastSolver::_SolveSingle,shared_solver(), boost::ref(param),boost::ref(vfree),boost::ref(q0),filteroptions,ikreturn,boost::ref(stateCheck)), _vFreeInc);
+        }
+
+        // every combination of the free values with the lower bound of the distance of its solutions to q0
+        std::vector<dReal> vcandidatevalues;
+        vcandidatevalues.reserve((numcandidates+1)*numfree);
+        std::vector< std::pair<size_t, dReal> > vcandidates; vcandidates.reserve(numcandidates+1);
+        for(size_t icandidate = 0; icandidate < numcandidates; ++icandidate) {
+            size_t index = icandidate;
+            dReal fbound = 0;
+            vcandidates.emplace_back(vcandidatevalues.size(), 0);
+            for(size_t ifree = 0; ifree < numfree; ++ifree) {
+                const std::vector<dReal>& vfreevalues = vvfreevalues[ifree];
+                dReal fvalue = vfreevalues[index%vfreevalues.size()];
+                index /= vfreevalues.size();
+                vcandidatevalues.push_back(fvalue);
+                dReal fdelta = fvalue - q0[_vfreeparams[ifree]];
+                if( _vjointrevolute[_vfreeparams[ifree]] == 2 ) {
+                    fdelta = utils::NormalizeCircularAngle(fdelta, -PI, PI);
+                }
+                fbound += fdelta*fdelta*vfreeweights2[ifree];
+            }
+            vcandidates.back().second = fbound;
+        }
+        std::stable_sort(vcandidates.begin(),vcandidates.end(),SortSolutionDistances);
+
+        std::vector<dReal> vcachedfree;
+        if( _GetCachedFreeValues(param, vcachedfree) ) {
+            vcandidates.insert(vcandidates.begin(), std::make_pair(vcandidatevalues.size(), dReal(0)));
+            vcandidatevalues.insert(vcandidatevalues.end(), vcachedfree.begin(), vcachedfree.end());
+        }
+
+        IkReturnPtr pbestreturn;
+        IkParameterization parambestglobal, paramnewglobal;
+        dReal fbestdist = 1e30, ftolerance2 = _fFreeSearchTolerance*_fFreeSearchTolerance;
+        int allres = IKRA_Reject;
+        FOREACHC(itcandidate, vcandidates) {
+            if( itcandidate->second >= fbestdist ) {
+                break; // the remaining free values cannot get closer to q0
+            }
+            std::copy(vcandidatevalues.begin()+itcandidate->first, vcandidatevalues.begin()+itcandidate->first+numfree, vfree.begin());
+            IkReturnPtr pcandidatereturn;
+            IkReturnAction res = _SolveSingleNoFinish(param, vfree, q0, filteroptions, stateCheck, pcandidatereturn, paramnewglobal);
+            if( !!pcandidatereturn ) {
+                dReal fdist = _ComputeGeometricConfigDistSqr(probot, pcandidatereturn->_vsolution, q0);
+                if( fdist < fbestdist ) {
+                    pbestreturn = pcandidatereturn;
+                    parambestglobal = paramnewglobal;
+                    fbestdist = fdist;
+                }
+                if( fbestdist <= ftolerance2 ) {
+                    break;
+                }
+                continue;
             }
             allres |= res;
+            if( res & IKRA_Quit ) {
+                return static_cast<IkReturnAction>(allres);
+            }
         }
 
+        if( !!pbestreturn ) {
+            _CacheFreeValues(param, pbestreturn->_vsolution);
+            if( !!ikreturn ) {
+                *ikreturn = *pbestreturn;
+            }
+            _CallFinishCallbacks(pbestreturn, pmanip, parambestglobal);
+            return pbestreturn->_action;
+        }
         return static_cast<IkReturnAction>(allres);
     }
 
+    /// \brief quantizes the values of the ik parameterization to look up nearby poses in the solution cache
+    void _GetSolutionCacheKey(const IkParameterization& param, std::vector<int64_t>& vkey) const
+    {
+        std::vector<dReal> vvalues(param.GetNumberOfValues());
+        param.GetValues(vvalues.begin());
+        vkey.resize(vvalues.size()+1);
+        vkey[0] = param.GetType();
+        for(size_t i = 0; i < vvalues.size(); ++i) {
+            vkey[i+1] = (int64_t)std::floor(vvalues[i]/_fSolutionCacheQuantization+0.5);
+        }
+    }
+
+    /// \brief gets the free values of the last solution of a pose quantized to the same values as param
+    bool _GetCachedFreeValues(const IkParameterization& param, std::vector<dReal>& vfreevalues)
+    {
+        if( _nSolutionCacheSize == 0 ) {
+            return false;
+        }
+        std::vector<int64_t> vkey;
+        _GetSolutionCacheKey(param, vkey);
+        std::map<std::vector<int64_t>, SolutionCacheList::iterator>::iterator itcache = _mapSolutionCache.find(vkey);
+        if( itcache == _mapSolutionCache.end() ) {
+            return false;
+        }
+        // most recently used entries are at the front
+        _listSolutionCache.splice(_listSolutionCache.begin(), _listSolutionCache, itcache->second);
+        vfreevalues = itcache->second->second;
+        return true;
+    }
+
+    /// \brief remembers the free values of vsolution for param, removing the least recently used pose if the cache is full
+    void _CacheFreeValues(const IkParameterization& param, const std::vector<dReal>& vsolution)
+    {
+        if( _nSolutionCacheSize == 0 ) {
+            return;
+        }
+        std::vector<int64_t> vkey;
+        _GetSolutionCacheKey(param, vkey);
+        std::map<std::vector<int64_t>, SolutionCacheList::iterator>::iterator itcache = _mapSolutionCache.find(vkey);
+        if( itcache != _mapSolutionCache.end() ) {
+            _listSolutionCache.splice(_listSolutionCache.begin(), _listSolutionCache, itcache->second);
+        }
+        else {
+            if( _listSolutionCache.size() >= _nSolutionCacheSize ) {
+                _mapSolutionCache.erase(_listSolutionCache.back().first);
+                _listSolutionCache.pop_back();
+            }
+            _listSolutionCache.push_front(std::make_pair(vkey, std::vector<dReal>()));
+            _mapSolutionCache[vkey] = _listSolutionCache.begin();
+        }
+        std::vector<dReal>& vfreevalues = _listSolutionCache.front().second;
+        vfreevalues.resize(_vfreeparams.size());
+        for(size_t ifree = 0; ifree < _vfreeparams.size(); ++ifree) {
+            vfreevalues[ifree] = vsolution.at(_vfreeparams[ifree]);
+        }
+    }
+
     /// \param tLocalTool _pmanip->GetLocalToolTransform()
     inline bool _CallIk(const IkParameterization& param, const vector<IkReal>& vfree, const Transform& tLocalTool, ikfast::IkSolutionList<IkReal>& solutions)
     {
@@ -1290,6 +1569,25 @@ protected:
     }
 
     IkReturnAction _SolveSingle(const IkParameterization& param, const vector<IkReal>& vfree, const vector<dReal>& q0, int filteroptions, IkReturnPtr ikreturn, StateCheckEndEffector& stateCheck)
+    {
+        IkReturnPtr pbestreturn;
+        IkParameterization paramnewglobal;
+        IkReturnAction retaction = _SolveSingleNoFinish(param, vfree, q0, filteroptions, stateCheck, pbestreturn, paramnewglobal);
+        if( !!pbestreturn ) {
+            if( !!ikreturn ) {
+                *ikreturn = *pbestreturn;
+            }
+            _CallFinishCallbacks(pbestreturn, RobotBase::ManipulatorPtr(_pmanip), paramnewglobal);
+            return pbestreturn->_action;
+        }
+        return retaction;
+    }
+
+    /// \brief solves for the given free values without calling the finish callbacks
+    ///
+    /// \param[out] pbestreturn set to the solution closest to q0 if one is found
+    /// \param[out] paramnewglobal the ik parameterization of pbestreturn in the world
+    IkReturnAction _SolveSingleNoFinish(const IkParameterization& param, const vector<IkReal>& vfree, const vector<dReal>& q0, int filteroptions, StateCheckEndEffector& stateCheck, IkReturnPtr& pbestreturn, IkParameterization& paramnewglobal)
     {
         RobotBase::ManipulatorPtr pmanip(_pmanip);
         ikfast::IkSolutionList<IkReal> solutions;
@@ -1334,7 +1632,7 @@ protected:
         }
 
         int allres = IKRA_Reject;
-        IkParameterization paramnewglobal; // needs to be initialized by _ValidateSolutionSingle so we get most accurate result back
+        // paramnewglobal needs to be initialized by _ValidateSolutionSingle so we get most accurate result back
         FOREACH(itindex,vsolutionorder) {
             const ikfast::IkSolution<IkReal>& iksol = dynamic_cast<const ikfast::IkSolution<IkReal>& >(solutions.GetSolution(*itindex));
             IkReturnAction res;
@@ -1361,12 +1659,9 @@ protected:
 
         // return as soon as a solution is found, since we're visiting phis starting from q0, we are guaranteed
         // that the solution will be close (ie, phi's dominate in the search). This is to speed things up
-        if( !!bestsolution.ikreturn ) {
-            if( !!ikreturn ) {
-                *ikreturn = *bestsolution.ikreturn;
-            }
-            _CallFinishCallbacks(bestsolution.ikreturn, pmanip, paramnewglobal);
-            return bestsolution.ikreturn->_action;
+        pbestreturn = bestsolution.ikreturn;
+        if( !!pbestreturn ) {
+            return pbestreturn->_action;
         }
         return static_cast<IkReturnAction>(allres);
     }
@@ -2309,6 +2604,109 @@ protected:
         }
     }
 
+    /// \brief ComposeSolution callback that stores all the free values it is called with
+    static IkReturnAction _AppendFreeValues(const vector<IkReal>& vfree, std::vector<IkReal>& vallfree)
+    {
+        vallfree.insert(vallfree.end(), vfree.begin(), vfree.end());
+        return IKRA_Reject; // continue with the next free values
+    }
+
+    /// \brief solves the poses startindex, startindex+stride, ... of vparams only checking the joint limits.
+    ///
+    /// Does not touch the robot, so several threads can call this at the same time.
+    /// The solutions of every pose are found and ordered exactly like SolveAll finds and orders them.
+    /// \param vallfree the free values to solve every pose with, one after another
+    /// \param viweights inverse of the weights of the arm joints, see _SortBatchSolutions
+    /// \param numsolved incremented for every pose with at least one solution
+    void _SolveAllBatchKinematics(const std::vector<IkParameterization>& vparams, const std::vector<IkReal>& vallfree, int filteroptions, const Transform& tLocalTool, const std::vector<dReal>& viweights, int startindex, int stride, std::vector< std::vector< std::vector<dReal> > >& vsolutions, int& numsolved)
+    {
+        ikfast::IkSolutionList<IkReal> solutions; // reused for all the poses of this thread
+        std::vector<IkReal> vfree(_vfreeparams.size()), vsolfree, vallsolfree, sol;
+        std::vector<dReal> vravesol;
+        std::vector< std::pair<std::vector<dReal>, int> > vravesols;
+        std::vector< std::pair<size_t, dReal> > vdists;
+        std::vector< std::vector<dReal> > vsortedsolutions;
+        size_t numfree = _vfreeparams.size() > 0 ? vallfree.size()/_vfreeparams.size() : 1;
+        for(size_t iparam = startindex; iparam < vparams.size(); iparam += stride) {
+            std::vector< std::vector<dReal> >& vparamsolutions = vsolutions[iparam];
+            vparamsolutions.resize(0);
+            for(size_t ifree = 0; ifree < numfree; ++ifree) {
+                std::copy(vallfree.begin()+ifree*vfree.size(), vallfree.begin()+(ifree+1)*vfree.size(), vfree.begin());
+                solutions.Clear();
+                if( !_CallIk(vparams[iparam], vfree, tLocalTool, solutions) ) {
+                    continue;
+                }
+                for(size_t isolution = 0; isolution < solutions.GetNumSolutions(); ++isolution) {
+                    const ikfast::IkSolution<IkReal>& iksol = dynamic_cast<const ikfast::IkSolution<IkReal>& >(solutions.GetSolution(isolution));
+                    iksol.Validate();
+                    if( iksol.GetFree().size() > 0 ) {
+                        // have to search over all the free parameters of the solution!
+                        vsolfree.resize(iksol.GetFree().size());
+                        vallsolfree.resize(0);
+                        ComposeSolution(iksol.GetFree(), vsolfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_AppendFreeValues, boost::cref(vsolfree), boost::ref(vallsolfree)), _GetFreeIncFromIndices(iksol.GetFree()));
+                        for(size_t isolfree = 0; isolfree < vallsolfree.size(); isolfree += vsolfree.size()) {
+                            std::copy(vallsolfree.begin()+isolfree, vallsolfree.begin()+isolfree+vsolfree.size(), vsolfree.begin());
+                            _AppendKinematicSolutions(iksol, vsolfree, filteroptions, sol, vravesol, vravesols, vparamsolutions);
+                        }
+                    }
+                    else {
+                        vsolfree.resize(0);
+                        _AppendKinematicSolutions(iksol, vsolfree, filteroptions, sol, vravesol, vravesols, vparamsolutions);
+                    }
+                }
+            }
+            if( vparamsolutions.size() > 0 ) {
+                _SortBatchSolutions(viweights, vparamsolutions, vdists, vsortedsolutions);
+                ++numsolved;
+            }
+        }
+    }
+
+    /// \brief same order as _SortSolutions, the farthest from the joint limits first, but without the robot so that several threads can call it
+    ///
+    /// \param viweights inverse of the weights of the arm joints
+    void _SortBatchSolutions(const std::vector<dReal>& viweights, std::vector< std::vector<dReal> >& vparamsolutions, std::vector< std::pair<size_t, dReal> >& vdists, std::vector< std::vector<dReal> >& vsortedsolutions) const
+    {
+        vdists.resize(vparamsolutions.size());
+        for(size_t i = 0; i < vparamsolutions.size(); ++i) {
+            const std::vector<dReal>& v = vparamsolutions[i];
+            dReal distlower = 1e30, distupper = 1e30;
+            for(size_t j = 0; j < v.size(); ++j) {
+                // like SubtractActiveDOFValues, the differences of circular joints are taken in [-PI,PI]
+                dReal flower = _vjointrevolute[j] == 2 ? utils::SubtractCircularAngle(v[j], _qlower[j]) : v[j]-_qlower[j];
+                dReal fupper = _vjointrevolute[j] == 2 ? utils::SubtractCircularAngle(v[j], _qupper[j]) : v[j]-_qupper[j];
+                distlower = min(distlower, RaveFabs(flower)*viweights[j]);
+                distupper = min(distupper, RaveFabs(fupper)*viweights[j]);
+            }
+            vdists[i].first = i;
+            vdists[i].second = -min(distupper,distlower);
+        }
+        std::stable_sort(vdists.begin(),vdists.end(),SortSolutionDistances);
+        vsortedsolutions.resize(vparamsolutions.size());
+        for(size_t i = 0; i < vdists.size(); ++i) {
+            vsortedsolutions[i].swap(vparamsolutions[vdists[i].first]);
+        }
+        vparamsolutions.swap(vsortedsolutions);
+    }
+
+    /// \brief adds the solution and all its equivalent solutions within the joint limits to vparamsolutions
+    void _AppendKinematicSolutions(const ikfast::IkSolution<IkReal>& iksol, const std::vector<IkReal>& vsolfree, int filteroptions, std::vector<IkReal>& sol, std::vector<dReal>& vravesol, std::vector< std::pair<std::vector<dReal>, int> >& vravesols, std::vector< std::vector<dReal> >& vparamsolutions)
+    {
+        iksol.GetSolution(sol, vsolfree);
+        vravesol.resize(sol.size());
+        std::copy(sol.begin(), sol.end(), vravesol.begin());
+        if( !(filteroptions&IKFO_IgnoreJointLimits) ) {
+            _ComputeAllSimilarJointAngles(vravesols, vravesol);
+            FOREACH(itravesol, vravesols) {
+                vparamsolutions.push_back(std::vector<dReal>());
+                vparamsolutions.back().swap(itravesol->first);
+            }
+        }
+        else {
+            vparamsolutions.push_back(vravesol);
+        }
+    }
+
     void _SortSolutions(RobotBasePtr probot, std::vector<IkReturnPtr>& vikreturns)
     {
         // sort with respect to how far it is from limits
@@ -2338,12 +2736,12 @@ protected:
         }
 
         std::stable_sort(vdists.begin(),vdists.end(),SortSolutionDistances);
+        // swapping in place along vdists does not follow the cycles of the permutation, so gather the sorted returns in a new vector
+        std::vector<IkReturnPtr> vsortedikreturns(vikreturns.size());
         for(size_t i = 0; i < vdists.size(); ++i) {
-            if( i != vdists[i].first )  {
-                std::swap(vikreturns[i], vikreturns[vdists[i].first]);
-                std::swap(vdists[i], vdists[vdists[i].first]);
-            }
+            vsortedikreturns[i].swap(vikreturns[vdists[i].first]);
         }
+        vikreturns.swap(vsortedikreturns);
     }
 
     /// \brief return incremental values for indices in the chain
@@ -2440,6 +2838,13 @@ protected:
     //@}
 
     bool _bEmptyTransform6D; ///< if true, then the iksolver has been built with identity of the manipulator transform. Only valid for Transform6D IKs.
+    int _nBatchThreads; ///< number of threads of SolveAllBatch, 0 uses all cores
+    dReal _fFreeSearchTolerance; ///< Solve stops searching the free joints once a solution is this close to q0
+    typedef std::list< std::pair< std::vector<int64_t>, std::vector<dReal> > > SolutionCacheList;
+    SolutionCacheList _listSolutionCache; ///< quantized poses and the free values of their last solutions, most recently used first
+    std::map<std::vector<int64_t>, SolutionCacheList::iterator> _mapSolutionCache; ///< indexes _listSolutionCache by quantized pose
+    size_t _nSolutionCacheSize; ///< maximum number of poses in _listSolutionCache, 0 disables the cache
+    dReal _fSolutionCacheQuantization; ///< ik parameterization values are divided by this and rounded to get the key of the cache
 
 };
 
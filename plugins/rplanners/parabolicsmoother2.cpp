@@ -13,6 +13,9 @@
 // If not, see <http://www.gnu.org/licenses/>.
 #include "openraveplugindefs.h"
 #include <fstream>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <openrave/planningutils.h>
 
 #include "rampoptimizer/interpolator.h"
@@ -26,6 +29,7 @@
 // #define SMOOTHER2_ENABLE_LAZYCOLLISIONCHECKING
 // #define SMOOTHER2_DISABLE_VVISITEDDISCRETIZATION
 #define SMOOTHER2_ENABLE_MERGING
+#define SMOOTHER2_SHORTCUT_BATCH_SIZE 8 // number of shortcut candidates checked at a time when nshortcutthreads > 1
 
 namespace rplanners {
 
@@ -362,10 +366,15 @@ public:
             _logginguniformsampler->SetSeed(utils::GetMicroTime());
         }
         _environmentid = GetEnv()->GetId();
+        _bStopShortcutWorkers = false;
         _vVisitedDiscretizationCache.resize(0x1000*0x1000,0); // pre-allocate in order to keep memory growth predictable
         _feasibilitychecker.SetEnvID(_environmentid); // set envid for logging purpose
     }
 
+    virtual ~ParabolicSmoother2() {
+        _DestroyShortcutWorkers(0);
+    }
+
     virtual bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr params)
     {
         EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
@@ -720,7 +729,18 @@ public:
 #ifdef SMOOTHER2_ENABLE_MERGING
                 nummerges = _MergeConsecutiveSegments(parabolicpath, parameters->_fStepLength*0.99);
 #endif
-                numShortcuts = _Shortcut(parabolicpath, parameters->_nMaxIterations, this, parameters->_fStepLength*0.99);
+                numShortcuts = -2;
+                if( parameters->nshortcutthreads > 1 ) {
+                    if( _bmanipconstraints ) {
+                        RAVELOG_DEBUG_FORMAT("env=%d, manipulator constraints are not supported by the parallel shortcutting, so checking one shortcut at a time", _environmentid);
+                    }
+                    else {
+                        numShortcuts = _ShortcutParallel(parabolicpath, parameters->_nMaxIterations, this, parameters->_fStepLength*0.99, parameters->nshortcutthreads);
+                    }
+                }
+                if( numShortcuts == -2 ) {
+                    numShortcuts = _Shortcut(parabolicpath, parameters->_nMaxIterations, this, parameters->_fStepLength*0.99);
+                }
 #ifdef SMOOTHER2_TIMING_DEBUG
                 _tShortcutEnd = utils::GetMicroTime();
 #endif
@@ -1347,6 +1367,38 @@ protected:
         dReal rightneighbor; // the first switch time to the right of this zero-velocity point
     };
 
+    /// \brief a smoother on its own clone of the environment that checks shortcut candidates for _ShortcutParallel
+    struct ShortcutWorker
+    {
+        EnvironmentBasePtr penv; ///< clone of the planner environment
+        boost::shared_ptr<ParabolicSmoother2> smoother; ///< smoother created in penv, only used for its feasibility checking
+        boost::shared_ptr<boost::thread> pthread; ///< runs _ShortcutWorkerThread until the workers are destroyed
+    };
+
+    /// \brief the candidates that the shortcut workers are checking, protected by _mutexShortcutBatch
+    struct ShortcutBatch
+    {
+        ShortcutBatch() : pparabolicpath(NULL), minTimeStep(0), fStartTimeVelMult(1), fStartTimeAccelMult(1), numcandidates(0), nextcandidate(0), numremaining(0) {
+        }
+        const RampOptimizer::ParabolicPath* pparabolicpath;
+        dReal minTimeStep, fStartTimeVelMult, fStartTimeAccelMult;
+        size_t numcandidates; // number of candidates in _vShortcutCandidates
+        size_t nextcandidate; // index of the next candidate that a worker takes
+        size_t numremaining;  // number of candidates that are not checked yet
+    };
+
+    /// \brief a shortcut from t0 to t1 checked by a ShortcutWorker
+    struct ShortcutCandidate
+    {
+        ShortcutCandidate() : t0(0), t1(0), retcode(-1), fTimeSaved(0), fVelMult(1), fAccelMult(1) {
+        }
+        dReal t0, t1;
+        int retcode;       // 0 if the shortcut passed all the constraints
+        dReal fTimeSaved;  // t1 - t0 minus the duration of the shortcut
+        dReal fVelMult, fAccelMult; // multipliers of the vel/accel limits the shortcut passed with
+        std::vector<RampOptimizer::RampND> vrampnds; // the checked shortcut
+    };
+
     /// \brief Time-parameterize the ordered set of waypoints to a trajectory that stops at every
     /// waypoint. _SetMilestones also adds some extra waypoints to the original set if any two
     /// consecutive waypoints are too far apart.
@@ -3270,6 +3322,485 @@ protected:
         return numShortcuts;
     }
 
+    /// \brief shortcuts like _Shortcut, but samples the (t0, t1) pairs of SMOOTHER2_SHORTCUT_BATCH_SIZE iterations at a
+    /// time and checks them in parallel on numworkers workers, each with its own clone of the environment. From every
+    /// batch, the feasible shortcuts that save the most time and do not overlap each other are applied. The candidates are
+    /// sampled and chosen in the calling thread and the batches do not depend on the number of workers, so the result for
+    /// a given seed is the same for any number of workers.
+    ///
+    /// \return the number of shortcuts applied, -1 if interrupted, -2 if the shortcuts cannot be checked in parallel
+    int _ShortcutParallel(RampOptimizer::ParabolicPath& parabolicpath, int numIters, RampOptimizer::RandomNumberGeneratorBase* rng, dReal minTimeStep, int numworkers)
+    {
+        if( !_InitShortcutWorkers(min(numworkers, SMOOTHER2_SHORTCUT_BATCH_SIZE)) ) {
+            return -2;
+        }
+        uint32_t basetime = utils::GetMicroTime();
+        int numShortcuts = 0;
+        const dReal tOriginal = parabolicpath.GetDuration();
+        dReal tTotal = tOriginal;
+
+        dReal fiSearchVelAccelMult = 1.0/_parameters->fSearchVelAccelMult;
+        dReal fStartTimeVelMult = 1.0, fStartTimeAccelMult = 1.0;
+
+        size_t nItersFromPrevSuccessful = 0;
+        size_t nCutoffIters = std::max(_parameters->nshortcutcycles, min(100, numIters/2));
+        dReal score = 1.0, currentBestScore = 1.0, iCurrentBestScore = 1.0;
+        dReal cutoffRatio = _parameters->durationImprovementCutoffRatio;
+        dReal specialShortcutWeight = 0.1, specialShortcutCutoffTime = 0.75;
+
+        dReal fiMinDiscretization = 4.0/(minTimeStep);
+        std::vector<uint8_t>& vVisitedDiscretization = _vVisitedDiscretizationCache;
+        vVisitedDiscretization.clear();
+        int nEndTimeDiscretization = 0;
+
+        std::vector<ShortcutCandidate>& vcandidates = _vShortcutCandidates;
+        vcandidates.resize(SMOOTHER2_SHORTCUT_BATCH_SIZE);
+        std::vector<size_t> vaccepted;
+        int iters = 0, numbatches = 0;
+        while( iters < numIters ) {
+            if( tTotal < minTimeStep || nItersFromPrevSuccessful > nCutoffIters ) {
+                break;
+            }
+
+            // Sample the candidates of this batch in the same way as _Shortcut
+            size_t numcandidates = 0;
+            for (; iters < numIters && numcandidates < vcandidates.size(); ++iters) {
+                nItersFromPrevSuccessful += 1;
+                dReal t0, t1;
+                if( iters == 0 ) {
+                    t0 = 0;
+                    t1 = tTotal;
+                }
+                else if( (_vZeroVelPointInfos.size() > 0 && rng->Rand() <= specialShortcutWeight) || (numIters - iters <= (int)_vZeroVelPointInfos.size()) ) {
+                    size_t index = _uniformsampler->SampleSequenceOneUInt32()%_vZeroVelPointInfos.size();
+                    dReal t = _vZeroVelPointInfos[index].point;
+                    t0 = t - rng->Rand()*min(specialShortcutCutoffTime, t);
+                    t1 = t + rng->Rand()*min(specialShortcutCutoffTime, tTotal - t);
+                    if( numIters - iters <= (int)_vZeroVelPointInfos.size() ) {
+                        fStartTimeVelMult = max(0.8, fStartTimeVelMult);
+                        fStartTimeAccelMult = max(0.8, fStartTimeAccelMult);
+                    }
+                }
+                else {
+                    t0 = rng->Rand()*tTotal;
+                    t1 = rng->Rand()*tTotal;
+                    if( t0 > t1 ) {
+                        RampOptimizer::Swap(t0, t1);
+                    }
+                }
+                if( t1 - t0 < minTimeStep ) {
+                    continue;
+                }
+#ifndef SMOOTHER2_DISABLE_VVISITEDDISCRETIZATION
+                if( vVisitedDiscretization.size() == 0 ) {
+                    nEndTimeDiscretization = (int)(tTotal*fiMinDiscretization)+1;
+                    if( nEndTimeDiscretization <= 0x1000 ) {
+                        vVisitedDiscretization.resize(nEndTimeDiscretization*nEndTimeDiscretization,0);
+                    }
+                }
+                size_t testPairIndex = (int)(t0*fiMinDiscretization)*nEndTimeDiscretization + (int)(t1*fiMinDiscretization);
+                if( testPairIndex < vVisitedDiscretization.size() ) {
+                    if( vVisitedDiscretization[testPairIndex] ) {
+                        continue;
+                    }
+                    vVisitedDiscretization[testPairIndex] = 1;
+                }
+#endif
+                ShortcutCandidate& candidate = vcandidates[numcandidates++];
+                candidate.t0 = t0;
+                candidate.t1 = t1;
+                candidate.retcode = -1;
+                candidate.vrampnds.resize(0);
+            }
+            if( numcandidates == 0 ) {
+                continue;
+            }
+
+            ++numbatches;
+            _progress._iteration += numcandidates;
+            _CheckShortcutBatch(parabolicpath, minTimeStep, fStartTimeVelMult, fStartTimeAccelMult, numcandidates);
+            if( _CallCallbacks(_progress) == PA_Interrupt ) {
+                return -1;
+            }
+
+            // Choose the feasible shortcuts that save the most time and do not overlap, ties go to the earlier sampled one
+            vaccepted.resize(0);
+            while( true ) {
+                size_t ibest = numcandidates;
+                for (size_t icandidate = 0; icandidate < numcandidates; ++icandidate) {
+                    const ShortcutCandidate& candidate = vcandidates[icandidate];
+                    if( candidate.retcode != 0 || candidate.vrampnds.size() == 0 || std::find(vaccepted.begin(), vaccepted.end(), icandidate) != vaccepted.end() ) {
+                        continue;
+                    }
+                    bool bOverlaps = false;
+                    FOREACHC(itaccepted, vaccepted) {
+                        if( candidate.t0 < vcandidates[*itaccepted].t1 && vcandidates[*itaccepted].t0 < candidate.t1 ) {
+                            bOverlaps = true;
+                            break;
+                        }
+                    }
+                    if( !bOverlaps && (ibest == numcandidates || candidate.fTimeSaved > vcandidates[ibest].fTimeSaved) ) {
+                        ibest = icandidate;
+                    }
+                }
+                if( ibest == numcandidates ) {
+                    break;
+                }
+                vaccepted.push_back(ibest);
+            }
+            if( vaccepted.size() == 0 ) {
+                continue;
+            }
+
+            // Replace the segments starting from the last one so that the times of the earlier ones stay valid
+            std::sort(vaccepted.begin(), vaccepted.end(), boost::bind(&ParabolicSmoother2::_CompareShortcutCandidateTimes, this, _2, _1));
+            dReal totaldiff = 0;
+            FOREACHC(itaccepted, vaccepted) {
+                const ShortcutCandidate& candidate = vcandidates[*itaccepted];
+                size_t writeIndex = 0;
+                for( size_t readIndex = 0; readIndex < _vZeroVelPointInfos.size(); ++readIndex ) {
+                    if( _vZeroVelPointInfos[readIndex].point <= candidate.t0 ) {
+                        writeIndex += 1;
+                    }
+                    else if( _vZeroVelPointInfos[readIndex].point > candidate.t1 ) {
+                        _vZeroVelPointInfos[writeIndex] = _vZeroVelPointInfos[readIndex];
+                        _vZeroVelPointInfos[writeIndex].point -= candidate.fTimeSaved;
+                        _vZeroVelPointInfos[writeIndex].leftneighbor -= candidate.fTimeSaved;
+                        _vZeroVelPointInfos[writeIndex].rightneighbor -= candidate.fTimeSaved;
+                        writeIndex += 1;
+                    }
+                }
+                _vZeroVelPointInfos.resize(writeIndex);
+                parabolicpath.ReplaceSegment(candidate.t0, candidate.t1, candidate.vrampnds);
+                totaldiff += candidate.fTimeSaved;
+                fStartTimeVelMult = min(1.0, candidate.fVelMult * fiSearchVelAccelMult);
+                fStartTimeAccelMult = min(1.0, candidate.fAccelMult * fiSearchVelAccelMult);
+                ++numShortcuts;
+            }
+            vVisitedDiscretization.clear();
+            tTotal = parabolicpath.GetDuration();
+            RAVELOG_DEBUG_FORMAT("env=%d, shortcut iter=%d/%d, applied %d/%d shortcuts, tTotal=%.15e", _environmentid%iters%numIters%vaccepted.size()%numcandidates%tTotal);
+
+            score = totaldiff/nItersFromPrevSuccessful;
+            if( score > currentBestScore) {
+                currentBestScore = score;
+                iCurrentBestScore = 1.0/currentBestScore;
+            }
+            nItersFromPrevSuccessful = 0;
+            if( (score*iCurrentBestScore < cutoffRatio) && (numShortcuts > 5)) {
+                break;
+            }
+        }
+
+        RAVELOG_DEBUG_FORMAT("env=%d, finished parallel shortcutting at iter=%d with %d workers in %d batches, successful=%d, endTime: %.15e -> %.15e; diff = %.15e, took %fs", _environmentid%iters%numworkers%numbatches%numShortcuts%tOriginal%tTotal%(tOriginal - tTotal)%(1e-6*(utils::GetMicroTime() - basetime)));
+        return numShortcuts;
+    }
+
+    bool _CompareShortcutCandidateTimes(size_t icandidate0, size_t icandidate1) const
+    {
+        return _vShortcutCandidates[icandidate0].t0 < _vShortcutCandidates[icandidate1].t0;
+    }
+
+    /// \brief true if the functions of the parameters that the shortcut checks call are the ones that
+    /// PlannerParameters::SetRobotActiveJoints or SetConfigurationSpecification create, so that the workers can create
+    /// them again in their environments. Custom functions are bound to the bodies of this environment, so only the
+    /// serial shortcutting can call them.
+    bool _HasDefaultShortcutFunctions()
+    {
+        PlannerParametersPtr pspecparameters(new PlannerParameters()), probotparameters(new PlannerParameters());
+        try {
+            pspecparameters->SetConfigurationSpecification(GetEnv(), _parameters->_configurationspecification);
+            std::vector<KinBodyPtr> vusedbodies;
+            _parameters->_configurationspecification.ExtractUsedBodies(GetEnv(), vusedbodies);
+            if( vusedbodies.size() == 1 && vusedbodies[0]->IsRobot() ) {
+                probotparameters->SetRobotActiveJoints(RaveInterfaceCast<RobotBase>(vusedbodies[0]));
+            }
+        }
+        catch(const std::exception& ex) {
+            RAVELOG_DEBUG_FORMAT("env=%d, cannot create the default functions of the configuration: %s", _environmentid%ex.what());
+            return false;
+        }
+        return _IsDefaultFunction(_parameters->_setstatevaluesfn, pspecparameters->_setstatevaluesfn, probotparameters->_setstatevaluesfn)
+               && _IsDefaultFunction(_parameters->_getstatefn, pspecparameters->_getstatefn, probotparameters->_getstatefn)
+               && _IsDefaultFunction(_parameters->_neighstatefn, pspecparameters->_neighstatefn, probotparameters->_neighstatefn)
+               && _IsDefaultFunction(_parameters->_checkpathvelocityconstraintsfn, pspecparameters->_checkpathvelocityconstraintsfn, probotparameters->_checkpathvelocityconstraintsfn);
+    }
+
+    /// \brief true if fn is not set or has the type of one of the default functions
+    template <typename Fn>
+    static bool _IsDefaultFunction(const Fn& fn, const Fn& fndefault0, const Fn& fndefault1)
+    {
+        if( !fn ) {
+            return true;
+        }
+        return (!!fndefault0 && fn.target_type() == fndefault0.target_type()) || (!!fndefault1 && fn.target_type() == fndefault1.target_type());
+    }
+
+    /// \brief clones the environment into the shortcut workers, initializes their smoothers with the parameters and starts
+    /// their threads
+    bool _InitShortcutWorkers(int numworkers)
+    {
+        if( !_HasDefaultShortcutFunctions() ) {
+            RAVELOG_DEBUG_FORMAT("env=%d, the parameters have custom state or constraint functions that the shortcut workers cannot call, so checking one shortcut at a time", _environmentid);
+            return false;
+        }
+        _DestroyShortcutWorkers(numworkers);
+        _vShortcutWorkers.resize(numworkers);
+        for (int iworker = 0; iworker < numworkers; ++iworker) {
+            ShortcutWorker& worker = _vShortcutWorkers[iworker];
+            // reuse the environments of the previous calls since cloning into them only updates the state of the bodies that changed
+            if( !worker.penv ) {
+                worker.penv = GetEnv()->CloneSelf(Clone_Bodies);
+            }
+            else {
+                worker.penv->Clone(GetEnv(), Clone_Bodies);
+            }
+
+            EnvironmentMutex::scoped_lock lockworker(worker.penv->GetMutex());
+            ConstraintTrajectoryTimingParametersPtr parameters(new ConstraintTrajectoryTimingParameters());
+            parameters->copy(_parameters);
+            try {
+                // rebind all the functions to the cloned environment, the limits are kept from the original parameters
+                parameters->SetConfigurationSpecification(worker.penv, _parameters->_configurationspecification);
+            }
+            catch(const std::exception& ex) {
+                RAVELOG_WARN_FORMAT("env=%d, failed to set the configuration of shortcut worker %d: %s", _environmentid%iworker%ex.what());
+                _DestroyShortcutWorkers(0);
+                return false;
+            }
+            parameters->_vConfigLowerLimit = _parameters->_vConfigLowerLimit;
+            parameters->_vConfigUpperLimit = _parameters->_vConfigUpperLimit;
+            parameters->_vConfigVelocityLimit = _parameters->_vConfigVelocityLimit;
+            parameters->_vConfigAccelerationLimit = _parameters->_vConfigAccelerationLimit;
+            parameters->_vConfigResolution = _parameters->_vConfigResolution;
+            if( !_parameters->_neighstatefn ) {
+                parameters->_neighstatefn.clear();
+            }
+            if( !_parameters->_checkpathvelocityconstraintsfn ) {
+                parameters->_checkpathvelocityconstraintsfn.clear();
+            }
+            parameters->nshortcutthreads = 0;
+            parameters->_sPostProcessingPlanner.clear();
+            parameters->_sPostProcessingParameters.clear();
+
+            if( !worker.smoother ) {
+                worker.smoother = boost::dynamic_pointer_cast<ParabolicSmoother2>(RaveCreatePlanner(worker.penv, GetXMLId()));
+            }
+            if( !worker.smoother || !worker.smoother->InitPlan(RobotBasePtr(), parameters) ) {
+                RAVELOG_WARN_FORMAT("env=%d, failed to initialize shortcut worker %d", _environmentid%iworker);
+                _DestroyShortcutWorkers(0);
+                return false;
+            }
+            worker.smoother->_bUsePerturbation = _bUsePerturbation;
+            worker.smoother->_feasibilitychecker.tol = _feasibilitychecker.tol;
+        }
+        for (int iworker = 0; iworker < numworkers; ++iworker) {
+            _vShortcutWorkers[iworker].pthread.reset(new boost::thread(boost::bind(&ParabolicSmoother2::_ShortcutWorkerThread, this, iworker)));
+        }
+        return true;
+    }
+
+    /// \brief stops the threads of all shortcut workers and destroys the cloned environments starting at index numkeep
+    void _DestroyShortcutWorkers(size_t numkeep)
+    {
+        {
+            boost::mutex::scoped_lock lock(_mutexShortcutBatch);
+            _bStopShortcutWorkers = true;
+            _condShortcutBatch.notify_all();
+        }
+        FOREACH(itworker, _vShortcutWorkers) {
+            if( !!itworker->pthread ) {
+                itworker->pthread->join();
+                itworker->pthread.reset();
+            }
+        }
+        _bStopShortcutWorkers = false;
+        _shortcutbatch = ShortcutBatch();
+
+        for (size_t iworker = numkeep; iworker < _vShortcutWorkers.size(); ++iworker) {
+            ShortcutWorker& worker = _vShortcutWorkers[iworker];
+            worker.smoother.reset();
+            if( !!worker.penv ) {
+                worker.penv->Destroy();
+                worker.penv.reset();
+            }
+        }
+        if( _vShortcutWorkers.size() > numkeep ) {
+            _vShortcutWorkers.resize(numkeep);
+        }
+    }
+
+    /// \brief has the worker threads check the first numcandidates candidates of _vShortcutCandidates, returns when all of
+    /// them are checked
+    void _CheckShortcutBatch(const RampOptimizer::ParabolicPath& parabolicpath, dReal minTimeStep, dReal fStartTimeVelMult, dReal fStartTimeAccelMult, size_t numcandidates)
+    {
+        boost::mutex::scoped_lock lock(_mutexShortcutBatch);
+        _shortcutbatch.pparabolicpath = &parabolicpath;
+        _shortcutbatch.minTimeStep = minTimeStep;
+        _shortcutbatch.fStartTimeVelMult = fStartTimeVelMult;
+        _shortcutbatch.fStartTimeAccelMult = fStartTimeAccelMult;
+        _shortcutbatch.numcandidates = numcandidates;
+        _shortcutbatch.nextcandidate = 0;
+        _shortcutbatch.numremaining = numcandidates;
+        _condShortcutBatch.notify_all();
+        while( _shortcutbatch.numremaining > 0 ) {
+            _condShortcutBatchDone.wait(lock);
+        }
+    }
+
+    /// \brief thread of shortcut worker iworker, checks the candidates of the batches one at a time until the workers are
+    /// destroyed. Which worker checks a candidate does not change its result since all the environments are the same.
+    void _ShortcutWorkerThread(size_t iworker)
+    {
+        boost::mutex::scoped_lock lock(_mutexShortcutBatch);
+        while( true ) {
+            while( !_bStopShortcutWorkers && _shortcutbatch.nextcandidate >= _shortcutbatch.numcandidates ) {
+                _condShortcutBatch.wait(lock);
+            }
+            if( _bStopShortcutWorkers ) {
+                return;
+            }
+            const size_t icandidate = _shortcutbatch.nextcandidate++;
+            const ShortcutBatch batch = _shortcutbatch;
+            lock.unlock();
+
+            ShortcutCandidate& candidate = _vShortcutCandidates.at(icandidate);
+            try {
+                _vShortcutWorkers.at(iworker).smoother->_CheckShortcutCandidate(*batch.pparabolicpath, batch.minTimeStep, batch.fStartTimeVelMult, batch.fStartTimeAccelMult, candidate);
+            }
+            catch (const std::exception& ex) {
+                RAVELOG_WARN_FORMAT("env=%d, shortcut worker %d failed to check t0=%.15e, t1=%.15e: %s", _environmentid%iworker%candidate.t0%candidate.t1%ex.what());
+                candidate.retcode = -1;
+            }
+
+            lock.lock();
+            if( --_shortcutbatch.numremaining == 0 ) {
+                _condShortcutBatchDone.notify_all();
+            }
+        }
+    }
+
+    /// \brief checks one shortcut iteration of _Shortcut from candidate.t0 to candidate.t1 in the environment of this
+    /// smoother, including the slow downs for time-based constraints. Manipulator constraints are not supported.
+    void _CheckShortcutCandidate(const RampOptimizer::ParabolicPath& parabolicpath, dReal minTimeStep, dReal fStartTimeVelMult, dReal fStartTimeAccelMult, ShortcutCandidate& candidate)
+    {
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        const std::vector<RampOptimizer::RampND>& rampndVect = parabolicpath.GetRampNDVect();
+        std::vector<RampOptimizer::RampND>& shortcutRampNDVect = _cacheRampNDVect, &shortcutRampNDVectOut = candidate.vrampnds, &shortcutRampNDVectOut1 = _cacheRampNDVectOut1;
+        std::vector<dReal>& x0Vect = _cacheX0Vect, &x1Vect = _cacheX1Vect, &v0Vect = _cacheV0Vect, &v1Vect = _cacheV1Vect;
+        std::vector<dReal>& vellimits = _cacheVellimits, &accellimits = _cacheAccelLimits;
+        const dReal t0 = candidate.t0, t1 = candidate.t1;
+        candidate.retcode = CFO_StateSettingError;
+
+        int i0, i1;
+        dReal u0, u1;
+        parabolicpath.FindRampNDIndex(t0, i0, u0);
+        parabolicpath.FindRampNDIndex(t1, i1, u1);
+        rampndVect[i0].EvalPos(u0, x0Vect);
+        if( _parameters->SetStateValues(x0Vect) != 0 ) {
+            return;
+        }
+        _parameters->_getstatefn(x0Vect);
+        rampndVect[i1].EvalPos(u1, x1Vect);
+        if( _parameters->SetStateValues(x1Vect) != 0 ) {
+            return;
+        }
+        _parameters->_getstatefn(x1Vect);
+        rampndVect[i0].EvalVel(u0, v0Vect);
+        rampndVect[i1].EvalVel(u1, v1Vect);
+
+        vellimits = _parameters->_vConfigVelocityLimit;
+        accellimits = _parameters->_vConfigAccelerationLimit;
+        for (size_t j = 0; j < _parameters->_vConfigVelocityLimit.size(); ++j) {
+            dReal fminvel = max(RaveFabs(v0Vect[j]), RaveFabs(v1Vect[j]));
+            vellimits[j] = min(vellimits[j], max(fminvel, fStartTimeVelMult * _parameters->_vConfigVelocityLimit[j]));
+            accellimits[j] = min(accellimits[j], fStartTimeAccelMult * _parameters->_vConfigAccelerationLimit[j]);
+        }
+
+        dReal fCurVelMult = fStartTimeVelMult, fCurAccelMult = fStartTimeAccelMult;
+        for (size_t iSlowDown = 0; iSlowDown < 100; ++iSlowDown) {
+            candidate.retcode = CFO_FinalValuesNotReached;
+            if( !_interpolator.ComputeArbitraryVelNDTrajectory(x0Vect, x1Vect, v0Vect, v1Vect, _parameters->_vConfigLowerLimit, _parameters->_vConfigUpperLimit, vellimits, accellimits, shortcutRampNDVect, true) ) {
+                return;
+            }
+            dReal segmentTime = 0;
+            FOREACHC(itrampnd, shortcutRampNDVect) {
+                segmentTime += itrampnd->GetDuration();
+            }
+            if( segmentTime + minTimeStep > t1 - t0 ) {
+                return;
+            }
+
+            if( _parameters->SetStateValues(x1Vect) != 0 ) {
+                candidate.retcode = CFO_StateSettingError;
+                return;
+            }
+            _parameters->_getstatefn(x1Vect);
+            RampOptimizer::CheckReturn retcheck = _feasibilitychecker.Check2(shortcutRampNDVect, 0xffff, shortcutRampNDVectOut);
+            if( retcheck.retcode == 0 && retcheck.bDifferentVelocity && shortcutRampNDVectOut.size() > 0 ) {
+                // Check2 modified the shortcut so that it does not end with v1, fix the last segment like _Shortcut does
+                for (size_t irampnd = 0; irampnd < shortcutRampNDVectOut.size(); ++irampnd) {
+                    for (size_t jdof = 0; jdof < shortcutRampNDVectOut[irampnd].GetDOF(); ++jdof) {
+                        dReal fminvel = max(RaveFabs(shortcutRampNDVectOut[irampnd].GetV0At(jdof)), RaveFabs(shortcutRampNDVectOut[irampnd].GetV1At(jdof)));
+                        if( vellimits[jdof] < fminvel ) {
+                            vellimits[jdof] = fminvel;
+                        }
+                    }
+                }
+                dReal allowedStretchTime = (t1 - t0) - (segmentTime + minTimeStep);
+                shortcutRampNDVectOut.back().GetX0Vect(x0Vect);
+                shortcutRampNDVectOut.back().GetV0Vect(v0Vect);
+                if( !_interpolator.ComputeArbitraryVelNDTrajectory(x0Vect, x1Vect, v0Vect, v1Vect, _parameters->_vConfigLowerLimit, _parameters->_vConfigUpperLimit, vellimits, accellimits, shortcutRampNDVect, true) ) {
+                    return;
+                }
+                dReal lastSegmentTime = 0;
+                FOREACHC(itrampnd, shortcutRampNDVect) {
+                    lastSegmentTime += itrampnd->GetDuration();
+                }
+                if( lastSegmentTime - shortcutRampNDVectOut.back().GetDuration() > allowedStretchTime ) {
+                    return;
+                }
+                retcheck = _feasibilitychecker.Check2(shortcutRampNDVect, 0xffff, shortcutRampNDVectOut1);
+                if( retcheck.retcode != 0 ) {
+                    candidate.retcode = retcheck.retcode;
+                    return;
+                }
+                if( retcheck.bDifferentVelocity ) {
+                    return;
+                }
+                shortcutRampNDVectOut.pop_back();
+                shortcutRampNDVectOut.insert(shortcutRampNDVectOut.end(), shortcutRampNDVectOut1.begin(), shortcutRampNDVectOut1.end());
+            }
+
+            candidate.retcode = retcheck.retcode;
+            if( retcheck.retcode == 0 ) {
+                segmentTime = 0;
+                FOREACHC(itrampnd, shortcutRampNDVectOut) {
+                    segmentTime += itrampnd->GetDuration();
+                }
+                candidate.fTimeSaved = (t1 - t0) - segmentTime;
+                candidate.fVelMult = fCurVelMult;
+                candidate.fAccelMult = fCurAccelMult;
+                return;
+            }
+            if( retcheck.retcode != CFO_CheckTimeBasedConstraints ) {
+                return;
+            }
+
+            // Scale down vellimits and accellimits using the normal procedure
+            fCurVelMult *= retcheck.fTimeBasedSurpassMult;
+            fCurAccelMult *= retcheck.fTimeBasedSurpassMult*retcheck.fTimeBasedSurpassMult;
+            if( fCurVelMult < 0.01 || fCurAccelMult < 0.0001 ) {
+                return;
+            }
+            for (size_t j = 0; j < vellimits.size(); ++j) {
+                dReal fMinVel =  max(RaveFabs(v0Vect[j]), RaveFabs(v1Vect[j]));
+                vellimits[j] = max(fMinVel, retcheck.fTimeBasedSurpassMult * vellimits[j]);
+                accellimits[j] *= retcheck.fTimeBasedSurpassMult*retcheck.fTimeBasedSurpassMult;
+            }
+        }
+    }
+
     void _DumpParabolicPath(RampOptimizer::ParabolicPath& parabolicpath, DebugLevel level=Level_Verbose, uint32_t fileindex=10000, int option=-1) const
     {
         if( !IS_DEBUGLEVEL(level) ) {
@@ -3388,6 +3919,15 @@ protected:
     // in _Shortcut
     std::vector<uint8_t> _vVisitedDiscretizationCache;
 
+    // in _ShortcutParallel
+    std::vector<ShortcutWorker> _vShortcutWorkers; ///< created when nshortcutthreads > 1, the environments are kept between calls
+    std::vector<ShortcutCandidate> _vShortcutCandidates; ///< the candidates of the current batch
+    ShortcutBatch _shortcutbatch; ///< the batch the worker threads are checking
+    boost::mutex _mutexShortcutBatch; ///< protects _shortcutbatch and _bStopShortcutWorkers
+    boost::condition_variable _condShortcutBatch; ///< notified when a batch starts or the workers have to stop
+    boost::condition_variable _condShortcutBatchDone; ///< notified when all the candidates of the batch are checked
+    bool _bStopShortcutWorkers; ///< if true, the worker threads exit
+
 #ifdef SMOOTHER2_TIMING_DEBUG
     // Statistics
     uint32_t _tShortcutStart, _tShortcutEnd;
@@ -0,0 +1,281 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 agent <agent@local>
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "openraveplugindefs.h"
+
+#include <atomic>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#define _(msgid) OpenRAVE::RaveGetLocalizedTextForDomain("openrave_plugins_rplanners", msgid)
+
+/// \brief runs several BiRRT planners on cloned environments in parallel, the first solution found is returned and the other planners are interrupted.
+class ParallelBirrtPlanner : public PlannerBase
+{
+    /// \brief a BiRRT planner on its own environment
+    struct Worker
+    {
+        EnvironmentBasePtr penv; ///< clone of the planner environment
+        PlannerBasePtr planner; ///< birrt planner created in penv
+        ParallelRRTParametersPtr parameters; ///< parameters bound to penv
+        TrajectoryBasePtr ptraj; ///< trajectory in penv the planner writes to
+        UserDataPtr callbackhandle; ///< handle of the callback that interrupts the planner
+        PlannerStatus status; ///< status of the last PlanPath
+    };
+
+public:
+    ParallelBirrtPlanner(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv), _nWinner(-1), _nNumFinished(0), _bStopWorkers(false), _nIterations(0)
+    {
+        __description = "\
+:Interface Author:  agent\n\n\
+Parallel Bi-directional RRTs. Runs several birrt planners in parallel, each in its own clone of the environment with its own collision checker and random seed. \
+The first solution found is returned and the other planners are interrupted. Takes ParallelRRTParameters, the number of planners is set by numthreads and their seeds by seedstrategy.\n\n\
+Custom functions of the parameters besides the ones set by PlannerParameters::SetConfigurationSpecification cannot be called from other environments, so they are ignored.\n\
+";
+    }
+
+    virtual ~ParallelBirrtPlanner() {
+        _DestroyWorkers(0);
+    }
+
+    virtual bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr pparams)
+    {
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        _parameters.reset(new ParallelRRTParameters());
+        _parameters->copy(pparams);
+        _robot = pbase;
+        return _InitPlan();
+    }
+
+    virtual bool InitPlan(RobotBasePtr pbase, std::istream& isParameters)
+    {
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        _parameters.reset(new ParallelRRTParameters());
+        isParameters >> *_parameters;
+        _robot = pbase;
+        return _InitPlan();
+    }
+
+    virtual PlannerStatus PlanPath(TrajectoryBasePtr ptraj, int planningoptions) override
+    {
+        if( !_parameters || _vworkers.size() == 0 ) {
+            return PlannerStatus("ParallelBirrtPlanner::PlanPath - Error, planner not initialized\n", PS_Failed);
+        }
+
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        uint32_t basetime = utils::GetMilliTime();
+
+        _nWinner = -1;
+        _nNumFinished = 0;
+        _bStopWorkers = false;
+        _nIterations = 0;
+        boost::thread_group workerthreads;
+        for(size_t iworker = 0; iworker < _vworkers.size(); ++iworker) {
+            workerthreads.create_thread(boost::bind(&ParallelBirrtPlanner::_WorkerThread, this, iworker));
+        }
+
+        // the callbacks of the user are only called from this thread
+        PlannerProgress progress;
+        PlannerAction callbackaction = PA_None;
+        {
+            boost::mutex::scoped_lock lockfinished(_mutexFinished);
+            while( _nNumFinished < _vworkers.size() && _nWinner < 0 ) {
+                progress._iteration = _nIterations.load();
+                lockfinished.unlock();
+                callbackaction = _CallCallbacks(progress);
+                lockfinished.lock();
+                if( callbackaction == PA_Interrupt ) {
+                    break;
+                }
+                _condFinished.timed_wait(lockfinished, boost::posix_time::milliseconds(10));
+            }
+        }
+        _bStopWorkers = true;
+        workerthreads.join_all();
+
+        if( callbackaction == PA_Interrupt && _nWinner < 0 ) {
+            return PlannerStatus("Planning was interrupted", PS_Interrupted);
+        }
+
+        if( _nWinner < 0 ) {
+            std::string description = str(boost::format(_("env=%d, plan failed in %fs with %d workers, iter=%d, nMaxIterations=%d"))%GetEnv()->GetId()%(0.001f*(float)(utils::GetMilliTime()-basetime))%_vworkers.size()%_nIterations.load()%_parameters->_nMaxIterations);
+            RAVELOG_WARN(description);
+            return PlannerStatus(description, PS_Failed);
+        }
+
+        Worker& winner = _vworkers.at(_nWinner);
+        std::vector<dReal> vdata;
+        winner.ptraj->GetWaypoints(0, winner.ptraj->GetNumWaypoints(), vdata, _parameters->_configurationspecification);
+        if( ptraj->GetConfigurationSpecification().GetDOF() == 0 ) {
+            ptraj->Init(_parameters->_configurationspecification);
+        }
+        ptraj->Insert(ptraj->GetNumWaypoints(), vdata, _parameters->_configurationspecification);
+        std::string description = str(boost::format(_("env=%d, plan success by worker %d/%d, iters=%d, path=%d points, computation time=%fs\n"))%GetEnv()->GetId()%_nWinner%_vworkers.size()%_nIterations.load()%ptraj->GetNumWaypoints()%(0.001f*(float)(utils::GetMilliTime()-basetime)));
+        RAVELOG_DEBUG(description);
+        PlannerStatus status = _ProcessPostPlanners(_robot,ptraj);
+        status.description = description;
+        return status;
+    }
+
+    virtual PlannerParametersConstPtr GetParameters() const {
+        return _parameters;
+    }
+
+protected:
+    bool _InitPlan()
+    {
+        int numthreads = _parameters->_nNumThreads;
+        if( numthreads <= 0 ) {
+            numthreads = max(1, (int)boost::thread::hardware_concurrency());
+        }
+        if( !!_parameters->_samplegoalfn || !!_parameters->_sampleinitialfn || !!_parameters->_costfn || !!_parameters->_goalfn ) {
+            RAVELOG_WARN_FORMAT("env=%d, custom goal/initial samplers and cost/goal functions cannot run in the cloned environments, so ignoring them", GetEnv()->GetId());
+        }
+
+        _DestroyWorkers(numthreads);
+        _vworkers.resize(numthreads);
+        uint32_t timeseed = utils::GetMicroTime();
+        for(int iworker = 0; iworker < numthreads; ++iworker) {
+            Worker& worker = _vworkers[iworker];
+            // reuse the environments of the previous calls since cloning into them only updates the state of the bodies that did not change
+            if( !worker.penv ) {
+                worker.penv = GetEnv()->CloneSelf(Clone_Bodies);
+            }
+            else {
+                worker.penv->Clone(GetEnv(), Clone_Bodies);
+            }
+
+            EnvironmentMutex::scoped_lock lockworker(worker.penv->GetMutex());
+            RobotBasePtr pworkerrobot;
+            if( !!_robot ) {
+                pworkerrobot = worker.penv->GetRobot(_robot->GetName());
+            }
+            worker.parameters.reset(new ParallelRRTParameters());
+            worker.parameters->copy(_parameters);
+            try {
+                // rebind all the functions to the cloned environment, the states are kept from the original parameters
+                worker.parameters->SetConfigurationSpecification(worker.penv, _parameters->_configurationspecification);
+            }
+            catch(const std::exception& ex) {
+                RAVELOG_WARN_FORMAT("env=%d, failed to set the configuration of worker %d: %s", GetEnv()->GetId()%iworker%ex.what());
+                _DestroyWorkers(iworker);
+                break;
+            }
+            worker.parameters->vinitialconfig = _parameters->vinitialconfig;
+            worker.parameters->_vInitialConfigVelocities = _parameters->_vInitialConfigVelocities;
+            worker.parameters->_vGoalConfigVelocities = _parameters->_vGoalConfigVelocities;
+            worker.parameters->_samplegoalfn.clear();
+            worker.parameters->_sampleinitialfn.clear();
+            worker.parameters->_costfn.clear();
+            worker.parameters->_goalfn.clear();
+            // post-processing is done once on the winning path
+            worker.parameters->_sPostProcessingPlanner.clear();
+            worker.parameters->_sPostProcessingParameters.clear();
+            if( _parameters->_nSeedStrategy == PSS_Time ) {
+                worker.parameters->_nRandomGeneratorSeed = timeseed + 0x9e3779b9*iworker;
+            }
+            else {
+                worker.parameters->_nRandomGeneratorSeed = _parameters->_nRandomGeneratorSeed + iworker;
+            }
+
+            if( !worker.planner ) {
+                worker.planner = RaveCreatePlanner(worker.penv, "birrt");
+                if( !worker.planner ) {
+                    RAVELOG_WARN_FORMAT("env=%d, failed to create birrt planner", GetEnv()->GetId());
+                    _DestroyWorkers(iworker);
+                    break;
+                }
+                worker.callbackhandle = worker.planner->RegisterPlanCallback(boost::bind(&ParallelBirrtPlanner::_WorkerCallback, this, _1));
+                worker.ptraj = RaveCreateTrajectory(worker.penv, "");
+            }
+            if( !worker.planner->InitPlan(pworkerrobot, worker.parameters) ) {
+                RAVELOG_WARN_FORMAT("env=%d, failed to initialize worker %d", GetEnv()->GetId()%iworker);
+                _DestroyWorkers(iworker);
+                break;
+            }
+        }
+
+        if( _vworkers.size() == 0 ) {
+            _parameters.reset();
+            return false;
+        }
+        RAVELOG_DEBUG_FORMAT("env=%d, ParallelBiRRT Planner Initialized with %d workers, step=%f", GetEnv()->GetId()%_vworkers.size()%_parameters->_fStepLength);
+        return true;
+    }
+
+    /// \brief destroys the cloned environments of all workers starting at index numkeep
+    void _DestroyWorkers(size_t numkeep)
+    {
+        for(size_t iworker = numkeep; iworker < _vworkers.size(); ++iworker) {
+            Worker& worker = _vworkers[iworker];
+            worker.callbackhandle.reset();
+            worker.planner.reset();
+            worker.ptraj.reset();
+            worker.parameters.reset();
+            if( !!worker.penv ) {
+                worker.penv->Destroy();
+                worker.penv.reset();
+            }
+        }
+        if( _vworkers.size() > numkeep ) {
+            _vworkers.resize(numkeep);
+        }
+    }
+
+    void _WorkerThread(size_t iworker)
+    {
+        Worker& worker = _vworkers.at(iworker);
+        try {
+            worker.ptraj->Init(worker.parameters->_configurationspecification);
+            worker.status = worker.planner->PlanPath(worker.ptraj);
+        }
+        catch(const std::exception& ex) {
+            RAVELOG_WARN_FORMAT("env=%d, worker %d failed: %s", GetEnv()->GetId()%iworker%ex.what());
+            worker.status = PlannerStatus(ex.what(), PS_Failed);
+        }
+
+        boost::mutex::scoped_lock lockfinished(_mutexFinished);
+        if( (worker.status.GetStatusCode() & PS_HasSolution) && _nWinner < 0 ) {
+            _nWinner = iworker;
+            _bStopWorkers = true;
+        }
+        ++_nNumFinished;
+        _condFinished.notify_all();
+    }
+
+    PlannerAction _WorkerCallback(const PlannerProgress& progress)
+    {
+        ++_nIterations;
+        return _bStopWorkers ? PA_Interrupt : PA_None;
+    }
+
+    ParallelRRTParametersPtr _parameters;
+    RobotBasePtr _robot;
+    std::vector<Worker> _vworkers;
+
+    boost::mutex _mutexFinished; ///< protects _nWinner and _nNumFinished
+    boost::condition_variable _condFinished; ///< notified every time a worker finishes
+    int _nWinner; ///< index of the worker whose path is returned, -1 if none
+    size_t _nNumFinished; ///< number of workers whose PlanPath returned
+    std::atomic<bool> _bStopWorkers; ///< if true, the callbacks of the workers interrupt their planners
+    std::atomic<int> _nIterations; ///< sum of the iterations of all the workers
+};
+
+PlannerBasePtr CreateParallelBirrtPlanner(EnvironmentBasePtr penv, std::istream& sinput)
+{
+    return PlannerBasePtr(new ParallelBirrtPlanner(penv, sinput));
+}
@@ -21,6 +21,11 @@
 
 #include <boost/pool/pool.hpp>
 
+#if defined(__AVX__) && OPENRAVE_PRECISION
+#include <immintrin.h>
+#define RPLANNERS_USE_AVX
+#endif
+
 #define _(msgid) OpenRAVE::RaveGetLocalizedTextForDomain("openrave_plugins_rplanners", msgid)
 
 enum ExtendType {
@@ -80,6 +85,7 @@ class SimpleNode : public NodeBase
 public:
     SimpleNode(SimpleNode* parent, const vector<dReal>& config) : rrtparent(parent) {
         std::copy(config.begin(), config.end(), q);
+        _levelindex = 0;
         _level = 0;
         _hasselfchild = 0;
         _usenn = 1;
@@ -87,6 +93,7 @@ public:
     }
     SimpleNode(SimpleNode* parent, const dReal* pconfig, int dof) : rrtparent(parent) {
         std::copy(pconfig, pconfig+dof, q);
+        _levelindex = 0;
         _level = 0;
         _hasselfchild = 0;
         _usenn = 1;
@@ -97,6 +104,7 @@ public:
 
     SimpleNode* rrtparent; ///< pointer to the RRT tree parent
     std::vector<SimpleNode*> _vchildren; ///< cache tree direct children of this node (for the next cache level down). Has nothing to do with the RRT tree.
+    uint32_t _levelindex; ///< index of the node in the vector of SpatialTree::_vvLevelNodes that holds it
     int16_t _level; ///< the level the node belongs to
     uint8_t _hasselfchild; ///< if 1, then _vchildren has contains a clone of this node in the level below it.
     uint8_t _usenn; ///< if 1, then use part of the nearest neighbor search, otherwise ignore
@@ -108,6 +116,37 @@ public:
     dReal q[0]; // the configuration immediately follows the struct
 };
 
+/// \brief allocator for boost::pool that aligns the memory blocks on cache lines
+struct CacheAlignedPoolAllocator
+{
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    static const size_type ALIGNMENT = 64;
+
+    static char* malloc(const size_type bytes)
+    {
+#ifdef _WIN32
+        return static_cast<char*>(_aligned_malloc(bytes, ALIGNMENT));
+#else
+        void* pmemory = NULL;
+        if( posix_memalign(&pmemory, ALIGNMENT, bytes) != 0 ) {
+            return NULL;
+        }
+        return static_cast<char*>(pmemory);
+#endif
+    }
+
+    static void free(char* const block)
+    {
+#ifdef _WIN32
+        _aligned_free(block);
+#else
+        ::free(block);
+#endif
+    }
+};
+
 class SpatialTreeBase
 {
 public:
@@ -148,6 +187,8 @@ public:
 
     SpatialTree(int fromgoal) {
         _fromgoal = fromgoal;
+        _bEnableFastDistanceMetric = true;
+        _bFastDistanceMetric = false;
         _fStepLength = 0.04f;
         _dof = 0;
         _numnodes = 0;
@@ -174,13 +215,14 @@ public:
                 _pNodesPool.reset();
             }
         }
-        if( !_pNodesPool ) {
-            _pNodesPool.reset(new boost::pool<>(sizeof(Node)+dof*sizeof(dReal)));
-        }
         _planner = planner;
         _distmetricfn = distmetricfn;
         _fStepLength = fStepLength;
         _dof = dof;
+        if( !_pNodesPool ) {
+            _pNodesPool.reset(new NodesPool(_GetNodeSize()));
+        }
+        _InitFastDistanceMetric();
         _vNewConfig.resize(dof);
         _vDeltaConfig.resize(dof);
         _vTempConfig.resize(dof);
@@ -190,8 +232,8 @@ public:
         _minlevel = _maxlevel - 1;
         _fMaxLevelBound = RavePow(_base, _maxlevel);
         int enclevel = _EncodeLevel(_maxlevel);
-        if( enclevel >= (int)_vsetLevelNodes.size() ) {
-            _vsetLevelNodes.resize(enclevel+1);
+        if( enclevel >= (int)_vvLevelNodes.size() ) {
+            _vvLevelNodes.resize(enclevel+1);
         }
         _constraintreturn.reset(new ConstraintFilterReturn());
     }
@@ -200,35 +242,119 @@ public:
     {
         if( !!_pNodesPool ) {
             // make sure all children are deleted
-            for(size_t ilevel = 0; ilevel < _vsetLevelNodes.size(); ++ilevel) {
-                FOREACH(itnode, _vsetLevelNodes[ilevel]) {
+            for(size_t ilevel = 0; ilevel < _vvLevelNodes.size(); ++ilevel) {
+                FOREACH(itnode, _vvLevelNodes[ilevel]) {
                     (*itnode)->~Node();
                 }
             }
-            FOREACH(itchildren, _vsetLevelNodes) {
+            FOREACH(itchildren, _vvLevelNodes) {
                 itchildren->clear();
             }
             //_pNodesPool->purge_memory();
-            _pNodesPool.reset(new boost::pool<>(sizeof(Node)+_dof*sizeof(dReal)));
+            _pNodesPool.reset(new NodesPool(_GetNodeSize()));
         }
         _numnodes = 0;
     }
 
+    /// \brief if true (default), distances are computed without calling the distance metric function whenever it is detected to be a weighted euclidean metric
+    void SetEnableFastDistanceMetric(bool bEnable)
+    {
+        _bEnableFastDistanceMetric = bEnable;
+        _InitFastDistanceMetric();
+    }
+
+    /// \brief true if the distance metric was detected to be weighted euclidean and the distances are computed directly
+    bool IsFastDistanceMetric() const {
+        return _bFastDistanceMetric;
+    }
+
     inline dReal _ComputeDistance(const dReal* config0, const dReal* config1) const
     {
+        if( _bFastDistanceMetric ) {
+            return _ComputeWeightedEuclideanDistance(config0, config1);
+        }
         return _distmetricfn(VectorWrapper<dReal>(config0, config0+_dof), VectorWrapper<dReal>(config1, config1+_dof));
     }
 
     inline dReal _ComputeDistance(const dReal* config0, const std::vector<dReal>& config1) const
     {
+        if( _bFastDistanceMetric ) {
+            return _ComputeWeightedEuclideanDistance(config0, &config1[0]);
+        }
         return _distmetricfn(VectorWrapper<dReal>(config0,config0+_dof), config1);
     }
 
     inline dReal _ComputeDistance(NodePtr node0, NodePtr node1) const
     {
+        if( _bFastDistanceMetric ) {
+            return _ComputeWeightedEuclideanDistance(node0->q, node1->q);
+        }
         return _distmetricfn(VectorWrapper<dReal>(node0->q, &node0->q[_dof]), VectorWrapper<dReal>(node1->q, &node1->q[_dof]));
     }
 
+    inline dReal _ComputeWeightedEuclideanDistance(const dReal* config0, const dReal* config1) const
+    {
+        const dReal* pweights2 = &_vFastMetricWeights2[0];
+        dReal fdist2 = 0;
+        for(int idof = 0; idof < _dof; ++idof) {
+            dReal fdiff = config0[idof] - config1[idof];
+            fdist2 += pweights2[idof]*fdiff*fdiff;
+        }
+        return RaveSqrt(fdist2);
+    }
+
+    /// \brief computes the distances from the configurations of numnodes nodes to pquery
+    inline void _ComputeDistances(const NodePtr* pnodes, size_t numnodes, const dReal* pquery, dReal* pdists) const
+    {
+        if( !_bFastDistanceMetric ) {
+            VectorWrapper<dReal> vquery(pquery, pquery+_dof);
+            for(size_t inode = 0; inode < numnodes; ++inode) {
+                pdists[inode] = _distmetricfn(VectorWrapper<dReal>(pnodes[inode]->q, pnodes[inode]->q+_dof), vquery);
+            }
+            return;
+        }
+        size_t inode = 0;
+#ifdef RPLANNERS_USE_AVX
+        // blocks of four nodes, every node accumulates its weighted squared distance in its own register
+        const dReal* pweights2 = &_vFastMetricWeights2[0];
+        for(; inode+4 <= numnodes; inode += 4) {
+            const dReal* pconfig0 = pnodes[inode]->q, *pconfig1 = pnodes[inode+1]->q, *pconfig2 = pnodes[inode+2]->q, *pconfig3 = pnodes[inode+3]->q;
+            __m256d vsum0 = _mm256_setzero_pd(), vsum1 = _mm256_setzero_pd(), vsum2 = _mm256_setzero_pd(), vsum3 = _mm256_setzero_pd();
+            int idof = 0;
+            for(; idof+4 <= _dof; idof += 4) {
+                __m256d vquery = _mm256_loadu_pd(pquery+idof), vweights2 = _mm256_loadu_pd(pweights2+idof);
+                __m256d vdiff0 = _mm256_sub_pd(_mm256_loadu_pd(pconfig0+idof), vquery);
+                __m256d vdiff1 = _mm256_sub_pd(_mm256_loadu_pd(pconfig1+idof), vquery);
+                __m256d vdiff2 = _mm256_sub_pd(_mm256_loadu_pd(pconfig2+idof), vquery);
+                __m256d vdiff3 = _mm256_sub_pd(_mm256_loadu_pd(pconfig3+idof), vquery);
+                vsum0 = _mm256_add_pd(vsum0, _mm256_mul_pd(vweights2, _mm256_mul_pd(vdiff0, vdiff0)));
+                vsum1 = _mm256_add_pd(vsum1, _mm256_mul_pd(vweights2, _mm256_mul_pd(vdiff1, vdiff1)));
+                vsum2 = _mm256_add_pd(vsum2, _mm256_mul_pd(vweights2, _mm256_mul_pd(vdiff2, vdiff2)));
+                vsum3 = _mm256_add_pd(vsum3, _mm256_mul_pd(vweights2, _mm256_mul_pd(vdiff3, vdiff3)));
+            }
+            // reduce the four registers into [sum0, sum1, sum2, sum3]
+            __m256d vhadd01 = _mm256_hadd_pd(vsum0, vsum1), vhadd23 = _mm256_hadd_pd(vsum2, vsum3);
+            __m256d vsums = _mm256_add_pd(_mm256_permute2f128_pd(vhadd01, vhadd23, 0x21), _mm256_blend_pd(vhadd01, vhadd23, 0xc));
+            if( idof < _dof ) {
+                dReal sums[4];
+                _mm256_storeu_pd(sums, vsums);
+                for(; idof < _dof; ++idof) {
+                    dReal fdiff0 = pconfig0[idof] - pquery[idof], fdiff1 = pconfig1[idof] - pquery[idof], fdiff2 = pconfig2[idof] - pquery[idof], fdiff3 = pconfig3[idof] - pquery[idof];
+                    sums[0] += pweights2[idof]*fdiff0*fdiff0;
+                    sums[1] += pweights2[idof]*fdiff1*fdiff1;
+                    sums[2] += pweights2[idof]*fdiff2*fdiff2;
+                    sums[3] += pweights2[idof]*fdiff3*fdiff3;
+                }
+                vsums = _mm256_loadu_pd(sums);
+            }
+            _mm256_storeu_pd(pdists+inode, _mm256_sqrt_pd(vsums));
+        }
+#endif
+        for(; inode < numnodes; ++inode) {
+            pdists[inode] = _ComputeWeightedEuclideanDistance(pnodes[inode]->q, pquery);
+        }
+    }
+
     std::pair<NodeBasePtr, dReal> FindNearestNode(const std::vector<dReal>& vquerystate) const
     {
         return _FindNearestNode(vquerystate);
@@ -251,7 +377,7 @@ public:
         bool bchanged=true;
         while(bchanged) {
             bchanged=false;
-            FOREACHC(itchildren, _vsetLevelNodes) {
+            FOREACHC(itchildren, _vvLevelNodes) {
                 FOREACHC(itchild, *itchildren) {
                     if( _setchildcache.find(*itchild) == _setchildcache.end() && _setchildcache.find((*itchild)->rrtparent) != _setchildcache.end() ) {
                         (*itchild)->_usenn = 0;
@@ -281,7 +407,7 @@ public:
         bool bchanged=true;
         while(bchanged) {
             bchanged=false;
-            FOREACHC(itchildren, _vsetLevelNodes) {
+            FOREACHC(itchildren, _vvLevelNodes) {
                 FOREACHC(itchild, *itchildren) {
                     if( _setchildcache.find(*itchild) == _setchildcache.end() && _setchildcache.find((*itchild)->rrtparent) != _setchildcache.end() ) {
                         //if( !std::binary_search(_vchildcache.begin(),_vchildcache.end(),(*itchild)->rrtparent) ) {
@@ -478,7 +604,7 @@ public:
             return _numnodes==0;
         }
 
-        if( _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).size() != 1 ) {
+        if( _vvLevelNodes.at(_EncodeLevel(_maxlevel)).size() != 1 ) {
             RAVELOG_WARN("more than 1 root node\n");
             return false;
         }
@@ -489,12 +615,16 @@ public:
         size_t numnodes = 0;
         for(int currentlevel = _maxlevel; currentlevel >= _minlevel; --currentlevel, fLevelBound *= _fBaseInv ) {
             int enclevel = _EncodeLevel(currentlevel);
-            if( enclevel >= (int)_vsetLevelNodes.size() ) {
+            if( enclevel >= (int)_vvLevelNodes.size() ) {
                 continue;
             }
 
-            const std::set<NodePtr>& setLevelRawChildren = _vsetLevelNodes.at(enclevel);
-            FOREACHC(itnode, setLevelRawChildren) {
+            const std::vector<NodePtr>& vLevelRawChildren = _vvLevelNodes.at(enclevel);
+            FOREACHC(itnode, vLevelRawChildren) {
+                if( (*itnode)->_level != currentlevel ) {
+                    RAVELOG_WARN_FORMAT("node of level %d is stored at level %d", (*itnode)->_level%currentlevel);
+                    return false;
+                }
                 FOREACH(itchild, (*itnode)->_vchildren) {
                     dReal curdist = _ComputeDistance(*itnode, *itchild);
                     if( curdist > fLevelBound+g_fEpsilonLinear ) {
@@ -514,7 +644,7 @@ public:
                 if( currentlevel < _maxlevel ) {
                     // find its parents
                     int nfound = 0;
-                    FOREACH(ittestnode, _vsetLevelNodes.at(_EncodeLevel(currentlevel+1))) {
+                    FOREACH(ittestnode, _vvLevelNodes.at(_EncodeLevel(currentlevel+1))) {
                         if( find((*ittestnode)->_vchildren.begin(), (*ittestnode)->_vchildren.end(), *itnode) != (*ittestnode)->_vchildren.end() ) {
                             ++nfound;
                         }
@@ -523,7 +653,7 @@ public:
                 }
             }
 
-            numnodes += setLevelRawChildren.size();
+            numnodes += vLevelRawChildren.size();
 
             for(size_t i = 0; i < vAccumNodes.size(); ++i) {
                 for(size_t j = i+1; j < vAccumNodes.size(); ++j) {
@@ -557,7 +687,7 @@ public:
         o << _numnodes << endl;
         // first organize all nodes into a vector struct with indices
         std::vector<NodePtr> vnodes; vnodes.reserve(_numnodes);
-        FOREACHC(itchildren, _vsetLevelNodes) {
+        FOREACHC(itchildren, _vvLevelNodes) {
             vnodes.insert(vnodes.end(), itchildren->begin(), itchildren->end());
         }
         // there's a bug here when using FOREACHC
@@ -583,11 +713,9 @@ public:
         if( (int)inode >= _numnodes ) {
             return NodePtr();
         }
-        FOREACHC(itchildren, _vsetLevelNodes) {
+        FOREACHC(itchildren, _vvLevelNodes) {
             if( inode < itchildren->size() ) {
-                typename std::set<NodePtr>::iterator itchild = itchildren->begin();
-                advance(itchild, inode);
-                return *itchild;
+                return (*itchildren)[inode];
             }
             else {
                 inode -= itchildren->size();
@@ -602,7 +730,7 @@ public:
         if( (int)vnodes.capacity() < _numnodes ) {
             vnodes.reserve(_numnodes);
         }
-        FOREACHC(itchildren, _vsetLevelNodes) {
+        FOREACHC(itchildren, _vvLevelNodes) {
             vnodes.insert(vnodes.end(), itchildren->begin(), itchildren->end());
         }
     }
@@ -645,6 +773,82 @@ private:
         }
     }
 
+    /// \brief size of the memory of one node, rounded up to cache lines so that nodes never share a line
+    inline size_t _GetNodeSize() const
+    {
+        size_t nodesize = sizeof(Node)+_dof*sizeof(dReal);
+        return ((nodesize+CacheAlignedPoolAllocator::ALIGNMENT-1)/CacheAlignedPoolAllocator::ALIGNMENT)*CacheAlignedPoolAllocator::ALIGNMENT;
+    }
+
+    /// \brief appends node to the nodes of level enclevel and records its index there
+    inline void _AddLevelNode(int enclevel, NodePtr node)
+    {
+        std::vector<NodePtr>& vlevelnodes = _vvLevelNodes.at(enclevel);
+        node->_levelindex = vlevelnodes.size();
+        vlevelnodes.push_back(node);
+    }
+
+    /// \brief returns true if node is one of vlevelnodes, uses the index recorded by _AddLevelNode instead of searching
+    static inline bool _IsLevelNode(const std::vector<NodePtr>& vlevelnodes, NodePtr node)
+    {
+        return node->_levelindex < vlevelnodes.size() && vlevelnodes[node->_levelindex] == node;
+    }
+
+    /// \brief removes node from the nodes of a level by moving the last node of the level in its place, the order of the level is not preserved
+    static bool _EraseLevelNode(std::vector<NodePtr>& vlevelnodes, NodePtr node)
+    {
+        if( !_IsLevelNode(vlevelnodes, node) ) {
+            return false;
+        }
+        NodePtr lastnode = vlevelnodes.back();
+        vlevelnodes[node->_levelindex] = lastnode;
+        lastnode->_levelindex = node->_levelindex;
+        vlevelnodes.pop_back();
+        return true;
+    }
+
+    /// \brief checks if _distmetricfn is a weighted euclidean metric sqrt(sum_i w_i*(q0_i-q1_i)^2), if it is then the distances are computed directly with the weights.
+    ///
+    /// The weights are probed along every axis and then verified on configurations that are far apart from each other, so metrics that wrap circular joints
+    /// or have any other non-euclidean term keep going through _distmetricfn.
+    void _InitFastDistanceMetric()
+    {
+        _bFastDistanceMetric = false;
+        _vFastMetricWeights2.resize(0);
+        if( !_bEnableFastDistanceMetric || _dof <= 0 || !_distmetricfn ) {
+            return;
+        }
+        std::vector<dReal> q0(_dof, 0), q1(_dof, 0);
+        std::vector<dReal> vweights2(_dof);
+        try {
+            for(int idof = 0; idof < _dof; ++idof) {
+                q1[idof] = 1;
+                dReal fdist = _distmetricfn(q0, q1);
+                q1[idof] = 0;
+                vweights2[idof] = fdist*fdist;
+            }
+            // deterministic configurations so that the random generators of the planner are not touched
+            for(int itest = 0; itest < 16; ++itest) {
+                dReal fdist2 = 0;
+                for(int idof = 0; idof < _dof; ++idof) {
+                    q0[idof] = 4*RaveSin(dReal(1.7)*(itest*_dof+idof)+dReal(0.3));
+                    q1[idof] = 4*RaveCos(dReal(2.3)*(itest*_dof+idof)+dReal(0.1));
+                    fdist2 += vweights2[idof]*(q0[idof]-q1[idof])*(q0[idof]-q1[idof]);
+                }
+                dReal fexpected = _distmetricfn(q0, q1);
+                if( RaveFabs(RaveSqrt(fdist2) - fexpected) > g_fEpsilonLinear*max(dReal(1), fexpected) ) {
+                    return;
+                }
+            }
+        }
+        catch(const std::exception& ex) {
+            RAVELOG_VERBOSE_FORMAT("distance metric cannot be probed, so using it directly: %s", ex.what());
+            return;
+        }
+        _vFastMetricWeights2.swap(vweights2);
+        _bFastDistanceMetric = true;
+    }
+
     inline int _EncodeLevel(int level) const {
         if( level <= 0 ) {
             return -2*level;
@@ -668,7 +872,7 @@ private:
         // traverse all levels gathering up the children at each level
         dReal fLevelBound = _fMaxLevelBound;
         _vCurrentLevelNodes.resize(1);
-        _vCurrentLevelNodes[0].first = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
+        _vCurrentLevelNodes[0].first = _vvLevelNodes.at(_EncodeLevel(_maxlevel)).at(0);
         _vCurrentLevelNodes[0].second = _ComputeDistance(_vCurrentLevelNodes[0].first->q, vquerystate);
         if( _vCurrentLevelNodes[0].first->_usenn ) {
             bestnode = _vCurrentLevelNodes[0];
@@ -677,17 +881,23 @@ private:
             _vNextLevelNodes.resize(0);
             //RAVELOG_VERBOSE_FORMAT("level %d (%f) has %d nodes", currentlevel%fLevelBound%_vCurrentLevelNodes.size());
             dReal minchilddist=std::numeric_limits<dReal>::infinity();
+            // gather the children of the level so that their distances are computed in blocks
+            _vLevelChildren.resize(0);
             FOREACH(itcurrentnode, _vCurrentLevelNodes) {
-                // only take the children whose distances are within the bound
-                FOREACHC(itchild, itcurrentnode->first->_vchildren) {
-                    dReal curdist = _ComputeDistance((*itchild)->q, vquerystate);
-                    if( !bestnode.first || (curdist < bestnode.second && bestnode.first->_usenn)) {
-                        bestnode = make_pair(*itchild, curdist);
-                    }
-                    _vNextLevelNodes.emplace_back(*itchild,  curdist);
-                    if( minchilddist > curdist ) {
-                        minchilddist = curdist;
-                    }
+                _vLevelChildren.insert(_vLevelChildren.end(), itcurrentnode->first->_vchildren.begin(), itcurrentnode->first->_vchildren.end());
+            }
+            _vLevelChildrenDists.resize(_vLevelChildren.size());
+            if( _vLevelChildren.size() > 0 ) {
+                _ComputeDistances(&_vLevelChildren[0], _vLevelChildren.size(), &vquerystate[0], &_vLevelChildrenDists[0]);
+            }
+            for(size_t ichild = 0; ichild < _vLevelChildren.size(); ++ichild) {
+                dReal curdist = _vLevelChildrenDists[ichild];
+                if( !bestnode.first || (curdist < bestnode.second && bestnode.first->_usenn)) {
+                    bestnode = make_pair(_vLevelChildren[ichild], curdist);
+                }
+                _vNextLevelNodes.emplace_back(_vLevelChildren[ichild],  curdist);
+                if( minchilddist > curdist ) {
+                    minchilddist = curdist;
                 }
             }
 
@@ -710,13 +920,13 @@ private:
         NodePtr newnode = _CreateNode(parent, config, userdata);
         if( _numnodes == 0 ) {
             // no root
-            _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).insert(newnode); // add to the level
+            _AddLevelNode(_EncodeLevel(_maxlevel), newnode); // add to the level
             newnode->_level = _maxlevel;
             _numnodes += 1;
         }
         else {
             _vCurrentLevelNodes.resize(1);
-            _vCurrentLevelNodes[0].first = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
+            _vCurrentLevelNodes[0].first = _vvLevelNodes.at(_EncodeLevel(_maxlevel)).at(0);
             _vCurrentLevelNodes[0].second = _ComputeDistance(_vCurrentLevelNodes[0].first->q, config);
             int nParentFound = _InsertRecursive(newnode, _vCurrentLevelNodes, _maxlevel, _fMaxLevelBound);
             if( nParentFound == 0 ) {
@@ -751,7 +961,7 @@ private:
         dReal closestDist=std::numeric_limits<dReal>::infinity();
         NodePtr closestNodeInRange=NULL; /// one of the nodes in vCurrentLevelNodes such that its distance to nodein is <= fLevelBound
         int enclevel = _EncodeLevel(currentlevel);
-        if( enclevel < (int)_vsetLevelNodes.size() ) {
+        if( enclevel < (int)_vvLevelNodes.size() ) {
             // build the level below
             _vNextLevelNodes.resize(0); // for currentlevel-1
             FOREACHC(itcurrentnode, vCurrentLevelNodes) {
@@ -871,10 +1081,10 @@ private:
             parentnode->_vchildren.push_back(clonenode);
             parentnode->_hasselfchild = 1;
             int encclonelevel = _EncodeLevel(clonenode->_level);
-            if( encclonelevel >= (int)_vsetLevelNodes.size() ) {
-                _vsetLevelNodes.resize(encclonelevel+1);
+            if( encclonelevel >= (int)_vvLevelNodes.size() ) {
+                _vvLevelNodes.resize(encclonelevel+1);
             }
-            _vsetLevelNodes.at(encclonelevel).insert(clonenode);
+            _AddLevelNode(encclonelevel, clonenode);
             _numnodes +=1;
             parentnode = clonenode;
         }
@@ -884,10 +1094,10 @@ private:
         }
         nodein->_level = insertlevel;
         int enclevel2 = _EncodeLevel(nodein->_level);
-        if( enclevel2 >= (int)_vsetLevelNodes.size() ) {
-            _vsetLevelNodes.resize(enclevel2+1);
+        if( enclevel2 >= (int)_vvLevelNodes.size() ) {
+            _vvLevelNodes.resize(enclevel2+1);
         }
-        _vsetLevelNodes.at(enclevel2).insert(nodein);
+        _AddLevelNode(enclevel2, nodein);
         parentnode->_vchildren.push_back(nodein);
 
         if( _minlevel > nodein->_level ) {
@@ -902,7 +1112,7 @@ private:
             return false;
         }
 
-        NodePtr proot = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
+        NodePtr proot = _vvLevelNodes.at(_EncodeLevel(_maxlevel)).at(0);
         if( _numnodes == 1 && removenode == proot ) {
             Reset();
             return true;
@@ -916,29 +1126,27 @@ private:
         }
         _vvCacheNodes.at(0).push_back(proot);
         bool bRemoved = _Remove(removenode, _vvCacheNodes, _maxlevel, _fMaxLevelBound);
+        if( removenode == proot ) {
+            // _Remove already took the root out of its level, instead of it another node should have been raised to _maxlevel
+            BOOST_ASSERT(bRemoved);
+            BOOST_ASSERT(_vvCacheNodes.at(0).size()==2);
+            BOOST_ASSERT(_vvLevelNodes.at(_EncodeLevel(_maxlevel)).size()==1 && _vvLevelNodes.at(_EncodeLevel(_maxlevel)).at(0)->_level == _maxlevel);
+        }
         if( bRemoved ) {
             _DeleteNode(removenode);
         }
-        if( removenode == proot ) {
-            BOOST_ASSERT(_vvCacheNodes.at(0).size()==2); // instead of root, another node should have been added
-            BOOST_ASSERT(_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).size()==1);
-            //_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).clear();
-            _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).erase(proot);
-            bRemoved = true;
-            _numnodes--;
-        }
         return bRemoved;
     }
 
     bool _Remove(NodePtr removenode, std::vector< std::vector<NodePtr> >& vvCoverSetNodes, int currentlevel, dReal fLevelBound)
     {
         int enclevel = _EncodeLevel(currentlevel);
-        if( enclevel >= (int)_vsetLevelNodes.size() ) {
+        if( enclevel >= (int)_vvLevelNodes.size() ) {
             return false;
         }
 
         // build the level below
-        std::set<NodePtr>& setLevelRawChildren = _vsetLevelNodes.at(enclevel);
+        std::vector<NodePtr>& vLevelRawChildren = _vvLevelNodes.at(enclevel);
         int coverindex = _maxlevel-(currentlevel-1);
         if( coverindex >= (int)vvCoverSetNodes.size() ) {
             vvCoverSetNodes.resize(coverindex+(_maxlevel-_minlevel)+1);
@@ -949,7 +1157,7 @@ private:
         bool bfound = false;
         FOREACH(itcurrentnode, vvCoverSetNodes.at(coverindex-1)) {
             // only take the children whose distances are within the bound
-            if( setLevelRawChildren.find(*itcurrentnode) != setLevelRawChildren.end() ) {
+            if( (*itcurrentnode)->_level == currentlevel ) {
                 typename std::vector<NodePtr>::iterator itchild = (*itcurrentnode)->_vchildren.begin();
                 while(itchild != (*itcurrentnode)->_vchildren.end() ) {
                     dReal curdist = _ComputeDistance(removenode, *itchild);
@@ -1007,10 +1215,10 @@ private:
                             clonenode->_vchildren.push_back(nodechild);
                             clonenode->_hasselfchild = 1;
                             int encclonelevel = _EncodeLevel(clonenode->_level);
-                            if( encclonelevel >= (int)_vsetLevelNodes.size() ) {
-                                _vsetLevelNodes.resize(encclonelevel+1);
+                            if( encclonelevel >= (int)_vvLevelNodes.size() ) {
+                                _vvLevelNodes.resize(encclonelevel+1);
                             }
-                            _vsetLevelNodes.at(encclonelevel).insert(clonenode);
+                            _AddLevelNode(encclonelevel, clonenode);
                             _numnodes +=1;
                             vvCoverSetNodes.at(_maxlevel-clonenode->_level).push_back(clonenode);
                             nodechild = clonenode;
@@ -1030,14 +1238,24 @@ private:
                 }
                 if( !closestNode ) {
                     BOOST_ASSERT(parentlevel>_maxlevel);
-                    // occurs when root node is being removed and new children have no where to go?
-                    _vsetLevelNodes.at(_EncodeLevel(_maxlevel)).insert(*itchild);
-                    vvCoverSetNodes.at(0).push_back(*itchild);
+                    // occurs when the root node is being removed and the child has nowhere to go, so it becomes the new root.
+                    // like when inserting, clone it up to _maxlevel so that every node keeps the level it is stored at and the new root is at _maxlevel
+                    NodePtr nodechild = *itchild;
+                    while( nodechild->_level < _maxlevel ) {
+                        NodePtr clonenode = _CloneNode(nodechild);
+                        clonenode->_level = nodechild->_level+1;
+                        clonenode->_vchildren.push_back(nodechild);
+                        clonenode->_hasselfchild = 1;
+                        _AddLevelNode(_EncodeLevel(clonenode->_level), clonenode);
+                        _numnodes +=1;
+                        nodechild = clonenode;
+                    }
+                    vvCoverSetNodes.at(0).push_back(nodechild);
                 }
             }
             // remove the node
-            size_t erased = setLevelRawChildren.erase(removenode);
-            BOOST_ASSERT(erased==1);
+            bool erased = _EraseLevelNode(vLevelRawChildren, removenode);
+            BOOST_ASSERT(erased);
             bRemoved = true;
             _numnodes--;
         }
@@ -1052,16 +1270,17 @@ private:
     int _fromgoal;
 
     // cover tree data structures
-    boost::shared_ptr< boost::pool<> > _pNodesPool; ///< pool nodes are created from
+    typedef boost::pool<CacheAlignedPoolAllocator> NodesPool;
+    boost::shared_ptr<NodesPool> _pNodesPool; ///< pool nodes are created from, every node starts on a cache line
 
-    std::vector< std::set<NodePtr> > _vsetLevelNodes; ///< _vsetLevelNodes[enc(level)][node] holds the indices of the children of "node" of a given the level. enc(level) maps (-inf,inf) into [0,inf) so it can be indexed by the vector. Every node has an entry in a map here. If the node doesn't hold any children, then it is at the leaf of the tree. _vsetLevelNodes.at(_EncodeLevel(_maxlevel)) is the root.
+    std::vector< std::vector<NodePtr> > _vvLevelNodes; ///< _vvLevelNodes[enc(level)] holds the nodes of a given level, in no particular order. enc(level) maps (-inf,inf) into [0,inf) so it can be indexed by the vector. Every node is in the vector of its own level at its Node::_levelindex. If the node doesn't hold any children, then it is at the leaf of the tree. _vvLevelNodes.at(_EncodeLevel(_maxlevel)) is the root.
 
     dReal _maxdistance; ///< maximum possible distance between two states. used to balance the tree. Has to be > 0.
     dReal _mindistance; ///< minimum possible distance between two states until they are declared the same
     dReal _base, _fBaseInv, _fBaseChildMult; ///< a constant used to control the max level of traversion. _fBaseInv = 1/_base, _fBaseChildMult=1/(_base-1)
     int _maxlevel; ///< the maximum allowed levels in the tree, this is where the root node starts (inclusive)
     int _minlevel; ///< the minimum allowed levels in the tree (inclusive)
-    int _numnodes; ///< the number of nodes in the current tree starting at the root at _vsetLevelNodes.at(_EncodeLevel(_maxlevel))
+    int _numnodes; ///< the number of nodes in the current tree starting at the root at _vvLevelNodes.at(_EncodeLevel(_maxlevel))
     dReal _fMaxLevelBound; // pow(_base, _maxlevel)
 
     // cache
@@ -1073,6 +1292,12 @@ private:
 
     mutable std::vector< std::pair<NodePtr, dReal> > _vCurrentLevelNodes, _vNextLevelNodes;
     mutable std::vector< std::vector<NodePtr> > _vvCacheNodes;
+    mutable std::vector<NodePtr> _vLevelChildren; ///< children of a level gathered by _FindNearestNode
+    mutable std::vector<dReal> _vLevelChildrenDists;
+
+    std::vector<dReal> _vFastMetricWeights2; ///< squared weights of the metric when _bFastDistanceMetric is true
+    bool _bEnableFastDistanceMetric; ///< if false, always use _distmetricfn
+    bool _bFastDistanceMetric; ///< if true, _distmetricfn is a weighted euclidean metric with weights _vFastMetricWeights2
 };
 
 #ifdef RAVE_REGISTER_BOOST
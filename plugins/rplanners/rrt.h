@@ -36,6 +36,8 @@ Uses the Rapidly-Exploring Random Trees Algorithm.\n\
                         "returns the goal index of the plan");
         RegisterCommand("GetInitGoalIndices",boost::bind(&RrtPlanner<Node>::GetInitGoalIndicesCommand,this,_1,_2),
                         "returns the start and goal indices");
+        RegisterCommand("BenchmarkNearestNeighbor",boost::bind(&RrtPlanner<Node>::BenchmarkNearestNeighborCommand,this,_1,_2),
+                        "Format: dof numqueries [numnodes0 numnodes1 ...]\n\nbuilds trees of random configurations with a weighted euclidean metric and times the nearest neighbor queries when calling the distance metric function and when computing the distances directly. For every tree size outputs: numnodes genericqueriespersec fastqueriespersec nummismatches");
         _filterreturn.reset(new ConstraintFilterReturn());
     }
     virtual ~RrtPlanner() {
@@ -244,7 +246,85 @@ Uses the Rapidly-Exploring Random Trees Algorithm.\n\
         return !!os;
     }
 
+    bool BenchmarkNearestNeighborCommand(std::ostream& os, std::istream& is)
+    {
+        int dof = 0, numqueries = 0;
+        is >> dof >> numqueries;
+        if( !is || dof <= 0 || numqueries <= 0 ) {
+            RAVELOG_WARN("BenchmarkNearestNeighbor needs positive dof and numqueries\n");
+            return false;
+        }
+        std::vector<int> vnumnodes;
+        int numnodes = 0;
+        while( is >> numnodes ) {
+            vnumnodes.push_back(numnodes);
+        }
+        if( vnumnodes.size() == 0 ) {
+            vnumnodes.push_back(1000);
+            vnumnodes.push_back(10000);
+            vnumnodes.push_back(100000);
+        }
+
+        std::vector<dReal> vweights2(dof), vlower(dof, -PI), vupper(dof, PI);
+        for(int idof = 0; idof < dof; ++idof) {
+            vweights2[idof] = 1/dReal(1+idof);
+        }
+        boost::function<dReal(const std::vector<dReal>&, const std::vector<dReal>&)> distmetricfn = boost::bind(&RrtPlanner<Node>::_WeightedEuclideanDistance, boost::cref(vweights2), _1, _2);
+
+        std::vector< std::vector<dReal> > vqueries(numqueries, std::vector<dReal>(dof));
+        FOREACH(itquery, vqueries) {
+            FOREACH(itvalue, *itquery) {
+                *itvalue = -PI + 2*PI*RaveRandomFloat();
+            }
+        }
+        std::vector<dReal> vconfig(dof);
+        FOREACHC(itnumnodes, vnumnodes) {
+            SpatialTree<SimpleNode> tree(0);
+            tree.Init(shared_planner(), dof, distmetricfn, dReal(0.04), distmetricfn(vlower, vupper));
+            for(int inode = 0; inode < *itnumnodes; ++inode) {
+                FOREACH(itvalue, vconfig) {
+                    *itvalue = -PI + 2*PI*RaveRandomFloat();
+                }
+                tree.InsertNode(NodeBasePtr(), vconfig, 0);
+            }
+
+            dReal fqueriespersec[2] = {0, 0};
+            std::vector<dReal> vnearestdists[2];
+            for(int ipass = 0; ipass < 2; ++ipass) {
+                tree.SetEnableFastDistanceMetric(ipass == 1);
+                vnearestdists[ipass].resize(numqueries);
+                uint64_t starttime = utils::GetNanoPerformanceTime();
+                for(int iquery = 0; iquery < numqueries; ++iquery) {
+                    vnearestdists[ipass][iquery] = tree.FindNearestNode(vqueries[iquery]).second;
+                }
+                uint64_t elapsed = utils::GetNanoPerformanceTime() - starttime;
+                fqueriespersec[ipass] = elapsed > 0 ? 1e9*numqueries/elapsed : 0;
+            }
+            int nummismatches = 0;
+            for(int iquery = 0; iquery < numqueries; ++iquery) {
+                if( RaveFabs(vnearestdists[0][iquery] - vnearestdists[1][iquery]) > g_fEpsilonLinear ) {
+                    ++nummismatches;
+                }
+            }
+            if( nummismatches > 0 ) {
+                RAVELOG_WARN_FORMAT("%d/%d nearest neighbor queries differ between the generic and fast distances", nummismatches%numqueries);
+            }
+            RAVELOG_DEBUG_FORMAT("dof=%d, nodes=%d, generic=%.0f/s, fast=%.0f/s, speedup=%.2fx", dof%tree.GetNumNodes()%fqueriespersec[0]%fqueriespersec[1]%(fqueriespersec[0] > 0 ? fqueriespersec[1]/fqueriespersec[0] : dReal(0)));
+            os << tree.GetNumNodes() << " " << fqueriespersec[0] << " " << fqueriespersec[1] << " " << nummismatches << " ";
+        }
+        return true;
+    }
+
 protected:
+    static dReal _WeightedEuclideanDistance(const std::vector<dReal>& vweights2, const std::vector<dReal>& c0, const std::vector<dReal>& c1)
+    {
+        dReal fdist2 = 0;
+        for(size_t i = 0; i < vweights2.size(); ++i) {
+            fdist2 += vweights2[i]*(c0[i]-c1[i])*(c0[i]-c1[i]);
+        }
+        return RaveSqrt(fdist2);
+    }
+
     RobotBasePtr _robot;
     std::vector<dReal> _sampleConfig;
     int _goalindex, _startindex;
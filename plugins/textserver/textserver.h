@@ -18,12 +18,17 @@
 #define OPENRAVE_TEXTSERVER
 
 #include <openrave/planningutils.h>
+#include <openrave/utils.h>
 #include <cstdlib>
+#include <cerrno>
 
 #ifndef _WIN32
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #else
 // for some reason there's a clash between winsock.h and winsock2.h, so don't include winsockX directly. Also cannot define WIN32_LEAN_AND_MEAN for vc100
 #undef WIN32_LEAN_AND_MEAN
@@ -31,291 +36,438 @@
 #define usleep(microseconds) Sleep((microseconds+999)/1000)
 #endif
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#define OPENRAVE_TEXTSERVER_EPOLL
+#endif
+
 #include <sstream>
+#include <boost/thread/tss.hpp>
 
 #ifdef _WIN32
 #define CLOSESOCKET closesocket
 typedef int socklen_t;
 #else
 #include <fcntl.h>
+#include <unistd.h>
 #define CLOSESOCKET close
 #endif
 
-/// manages all connections. At the moment, server can handle only one connectino at a time
-class SimpleTextServer : public ModuleBase
+// do not raise SIGPIPE when a client closed its connection while replies are sent
+#ifdef MSG_NOSIGNAL
+#define TEXTSERVER_SENDFLAGS MSG_NOSIGNAL
+#else
+#define TEXTSERVER_SENDFLAGS 0
+#endif
+
+/// \brief waits until sockets can be read or written, uses epoll on linux and select on the other systems
+class SocketPoller
 {
-    // socket just accepts connections
-    class Socket
-    {
 public:
-        struct PACKET
-        {
-            string cmd, arg;
-        };
+    enum PollEvent
+    {
+        PE_Read = 1,
+        PE_Write = 2,
+        PE_Error = 4,
+    };
 
-        Socket() {
-            bInit = false;
-            client_sockfd = 0;
+    SocketPoller() {
+#ifdef OPENRAVE_TEXTSERVER_EPOLL
+        _epollfd = epoll_create(64);
+        if( _epollfd < 0 ) {
+            RAVELOG_ERROR("failed to create epoll instance\n");
         }
-        ~Socket() {
-            if( bInit )
-                Close();
+#endif
+#ifndef _WIN32
+        // Notify writes to the pipe to wake up Wait
+        if( pipe(_vnotifyfds) == 0 ) {
+            fcntl(_vnotifyfds[0], F_SETFL, fcntl(_vnotifyfds[0], F_GETFL, 0)|O_NONBLOCK);
+            fcntl(_vnotifyfds[1], F_SETFL, fcntl(_vnotifyfds[1], F_GETFL, 0)|O_NONBLOCK);
+            Add(_vnotifyfds[0]);
         }
-        bool Accept(int server_sockfd)
-        {
-            if( bInit )
-                Close();
-
-            bool success = true;
-
-            //signal(SIGCHLD, SIG_IGN);
-            //RAVELOG(L"server waiting for connection, %d\n", server_sockfd);
-
-            //	char str[sizeof(server_address)+1];
-            //	memcpy(str, &server_address, sizeof(server_address));
-            //	str[sizeof(server_address)] = 0;
-
-            client_len = sizeof(client_address);
-            client_sockfd = accept(server_sockfd, (struct sockaddr *)&client_address, (socklen_t*)&client_len);
-
-            if( client_sockfd == -1 ) {
-                success = false;
-                client_sockfd = 0;
-            }
-
-            bInit = success;
-
-            return bInit;
+        else {
+            _vnotifyfds[0] = _vnotifyfds[1] = -1;
         }
-        void Close()
-        {
-            if( bInit ) {
-                // close
-                CLOSESOCKET(client_sockfd); client_sockfd = 0;
-                bInit = false;
-            }
+#endif
+    }
+    ~SocketPoller() {
+#ifdef OPENRAVE_TEXTSERVER_EPOLL
+        if( _epollfd >= 0 ) {
+            close(_epollfd);
         }
-
-        /// returns true if connection is valid, otherwise false
-        bool IsInit() {
-            return bInit;
+#endif
+#ifndef _WIN32
+        if( _vnotifyfds[0] >= 0 ) {
+            close(_vnotifyfds[0]);
+            close(_vnotifyfds[1]);
         }
+#endif
+    }
 
-        void SendData(const void* pdata, int size_to_write)
-        {
-            if( client_sockfd == 0 )
-                return;
-
-            int nBytesReceived;
-
+    /// \brief wakes up Wait from any thread. On windows Wait only returns at its timeout.
+    void Notify()
+    {
 #ifndef _WIN32
-            // check if closed, only for linux systems
-            struct timeval tv;
-            fd_set exfds, writefds;
-
-            tv.tv_sec = 0;
-            tv.tv_usec = 0;
-
-            FD_ZERO(&exfds);
-            FD_ZERO(&writefds);
-            FD_SET(client_sockfd, &exfds);
-
-            // don't care about writefds and exceptfds:
-            int num = select(client_sockfd+1, NULL, NULL, &exfds, &tv);
-
-            if (( num > 0) && FD_ISSET(client_sockfd, &exfds) ) {
-                RAVELOG_ERROR("socket exception detected\n");
-                Close();
-                return;
-            }
-
-            FD_SET(client_sockfd, &writefds);
-
-            // don't care about writefds and exceptfds:
-            num = select(client_sockfd+1, NULL, &writefds, NULL, &tv);
-
-            if (( num == 0) || !FD_ISSET(client_sockfd, &writefds) ) {
-                RAVELOG_WARN("no writable socket\n");
-                return;
+        if( _vnotifyfds[1] >= 0 ) {
+            char c = 0;
+            if( write(_vnotifyfds[1], &c, 1) < 0 ) {
+                // the pipe is full, so Wait wakes up anyway
             }
-
-            /*int ret = recv(client_sockfd, NULL, 0, MSG_PEEK|MSG_DONTWAIT);
-               if( ret == 0 ) {
-               RAVEPRINT(L"socket close detected\n");
-               Close();
-               return;
-               }*/
+        }
 #endif
+    }
 
-            char* pbuf = (char*)pdata;
+    /// \brief starts watching a socket for reading
+    bool Add(int sockfd)
+    {
+#ifdef OPENRAVE_TEXTSERVER_EPOLL
+        if( _epollfd < 0 ) {
+            return false;
+        }
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = sockfd;
+        return epoll_ctl(_epollfd, EPOLL_CTL_ADD, sockfd, &ev) == 0;
+#else
+        boost::mutex::scoped_lock lock(_mutex);
+        _mapSockets[sockfd] = false;
+        return true;
+#endif
+    }
 
-            if( (nBytesReceived = send(client_sockfd, (char*)&size_to_write, 4, 0)) != 4 ) {
-                RAVELOG_ERROR("failed to send command: %d\n", nBytesReceived);
-                return;
-            }
+    void Remove(int sockfd)
+    {
+#ifdef OPENRAVE_TEXTSERVER_EPOLL
+        struct epoll_event ev; // kernels before 2.6.9 require a non-null event
+        memset(&ev, 0, sizeof(ev));
+        epoll_ctl(_epollfd, EPOLL_CTL_DEL, sockfd, &ev);
+#else
+        boost::mutex::scoped_lock lock(_mutex);
+        _mapSockets.erase(sockfd);
+#endif
+    }
 
-            while(size_to_write > 0 ) {
-                nBytesReceived = send(client_sockfd, pbuf, size_to_write, 0);
-                if( nBytesReceived <= 0 ) {
-                    if( nBytesReceived == -1 )
-                        return;
+    /// \brief sets whether the socket is also watched for writing. Can be called from any thread.
+    void SetWriting(int sockfd, bool bWriting)
+    {
+#ifdef OPENRAVE_TEXTSERVER_EPOLL
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN|(bWriting ? EPOLLOUT : 0);
+        ev.data.fd = sockfd;
+        epoll_ctl(_epollfd, EPOLL_CTL_MOD, sockfd, &ev);
+#else
+        boost::mutex::scoped_lock lock(_mutex);
+        std::map<int, bool>::iterator it = _mapSockets.find(sockfd);
+        if( it != _mapSockets.end() ) {
+            it->second = bWriting;
+        }
+#endif
+    }
 
-                    //perror("failed to read line");
-                    continue;
+    /// \brief waits until at least one of the sockets has an event, Notify is called, or the timeout expires
+    ///
+    /// \param[out] vevents the sockets with events and their combination of PollEvent
+    /// \return the number of sockets with events, or -1 on error
+    int Wait(int timeoutms, std::vector< std::pair<int, int> >& vevents)
+    {
+        int num = _Wait(timeoutms, vevents);
+#ifndef _WIN32
+        for(size_t i = 0; i < vevents.size(); ++i) {
+            if( vevents[i].first == _vnotifyfds[0] ) {
+                char buffer[64];
+                while( read(_vnotifyfds[0], buffer, sizeof(buffer)) > 0 ) {
                 }
-
-                size_to_write -= nBytesReceived;
-                pbuf += nBytesReceived;
+                vevents.erase(vevents.begin()+i);
+                --num;
+                break;
             }
         }
+#endif
+        return num;
+    }
 
-
-        bool ReadLine(string& s)
-        {
-            struct timeval tv;
-            fd_set readfds, exfds;
-            s.resize(0);
-
-            tv.tv_sec = 0;
-            tv.tv_usec = 0;
-
-
-            FD_ZERO(&exfds);
-            FD_SET(client_sockfd, &exfds);
-
-            // don't care about writefds and exceptfds:
-            int num = select(client_sockfd+1, NULL, NULL, &exfds, &tv);
-
-            if (( num > 0) && FD_ISSET(client_sockfd, &exfds) ) {
-                RAVELOG_ERROR("socket exception detected\n");
-                Close();
-                return false;
+private:
+    int _Wait(int timeoutms, std::vector< std::pair<int, int> >& vevents)
+    {
+        vevents.resize(0);
+#ifdef OPENRAVE_TEXTSERVER_EPOLL
+        struct epoll_event events[64];
+        int num = epoll_wait(_epollfd, events, 64, timeoutms);
+        if( num < 0 ) {
+            return errno == EINTR ? 0 : -1;
+        }
+        for(int i = 0; i < num; ++i) {
+            int flags = 0;
+            if( events[i].events & EPOLLIN ) {
+                flags |= PE_Read;
             }
-
-            FD_ZERO(&readfds);
-            FD_SET(client_sockfd, &readfds);
-
-            // don't care about writefds and exceptfds:
-            num = select(client_sockfd+1, &readfds, NULL, NULL, &tv);
-
-            if (( num == 0) || !FD_ISSET(client_sockfd, &readfds) ) {
-                return false;
+            if( events[i].events & EPOLLOUT ) {
+                flags |= PE_Write;
             }
-
-            // protocol: size1 size2 "size1 bytes" "size2 bytes"
-            long nBytesReceived;
-            char c;
-            int failed = 0;
-
-            while(1) {
-                if( (nBytesReceived = recv(client_sockfd, &c, sizeof(char), 0)) > 0 ) {
-                    if(( c == '\n') ||( c == '\r') ) {
-                        break;
-                    }
-                    s.push_back(c);
-                }
-                else if( nBytesReceived == 0 ) {
-                    //RAVELOG_DEBUG("closing connection\n");
-                    //  Close();
-                    return false;
-                }
-                else {
-                    if( failed < 10 ) {
-                        failed++;
-                        usleep(1000);
-                        continue;
-                    }
-                    perror("failed to read line");
-                    Close();
-                    return false;
+            if( events[i].events & (EPOLLERR|EPOLLHUP) ) {
+                flags |= PE_Error;
+            }
+            vevents.push_back(std::make_pair((int)events[i].data.fd, flags));
+        }
+        return num;
+#else
+        fd_set readfds, writefds, exfds;
+        FD_ZERO(&readfds);
+        FD_ZERO(&writefds);
+        FD_ZERO(&exfds);
+        std::vector<int> vsockets;
+        int maxfd = -1;
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            FOREACHC(it, _mapSockets) {
+                FD_SET(it->first, &readfds);
+                FD_SET(it->first, &exfds);
+                if( it->second ) {
+                    FD_SET(it->first, &writefds);
                 }
+                vsockets.push_back(it->first);
+                maxfd = max(maxfd, it->first);
             }
-
-            return true;
         }
+        if( maxfd < 0 ) {
+            usleep(timeoutms*1000);
+            return 0;
+        }
+        struct timeval tv;
+        tv.tv_sec = timeoutms/1000;
+        tv.tv_usec = (timeoutms%1000)*1000;
+        int num = select(maxfd+1, &readfds, &writefds, &exfds, &tv);
+        if( num <= 0 ) {
+            return num;
+        }
+        FOREACHC(it, vsockets) {
+            int flags = 0;
+            if( FD_ISSET(*it, &readfds) ) {
+                flags |= PE_Read;
+            }
+            if( FD_ISSET(*it, &writefds) ) {
+                flags |= PE_Write;
+            }
+            if( FD_ISSET(*it, &exfds) ) {
+                flags |= PE_Error;
+            }
+            if( flags != 0 ) {
+                vevents.push_back(std::make_pair(*it, flags));
+            }
+        }
+        return (int)vevents.size();
+#endif
+    }
 
-private:
-        int client_sockfd;
-        int client_len;
-
-        struct sockaddr_in client_address;
-        bool bInit;
-    };
-    typedef boost::shared_ptr<Socket> SocketPtr;
-    typedef boost::shared_ptr<Socket const> SocketConstPtr;
+#ifndef _WIN32
+    int _vnotifyfds[2]; ///< pipe written by Notify, its read end is watched by Wait
+#endif
+#ifdef OPENRAVE_TEXTSERVER_EPOLL
+    int _epollfd;
+#else
+    boost::mutex _mutex; ///< protects _mapSockets
+    std::map<int, bool> _mapSockets; ///< watched sockets, the value is true if also watched for writing
+#endif
+};
 
+/// manages all connections. A single event thread reads the requests of all the clients, commands that modify
+/// the environment are executed one at a time by the command thread, and read-only queries are executed by a pool
+/// of query threads, each with its own clone of the environment.
+class SimpleTextServer : public ModuleBase
+{
     /// \param in is the data passed from the network
     /// \param out is the return data that will be passed to the client
     /// \param boost::shared_ptr<void> is a pointer to a void that willl be passed to the worker thread function
     typedef boost::function<bool (istream&, ostream&, boost::shared_ptr<void>&)> OpenRaveNetworkFn;
     typedef boost::function<bool (boost::shared_ptr<istream>, boost::shared_ptr<void>)> OpenRaveWorkerFn;
+    /// \param vints, vvalues the integers and values of the binary request
+    /// \param vreplyints, vreplyvalues the integers and values returned to the client
+    typedef boost::function<bool (const vector<int32_t>&, const vector<dReal>&, vector<int32_t>&, vector<dReal>&)> OpenRaveBinaryFn;
+
+    /// \brief the thread the network function of a command is executed on
+    enum ExecutionType
+    {
+        ET_Serialized = 0, ///< can modify the environment, executed by the command thread one command at a time
+        ET_Query = 1, ///< only reads the environment, executed by a query thread on its cloned environment
+        ET_Concurrent = 2, ///< does not modify the environment, executed by a query thread on the server environment
+    };
 
     /// each network function has a function to intially processes the data on the socket function
     /// and one that is executed on the main worker thread to avoid multithreading data synchronization issues
     struct RAVENETWORKFN
     {
-        RAVENETWORKFN() : bReturnResult(false) {
+        RAVENETWORKFN() : bReturnResult(false), type(ET_Serialized), bModifiesEnvironment(true), bDeferReply(false) {
         }
-        RAVENETWORKFN(const OpenRaveNetworkFn& socket, const OpenRaveWorkerFn& worker, bool bReturnResult) : fnSocketThread(socket), fnWorker(worker), bReturnResult(bReturnResult) {
+        RAVENETWORKFN(const OpenRaveNetworkFn& socket, const OpenRaveWorkerFn& worker, bool bReturnResult, ExecutionType type=ET_Serialized, bool bModifiesEnvironment=true) : fnSocketThread(socket), fnWorker(worker), bReturnResult(bReturnResult), type(type), bModifiesEnvironment(bModifiesEnvironment), bDeferReply(false) {
         }
 
         OpenRaveNetworkFn fnSocketThread;
         OpenRaveWorkerFn fnWorker;
         bool bReturnResult;     // if true, function is expected to return a result
+        ExecutionType type;
+        bool bModifiesEnvironment; ///< if false, an ET_Serialized command does not force the query threads to clone the environment again
+        bool bDeferReply; ///< if true and fnSocketThread sets its data, the data is a WAITREQUEST and the reply is sent by the event thread once it is done
+    };
+
+    /// \brief the wait command of a robot whose controller was still running, the event thread replies once the controller is done or the timeout expires
+    struct WAITREQUEST
+    {
+        WAITREQUEST() : endtime(0) {
+        }
+        ControllerBasePtr pcontroller;
+        uint64_t endtime; ///< us, 0 if the wait does not time out
+    };
+    typedef boost::shared_ptr<WAITREQUEST> WaitRequestPtr;
+
+    /// \brief commands of the binary protocol, see orEnvBinary
+    enum BinaryCommand
+    {
+        BC_GetDOFValues = 1, ///< ints: bodyid [dofindices], reply values: dof values
+        BC_SetDOFValues = 2, ///< ints: bodyid [dofindices], values: dof values
+        BC_GetTransform = 3, ///< ints: bodyid, reply values: quaternion and translation
+        BC_SetTransform = 4, ///< ints: bodyid, values: quaternion and translation
+        BC_CheckCollision = 5, ///< ints: bodyid, reply ints: collision collidingbodyid
+        BC_SetTrajectory = 6, ///< ints: robotid numpoints havetime, values: active dof values of every point followed by its delta time if havetime
+        BC_GetTrajectory = 7, ///< ints: robotid, reply ints: numpoints dof, reply values: the retimed active dof values and delta time of every point of the last trajectory set
+    };
+
+    struct RAVEBINARYFN
+    {
+        RAVEBINARYFN() : type(ET_Serialized), bModifiesEnvironment(true) {
+        }
+        RAVEBINARYFN(const string& name, const OpenRaveBinaryFn& fn, ExecutionType type, bool bModifiesEnvironment=true) : name(name), fn(fn), type(type), bModifiesEnvironment(bModifiesEnvironment) {
+        }
+
+        string name; ///< name used for the statistics
+        OpenRaveBinaryFn fn;
+        ExecutionType type;
+        bool bModifiesEnvironment; ///< if false, an ET_Serialized command does not force the query threads to clone the environment again
+    };
+
+    /// \brief one line or binary frame received from a client
+    struct REQUEST
+    {
+        REQUEST() : pfn(NULL), pbinaryfn(NULL), bBinary(false), bSwitchBinary(false), opcode(0), type(ET_Serialized), bModifiesEnvironment(false), starttime(0) {
+        }
+        string cmd;
+        boost::shared_ptr<istream> is;
+        stringstream::streampos inputpos; ///< position of the arguments in is
+        const RAVENETWORKFN* pfn; ///< NULL if the command is not recognized
+        const RAVEBINARYFN* pbinaryfn; ///< NULL if the binary command is not recognized
+        bool bBinary; ///< if true, the request is a binary frame and vints, vvalues hold its data
+        bool bSwitchBinary; ///< the binary command, the connection switches to binary frames once it replied successfully
+        uint16_t opcode;
+        vector<int32_t> vints;
+        vector<dReal> vvalues;
+        ExecutionType type;
+        bool bModifiesEnvironment; ///< if true, the query threads clone the environment again after the request executed
+        uint64_t starttime; ///< time the request was received, us
+        WaitRequestPtr pwait; ///< set while the reply of a wait command is deferred
     };
+    typedef boost::shared_ptr<REQUEST> RequestPtr;
 
+    /// \brief a client connection. Requests can be pipelined, they are executed one at a time in the order they were received so that replies are sent in order.
+    class Connection
+    {
 public:
-    SimpleTextServer(EnvironmentBasePtr penv) : ModuleBase(penv) {
+        Connection(int sockfd) : sockfd(sockfd), bbinary(false), bswitching(false), nwriteoffset(0), bexecuting(false), bclosed(false), bremoved(false), bwriting(false) {
+        }
+
+        int sockfd;
+        string sreadbuffer; ///< received bytes that do not form a full line or frame yet, only used by the event thread
+        bool bbinary; ///< the client switched to binary frames with the binary command, only used by the event thread
+        bool bswitching; ///< the binary command did not reply yet, so the following bytes are not parsed until the mode of the connection is known, only used by the event thread
+
+        boost::mutex mutex; ///< protects the members below
+        string swritebuffer; ///< replies that were not sent yet
+        size_t nwriteoffset; ///< number of bytes of swritebuffer already sent
+        list<RequestPtr> listrequests; ///< requests waiting for the executing request
+        bool bexecuting; ///< a request of the connection is scheduled or executing
+        bool bclosed; ///< the connection failed or was closed by the client, requests are not executed anymore
+        bool bremoved; ///< the event thread stopped watching the socket, it is closed once no request is executing
+        bool bwriting; ///< the socket is watched for writing because swritebuffer could not be sent without blocking
+    };
+    typedef boost::shared_ptr<Connection> ConnectionPtr;
+
+    /// \brief latency statistics of one command
+    struct COMMANDSTATS
+    {
+        COMMANDSTATS() : count(0), totaltime(0), maxtime(0) {
+            vhistogram.assign(0);
+        }
+        uint64_t count;
+        uint64_t totaltime, maxtime; ///< us
+        boost::array<uint64_t, 24> vhistogram; ///< vhistogram[i] is the number of requests with latencies in [2^i,2^(i+1)) us, the last bin also counts the larger latencies
+    };
+
+public:
+    SimpleTextServer(EnvironmentBasePtr penv) : ModuleBase(penv), _ppenvquery(&SimpleTextServer::_NoCleanup) {
         _nIdIndex = 1;
         _nNextFigureId = 1;
         _bWorking = false;
         bDestroying = false;
-        __description=":Interface Author: Rosen Diankov\n\nSimple text-based server using sockets.";
-        mapNetworkFns["body_checkcollision"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvCheckCollision, this, _1, _2, _3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["body_getjoints"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyGetJointValues, this,_1, _2, _3), OpenRaveWorkerFn(), true);
+        bInitThread = false;
+        bCloseThread = false;
+        _nQueryThreads = 2;
+        _nServerStamp = 0;
+        __description=":Interface Author: Rosen Diankov\n\nSimple text-based server using sockets.\n\nThe arguments are \"port [querythreads num]\": the port to listen on (default 4765), and the number of threads executing read-only queries on clones of the environment (default 2, 0 executes every command on the command thread).";
+        mapNetworkFns["binary"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvBinary,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Concurrent);
+        mapNetworkFns["body_checkcollision"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvCheckCollision, this, _1, _2, _3), OpenRaveWorkerFn(), true, ET_Query);
+        mapNetworkFns["body_getjoints"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyGetJointValues, this,_1, _2, _3), OpenRaveWorkerFn(), true, ET_Query);
         mapNetworkFns["body_destroy"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyDestroy,this,_1,_2,_3), OpenRaveWorkerFn(), false);
         mapNetworkFns["body_enable"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyEnable,this,_1,_2,_3), OpenRaveWorkerFn(), false);
-        mapNetworkFns["body_getaabb"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyGetAABB,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["body_getaabbs"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyGetAABBs,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["body_getlinks"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyGetLinks,this,_1,_2,_3),OpenRaveWorkerFn(), true);
-        mapNetworkFns["body_getdof"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyGetDOF,this,_1,_2,_3),OpenRaveWorkerFn(), true);
+        mapNetworkFns["body_getaabb"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyGetAABB,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
+        mapNetworkFns["body_getaabbs"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyGetAABBs,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
+        mapNetworkFns["body_getlinks"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyGetLinks,this,_1,_2,_3),OpenRaveWorkerFn(), true, ET_Query);
+        mapNetworkFns["body_getdof"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodyGetDOF,this,_1,_2,_3),OpenRaveWorkerFn(), true, ET_Query);
         mapNetworkFns["body_settransform"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orKinBodySetTransform,this,_1,_2,_3),OpenRaveWorkerFn(), false);
         mapNetworkFns["body_setjoints"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodySetJointValues,this,_1,_2,_3), OpenRaveWorkerFn(), false);
         mapNetworkFns["body_setjointtorques"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orBodySetJointTorques,this,_1,_2,_3), OpenRaveWorkerFn(), false);
-        mapNetworkFns["close"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvClose,this,_1,_2,_3), OpenRaveWorkerFn(),false);
+        mapNetworkFns["close"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvClose,this,_1,_2,_3), OpenRaveWorkerFn(),false, ET_Serialized, false);
         mapNetworkFns["createrobot"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvCreateRobot,this,_1,_2,_3), OpenRaveWorkerFn(), true);
         mapNetworkFns["createbody"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvCreateKinBody,this,_1,_2,_3), OpenRaveWorkerFn(), true);
         mapNetworkFns["createmodule"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvCreateModule,this,_1,_2,_3), boost::bind(&SimpleTextServer::worEnvCreateModule,this,_1,_2), true);
         mapNetworkFns["env_dstrprob"] = RAVENETWORKFN(OpenRaveNetworkFn(), boost::bind(&SimpleTextServer::worEnvDestroyProblem,this,_1,_2), false);
-        mapNetworkFns["env_getbodies"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvGetBodies,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["env_getrobots"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvGetRobots,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["env_getbody"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvGetBody,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["env_loadplugin"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvLoadPlugin,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["env_raycollision"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvRayCollision,this,_1,_2,_3), OpenRaveWorkerFn(), true);
+        mapNetworkFns["env_getbodies"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvGetBodies,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
+        mapNetworkFns["env_getrobots"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvGetRobots,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
+        mapNetworkFns["env_getbody"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvGetBody,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
+        mapNetworkFns["env_loadplugin"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvLoadPlugin,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Serialized, false);
+        mapNetworkFns["env_raycollision"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvRayCollision,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
         mapNetworkFns["env_stepsimulation"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvStepSimulation,this,_1,_2,_3), boost::bind(&SimpleTextServer::worEnvStepSimulation,this,_1,_2), false);
-        mapNetworkFns["env_triangulate"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvTriangulate,this,_1,_2,_3), OpenRaveWorkerFn(), true);
+        mapNetworkFns["env_triangulate"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvTriangulate,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
         mapNetworkFns["loadscene"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvLoadScene,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["plot"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvPlot,this,_1,_2,_3), OpenRaveWorkerFn(), true);
+        mapNetworkFns["plot"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvPlot,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Serialized, false);
         mapNetworkFns["problem_sendcmd"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orProblemSendCommand,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["robot_checkselfcollision"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotCheckSelfCollision,this,_1,_2,_3), OpenRaveWorkerFn(), true);
+        mapNetworkFns["robot_checkselfcollision"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotCheckSelfCollision,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
         mapNetworkFns["robot_controllersend"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotControllerSend,this,_1,_2,_3), OpenRaveWorkerFn(), true);
         mapNetworkFns["robot_controllerset"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotControllerSet,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["robot_getactivedof"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotGetActiveDOF,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["robot_getdofvalues"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotGetDOFValues,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["robot_getlimits"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotGetDOFLimits,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["robot_getmanipulators"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotGetManipulators,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["robot_getsensors"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotGetAttachedSensors,this,_1,_2,_3), OpenRaveWorkerFn(), true);
+        mapNetworkFns["robot_getactivedof"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotGetActiveDOF,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
+        mapNetworkFns["robot_getdofvalues"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotGetDOFValues,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
+        mapNetworkFns["robot_getlimits"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotGetDOFLimits,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
+        mapNetworkFns["robot_getmanipulators"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotGetManipulators,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Query);
+        mapNetworkFns["robot_getsensors"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotGetAttachedSensors,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Serialized, false);
         mapNetworkFns["robot_sensorsend"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotSensorSend,this,_1,_2,_3), OpenRaveWorkerFn(), true);
         mapNetworkFns["robot_sensorconfigure"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotSensorConfigure,this,_1,_2,_3), OpenRaveWorkerFn(), true);
-        mapNetworkFns["robot_sensordata"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotSensorData,this,_1,_2,_3), OpenRaveWorkerFn(), true);
+        mapNetworkFns["robot_sensordata"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotSensorData,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Concurrent);
         mapNetworkFns["robot_setactivedofs"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotSetActiveDOFs,this,_1,_2,_3), OpenRaveWorkerFn(), false);
         mapNetworkFns["robot_setactivemanipulator"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotSetActiveManipulator,this,_1,_2,_3), OpenRaveWorkerFn(), false);
         mapNetworkFns["robot_setdof"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orRobotSetDOFValues,this,_1,_2,_3), OpenRaveWorkerFn(), false);
         mapNetworkFns["robot_traj"] = RAVENETWORKFN(OpenRaveNetworkFn(), boost::bind(&SimpleTextServer::worRobotStartActiveTrajectory,this,_1,_2), false);
         mapNetworkFns["render"] = RAVENETWORKFN(OpenRaveNetworkFn(), boost::bind(&SimpleTextServer::worRender,this,_1,_2), false);
         mapNetworkFns["setoptions"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvSetOptions,this,_1,_2,_3), boost::bind(&SimpleTextServer::worSetOptions,this,_1,_2), false);
-        mapNetworkFns["test"] = RAVENETWORKFN(OpenRaveNetworkFn(), OpenRaveWorkerFn(), false);
-        mapNetworkFns["wait"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvWait,this,_1,_2,_3), OpenRaveWorkerFn(), true);
+        mapNetworkFns["stats"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orServerStats,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Concurrent);
+        mapNetworkFns["test"] = RAVENETWORKFN(OpenRaveNetworkFn(), OpenRaveWorkerFn(), false, ET_Serialized, false);
+        mapNetworkFns["wait"] = RAVENETWORKFN(boost::bind(&SimpleTextServer::orEnvWait,this,_1,_2,_3), OpenRaveWorkerFn(), true, ET_Concurrent);
+        mapNetworkFns["wait"].bDeferReply = true;
+        mapBinaryFns[BC_GetDOFValues] = RAVEBINARYFN("binary_getdofvalues", boost::bind(&SimpleTextServer::bGetDOFValues,this,_1,_2,_3,_4), ET_Query);
+        mapBinaryFns[BC_SetDOFValues] = RAVEBINARYFN("binary_setdofvalues", boost::bind(&SimpleTextServer::bSetDOFValues,this,_1,_2,_3,_4), ET_Serialized);
+        mapBinaryFns[BC_GetTransform] = RAVEBINARYFN("binary_gettransform", boost::bind(&SimpleTextServer::bGetTransform,this,_1,_2,_3,_4), ET_Query);
+        mapBinaryFns[BC_SetTransform] = RAVEBINARYFN("binary_settransform", boost::bind(&SimpleTextServer::bSetTransform,this,_1,_2,_3,_4), ET_Serialized);
+        mapBinaryFns[BC_CheckCollision] = RAVEBINARYFN("binary_checkcollision", boost::bind(&SimpleTextServer::bCheckCollision,this,_1,_2,_3,_4), ET_Query);
+        mapBinaryFns[BC_SetTrajectory] = RAVEBINARYFN("binary_settrajectory", boost::bind(&SimpleTextServer::bSetTrajectory,this,_1,_2,_3,_4), ET_Serialized);
+        mapBinaryFns[BC_GetTrajectory] = RAVEBINARYFN("binary_gettrajectory", boost::bind(&SimpleTextServer::bGetTrajectory,this,_1,_2,_3,_4), ET_Serialized, false);
 
         string logfilename = RaveGetHomeDirectory() + string("/textserver.log");
         flog.open(logfilename.c_str());
@@ -330,8 +482,19 @@ public:
     virtual int main(const std::string& cmd)
     {
         _nPort = 4765;
+        _nQueryThreads = 2;
         stringstream ss(cmd);
         ss >> _nPort;
+        string option;
+        while( ss >> option ) {
+            std::transform(option.begin(), option.end(), option.begin(), ::tolower);
+            if( option == "querythreads" ) {
+                ss >> _nQueryThreads;
+            }
+            else {
+                RAVELOG_WARN("unknown textserver option %s\n", option.c_str());
+            }
+        }
 
         Destroy();
 
@@ -375,34 +538,24 @@ public:
             return -1;
         }
 
-        // set nonblocking
-#ifdef _WIN32
-        u_long flags = 1;
-        ioctlsocket(server_sockfd, FIONBIO, &flags);
-#else
-        int flags;
-
-        // If they have O_NONBLOCK, use the Posix way to do it
-#if defined(O_NONBLOCK)
-        // Fixme: O_NONBLOCK is defined but broken on SunOS 4.1.x and AIX 3.2.5.
-        if (-1 == (flags = fcntl(server_sockfd, F_GETFL, 0))) {
-            flags = 0;
-        }
-        if( fcntl(server_sockfd, F_SETFL, flags | O_NONBLOCK) < 0 ) {
+        if( !_SetNonBlocking(server_sockfd) ) {
             return -1;
         }
-#else
-        // Otherwise, use the old way of doing it
-        flags = 1;
-        if( ioctl(server_sockfd, FIOBIO, &flags) < 0 ) {
+
+        _poller.reset(new SocketPoller());
+        if( !_poller->Add(server_sockfd) ) {
+            RAVELOG_ERROR("failed to watch server port %d\n", _nPort);
+            _poller.reset();
             return -1;
         }
-#endif
-#endif
 
-        RAVELOG_DEBUG("text server listening on port %d\n",_nPort);
+        RAVELOG_DEBUG("text server listening on port %d with %d query threads\n",_nPort,_nQueryThreads);
         _servthread.reset(new boost::thread(boost::bind(&SimpleTextServer::_listen_threadcb,this)));
+        _commandthread.reset(new boost::thread(boost::bind(&SimpleTextServer::_command_threadcb,this)));
         _workerthread.reset(new boost::thread(boost::bind(&SimpleTextServer::_worker_threadcb,this)));
+        for(int i = 0; i < _nQueryThreads; ++i) {
+            _vquerythreads.push_back(boost::shared_ptr<boost::thread>(new boost::thread(boost::bind(&SimpleTextServer::_query_threadcb,this))));
+        }
         bInitThread = true;
         return 0;
     }
@@ -424,22 +577,43 @@ public:
         if( bInitThread ) {
             bCloseThread = true;
             _condWorker.notify_all();
+            {
+                boost::mutex::scoped_lock lock(_mutexRequests);
+                _condHasCommand.notify_all();
+                _condHasQuery.notify_all();
+            }
             if( !!_servthread ) {
                 _servthread->join();
             }
             _servthread.reset();
-
-            FOREACH(it, _listReadThreads) {
-                _condWorker.notify_all();
+            if( !!_commandthread ) {
+                _commandthread->join();
+            }
+            _commandthread.reset();
+            FOREACH(it, _vquerythreads) {
                 (*it)->join();
             }
-            _listReadThreads.clear();
+            _vquerythreads.clear();
+
             _condHasWork.notify_all();
             if( !!_workerthread ) {
                 _workerthread->join();
             }
             _workerthread.reset();
 
+            FOREACH(it, _mapConnections) {
+                boost::mutex::scoped_lock lock(it->second->mutex);
+                if( it->second->sockfd >= 0 ) {
+                    CLOSESOCKET(it->second->sockfd); it->second->sockfd = -1;
+                }
+            }
+            _mapConnections.clear();
+            _listCommands.clear();
+            _listQueries.clear();
+            _listWaits.clear();
+            _listSwitchedConnections.clear();
+            _poller.reset();
+
             bCloseThread = false;
             bInitThread = false;
 
@@ -478,6 +652,56 @@ private:
         return boost::static_pointer_cast<SimpleTextServer const>(shared_from_this());
     }
 
+    static bool _SetNonBlocking(int sockfd)
+    {
+#ifdef _WIN32
+        u_long flags = 1;
+        ioctlsocket(sockfd, FIONBIO, &flags);
+#else
+        int flags;
+
+        // If they have O_NONBLOCK, use the Posix way to do it
+#if defined(O_NONBLOCK)
+        // Fixme: O_NONBLOCK is defined but broken on SunOS 4.1.x and AIX 3.2.5.
+        if (-1 == (flags = fcntl(sockfd, F_GETFL, 0))) {
+            flags = 0;
+        }
+        if( fcntl(sockfd, F_SETFL, flags | O_NONBLOCK) < 0 ) {
+            return false;
+        }
+#else
+        // Otherwise, use the old way of doing it
+        flags = 1;
+        if( ioctl(sockfd, FIOBIO, &flags) < 0 ) {
+            return false;
+        }
+#endif
+#endif
+        return true;
+    }
+
+    /// \brief returns true if the last socket call failed only because it would have blocked
+    static bool _IsSocketBlocked()
+    {
+#ifdef _WIN32
+        int err = WSAGetLastError();
+        return err == WSAEWOULDBLOCK || err == WSAEINTR;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+    }
+
+    static void _NoCleanup(EnvironmentBasePtr* ppenv)
+    {
+    }
+
+    /// \brief the environment the server functions should use: the cloned environment of the query thread when executing an ET_Query command, otherwise the server environment
+    EnvironmentBasePtr _GetQueryEnv()
+    {
+        EnvironmentBasePtr* ppenv = _ppenvquery.get();
+        return !!ppenv && !!*ppenv ? *ppenv : GetEnv();
+    }
+
     // called from threads other than the main worker to wait until
     void _SyncWithWorkerThread()
     {
@@ -510,146 +734,767 @@ private:
                     continue;
                 }
 
-                *(volatile bool*)&_bWorking = true;
-                listlocalworkers.swap(listWorkers);
+                *(volatile bool*)&_bWorking = true;
+                listlocalworkers.swap(listWorkers);
+            }
+
+            // transfer the current workers to a temporary list so
+            FOREACH(it, listlocalworkers) {
+                try {
+                    (*it)();
+                }
+                catch(const std::exception& ex) {
+                    RAVELOG_FATAL("server caught exception: %s\n",ex.what());
+                }
+                catch(...) {
+                    RAVELOG_FATAL("unknown exception!!\n");
+                }
+            }
+            listlocalworkers.clear();
+
+            {
+                // the workers could have modified the environment
+                boost::mutex::scoped_lock lock(_mutexRequests);
+                ++_nServerStamp;
+            }
+            *(volatile bool*)&_bWorking = false;
+            _condWorker.notify_all();
+        }
+    }
+
+    /// \brief the event thread, accepts the connections and reads the requests of all the clients
+    void _listen_threadcb()
+    {
+        std::vector< std::pair<int, int> > vevents;
+        while(!bCloseThread) {
+            bool bWaiting;
+            {
+                boost::mutex::scoped_lock lock(_mutexEvents);
+                bWaiting = _listWaits.size() > 0;
+            }
+            // the controllers of the deferred waits are polled every millisecond
+            if( _poller->Wait(bWaiting ? 1 : 100, vevents) < 0 ) {
+                RAVELOG_WARN("failed to wait for socket events\n");
+                usleep(1000);
+                continue;
+            }
+            _CheckWaits();
+            _CheckSwitchedConnections();
+
+            FOREACH(itevent, vevents) {
+                if( itevent->first == server_sockfd ) {
+                    _AcceptConnections();
+                    continue;
+                }
+                map<int, ConnectionPtr>::iterator itconn = _mapConnections.find(itevent->first);
+                if( itconn == _mapConnections.end() ) {
+                    continue;
+                }
+                ConnectionPtr pconn = itconn->second;
+                bool bClose = false;
+                if( itevent->second & SocketPoller::PE_Read ) {
+                    bClose = !_ReadConnection(pconn);
+                }
+                else if( itevent->second & SocketPoller::PE_Error ) {
+                    bClose = true;
+                }
+                {
+                    boost::mutex::scoped_lock lock(pconn->mutex);
+                    if( !bClose && !pconn->bclosed && (itevent->second & SocketPoller::PE_Write) ) {
+                        _FlushConnection(*pconn);
+                    }
+                    bClose |= pconn->bclosed;
+                }
+                if( bClose ) {
+                    _CloseConnection(pconn);
+                }
+            }
+        }
+
+        RAVELOG_DEBUG("**Server thread exiting\n");
+    }
+
+    /// \brief replies to the deferred waits whose controllers are done or whose timeouts expired, then executes the next requests of their connections
+    void _CheckWaits()
+    {
+        list< pair<ConnectionPtr, RequestPtr> > listdone;
+        {
+            boost::mutex::scoped_lock lock(_mutexEvents);
+            uint64_t curtime = utils::GetMicroTime();
+            list< pair<ConnectionPtr, RequestPtr> >::iterator itwait = _listWaits.begin();
+            while( itwait != _listWaits.end() ) {
+                const WAITREQUEST& wait = *itwait->second->pwait;
+                bool bClosed;
+                {
+                    boost::mutex::scoped_lock lockconn(itwait->first->mutex);
+                    bClosed = itwait->first->bclosed;
+                }
+                if( bClosed || wait.pcontroller->IsDone() || (wait.endtime > 0 && curtime >= wait.endtime) ) {
+                    listdone.splice(listdone.end(), _listWaits, itwait++);
+                }
+                else {
+                    ++itwait;
+                }
+            }
+        }
+        FOREACH(itdone, listdone) {
+            RequestPtr prequest = itdone->second;
+            // only succeed if the controller finished
+            _SendReply(itdone->first, prequest->pwait->pcontroller->IsDone() ? "1" : "0", 1);
+            _RecordLatency(prequest->cmd, utils::GetMicroTime()-prequest->starttime);
+            prequest->pwait.reset();
+            _ExecuteNextRequest(itdone->first);
+        }
+    }
+
+    /// \brief sets the mode of the connections whose binary command replied and parses the bytes they received after it
+    void _CheckSwitchedConnections()
+    {
+        list< pair<ConnectionPtr, bool> > listswitched;
+        {
+            boost::mutex::scoped_lock lock(_mutexEvents);
+            listswitched.swap(_listSwitchedConnections);
+        }
+        FOREACH(itswitched, listswitched) {
+            ConnectionPtr pconn = itswitched->first;
+            map<int, ConnectionPtr>::iterator itconn = _mapConnections.find(pconn->sockfd);
+            if( itconn == _mapConnections.end() || itconn->second != pconn ) {
+                continue; // closed
+            }
+            pconn->bbinary = itswitched->second;
+            pconn->bswitching = false;
+            if( !_ParseConnection(pconn) ) {
+                _CloseConnection(pconn);
+            }
+        }
+    }
+
+    void _AcceptConnections()
+    {
+        while(1) {
+            struct sockaddr_in client_address;
+            socklen_t client_len = sizeof(client_address);
+            int client_sockfd = accept(server_sockfd, (struct sockaddr *)&client_address, &client_len);
+            if( client_sockfd < 0 ) {
+                break;
+            }
+            if( !_SetNonBlocking(client_sockfd) || !_poller->Add(client_sockfd) ) {
+                RAVELOG_WARN("failed to set up new server connection\n");
+                CLOSESOCKET(client_sockfd);
+                continue;
+            }
+            // replies are small, send them right away
+            int yes = 1;
+            setsockopt(client_sockfd, IPPROTO_TCP, TCP_NODELAY, (const char*)&yes, sizeof(int));
+            _mapConnections[client_sockfd].reset(new Connection(client_sockfd));
+            RAVELOG_VERBOSE("started new server connection\n");
+        }
+    }
+
+    /// \brief stops watching the socket of a connection, the socket is closed once the connection does not execute a request anymore
+    void _CloseConnection(ConnectionPtr pconn)
+    {
+        RAVELOG_VERBOSE("Closing socket connection\n");
+        _poller->Remove(pconn->sockfd);
+        _mapConnections.erase(pconn->sockfd);
+        boost::mutex::scoped_lock lock(pconn->mutex);
+        pconn->bclosed = true;
+        pconn->bremoved = true;
+        pconn->listrequests.clear();
+        if( !pconn->bexecuting && pconn->sockfd >= 0 ) {
+            CLOSESOCKET(pconn->sockfd); pconn->sockfd = -1;
+        }
+    }
+
+    /// \brief reads the available bytes of a connection and schedules the requests of all the complete lines and binary frames
+    ///
+    /// \return false if the connection was closed by the client or failed
+    bool _ReadConnection(ConnectionPtr pconn)
+    {
+        bool bOpen = true;
+        char buffer[4096];
+        while(1) {
+            int nBytesReceived = recv(pconn->sockfd, buffer, sizeof(buffer), 0);
+            if( nBytesReceived > 0 ) {
+                pconn->sreadbuffer.append(buffer, nBytesReceived);
+                continue;
+            }
+            if( nBytesReceived < 0 && _IsSocketBlocked() ) {
+                break;
+            }
+            bOpen = false;
+            break;
+        }
+
+        return _ParseConnection(pconn) && bOpen;
+    }
+
+    /// \brief schedules the requests of all the complete lines and binary frames received by a connection. Stops after the binary command until the connection knows whether it switched to binary frames.
+    ///
+    /// \return false if the connection received an invalid frame
+    bool _ParseConnection(ConnectionPtr pconn)
+    {
+        bool bOpen = true;
+        const string& sbuffer = pconn->sreadbuffer;
+        size_t start = 0;
+        while( start < sbuffer.size() && !pconn->bswitching ) {
+            if( pconn->bbinary ) {
+                uint32_t framesize = 0;
+                if( sbuffer.size()-start < sizeof(framesize) ) {
+                    break;
+                }
+                memcpy(&framesize, &sbuffer[start], sizeof(framesize));
+                if( framesize > s_nMaxFrameSize ) {
+                    RAVELOG_ERROR("binary frame of %d bytes is too big, closing connection\n", framesize);
+                    bOpen = false;
+                    break;
+                }
+                if( sbuffer.size()-start-sizeof(framesize) < framesize ) {
+                    break;
+                }
+                _ParseBinaryRequest(pconn, &sbuffer[start+sizeof(framesize)], framesize);
+                start += sizeof(framesize)+framesize;
+            }
+            else {
+                size_t end = sbuffer.find_first_of("\r\n", start);
+                if( end == string::npos ) {
+                    break;
+                }
+                if( end > start ) {
+                    _ParseRequest(pconn, sbuffer.substr(start, end-start));
+                }
+                if( sbuffer[end] == '\r' && end+1 < sbuffer.size() && sbuffer[end+1] == '\n' ) {
+                    ++end; // the binary frames start after the full line ending
+                }
+                start = end+1;
+            }
+        }
+        pconn->sreadbuffer.erase(0, start);
+        return bOpen;
+    }
+
+    void _ParseRequest(ConnectionPtr pconn, const string& line)
+    {
+        if( !!flog &&( GetEnv()->GetDebugLevel()>0) ) {
+            boost::mutex::scoped_lock lock(_mutexLog);
+            static int index=0;
+            flog << index++ << ": " << line << endl;
+        }
+
+        RequestPtr prequest(new REQUEST());
+        prequest->starttime = utils::GetMicroTime();
+        prequest->is.reset(new stringstream(line));
+        *prequest->is >> prequest->cmd;
+        if( !!*prequest->is ) {
+            std::transform(prequest->cmd.begin(), prequest->cmd.end(), prequest->cmd.begin(), ::tolower);
+            prequest->inputpos = prequest->is->tellg();
+            map<string, RAVENETWORKFN>::const_iterator itfn = mapNetworkFns.find(prequest->cmd);
+            if( itfn != mapNetworkFns.end() ) {
+                prequest->pfn = &itfn->second;
+                prequest->type = itfn->second.type;
+                prequest->bModifiesEnvironment = itfn->second.type == ET_Serialized && itfn->second.bModifiesEnvironment;
+                if( prequest->cmd == "binary" ) {
+                    // the requests following this line are binary frames if the command succeeds
+                    prequest->bSwitchBinary = true;
+                    pconn->bswitching = true;
+                }
+            }
+        }
+        else {
+            prequest->cmd.resize(0);
+        }
+        _QueueRequest(pconn, prequest);
+    }
+
+    /// \brief parses a binary frame: opcode (uint16), reserved (uint16), number of ints (uint32), the ints (int32) and the values (dReal) filling the rest of the frame
+    void _ParseBinaryRequest(ConnectionPtr pconn, const char* pdata, size_t size)
+    {
+        RequestPtr prequest(new REQUEST());
+        prequest->starttime = utils::GetMicroTime();
+        prequest->bBinary = true;
+        uint32_t numints = 0;
+        if( size >= 8 ) {
+            memcpy(&prequest->opcode, pdata, sizeof(prequest->opcode));
+            memcpy(&numints, pdata+4, sizeof(numints));
+        }
+        if( size >= 8 && numints <= (size-8)/sizeof(int32_t) && (size-8-numints*sizeof(int32_t))%sizeof(dReal) == 0 ) {
+            prequest->vints.resize(numints);
+            if( numints > 0 ) {
+                memcpy(&prequest->vints[0], pdata+8, numints*sizeof(int32_t));
+            }
+            size_t offset = 8+numints*sizeof(int32_t);
+            prequest->vvalues.resize((size-offset)/sizeof(dReal));
+            if( prequest->vvalues.size() > 0 ) {
+                memcpy(&prequest->vvalues[0], pdata+offset, size-offset);
+            }
+            map<int, RAVEBINARYFN>::const_iterator itfn = mapBinaryFns.find(prequest->opcode);
+            if( itfn != mapBinaryFns.end() ) {
+                prequest->pbinaryfn = &itfn->second;
+                prequest->cmd = itfn->second.name;
+                prequest->type = itfn->second.type;
+                prequest->bModifiesEnvironment = itfn->second.type == ET_Serialized && itfn->second.bModifiesEnvironment;
+            }
+        }
+        else {
+            RAVELOG_ERROR("malformed binary frame of %d bytes\n", (int)size);
+        }
+        _QueueRequest(pconn, prequest);
+    }
+
+    /// \brief schedules the request if the connection does not execute a request, otherwise queues it after the other requests of the connection
+    void _QueueRequest(ConnectionPtr pconn, RequestPtr prequest)
+    {
+        {
+            boost::mutex::scoped_lock lock(pconn->mutex);
+            if( pconn->bexecuting ) {
+                // pipelined, executed after the requests before it
+                pconn->listrequests.push_back(prequest);
+                return;
+            }
+            pconn->bexecuting = true;
+        }
+        _ScheduleRequest(pconn, prequest);
+    }
+
+    void _ScheduleRequest(ConnectionPtr pconn, RequestPtr prequest)
+    {
+        boost::mutex::scoped_lock lock(_mutexRequests);
+        if( prequest->type != ET_Serialized && _vquerythreads.size() > 0 ) {
+            _listQueries.push_back(make_pair(pconn, prequest));
+            _condHasQuery.notify_one();
+        }
+        else {
+            _listCommands.push_back(make_pair(pconn, prequest));
+            _condHasCommand.notify_one();
+        }
+    }
+
+    /// \brief executes the ET_Serialized commands one at a time
+    void _command_threadcb()
+    {
+        while(!bCloseThread) {
+            ConnectionPtr pconn;
+            RequestPtr prequest;
+            {
+                boost::mutex::scoped_lock lock(_mutexRequests);
+                while( _listCommands.size() == 0 && !bCloseThread ) {
+                    _condHasCommand.wait(lock);
+                }
+                if( bCloseThread ) {
+                    break;
+                }
+                pconn = _listCommands.front().first;
+                prequest = _listCommands.front().second;
+                _listCommands.pop_front();
+            }
+            _ExecuteRequest(pconn, prequest);
+        }
+    }
+
+    /// \brief executes the ET_Query and ET_Concurrent commands, the ET_Query commands use a clone of the environment that is updated whenever the environment changed
+    void _query_threadcb()
+    {
+        EnvironmentBasePtr pclone;
+        std::vector< std::pair<int, int> > vbodystamps;
+        int nserverstamp = -1;
+        while(!bCloseThread) {
+            ConnectionPtr pconn;
+            RequestPtr prequest;
+            {
+                boost::mutex::scoped_lock lock(_mutexRequests);
+                while( _listQueries.size() == 0 && !bCloseThread ) {
+                    _condHasQuery.wait(lock);
+                }
+                if( bCloseThread ) {
+                    break;
+                }
+                pconn = _listQueries.front().first;
+                prequest = _listQueries.front().second;
+                _listQueries.pop_front();
+            }
+
+            if( prequest->type == ET_Query ) {
+                try {
+                    _SyncWithWorkerThread();
+                    _UpdateQueryEnvironment(pclone, vbodystamps, nserverstamp);
+                }
+                catch(const std::exception& ex) {
+                    RAVELOG_WARN("failed to clone the environment for query %s, using the server environment: %s\n", prequest->cmd.c_str(), ex.what());
+                    pclone.reset();
+                    vbodystamps.resize(0);
+                }
+                _ppenvquery.reset(&pclone);
+            }
+            _ExecuteRequest(pconn, prequest);
+            _ppenvquery.reset();
+        }
+
+        if( !!pclone ) {
+            pclone->Destroy();
+        }
+    }
+
+    /// \brief clones the server environment into the environment of a query thread if any body or the server state changed since the last clone
+    ///
+    /// \param vbodystamps the environment ids and update stamps of the bodies at the last clone
+    /// \param nserverstamp the value of _nServerStamp at the last clone
+    void _UpdateQueryEnvironment(EnvironmentBasePtr& pclone, std::vector< std::pair<int, int> >& vbodystamps, int& nserverstamp)
+    {
+        int nnewserverstamp;
+        {
+            boost::mutex::scoped_lock lock(_mutexRequests);
+            nnewserverstamp = _nServerStamp;
+        }
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        std::vector<KinBodyPtr> vbodies;
+        GetEnv()->GetBodies(vbodies);
+        bool bChanged = !pclone || nserverstamp != nnewserverstamp || vbodies.size() != vbodystamps.size();
+        vbodystamps.resize(vbodies.size());
+        for(size_t i = 0; i < vbodies.size(); ++i) {
+            std::pair<int, int> stamp(vbodies[i]->GetEnvironmentId(), vbodies[i]->GetUpdateStamp());
+            if( vbodystamps[i] != stamp ) {
+                vbodystamps[i] = stamp;
+                bChanged = true;
+            }
+        }
+        if( !bChanged ) {
+            return;
+        }
+        if( !pclone ) {
+            pclone = GetEnv()->CloneSelf(Clone_Bodies);
+        }
+        else {
+            pclone->Clone(GetEnv(), Clone_Bodies);
+        }
+        // controllers of the cloned robots should not move them
+        pclone->StopSimulation();
+        nserverstamp = nnewserverstamp;
+    }
+
+    /// \brief executes a request and sends its reply, then schedules the next request of the connection
+    void _ExecuteRequest(ConnectionPtr pconn, RequestPtr prequest)
+    {
+        bool bClosed;
+        {
+            boost::mutex::scoped_lock lock(pconn->mutex);
+            bClosed = pconn->bclosed;
+        }
+        bool bSuccess = false;
+        if( !bClosed ) {
+            if( prequest->bBinary ) {
+                _ProcessBinaryRequest(pconn, *prequest);
+            }
+            else {
+                bSuccess = _ProcessRequest(pconn, *prequest);
+            }
+            if( !!prequest->pwait ) {
+                // the event thread replies and executes the next request of the connection once the wait is done
+                boost::mutex::scoped_lock lock(_mutexEvents);
+                _listWaits.push_back(make_pair(pconn, prequest));
+                _poller->Notify();
+                return;
+            }
+            if( !!prequest->pfn || !!prequest->pbinaryfn ) {
+                _RecordLatency(prequest->cmd, utils::GetMicroTime()-prequest->starttime);
+                if( prequest->bModifiesEnvironment ) {
+                    boost::mutex::scoped_lock lock(_mutexRequests);
+                    ++_nServerStamp;
+                }
+            }
+        }
+        if( prequest->bSwitchBinary ) {
+            // the reply was sent in the old mode, the event thread parses the following bytes in the new mode
+            boost::mutex::scoped_lock lock(_mutexEvents);
+            _listSwitchedConnections.push_back(make_pair(pconn, bSuccess));
+            _poller->Notify();
+        }
+        _ExecuteNextRequest(pconn);
+    }
+
+    /// \brief schedules the next pipelined request of the connection, or closes its socket if the event thread stopped watching it
+    void _ExecuteNextRequest(ConnectionPtr pconn)
+    {
+        RequestPtr pnextrequest;
+        {
+            boost::mutex::scoped_lock lock(pconn->mutex);
+            if( !pconn->bclosed && pconn->listrequests.size() > 0 ) {
+                pnextrequest = pconn->listrequests.front();
+                pconn->listrequests.pop_front();
+            }
+            else {
+                pconn->bexecuting = false;
+                if( pconn->bremoved && pconn->sockfd >= 0 ) {
+                    CLOSESOCKET(pconn->sockfd); pconn->sockfd = -1;
+                }
+            }
+        }
+        if( !!pnextrequest ) {
+            _ScheduleRequest(pconn, pnextrequest);
+        }
+    }
+
+    /// \return true if the network function of the command succeeded
+    bool _ProcessRequest(ConnectionPtr pconn, REQUEST& request)
+    {
+        if( !request.pfn ) {
+            if( request.cmd.size() == 0 ) {
+                RAVELOG_ERROR("Failed to get command\n");
+            }
+            else {
+                RAVELOG_ERROR("Failed to recognize command: %s\n", request.cmd.c_str());
             }
+            _SendReply(pconn, "error\n",1);
+            return false;
+        }
 
-            // transfer the current workers to a temporary list so
-            FOREACH(it, listlocalworkers) {
-                try {
-                    (*it)();
+        const RAVENETWORKFN& fn = *request.pfn;
+        bool bCallWorker = true, bSuccess = true;
+        boost::shared_ptr<void> pdata;
+        stringstream sout;
+        if( !!fn.fnSocketThread ) {
+            bSuccess = false;
+            try {
+                bSuccess = fn.fnSocketThread(*request.is, sout, pdata);
+            }
+            catch(const std::exception& ex) {
+                RAVELOG_FATAL("server caught exception: %s\n",ex.what());
+            }
+            catch(...) {
+                RAVELOG_FATAL("unknown exception!!\n");
+            }
+
+            if( bSuccess ) {
+                if( fn.bDeferReply && !!pdata ) {
+                    request.pwait = boost::static_pointer_cast<WAITREQUEST>(pdata);
+                    return true;
                 }
-                catch(const std::exception& ex) {
-                    RAVELOG_FATAL("server caught exception: %s\n",ex.what());
+                if( fn.bReturnResult ) {
+                    _SendReply(pconn, sout.str().c_str(), sout.str().size());
                 }
-                catch(...) {
-                    RAVELOG_FATAL("unknown exception!!\n");
+                if( !fn.fnWorker ) {
+                    bCallWorker = false;
                 }
             }
-            listlocalworkers.clear();
+            else {
+                bCallWorker = false;
+                if( !!flog  ) {
+                    boost::mutex::scoped_lock lock(_mutexLog);
+                    flog << " error" << endl;
+                }
+                if( fn.bReturnResult ) {
+                    _SendReply(pconn, "error\n", 6);
+                }
+            }
+        }
+        else {
+            if( fn.bReturnResult ) {
+                _SendReply(pconn, sout.str().c_str(), sout.str().size());     // return dummy
+            }
+            bCallWorker = !!fn.fnWorker;
+        }
 
-            *(volatile bool*)&_bWorking = false;
-            _condWorker.notify_all();
+        if( bCallWorker ) {
+            BOOST_ASSERT(!!fn.fnWorker);
+            request.is->clear();
+            request.is->seekg(request.inputpos);
+            ScheduleWorker(boost::bind(fn.fnWorker,request.is,pdata));
         }
+        return bSuccess;
     }
 
-    void _listen_threadcb()
+    /// \brief executes a binary request and sends the reply frame: size of the rest of the frame (uint32), opcode (uint16), status (uint16, 0 on success), number of ints (uint32), the ints (int32) and the values (dReal)
+    void _ProcessBinaryRequest(ConnectionPtr pconn, REQUEST& request)
     {
-        SocketPtr psocket(new Socket());
+        vector<int32_t> vreplyints;
+        vector<dReal> vreplyvalues;
+        bool bSuccess = false;
+        if( !!request.pbinaryfn ) {
+            try {
+                bSuccess = request.pbinaryfn->fn(request.vints, request.vvalues, vreplyints, vreplyvalues);
+            }
+            catch(const std::exception& ex) {
+                RAVELOG_FATAL("server caught exception: %s\n",ex.what());
+            }
+            catch(...) {
+                RAVELOG_FATAL("unknown exception!!\n");
+            }
+        }
+        else {
+            RAVELOG_ERROR("Failed to recognize binary command: %d\n", (int)request.opcode);
+        }
+        if( !bSuccess ) {
+            vreplyints.resize(0);
+            vreplyvalues.resize(0);
+        }
+
+        char header[12];
+        uint32_t size = 8+vreplyints.size()*sizeof(int32_t)+vreplyvalues.size()*sizeof(dReal);
+        uint16_t status = bSuccess ? 0 : 1;
+        uint32_t numints = vreplyints.size();
+        memcpy(header, &size, 4);
+        memcpy(header+4, &request.opcode, 2);
+        memcpy(header+6, &status, 2);
+        memcpy(header+8, &numints, 4);
+        vector< pair<const char*, size_t> > vbuffers;
+        vbuffers.push_back(make_pair((const char*)header, sizeof(header)));
+        if( vreplyints.size() > 0 ) {
+            vbuffers.push_back(make_pair((const char*)&vreplyints[0], vreplyints.size()*sizeof(int32_t)));
+        }
+        if( vreplyvalues.size() > 0 ) {
+            vbuffers.push_back(make_pair((const char*)&vreplyvalues[0], vreplyvalues.size()*sizeof(dReal)));
+        }
+        _SendReplyBuffers(pconn, vbuffers);
+    }
 
-        while(!bCloseThread) {
+    /// \brief queues a reply of size bytes preceded by its size and sends it if the socket allows it
+    void _SendReply(ConnectionPtr pconn, const void* pdata, int size)
+    {
+        boost::mutex::scoped_lock lock(pconn->mutex);
+        if( pconn->bclosed ) {
+            return;
+        }
+        pconn->swritebuffer.append((const char*)&size, 4);
+        pconn->swritebuffer.append((const char*)pdata, size);
+        _FlushConnection(*pconn);
+    }
 
-            // finally initialize the socket
-            if( !psocket->Accept(server_sockfd) ) {
-                usleep(100000);
+    /// \brief sends a reply made of several buffers. If no earlier reply is pending, the buffers are sent with one gather write without copying them.
+    void _SendReplyBuffers(ConnectionPtr pconn, const vector< pair<const char*, size_t> >& vbuffers)
+    {
+        boost::mutex::scoped_lock lock(pconn->mutex);
+        if( pconn->bclosed ) {
+            return;
+        }
+        size_t nsent = 0;
+#ifndef _WIN32
+        if( pconn->swritebuffer.size() == 0 && vbuffers.size() <= 8 ) {
+            struct iovec iov[8];
+            for(size_t i = 0; i < vbuffers.size(); ++i) {
+                iov[i].iov_base = (void*)vbuffers[i].first;
+                iov[i].iov_len = vbuffers[i].second;
+            }
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = vbuffers.size();
+            ssize_t nBytesSent = sendmsg(pconn->sockfd, &msg, TEXTSERVER_SENDFLAGS);
+            if( nBytesSent > 0 ) {
+                nsent = nBytesSent;
+            }
+            else if( nBytesSent < 0 && !_IsSocketBlocked() ) {
+                RAVELOG_ERROR("failed to send reply: %d\n", (int)nBytesSent);
+                _FailConnection(*pconn);
+                return;
+            }
+        }
+#endif
+        // queue what could not be sent
+        FOREACHC(itbuffer, vbuffers) {
+            if( nsent >= itbuffer->second ) {
+                nsent -= itbuffer->second;
                 continue;
             }
-
-            // start a new thread
-            _listReadThreads.push_back(boost::shared_ptr<boost::thread>(new boost::thread(boost::bind(&SimpleTextServer::_read_threadcb,shared_server(), psocket))));
-            psocket.reset(new Socket());
+            pconn->swritebuffer.append(itbuffer->first+nsent, itbuffer->second-nsent);
+            nsent = 0;
         }
-
-        RAVELOG_DEBUG("**Server thread exiting\n");
+        _FlushConnection(*pconn);
     }
 
-    void _read_threadcb(SocketPtr psocket)
+    /// \brief stops executing the requests of a connection after a socket error, the event thread closes the socket when it notices the error. Assumes the mutex of the connection is locked.
+    void _FailConnection(Connection& conn)
     {
-        RAVELOG_VERBOSE("started new server connection\n");
-        string cmd, line;
-        stringstream sout;
-        while(!bCloseThread) {
-            if( psocket->ReadLine(line) && line.length() ) {
-
-                if( !!flog &&( GetEnv()->GetDebugLevel()>0) ) {
-                    static int index=0;
-                    flog << index++ << ": " << line << endl;
-                }
-
-                boost::shared_ptr<istream> is(new stringstream(line));
-                *is >> cmd;
-                if( !*is ) {
-                    RAVELOG_ERROR("Failed to get command\n");
-                    psocket->SendData("error\n",1);
-                    continue;
-                }
-                std::transform(cmd.begin(), cmd.end(), cmd.begin(), ::tolower);
-                stringstream::streampos inputpos = is->tellg();
-
-                map<string, RAVENETWORKFN>::iterator itfn = mapNetworkFns.find(cmd);
-                if( itfn != mapNetworkFns.end() ) {
-                    bool bCallWorker = true;
-                    boost::shared_ptr<void> pdata;
-
-                    // need to set w.args before pcmdend is modified
-                    sout.str(""); sout.clear();
-                    if( !!itfn->second.fnSocketThread ) {
-                        bool bSuccess = false;
-                        try {
-                            bSuccess = itfn->second.fnSocketThread(*is, sout, pdata);
-                        }
-                        catch(const std::exception& ex) {
-                            RAVELOG_FATAL("server caught exception: %s\n",ex.what());
-                        }
-                        catch(...) {
-                            RAVELOG_FATAL("unknown exception!!\n");
-                        }
-
-                        if( bSuccess ) {
-                            if( itfn->second.bReturnResult ) {
-                                psocket->SendData(sout.str().c_str(), sout.str().size());
-                            }
-                            if( !itfn->second.fnWorker ) {
-                                bCallWorker = false;
-                            }
-                        }
-                        else {
-                            bCallWorker = false;
-                            if( !!flog  ) {
-                                flog << " error" << endl;
-                            }
-                            if( itfn->second.bReturnResult ) {
-                                psocket->SendData("error\n", 6);
-                            }
-                        }
-                    }
-                    else {
-                        if( itfn->second.bReturnResult ) {
-                            psocket->SendData(sout.str().c_str(), sout.str().size());     // return dummy
-                        }
-                        bCallWorker = !!itfn->second.fnWorker;
-                    }
+        conn.bclosed = true;
+        conn.swritebuffer.resize(0);
+        conn.nwriteoffset = 0;
+        conn.listrequests.clear();
+    }
 
-                    if( bCallWorker ) {
-                        BOOST_ASSERT(!!itfn->second.fnWorker);
-                        is->clear();
-                        is->seekg(inputpos);
-                        ScheduleWorker(boost::bind(itfn->second.fnWorker,is,pdata));
-                    }
-                }
-                else {
-                    RAVELOG_ERROR("Failed to recognize command: %s\n", cmd.c_str());
-                    psocket->SendData("error\n",1);
-                }
+    /// \brief sends as much of the pending replies as possible without blocking, assumes the mutex of the connection is locked
+    void _FlushConnection(Connection& conn)
+    {
+        while( conn.nwriteoffset < conn.swritebuffer.size() ) {
+            int nBytesSent = send(conn.sockfd, conn.swritebuffer.c_str()+conn.nwriteoffset, conn.swritebuffer.size()-conn.nwriteoffset, TEXTSERVER_SENDFLAGS);
+            if( nBytesSent > 0 ) {
+                conn.nwriteoffset += nBytesSent;
+                continue;
             }
-            else if( !psocket->IsInit() ) {
+            if( nBytesSent < 0 && _IsSocketBlocked() ) {
                 break;
             }
-            usleep(1000);
+            RAVELOG_ERROR("failed to send reply: %d\n", nBytesSent);
+            _FailConnection(conn);
+            return;
         }
 
-        RAVELOG_VERBOSE("Closing socket connection\n");
+        if( conn.nwriteoffset >= conn.swritebuffer.size() ) {
+            conn.swritebuffer.resize(0);
+            conn.nwriteoffset = 0;
+        }
+        else if( conn.nwriteoffset > 65536 ) {
+            conn.swritebuffer.erase(0, conn.nwriteoffset);
+            conn.nwriteoffset = 0;
+        }
+        bool bWriting = conn.swritebuffer.size() > 0;
+        if( conn.bwriting != bWriting ) {
+            _poller->SetWriting(conn.sockfd, bWriting);
+            conn.bwriting = bWriting;
+        }
+    }
+
+    void _RecordLatency(const string& cmd, uint64_t latency)
+    {
+        int ibin = 0;
+        while( ibin+1 < (int)boost::array<uint64_t, 24>::static_size && latency >= (uint64_t(2)<<ibin) ) {
+            ++ibin;
+        }
+        boost::mutex::scoped_lock lock(_mutexStats);
+        COMMANDSTATS& stats = _mapStats[cmd];
+        stats.count++;
+        stats.totaltime += latency;
+        stats.maxtime = max(stats.maxtime, latency);
+        stats.vhistogram[ibin]++;
+    }
+
+    /// \brief upper bound of the latency of the given fraction of the requests computed from the histogram, us
+    static uint64_t _GetLatencyPercentile(const COMMANDSTATS& stats, dReal fraction)
+    {
+        uint64_t count = 0;
+        for(size_t ibin = 0; ibin < stats.vhistogram.size(); ++ibin) {
+            count += stats.vhistogram[ibin];
+            if( count > 0 && count >= fraction*stats.count ) {
+                return min(uint64_t(2)<<ibin, stats.maxtime);
+            }
+        }
+        return stats.maxtime;
     }
 
     int _nPort;     ///< port used for listening to incoming connections
+    int _nQueryThreads; ///< number of threads executing ET_Query and ET_Concurrent commands
 
-    boost::shared_ptr<boost::thread> _servthread, _workerthread;
-    list<boost::shared_ptr<boost::thread> > _listReadThreads;
+    boost::shared_ptr<boost::thread> _servthread, _workerthread, _commandthread;
+    vector<boost::shared_ptr<boost::thread> > _vquerythreads;
+
+    boost::shared_ptr<SocketPoller> _poller;
+    map<int, ConnectionPtr> _mapConnections; ///< only used by the event thread
+    boost::thread_specific_ptr<EnvironmentBasePtr> _ppenvquery; ///< the cloned environment of the query thread while it executes an ET_Query command
 
     boost::mutex _mutexWorker;
     boost::condition _condWorker;
     boost::condition _condHasWork;
 
+    boost::mutex _mutexRequests; ///< protects _listCommands, _listQueries and _nServerStamp
+    boost::condition _condHasCommand, _condHasQuery;
+    list< pair<ConnectionPtr, RequestPtr> > _listCommands; ///< requests waiting for the command thread
+    list< pair<ConnectionPtr, RequestPtr> > _listQueries; ///< requests waiting for a query thread
+    int _nServerStamp; ///< incremented every time a command or worker that can modify the environment finished
+
+    boost::mutex _mutexEvents; ///< protects _listWaits and _listSwitchedConnections
+    list< pair<ConnectionPtr, RequestPtr> > _listWaits; ///< wait commands whose replies are deferred, checked by the event thread
+    list< pair<ConnectionPtr, bool> > _listSwitchedConnections; ///< connections whose binary command replied and whether they switched to binary frames
+
+    boost::mutex _mutexStats;
+    map<string, COMMANDSTATS> _mapStats;
+
     bool bInitThread;
     bool bCloseThread;
     bool bDestroying;
@@ -657,10 +1502,16 @@ private:
     struct sockaddr_in server_address;
     int server_sockfd, server_len;
 
+    boost::mutex _mutexLog;
     ofstream flog;
 
     list<boost::function<void()> > listWorkers;
     map<string, RAVENETWORKFN> mapNetworkFns;
+    map<int, RAVEBINARYFN> mapBinaryFns;
+    static const uint32_t s_nMaxFrameSize = 0x4000000; ///< larger binary frames close the connection
+
+    boost::mutex _mutexTrajectories;
+    map<int, TrajectoryBasePtr> _mapTrajectories; ///< the last trajectory set on the controller of every robot, indexed by the environment id of the robot. Protected by _mutexTrajectories.
 
     int _nIdIndex;
     map<int, ModuleBasePtr > _mapModules;
@@ -678,7 +1529,7 @@ protected:
         if( !is ) {
             return KinBodyPtr();
         }
-        return GetEnv()->GetBodyFromEnvironmentId(index);
+        return _GetQueryEnv()->GetBodyFromEnvironmentId(index);
     }
 
     RobotBasePtr orMacroGetRobot(istream& is)
@@ -688,7 +1539,7 @@ protected:
         if( !is ) {
             return RobotBasePtr();
         }
-        KinBodyPtr pbody = GetEnv()->GetBodyFromEnvironmentId(index);
+        KinBodyPtr pbody = _GetQueryEnv()->GetBodyFromEnvironmentId(index);
         if( !pbody || !pbody->IsRobot() ) {
             return RobotBasePtr();
         }
@@ -988,9 +1839,9 @@ protected:
             return false;
         }
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
 
-        KinBodyPtr pbody = GetEnv()->GetKinBody(bodyname);
+        KinBodyPtr pbody = _GetQueryEnv()->GetKinBody(bodyname);
         if( !pbody ) {
             os << "0";
         }
@@ -1003,10 +1854,10 @@ protected:
     bool orEnvGetRobots(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
 
         vector<RobotBasePtr> vrobots;
-        GetEnv()->GetRobots(vrobots);
+        _GetQueryEnv()->GetRobots(vrobots);
 
         os << vrobots.size() << " ";
         FOREACHC(it, vrobots) {
@@ -1018,10 +1869,10 @@ protected:
     bool orEnvGetBodies(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
 
         vector<KinBodyPtr> vbodies;
-        GetEnv()->GetBodies(vbodies);
+        _GetQueryEnv()->GetBodies(vbodies);
         os << vbodies.size() << " ";
         FOREACHC(it, vbodies) {
             os << (*it)->GetEnvironmentId() << " " << (*it)->GetName() << " " << (*it)->GetXMLId() << " " << (*it)->GetURI() << "\n ";
@@ -1115,7 +1966,7 @@ protected:
     bool orBodyGetLinks(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         KinBodyPtr body = orMacroGetBody(is);
         if( !body ) {
             return false;
@@ -1530,7 +2381,7 @@ protected:
     bool orRobotCheckSelfCollision(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         KinBodyPtr probot = orMacroGetBody(is);
         if( !probot ) {
             return false;
@@ -1544,7 +2395,7 @@ protected:
     bool orRobotGetActiveDOF(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         RobotBasePtr probot = orMacroGetRobot(is);
         if( !probot ) {
             return false;
@@ -1557,7 +2408,7 @@ protected:
     bool orBodyGetAABB(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         KinBodyPtr pbody = orMacroGetBody(is);
         if( !pbody ) {
             return false;
@@ -1571,7 +2422,7 @@ protected:
     bool orBodyGetAABBs(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         KinBodyPtr pbody = orMacroGetBody(is);
         if( !pbody ) {
             return false;
@@ -1588,7 +2439,7 @@ protected:
     bool orBodyGetDOF(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         KinBodyPtr pbody = orMacroGetBody(is);
         if( !pbody ) {
             return false;
@@ -1601,7 +2452,7 @@ protected:
     bool orBodyGetJointValues(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         KinBodyPtr pbody = orMacroGetBody(is);
         if( !pbody ) {
             return false;
@@ -1634,7 +2485,7 @@ protected:
     bool orRobotGetDOFValues(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         RobotBasePtr probot = orMacroGetRobot(is);
         if( !probot ) {
             return false;
@@ -1666,7 +2517,7 @@ protected:
     bool orRobotGetDOFLimits(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         RobotBasePtr probot = orMacroGetRobot(is);
         if( !probot ) {
             return false;
@@ -1687,7 +2538,7 @@ protected:
     bool orRobotGetManipulators(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         RobotBasePtr probot = orMacroGetRobot(is);
         if( !probot ) {
             return false;
@@ -2015,6 +2866,13 @@ protected:
             return false;
         }
 
+        _StartActiveTrajectory(probot, spec, vpoints, havetime, havetrans);
+        return true;
+    }
+
+    /// \brief retimes the points of an active dof trajectory and sets it on the controller of the robot, assumes the environment is locked
+    void _StartActiveTrajectory(RobotBasePtr probot, const ConfigurationSpecification& spec, const vector<dReal>& vpoints, bool havetime, bool havetrans)
+    {
         // add all the points
         TrajectoryBasePtr ptraj = RaveCreateTrajectory(GetEnv(),"");
         ptraj->Init(spec);
@@ -2025,14 +2883,15 @@ protected:
         }
         planningutils::RetimeActiveDOFTrajectory(ptraj,probot,havetime);
         probot->GetController()->SetPath(ptraj);
-        return true;
+        boost::mutex::scoped_lock lock(_mutexTrajectories);
+        _mapTrajectories[probot->GetEnvironmentId()] = ptraj;
     }
 
     /// [collision, bodycolliding] = orEnvCheckCollision(body) - returns whether a certain body is colliding with the scene
     bool orEnvCheckCollision(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         KinBodyPtr pbody = orMacroGetBody(is);
         if( !pbody ) {
             return false;
@@ -2047,7 +2906,7 @@ protected:
                 return false;
             }
             if( bodyid ) {
-                KinBodyPtr pignore = GetEnv()->GetBodyFromEnvironmentId(bodyid);
+                KinBodyPtr pignore = _GetQueryEnv()->GetBodyFromEnvironmentId(bodyid);
                 if( !pignore ) {
                     RAVELOG_WARN("failed to find body %d",bodyid);
                 }
@@ -2062,9 +2921,9 @@ protected:
 
         CollisionReportPtr preport(new CollisionReport());
         vector<KinBody::LinkConstPtr> empty;
-        CollisionOptionsStateSaver optionsaver(GetEnv()->GetCollisionChecker(),CO_Contacts);
+        CollisionOptionsStateSaver optionsaver(_GetQueryEnv()->GetCollisionChecker(),CO_Contacts);
         if( linkindex >= 0 ) {
-            if( GetEnv()->CheckCollision(KinBody::LinkConstPtr(pbody->GetLinks().at(linkindex)), vignore, empty,preport)) {
+            if( _GetQueryEnv()->CheckCollision(KinBody::LinkConstPtr(pbody->GetLinks().at(linkindex)), vignore, empty,preport)) {
                 os << "1 ";
             }
             else {
@@ -2072,7 +2931,7 @@ protected:
             }
         }
         else {
-            if( GetEnv()->CheckCollision(KinBodyConstPtr(pbody), vignore, empty,preport)) {
+            if( _GetQueryEnv()->CheckCollision(KinBodyConstPtr(pbody), vignore, empty,preport)) {
                 os << "1 ";
             }
             else {
@@ -2104,11 +2963,11 @@ protected:
     bool orEnvRayCollision(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
         KinBodyPtr pbody = orMacroGetBody(is);
 
-        int oldoptions = GetEnv()->GetCollisionChecker()->GetCollisionOptions();
-        GetEnv()->GetCollisionChecker()->SetCollisionOptions(oldoptions|CO_Contacts);
+        int oldoptions = _GetQueryEnv()->GetCollisionChecker()->GetCollisionOptions();
+        _GetQueryEnv()->GetCollisionChecker()->SetCollisionOptions(oldoptions|CO_Contacts);
 
         CollisionReportPtr preport(new CollisionReport());
         RAY r;
@@ -2121,10 +2980,10 @@ protected:
                 break;
             }
             if(!pbody) {
-                bcollision = GetEnv()->CheckCollision(r, preport);
+                bcollision = _GetQueryEnv()->CheckCollision(r, preport);
             }
             else {
-                bcollision = GetEnv()->CheckCollision(r, KinBodyConstPtr(pbody), preport);
+                bcollision = _GetQueryEnv()->CheckCollision(r, KinBodyConstPtr(pbody), preport);
             }
             if(bcollision) {
                 BOOST_ASSERT(preport->contacts.size()>0);
@@ -2141,7 +3000,7 @@ protected:
             }
         }
 
-        GetEnv()->GetCollisionChecker()->SetCollisionOptions(oldoptions);
+        _GetQueryEnv()->GetCollisionChecker()->SetCollisionOptions(oldoptions);
         FOREACH(it, info) {
             os << *it << " ";
         }
@@ -2180,17 +3039,17 @@ protected:
         is >> inclusive;
         vector<int> vobjids = vector<int>((istream_iterator<int>(is)), istream_iterator<int>());
 
-        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
 
         vector<KinBodyPtr> vbodies;
-        GetEnv()->GetBodies(vbodies);
+        _GetQueryEnv()->GetBodies(vbodies);
 
         TriMesh trimesh;
         FOREACH(itbody, vbodies) {
             if( (find(vobjids.begin(),vobjids.end(),(*itbody)->GetEnvironmentId()) == vobjids.end()) ^ !inclusive ) {
                 continue;
             }
-            GetEnv()->Triangulate(trimesh, **itbody);
+            _GetQueryEnv()->Triangulate(trimesh, **itbody);
         }
 
         BOOST_ASSERT( (trimesh.indices.size()%3) == 0 );
@@ -2205,14 +3064,14 @@ protected:
     }
 
     // waits for rave to finish commands
-    // if a robot id is specified, also waits for that robot's trajectory to finish
+    // if a robot id is specified, also waits for that robot's trajectory to finish. The reply is deferred to the event
+    // thread, so the query thread does not poll the controller.
     bool orEnvWait(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
     {
         _SyncWithWorkerThread();
         RobotBasePtr probot;
         ControllerBasePtr pcontroller;
-        int timeout = -1;
-        dReal ftimeout;
+        dReal ftimeout = 0;
 
         {
             EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
@@ -2223,34 +3082,246 @@ protected:
             }
 
             is >> ftimeout;
-            if( !!is ) {
-                timeout = (int)(1000*ftimeout);
+            if( !is ) {
+                ftimeout = 0;
             }
             pcontroller = probot->GetController();
         }
 
-        if( !!pcontroller ) {
-            while( !pcontroller->IsDone() ) {
-                usleep(1000);
-                if( timeout > 0 ) {
-                    if( --timeout == 0 )
-                        break;
-                }
-                if( bCloseThread ) {
-                    return false;
-                }
+        if( !pcontroller || pcontroller->IsDone() ) {
+            os << "1";
+            return true;
+        }
+
+        WaitRequestPtr pwait(new WAITREQUEST());
+        pwait->pcontroller = pcontroller;
+        if( ftimeout > 0 ) {
+            pwait->endtime = utils::GetMicroTime() + (uint64_t)(1000000*ftimeout);
+        }
+        pdata = pwait;
+        return true;
+    }
+
+    /// stats [reset] - returns the latency statistics of the executed commands, one line per command:
+    /// name count mean max p50 p99 h0 ... h23
+    /// latencies are in us from receiving the request until its reply is sent, hi is the number of requests with latencies in [2^i,2^(i+1)) us.
+    /// if reset is specified, the statistics are cleared after being returned
+    bool orServerStats(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
+    {
+        string cmd;
+        is >> cmd;
+        boost::mutex::scoped_lock lock(_mutexStats);
+        FOREACHC(it, _mapStats) {
+            const COMMANDSTATS& stats = it->second;
+            os << it->first << " " << stats.count << " " << (stats.count > 0 ? stats.totaltime/stats.count : 0) << " " << stats.maxtime << " " << _GetLatencyPercentile(stats, 0.5) << " " << _GetLatencyPercentile(stats, 0.99);
+            FOREACHC(itbin, stats.vhistogram) {
+                os << " " << *itbin;
             }
+            os << endl;
+        }
+        if( cmd == "reset" ) {
+            _mapStats.clear();
+        }
+        return true;
+    }
 
-            if( timeout != 0 ) {     // only ret success
-                os << "1";
+    /// binary - switches the connection to binary frames, returns "1 sizeof(dReal)", or fails if the server is not little endian.
+    /// the line must end with '\n'. Once the command succeeded, the next bytes are binary frames and the connection stays binary until it is closed. If it fails, the connection keeps reading lines.
+    /// every request frame is: size of the rest of the frame (uint32), opcode (uint16, one of BinaryCommand), reserved (uint16), number of ints (uint32), the ints (int32) and the values (dReal)
+    /// every reply frame is: size of the rest of the frame (uint32), opcode (uint16), status (uint16, 0 on success), number of ints (uint32), the ints (int32) and the values (dReal)
+    bool orEnvBinary(istream& is, ostream& os, boost::shared_ptr<void>& pdata)
+    {
+        // the frames are parsed with the byte order of the server, so binary is only enabled where it is little endian
+        uint16_t test = 1;
+        if( *(const char*)&test != 1 ) {
+            return false;
+        }
+        os << "1 " << sizeof(dReal);
+        return true;
+    }
+
+    KinBodyPtr _GetBinaryBody(const vector<int32_t>& vints)
+    {
+        if( vints.size() == 0 ) {
+            return KinBodyPtr();
+        }
+        return _GetQueryEnv()->GetBodyFromEnvironmentId(vints[0]);
+    }
+
+    bool bGetDOFValues(const vector<int32_t>& vints, const vector<dReal>& vvalues, vector<int32_t>& vreplyints, vector<dReal>& vreplyvalues)
+    {
+        _SyncWithWorkerThread();
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
+        KinBodyPtr pbody = _GetBinaryBody(vints);
+        if( !pbody ) {
+            return false;
+        }
+        if( vints.size() == 1 ) {
+            pbody->GetDOFValues(vreplyvalues);
+            return true;
+        }
+        vector<dReal> vdofvalues;
+        pbody->GetDOFValues(vdofvalues);
+        vreplyvalues.resize(vints.size()-1);
+        for(size_t i = 1; i < vints.size(); ++i) {
+            if( vints[i] < 0 || vints[i] >= (int)vdofvalues.size() ) {
+                RAVELOG_ERROR("bad index: %d\n", vints[i]);
+                return false;
             }
-            else {
-                os << "0";
+            vreplyvalues[i-1] = vdofvalues[vints[i]];
+        }
+        return true;
+    }
+
+    bool bSetDOFValues(const vector<int32_t>& vints, const vector<dReal>& vvalues, vector<int32_t>& vreplyints, vector<dReal>& vreplyvalues)
+    {
+        _SyncWithWorkerThread();
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        KinBodyPtr pbody = _GetBinaryBody(vints);
+        if( !pbody ) {
+            return false;
+        }
+        vector<dReal> vdofvalues;
+        if( vints.size() == 1 ) {
+            if( (int)vvalues.size() != pbody->GetDOF() ) {
+                return false;
             }
+            vdofvalues = vvalues;
         }
         else {
-            os << "1";
+            if( vvalues.size() != vints.size()-1 ) {
+                return false;
+            }
+            pbody->GetDOFValues(vdofvalues);
+            for(size_t i = 1; i < vints.size(); ++i) {
+                if( vints[i] < 0 || vints[i] >= (int)vdofvalues.size() ) {
+                    RAVELOG_ERROR("bad index: %d\n", vints[i]);
+                    return false;
+                }
+                vdofvalues[vints[i]] = vvalues[i-1];
+            }
+        }
+        pbody->SetDOFValues(vdofvalues, true);
+        if( pbody->IsRobot() ) {
+            // if robot, have to turn off any trajectory following
+            RobotBasePtr probot = RaveInterfaceCast<RobotBase>(pbody);
+            if( !!probot->GetController() ) {
+                // reget the values since they'll go through the joint limits
+                probot->GetDOFValues(vdofvalues);
+                probot->GetController()->SetDesired(vdofvalues);
+            }
+        }
+        return true;
+    }
+
+    bool bGetTransform(const vector<int32_t>& vints, const vector<dReal>& vvalues, vector<int32_t>& vreplyints, vector<dReal>& vreplyvalues)
+    {
+        _SyncWithWorkerThread();
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
+        KinBodyPtr pbody = _GetBinaryBody(vints);
+        if( !pbody ) {
+            return false;
+        }
+        Transform t = pbody->GetTransform();
+        vreplyvalues.resize(7);
+        vreplyvalues[0] = t.rot.x; vreplyvalues[1] = t.rot.y; vreplyvalues[2] = t.rot.z; vreplyvalues[3] = t.rot.w;
+        vreplyvalues[4] = t.trans.x; vreplyvalues[5] = t.trans.y; vreplyvalues[6] = t.trans.z;
+        return true;
+    }
+
+    bool bSetTransform(const vector<int32_t>& vints, const vector<dReal>& vvalues, vector<int32_t>& vreplyints, vector<dReal>& vreplyvalues)
+    {
+        _SyncWithWorkerThread();
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        KinBodyPtr pbody = _GetBinaryBody(vints);
+        if( !pbody || vvalues.size() != 7 ) {
+            return false;
+        }
+        Transform t;
+        t.rot = Vector(vvalues[0], vvalues[1], vvalues[2], vvalues[3]);
+        t.trans = Vector(vvalues[4], vvalues[5], vvalues[6]);
+        t.rot.normalize4();
+        pbody->SetTransform(t);
+        if( pbody->IsRobot() ) {
+            RobotBasePtr probot = RaveInterfaceCast<RobotBase>(pbody);
+            if( !!probot->GetController() ) {
+                // if robot, reset the trajectory
+                probot->GetController()->Reset(0);
+            }
+        }
+        return true;
+    }
+
+    bool bCheckCollision(const vector<int32_t>& vints, const vector<dReal>& vvalues, vector<int32_t>& vreplyints, vector<dReal>& vreplyvalues)
+    {
+        _SyncWithWorkerThread();
+        EnvironmentMutex::scoped_lock lock(_GetQueryEnv()->GetMutex());
+        KinBodyPtr pbody = _GetBinaryBody(vints);
+        if( !pbody ) {
+            return false;
+        }
+        CollisionReportPtr preport(new CollisionReport());
+        bool bCollision = _GetQueryEnv()->CheckCollision(KinBodyConstPtr(pbody), preport);
+        int bodyindex = 0;
+        if( !!preport->plink1 &&( preport->plink1->GetParent() != pbody) ) {
+            bodyindex = preport->plink1->GetParent()->GetEnvironmentId();
+        }
+        if( !!preport->plink2 &&( preport->plink2->GetParent() != pbody) ) {
+            bodyindex = preport->plink2->GetParent()->GetEnvironmentId();
+        }
+        vreplyints.push_back(bCollision);
+        vreplyints.push_back(bodyindex);
+        return true;
+    }
+
+    bool bSetTrajectory(const vector<int32_t>& vints, const vector<dReal>& vvalues, vector<int32_t>& vreplyints, vector<dReal>& vreplyvalues)
+    {
+        _SyncWithWorkerThread();
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        KinBodyPtr pbody = _GetBinaryBody(vints);
+        if( !pbody || !pbody->IsRobot() || vints.size() != 3 ) {
+            return false;
+        }
+        RobotBasePtr probot = RaveInterfaceCast<RobotBase>(pbody);
+        if( !probot->GetController() ) {
+            return false;
+        }
+        int numpoints = vints[1];
+        bool havetime = vints[2] != 0;
+        ConfigurationSpecification spec = probot->GetActiveConfigurationSpecification();
+        if( havetime ) {
+            spec.AddDeltaTimeGroup();
         }
+        if( numpoints <= 0 || (int)vvalues.size() != numpoints*spec.GetDOF() ) {
+            return false;
+        }
+        _StartActiveTrajectory(probot, spec, vvalues, havetime, false);
+        return true;
+    }
+
+    bool bGetTrajectory(const vector<int32_t>& vints, const vector<dReal>& vvalues, vector<int32_t>& vreplyints, vector<dReal>& vreplyvalues)
+    {
+        _SyncWithWorkerThread();
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        KinBodyPtr pbody = _GetBinaryBody(vints);
+        if( !pbody || !pbody->IsRobot() ) {
+            return false;
+        }
+        RobotBasePtr probot = RaveInterfaceCast<RobotBase>(pbody);
+        TrajectoryBasePtr ptraj;
+        {
+            boost::mutex::scoped_lock lock(_mutexTrajectories);
+            map<int, TrajectoryBasePtr>::iterator it = _mapTrajectories.find(probot->GetEnvironmentId());
+            if( it == _mapTrajectories.end() ) {
+                return false;
+            }
+            ptraj = it->second;
+        }
+        ConfigurationSpecification spec = probot->GetActiveConfigurationSpecification();
+        spec.AddDeltaTimeGroup();
+        ptraj->GetWaypoints(0, ptraj->GetNumWaypoints(), vreplyvalues, spec);
+        vreplyints.push_back(ptraj->GetNumWaypoints());
+        vreplyints.push_back(spec.GetDOF());
         return true;
     }
 
@@ -2308,7 +3379,7 @@ protected:
 #ifdef RAVE_REGISTER_BOOST
 #include BOOST_TYPEOF_INCREMENT_REGISTRATION_GROUP()
 
-BOOST_TYPEOF_REGISTER_TYPE(SimpleTextServer::Socket)
+BOOST_TYPEOF_REGISTER_TYPE(SimpleTextServer::Connection)
 BOOST_TYPEOF_REGISTER_TYPE(SimpleTextServer::WORKERSTRUCT)
 
 #endif
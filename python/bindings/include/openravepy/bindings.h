@@ -226,6 +226,79 @@ public:
     OPENRAVE_SHARED_PTR<void const> _handle;
 };
 
+/// \brief copies the values of a numeric numpy array, or the remaining values of a numpy flat iterator, into v.
+///
+/// numpy converts the array to T, which is free for aligned C-contiguous arrays that already have the type, and the
+/// values are then copied with one memcpy. A flat iterator reads its base array in C order starting at its current
+/// position, like list(it). Arrays have to be one-dimensional unless bAllowMultiDim is set, in which case they are
+/// read in C order like their flat attribute.
+/// \return false if pyo is not a numeric numpy array, in which case v is untouched
+/// \throw openrave_exception if pyo is an array of another rank
+template <typename T>
+inline bool _ExtractNumpyArray(PyObject* pyo, std::vector<T>& v, bool bAllowMultiDim=false)
+{
+    npy_intp offset = 0;
+    if( PyArrayIter_Check(pyo) ) {
+        PyArrayIterObject* pyiter = reinterpret_cast<PyArrayIterObject*>(pyo);
+        offset = pyiter->index;
+        pyo = reinterpret_cast<PyObject*>(pyiter->ao);
+        bAllowMultiDim = true;
+    }
+    if( !PyArray_Check(pyo) ) {
+        return false;
+    }
+    PyArrayObject* pyarray = reinterpret_cast<PyArrayObject*>(pyo);
+    if( !PyArray_ISBOOL(pyarray) && !PyArray_ISINTEGER(pyarray) && !PyArray_ISFLOAT(pyarray) ) {
+        return false; // object, string and complex arrays go through the element-wise path
+    }
+    if( PyArray_NDIM(pyarray) != 1 && (!bAllowMultiDim || PyArray_NDIM(pyarray) == 0) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("expected a one-dimensional array, got %d dimensions"), PyArray_NDIM(pyarray), ORE_InvalidArguments);
+    }
+    // steals the reference to the descriptor, returns a new reference that might be pyarray itself
+    PyArrayObject* pyconverted = reinterpret_cast<PyArrayObject*>(PyArray_FromArray(pyarray, PyArray_DescrFromType(select_npy_type<T>::type), NPY_ARRAY_IN_ARRAY|NPY_ARRAY_FORCECAST));
+    if( pyconverted == nullptr ) {
+        PyErr_Clear();
+        return false;
+    }
+    const npy_intp size = PyArray_SIZE(pyconverted);
+    v.resize(offset < size ? size-offset : 0);
+    if( v.size() > 0 ) {
+        memcpy(v.data(), reinterpret_cast<const T*>(PyArray_DATA(pyconverted))+offset, v.size()*sizeof(T));
+    }
+    Py_DECREF(pyconverted);
+    return true;
+}
+
+/// \brief types that ExtractArray can fill from numpy arrays without touching the elements from python
+template <typename T>
+inline bool ExtractNumpyArray(PyObject* pyo, std::vector<T>& v, bool bAllowMultiDim=false)
+{
+    return false;
+}
+
+inline bool ExtractNumpyArray(PyObject* pyo, std::vector<double>& v, bool bAllowMultiDim=false)
+{
+    return _ExtractNumpyArray(pyo, v, bAllowMultiDim);
+}
+
+inline bool ExtractNumpyArray(PyObject* pyo, std::vector<float>& v, bool bAllowMultiDim=false)
+{
+    return _ExtractNumpyArray(pyo, v, bAllowMultiDim);
+}
+
+inline bool ExtractNumpyArray(PyObject* pyo, std::vector<int>& v, bool bAllowMultiDim=false)
+{
+    return _ExtractNumpyArray(pyo, v, bAllowMultiDim);
+}
+
+inline bool ExtractNumpyArray(PyObject* pyo, std::vector<uint8_t>& v, bool bAllowMultiDim=false)
+{
+    return _ExtractNumpyArray(pyo, v, bAllowMultiDim);
+}
+
+/// \brief converts a python sequence to a vector.
+///
+/// numeric numpy arrays are copied in one go (see ExtractNumpyArray), everything else is extracted element by element.
 template <typename T>
 inline std::vector<T> ExtractArray(const py::object& o)
 {
@@ -233,6 +306,9 @@ inline std::vector<T> ExtractArray(const py::object& o)
         return {};
     }
     std::vector<T> v;
+    if( ExtractNumpyArray(o.ptr(), v) ) {
+        return v;
+    }
     try {
         const size_t n = len(o);
         v.resize(n);
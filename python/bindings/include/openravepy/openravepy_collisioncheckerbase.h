@@ -93,6 +93,7 @@ public:
     bool CheckCollisionOBB(object oaabb, object otransform, PyCollisionReportPtr pReport);
 
     virtual bool CheckSelfCollision(object o1, PyCollisionReportPtr pReport);
+    virtual object CheckContinuousCollision(object obody, object oq0, object oq1, PyCollisionReportPtr pReport);
 };
 
 } // namespace openravepy
@@ -34,9 +34,9 @@ protected:
 
     PyInterfaceBasePtr _toPyInterface(InterfaceBasePtr pinterface);
 
-    void _BodyCallback(object fncallback, KinBodyPtr pbody, int action);
+    void _BodyCallback(PythonCallbackHolderPtr pfncallback, KinBodyPtr pbody, int action);
 
-    CollisionAction _CollisionCallback(object fncallback, CollisionReportPtr preport, bool bFromPhysics);
+    CollisionAction _CollisionCallback(PythonCallbackHolderPtr pfncallback, CollisionReportPtr preport, bool bFromPhysics);
 
 public:
     PyEnvironmentBase(int options=ECO_StartSimulationThread);
@@ -216,6 +216,11 @@ public:
 
     void UpdatePublishedBodies();
 
+    void SetConcurrentQueries(bool bConcurrent);
+    bool IsConcurrentQueries() const;
+    object GetLockStatistics() const;
+    void ResetLockStatistics();
+
     object GetPublishedBodies(uint64_t timeout=0);
 
     object GetPublishedBody(const std::string &name, uint64_t timeout = 0);
@@ -49,7 +49,7 @@ class PyIkSolverBase : public PyInterfaceBase
 protected:
     IkSolverBasePtr _pIkSolver;
 
-    static IkReturn _CallCustomFilter(object fncallback, PyEnvironmentBasePtr pyenv, IkSolverBasePtr pIkSolver, std::vector<dReal>& values, RobotBase::ManipulatorConstPtr pmanip, const IkParameterization& ikparam);
+    static IkReturn _CallCustomFilter(PythonCallbackHolderPtr pfncallback, PyEnvironmentBasePtr pyenv, IkSolverBasePtr pIkSolver, std::vector<dReal>& values, RobotBase::ManipulatorConstPtr pmanip, const IkParameterization& ikparam);
 
 public:
     PyIkSolverBase(IkSolverBasePtr pIkSolver, PyEnvironmentBasePtr pyenv);
@@ -68,6 +68,8 @@ public:
 
     object SolveAll(object oparam, object oFreeParameters, int filteroptions);
 
+    object SolveAllBatch(object oparams, int filteroptions);
+
     PyIkReturnPtr CallFilters(object oparam);
 
     bool Supports(IkParameterizationType type);
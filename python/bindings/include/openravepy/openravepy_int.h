@@ -228,6 +228,29 @@ private:
 
 typedef OPENRAVE_SHARED_PTR<PythonThreadSaver> PythonThreadSaverPtr;
 
+/// \brief holds a python function that C++ callbacks call from threads that might not hold the GIL.
+///
+/// Copying the holder pointer into a callback does not touch the reference count of the function, and the GIL is taken
+/// when the function is released. Callers have to take the GIL around every call.
+class OPENRAVEPY_API PythonCallbackHolder
+{
+public:
+    PythonCallbackHolder(const py::object& fncallback) : _pfncallback(new py::object(fncallback)) {
+    }
+    virtual ~PythonCallbackHolder() {
+        PyGILState_STATE gstate = PyGILState_Ensure();
+        _pfncallback.reset();
+        PyGILState_Release(gstate);
+    }
+    const py::object& GetFunction() const {
+        return *_pfncallback;
+    }
+private:
+    OPENRAVE_SHARED_PTR<py::object> _pfncallback;
+};
+
+typedef OPENRAVE_SHARED_PTR<PythonCallbackHolder> PythonCallbackHolderPtr;
+
 inline RaveVector<float> ExtractFloat3(const py::object& o)
 {
     return RaveVector<float>(py::extract<float>(o[0]), py::extract<float>(o[1]), py::extract<float>(o[2]));
@@ -295,9 +318,43 @@ inline RaveVector<T> ExtractVector(const py::object& oraw)
     return v;
 }
 
+/// \brief fills t from a numpy array of 7 values (quaternion and translation) or of 3x4 or 4x4 values without going through python for every element
+///
+/// \return false if o is not a numeric numpy array of one of these shapes
+template <typename T>
+inline bool _ExtractNumpyTransform(const py::object& o, RaveTransformMatrix<T>& t)
+{
+    if( !PyArray_Check(o.ptr()) ) {
+        return false;
+    }
+    PyArrayObject* pyarray = reinterpret_cast<PyArrayObject*>(o.ptr());
+    const npy_intp* dims = PyArray_DIMS(pyarray);
+    const bool bPose = PyArray_NDIM(pyarray) == 1 && dims[0] == 7;
+    const bool bMatrix = PyArray_NDIM(pyarray) == 2 && (dims[0] == 3 || dims[0] == 4) && dims[1] == 4;
+    std::vector<T> vvalues;
+    if( (!bPose && !bMatrix) || !ExtractNumpyArray(o.ptr(), vvalues, true) ) {
+        return false;
+    }
+    if( bPose ) {
+        t = RaveTransform<T>(RaveVector<T>(vvalues[0], vvalues[1], vvalues[2], vvalues[3]), RaveVector<T>(vvalues[4], vvalues[5], vvalues[6]));
+        return true;
+    }
+    for(int i = 0; i < 3; ++i) {
+        t.m[4*i+0] = vvalues[4*i+0];
+        t.m[4*i+1] = vvalues[4*i+1];
+        t.m[4*i+2] = vvalues[4*i+2];
+        t.trans[i] = vvalues[4*i+3];
+    }
+    return true;
+}
+
 template <typename T>
 inline RaveTransform<T> ExtractTransformType(const py::object& o)
 {
+    RaveTransformMatrix<T> tnumpy;
+    if( _ExtractNumpyTransform(o, tnumpy) ) {
+        return tnumpy;
+    }
     if( len(o) == 7 ) {
         return RaveTransform<T>(RaveVector<T>(py::extract<T>(o[0]), py::extract<T>(o[1]), py::extract<T>(o[2]), py::extract<T>(o[3])), RaveVector<T>(py::extract<T>(o[4]), py::extract<T>(o[5]), py::extract<T>(o[6])));
     }
@@ -315,10 +372,13 @@ inline RaveTransform<T> ExtractTransformType(const py::object& o)
 template <typename T>
 inline RaveTransformMatrix<T> ExtractTransformMatrixType(const py::object& o)
 {
+    RaveTransformMatrix<T> t;
+    if( _ExtractNumpyTransform(o, t) ) {
+        return t;
+    }
     if( len(o) == 7 ) {
         return RaveTransform<T>(RaveVector<T>(py::extract<T>(o[0]), py::extract<T>(o[1]), py::extract<T>(o[2]), py::extract<T>(o[3])), RaveVector<T>(py::extract<T>(o[4]), py::extract<T>(o[5]), py::extract<T>(o[6])));
     }
-    RaveTransformMatrix<T> t;
     for(int i = 0; i < 3; ++i) {
         py::object orow = o[i];
         t.m[4*i+0] = py::extract<T>(orow[0]);
@@ -262,6 +262,7 @@ public:
         object GetDiffuseColor() const;
         object GetAmbientColor() const;
         object GetInfo();
+        bool SharesInfo(OPENRAVE_SHARED_PTR<PyGeometry> p) const;
         object ComputeInnerEmptyVolume() const;
         bool __eq__(OPENRAVE_SHARED_PTR<PyGeometry> p);
         bool __ne__(OPENRAVE_SHARED_PTR<PyGeometry> p);
@@ -192,6 +192,7 @@ public:
     py::object GetTransform() const;
     py::object GetTransformPose() const;
     py::object GetLinkTransformations(bool returndoflastvlaues=false) const;
+    py::object ComputeLinkTransformationsBatch(py::object oconfigs) const;
     void SetLinkTransformations(py::object transforms, py::object odoflastvalues=py::none_());
     void SetLinkVelocities(py::object ovelocities);
     py::object GetLinkEnableStates() const;
@@ -241,6 +242,10 @@ public:
     void SetSelfCollisionChecker(PyCollisionCheckerBasePtr pycollisionchecker);
     PyInterfaceBasePtr GetSelfCollisionChecker();
     bool CheckSelfCollision(PyCollisionReportPtr pReport=PyCollisionReportPtr(), PyCollisionCheckerBasePtr pycollisionchecker=PyCollisionCheckerBasePtr());
+    /// \brief collision checks the body at every row of configs with the gil released, returns a bool array
+    ///
+    /// The state of the body is restored afterwards. indices selects the dofs of the columns, all dofs if None.
+    py::object CheckCollisionBatch(py::object oconfigs, py::object oindices=py::none_(), bool bCheckSelfCollision=true);
     bool IsAttached(PyKinBodyPtr pattachbody);
     py::object GetAttached() const;
     void SetZeroConfiguration();
@@ -270,6 +275,8 @@ public:
     py::object GetAdjacentLinks() const;
     py::object GetManageData() const;
     int GetUpdateStamp() const;
+    py::object RegisterChangeCallback(uint32_t properties, py::object fncallback) const;
+    py::object DeferChangeCallbacks();
     std::string serialize(int options) const;
     std::string GetKinematicsGeometryHash() const;
     PyStateRestoreContextBase* CreateKinBodyStateSaver(py::object options=py::none_());
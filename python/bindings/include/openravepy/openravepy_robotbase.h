@@ -104,6 +104,9 @@ public:
 
         object FindIKSolutions(object oparam, object freeparams, int filteroptions, bool ikreturn=false, bool releasegil=false) const;
 
+        /// \brief finds the ik solutions of every pose of oparams with the gil released, returns a list of solution arrays
+        object FindIKSolutionsBatch(object oparams, int filteroptions) const;
+
         object GetIkParameterization(object oparam, bool inworld=true);
 
         object GetChildJoints();
@@ -52,6 +52,10 @@ public:
 
     object SamplePoints2D(object otimes, PyConfigurationSpecificationPtr pyspec) const;
 
+    object SampleRange2D(dReal tstart, dReal tend, dReal deltatime) const;
+
+    object SampleRange2D(dReal tstart, dReal tend, dReal deltatime, PyConfigurationSpecificationPtr pyspec) const;
+
     object GetConfigurationSpecification() const;
 
     size_t GetNumWaypoints() const;
@@ -175,12 +175,19 @@ void PyCollisionCheckerBase::RemoveKinBody(PyKinBodyPtr pbody)
 bool PyCollisionCheckerBase::CheckCollision(PyKinBodyPtr pbody1)
 {
     CHECK_POINTER(pbody1);
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
     return _pCollisionChecker->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)));
 }
 bool PyCollisionCheckerBase::CheckCollision(PyKinBodyPtr pbody1, PyCollisionReportPtr pReport)
 {
     CHECK_POINTER(pbody1);
-    bool bCollision = _pCollisionChecker->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)), openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+        bCollision = _pCollisionChecker->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)), openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,_pyenv);
     return bCollision;
 }
@@ -189,6 +196,8 @@ bool PyCollisionCheckerBase::CheckCollision(PyKinBodyPtr pbody1, PyKinBodyPtr pb
 {
     CHECK_POINTER(pbody1);
     CHECK_POINTER(pbody2);
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
     return _pCollisionChecker->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)), KinBodyConstPtr(openravepy::GetKinBody(pbody2)));
 }
 
@@ -196,7 +205,12 @@ bool PyCollisionCheckerBase::CheckCollision(PyKinBodyPtr pbody1, PyKinBodyPtr pb
 {
     CHECK_POINTER(pbody1);
     CHECK_POINTER(pbody2);
-    bool bCollision = _pCollisionChecker->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)), KinBodyConstPtr(openravepy::GetKinBody(pbody2)), openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+        bCollision = _pCollisionChecker->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)), KinBodyConstPtr(openravepy::GetKinBody(pbody2)), openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,_pyenv);
     return bCollision;
 }
@@ -206,10 +220,14 @@ bool PyCollisionCheckerBase::CheckCollision(object o1)
     CHECK_POINTER(o1);
     KinBody::LinkConstPtr plink = openravepy::GetKinBodyLinkConst(o1);
     if( !!plink ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
         return _pCollisionChecker->CheckCollision(plink);
     }
     KinBodyConstPtr pbody = openravepy::GetKinBody(o1);
     if( !!pbody ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
         return _pCollisionChecker->CheckCollision(pbody);
     }
     throw OPENRAVE_EXCEPTION_FORMAT0(_("CheckCollision(object) invalid argument"),ORE_InvalidArguments);
@@ -221,12 +239,20 @@ bool PyCollisionCheckerBase::CheckCollision(object o1, PyCollisionReportPtr pRep
     KinBody::LinkConstPtr plink = openravepy::GetKinBodyLinkConst(o1);
     bool bCollision;
     if( !!plink ) {
-        bCollision = _pCollisionChecker->CheckCollision(plink,openravepy::GetCollisionReport(pReport));
+        {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+            bCollision = _pCollisionChecker->CheckCollision(plink,openravepy::GetCollisionReport(pReport));
+        }
     }
     else {
         KinBodyConstPtr pbody = openravepy::GetKinBody(o1);
         if( !!pbody ) {
-            bCollision = _pCollisionChecker->CheckCollision(pbody,openravepy::GetCollisionReport(pReport));
+            {
+                openravepy::PythonThreadSaver threadsaver;
+                EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+                bCollision = _pCollisionChecker->CheckCollision(pbody,openravepy::GetCollisionReport(pReport));
+            }
         }
         else {
             throw OPENRAVE_EXCEPTION_FORMAT0(_("invalid argument"),ORE_InvalidArguments);
@@ -244,15 +270,24 @@ bool PyCollisionCheckerBase::CheckCollision(object o1, object o2)
     if( !!plink ) {
         KinBody::LinkConstPtr plink2 = openravepy::GetKinBodyLinkConst(o2);
         if( !!plink2 ) {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
             return _pCollisionChecker->CheckCollision(plink,plink2);
         }
         KinBodyConstPtr pbody2 = openravepy::GetKinBody(o2);
         if( !!pbody2 ) {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
             return _pCollisionChecker->CheckCollision(plink,pbody2);
         }
         CollisionReportPtr preport2 = openravepy::GetCollisionReport(o2);
         if( !!preport2 ) {
-            bool bCollision = _pCollisionChecker->CheckCollision(plink,preport2);
+            bool bCollision;
+            {
+                openravepy::PythonThreadSaver threadsaver;
+                EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+                bCollision = _pCollisionChecker->CheckCollision(plink,preport2);
+            }
             openravepy::UpdateCollisionReport(o2,_pyenv);
             return bCollision;
         }
@@ -262,15 +297,24 @@ bool PyCollisionCheckerBase::CheckCollision(object o1, object o2)
     if( !!pbody ) {
         KinBody::LinkConstPtr plink2 = openravepy::GetKinBodyLinkConst(o2);
         if( !!plink2 ) {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
             return _pCollisionChecker->CheckCollision(plink2,pbody);
         }
         KinBodyConstPtr pbody2 = openravepy::GetKinBody(o2);
         if( !!pbody2 ) {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
             return _pCollisionChecker->CheckCollision(pbody,pbody2);
         }
         CollisionReportPtr preport2 = openravepy::GetCollisionReport(o2);
         if( !!preport2 ) {
-            bool bCollision = _pCollisionChecker->CheckCollision(pbody,preport2);
+            bool bCollision;
+            {
+                openravepy::PythonThreadSaver threadsaver;
+                EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+                bCollision = _pCollisionChecker->CheckCollision(pbody,preport2);
+            }
             openravepy::UpdateCollisionReport(o2,_pyenv);
             return bCollision;
         }
@@ -287,12 +331,20 @@ bool PyCollisionCheckerBase::CheckCollision(object o1, object o2, PyCollisionRep
     if( !!plink ) {
         KinBody::LinkConstPtr plink2 = openravepy::GetKinBodyLinkConst(o2);
         if( !!plink2 ) {
-            bCollision = _pCollisionChecker->CheckCollision(plink,plink2, openravepy::GetCollisionReport(pReport));
+            {
+                openravepy::PythonThreadSaver threadsaver;
+                EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+                bCollision = _pCollisionChecker->CheckCollision(plink,plink2, openravepy::GetCollisionReport(pReport));
+            }
         }
         else {
             KinBodyConstPtr pbody2 = openravepy::GetKinBody(o2);
             if( !!pbody2 ) {
-                bCollision = _pCollisionChecker->CheckCollision(plink,pbody2, openravepy::GetCollisionReport(pReport));
+                {
+                    openravepy::PythonThreadSaver threadsaver;
+                    EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+                    bCollision = _pCollisionChecker->CheckCollision(plink,pbody2, openravepy::GetCollisionReport(pReport));
+                }
             }
             else {
                 throw OPENRAVE_EXCEPTION_FORMAT0(_("invalid argument 2"),ORE_InvalidArguments);
@@ -304,12 +356,20 @@ bool PyCollisionCheckerBase::CheckCollision(object o1, object o2, PyCollisionRep
         if( !!pbody ) {
             KinBody::LinkConstPtr plink2 = openravepy::GetKinBodyLinkConst(o2);
             if( !!plink2 ) {
-                bCollision = _pCollisionChecker->CheckCollision(plink2,pbody, openravepy::GetCollisionReport(pReport));
+                {
+                    openravepy::PythonThreadSaver threadsaver;
+                    EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+                    bCollision = _pCollisionChecker->CheckCollision(plink2,pbody, openravepy::GetCollisionReport(pReport));
+                }
             }
             else {
                 KinBodyConstPtr pbody2 = openravepy::GetKinBody(o2);
                 if( !!pbody2 ) {
-                    bCollision = _pCollisionChecker->CheckCollision(pbody,pbody2, openravepy::GetCollisionReport(pReport));
+                    {
+                        openravepy::PythonThreadSaver threadsaver;
+                        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+                        bCollision = _pCollisionChecker->CheckCollision(pbody,pbody2, openravepy::GetCollisionReport(pReport));
+                    }
                 }
                 else {
                     throw OPENRAVE_EXCEPTION_FORMAT0(_("invalid argument 2"),ORE_InvalidArguments);
@@ -331,10 +391,14 @@ bool PyCollisionCheckerBase::CheckCollision(object o1, PyKinBodyPtr pybody2)
     KinBodyConstPtr pbody2 = openravepy::GetKinBody(pybody2);
     KinBody::LinkConstPtr plink = openravepy::GetKinBodyLinkConst(o1);
     if( !!plink ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
         return _pCollisionChecker->CheckCollision(plink,pbody2);
     }
     KinBodyConstPtr pbody1 = openravepy::GetKinBody(o1);
     if( !!pbody1 ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
         return _pCollisionChecker->CheckCollision(pbody1,pbody2);
     }
     throw OPENRAVE_EXCEPTION_FORMAT0(_("CheckCollision(object) invalid argument"),ORE_InvalidArguments);
@@ -348,12 +412,20 @@ bool PyCollisionCheckerBase::CheckCollision(object o1, PyKinBodyPtr pybody2, PyC
     KinBody::LinkConstPtr plink = openravepy::GetKinBodyLinkConst(o1);
     bool bCollision = false;
     if( !!plink ) {
-        bCollision = _pCollisionChecker->CheckCollision(plink,pbody2,openravepy::GetCollisionReport(pReport));
+        {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+            bCollision = _pCollisionChecker->CheckCollision(plink,pbody2,openravepy::GetCollisionReport(pReport));
+        }
     }
     else {
         KinBodyConstPtr pbody1 = openravepy::GetKinBody(o1);
         if( !!pbody1 ) {
-            bCollision = _pCollisionChecker->CheckCollision(pbody1,pbody2,openravepy::GetCollisionReport(pReport));
+            {
+                openravepy::PythonThreadSaver threadsaver;
+                EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+                bCollision = _pCollisionChecker->CheckCollision(pbody1,pbody2,openravepy::GetCollisionReport(pReport));
+            }
         }
         else {
             throw OPENRAVE_EXCEPTION_FORMAT0(_("CheckCollision(object) invalid argument"),ORE_InvalidArguments);
@@ -394,9 +466,13 @@ bool PyCollisionCheckerBase::CheckCollision(object o1, object bodyexcluded, obje
         }
     }
     if( !!plink1 ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
         return _pCollisionChecker->CheckCollision(plink1,vbodyexcluded,vlinkexcluded);
     }
     else if( !!pbody1 ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
         return _pCollisionChecker->CheckCollision(pbody1,vbodyexcluded,vlinkexcluded);
     }
     else {
@@ -432,10 +508,18 @@ bool PyCollisionCheckerBase::CheckCollision(object o1, object bodyexcluded, obje
 
     bool bCollision=false;
     if( !!plink1 ) {
-        bCollision = _pCollisionChecker->CheckCollision(plink1, vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+        {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+            bCollision = _pCollisionChecker->CheckCollision(plink1, vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+        }
     }
     else if( !!pbody1 ) {
-        bCollision = _pCollisionChecker->CheckCollision(pbody1, vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+        {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+            bCollision = _pCollisionChecker->CheckCollision(pbody1, vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+        }
     }
     else {
         throw OPENRAVE_EXCEPTION_FORMAT0(_("invalid argument 1"),ORE_InvalidArguments);
@@ -467,6 +551,8 @@ bool PyCollisionCheckerBase::CheckCollision(PyKinBodyPtr pbody, object bodyexclu
             RAVELOG_ERROR("failed to get excluded link\n");
         }
     }
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
     return _pCollisionChecker->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody)),vbodyexcluded,vlinkexcluded);
 }
 
@@ -493,19 +579,31 @@ bool PyCollisionCheckerBase::CheckCollision(PyKinBodyPtr pbody, object bodyexclu
         }
     }
 
-    bool bCollision = _pCollisionChecker->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody)), vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+        bCollision = _pCollisionChecker->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody)), vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,_pyenv);
     return bCollision;
 }
 
 bool PyCollisionCheckerBase::CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray, PyKinBodyPtr pbody)
 {
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
     return _pCollisionChecker->CheckCollision(pyray->r,KinBodyConstPtr(openravepy::GetKinBody(pbody)));
 }
 
 bool PyCollisionCheckerBase::CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray, PyKinBodyPtr pbody, PyCollisionReportPtr pReport)
 {
-    bool bCollision = _pCollisionChecker->CheckCollision(pyray->r, KinBodyConstPtr(openravepy::GetKinBody(pbody)), openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+        bCollision = _pCollisionChecker->CheckCollision(pyray->r, KinBodyConstPtr(openravepy::GetKinBody(pbody)), openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,_pyenv);
     return bCollision;
 }
@@ -520,10 +618,20 @@ object PyCollisionCheckerBase::CheckCollisionRays(object rays, PyKinBodyPtr pbod
     if( extract<int>(shape[1]) != 6 ) {
         throw openrave_exception(_("rays object needs to be a Nx6 vector\n"));
     }
-    CollisionReport report;
-    CollisionReportPtr preport(&report,null_deleter());
+    std::vector<RAY> vrays(num);
+    for(int i = 0; i < num; ++i) {
+        std::vector<dReal> ray = ExtractArray<dReal>(rays[i]);
+        vrays[i].pos = Vector(ray[0], ray[1], ray[2]);
+        vrays[i].dir = Vector(ray[3], ray[4], ray[5]);
+    }
+    std::vector<dReal> vdistances;
+    std::vector<Vector> vnormals;
+    std::vector<int> vbodyids;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        _pCollisionChecker->CheckCollisionRays(vrays, vdistances, vnormals, vbodyids, KinBodyConstPtr(openravepy::GetKinBody(pbody)));
+    }
 
-    RAY r;
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
     py::array_t<dReal> pypos({num, 6});
     py::buffer_info bufpos = pypos.request();
@@ -540,31 +648,19 @@ object PyCollisionCheckerBase::CheckCollisionRays(object rays, PyKinBodyPtr pbod
     bool* pcollision = (bool*)PyArray_DATA(pycollision);
 #endif // USE_PYBIND11_PYTHON_BINDINGS
     for(int i = 0; i < num; ++i, ppos += 6) {
-        std::vector<dReal> ray = ExtractArray<dReal>(rays[i]);
-        r.pos.x = ray[0];
-        r.pos.y = ray[1];
-        r.pos.z = ray[2];
-        r.dir.x = ray[3];
-        r.dir.y = ray[4];
-        r.dir.z = ray[5];
-        bool bCollision;
-        if( !pbody ) {
-            bCollision = _pCollisionChecker->CheckCollision(r, preport);
-        }
-        else {
-            bCollision = _pCollisionChecker->CheckCollision(r, KinBodyConstPtr(openravepy::GetKinBody(pbody)), preport);
-        }
+        const RAY& r = vrays[i];
         pcollision[i] = false;
         ppos[0] = 0; ppos[1] = 0; ppos[2] = 0; ppos[3] = 0; ppos[4] = 0; ppos[5] = 0;
-        if( bCollision &&( report.contacts.size() > 0) ) {
-            if( !bFrontFacingOnly ||( report.contacts[0].norm.dot3(r.dir)<0) ) {
+        if( vbodyids[i] != 0 ) {
+            if( !bFrontFacingOnly ||( vnormals[i].dot3(r.dir)<0) ) {
+                Vector vhit = r.pos + r.dir*(vdistances[i]/RaveSqrt(r.dir.lengthsqr3()));
                 pcollision[i] = true;
-                ppos[0] = report.contacts[0].pos.x;
-                ppos[1] = report.contacts[0].pos.y;
-                ppos[2] = report.contacts[0].pos.z;
-                ppos[3] = report.contacts[0].norm.x;
-                ppos[4] = report.contacts[0].norm.y;
-                ppos[5] = report.contacts[0].norm.z;
+                ppos[0] = vhit.x;
+                ppos[1] = vhit.y;
+                ppos[2] = vhit.z;
+                ppos[3] = vnormals[i].x;
+                ppos[4] = vnormals[i].y;
+                ppos[5] = vnormals[i].z;
             }
         }
     }
@@ -577,12 +673,19 @@ object PyCollisionCheckerBase::CheckCollisionRays(object rays, PyKinBodyPtr pbod
 
 bool PyCollisionCheckerBase::CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray)
 {
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
     return _pCollisionChecker->CheckCollision(pyray->r);
 }
 
 bool PyCollisionCheckerBase::CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray, PyCollisionReportPtr pReport)
 {
-    bool bCollision = _pCollisionChecker->CheckCollision(pyray->r, openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+        bCollision = _pCollisionChecker->CheckCollision(pyray->r, openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,_pyenv);
     return bCollision;
 }
@@ -594,7 +697,12 @@ bool PyCollisionCheckerBase::CheckCollisionTriMesh(object otrimesh, PyKinBodyPtr
         throw openrave_exception(_("bad trimesh"));
     }
     KinBodyConstPtr pbody(openravepy::GetKinBody(pybody));
-    bool bCollision = _pCollisionChecker->CheckCollision(trimesh, pbody, openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+        bCollision = _pCollisionChecker->CheckCollision(trimesh, pbody, openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,_pyenv);
     return bCollision;
 }
@@ -605,7 +713,12 @@ bool PyCollisionCheckerBase::CheckCollisionTriMesh(object otrimesh, PyCollisionR
     if( !ExtractTriMesh(otrimesh,trimesh) ) {
         throw openrave_exception(_("bad trimesh"));
     }
-    bool bCollision = _pCollisionChecker->CheckCollision(trimesh, openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+        bCollision = _pCollisionChecker->CheckCollision(trimesh, openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,_pyenv);
     return bCollision;
 }
@@ -614,7 +727,12 @@ bool PyCollisionCheckerBase::CheckCollisionOBB(object oaabb, object otransform,
 {
     AABB aabb = ExtractAABB(oaabb);
     Transform t = ExtractTransform(otransform);
-    bool bCollision = _pCollisionChecker->CheckCollision(aabb, t, openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+        bCollision = _pCollisionChecker->CheckCollision(aabb, t, openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,_pyenv);
     return bCollision;
 }
@@ -625,10 +743,18 @@ bool PyCollisionCheckerBase::CheckSelfCollision(object o1, PyCollisionReportPtr
     KinBodyConstPtr pbody1 = openravepy::GetKinBody(o1);
     bool bCollision;
     if( !!plink1 ) {
-        bCollision = _pCollisionChecker->CheckSelfCollision(plink1, openravepy::GetCollisionReport(pReport));
+        {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+            bCollision = _pCollisionChecker->CheckSelfCollision(plink1, openravepy::GetCollisionReport(pReport));
+        }
     }
     else if( !!pbody1 ) {
-        bCollision = _pCollisionChecker->CheckSelfCollision(pbody1, openravepy::GetCollisionReport(pReport));
+        {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_pCollisionChecker->GetEnv()->GetMutex());
+            bCollision = _pCollisionChecker->CheckSelfCollision(pbody1, openravepy::GetCollisionReport(pReport));
+        }
     }
     else {
         throw OPENRAVE_EXCEPTION_FORMAT0(_("invalid parameters to CheckSelfCollision"), ORE_InvalidArguments);
@@ -637,6 +763,19 @@ bool PyCollisionCheckerBase::CheckSelfCollision(object o1, PyCollisionReportPtr
     return bCollision;
 }
 
+object PyCollisionCheckerBase::CheckContinuousCollision(object obody, object oq0, object oq1, PyCollisionReportPtr pReport)
+{
+    KinBodyConstPtr pbody = openravepy::GetKinBody(obody);
+    if( !pbody ) {
+        throw OPENRAVE_EXCEPTION_FORMAT0(_("invalid parameters to CheckContinuousCollision"), ORE_InvalidArguments);
+    }
+    std::vector<dReal> q0 = ExtractArray<dReal>(oq0), q1 = ExtractArray<dReal>(oq1);
+    dReal ftimeofcontact = 1;
+    bool bCollision = _pCollisionChecker->CheckContinuousCollision(pbody, q0, q1, ftimeofcontact, openravepy::GetCollisionReport(pReport));
+    openravepy::UpdateCollisionReport(pReport,_pyenv);
+    return py::make_tuple(bCollision, ftimeofcontact);
+}
+
 CollisionCheckerBasePtr GetCollisionChecker(PyCollisionCheckerBasePtr pyCollisionChecker)
 {
     return !pyCollisionChecker ? CollisionCheckerBasePtr() : pyCollisionChecker->GetCollisionChecker();
@@ -829,6 +968,7 @@ void init_openravepy_collisionchecker()
     .def("CheckCollisionTriMesh",pcoltbr, PY_ARGS("trimesh", "body", "report") DOXY_FN(CollisionCheckerBase,CheckCollision "const TriMesh; KinBodyConstPtr; CollisionReportPtr"))
     .def("CheckCollisionOBB", pcolobb, PY_ARGS("aabb", "pose", "report") DOXY_FN(CollisionCheckerBase,CheckCollision "const AABB; const Transform; CollisionReport"))
     .def("CheckSelfCollision",&PyCollisionCheckerBase::CheckSelfCollision, PY_ARGS("linkbody", "report") DOXY_FN(CollisionCheckerBase,CheckSelfCollision "KinBodyConstPtr, CollisionReportPtr"))
+    .def("CheckContinuousCollision",&PyCollisionCheckerBase::CheckContinuousCollision, PY_ARGS("body", "q0", "q1", "report") "Checks the body against the scene while its DOF values move linearly from q0 to q1. Returns (collision, time of contact in [0,1]).")
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
     .def("CheckCollisionRays", &PyCollisionCheckerBase::CheckCollisionRays,
          "rays"_a,
@@ -886,6 +886,18 @@ object pyRaveInvertFileLookup(const std::string& filename)
     return py::none_();
 }
 
+object pyRaveGetKinematicModelCacheStatistics()
+{
+    KinematicModelCacheStatistics stats = OpenRAVE::RaveGetKinematicModelCacheStatistics();
+    py::dict ostats;
+    ostats["numentries"] = stats.numentries;
+    ostats["numhits"] = stats.numhits;
+    ostats["nummisses"] = stats.nummisses;
+    ostats["parsetime"] = 1e-6*stats.parsetime;
+    ostats["instantiatetime"] = 1e-6*stats.instantiatetime;
+    return ostats;
+}
+
 object RaveGetPluginInfo()
 {
     py::list plugins;
@@ -1215,6 +1227,7 @@ string poseSerialization(object o)
 #ifndef USE_PYBIND11_PYTHON_BINDINGS
 BOOST_PYTHON_FUNCTION_OVERLOADS(RaveInitialize_overloads, pyRaveInitialize, 0, 2)
 BOOST_PYTHON_FUNCTION_OVERLOADS(RaveFindLocalFile_overloads, OpenRAVE::RaveFindLocalFile, 1, 2)
+BOOST_PYTHON_FUNCTION_OVERLOADS(RaveEvictKinematicModelCache_overloads, OpenRAVE::RaveEvictKinematicModelCache, 0, 1)
 BOOST_PYTHON_FUNCTION_OVERLOADS(InterpolateQuatSlerp_overloads, openravepy::InterpolateQuatSlerp, 3, 4)
 BOOST_PYTHON_FUNCTION_OVERLOADS(InterpolateQuatSquad_overloads, openravepy::InterpolateQuatSquad, 5, 6)
 BOOST_PYTHON_FUNCTION_OVERLOADS(ComputePoseDistSqr_overloads, openravepy::ComputePoseDistSqr, 2, 3)
@@ -1833,6 +1846,24 @@ void init_openravepy_global()
 #else
     def("RaveDestroy",RaveDestroy,DOXY_FN1(RaveDestroy));
 #endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    m.def("RaveSetKinematicModelCacheEnabled",OpenRAVE::RaveSetKinematicModelCacheEnabled, PY_ARGS("enabled") DOXY_FN1(RaveSetKinematicModelCacheEnabled));
+#else
+    def("RaveSetKinematicModelCacheEnabled",OpenRAVE::RaveSetKinematicModelCacheEnabled, PY_ARGS("enabled") DOXY_FN1(RaveSetKinematicModelCacheEnabled));
+#endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    m.def("RaveGetKinematicModelCacheStatistics",openravepy::pyRaveGetKinematicModelCacheStatistics, "Returns the numentries, numhits, nummisses, parsetime and instantiatetime (in seconds) of the kinematic model cache.");
+#else
+    def("RaveGetKinematicModelCacheStatistics",openravepy::pyRaveGetKinematicModelCacheStatistics, "Returns the numentries, numhits, nummisses, parsetime and instantiatetime (in seconds) of the kinematic model cache.");
+#endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    m.def("RaveEvictKinematicModelCache",OpenRAVE::RaveEvictKinematicModelCache,
+          "uri"_a = "",
+          DOXY_FN1(RaveEvictKinematicModelCache)
+          );
+#else
+    def("RaveEvictKinematicModelCache",OpenRAVE::RaveEvictKinematicModelCache,RaveEvictKinematicModelCache_overloads(PY_ARGS("uri") DOXY_FN1(RaveEvictKinematicModelCache)));
+#endif
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
     m.def("RaveGetPluginInfo",openravepy::RaveGetPluginInfo,DOXY_FN1(RaveGetPluginInfo));
 #else
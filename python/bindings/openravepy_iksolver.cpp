@@ -89,34 +89,36 @@ void PyIkReturn::SetMapKeyValue(const std::string& key, object ovalues) {
 
 typedef OPENRAVE_SHARED_PTR<PyIkReturn> PyIkReturnPtr;
 
-IkReturn PyIkSolverBase::_CallCustomFilter(object fncallback, PyEnvironmentBasePtr pyenv, IkSolverBasePtr pIkSolver, std::vector<dReal>& values, RobotBase::ManipulatorConstPtr pmanip, const IkParameterization& ikparam)
+IkReturn PyIkSolverBase::_CallCustomFilter(PythonCallbackHolderPtr pfncallback, PyEnvironmentBasePtr pyenv, IkSolverBasePtr pIkSolver, std::vector<dReal>& values, RobotBase::ManipulatorConstPtr pmanip, const IkParameterization& ikparam)
 {
-    object res;
-    PyGILState_STATE gstate = PyGILState_Ensure();
-    std::string errmsg;
-    try {
-        RobotBase::ManipulatorPtr pmanip2 = OPENRAVE_CONST_POINTER_CAST<RobotBase::Manipulator>(pmanip);
-        res = fncallback(toPyArray(values), openravepy::toPyRobotManipulator(pmanip2,pyenv),toPyIkParameterization(ikparam));
-    }
-    catch(...) {
-        errmsg = boost::str(boost::format("exception occured in python custom filter callback of iksolver %s: %s")%pIkSolver->GetXMLId()%GetPyErrorString());
-    }
     IkReturn ikfr(IKRA_Success);
-    if( IS_PYTHONOBJECT_NONE(res) ) {
-        ikfr._action = IKRA_Reject;
-    }
-    else {
-        if( !openravepy::ExtractIkReturn(res,ikfr) ) {
-            extract_<IkReturnAction> ikfra(res);
-            if( ikfra.check() ) {
-                ikfr._action = (IkReturnAction)ikfra;
-            }
-            else {
-                errmsg = "failed to convert return type of filter to IkReturn";
+    std::string errmsg;
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    {
+        // every python object has to be created and destroyed while the GIL is held
+        object res;
+        try {
+            RobotBase::ManipulatorPtr pmanip2 = OPENRAVE_CONST_POINTER_CAST<RobotBase::Manipulator>(pmanip);
+            res = pfncallback->GetFunction()(toPyArray(values), openravepy::toPyRobotManipulator(pmanip2,pyenv),toPyIkParameterization(ikparam));
+        }
+        catch(...) {
+            errmsg = boost::str(boost::format("exception occured in python custom filter callback of iksolver %s: %s")%pIkSolver->GetXMLId()%GetPyErrorString());
+        }
+        if( IS_PYTHONOBJECT_NONE(res) ) {
+            ikfr._action = IKRA_Reject;
+        }
+        else {
+            if( !openravepy::ExtractIkReturn(res,ikfr) ) {
+                extract_<IkReturnAction> ikfra(res);
+                if( ikfra.check() ) {
+                    ikfr._action = (IkReturnAction)ikfra;
+                }
+                else {
+                    errmsg = "failed to convert return type of filter to IkReturn";
+                }
             }
         }
     }
-
     PyGILState_Release(gstate);
     if( errmsg.size() > 0 ) {
         throw openrave_exception(errmsg,ORE_Assert);
@@ -214,6 +216,30 @@ object PyIkSolverBase::SolveAll(object oparam, object oFreeParameters, int filte
     return pyreturns;
 }
 
+object PyIkSolverBase::SolveAllBatch(object oparams, int filteroptions)
+{
+    std::vector<IkParameterization> vikparams(len(oparams));
+    for(size_t i = 0; i < vikparams.size(); ++i) {
+        if( !ExtractIkParameterization(oparams[i],vikparams[i]) ) {
+            throw openrave_exception(_("first argument to IkSolver.SolveAllBatch needs to be a list of IkParameterization"),ORE_InvalidArguments);
+        }
+    }
+    std::vector< std::vector< std::vector<dReal> > > vsolutions;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        _pIkSolver->SolveAllBatch(vikparams, filteroptions, vsolutions);
+    }
+    py::list pysolutions;
+    FOREACH(itsolutions, vsolutions) {
+        py::list pyparamsolutions;
+        FOREACH(itsolution, *itsolutions) {
+            pyparamsolutions.append(toPyArray(*itsolution));
+        }
+        pysolutions.append(pyparamsolutions);
+    }
+    return pysolutions;
+}
+
 PyIkReturnPtr PyIkSolverBase::CallFilters(object oparam)
 {
     PyIkReturnPtr pyreturn(new PyIkReturn(IKRA_Reject));
@@ -235,7 +261,7 @@ object PyIkSolverBase::RegisterCustomFilter(int priority, object fncallback)
     if( !fncallback ) {
         throw OPENRAVE_EXCEPTION_FORMAT0(_("callback not specified"),ORE_InvalidArguments);
     }
-    return toPyUserData(_pIkSolver->RegisterCustomFilter(priority,boost::bind(&PyIkSolverBase::_CallCustomFilter,fncallback,_pyenv,_pIkSolver,_1,_2,_3)));
+    return toPyUserData(_pIkSolver->RegisterCustomFilter(priority,boost::bind(&PyIkSolverBase::_CallCustomFilter,PythonCallbackHolderPtr(new PythonCallbackHolder(fncallback)),_pyenv,_pIkSolver,_1,_2,_3)));
 }
 
 bool ExtractIkReturn(object o, IkReturn& ikfr)
@@ -361,6 +387,7 @@ void init_openravepy_iksolver()
         .def("Solve",SolveFree, PY_ARGS("ikparam","q0","freeparameters", "filteroptions") DOXY_FN(IkSolverBase, Solve "const IkParameterization&; const std::vector; const std::vector; int; IkReturnPtr"))
         .def("SolveAll",SolveAll, PY_ARGS("ikparam","filteroptions") DOXY_FN(IkSolverBase, SolveAll "const IkParameterization&; int; std::vector<IkReturnPtr>"))
         .def("SolveAll",SolveAllFree, PY_ARGS("ikparam","freeparameters","filteroptions") DOXY_FN(IkSolverBase, SolveAll "const IkParameterization&; const std::vector; int; std::vector<IkReturnPtr>"))
+        .def("SolveAllBatch",&PyIkSolverBase::SolveAllBatch, PY_ARGS("ikparams","filteroptions") DOXY_FN(IkSolverBase,SolveAllBatch))
         .def("GetNumFreeParameters",&PyIkSolverBase::GetNumFreeParameters, DOXY_FN(IkSolverBase,GetNumFreeParameters))
         .def("GetFreeParameters",&PyIkSolverBase::GetFreeParameters, DOXY_FN(IkSolverBase,GetFreeParameters))
         .def("Supports",&PyIkSolverBase::Supports, PY_ARGS("iktype") DOXY_FN(IkSolverBase,Supports))
@@ -903,12 +903,11 @@ PyInterfaceBasePtr PyEnvironmentBase::_toPyInterface(InterfaceBasePtr pinterface
     return PyInterfaceBasePtr();
 }
 
-void PyEnvironmentBase::_BodyCallback(object fncallback, KinBodyPtr pbody, int action)
+void PyEnvironmentBase::_BodyCallback(PythonCallbackHolderPtr pfncallback, KinBodyPtr pbody, int action)
 {
-    object res;
     PyGILState_STATE gstate = PyGILState_Ensure();
     try {
-        fncallback(openravepy::toPyKinBody(pbody, shared_from_this()), action);
+        pfncallback->GetFunction()(openravepy::toPyKinBody(pbody, shared_from_this()), action);
     }
     catch(...) {
         RAVELOG_ERROR("exception occured in python body callback:\n");
@@ -917,30 +916,33 @@ void PyEnvironmentBase::_BodyCallback(object fncallback, KinBodyPtr pbody, int a
     PyGILState_Release(gstate);
 }
 
-CollisionAction PyEnvironmentBase::_CollisionCallback(object fncallback, CollisionReportPtr preport, bool bFromPhysics)
+CollisionAction PyEnvironmentBase::_CollisionCallback(PythonCallbackHolderPtr pfncallback, CollisionReportPtr preport, bool bFromPhysics)
 {
-    object res;
-    PyGILState_STATE gstate = PyGILState_Ensure();
-    try {
-        res = fncallback(openravepy::toPyCollisionReport(preport,shared_from_this()),bFromPhysics);
-    }
-    catch(...) {
-        RAVELOG_ERROR("exception occured in python collision callback:\n");
-        PyErr_Print();
-    }
     CollisionAction ret = CA_DefaultAction;
-    if( IS_PYTHONOBJECT_NONE(res) || !res ) {
-        ret = CA_DefaultAction;
-        RAVELOG_WARN("collision callback nothing returning, so executing default action\n");
-    }
-    else {
-        extract_<int> xi(res);
-        if( xi.check() ) {
-            ret = (CollisionAction)(int) xi;
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    {
+        // every python object has to be created and destroyed while the GIL is held
+        object res;
+        try {
+            res = pfncallback->GetFunction()(openravepy::toPyCollisionReport(preport,shared_from_this()),bFromPhysics);
         }
-        else {
+        catch(...) {
+            RAVELOG_ERROR("exception occured in python collision callback:\n");
+            PyErr_Print();
+        }
+        if( IS_PYTHONOBJECT_NONE(res) || !res ) {
+            ret = CA_DefaultAction;
             RAVELOG_WARN("collision callback nothing returning, so executing default action\n");
         }
+        else {
+            extract_<int> xi(res);
+            if( xi.check() ) {
+                ret = (CollisionAction)(int) xi;
+            }
+            else {
+                RAVELOG_WARN("collision callback nothing returning, so executing default action\n");
+            }
+        }
     }
     PyGILState_Release(gstate);
     return ret;
@@ -1014,12 +1016,19 @@ object PyEnvironmentBase::GetCollisionChecker()
 bool PyEnvironmentBase::CheckCollision(PyKinBodyPtr pbody1)
 {
     CHECK_POINTER(pbody1);
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
     return _penv->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)));
 }
 bool PyEnvironmentBase::CheckCollision(PyKinBodyPtr pbody1, PyCollisionReportPtr pReport)
 {
     CHECK_POINTER(pbody1);
-    bool bCollision = _penv->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)), openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+        bCollision = _penv->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)), openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,shared_from_this());
     return bCollision;
 }
@@ -1028,6 +1037,8 @@ bool PyEnvironmentBase::CheckCollision(PyKinBodyPtr pbody1, PyKinBodyPtr pbody2)
 {
     CHECK_POINTER(pbody1);
     CHECK_POINTER(pbody2);
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
     return _penv->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)), KinBodyConstPtr(openravepy::GetKinBody(pbody2)));
 }
 
@@ -1035,7 +1046,12 @@ bool PyEnvironmentBase::CheckCollision(PyKinBodyPtr pbody1, PyKinBodyPtr pbody2,
 {
     CHECK_POINTER(pbody1);
     CHECK_POINTER(pbody2);
-    bool bCollision = _penv->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)), KinBodyConstPtr(openravepy::GetKinBody(pbody2)), openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+        bCollision = _penv->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody1)), KinBodyConstPtr(openravepy::GetKinBody(pbody2)), openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,shared_from_this());
     return bCollision;
 }
@@ -1045,10 +1061,14 @@ bool PyEnvironmentBase::CheckCollision(object o1)
     CHECK_POINTER(o1);
     KinBody::LinkConstPtr plink = openravepy::GetKinBodyLinkConst(o1);
     if( !!plink ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
         return _penv->CheckCollision(plink);
     }
     KinBodyConstPtr pbody = openravepy::GetKinBody(o1);
     if( !!pbody ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
         return _penv->CheckCollision(pbody);
     }
     throw OPENRAVE_EXCEPTION_FORMAT0(_("CheckCollision(object) invalid argument"),ORE_InvalidArguments);
@@ -1060,12 +1080,20 @@ bool PyEnvironmentBase::CheckCollision(object o1, PyCollisionReportPtr pReport)
     KinBody::LinkConstPtr plink = openravepy::GetKinBodyLinkConst(o1);
     bool bCollision;
     if( !!plink ) {
-        bCollision = _penv->CheckCollision(plink,openravepy::GetCollisionReport(pReport));
+        {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+            bCollision = _penv->CheckCollision(plink,openravepy::GetCollisionReport(pReport));
+        }
     }
     else {
         KinBodyConstPtr pbody = openravepy::GetKinBody(o1);
         if( !!pbody ) {
-            bCollision = _penv->CheckCollision(pbody,openravepy::GetCollisionReport(pReport));
+            {
+                openravepy::PythonThreadSaver threadsaver;
+                EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+                bCollision = _penv->CheckCollision(pbody,openravepy::GetCollisionReport(pReport));
+            }
         }
         else {
             throw OPENRAVE_EXCEPTION_FORMAT0(_("invalid argument"),ORE_InvalidArguments);
@@ -1083,15 +1111,24 @@ bool PyEnvironmentBase::CheckCollision(object o1, object o2)
     if( !!plink ) {
         KinBody::LinkConstPtr plink2 = openravepy::GetKinBodyLinkConst(o2);
         if( !!plink2 ) {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
             return _penv->CheckCollision(plink,plink2);
         }
         KinBodyConstPtr pbody2 = openravepy::GetKinBody(o2);
         if( !!pbody2 ) {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
             return _penv->CheckCollision(plink,pbody2);
         }
         CollisionReportPtr preport2 = openravepy::GetCollisionReport(o2);
         if( !!preport2 ) {
-            bool bCollision = _penv->CheckCollision(plink,preport2);
+            bool bCollision;
+            {
+                openravepy::PythonThreadSaver threadsaver;
+                EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+                bCollision = _penv->CheckCollision(plink,preport2);
+            }
             openravepy::UpdateCollisionReport(o2,shared_from_this());
             return bCollision;
         }
@@ -1101,15 +1138,24 @@ bool PyEnvironmentBase::CheckCollision(object o1, object o2)
     if( !!pbody ) {
         KinBody::LinkConstPtr plink2 = openravepy::GetKinBodyLinkConst(o2);
         if( !!plink2 ) {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
             return _penv->CheckCollision(plink2,pbody);
         }
         KinBodyConstPtr pbody2 = openravepy::GetKinBody(o2);
         if( !!pbody2 ) {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
             return _penv->CheckCollision(pbody,pbody2);
         }
         CollisionReportPtr preport2 = openravepy::GetCollisionReport(o2);
         if( !!preport2 ) {
-            bool bCollision = _penv->CheckCollision(pbody,preport2);
+            bool bCollision;
+            {
+                openravepy::PythonThreadSaver threadsaver;
+                EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+                bCollision = _penv->CheckCollision(pbody,preport2);
+            }
             openravepy::UpdateCollisionReport(o2,shared_from_this());
             return bCollision;
         }
@@ -1126,12 +1172,20 @@ bool PyEnvironmentBase::CheckCollision(object o1, object o2, PyCollisionReportPt
     if( !!plink ) {
         KinBody::LinkConstPtr plink2 = openravepy::GetKinBodyLinkConst(o2);
         if( !!plink2 ) {
-            bCollision = _penv->CheckCollision(plink,plink2, openravepy::GetCollisionReport(pReport));
+            {
+                openravepy::PythonThreadSaver threadsaver;
+                EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+                bCollision = _penv->CheckCollision(plink,plink2, openravepy::GetCollisionReport(pReport));
+            }
         }
         else {
             KinBodyConstPtr pbody2 = openravepy::GetKinBody(o2);
             if( !!pbody2 ) {
-                bCollision = _penv->CheckCollision(plink,pbody2, openravepy::GetCollisionReport(pReport));
+                {
+                    openravepy::PythonThreadSaver threadsaver;
+                    EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+                    bCollision = _penv->CheckCollision(plink,pbody2, openravepy::GetCollisionReport(pReport));
+                }
             }
             else {
                 throw OPENRAVE_EXCEPTION_FORMAT0(_("invalid argument 2"),ORE_InvalidArguments);
@@ -1143,12 +1197,20 @@ bool PyEnvironmentBase::CheckCollision(object o1, object o2, PyCollisionReportPt
         if( !!pbody ) {
             KinBody::LinkConstPtr plink2 = openravepy::GetKinBodyLinkConst(o2);
             if( !!plink2 ) {
-                bCollision = _penv->CheckCollision(plink2,pbody, openravepy::GetCollisionReport(pReport));
+                {
+                    openravepy::PythonThreadSaver threadsaver;
+                    EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+                    bCollision = _penv->CheckCollision(plink2,pbody, openravepy::GetCollisionReport(pReport));
+                }
             }
             else {
                 KinBodyConstPtr pbody2 = openravepy::GetKinBody(o2);
                 if( !!pbody2 ) {
-                    bCollision = _penv->CheckCollision(pbody,pbody2, openravepy::GetCollisionReport(pReport));
+                    {
+                        openravepy::PythonThreadSaver threadsaver;
+                        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+                        bCollision = _penv->CheckCollision(pbody,pbody2, openravepy::GetCollisionReport(pReport));
+                    }
                 }
                 else {
                     throw OPENRAVE_EXCEPTION_FORMAT0(_("invalid argument 2"),ORE_InvalidArguments);
@@ -1170,10 +1232,14 @@ bool PyEnvironmentBase::CheckCollision(object o1, PyKinBodyPtr pybody2)
     KinBodyConstPtr pbody2 = openravepy::GetKinBody(pybody2);
     KinBody::LinkConstPtr plink = openravepy::GetKinBodyLinkConst(o1);
     if( !!plink ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
         return _penv->CheckCollision(plink,pbody2);
     }
     KinBodyConstPtr pbody1 = openravepy::GetKinBody(o1);
     if( !!pbody1 ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
         return _penv->CheckCollision(pbody1,pbody2);
     }
     throw OPENRAVE_EXCEPTION_FORMAT0(_("CheckCollision(object) invalid argument"),ORE_InvalidArguments);
@@ -1187,12 +1253,20 @@ bool PyEnvironmentBase::CheckCollision(object o1, PyKinBodyPtr pybody2, PyCollis
     KinBody::LinkConstPtr plink = openravepy::GetKinBodyLinkConst(o1);
     bool bCollision = false;
     if( !!plink ) {
-        bCollision = _penv->CheckCollision(plink,pbody2,openravepy::GetCollisionReport(pReport));
+        {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+            bCollision = _penv->CheckCollision(plink,pbody2,openravepy::GetCollisionReport(pReport));
+        }
     }
     else {
         KinBodyConstPtr pbody1 = openravepy::GetKinBody(o1);
         if( !!pbody1 ) {
-            bCollision = _penv->CheckCollision(pbody1,pbody2,openravepy::GetCollisionReport(pReport));
+            {
+                openravepy::PythonThreadSaver threadsaver;
+                EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+                bCollision = _penv->CheckCollision(pbody1,pbody2,openravepy::GetCollisionReport(pReport));
+            }
         }
         else {
             throw OPENRAVE_EXCEPTION_FORMAT0(_("CheckCollision(object) invalid argument"),ORE_InvalidArguments);
@@ -1233,9 +1307,13 @@ bool PyEnvironmentBase::CheckCollision(object o1, object bodyexcluded, object li
         }
     }
     if( !!plink1 ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
         return _penv->CheckCollision(plink1,vbodyexcluded,vlinkexcluded);
     }
     else if( !!pbody1 ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
         return _penv->CheckCollision(pbody1,vbodyexcluded,vlinkexcluded);
     }
     else {
@@ -1271,10 +1349,18 @@ bool PyEnvironmentBase::CheckCollision(object o1, object bodyexcluded, object li
 
     bool bCollision=false;
     if( !!plink1 ) {
-        bCollision = _penv->CheckCollision(plink1, vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+        {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+            bCollision = _penv->CheckCollision(plink1, vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+        }
     }
     else if( !!pbody1 ) {
-        bCollision = _penv->CheckCollision(pbody1, vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+        {
+            openravepy::PythonThreadSaver threadsaver;
+            EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+            bCollision = _penv->CheckCollision(pbody1, vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+        }
     }
     else {
         throw OPENRAVE_EXCEPTION_FORMAT0(_("invalid argument 1"),ORE_InvalidArguments);
@@ -1306,6 +1392,8 @@ bool PyEnvironmentBase::CheckCollision(PyKinBodyPtr pbody, object bodyexcluded,
             RAVELOG_ERROR("failed to get excluded link\n");
         }
     }
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
     return _penv->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody)),vbodyexcluded,vlinkexcluded);
 }
 
@@ -1332,19 +1420,31 @@ bool PyEnvironmentBase::CheckCollision(PyKinBodyPtr pbody, object bodyexcluded,
         }
     }
 
-    bool bCollision = _penv->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody)), vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+        bCollision = _penv->CheckCollision(KinBodyConstPtr(openravepy::GetKinBody(pbody)), vbodyexcluded, vlinkexcluded, openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,shared_from_this());
     return bCollision;
 }
 
 bool PyEnvironmentBase::CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray, PyKinBodyPtr pbody)
 {
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
     return _penv->CheckCollision(pyray->r,KinBodyConstPtr(openravepy::GetKinBody(pbody)));
 }
 
 bool PyEnvironmentBase::CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray, PyKinBodyPtr pbody, PyCollisionReportPtr pReport)
 {
-    bool bCollision = _penv->CheckCollision(pyray->r, KinBodyConstPtr(openravepy::GetKinBody(pbody)), openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+        bCollision = _penv->CheckCollision(pyray->r, KinBodyConstPtr(openravepy::GetKinBody(pbody)), openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,shared_from_this());
     return bCollision;
 }
@@ -1440,12 +1540,19 @@ object PyEnvironmentBase::CheckCollisionRays(py::numeric::array rays, PyKinBodyP
 
 bool PyEnvironmentBase::CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray)
 {
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
     return _penv->CheckCollision(pyray->r);
 }
 
 bool PyEnvironmentBase::CheckCollision(OPENRAVE_SHARED_PTR<PyRay> pyray, PyCollisionReportPtr pReport)
 {
-    bool bCollision = _penv->CheckCollision(pyray->r, openravepy::GetCollisionReport(pReport));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_penv->GetMutex());
+        bCollision = _penv->CheckCollision(pyray->r, openravepy::GetCollisionReport(pReport));
+    }
     openravepy::UpdateCollisionReport(pReport,shared_from_this());
     return bCollision;
 }
@@ -1712,7 +1819,7 @@ object PyEnvironmentBase::RegisterBodyCallback(object fncallback)
     if( !fncallback ) {
         throw OpenRAVEException(_("callback not specified"));
     }
-    UserDataPtr p = _penv->RegisterBodyCallback(boost::bind(&PyEnvironmentBase::_BodyCallback,shared_from_this(),fncallback,_1,_2));
+    UserDataPtr p = _penv->RegisterBodyCallback(boost::bind(&PyEnvironmentBase::_BodyCallback,shared_from_this(),PythonCallbackHolderPtr(new PythonCallbackHolder(fncallback)),_1,_2));
     if( !p ) {
         throw OpenRAVEException(_("registration handle is NULL"));
     }
@@ -1724,7 +1831,7 @@ object PyEnvironmentBase::RegisterCollisionCallback(object fncallback)
     if( !fncallback ) {
         throw OpenRAVEException(_("callback not specified"));
     }
-    UserDataPtr p = _penv->RegisterCollisionCallback(boost::bind(&PyEnvironmentBase::_CollisionCallback,shared_from_this(),fncallback,_1,_2));
+    UserDataPtr p = _penv->RegisterCollisionCallback(boost::bind(&PyEnvironmentBase::_CollisionCallback,shared_from_this(),PythonCallbackHolderPtr(new PythonCallbackHolder(fncallback)),_1,_2));
     if( !p ) {
         throw OpenRAVEException(_("registration handle is NULL"));
     }
@@ -2120,6 +2227,32 @@ void PyEnvironmentBase::UpdatePublishedBodies()
     _penv->UpdatePublishedBodies();
 }
 
+void PyEnvironmentBase::SetConcurrentQueries(bool bConcurrent)
+{
+    _penv->SetConcurrentQueries(bConcurrent);
+}
+
+bool PyEnvironmentBase::IsConcurrentQueries() const
+{
+    return _penv->IsConcurrentQueries();
+}
+
+object PyEnvironmentBase::GetLockStatistics() const
+{
+    EnvironmentBase::LockStatistics stats;
+    _penv->GetLockStatistics(stats);
+    py::dict ostats;
+    ostats["numcontended"] = stats.numcontended;
+    ostats["waittime"] = stats.waittime;
+    ostats["maxwaittime"] = stats.maxwaittime;
+    return ostats;
+}
+
+void PyEnvironmentBase::ResetLockStatistics()
+{
+    _penv->ResetLockStatistics();
+}
+
 object PyEnvironmentBase::GetPublishedBodies(uint64_t timeout)
 {
     std::vector<KinBody::BodyState> vbodystates;
@@ -2911,6 +3044,10 @@ Because race conditions can pop up when trying to lock the openrave environment
                      .def("GetBodies",&PyEnvironmentBase::GetBodies, DOXY_FN(EnvironmentBase,GetBodies))
                      .def("GetSensors",&PyEnvironmentBase::GetSensors, DOXY_FN(EnvironmentBase,GetSensors))
                      .def("UpdatePublishedBodies",&PyEnvironmentBase::UpdatePublishedBodies, DOXY_FN(EnvironmentBase,UpdatePublishedBodies))
+                     .def("SetConcurrentQueries",&PyEnvironmentBase::SetConcurrentQueries, PY_ARGS("concurrent") DOXY_FN(EnvironmentBase,SetConcurrentQueries))
+                     .def("IsConcurrentQueries",&PyEnvironmentBase::IsConcurrentQueries, DOXY_FN(EnvironmentBase,IsConcurrentQueries))
+                     .def("GetLockStatistics",&PyEnvironmentBase::GetLockStatistics, DOXY_FN(EnvironmentBase,GetLockStatistics))
+                     .def("ResetLockStatistics",&PyEnvironmentBase::ResetLockStatistics, DOXY_FN(EnvironmentBase,ResetLockStatistics))
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
                      .def("GetPublishedBody",&PyEnvironmentBase::GetPublishedBody,
                           "name"_a,
@@ -1066,6 +1066,9 @@ object PyLink::PyGeometry::GetAmbientColor() const {
 object PyLink::PyGeometry::GetInfo() {
     return py::to_object(PyGeometryInfoPtr(new PyGeometryInfo(_pgeometry->GetInfo())));
 }
+bool PyLink::PyGeometry::SharesInfo(OPENRAVE_SHARED_PTR<PyGeometry> p) const {
+    return !!p && _pgeometry->SharesInfo(*p->_pgeometry);
+}
 object PyLink::PyGeometry::ComputeInnerEmptyVolume() const
 {
     Transform tInnerEmptyVolume;
@@ -2627,6 +2630,37 @@ object PyKinBody::GetLinkTransformations(bool returndoflastvlaues) const
     return otransforms;
 }
 
+object PyKinBody::ComputeLinkTransformationsBatch(object oconfigs) const
+{
+    const size_t dof = _pbody->GetDOF();
+    const int numconfigs = len(oconfigs);
+    std::vector<dReal> vconfigs;
+    vconfigs.reserve(numconfigs*dof);
+    for(int i = 0; i < numconfigs; ++i) {
+        std::vector<dReal> vconfig = ExtractArray<dReal>(oconfigs[i]);
+        OPENRAVE_ASSERT_OP(vconfig.size(), ==, dof);
+        vconfigs.insert(vconfigs.end(), vconfig.begin(), vconfig.end());
+    }
+
+    std::vector<Transform> vtransforms;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pbody->GetEnv()->GetMutex());
+        _pbody->ComputeLinkTransformationsBatch(vconfigs, vtransforms);
+    }
+
+    const size_t numlinks = _pbody->GetLinks().size();
+    py::list oconfigtransforms;
+    for(int i = 0; i < numconfigs; ++i) {
+        py::list otransforms;
+        for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+            otransforms.append(ReturnTransform(vtransforms[i*numlinks+ilink]));
+        }
+        oconfigtransforms.append(otransforms);
+    }
+    return oconfigtransforms;
+}
+
 void PyKinBody::SetLinkTransformations(object transforms, object odoflastvalues)
 {
     size_t numtransforms = len(transforms);
@@ -2638,10 +2672,15 @@ void PyKinBody::SetLinkTransformations(object transforms, object odoflastvalues)
         vtransforms[i] = ExtractTransform(transforms[i]);
     }
     if( IS_PYTHONOBJECT_NONE(odoflastvalues) ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pbody->GetEnv()->GetMutex());
         _pbody->SetLinkTransformations(vtransforms);
     }
     else {
-        _pbody->SetLinkTransformations(vtransforms, ExtractArray<dReal>(odoflastvalues));
+        std::vector<dReal> vdoflastvalues = ExtractArray<dReal>(odoflastvalues);
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pbody->GetEnv()->GetMutex());
+        _pbody->SetLinkTransformations(vtransforms, vdoflastvalues);
     }
 }
 
@@ -2851,7 +2890,10 @@ bool PyKinBody::IsDOFPrismatic(int dofindex) const
 
 void PyKinBody::SetTransform(object transform)
 {
-    _pbody->SetTransform(ExtractTransform(transform));
+    Transform t = ExtractTransform(transform);
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_pbody->GetEnv()->GetMutex());
+    _pbody->SetTransform(t);
 }
 
 void PyKinBody::SetDOFWeights(object o)
@@ -2992,19 +3034,26 @@ void PyKinBody::SetDOFValues(object o)
     if( (int)values.size() != GetDOF() ) {
         throw openrave_exception(_("values do not equal to body degrees of freedom"));
     }
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_pbody->GetEnv()->GetMutex());
     _pbody->SetDOFValues(values,KinBody::CLA_CheckLimits);
 }
 void PyKinBody::SetTransformWithDOFValues(object otrans,object ojoints)
 {
+    Transform t = ExtractTransform(otrans);
     if( _pbody->GetDOF() == 0 ) {
-        _pbody->SetTransform(ExtractTransform(otrans));
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pbody->GetEnv()->GetMutex());
+        _pbody->SetTransform(t);
         return;
     }
     std::vector<dReal> values = ExtractArray<dReal>(ojoints);
     if( (int)values.size() != GetDOF() ) {
         throw openrave_exception(_("values do not equal to body degrees of freedom"));
     }
-    _pbody->SetDOFValues(values,ExtractTransform(otrans),KinBody::CLA_CheckLimits);
+    openravepy::PythonThreadSaver threadsaver;
+    EnvironmentMutex::scoped_lock lock(_pbody->GetEnv()->GetMutex());
+    _pbody->SetDOFValues(values,t,KinBody::CLA_CheckLimits);
 }
 
 void PyKinBody::SetDOFValues(object o, object indices, uint32_t checklimits)
@@ -3014,6 +3063,8 @@ void PyKinBody::SetDOFValues(object o, object indices, uint32_t checklimits)
     }
     std::vector<dReal> vsetvalues = ExtractArray<dReal>(o);
     if( IS_PYTHONOBJECT_NONE(indices) ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pbody->GetEnv()->GetMutex());
         _pbody->SetDOFValues(vsetvalues,checklimits);
     }
     else {
@@ -3021,6 +3072,8 @@ void PyKinBody::SetDOFValues(object o, object indices, uint32_t checklimits)
             return;
         }
         std::vector<int> vindices = ExtractArray<int>(indices);
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pbody->GetEnv()->GetMutex());
         _pbody->SetDOFValues(vsetvalues,checklimits, vindices);
     }
 }
@@ -3181,11 +3234,71 @@ PyInterfaceBasePtr PyKinBody::GetSelfCollisionChecker()
 
 bool PyKinBody::CheckSelfCollision(PyCollisionReportPtr pReport, PyCollisionCheckerBasePtr pycollisionchecker)
 {
-    bool bCollision = _pbody->CheckSelfCollision(openravepy::GetCollisionReport(pReport), openravepy::GetCollisionChecker(pycollisionchecker));
+    bool bCollision;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_pbody->GetEnv()->GetMutex());
+        bCollision = _pbody->CheckSelfCollision(openravepy::GetCollisionReport(pReport), openravepy::GetCollisionChecker(pycollisionchecker));
+    }
     openravepy::UpdateCollisionReport(pReport,GetEnv());
     return bCollision;
 }
 
+object PyKinBody::CheckCollisionBatch(object oconfigs, object oindices, bool bCheckSelfCollision)
+{
+    std::vector<int> vindices;
+    if( IS_PYTHONOBJECT_NONE(oindices) ) {
+        vindices.resize(_pbody->GetDOF());
+        for(int i = 0; i < (int)vindices.size(); ++i) {
+            vindices[i] = i;
+        }
+    }
+    else {
+        vindices = ExtractArray<int>(oindices);
+    }
+    const size_t dof = vindices.size();
+    const int numconfigs = len(oconfigs);
+    std::vector<dReal> vconfigs;
+    vconfigs.reserve(numconfigs*dof);
+    for(int i = 0; i < numconfigs; ++i) {
+        std::vector<dReal> vconfig = ExtractArray<dReal>(oconfigs[i]);
+        OPENRAVE_ASSERT_OP(vconfig.size(), ==, dof);
+        vconfigs.insert(vconfigs.end(), vconfig.begin(), vconfig.end());
+    }
+
+    std::vector<uint8_t> vcollision(numconfigs, 0);
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        // lock after releasing the gil so that the threads waiting for the environment do not hold the gil
+        EnvironmentMutex::scoped_lock lock(_pbody->GetEnv()->GetMutex());
+        KinBody::KinBodyStateSaver saver(_pbody, KinBody::Save_LinkTransformation);
+        std::vector<dReal> vvalues(dof);
+        for(int i = 0; i < numconfigs; ++i) {
+            if( dof > 0 ) {
+                std::copy(vconfigs.begin()+i*dof, vconfigs.begin()+(i+1)*dof, vvalues.begin());
+                _pbody->SetDOFValues(vvalues, KinBody::CLA_CheckLimits, vindices);
+            }
+            vcollision[i] = _pbody->GetEnv()->CheckCollision(KinBodyConstPtr(_pbody)) || (bCheckSelfCollision && _pbody->CheckSelfCollision());
+        }
+    }
+
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    py::array_t<bool> pycollision({numconfigs});
+    py::buffer_info bufcollision = pycollision.request();
+    bool* pcollision = (bool*) bufcollision.ptr;
+    std::copy(vcollision.begin(), vcollision.end(), pcollision);
+    return pycollision;
+#else // USE_PYBIND11_PYTHON_BINDINGS
+    npy_intp dims[] = { numconfigs };
+    PyObject* pycollision = PyArray_SimpleNew(1, dims, PyArray_BOOL);
+    if( numconfigs > 0 ) {
+        // numpy bool = uint8_t
+        memcpy(PyArray_DATA(pycollision), vcollision.data(), vcollision.size()*sizeof(uint8_t));
+    }
+    return py::to_array_astype<bool>(pycollision);
+#endif // USE_PYBIND11_PYTHON_BINDINGS
+}
+
 bool PyKinBody::IsAttached(PyKinBodyPtr pattachbody)
 {
     CHECK_POINTER(pattachbody);
@@ -3376,6 +3489,44 @@ int PyKinBody::GetUpdateStamp() const
     return _pbody->GetUpdateStamp();
 }
 
+static void _CallChangeCallback(PythonCallbackHolderPtr pfncallback)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    try {
+        pfncallback->GetFunction()();
+    }
+    catch(...) {
+        RAVELOG_ERROR("exception occured in python change callback:\n");
+        PyErr_Print();
+    }
+    PyGILState_Release(gstate);
+}
+
+/// \brief keeps a KinBody::ChangeCallbackDeferrer alive until the handle is released
+class ChangeCallbackDeferrerHandle : public UserData
+{
+public:
+    ChangeCallbackDeferrerHandle(KinBodyPtr pbody) : _pbody(pbody), _deferrer(*pbody) {
+    }
+
+private:
+    KinBodyPtr _pbody;
+    KinBody::ChangeCallbackDeferrer _deferrer;
+};
+
+object PyKinBody::RegisterChangeCallback(uint32_t properties, object fncallback) const
+{
+    if( IS_PYTHONOBJECT_NONE(fncallback) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT0(_("callback not specified"), ORE_InvalidArguments);
+    }
+    return toPyUserData(_pbody->RegisterChangeCallback(properties, boost::bind(_CallChangeCallback, PythonCallbackHolderPtr(new PythonCallbackHolder(fncallback)))));
+}
+
+object PyKinBody::DeferChangeCallbacks()
+{
+    return toPyUserData(UserDataPtr(new ChangeCallbackDeferrerHandle(_pbody)));
+}
+
 string PyKinBody::serialize(int options) const
 {
     std::stringstream ss;
@@ -3896,6 +4047,7 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetFloatParameters_overloads, GetFloatPar
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetIntParameters_overloads, GetIntParameters, 0, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetStringParameters_overloads, GetStringParameters, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckSelfCollision_overloads, CheckSelfCollision, 0, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CheckCollisionBatch_overloads, CheckCollisionBatch, 1, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetLinkAccelerations_overloads, GetLinkAccelerations, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(InitCollisionMesh_overloads, InitCollisionMesh, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(InitFromBoxes_overloads, InitFromBoxes, 1, 3)
@@ -4439,6 +4591,7 @@ void init_openravepy_kinbody()
         object (PyKinBody::*GetNonAdjacentLinks2)(int) const = &PyKinBody::GetNonAdjacentLinks;
         std::string sInitFromBoxesDoc = std::string(DOXY_FN(KinBody,InitFromBoxes "const std::vector< AABB; bool")) + std::string("\nboxes is a Nx6 array, first 3 columsn are position, last 3 are extents");
         std::string sGetChainDoc = std::string(DOXY_FN(KinBody,GetChain)) + std::string("If returnjoints is false will return a list of links, otherwise will return a list of links (default is true)");
+        std::string sCheckCollisionBatchDoc = std::string("Collision checks the body against the environment, and itself if checkself is True, at every configuration (row) of configs. The gil is released and the environment locked while checking, so other python threads keep running. The state of the body is restored afterwards.\n\n:param configs: NxM array of dof values\n\n:param indices: the M dof indices of the columns, all dofs if None\n\n:return: N-element bool array, True where the configuration is in collision\n\n");
         std::string sComputeInverseDynamicsDoc = std::string(":param returncomponents: If True will return three N-element arrays that represents the torque contributions to M, C, and G.\n\n:param externalforcetorque: A dictionary of link indices and a 6-element array of forces/torques in that order.\n\n") + std::string(DOXY_FN(KinBody, ComputeInverseDynamics));
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
         scope_ kinbody = class_<PyKinBody, OPENRAVE_SHARED_PTR<PyKinBody>, PyInterfaceBase>(m, "KinBody", DOXY_CLASS(KinBody))
@@ -4580,6 +4733,7 @@ void init_openravepy_kinbody()
                          .def("GetLinkTransformations",&PyKinBody::GetLinkTransformations, GetLinkTransformations_overloads(PY_ARGS("returndoflastvlaues") DOXY_FN(KinBody,GetLinkTransformations)))
 #endif
                          .def("GetBodyTransformations",&PyKinBody::GetLinkTransformations, DOXY_FN(KinBody,GetLinkTransformations))
+                         .def("ComputeLinkTransformationsBatch",&PyKinBody::ComputeLinkTransformationsBatch, PY_ARGS("configs") "Computes the link transformations of every configuration (row) of configs without changing the body. Returns a list with the link transformations of every configuration, same as GetLinkTransformations.\n\n:param configs: NxGetDOF() array of dof values\n\n")
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
                          .def("SetLinkTransformations",&PyKinBody::SetLinkTransformations,
                               "transforms"_a,
@@ -4740,6 +4894,16 @@ void init_openravepy_kinbody()
                               )
 #else
                          .def("CheckSelfCollision",&PyKinBody::CheckSelfCollision, CheckSelfCollision_overloads(PY_ARGS("report","collisionchecker") DOXY_FN(KinBody,CheckSelfCollision)))
+#endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+                         .def("CheckCollisionBatch", &PyKinBody::CheckCollisionBatch,
+                              "configs"_a,
+                              "indices"_a = py::none_(),
+                              "checkself"_a = true,
+                              sCheckCollisionBatchDoc.c_str()
+                              )
+#else
+                         .def("CheckCollisionBatch",&PyKinBody::CheckCollisionBatch, CheckCollisionBatch_overloads(PY_ARGS("configs","indices","checkself") sCheckCollisionBatchDoc.c_str()))
 #endif
                          .def("IsAttached",&PyKinBody::IsAttached,PY_ARGS("body") DOXY_FN(KinBody,IsAttached))
                          .def("GetAttached",&PyKinBody::GetAttached, DOXY_FN(KinBody,GetAttached))
@@ -4784,6 +4948,8 @@ void init_openravepy_kinbody()
                          .def("GetAdjacentLinks",&PyKinBody::GetAdjacentLinks, DOXY_FN(KinBody,GetAdjacentLinks))
                          .def("GetManageData",&PyKinBody::GetManageData, DOXY_FN(KinBody,GetManageData))
                          .def("GetUpdateStamp",&PyKinBody::GetUpdateStamp, DOXY_FN(KinBody,GetUpdateStamp))
+                         .def("RegisterChangeCallback",&PyKinBody::RegisterChangeCallback, PY_ARGS("properties","callback") DOXY_FN(KinBody,RegisterChangeCallback))
+                         .def("DeferChangeCallbacks",&PyKinBody::DeferChangeCallbacks, DOXY_CLASS(KinBody::ChangeCallbackDeferrer))
                          .def("serialize",&PyKinBody::serialize,PY_ARGS("options") DOXY_FN(KinBody,serialize))
                          .def("GetKinematicsGeometryHash",&PyKinBody::GetKinematicsGeometryHash, DOXY_FN(KinBody,GetKinematicsGeometryHash))
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
@@ -4986,6 +5152,7 @@ void init_openravepy_kinbody()
                                   .def("GetAmbientColor",&PyLink::PyGeometry::GetAmbientColor,DOXY_FN(KinBody::Link::Geometry,GetAmbientColor))
                                   .def("ComputeInnerEmptyVolume",&PyLink::PyGeometry::ComputeInnerEmptyVolume,DOXY_FN(KinBody::Link::Geometry,ComputeInnerEmptyVolume))
                                   .def("GetInfo",&PyLink::PyGeometry::GetInfo,DOXY_FN(KinBody::Link::Geometry,GetInfo))
+                                  .def("SharesInfo",&PyLink::PyGeometry::SharesInfo, PY_ARGS("geometry") DOXY_FN(KinBody::Link::Geometry,SharesInfo))
                                   .def("__eq__",&PyLink::PyGeometry::__eq__)
                                   .def("__ne__",&PyLink::PyGeometry::__ne__)
                                   .def("__hash__",&PyLink::PyGeometry::__hash__)
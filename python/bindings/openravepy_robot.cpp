@@ -620,6 +620,58 @@ object PyRobotBase::PyManipulator::FindIKSolutions(object oparam, int filteropti
     }
 }
 
+object PyRobotBase::PyManipulator::FindIKSolutionsBatch(object oparams, int filteroptions) const
+{
+    std::vector<IkParameterization> vikparams(len(oparams));
+    for(size_t i = 0; i < vikparams.size(); ++i) {
+        // assume transformation matrix
+        if( !ExtractIkParameterization(oparams[i],vikparams[i]) ) {
+            vikparams[i] = IkParameterization(ExtractTransform(oparams[i]));
+        }
+    }
+    const size_t nArmIndices = _pmanip->GetArmIndices().size();
+    std::vector< std::vector< std::vector<dReal> > > vsolutions;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        // lock after releasing the gil so that the threads waiting for the environment do not hold the gil
+        EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex());
+        IkSolverBasePtr pIkSolver = _pmanip->GetIkSolver();
+        OPENRAVE_ASSERT_FORMAT(!!pIkSolver, "manipulator %s does not have an IK solver set", _pmanip->GetName(), ORE_Failed);
+        // the ik solver expects the poses in the frame of the manipulator base
+        if( !!_pmanip->GetBase() ) {
+            Transform tbaseinv = _pmanip->GetBase()->GetTransform().inverse();
+            FOREACH(itikparam, vikparams) {
+                *itikparam = tbaseinv * *itikparam;
+            }
+        }
+        pIkSolver->SolveAllBatch(vikparams, filteroptions, vsolutions);
+    }
+
+    py::list pysolutions;
+    FOREACHC(itsolutions, vsolutions) {
+        npy_intp dims[] = { npy_intp(itsolutions->size()), npy_intp(nArmIndices) };
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+        py::array_t<dReal> pyparamsolutions({dims[0], dims[1]});
+        py::buffer_info buf = pyparamsolutions.request();
+        dReal* ppos = (dReal*) buf.ptr;
+#else // USE_PYBIND11_PYTHON_BINDINGS
+        PyObject *pyparamsolutions = PyArray_SimpleNew(2,dims, sizeof(dReal)==8 ? PyArray_DOUBLE : PyArray_FLOAT);
+        dReal* ppos = (dReal*)PyArray_DATA(pyparamsolutions);
+#endif // USE_PYBIND11_PYTHON_BINDINGS
+        for(const std::vector<dReal>& solution : *itsolutions) {
+            BOOST_ASSERT(solution.size() == nArmIndices);
+            std::copy(begin(solution), end(solution), ppos);
+            ppos += nArmIndices;
+        }
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+        pysolutions.append(pyparamsolutions);
+#else // USE_PYBIND11_PYTHON_BINDINGS
+        pysolutions.append(py::to_array_astype<dReal>(pyparamsolutions));
+#endif // USE_PYBIND11_PYTHON_BINDINGS
+    }
+    return pysolutions;
+}
+
 object PyRobotBase::PyManipulator::FindIKSolutions(object oparam, object freeparams, int filteroptions, bool ikreturn, bool releasegil) const
 {
     std::vector<dReal> vfreeparams = ExtractArray<dReal>(freeparams);
@@ -1477,6 +1529,8 @@ void PyRobotBase::SetActiveDOFValues(object values, uint32_t checklimits) const
 {
     std::vector<dReal> vvalues = ExtractArray<dReal>(values);
     if( vvalues.size() > 0 ) {
+        openravepy::PythonThreadSaver threadsaver;
+        EnvironmentMutex::scoped_lock lock(_probot->GetEnv()->GetMutex());
         _probot->SetActiveDOFValues(vvalues,checklimits);
     }
     else {
@@ -2265,6 +2319,7 @@ void init_openravepy_robot()
 #else
         .def("FindIKSolutions",pmanipiksf,FindIKSolutionsFree_overloads(PY_ARGS("param","freevalues","filteroptions","ikreturn","releasegil") DOXY_FN(RobotBase::Manipulator,FindIKSolutions "const IkParameterization; const std::vector; std::vector; int")))
 #endif
+        .def("FindIKSolutionsBatch",&PyRobotBase::PyManipulator::FindIKSolutionsBatch, PY_ARGS("params","filteroptions") "Finds all the ik solutions of every pose in params with the gil released and the environment locked, so other python threads keep running. The poses are IkParameterization objects or 4x4 matrices in the world frame. Returns a list with a solutions x arm dof array for every pose.\n\n")
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
         .def("GetIkParameterization", &PyRobotBase::PyManipulator::GetIkParameterization,
              "iktype"_a,
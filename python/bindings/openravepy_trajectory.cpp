@@ -110,14 +110,20 @@ void PyTrajectoryBase::Remove(size_t startindex, size_t endindex)
 object PyTrajectoryBase::Sample(dReal time) const
 {
     std::vector<dReal> values;
-    _ptrajectory->Sample(values,time);
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        _ptrajectory->Sample(values,time);
+    }
     return toPyArray(values);
 }
 
 object PyTrajectoryBase::Sample(dReal time, PyConfigurationSpecificationPtr pyspec) const
 {
     std::vector<dReal> values;
-    _ptrajectory->Sample(values,time,openravepy::GetConfigurationSpecification(pyspec), true);
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        _ptrajectory->Sample(values,time,openravepy::GetConfigurationSpecification(pyspec), true);
+    }
     return toPyArray(values);
 }
 
@@ -132,7 +138,10 @@ object PyTrajectoryBase::Sample(dReal time, OPENRAVE_SHARED_PTR<ConfigurationSpe
 object PyTrajectoryBase::SampleFromPrevious(object odata, dReal time, PyConfigurationSpecificationPtr pyspec) const
 {
     std::vector<dReal> vdata = ExtractArray<dReal>(odata);
-    _ptrajectory->Sample(vdata,time,openravepy::GetConfigurationSpecification(pyspec), false);
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        _ptrajectory->Sample(vdata,time,openravepy::GetConfigurationSpecification(pyspec), false);
+    }
     return toPyArray(vdata);
 }
 
@@ -146,7 +155,10 @@ object PyTrajectoryBase::SamplePoints2D(object otimes) const
 {
     std::vector<dReal> values;
     std::vector<dReal> vtimes = ExtractArray<dReal>(otimes);
-    _ptrajectory->SamplePoints(values,vtimes);
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        _ptrajectory->SamplePoints(values,vtimes);
+    }
 
     const int numdof = _ptrajectory->GetConfigurationSpecification().GetDOF();
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
@@ -168,7 +180,10 @@ object PyTrajectoryBase::SamplePoints2D(object otimes, PyConfigurationSpecificat
     std::vector<dReal> values;
     ConfigurationSpecification spec = openravepy::GetConfigurationSpecification(pyspec);
     std::vector<dReal> vtimes = ExtractArray<dReal>(otimes);
-    _ptrajectory->SamplePoints(values, vtimes, spec);
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        _ptrajectory->SamplePoints(values, vtimes, spec);
+    }
 
     const int numdof = spec.GetDOF();
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
@@ -191,6 +206,44 @@ object PyTrajectoryBase::SamplePoints2D(object otimes, OPENRAVE_SHARED_PTR<Confi
     return this->SamplePoints2D(otimes, pyspec);
 }
 
+/// \brief returns the points in values as a numpoints x numdof array
+static object _ToPyArray2D(const std::vector<dReal>& values, int numdof)
+{
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    py::array_t<dReal> pypos = toPyArray(values);
+    pypos.resize({(int) values.size()/numdof, numdof});
+    return pypos;
+#else // USE_PYBIND11_PYTHON_BINDINGS
+    npy_intp dims[] = { npy_intp(values.size()/numdof), npy_intp(numdof) };
+    PyObject *pypos = PyArray_SimpleNew(2,dims, sizeof(dReal)==8 ? PyArray_DOUBLE : PyArray_FLOAT);
+    if( !values.empty() ) {
+        memcpy(PyArray_DATA(pypos), values.data(), values.size()*sizeof(values[0]));
+    }
+    return py::to_array_astype<dReal>(pypos);
+#endif // USE_PYBIND11_PYTHON_BINDINGS
+}
+
+object PyTrajectoryBase::SampleRange2D(dReal tstart, dReal tend, dReal deltatime) const
+{
+    std::vector<dReal> values;
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        _ptrajectory->SampleRange(values, tstart, tend, deltatime);
+    }
+    return _ToPyArray2D(values, _ptrajectory->GetConfigurationSpecification().GetDOF());
+}
+
+object PyTrajectoryBase::SampleRange2D(dReal tstart, dReal tend, dReal deltatime, PyConfigurationSpecificationPtr pyspec) const
+{
+    std::vector<dReal> values;
+    ConfigurationSpecification spec = openravepy::GetConfigurationSpecification(pyspec);
+    {
+        openravepy::PythonThreadSaver threadsaver;
+        _ptrajectory->SampleRange(values, tstart, tend, deltatime, spec);
+    }
+    return _ToPyArray2D(values, spec.GetDOF());
+}
+
 object PyTrajectoryBase::GetConfigurationSpecification() const {
     return py::to_object(openravepy::toPyConfigurationSpecification(_ptrajectory->GetConfigurationSpecification()));
 }
@@ -483,6 +536,8 @@ void init_openravepy_trajectory()
     object (PyTrajectoryBase::*SamplePoints2D1)(object) const = &PyTrajectoryBase::SamplePoints2D;
     object (PyTrajectoryBase::*SamplePoints2D2)(object, PyConfigurationSpecificationPtr) const = &PyTrajectoryBase::SamplePoints2D;
     object (PyTrajectoryBase::*SamplePoints2D3)(object, OPENRAVE_SHARED_PTR<ConfigurationSpecification::Group>) const = &PyTrajectoryBase::SamplePoints2D;
+    object (PyTrajectoryBase::*SampleRange2D1)(dReal, dReal, dReal) const = &PyTrajectoryBase::SampleRange2D;
+    object (PyTrajectoryBase::*SampleRange2D2)(dReal, dReal, dReal, PyConfigurationSpecificationPtr) const = &PyTrajectoryBase::SampleRange2D;
     object (PyTrajectoryBase::*GetWaypoints1)(size_t,size_t) const = &PyTrajectoryBase::GetWaypoints;
     object (PyTrajectoryBase::*GetWaypoints2)(size_t,size_t,PyConfigurationSpecificationPtr) const = &PyTrajectoryBase::GetWaypoints;
     object (PyTrajectoryBase::*GetWaypoints3)(size_t, size_t, OPENRAVE_SHARED_PTR<ConfigurationSpecification::Group>) const = &PyTrajectoryBase::GetWaypoints;
@@ -520,6 +575,8 @@ void init_openravepy_trajectory()
     .def("SamplePoints2D",SamplePoints2D1, PY_ARGS("times") DOXY_FN(TrajectoryBase,SamplePoints2D "std::vector; std::vector"))
     .def("SamplePoints2D",SamplePoints2D2, PY_ARGS("times","spec") DOXY_FN(TrajectoryBase,SamplePoints2D "std::vector; std::vector; const ConfigurationSpecification"))
     .def("SamplePoints2D",SamplePoints2D3, PY_ARGS("times","group") DOXY_FN(TrajectoryBase,SamplePoints2D "std::vector; std::vector; const ConfigurationSpecification::Group"))
+    .def("SampleRange2D",SampleRange2D1, PY_ARGS("tstart","tend","deltatime") DOXY_FN(TrajectoryBase,SampleRange "std::vector; dReal; dReal; dReal"))
+    .def("SampleRange2D",SampleRange2D2, PY_ARGS("tstart","tend","deltatime","spec") DOXY_FN(TrajectoryBase,SampleRange "std::vector; dReal; dReal; dReal; const ConfigurationSpecification"))
     .def("GetConfigurationSpecification",&PyTrajectoryBase::GetConfigurationSpecification,DOXY_FN(TrajectoryBase,GetConfigurationSpecification))
     .def("GetNumWaypoints",&PyTrajectoryBase::GetNumWaypoints,DOXY_FN(TrajectoryBase,GetNumWaypoints))
     .def("GetWaypoints",GetWaypoints1, PY_ARGS("startindex","endindex") DOXY_FN(TrajectoryBase, GetWaypoints "size_t; size_t; std::vector"))
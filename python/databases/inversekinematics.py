@@ -994,6 +994,13 @@ class InverseKinematicsModel(DatabaseGenerator):
         with self.env:
             results = self.ikfastproblem.SendCommand('PerfTiming num %d %s'%(num,self.getfilename(True)))
             return [double(s)*1e-9 for s in results.split()]
+
+    def perftimingbatch(self,num,numthreads):
+        """Returns the number of random poses solved per second when num poses are spread over numthreads threads.
+        """
+        with self.env:
+            results = self.ikfastproblem.SendCommand('PerfTiming num %d threads %d %s'%(num,numthreads,self.getfilename(True)))
+            return double(results)
         
     def testik(self,iktests,jacobianthreshold=None):
         """Tests the iksolver.
@@ -28,6 +28,7 @@ import tutorial_inversereachability
 import tutorial_plotting
 
 # examples showing complex demos
+import bindingsbenchmark
 import calibrationviews
 import checkconvexdecomposition
 import checkvisibility
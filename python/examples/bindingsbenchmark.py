@@ -0,0 +1,98 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# Copyright (C) 2026 agent <agent@local>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Times passing large arrays through the python bindings.
+
+Numeric numpy arrays are copied into the bindings with one memcpy, while python lists go through the element-wise
+path. Every call is timed with both kinds of inputs so the gain of the numpy path can be read directly:
+
+- KinBody.SetDOFValues with the values of one configuration
+- Trajectory.Insert and Trajectory.GetWaypoints with a trajectory of many waypoints
+- Environment.plot3 with a large point cloud (the points are converted even if there is no viewer)
+
+.. examplepre-block:: bindingsbenchmark
+
+.. examplepost-block:: bindingsbenchmark
+"""
+from __future__ import with_statement # for python 2.5
+__author__ = 'agent'
+
+import time
+import openravepy
+if not __openravepy_build_doc__:
+    from openravepy import *
+    from numpy import *
+
+def timecall(fn, numcalls):
+    """returns the seconds per call of fn"""
+    starttime = time.time()
+    for i in range(numcalls):
+        fn()
+    return (time.time()-starttime)/numcalls
+
+def main(env,options):
+    "Main example code."
+    env.Load(options.robot)
+    robot = env.GetRobots()[0]
+    with env:
+        lower,upper = robot.GetDOFLimits()
+        values = lower+random.rand(robot.GetDOF())*(upper-lower)
+        listvalues = list(values)
+        tarray = timecall(lambda: robot.SetDOFValues(values), options.calls)
+        tlist = timecall(lambda: robot.SetDOFValues(listvalues), options.calls)
+        print 'SetDOFValues (%d dofs): numpy=%.2fus, list=%.2fus, speedup=%.2fx'%(robot.GetDOF(),tarray*1e6,tlist*1e6,tlist/tarray)
+
+        spec = robot.GetActiveConfigurationSpecification()
+        spec.AddDeltaTimeGroup()
+        waypoints = random.rand(options.waypoints*spec.GetDOF())
+        listwaypoints = list(waypoints)
+        traj = RaveCreateTrajectory(env,'')
+        def insert(data):
+            traj.Init(spec)
+            traj.Insert(0,data)
+        tarray = timecall(lambda: insert(waypoints), 10)
+        tlist = timecall(lambda: insert(listwaypoints), 10)
+        tget = timecall(lambda: traj.GetWaypoints(0,traj.GetNumWaypoints()), 10)
+        print 'Trajectory.Insert (%d waypoints): numpy=%.2fms, list=%.2fms, speedup=%.2fx, GetWaypoints=%.2fms'%(options.waypoints,tarray*1e3,tlist*1e3,tlist/tarray,tget*1e3)
+
+    points = random.rand(options.points,3)
+    listpoints = points.tolist()
+    tarray = timecall(lambda: env.plot3(points,2), 5)
+    tlist = timecall(lambda: env.plot3(listpoints,2), 1)
+    print 'plot3 (%d points): numpy=%.2fms, list=%.2fms, speedup=%.2fx'%(options.points,tarray*1e3,tlist*1e3,tlist/tarray)
+
+from optparse import OptionParser
+from openravepy.misc import OpenRAVEGlobalArguments
+
+@openravepy.with_destroy
+def run(args=None):
+    """Command-line execution of the example.
+
+    :param args: arguments for script to parse, if not specified will use sys.argv
+    """
+    parser = OptionParser(description='Times passing numpy arrays and python lists through the openravepy bindings.')
+    OpenRAVEGlobalArguments.addOptions(parser)
+    parser.add_option('--robot',action="store",type='string',dest='robot',default='robots/barrettwam.robot.xml',
+                      help='Robot to set the configurations of (default=%default)')
+    parser.add_option('--calls',action="store",type='int',dest='calls',default=10000,
+                      help='Number of SetDOFValues calls (default=%default)')
+    parser.add_option('--waypoints',action="store",type='int',dest='waypoints',default=10000,
+                      help='Number of trajectory waypoints (default=%default)')
+    parser.add_option('--points',action="store",type='int',dest='points',default=1000000,
+                      help='Number of points to plot (default=%default)')
+    (options, leftargs) = parser.parse_args(args=args)
+    OpenRAVEGlobalArguments.parseAndCreateThreadedUser(options,main,defaultviewer=False)
+
+if __name__ == "__main__":
+    run()
@@ -0,0 +1,161 @@
+/** \example orcachebenchmark.cpp
+    \author agent <agent@local>, 2026
+
+    Measures how the self collision checks per second of the CacheChecker collision checker scale with the number of
+    threads when all threads share one concurrent self collision cache. The checker is set to track the robot and its
+    self collision cache is made concurrent with the SetSelfCacheConcurrent command. Every thread gets a clone of the
+    environment, whose checker shares the self collision cache, and self collision checks its robot at random
+    configurations. The configurations are drawn from a fixed pool, so later checks hit the configurations cached by
+    other threads. For every number of threads the checks per second and the cache hit rate are printed.
+
+    Usage:
+    \verbatim
+    orcachebenchmark [--threads num] [--checks num] [--samples num] [--robot name] [scene]
+    \endverbatim
+
+    - \b --threads - maximum number of threads, the number of threads is doubled from 1 up to it (default 32).
+    - \b --checks - number of self collision checks for every number of threads (default 20000).
+    - \b --samples - size of the pool of random configurations (default 5000).
+    - \b --robot - robot to track (default the first robot in the scene).
+
+    If no scene is specified, uses data/lab1.env.xml.
+
+    <b>Full Example Code:</b>
+ */
+#include <openrave-core.h>
+#include <openrave/utils.h>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+
+using namespace OpenRAVE;
+using namespace std;
+
+void CheckSelfCollisions(EnvironmentBasePtr penv, const string& robotname, const vector<dReal>& vsamples, int dof, int startsample, int numchecks)
+{
+    EnvironmentMutex::scoped_lock lock(penv->GetMutex());
+    RobotBasePtr probot = penv->GetRobot(robotname);
+    int numsamples = (int)vsamples.size()/dof;
+    vector<dReal> vvalues(dof);
+    for(int icheck = 0; icheck < numchecks; ++icheck) {
+        int isample = (startsample+icheck)%numsamples;
+        std::copy(vsamples.begin()+isample*dof, vsamples.begin()+(isample+1)*dof, vvalues.begin());
+        probot->SetDOFValues(vvalues, KinBody::CLA_Nothing);
+        probot->CheckSelfCollision();
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    int maxthreads = 32, numchecks = 20000, numsamples = 5000;
+    string scenefilename = "data/lab1.env.xml", robotname;
+    for(int i = 1; i < argc; ++i) {
+        if( strcmp(argv[i], "--threads") == 0 && i+1 < argc ) {
+            maxthreads = max(1, atoi(argv[++i]));
+        }
+        else if( strcmp(argv[i], "--checks") == 0 && i+1 < argc ) {
+            numchecks = atoi(argv[++i]);
+        }
+        else if( strcmp(argv[i], "--samples") == 0 && i+1 < argc ) {
+            numsamples = max(1, atoi(argv[++i]));
+        }
+        else if( strcmp(argv[i], "--robot") == 0 && i+1 < argc ) {
+            robotname = argv[++i];
+        }
+        else {
+            scenefilename = argv[i];
+        }
+    }
+
+    RaveInitialize(true); // start openrave core
+    EnvironmentBasePtr penv = RaveCreateEnvironment(); // create the main environment
+    penv->Load(scenefilename);
+
+    CollisionCheckerBasePtr pchecker = RaveCreateCollisionChecker(penv, "CacheChecker");
+    if( !pchecker ) {
+        RAVELOG_WARN("failed to create the CacheChecker collision checker\n");
+        RaveDestroy();
+        return 1;
+    }
+    penv->SetCollisionChecker(pchecker);
+
+    vector<dReal> vsamples;
+    int dof = 0;
+    {
+        EnvironmentMutex::scoped_lock lock(penv->GetMutex());
+        RobotBasePtr probot;
+        if( robotname.size() > 0 ) {
+            probot = penv->GetRobot(robotname);
+        }
+        else {
+            vector<RobotBasePtr> vrobots;
+            penv->GetRobots(vrobots);
+            if( vrobots.size() > 0 ) {
+                probot = vrobots.at(0);
+            }
+        }
+        if( !probot ) {
+            RAVELOG_WARN_FORMAT("no robot to track in %s", scenefilename);
+            RaveDestroy();
+            return 1;
+        }
+        robotname = probot->GetName();
+
+        stringstream sout, strack, sconcurrent("SetSelfCacheConcurrent 1");
+        strack << "TrackRobotState " << robotname;
+        if( !pchecker->SendCommand(sout, strack) || !pchecker->SendCommand(sout, sconcurrent) ) {
+            RAVELOG_WARN_FORMAT("failed to set up the self collision cache of %s", robotname);
+            RaveDestroy();
+            return 1;
+        }
+
+        dof = probot->GetDOF();
+        vector<dReal> vlower, vupper;
+        probot->GetDOFLimits(vlower, vupper);
+        vsamples.resize(numsamples*dof);
+        for(int isample = 0; isample < numsamples; ++isample) {
+            for(int j = 0; j < dof; ++j) {
+                // continuous joints have very large limits
+                dReal flower = max(vlower[j], dReal(-PI)), fupper = min(vupper[j], dReal(PI));
+                vsamples[isample*dof+j] = flower + RaveRandomFloat()*(fupper-flower);
+            }
+        }
+    }
+
+    for(int numthreads = 1; numthreads <= maxthreads; numthreads *= 2) {
+        // every thread gets its own environment, the cloned checkers share the self collision cache of pchecker
+        vector<EnvironmentBasePtr> venvs(numthreads);
+        for(int ithread = 0; ithread < numthreads; ++ithread) {
+            venvs[ithread] = penv->CloneSelf(Clone_Bodies);
+        }
+
+        uint64_t starttime = utils::GetMicroTime();
+        boost::thread_group threads;
+        for(int ithread = 0; ithread < numthreads; ++ithread) {
+            threads.create_thread(boost::bind(CheckSelfCollisions, venvs[ithread], boost::cref(robotname), boost::cref(vsamples), dof, ithread*numsamples/numthreads, numchecks/numthreads));
+        }
+        threads.join_all();
+        uint64_t checktime = utils::GetMicroTime()-starttime;
+
+        // add up the statistics of all cloned checkers: checks, collision hits, free hits, cached configurations
+        int numtotalchecks = 0, numhits = 0, numnodes = 0;
+        for(int ithread = 0; ithread < numthreads; ++ithread) {
+            stringstream sout, sinput("GetSelfCacheStatistics");
+            if( venvs[ithread]->GetCollisionChecker()->SendCommand(sout, sinput) ) {
+                int numthreadchecks = 0, numcollisionhits = 0, numfreehits = 0;
+                sout >> numthreadchecks >> numcollisionhits >> numfreehits >> numnodes;
+                numtotalchecks += numthreadchecks;
+                numhits += numcollisionhits + numfreehits;
+            }
+            venvs[ithread]->Destroy();
+        }
+        RAVELOG_INFO_FORMAT("%s threads=%d checks=%d: %.0f checks/s, hit rate=%.3f, cached configurations=%d", robotname%numthreads%numtotalchecks%(checktime > 0 ? 1e6*numtotalchecks/checktime : 0.0)%(numtotalchecks > 0 ? dReal(numhits)/numtotalchecks : dReal(0))%numnodes);
+    }
+
+    RaveDestroy(); // destroy
+    return 0;
+}
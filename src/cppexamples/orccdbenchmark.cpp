@@ -0,0 +1,145 @@
+/** \example orccdbenchmark.cpp
+    \author agent <agent@local>, 2026
+
+    Compares validating straight joint-space segments of a robot by discretizing them at the DOF resolutions and
+    checking every configuration against validating them with one CollisionCheckerBase::CheckContinuousCollision call.
+    The segments connect random collision-free configurations. The timings and the number of segments where the two
+    methods disagree are printed.
+
+    Usage:
+    \verbatim
+    orccdbenchmark [--segments num] [--collision checker] [scene]
+    \endverbatim
+
+    - \b --segments - number of random segments (default 200).
+    - \b --collision - collision checker to use (default fcl_).
+
+    If no scene is specified, uses data/lab1.env.xml.
+
+    <b>Full Example Code:</b>
+ */
+#include <openrave-core.h>
+#include <openrave/utils.h>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+using namespace OpenRAVE;
+using namespace std;
+
+/// \brief samples a collision-free configuration of the robot
+static bool SampleFreeConfiguration(RobotBasePtr probot, const vector<dReal>& vlower, const vector<dReal>& vupper, vector<dReal>& q)
+{
+    q.resize(vlower.size());
+    for(int itry = 0; itry < 1000; ++itry) {
+        for(size_t j = 0; j < q.size(); ++j) {
+            // limits of circular joints are very large, so sample them in [-pi,pi]
+            dReal flower = max(vlower[j], dReal(-PI)), fupper = min(vupper[j], dReal(PI));
+            q[j] = flower + RaveRandomFloat()*(fupper-flower);
+        }
+        probot->SetDOFValues(q, KinBody::CLA_Nothing);
+        if( !probot->GetEnv()->CheckCollision(probot) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// \brief checks the configurations of the segment at the DOF resolutions, returns true if any of them collides
+static bool CheckSegmentDiscrete(RobotBasePtr probot, const vector<dReal>& q0, const vector<dReal>& q1, const vector<dReal>& vresolutions)
+{
+    int numsteps = 1;
+    for(size_t j = 0; j < q0.size(); ++j) {
+        numsteps = max(numsteps, (int)ceil(RaveFabs(q1[j]-q0[j])/vresolutions[j]));
+    }
+    vector<dReal> q(q0.size());
+    for(int istep = 1; istep <= numsteps; ++istep) {
+        dReal fraction = dReal(istep)/dReal(numsteps);
+        for(size_t j = 0; j < q.size(); ++j) {
+            q[j] = q0[j] + fraction*(q1[j]-q0[j]);
+        }
+        probot->SetDOFValues(q, KinBody::CLA_Nothing);
+        if( probot->GetEnv()->CheckCollision(probot) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char ** argv)
+{
+    int numsegments = 200;
+    string scenefilename = "data/lab1.env.xml", collisionchecker = "fcl_";
+    for(int i = 1; i < argc; ++i) {
+        if( strcmp(argv[i], "--segments") == 0 && i+1 < argc ) {
+            numsegments = atoi(argv[++i]);
+        }
+        else if( strcmp(argv[i], "--collision") == 0 && i+1 < argc ) {
+            collisionchecker = argv[++i];
+        }
+        else {
+            scenefilename = argv[i];
+        }
+    }
+
+    RaveInitialize(true); // start openrave core
+    EnvironmentBasePtr penv = RaveCreateEnvironment(); // create the main environment
+    CollisionCheckerBasePtr pchecker = RaveCreateCollisionChecker(penv, collisionchecker);
+    if( !pchecker ) {
+        RAVELOG_WARN_FORMAT("failed to create collision checker %s", collisionchecker);
+        RaveDestroy();
+        return 1;
+    }
+    penv->SetCollisionChecker(pchecker);
+    penv->Load(scenefilename);
+
+    vector<RobotBasePtr> vrobots;
+    penv->GetRobots(vrobots);
+    if( vrobots.size() == 0 ) {
+        RAVELOG_WARN_FORMAT("no robots in %s", scenefilename);
+        RaveDestroy();
+        return 1;
+    }
+    RobotBasePtr probot = vrobots.at(0);
+
+    {
+        EnvironmentMutex::scoped_lock lock(penv->GetMutex());
+        vector<dReal> vlower, vupper, vresolutions;
+        probot->GetDOFLimits(vlower, vupper);
+        probot->GetDOFResolutions(vresolutions);
+
+        vector< vector<dReal> > vsegments;
+        vector<dReal> q;
+        while( (int)vsegments.size() < 2*numsegments && SampleFreeConfiguration(probot, vlower, vupper, q) ) {
+            vsegments.push_back(q);
+        }
+        numsegments = vsegments.size()/2;
+
+        vector<uint8_t> vdiscretecollisions(numsegments), vcontinuouscollisions(numsegments);
+        uint64_t starttime = utils::GetMicroTime();
+        for(int isegment = 0; isegment < numsegments; ++isegment) {
+            vdiscretecollisions[isegment] = CheckSegmentDiscrete(probot, vsegments[2*isegment], vsegments[2*isegment+1], vresolutions);
+        }
+        uint64_t discretetime = utils::GetMicroTime()-starttime;
+
+        dReal ftimeofcontact = 0;
+        starttime = utils::GetMicroTime();
+        for(int isegment = 0; isegment < numsegments; ++isegment) {
+            vcontinuouscollisions[isegment] = pchecker->CheckContinuousCollision(probot, vsegments[2*isegment], vsegments[2*isegment+1], ftimeofcontact);
+        }
+        uint64_t continuoustime = utils::GetMicroTime()-starttime;
+
+        int numcolliding = 0, nummissed = 0, numextra = 0;
+        for(int isegment = 0; isegment < numsegments; ++isegment) {
+            numcolliding += vdiscretecollisions[isegment];
+            nummissed += vdiscretecollisions[isegment] && !vcontinuouscollisions[isegment];
+            numextra += !vdiscretecollisions[isegment] && vcontinuouscollisions[isegment];
+        }
+        RAVELOG_INFO_FORMAT("%s: %d segments (%d colliding), discrete=%.3fms/segment, continuous=%.3fms/segment, speedup=%.2fx", probot->GetName()%numsegments%numcolliding%(numsegments > 0 ? 1e-3*discretetime/numsegments : 0.0)%(numsegments > 0 ? 1e-3*continuoustime/numsegments : 0.0)%(continuoustime > 0 ? dReal(discretetime)/dReal(continuoustime) : dReal(0)));
+        // continuous checking also finds the contacts that happen between the discretized configurations
+        RAVELOG_INFO_FORMAT("segments only colliding when discretized: %d, only colliding when continuous: %d", nummissed%numextra);
+    }
+
+    RaveDestroy(); // destroy
+    return 0;
+}
@@ -0,0 +1,155 @@
+/** \example orfkbenchmark.cpp
+    \author agent <agent@local>, 2026
+
+    Measures the forward kinematics throughput of KinBody::SetDOFValues on a set of robots. Every
+    robot is timed with the precompiled forward kinematics program and with the generic
+    forward kinematics path (toggled through the SetUseForwardKinematicsProgram body command), and
+    with KinBody::ComputeLinkTransformationsBatch on the same configurations. Finally the precompiled path is timed
+    again with change callbacks registered for KinBody::Prop_LinkTransforms, once dispatching the callbacks after
+    every configuration and once coalescing them with a KinBody::ChangeCallbackDeferrer around the whole loop.
+
+    Usage:
+    \verbatim
+    orfkbenchmark [--samples num] [--callbacks num] [robot_model ...]
+    \endverbatim
+
+    - \b --samples - number of random configurations set per robot and path (default 100000).
+    - \b --callbacks - number of change callbacks to register for the callback timings (default 4).
+
+    If no robots are specified, uses robots/barrettwam.robot.xml, robots/pr2-beta-static.zae and robots/puma.robot.xml.
+
+    <b>Full Example Code:</b>
+ */
+#include <openrave-core.h>
+#include <openrave/utils.h>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+
+#include <boost/bind.hpp>
+
+using namespace OpenRAVE;
+using namespace std;
+
+static void CountChange(int* pcount)
+{
+    ++(*pcount);
+}
+
+/// \brief sets all the configurations in vconfigs and returns the number of SetDOFValues calls per second
+static dReal TimeForwardKinematics(KinBodyPtr pbody, const vector< vector<dReal> >& vconfigs, bool buseprogram)
+{
+    stringstream sout, sinput;
+    sinput << "SetUseForwardKinematicsProgram " << buseprogram;
+    pbody->SendCommand(sout, sinput);
+
+    uint64_t starttime = utils::GetMicroTime();
+    for(size_t i = 0; i < vconfigs.size(); ++i) {
+        pbody->SetDOFValues(vconfigs[i], KinBody::CLA_Nothing);
+    }
+    uint64_t elapsed = utils::GetMicroTime()-starttime;
+    return elapsed > 0 ? dReal(vconfigs.size())*1e6/dReal(elapsed) : dReal(0);
+}
+
+/// \brief computes the link transformations of all the configurations with ComputeLinkTransformationsBatch and returns the number of configurations per second
+static dReal TimeForwardKinematicsBatch(KinBodyPtr pbody, const vector< vector<dReal> >& vconfigs)
+{
+    vector<dReal> vflatconfigs;
+    vflatconfigs.reserve(vconfigs.size()*pbody->GetDOF());
+    for(size_t i = 0; i < vconfigs.size(); ++i) {
+        vflatconfigs.insert(vflatconfigs.end(), vconfigs[i].begin(), vconfigs[i].end());
+    }
+    vector<Transform> vtransforms;
+    uint64_t starttime = utils::GetMicroTime();
+    pbody->ComputeLinkTransformationsBatch(vflatconfigs, vtransforms);
+    uint64_t elapsed = utils::GetMicroTime()-starttime;
+    return elapsed > 0 ? dReal(vconfigs.size())*1e6/dReal(elapsed) : dReal(0);
+}
+
+/// \brief sets all the configurations in vconfigs with numcallbacks change callbacks registered and returns the number of SetDOFValues calls per second
+static dReal TimeForwardKinematicsCallbacks(KinBodyPtr pbody, const vector< vector<dReal> >& vconfigs, int numcallbacks, bool bdefer)
+{
+    int numchanges = 0;
+    vector<UserDataPtr> vhandles(numcallbacks);
+    for(int i = 0; i < numcallbacks; ++i) {
+        vhandles[i] = pbody->RegisterChangeCallback(KinBody::Prop_LinkTransforms, boost::bind(CountChange, &numchanges));
+    }
+
+    uint64_t starttime = utils::GetMicroTime();
+    {
+        boost::shared_ptr<KinBody::ChangeCallbackDeferrer> pdeferrer;
+        if( bdefer ) {
+            pdeferrer.reset(new KinBody::ChangeCallbackDeferrer(*pbody));
+        }
+        for(size_t i = 0; i < vconfigs.size(); ++i) {
+            pbody->SetDOFValues(vconfigs[i], KinBody::CLA_Nothing);
+        }
+    }
+    uint64_t elapsed = utils::GetMicroTime()-starttime;
+    RAVELOG_DEBUG_FORMAT("%s received %d change callbacks", pbody->GetName()%numchanges);
+    return elapsed > 0 ? dReal(vconfigs.size())*1e6/dReal(elapsed) : dReal(0);
+}
+
+int main(int argc, char ** argv)
+{
+    int numsamples = 100000, numcallbacks = 4;
+    vector<string> vrobotfiles;
+    for(int i = 1; i < argc; ++i) {
+        if( strcmp(argv[i], "--samples") == 0 && i+1 < argc ) {
+            numsamples = atoi(argv[++i]);
+        }
+        else if( strcmp(argv[i], "--callbacks") == 0 && i+1 < argc ) {
+            numcallbacks = atoi(argv[++i]);
+        }
+        else {
+            vrobotfiles.push_back(argv[i]);
+        }
+    }
+    if( vrobotfiles.size() == 0 ) {
+        vrobotfiles.push_back("robots/barrettwam.robot.xml");
+        vrobotfiles.push_back("robots/pr2-beta-static.zae");
+        vrobotfiles.push_back("robots/puma.robot.xml");
+    }
+
+    RaveInitialize(true); // start openrave core
+    EnvironmentBasePtr penv = RaveCreateEnvironment(); // create the main environment
+
+    for(size_t irobot = 0; irobot < vrobotfiles.size(); ++irobot) {
+        KinBodyPtr pbody = penv->ReadRobotURI(vrobotfiles[irobot]);
+        if( !pbody ) {
+            pbody = penv->ReadKinBodyURI(vrobotfiles[irobot]);
+        }
+        if( !pbody ) {
+            RAVELOG_WARN_FORMAT("failed to load %s", vrobotfiles[irobot]);
+            continue;
+        }
+        penv->Add(pbody, true);
+
+        EnvironmentMutex::scoped_lock lock(penv->GetMutex());
+        vector<dReal> vlower, vupper;
+        pbody->GetDOFLimits(vlower, vupper);
+        vector< vector<dReal> > vconfigs(numsamples, vector<dReal>(pbody->GetDOF()));
+        for(int i = 0; i < numsamples; ++i) {
+            for(int j = 0; j < pbody->GetDOF(); ++j) {
+                // limits of circular joints are very large, so sample them in [-pi,pi]
+                dReal flower = max(vlower[j], dReal(-PI)), fupper = min(vupper[j], dReal(PI));
+                vconfigs[i][j] = flower + RaveRandomFloat()*(fupper-flower);
+            }
+        }
+
+        dReal fgeneric = TimeForwardKinematics(pbody, vconfigs, false);
+        dReal fprogram = TimeForwardKinematics(pbody, vconfigs, true);
+        dReal fbatch = TimeForwardKinematicsBatch(pbody, vconfigs);
+        RAVELOG_INFO_FORMAT("%s (%d dofs, %d links): generic=%.0f/s, program=%.0f/s, batch=%.0f/s, speedup=%.2fx/%.2fx", pbody->GetName()%pbody->GetDOF()%pbody->GetLinks().size()%fgeneric%fprogram%fbatch%(fgeneric > 0 ? fprogram/fgeneric : dReal(0))%(fgeneric > 0 ? fbatch/fgeneric : dReal(0)));
+        if( numcallbacks > 0 ) {
+            dReal fcallbacks = TimeForwardKinematicsCallbacks(pbody, vconfigs, numcallbacks, false);
+            dReal fdeferred = TimeForwardKinematicsCallbacks(pbody, vconfigs, numcallbacks, true);
+            RAVELOG_INFO_FORMAT("%s with %d change callbacks: program=%.0f/s, deferred=%.0f/s", pbody->GetName()%numcallbacks%fcallbacks%fdeferred);
+        }
+        penv->Remove(pbody);
+    }
+
+    RaveDestroy(); // destroy
+    return 0;
+}
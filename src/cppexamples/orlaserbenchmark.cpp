@@ -0,0 +1,163 @@
+/** \example orlaserbenchmark.cpp
+    \author agent <agent@local>, 2026
+
+    Measures the throughput in beams per second of simulating a 2D laser scanner. A planar scan is cast from the center
+    of the scene either with one CollisionCheckerBase::CheckCollision call per beam, or with one
+    CollisionCheckerBase::CheckCollisionRays call per scan, and finally by stepping a BaseLaser2D sensor. The number of
+    beams where the first two methods disagree is printed.
+
+    Usage:
+    \verbatim
+    orlaserbenchmark [--beams num] [--scans num] [--threads num] [--collision checker] [scene]
+    \endverbatim
+
+    - \b --beams - number of beams of one scan spread over 270 degrees (default 1080).
+    - \b --scans - number of scans of every method (default 100).
+    - \b --threads - number of threads of the fcl checker, set with its SetNarrowPhaseThreads command (default 1).
+    - \b --collision - collision checker to use (default fcl_).
+
+    If no scene is specified, uses data/lab1.env.xml.
+
+    <b>Full Example Code:</b>
+ */
+#include <openrave-core.h>
+#include <openrave/utils.h>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+
+using namespace OpenRAVE;
+using namespace std;
+
+int main(int argc, char ** argv)
+{
+    int numbeams = 1080, numscans = 100, numthreads = 1;
+    string scenefilename = "data/lab1.env.xml", collisionchecker = "fcl_";
+    for(int i = 1; i < argc; ++i) {
+        if( strcmp(argv[i], "--beams") == 0 && i+1 < argc ) {
+            numbeams = max(2, atoi(argv[++i]));
+        }
+        else if( strcmp(argv[i], "--scans") == 0 && i+1 < argc ) {
+            numscans = atoi(argv[++i]);
+        }
+        else if( strcmp(argv[i], "--threads") == 0 && i+1 < argc ) {
+            numthreads = atoi(argv[++i]);
+        }
+        else if( strcmp(argv[i], "--collision") == 0 && i+1 < argc ) {
+            collisionchecker = argv[++i];
+        }
+        else {
+            scenefilename = argv[i];
+        }
+    }
+
+    RaveInitialize(true); // start openrave core
+    EnvironmentBasePtr penv = RaveCreateEnvironment(); // create the main environment
+    CollisionCheckerBasePtr pchecker = RaveCreateCollisionChecker(penv, collisionchecker);
+    if( !pchecker ) {
+        RAVELOG_WARN_FORMAT("failed to create collision checker %s", collisionchecker);
+        RaveDestroy();
+        return 1;
+    }
+    penv->SetCollisionChecker(pchecker);
+    penv->Load(scenefilename);
+    if( numthreads > 1 ) {
+        stringstream sout, sinput;
+        sinput << "SetNarrowPhaseThreads " << numthreads;
+        if( !pchecker->SendCommand(sout, sinput) ) {
+            RAVELOG_WARN_FORMAT("collision checker %s does not support SetNarrowPhaseThreads", collisionchecker);
+        }
+    }
+
+    {
+        EnvironmentMutex::scoped_lock lock(penv->GetMutex());
+
+        // scan in a horizontal plane at the center of the scene
+        vector<KinBodyPtr> vbodies;
+        penv->GetBodies(vbodies);
+        Vector vmin(1e30,1e30,1e30), vmax(-1e30,-1e30,-1e30);
+        for(size_t ibody = 0; ibody < vbodies.size(); ++ibody) {
+            AABB ab = vbodies[ibody]->ComputeAABB();
+            for(int i = 0; i < 3; ++i) {
+                vmin[i] = min(vmin[i], ab.pos[i]-ab.extents[i]);
+                vmax[i] = max(vmax[i], ab.pos[i]+ab.extents[i]);
+            }
+        }
+        Transform tlaser;
+        if( vbodies.size() > 0 ) {
+            tlaser.trans = 0.5*(vmin+vmax);
+        }
+        SensorBase::LaserGeomDataPtr pgeom(new SensorBase::LaserGeomData());
+        pgeom->min_angle[0] = -0.75*PI;
+        pgeom->max_angle[0] = 0.75*PI;
+        pgeom->resolution[0] = (pgeom->max_angle[0]-pgeom->min_angle[0])/(numbeams-1);
+        pgeom->min_range = 0.03;
+        pgeom->max_range = 30;
+
+        vector<RAY> vrays(numbeams);
+        for(int ibeam = 0; ibeam < numbeams; ++ibeam) {
+            dReal fangle = pgeom->min_angle[0] + ibeam*pgeom->resolution[0];
+            Vector vdir = tlaser.rotate(Vector(RaveCos(fangle), RaveSin(fangle), 0));
+            vrays[ibeam].pos = tlaser.trans + pgeom->min_range*vdir;
+            vrays[ibeam].dir = (pgeom->max_range-pgeom->min_range)*vdir;
+        }
+
+        vector<dReal> vbeamdistances(numbeams);
+        vector<int> vbeambodyids(numbeams);
+        CollisionReportPtr report(new CollisionReport());
+        pchecker->SetCollisionOptions(CO_Distance);
+        uint64_t starttime = utils::GetMicroTime();
+        for(int iscan = 0; iscan < numscans; ++iscan) {
+            for(int ibeam = 0; ibeam < numbeams; ++ibeam) {
+                if( pchecker->CheckCollision(vrays[ibeam], report) && !!report->plink1 ) {
+                    vbeamdistances[ibeam] = report->minDistance;
+                    vbeambodyids[ibeam] = report->plink1->GetParent()->GetEnvironmentId();
+                }
+                else {
+                    vbeamdistances[ibeam] = -1;
+                    vbeambodyids[ibeam] = 0;
+                }
+            }
+        }
+        uint64_t beamtime = utils::GetMicroTime()-starttime;
+        pchecker->SetCollisionOptions(0);
+
+        vector<dReal> vdistances;
+        vector<Vector> vnormals;
+        vector<int> vbodyids;
+        starttime = utils::GetMicroTime();
+        for(int iscan = 0; iscan < numscans; ++iscan) {
+            pchecker->CheckCollisionRays(vrays, vdistances, vnormals, vbodyids);
+        }
+        uint64_t batchtime = utils::GetMicroTime()-starttime;
+
+        int numhits = 0, numdifferent = 0;
+        for(int ibeam = 0; ibeam < numbeams; ++ibeam) {
+            numhits += vbodyids[ibeam] != 0;
+            if( vbodyids[ibeam] != vbeambodyids[ibeam] || RaveFabs(vdistances[ibeam]-vbeamdistances[ibeam]) > 1e-4 ) {
+                ++numdifferent;
+            }
+        }
+
+        SensorBasePtr psensor = RaveCreateSensor(penv, "BaseLaser2D");
+        uint64_t sensortime = 0;
+        if( !!psensor ) {
+            psensor->SetSensorGeometry(pgeom);
+            psensor->SetTransform(tlaser);
+            psensor->Configure(SensorBase::CC_RenderGeometryOff);
+            psensor->Configure(SensorBase::CC_PowerOn);
+            starttime = utils::GetMicroTime();
+            for(int iscan = 0; iscan < numscans; ++iscan) {
+                psensor->SimulationStep(0); // time_scan is 0, so every step scans
+            }
+            sensortime = utils::GetMicroTime()-starttime;
+        }
+
+        dReal numtotalbeams = dReal(numbeams)*numscans;
+        RAVELOG_INFO_FORMAT("%s threads=%d beams=%d (%d hits) scans=%d: CheckCollision=%.0f beams/s, CheckCollisionRays=%.0f beams/s, BaseLaser2D=%.0f beams/s, different beams=%d", collisionchecker%numthreads%numbeams%numhits%numscans%(beamtime > 0 ? 1e6*numtotalbeams/beamtime : 0.0)%(batchtime > 0 ? 1e6*numtotalbeams/batchtime : 0.0)%(sensortime > 0 ? 1e6*numtotalbeams/sensortime : 0.0)%numdifferent);
+    }
+
+    RaveDestroy(); // destroy
+    return 0;
+}
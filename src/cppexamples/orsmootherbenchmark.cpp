@@ -0,0 +1,150 @@
+/** \example orsmootherbenchmark.cpp
+    \author agent <agent@local>, 2026
+
+    Compares the wall-clock time and the resulting trajectory durations of the parabolicsmoother2 shortcutting when it
+    checks one shortcut at a time and when it checks several shortcuts in parallel with the nshortcutthreads
+    parameter. A path for the active joints of the robot is planned once with birrt between two random collision-free
+    configurations, then it is smoothed with every number of threads and every seed. For every number of threads the
+    average smoothing time and the average, best and worst trajectory durations are printed, so the time needed to
+    reach a given quality can be read off and compared with the serial smoother.
+
+    Usage:
+    \verbatim
+    orsmootherbenchmark [--threads num] [--seeds num] [--iterations num] [--robot name] [scene]
+    \endverbatim
+
+    - \b --threads - maximum number of threads, the number of threads is doubled from 1 up to it (default 8).
+    - \b --seeds - number of random generator seeds to smooth with (default 5).
+    - \b --iterations - maximum shortcut iterations of the smoother (default 200).
+    - \b --robot - robot to plan for (default the first robot in the scene).
+
+    If no scene is specified, uses data/lab1.env.xml.
+
+    <b>Full Example Code:</b>
+ */
+#include <openrave-core.h>
+#include <openrave/utils.h>
+#include <openrave/planningutils.h>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+
+using namespace OpenRAVE;
+using namespace std;
+
+/// \brief samples random configurations of the active joints until one is collision-free
+bool SampleFreeConfiguration(RobotBasePtr probot, vector<dReal>& vvalues)
+{
+    vector<dReal> vlower, vupper;
+    probot->GetActiveDOFLimits(vlower, vupper);
+    vvalues.resize(vlower.size());
+    for(int itry = 0; itry < 1000; ++itry) {
+        for(size_t j = 0; j < vvalues.size(); ++j) {
+            // continuous joints have very large limits
+            dReal flower = max(vlower[j], dReal(-PI)), fupper = min(vupper[j], dReal(PI));
+            vvalues[j] = flower + RaveRandomFloat()*(fupper-flower);
+        }
+        probot->SetActiveDOFValues(vvalues);
+        if( !probot->GetEnv()->CheckCollision(probot) && !probot->CheckSelfCollision() ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char ** argv)
+{
+    int maxthreads = 8, numseeds = 5, numiterations = 200;
+    string scenefilename = "data/lab1.env.xml", robotname;
+    for(int i = 1; i < argc; ++i) {
+        if( strcmp(argv[i], "--threads") == 0 && i+1 < argc ) {
+            maxthreads = max(1, atoi(argv[++i]));
+        }
+        else if( strcmp(argv[i], "--seeds") == 0 && i+1 < argc ) {
+            numseeds = max(1, atoi(argv[++i]));
+        }
+        else if( strcmp(argv[i], "--iterations") == 0 && i+1 < argc ) {
+            numiterations = atoi(argv[++i]);
+        }
+        else if( strcmp(argv[i], "--robot") == 0 && i+1 < argc ) {
+            robotname = argv[++i];
+        }
+        else {
+            scenefilename = argv[i];
+        }
+    }
+
+    RaveInitialize(true); // start openrave core
+    EnvironmentBasePtr penv = RaveCreateEnvironment(); // create the main environment
+    penv->Load(scenefilename);
+
+    EnvironmentMutex::scoped_lock lock(penv->GetMutex());
+    RobotBasePtr probot;
+    if( robotname.size() > 0 ) {
+        probot = penv->GetRobot(robotname);
+    }
+    else {
+        vector<RobotBasePtr> vrobots;
+        penv->GetRobots(vrobots);
+        if( vrobots.size() > 0 ) {
+            probot = vrobots.at(0);
+        }
+    }
+    if( !probot ) {
+        RAVELOG_WARN_FORMAT("no robot to plan for in %s", scenefilename);
+        RaveDestroy();
+        return 1;
+    }
+    RobotBase::ManipulatorPtr pmanip = probot->GetActiveManipulator();
+    if( !!pmanip ) {
+        probot->SetActiveDOFs(pmanip->GetArmIndices());
+    }
+
+    // plan the path that all the smoothers start from
+    PlannerBase::PlannerParametersPtr params(new PlannerBase::PlannerParameters());
+    params->SetRobotActiveJoints(probot);
+    if( !SampleFreeConfiguration(probot, params->vgoalconfig) || !SampleFreeConfiguration(probot, params->vinitialconfig) ) {
+        RAVELOG_WARN_FORMAT("failed to sample collision-free configurations for %s", probot->GetName());
+        RaveDestroy();
+        return 1;
+    }
+    params->_sPostProcessingPlanner = ""; // keep the jerky path
+    PlannerBasePtr pplanner = RaveCreatePlanner(penv, "birrt");
+    TrajectoryBasePtr ptraj = RaveCreateTrajectory(penv, "");
+    if( !pplanner->InitPlan(probot, params) || pplanner->PlanPath(ptraj).GetStatusCode() != PS_HasSolution ) {
+        RAVELOG_WARN_FORMAT("failed to plan a path for %s", probot->GetName());
+        RaveDestroy();
+        return 1;
+    }
+
+    TrajectoryBasePtr psmoothtraj = RaveCreateTrajectory(penv, "");
+    for(int numthreads = 1; numthreads <= maxthreads; numthreads *= 2) {
+        uint64_t totaltime = 0;
+        dReal ftotalduration = 0, fminduration = 1e30, fmaxduration = 0;
+        int numsuccessful = 0;
+        for(int iseed = 0; iseed < numseeds; ++iseed) {
+            psmoothtraj->Clone(ptraj, Clone_All);
+            stringstream ssparameters;
+            ssparameters << "<_nmaxiterations>" << numiterations << "</_nmaxiterations><_nrandomgeneratorseed>" << iseed << "</_nrandomgeneratorseed><nshortcutthreads>" << (numthreads > 1 ? numthreads : 0) << "</nshortcutthreads>";
+            uint64_t starttime = utils::GetMicroTime();
+            PlannerStatus status = planningutils::SmoothActiveDOFTrajectory(psmoothtraj, probot, 1, 1, "parabolicsmoother2", ssparameters.str());
+            totaltime += utils::GetMicroTime()-starttime;
+            if( status.GetStatusCode() == PS_HasSolution ) {
+                dReal fduration = psmoothtraj->GetDuration();
+                ftotalduration += fduration;
+                fminduration = min(fminduration, fduration);
+                fmaxduration = max(fmaxduration, fduration);
+                ++numsuccessful;
+            }
+        }
+        if( numsuccessful == 0 ) {
+            RAVELOG_WARN_FORMAT("threads=%d: smoothing failed for all seeds", numthreads);
+            continue;
+        }
+        RAVELOG_INFO_FORMAT("%s threads=%d iterations=%d: %.3fs per smoothing, duration avg=%.4fs min=%.4fs max=%.4fs (%d/%d seeds)", probot->GetName()%numthreads%numiterations%(1e-6*totaltime/numseeds)%(ftotalduration/numsuccessful)%fminduration%fmaxduration%numsuccessful%numseeds);
+    }
+
+    RaveDestroy(); // destroy
+    return 0;
+}
@@ -0,0 +1,74 @@
+/** \example orspatialtreebenchmark.cpp
+    \author agent <agent@local>, 2026
+
+    Measures the nearest neighbor query throughput of the cover trees used by the RRT planners. For every tree size, a
+    tree of random configurations is built with a weighted euclidean metric, and the same queries are timed when the
+    distances go through the distance metric function and when they are computed directly by the tree. The work is
+    done by the BenchmarkNearestNeighbor command of the planner.
+
+    Usage:
+    \verbatim
+    orspatialtreebenchmark [--dof num] [--queries num] [numnodes ...]
+    \endverbatim
+
+    - \b --dof - dimension of the configurations (default 7).
+    - \b --queries - number of nearest neighbor queries per tree (default 10000).
+
+    If no tree sizes are specified, uses 1000, 10000 and 100000 nodes.
+
+    <b>Full Example Code:</b>
+ */
+#include <openrave-core.h>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+
+using namespace OpenRAVE;
+using namespace std;
+
+int main(int argc, char ** argv)
+{
+    int dof = 7, numqueries = 10000;
+    vector<int> vnumnodes;
+    for(int i = 1; i < argc; ++i) {
+        if( strcmp(argv[i], "--dof") == 0 && i+1 < argc ) {
+            dof = atoi(argv[++i]);
+        }
+        else if( strcmp(argv[i], "--queries") == 0 && i+1 < argc ) {
+            numqueries = atoi(argv[++i]);
+        }
+        else {
+            vnumnodes.push_back(atoi(argv[i]));
+        }
+    }
+
+    RaveInitialize(true); // start openrave core
+    EnvironmentBasePtr penv = RaveCreateEnvironment(); // create the main environment
+    PlannerBasePtr planner = RaveCreatePlanner(penv, "birrt");
+    if( !planner ) {
+        RAVELOG_WARN("failed to create birrt planner\n");
+        RaveDestroy();
+        return 1;
+    }
+
+    stringstream sout, sinput;
+    sinput << "BenchmarkNearestNeighbor " << dof << " " << numqueries;
+    for(size_t i = 0; i < vnumnodes.size(); ++i) {
+        sinput << " " << vnumnodes[i];
+    }
+    if( !planner->SendCommand(sout, sinput) ) {
+        RAVELOG_WARN("BenchmarkNearestNeighbor failed\n");
+        RaveDestroy();
+        return 1;
+    }
+
+    int numnodes = 0, nummismatches = 0;
+    dReal fgeneric = 0, ffast = 0;
+    while( sout >> numnodes >> fgeneric >> ffast >> nummismatches ) {
+        RAVELOG_INFO_FORMAT("dof=%d, nodes=%d: generic=%.0f queries/s, fast=%.0f queries/s, speedup=%.2fx, mismatches=%d", dof%numnodes%fgeneric%ffast%(fgeneric > 0 ? ffast/fgeneric : dReal(0))%nummismatches);
+    }
+
+    RaveDestroy(); // destroy
+    return 0;
+}
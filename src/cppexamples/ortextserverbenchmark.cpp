@@ -0,0 +1,340 @@
+/** \example ortextserverbenchmark.cpp
+    \author agent <agent@local>, 2026
+
+    Measures the round trip latency of polling and setting the joint values of a robot through the textserver module,
+    once with the text commands body_getjoints and body_setjoints, and once with the binary frames that a connection
+    switches to with the binary command. The server runs in the same process and the clients connect to it over the
+    loopback interface. For every measurement the mean, median and 99th percentile of the round trip times are printed,
+    followed by the largest difference between the joint values returned by the two protocols, which comes from
+    formatting the values as text, and the latency statistics of the server returned by the stats command.
+
+    Usage:
+    \verbatim
+    ortextserverbenchmark [--port port] [--requests num] [--robot name] [scene]
+    \endverbatim
+
+    - \b --port - port of the textserver (default 4766).
+    - \b --requests - number of round trips of every measurement (default 10000).
+    - \b --robot - robot whose joint values are polled (default the first robot in the scene).
+
+    If no scene is specified, uses data/lab1.env.xml.
+
+    <b>Full Example Code:</b>
+ */
+#include <openrave-core.h>
+#include <openrave/utils.h>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+
+using namespace OpenRAVE;
+using namespace std;
+
+// opcodes of SimpleTextServer::BinaryCommand
+static const uint16_t BC_GetDOFValues = 1;
+static const uint16_t BC_SetDOFValues = 2;
+
+/// \brief blocking client of the textserver
+class TextServerClient
+{
+public:
+    TextServerClient() : _sockfd(-1) {
+    }
+    ~TextServerClient() {
+        if( _sockfd >= 0 ) {
+            close(_sockfd);
+        }
+    }
+
+    bool Connect(int port)
+    {
+        _sockfd = socket(AF_INET, SOCK_STREAM, 0);
+        if( _sockfd < 0 ) {
+            return false;
+        }
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        int yes = 1;
+        setsockopt(_sockfd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        // the server starts listening in its own thread
+        for(int itry = 0; itry < 100; ++itry) {
+            if( connect(_sockfd, (struct sockaddr*)&address, sizeof(address)) == 0 ) {
+                return true;
+            }
+            usleep(10000);
+        }
+        return false;
+    }
+
+    bool Send(const void* pdata, size_t size)
+    {
+        const char* pbuf = (const char*)pdata;
+        while( size > 0 ) {
+            ssize_t nsent = send(_sockfd, pbuf, size, 0);
+            if( nsent <= 0 ) {
+                return false;
+            }
+            pbuf += nsent;
+            size -= nsent;
+        }
+        return true;
+    }
+
+    bool Receive(void* pdata, size_t size)
+    {
+        char* pbuf = (char*)pdata;
+        while( size > 0 ) {
+            ssize_t nreceived = recv(_sockfd, pbuf, size, 0);
+            if( nreceived <= 0 ) {
+                return false;
+            }
+            pbuf += nreceived;
+            size -= nreceived;
+        }
+        return true;
+    }
+
+    /// \brief receives a text reply: its size (int32) followed by the text
+    bool ReceiveText(string& reply)
+    {
+        int32_t size = 0;
+        if( !Receive(&size, sizeof(size)) || size < 0 ) {
+            return false;
+        }
+        reply.resize(size);
+        return size == 0 || Receive(&reply[0], size);
+    }
+
+    bool SendBinary(uint16_t opcode, const vector<int32_t>& vints, const vector<dReal>& vvalues)
+    {
+        uint32_t size = 8+vints.size()*sizeof(int32_t)+vvalues.size()*sizeof(dReal);
+        uint16_t reserved = 0;
+        uint32_t numints = vints.size();
+        vector<char> vframe(4+size);
+        memcpy(&vframe[0], &size, 4);
+        memcpy(&vframe[4], &opcode, 2);
+        memcpy(&vframe[6], &reserved, 2);
+        memcpy(&vframe[8], &numints, 4);
+        if( vints.size() > 0 ) {
+            memcpy(&vframe[12], &vints[0], vints.size()*sizeof(int32_t));
+        }
+        if( vvalues.size() > 0 ) {
+            memcpy(&vframe[12+vints.size()*sizeof(int32_t)], &vvalues[0], vvalues.size()*sizeof(dReal));
+        }
+        return Send(&vframe[0], vframe.size());
+    }
+
+    /// \brief receives a binary reply, returns false if it failed or the server returned an error
+    bool ReceiveBinary(vector<int32_t>& vints, vector<dReal>& vvalues)
+    {
+        char header[12];
+        if( !Receive(header, sizeof(header)) ) {
+            return false;
+        }
+        uint32_t size = 0, numints = 0;
+        uint16_t status = 0;
+        memcpy(&size, header, 4);
+        memcpy(&status, header+6, 2);
+        memcpy(&numints, header+8, 4);
+        if( size < 8+numints*sizeof(int32_t) ) {
+            return false;
+        }
+        vints.resize(numints);
+        vvalues.resize((size-8-numints*sizeof(int32_t))/sizeof(dReal));
+        if( vints.size() > 0 && !Receive(&vints[0], vints.size()*sizeof(int32_t)) ) {
+            return false;
+        }
+        if( vvalues.size() > 0 && !Receive(&vvalues[0], vvalues.size()*sizeof(dReal)) ) {
+            return false;
+        }
+        return status == 0;
+    }
+
+private:
+    int _sockfd;
+};
+
+void PrintLatencies(const string& name, vector<uint64_t>& vtimes)
+{
+    if( vtimes.size() == 0 ) {
+        return;
+    }
+    sort(vtimes.begin(), vtimes.end());
+    uint64_t totaltime = 0;
+    for(size_t i = 0; i < vtimes.size(); ++i) {
+        totaltime += vtimes[i];
+    }
+    RAVELOG_INFO_FORMAT("%s: mean=%.1fus, p50=%dus, p99=%dus", name%(dReal(totaltime)/vtimes.size())%vtimes[vtimes.size()/2]%vtimes[(vtimes.size()*99)/100]);
+}
+
+int main(int argc, char ** argv)
+{
+    int port = 4766, numrequests = 10000;
+    string scenefilename = "data/lab1.env.xml", robotname;
+    for(int i = 1; i < argc; ++i) {
+        if( strcmp(argv[i], "--port") == 0 && i+1 < argc ) {
+            port = atoi(argv[++i]);
+        }
+        else if( strcmp(argv[i], "--requests") == 0 && i+1 < argc ) {
+            numrequests = max(1, atoi(argv[++i]));
+        }
+        else if( strcmp(argv[i], "--robot") == 0 && i+1 < argc ) {
+            robotname = argv[++i];
+        }
+        else {
+            scenefilename = argv[i];
+        }
+    }
+
+    RaveInitialize(true); // start openrave core
+    EnvironmentBasePtr penv = RaveCreateEnvironment(); // create the main environment
+    penv->Load(scenefilename);
+
+    int robotid = 0;
+    vector<dReal> vinitialvalues;
+    {
+        EnvironmentMutex::scoped_lock lock(penv->GetMutex());
+        RobotBasePtr probot;
+        if( robotname.size() > 0 ) {
+            probot = penv->GetRobot(robotname);
+        }
+        else {
+            vector<RobotBasePtr> vrobots;
+            penv->GetRobots(vrobots);
+            if( vrobots.size() > 0 ) {
+                probot = vrobots.at(0);
+            }
+        }
+        if( !probot ) {
+            RAVELOG_WARN_FORMAT("no robot in %s", scenefilename);
+            RaveDestroy();
+            return 1;
+        }
+        robotname = probot->GetName();
+        robotid = probot->GetEnvironmentId();
+        probot->GetDOFValues(vinitialvalues);
+    }
+
+    ModuleBasePtr pserver = RaveCreateModule(penv, "textserver");
+    stringstream ssargs;
+    ssargs << port;
+    if( !pserver || penv->AddModule(pserver, ssargs.str()) != 0 ) {
+        RAVELOG_WARN_FORMAT("failed to start the textserver on port %d", port);
+        RaveDestroy();
+        return 1;
+    }
+
+    {
+        TextServerClient textclient, binaryclient;
+        string reply;
+        if( !textclient.Connect(port) || !binaryclient.Connect(port) ) {
+            RAVELOG_WARN_FORMAT("failed to connect to the textserver on port %d", port);
+            RaveDestroy();
+            return 1;
+        }
+        string binarycmd = "binary\n";
+        int bbinary = 0, realsize = 0;
+        if( binaryclient.Send(binarycmd.c_str(), binarycmd.size()) && binaryclient.ReceiveText(reply) ) {
+            stringstream ss(reply);
+            ss >> bbinary >> realsize;
+        }
+        if( !bbinary || realsize != (int)sizeof(dReal) ) {
+            RAVELOG_WARN("textserver does not support binary frames with the dReal of this program\n");
+            RaveDestroy();
+            return 1;
+        }
+
+        stringstream ssget, ssset;
+        ssget << "body_getjoints " << robotid << "\n";
+        ssset << "body_setjoints " << robotid << " " << vinitialvalues.size() << " ";
+        ssset.precision(std::numeric_limits<dReal>::digits10+1);
+        for(size_t i = 0; i < vinitialvalues.size(); ++i) {
+            ssset << vinitialvalues[i] << " ";
+        }
+        ssset << "\n";
+        string getcmd = ssget.str(), setgetcmd = ssset.str() + ssget.str();
+
+        vector<uint64_t> vtextgettimes(numrequests), vbinarygettimes(numrequests), vtextsettimes(numrequests), vbinarysettimes(numrequests);
+        vector<int32_t> vints(1, robotid), vreplyints;
+        vector<dReal> vnovalues, vbinaryvalues;
+        for(int i = 0; i < numrequests; ++i) {
+            uint64_t starttime = utils::GetMicroTime();
+            if( !textclient.Send(getcmd.c_str(), getcmd.size()) || !textclient.ReceiveText(reply) ) {
+                RAVELOG_WARN("text request failed\n");
+                break;
+            }
+            vtextgettimes[i] = utils::GetMicroTime()-starttime;
+        }
+        vector<dReal> vtextvalues;
+        {
+            stringstream ss(reply);
+            dReal f;
+            while( ss >> f ) {
+                vtextvalues.push_back(f);
+            }
+        }
+
+        for(int i = 0; i < numrequests; ++i) {
+            uint64_t starttime = utils::GetMicroTime();
+            if( !binaryclient.SendBinary(BC_GetDOFValues, vints, vnovalues) || !binaryclient.ReceiveBinary(vreplyints, vbinaryvalues) ) {
+                RAVELOG_WARN("binary request failed\n");
+                break;
+            }
+            vbinarygettimes[i] = utils::GetMicroTime()-starttime;
+        }
+
+        // setting: the set and get requests are pipelined, only the get returns a reply in the text protocol
+        for(int i = 0; i < numrequests; ++i) {
+            uint64_t starttime = utils::GetMicroTime();
+            if( !textclient.Send(setgetcmd.c_str(), setgetcmd.size()) || !textclient.ReceiveText(reply) ) {
+                RAVELOG_WARN("text request failed\n");
+                break;
+            }
+            vtextsettimes[i] = utils::GetMicroTime()-starttime;
+        }
+        vector<dReal> vsetreplyvalues;
+        for(int i = 0; i < numrequests; ++i) {
+            uint64_t starttime = utils::GetMicroTime();
+            if( !binaryclient.SendBinary(BC_SetDOFValues, vints, vinitialvalues) || !binaryclient.SendBinary(BC_GetDOFValues, vints, vnovalues) || !binaryclient.ReceiveBinary(vreplyints, vsetreplyvalues) || !binaryclient.ReceiveBinary(vreplyints, vsetreplyvalues) ) {
+                RAVELOG_WARN("binary request failed\n");
+                break;
+            }
+            vbinarysettimes[i] = utils::GetMicroTime()-starttime;
+        }
+
+        RAVELOG_INFO_FORMAT("%s dof=%d requests=%d", robotname%vinitialvalues.size()%numrequests);
+        PrintLatencies("text get", vtextgettimes);
+        PrintLatencies("binary get", vbinarygettimes);
+        PrintLatencies("text set+get", vtextsettimes);
+        PrintLatencies("binary set+get", vbinarysettimes);
+        dReal fmaxerror = 0;
+        if( vtextvalues.size() != vbinaryvalues.size() ) {
+            RAVELOG_WARN_FORMAT("text returned %d values, binary returned %d", vtextvalues.size()%vbinaryvalues.size());
+        }
+        else {
+            for(size_t i = 0; i < vtextvalues.size(); ++i) {
+                fmaxerror = max(fmaxerror, RaveFabs(vtextvalues[i]-vbinaryvalues[i]));
+            }
+        }
+        RAVELOG_INFO_FORMAT("max difference between text and binary values=%e", fmaxerror);
+
+        string statscmd = "stats\n";
+        if( textclient.Send(statscmd.c_str(), statscmd.size()) && textclient.ReceiveText(reply) ) {
+            RAVELOG_INFO_FORMAT("server statistics (name count mean max p50 p99 histogram, us):\n%s", reply);
+        }
+    }
+
+    RaveDestroy(); // destroy
+    return 0;
+}
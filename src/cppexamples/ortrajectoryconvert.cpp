@@ -0,0 +1,85 @@
+/** \example ortrajectoryconvert.cpp
+    \author agent <agent@local>, 2026
+
+    Converts trajectory files between the XML, binary and columnar binary formats. Any format can be read since
+    TrajectoryBase::deserialize detects it. The columnar files can later be memory mapped with the LoadMappedTrajectory
+    command of the trajectory, which reads the waypoints of float64 files directly from the mapping.
+
+    Usage:
+    \verbatim
+    ortrajectoryconvert [--format columnar|binary|xml] [--encoding num] input output
+    \endverbatim
+
+    - \b --format - format of the output (default columnar).
+    - \b --encoding - encoding of the columnar output: 0 for float64 (default), 1 for float32, 2 for float32 differences between consecutive waypoints.
+
+    <b>Full Example Code:</b>
+ */
+#include <openrave-core.h>
+#include <openrave/utils.h>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace OpenRAVE;
+using namespace std;
+
+int main(int argc, char ** argv)
+{
+    string format = "columnar";
+    int encoding = 0;
+    vector<string> vfilenames;
+    for(int i = 1; i < argc; ++i) {
+        if( strcmp(argv[i], "--format") == 0 && i+1 < argc ) {
+            format = argv[++i];
+        }
+        else if( strcmp(argv[i], "--encoding") == 0 && i+1 < argc ) {
+            encoding = atoi(argv[++i]);
+        }
+        else {
+            vfilenames.push_back(argv[i]);
+        }
+    }
+    if( vfilenames.size() != 2 ) {
+        RAVELOG_WARN("need an input and output trajectory file\n");
+        return 1;
+    }
+
+    RaveInitialize(true); // start openrave core
+    EnvironmentBasePtr penv = RaveCreateEnvironment(); // create the main environment
+    TrajectoryBasePtr ptraj = RaveCreateTrajectory(penv, "");
+    int ret = 0;
+    try {
+        uint64_t starttime = utils::GetMicroTime();
+        ifstream fin(vfilenames[0].c_str(), ios::binary);
+        ptraj->deserialize(fin);
+        uint64_t readtime = utils::GetMicroTime()-starttime;
+
+        starttime = utils::GetMicroTime();
+        if( format == "columnar" ) {
+            stringstream sout, sinput;
+            sinput << "SaveColumnarTrajectory " << vfilenames[1] << " " << encoding;
+            if( !ptraj->SendCommand(sout, sinput) ) {
+                RAVELOG_WARN_FORMAT("failed to write %s", vfilenames[1]);
+                ret = 1;
+            }
+        }
+        else {
+            ofstream fout(vfilenames[1].c_str(), ios::binary);
+            fout << std::setprecision(std::numeric_limits<dReal>::digits10+1);
+            // 0x8000 selects the XML format
+            ptraj->serialize(fout, format == "xml" ? 0x8000 : 0);
+        }
+        uint64_t writetime = utils::GetMicroTime()-starttime;
+        RAVELOG_INFO_FORMAT("converted %d waypoints (dof=%d) from %s to %s, read=%.3fms, write=%.3fms", ptraj->GetNumWaypoints()%ptraj->GetConfigurationSpecification().GetDOF()%vfilenames[0]%vfilenames[1]%(1e-3*readtime)%(1e-3*writetime));
+    }
+    catch(const std::exception& ex) {
+        RAVELOG_WARN_FORMAT("failed to convert %s: %s", vfilenames[0]%ex.what());
+        ret = 1;
+    }
+
+    RaveDestroy(); // destroy
+    return ret;
+}
@@ -0,0 +1,114 @@
+/** \example ortrajectorysamplingbenchmark.cpp
+    \author agent <agent@local>, 2026
+
+    Compares sampling a trajectory on a regular time grid by calling TrajectoryBase::Sample for every time against
+    sampling the whole grid with one TrajectoryBase::SampleRange call. The trajectory has random waypoints with the
+    given interpolation for the joint values, the derivatives its interpolation needs are added to the waypoints.
+    The timings and the largest difference between the two results are printed.
+
+    Usage:
+    \verbatim
+    ortrajectorysamplingbenchmark [--interpolation linear|quadratic|cubic|quintic] [--dof num] [--waypoints num] [--deltatime time]
+    \endverbatim
+
+    - \b --interpolation - interpolation of the joint values (default quintic).
+    - \b --dof - number of joint values (default 7).
+    - \b --waypoints - number of waypoints (default 1000).
+    - \b --deltatime - time between two samples (default 0.001).
+
+    <b>Full Example Code:</b>
+ */
+#include <openrave-core.h>
+#include <openrave/utils.h>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+
+using namespace OpenRAVE;
+using namespace std;
+
+int main(int argc, char ** argv)
+{
+    string interpolation = "quintic";
+    int dof = 7, numwaypoints = 1000;
+    dReal deltatime = 0.001;
+    for(int i = 1; i < argc; ++i) {
+        if( strcmp(argv[i], "--interpolation") == 0 && i+1 < argc ) {
+            interpolation = argv[++i];
+        }
+        else if( strcmp(argv[i], "--dof") == 0 && i+1 < argc ) {
+            dof = atoi(argv[++i]);
+        }
+        else if( strcmp(argv[i], "--waypoints") == 0 && i+1 < argc ) {
+            numwaypoints = atoi(argv[++i]);
+        }
+        else if( strcmp(argv[i], "--deltatime") == 0 && i+1 < argc ) {
+            deltatime = atof(argv[++i]);
+        }
+    }
+
+    RaveInitialize(true); // start openrave core
+    EnvironmentBasePtr penv = RaveCreateEnvironment(); // create the main environment
+
+    ConfigurationSpecification spec;
+    {
+        stringstream ss;
+        ss << "joint_values robot";
+        for(int j = 0; j < dof; ++j) {
+            ss << " " << j;
+        }
+        spec._vgroups.push_back(ConfigurationSpecification::Group());
+        spec._vgroups.back().name = ss.str();
+        spec._vgroups.back().offset = 0;
+        spec._vgroups.back().dof = dof;
+        spec._vgroups.back().interpolation = interpolation;
+    }
+    int maxderiv = interpolation == "quintic" ? 2 : (interpolation == "linear" ? 0 : 1);
+    for(int deriv = 1; deriv <= maxderiv; ++deriv) {
+        spec.AddDerivativeGroups(deriv, false);
+    }
+    int timeoffset = spec.AddDeltaTimeGroup();
+
+    vector<dReal> vwaypoints(spec.GetDOF()*numwaypoints);
+    for(size_t i = 0; i < vwaypoints.size(); ++i) {
+        vwaypoints[i] = 2*RaveRandomFloat()-1;
+    }
+    for(int ipoint = 0; ipoint < numwaypoints; ++ipoint) {
+        vwaypoints[ipoint*spec.GetDOF()+timeoffset] = ipoint == 0 ? 0 : 0.05+0.1*RaveRandomFloat();
+    }
+    TrajectoryBasePtr ptraj = RaveCreateTrajectory(penv, "");
+    ptraj->Init(spec);
+    ptraj->Insert(0, vwaypoints);
+    dReal duration = ptraj->GetDuration();
+
+    // sample once so that both methods start with the internal structures computed
+    vector<dReal> vsample, vsamples, vrangesamples;
+    ptraj->Sample(vsample, 0);
+
+    uint64_t starttime = utils::GetMicroTime();
+    size_t numsamples = 0;
+    for(; numsamples*deltatime <= duration; ++numsamples) {
+        ptraj->Sample(vsample, numsamples*deltatime);
+        vsamples.insert(vsamples.end(), vsample.begin(), vsample.end());
+    }
+    uint64_t sampletime = utils::GetMicroTime()-starttime;
+
+    starttime = utils::GetMicroTime();
+    ptraj->SampleRange(vrangesamples, 0, (numsamples-1)*deltatime, deltatime);
+    uint64_t rangetime = utils::GetMicroTime()-starttime;
+
+    dReal fmaxerror = 0;
+    if( vrangesamples.size() != vsamples.size() ) {
+        RAVELOG_WARN_FORMAT("SampleRange returned %d values, expected %d", vrangesamples.size()%vsamples.size());
+    }
+    else {
+        for(size_t i = 0; i < vsamples.size(); ++i) {
+            fmaxerror = max(fmaxerror, RaveFabs(vsamples[i]-vrangesamples[i]));
+        }
+    }
+    RAVELOG_INFO_FORMAT("%s dof=%d waypoints=%d samples=%d: Sample=%.3fus/sample, SampleRange=%.3fus/sample, speedup=%.2fx, max difference=%e", interpolation%dof%numwaypoints%numsamples%(dReal(sampletime)/numsamples)%(dReal(rangetime)/numsamples)%(rangetime > 0 ? dReal(sampletime)/dReal(rangetime) : dReal(0))%fmaxerror);
+
+    RaveDestroy(); // destroy
+    return 0;
+}
@@ -2396,11 +2396,11 @@ public:
             }
 
             KinBody::Link::GeometryPtr pgeom(new KinBody::Link::Geometry(plink,*itgeominfo));
-            pgeom->_info.InitCollisionMesh();
+            pgeom->_GetInfoToModify().InitCollisionMesh();
             plink->_vGeometries.push_back(pgeom);
             //  Append the collision mesh
             TriMesh trimesh = pgeom->GetCollisionMesh();
-            trimesh.ApplyTransform(pgeom->_info._t);
+            trimesh.ApplyTransform(pgeom->GetTransform());
             plink->_collision.Append(trimesh);
         }
 
@@ -4780,10 +4780,10 @@ private:
                             if( resolveCommon_bool_or_param(pelt, referenceElt, bVisible) ) {
                                 FOREACH(itgeometry, plink->_vGeometries) {
                                     if( bAndWithPrevious ) {
-                                        (*itgeometry)->_info._bVisible &= bVisible;
+                                        (*itgeometry)->_GetInfoToModify()._bVisible &= bVisible;
                                     }
                                     else {
-                                        (*itgeometry)->_info._bVisible = bVisible;
+                                        (*itgeometry)->_GetInfoToModify()._bVisible = bVisible;
                                     }
                                 }
                             }
@@ -19,6 +19,7 @@
 
 #include "ravep.h"
 #include "colladaparser/colladacommon.h"
+#include "kinematicmodelcache.h"
 
 #ifdef HAVE_BOOST_FILESYSTEM
 #include <boost/filesystem/operations.hpp>
@@ -37,6 +38,99 @@
 
 class Environment : public EnvironmentBase
 {
+    typedef boost::shared_mutex InterfacesMutex;
+    typedef boost::unique_lock<InterfacesMutex> InterfacesLock; ///< used when modifying the interface lists
+    typedef boost::shared_lock<InterfacesMutex> InterfacesSharedLock; ///< used when only reading the interface lists, many threads can hold it at the same time
+
+    /// \brief locks the environment mutex and records the time spent waiting for it in the lock statistics
+    class EnvironmentLock : public EnvironmentMutex::scoped_lock
+    {
+public:
+        EnvironmentLock(const Environment& env, bool block=true) : EnvironmentMutex::scoped_lock(env.GetMutex(), boost::defer_lock), _env(env) {
+            if( block ) {
+                Lock();
+            }
+        }
+
+        void Lock()
+        {
+            if( !try_lock() ) {
+                uint64_t starttime = utils::GetMicroTime();
+                lock();
+                _env._AddLockContention(utils::GetMicroTime()-starttime);
+            }
+        }
+
+private:
+        const Environment& _env;
+    };
+
+    /// \brief lock held by the read-only collision queries, also selects the collision checker the query runs on.
+    ///
+    /// When concurrent queries are enabled, only a shared lock on _mutexQueries is taken so many threads can query at the same time,
+    /// and every thread queries its own checker so that the checker caches are not shared. Otherwise the environment mutex is locked
+    /// and the environment checker is used. A thread that holds a ConcurrentQueriesWriteLock already excludes the other queries, so it uses the environment checker.
+    class QueryLock
+    {
+public:
+        QueryLock(Environment& env) : _lockqueries(env._mutexQueries, boost::defer_lock), _lockenv(env, false), _pchecker(NULL) {
+            if( !env._IsConcurrentQueriesWriter() ) {
+                while(true) {
+                    _lockqueries.lock();
+                    if( !env._bConcurrentQueries ) {
+                        _lockqueries.unlock();
+                        break;
+                    }
+                    _pchecker = env._GetConcurrentQueryChecker().get(); // only destroyed by writers, which wait for _lockqueries
+                    if( !!_pchecker ) {
+                        return;
+                    }
+                    // creating the checker locks the environment, which cannot be done while holding _mutexQueries since the writers lock them in the opposite order
+                    _lockqueries.unlock();
+                    env._CreateConcurrentQueryChecker();
+                }
+            }
+            _lockenv.Lock();
+            _pchecker = env._pCurrentChecker.get();
+        }
+
+        /// \brief the checker the query has to run on
+        inline CollisionCheckerBase* GetChecker() const {
+            return _pchecker;
+        }
+
+private:
+        boost::shared_lock<boost::shared_mutex> _lockqueries;
+        EnvironmentLock _lockenv;
+        CollisionCheckerBase* _pchecker;
+    };
+
+    /// \brief held while changing the scene, waits for the running concurrent queries and blocks new ones.
+    ///
+    /// Has to be created with the environment mutex locked, so the concurrent query mode cannot change while it is alive. Can be nested in the same thread.
+    class ConcurrentQueriesWriteLock : public UserData
+    {
+public:
+        ConcurrentQueriesWriteLock(const Environment& env) : _env(env), _bLocked(env._LockConcurrentQueriesWrite()) {
+        }
+        virtual ~ConcurrentQueriesWriteLock() {
+            if( _bLocked ) {
+                _env._UnlockConcurrentQueriesWrite();
+            }
+        }
+
+private:
+        const Environment& _env;
+        bool _bLocked;
+    };
+
+    /// \brief the checker a thread runs its concurrent queries on
+    struct ConcurrentQueryChecker
+    {
+        CollisionCheckerBasePtr pchecker;
+        boost::weak_ptr<int> threadtoken; ///< expires when the thread that created pchecker exits, see _GetThreadToken
+    };
+
     class GraphHandleMulti : public GraphHandle
     {
 public:
@@ -76,7 +170,7 @@ public:
         virtual ~CollisionCallbackData() {
             boost::shared_ptr<Environment> penv = _pweakenv.lock();
             if( !!penv ) {
-                boost::timed_mutex::scoped_lock lock(penv->_mutexInterfaces);
+                InterfacesLock lock(penv->_mutexInterfaces);
                 penv->_listRegisteredCollisionCallbacks.erase(_iterator);
             }
         }
@@ -97,7 +191,7 @@ public:
         virtual ~BodyCallbackData() {
             boost::shared_ptr<Environment> penv = _pweakenv.lock();
             if( !!penv ) {
-                boost::timed_mutex::scoped_lock lock(penv->_mutexInterfaces);
+                InterfacesLock lock(penv->_mutexInterfaces);
                 penv->_listRegisteredBodyCallbacks.erase(_iterator);
             }
         }
@@ -111,7 +205,7 @@ protected:
     typedef boost::shared_ptr<BodyCallbackData> BodyCallbackDataPtr;
 
 public:
-    Environment() : EnvironmentBase()
+    Environment() : EnvironmentBase(), _pconcurrentquerieswriter(&Environment::_NoCleanupConcurrentQueriesWriter)
     {
         _homedirectory = RaveGetHomeDirectory();
         RAVELOG_DEBUG_FORMAT("setting openrave home directory to %s", _homedirectory);
@@ -125,6 +219,7 @@ public:
         _bRealTime = true;
         _bInit = false;
         _bEnableSimulation = true;     // need to start by default
+        _bConcurrentQueries = false;
         _unit = std::make_pair("meter",1.0); //default unit settings
 
         _handlegenericrobot = RaveRegisterInterface(PT_Robot,"GenericRobot", RaveGetInterfaceHash(PT_Robot), GetHash(), CreateGenericRobot);
@@ -232,7 +327,7 @@ public:
         list< pair<ModuleBasePtr, std::string> > listModules;
         list<ViewerBasePtr> listViewers = _listViewers;
         {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             listModules = _listModules;
             listViewers = _listViewers;
         }
@@ -251,7 +346,8 @@ public:
 
         // lock the environment
         {
-            EnvironmentMutex::scoped_lock lockenv(GetMutex());
+            EnvironmentLock lockenv(*this);
+            ConcurrentQueriesWriteLock lockwrite(*this);
             _bEnableSimulation = false;
             if( !!_pPhysicsEngine ) {
                 _pPhysicsEngine->DestroyEnvironment();
@@ -259,13 +355,14 @@ public:
             if( !!_pCurrentChecker ) {
                 _pCurrentChecker->DestroyEnvironment();
             }
+            _ClearConcurrentQueryCheckers();
 
             // clear internal interface lists, have to Destroy all kinbodys without locking _mutexInterfaces since some can hold BodyCallbackData, which requires to lock _mutexInterfaces
             std::vector<RobotBasePtr> vecrobots;
             std::vector<KinBodyPtr> vecbodies;
             list<SensorBasePtr> listSensors;
             {
-                boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+                InterfacesLock lock(_mutexInterfaces);
                 vecrobots.swap(_vecrobots);
                 vecbodies.swap(_vecbodies);
                 listSensors.swap(_listSensors);
@@ -315,7 +412,8 @@ public:
             }
         }
 
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
+        ConcurrentQueriesWriteLock lockwrite(*this);
 
         if( !!_pPhysicsEngine ) {
             _pPhysicsEngine->DestroyEnvironment();
@@ -323,9 +421,10 @@ public:
         if( !!_pCurrentChecker ) {
             _pCurrentChecker->DestroyEnvironment();
         }
+        _ClearConcurrentQueryCheckers();
         std::vector<KinBodyPtr> vcallbackbodies;
         {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             boost::mutex::scoped_lock locknetworkid(_mutexEnvironmentIds);
 
             FOREACH(itbody,_vecbodies) {
@@ -364,7 +463,7 @@ public:
 
         list< pair<ModuleBasePtr, std::string> > listModules;
         {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             listModules = _listModules;
         }
 
@@ -389,21 +488,21 @@ public:
     virtual void OwnInterface(InterfaceBasePtr pinterface)
     {
         CHECK_INTERFACE(pinterface);
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        EnvironmentLock lockenv(*this);
+        InterfacesLock lock(_mutexInterfaces);
         _listOwnedInterfaces.push_back(pinterface);
     }
     virtual void DisownInterface(InterfaceBasePtr pinterface)
     {
         CHECK_INTERFACE(pinterface);
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        EnvironmentLock lockenv(*this);
+        InterfacesLock lock(_mutexInterfaces);
         _listOwnedInterfaces.remove(pinterface);
     }
 
     virtual EnvironmentBasePtr CloneSelf(int options)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         boost::shared_ptr<Environment> penv(new Environment());
         penv->_Clone(boost::static_pointer_cast<Environment const>(shared_from_this()),options,false);
         return penv;
@@ -411,7 +510,9 @@ public:
 
     virtual void Clone(EnvironmentBaseConstPtr preference, int cloningoptions)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
+        ConcurrentQueriesWriteLock lockwrite(*this);
+        _ClearConcurrentQueryCheckers();
         _Clone(boost::static_pointer_cast<Environment const>(preference),cloningoptions,true);
     }
 
@@ -423,8 +524,8 @@ public:
             RAVELOG_WARN_FORMAT("Error %d with executing module %s", ret%module->GetXMLId());
         }
         else {
-            EnvironmentMutex::scoped_lock lockenv(GetMutex());
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            EnvironmentLock lockenv(*this);
+            InterfacesLock lock(_mutexInterfaces);
             _listModules.emplace_back(module,  cmdargs);
         }
 
@@ -434,14 +535,14 @@ public:
     void GetModules(std::list<ModuleBasePtr>& listModules, uint64_t timeout) const
     {
         if( timeout == 0 ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesSharedLock lock(_mutexInterfaces);
             listModules.clear();
             FOREACHC(it, _listModules) {
                 listModules.push_back(it->first);
             }
         }
         else {
-            boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
+            InterfacesSharedLock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
             if (!lock.owns_lock()) {
                 throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
             }
@@ -459,7 +560,7 @@ public:
 
     virtual bool Load(const std::string& filename, const AttributesList& atts)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         OpenRAVEXMLParser::GetXMLErrorCount() = 0;
         if( _IsColladaURI(filename) ) {
             if( RaveParseColladaURI(shared_from_this(), filename, atts) ) {
@@ -504,7 +605,7 @@ public:
 
     virtual bool LoadData(const std::string& data, const AttributesList& atts)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         if( _IsColladaData(data) ) {
             return RaveParseColladaData(shared_from_this(), data, atts);
         }
@@ -513,7 +614,7 @@ public:
 
     virtual void Save(const std::string& filename, SelectionOptions options, const AttributesList& atts)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         std::list<KinBodyPtr> listbodies;
         switch(options) {
         case SO_Everything:
@@ -577,7 +678,7 @@ public:
             throw OPENRAVE_EXCEPTION_FORMAT("got invalid filetype %s, only support collada", filetype, ORE_InvalidArguments);
         }
 
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         std::list<KinBodyPtr> listbodies;
         switch(options) {
         case SO_Everything:
@@ -655,7 +756,8 @@ public:
 
     virtual void _AddKinBody(KinBodyPtr pbody, bool bAnonymous)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
+        ConcurrentQueriesWriteLock lockwrite(*this);
         CHECK_INTERFACE(pbody);
         if( !utils::IsValidName(pbody->GetName()) ) {
             throw openrave_exception(str(boost::format(_("kinbody name: \"%s\" is not valid"))%pbody->GetName()));
@@ -672,13 +774,14 @@ public:
             }
         }
         {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             _vecbodies.push_back(pbody);
             SetEnvironmentId(pbody);
             _nBodiesModifiedStamp++;
         }
         pbody->_ComputeInternalInformation();
         _pCurrentChecker->InitKinBody(pbody);
+        _ClearConcurrentQueryCheckers();
         if( !!pbody->GetSelfCollisionChecker() && pbody->GetSelfCollisionChecker() != _pCurrentChecker ) {
             // also initialize external collision checker if specified for this body
             pbody->GetSelfCollisionChecker()->InitKinBody(pbody);
@@ -691,7 +794,8 @@ public:
 
     virtual void _AddRobot(RobotBasePtr robot, bool bAnonymous)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
+        ConcurrentQueriesWriteLock lockwrite(*this);
         CHECK_INTERFACE(robot);
         if( !robot->IsRobot() ) {
             throw openrave_exception(str(boost::format(_("kinbody \"%s\" is not a robot"))%robot->GetName()));
@@ -711,7 +815,7 @@ public:
             }
         }
         {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             _vecbodies.push_back(robot);
             _vecrobots.push_back(robot);
             SetEnvironmentId(robot);
@@ -719,6 +823,7 @@ public:
         }
         robot->_ComputeInternalInformation(); // have to do this after _vecrobots is added since SensorBase::SetName can call EnvironmentBase::GetSensor to initialize itself
         _pCurrentChecker->InitKinBody(robot);
+        _ClearConcurrentQueryCheckers();
         if( !!robot->GetSelfCollisionChecker() && robot->GetSelfCollisionChecker() != _pCurrentChecker ) {
             // also initialize external collision checker if specified for this body
             robot->GetSelfCollisionChecker()->InitKinBody(robot);
@@ -731,7 +836,7 @@ public:
 
     virtual void _AddSensor(SensorBasePtr psensor, bool bAnonymous)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         CHECK_INTERFACE(psensor);
         if( !utils::IsValidName(psensor->GetName()) ) {
             throw openrave_exception(str(boost::format(_("sensor name: \"%s\" is not valid"))%psensor->GetName()));
@@ -748,7 +853,7 @@ public:
             }
         }
         {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             _listSensors.push_back(psensor);
         }
         psensor->Configure(SensorBase::CC_PowerOn);
@@ -756,14 +861,15 @@ public:
 
     virtual bool Remove(InterfaceBasePtr pinterface)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
+        ConcurrentQueriesWriteLock lockwrite(*this);
         CHECK_INTERFACE(pinterface);
         switch(pinterface->GetInterfaceType()) {
         case PT_KinBody:
         case PT_Robot: {
             KinBodyPtr pbody = RaveInterfaceCast<KinBody>(pinterface);
             {
-                boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+                InterfacesLock lock(_mutexInterfaces);
                 vector<KinBodyPtr>::iterator it = std::find(_vecbodies.begin(), _vecbodies.end(), pbody);
                 if( it == _vecbodies.end() ) {
                     return false;
@@ -814,10 +920,11 @@ public:
 
     virtual bool RemoveKinBodyByName(const std::string& name)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
+        ConcurrentQueriesWriteLock lockwrite(*this);
         KinBodyPtr pbody;
         {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             vector<KinBodyPtr>::iterator it = _vecbodies.end();
             FOREACHC(itbody, _vecbodies) {
                 if( (*itbody)->GetName() == name ) {
@@ -838,7 +945,7 @@ public:
 
     virtual UserDataPtr RegisterBodyCallback(const BodyCallbackFn& callback)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesLock lock(_mutexInterfaces);
         BodyCallbackDataPtr pdata(new BodyCallbackData(callback,boost::static_pointer_cast<Environment>(shared_from_this())));
         pdata->_iterator = _listRegisteredBodyCallbacks.insert(_listRegisteredBodyCallbacks.end(),pdata);
         return pdata;
@@ -846,7 +953,7 @@ public:
 
     virtual KinBodyPtr GetKinBody(const std::string& pname) const
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         FOREACHC(it, _vecbodies) {
             if((*it)->GetName()==pname) {
                 return *it;
@@ -857,7 +964,7 @@ public:
 
     virtual RobotBasePtr GetRobot(const std::string& pname) const
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         FOREACHC(it, _vecrobots) {
             if((*it)->GetName()==pname) {
                 return *it;
@@ -868,7 +975,7 @@ public:
 
     virtual SensorBasePtr GetSensor(const std::string& name) const
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         FOREACHC(itrobot,_vecrobots) {
             FOREACHC(itsensor, (*itrobot)->GetAttachedSensors()) {
                 SensorBasePtr psensor = (*itsensor)->GetSensor();
@@ -887,7 +994,7 @@ public:
 
     virtual bool SetPhysicsEngine(PhysicsEngineBasePtr pengine)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         if( !!_pPhysicsEngine ) {
             _pPhysicsEngine->DestroyEnvironment();
         }
@@ -910,20 +1017,20 @@ public:
 
     virtual UserDataPtr RegisterCollisionCallback(const CollisionCallbackFn& callback)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesLock lock(_mutexInterfaces);
         CollisionCallbackDataPtr pdata(new CollisionCallbackData(callback,boost::static_pointer_cast<Environment>(shared_from_this())));
         pdata->_iterator = _listRegisteredCollisionCallbacks.insert(_listRegisteredCollisionCallbacks.end(),pdata);
         return pdata;
     }
     virtual bool HasRegisteredCollisionCallbacks() const
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         return _listRegisteredCollisionCallbacks.size() > 0;
     }
 
     virtual void GetRegisteredCollisionCallbacks(std::list<CollisionCallbackFn>& listcallbacks) const
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         listcallbacks.clear();
         FOREACHC(it, _listRegisteredCollisionCallbacks) {
             CollisionCallbackDataPtr pdata = boost::dynamic_pointer_cast<CollisionCallbackData>(it->lock());
@@ -933,10 +1040,12 @@ public:
 
     virtual bool SetCollisionChecker(CollisionCheckerBasePtr pchecker)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
+        ConcurrentQueriesWriteLock lockwrite(*this);
         if( _pCurrentChecker == pchecker ) {
             return true;
         }
+        _ClearConcurrentQueryCheckers();
         if( !!_pCurrentChecker ) {
             _pCurrentChecker->DestroyEnvironment();     // delete all resources
         }
@@ -960,90 +1069,92 @@ public:
 
     virtual bool CheckCollision(KinBodyConstPtr pbody1, CollisionReportPtr report)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        QueryLock lockquery(*this);
         CHECK_COLLISION_BODY(pbody1);
-        return _pCurrentChecker->CheckCollision(pbody1,report);
+        return lockquery.GetChecker()->CheckCollision(pbody1,report);
     }
 
     virtual bool CheckCollision(KinBodyConstPtr pbody1, KinBodyConstPtr pbody2, CollisionReportPtr report)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        QueryLock lockquery(*this);
         CHECK_COLLISION_BODY(pbody1);
         CHECK_COLLISION_BODY(pbody2);
-        return _pCurrentChecker->CheckCollision(pbody1,pbody2,report);
+        return lockquery.GetChecker()->CheckCollision(pbody1,pbody2,report);
     }
 
     virtual bool CheckCollision(KinBody::LinkConstPtr plink, CollisionReportPtr report )
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        QueryLock lockquery(*this);
         CHECK_COLLISION_BODY(plink->GetParent());
-        return _pCurrentChecker->CheckCollision(plink,report);
+        return lockquery.GetChecker()->CheckCollision(plink,report);
     }
 
     virtual bool CheckCollision(KinBody::LinkConstPtr plink1, KinBody::LinkConstPtr plink2, CollisionReportPtr report)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        QueryLock lockquery(*this);
         CHECK_COLLISION_BODY(plink1->GetParent());
         CHECK_COLLISION_BODY(plink2->GetParent());
-        return _pCurrentChecker->CheckCollision(plink1,plink2,report);
+        return lockquery.GetChecker()->CheckCollision(plink1,plink2,report);
     }
 
     virtual bool CheckCollision(KinBody::LinkConstPtr plink, KinBodyConstPtr pbody, CollisionReportPtr report)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        QueryLock lockquery(*this);
         CHECK_COLLISION_BODY(plink->GetParent());
         CHECK_COLLISION_BODY(pbody);
-        return _pCurrentChecker->CheckCollision(plink,pbody,report);
+        return lockquery.GetChecker()->CheckCollision(plink,pbody,report);
     }
 
     virtual bool CheckCollision(KinBody::LinkConstPtr plink, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<KinBody::LinkConstPtr>& vlinkexcluded, CollisionReportPtr report)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        QueryLock lockquery(*this);
         CHECK_COLLISION_BODY(plink->GetParent());
-        return _pCurrentChecker->CheckCollision(plink,vbodyexcluded,vlinkexcluded,report);
+        return lockquery.GetChecker()->CheckCollision(plink,vbodyexcluded,vlinkexcluded,report);
     }
 
     virtual bool CheckCollision(KinBodyConstPtr pbody, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<KinBody::LinkConstPtr>& vlinkexcluded, CollisionReportPtr report)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        QueryLock lockquery(*this);
         CHECK_COLLISION_BODY(pbody);
-        return _pCurrentChecker->CheckCollision(pbody,vbodyexcluded,vlinkexcluded,report);
+        return lockquery.GetChecker()->CheckCollision(pbody,vbodyexcluded,vlinkexcluded,report);
     }
 
     virtual bool CheckCollision(const RAY& ray, KinBody::LinkConstPtr plink, CollisionReportPtr report)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        QueryLock lockquery(*this);
         CHECK_COLLISION_BODY(plink->GetParent());
-        return _pCurrentChecker->CheckCollision(ray,plink,report);
+        return lockquery.GetChecker()->CheckCollision(ray,plink,report);
     }
     virtual bool CheckCollision(const RAY& ray, KinBodyConstPtr pbody, CollisionReportPtr report)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        QueryLock lockquery(*this);
         CHECK_COLLISION_BODY(pbody);
-        return _pCurrentChecker->CheckCollision(ray,pbody,report);
+        return lockquery.GetChecker()->CheckCollision(ray,pbody,report);
     }
     virtual bool CheckCollision(const RAY& ray, CollisionReportPtr report)
     {
-        return _pCurrentChecker->CheckCollision(ray,report);
+        QueryLock lockquery(*this);
+        return lockquery.GetChecker()->CheckCollision(ray,report);
     }
 
     virtual bool CheckCollision(const TriMesh& trimesh, KinBodyConstPtr pbody, CollisionReportPtr report)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        QueryLock lockquery(*this);
         CHECK_COLLISION_BODY(pbody);
-        return _pCurrentChecker->CheckCollision(trimesh,pbody,report);
+        return lockquery.GetChecker()->CheckCollision(trimesh,pbody,report);
     }
 
     virtual bool CheckStandaloneSelfCollision(KinBodyConstPtr pbody, CollisionReportPtr report)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        QueryLock lockquery(*this);
         CHECK_COLLISION_BODY(pbody);
-        return _pCurrentChecker->CheckStandaloneSelfCollision(pbody,report);
+        return lockquery.GetChecker()->CheckStandaloneSelfCollision(pbody,report);
     }
 
     virtual void StepSimulation(dReal fTimeStep)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
+        ConcurrentQueriesWriteLock lockwrite(*this);
 
         uint64_t step = (uint64_t)ceil(1000000.0 * (double)fTimeStep);
         fTimeStep = (dReal)((double)step * 0.000001);
@@ -1057,7 +1168,7 @@ public:
         list<SensorBasePtr> listSensors;
         list< pair<ModuleBasePtr, std::string> > listModules;
         {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesSharedLock lock(_mutexInterfaces);
             vecbodies = _vecbodies;
             vecrobots = _vecrobots;
             listSensors = _listSensors;
@@ -1091,14 +1202,61 @@ public:
         return _mutexEnvironment;
     }
 
+    virtual void SetConcurrentQueries(bool bConcurrent)
+    {
+        // the writers hold the environment mutex, so locking it first keeps the mode fixed for them
+        EnvironmentLock lockenv(*this);
+        boost::unique_lock<boost::shared_mutex> lock(_mutexQueries); // wait for all running queries
+        if( _bConcurrentQueries != bConcurrent ) {
+            RAVELOG_DEBUG_FORMAT("env=%d, concurrent queries=%d", GetId()%bConcurrent);
+            _bConcurrentQueries = bConcurrent;
+            _ClearConcurrentQueryCheckers();
+        }
+    }
+
+    virtual UserDataPtr LockConcurrentQueries()
+    {
+        if( !_bConcurrentQueries || _IsConcurrentQueriesWriter() ) {
+            return UserDataPtr();
+        }
+        return UserDataPtr(new ConcurrentQueriesWriteLock(*this));
+    }
+
+    virtual bool TryLockConcurrentQueries()
+    {
+        return _LockConcurrentQueriesWrite();
+    }
+
+    virtual void UnlockConcurrentQueries()
+    {
+        _UnlockConcurrentQueriesWrite();
+    }
+
+    virtual bool IsConcurrentQueries() const
+    {
+        return _bConcurrentQueries;
+    }
+
+    virtual void GetLockStatistics(LockStatistics& stats) const
+    {
+        boost::mutex::scoped_lock lock(_mutexLockStatistics);
+        stats = _lockstatistics;
+    }
+
+    virtual void ResetLockStatistics()
+    {
+        boost::mutex::scoped_lock lock(_mutexLockStatistics);
+        _lockstatistics = LockStatistics();
+    }
+
     virtual void GetBodies(std::vector<KinBodyPtr>& bodies, uint64_t timeout) const
     {
         if( timeout == 0 ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesSharedLock lock(_mutexInterfaces);
             bodies = _vecbodies;
         }
         else {
-            boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
+            InterfacesSharedLock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
             if (!lock.owns_lock()) {
                 throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
             }
@@ -1109,11 +1267,11 @@ public:
     virtual void GetRobots(std::vector<RobotBasePtr>& robots, uint64_t timeout) const
     {
         if( timeout == 0 ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesSharedLock lock(_mutexInterfaces);
             robots = _vecrobots;
         }
         else {
-            boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
+            InterfacesSharedLock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
             if (!lock.owns_lock()) {
                 throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
             }
@@ -1124,11 +1282,11 @@ public:
     virtual void GetSensors(std::vector<SensorBasePtr>& vsensors, uint64_t timeout) const
     {
         if( timeout == 0 ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesSharedLock lock(_mutexInterfaces);
             _GetSensors(vsensors);
         }
         else {
-            boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
+            InterfacesSharedLock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
             if (!lock.owns_lock()) {
                 throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
             }
@@ -1151,7 +1309,7 @@ public:
 
     virtual void Triangulate(TriMesh& trimesh, const KinBody &body)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());     // reading collision data, so don't want anyone modifying it
+        EnvironmentLock lockenv(*this);     // reading collision data, so don't want anyone modifying it
         FOREACHC(it, body.GetLinks()) {
             trimesh.Append((*it)->GetCollisionData(), (*it)->GetTransform());
         }
@@ -1159,7 +1317,7 @@ public:
 
     virtual void TriangulateScene(TriMesh& trimesh, SelectionOptions options,const std::string& selectname)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         FOREACH(itbody, _vecbodies) {
             RobotBasePtr robot;
             if( (*itbody)->IsRobot() ) {
@@ -1205,10 +1363,10 @@ public:
 
     virtual RobotBasePtr ReadRobotURI(RobotBasePtr robot, const std::string& filename, const AttributesList& atts)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
 
         if( !!robot ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             FOREACH(itviewer, _listViewers) {
                 (*itviewer)->RemoveKinBody(robot);
             }
@@ -1217,6 +1375,38 @@ public:
             }
         }
 
+        KinematicModelCache& modelcache = GetKinematicModelCache();
+        std::string cachekey;
+        if( modelcache.IsEnabled() && !_IsColladaURI(filename) && (_IsOpenRAVEFile(filename) || !_IsRigidModelFile(filename)) ) {
+            cachekey = KinematicModelCache::GetKey(filename, atts);
+        }
+        if( cachekey.size() > 0 ) {
+            KinematicModelConstPtr model = modelcache.Find(cachekey);
+            if( !!model ) {
+                uint64_t starttime = utils::GetMicroTime();
+                RobotBasePtr newrobot = _CreateRobotFromKinematicModel(robot, *model);
+                if( !!newrobot ) {
+                    modelcache.AddHit(utils::GetMicroTime()-starttime);
+                    return newrobot;
+                }
+            }
+        }
+
+        uint64_t starttime = utils::GetMicroTime();
+        robot = _ReadRobotURI(robot, filename, atts);
+        if( !!robot && cachekey.size() > 0 ) {
+            std::string fullfilename = RaveFindLocalFile(filename);
+            KinematicModelConstPtr model = _ExtractKinematicModel(robot, fullfilename);
+            if( !!model ) {
+                modelcache.Insert(cachekey, fullfilename, model, utils::GetMicroTime()-starttime);
+            }
+        }
+        return robot;
+    }
+
+    /// \brief reads the robot from the file without using the kinematic model cache
+    RobotBasePtr _ReadRobotURI(RobotBasePtr robot, const std::string& filename, const AttributesList& atts)
+    {
         if( _IsColladaURI(filename) ) {
             if( !RaveParseColladaURI(shared_from_this(), robot, filename, atts) ) {
                 return RobotBasePtr();
@@ -1289,12 +1479,113 @@ public:
         return robot;
     }
 
+    /// \brief stores the infos of a robot that was just read so that robots can be created from them without reading the file again
+    ///
+    /// \param fullfilename the resolved file the robot was read from
+    /// \return empty if the robot cannot be recreated from its infos
+    KinematicModelConstPtr _ExtractKinematicModel(RobotBasePtr robot, const std::string& fullfilename)
+    {
+        // readables can be defined by plugins and connected bodies are resolved from other files, so read these robots every time
+        if( robot->GetLinks().size() == 0 || robot->GetReadableInterfaces().size() > 0 || robot->GetConnectedBodies().size() > 0 ) {
+            return KinematicModelConstPtr();
+        }
+        KinematicModelPtr model(new KinematicModel());
+        model->_xmlid = robot->GetXMLId();
+        model->_name = robot->GetName();
+        model->_description = robot->GetDescription();
+        model->_uri = robot->GetURI();
+        FOREACHC(itlink, robot->GetLinks()) {
+            KinBody::LinkInfoPtr linkinfo(new KinBody::LinkInfo((*itlink)->UpdateAndGetInfo()));
+            // the adjacent links set by the file are stored in the body
+            linkinfo->_vForcedAdjacentLinks.clear();
+            FOREACHC(itadjacent, robot->_vForcedAdjacentLinks) {
+                if( itadjacent->first == linkinfo->_name ) {
+                    linkinfo->_vForcedAdjacentLinks.push_back(itadjacent->second);
+                }
+            }
+            model->_vLinkInfos.push_back(linkinfo);
+        }
+        for(int ipassive = 0; ipassive < 2; ++ipassive) {
+            FOREACHC(itjoint, ipassive ? robot->GetPassiveJoints() : robot->GetJoints()) {
+                KinBody::JointInfoPtr jointinfo(new KinBody::JointInfo((*itjoint)->UpdateAndGetInfo()));
+                if( !!jointinfo->_trajfollow ) {
+                    return KinematicModelConstPtr();
+                }
+                jointinfo->_bIsActive = !ipassive;
+                for(int iaxis = 0; iaxis < (*itjoint)->GetDOF(); ++iaxis) {
+                    jointinfo->_vmimic[iaxis].reset();
+                    if( (*itjoint)->IsMimic(iaxis) ) {
+                        jointinfo->_vmimic[iaxis].reset(new KinBody::MimicInfo());
+                        for(int itype = 0; itype < 3; ++itype) {
+                            jointinfo->_vmimic[iaxis]->_equations[itype] = (*itjoint)->GetMimicEquation(iaxis, itype);
+                        }
+                    }
+                }
+                model->_vJointInfos.push_back(jointinfo);
+            }
+        }
+        FOREACHC(itmanip, robot->GetManipulators()) {
+            model->_vManipulatorInfos.push_back(RobotBase::ManipulatorInfoConstPtr(new RobotBase::ManipulatorInfo((*itmanip)->GetInfo())));
+        }
+        FOREACHC(itattached, robot->GetAttachedSensors()) {
+            model->_vAttachedSensorInfos.push_back(RobotBase::AttachedSensorInfoConstPtr(new RobotBase::AttachedSensorInfo((*itattached)->UpdateAndGetInfo())));
+        }
+        FOREACHC(itgripper, robot->GetGripperInfos()) {
+            model->_vGripperInfos.push_back(RobotBase::GripperInfoConstPtr(new RobotBase::GripperInfo(**itgripper)));
+        }
+        KinematicModelCache::SetDependencies(*model, fullfilename);
+        return model;
+    }
+
+    /// \brief initializes robot from a cached model, creates the robot if it is empty
+    ///
+    /// \return empty if robot is of a different type than the model or the initialization failed. If the initialization
+    /// failed, robot is destroyed and gets its previous name back so that the file can be read into it.
+    RobotBasePtr _CreateRobotFromKinematicModel(RobotBasePtr robot, const KinematicModel& model)
+    {
+        if( !robot ) {
+            robot = RaveCreateRobot(shared_from_this(), model._xmlid);
+            if( !robot ) {
+                return RobotBasePtr();
+            }
+        }
+        else if( _stricmp(robot->GetXMLId().c_str(), model._xmlid.c_str()) != 0 ) {
+            return RobotBasePtr();
+        }
+
+        const std::string oldname = robot->GetName();
+        if( model._name.size() > 0 ) {
+            robot->SetName(model._name); // the attached sensors are named after the robot
+        }
+        bool bsuccess = false;
+        try {
+            // Init copies the infos, so the cached model is not modified
+            bsuccess = robot->Init(model._vLinkInfos, model._vJointInfos, model._vManipulatorInfos, model._vAttachedSensorInfos, model._uri);
+        }
+        catch(const std::exception& ex) {
+            RAVELOG_WARN_FORMAT("env=%d, failed to create robot %s from cached model %s: %s", GetId()%model._name%model._uri%ex.what());
+        }
+        if( !bsuccess ) {
+            // Init can fail after adding some of the links, reading the file would add to them
+            robot->Destroy();
+            if( oldname.size() > 0 ) {
+                robot->SetName(oldname);
+            }
+            return RobotBasePtr();
+        }
+        FOREACHC(itgripper, model._vGripperInfos) {
+            robot->AddGripperInfo(RobotBase::GripperInfoPtr(new RobotBase::GripperInfo(**itgripper)));
+        }
+        robot->SetDescription(model._description);
+        return robot;
+    }
+
     virtual RobotBasePtr ReadRobotData(RobotBasePtr robot, const std::string& data, const AttributesList& atts)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
 
         if( !!robot ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             FOREACH(itviewer, _listViewers) {
                 (*itviewer)->RemoveKinBody(robot);
             }
@@ -1348,10 +1639,10 @@ public:
 
     virtual KinBodyPtr ReadKinBodyURI(KinBodyPtr body, const std::string& filename, const AttributesList& atts)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
 
         if( !!body ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             FOREACH(itviewer, _listViewers) {
                 (*itviewer)->RemoveKinBody(body);
             }
@@ -1432,10 +1723,10 @@ public:
 
     virtual KinBodyPtr ReadKinBodyData(KinBodyPtr body, const std::string& data, const AttributesList& atts)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
 
         if( !!body ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             FOREACH(itviewer, _listViewers) {
                 (*itviewer)->RemoveKinBody(body);
             }
@@ -1489,7 +1780,7 @@ public:
     virtual InterfaceBasePtr ReadInterfaceURI(const std::string& filename, const AttributesList& atts)
     {
         try {
-            EnvironmentMutex::scoped_lock lockenv(GetMutex());
+            EnvironmentLock lockenv(*this);
             BaseXMLReaderPtr preader = OpenRAVEXMLParser::CreateInterfaceReader(shared_from_this(),atts,false);
             if( !preader ) {
                 return InterfaceBasePtr();
@@ -1511,7 +1802,7 @@ public:
 
     virtual InterfaceBasePtr ReadInterfaceURI(InterfaceBasePtr pinterface, InterfaceType type, const std::string& filename, const AttributesList& atts)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         bool bIsColladaURI=false, bIsColladaFile=false, bIsXFile = false;
         if( _IsColladaURI(filename) ) {
             bIsColladaURI = true;
@@ -1592,7 +1883,7 @@ public:
 
     virtual InterfaceBasePtr ReadInterfaceData(InterfaceBasePtr pinterface, InterfaceType type, const std::string& data, const AttributesList& atts)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
 
         // check for collada?
         BaseXMLReaderPtr preader = OpenRAVEXMLParser::CreateInterfaceReader(shared_from_this(), type, pinterface, RaveGetInterfaceName(type), atts);
@@ -1616,7 +1907,7 @@ public:
 
     virtual boost::shared_ptr<TriMesh> _ReadTrimeshURI(boost::shared_ptr<TriMesh> ptrimesh, const std::string& filename, RaveVector<float>& diffuseColor, RaveVector<float>& ambientColor, const AttributesList& atts)
     {
-        //EnvironmentMutex::scoped_lock lockenv(GetMutex()); // don't lock!
+        //EnvironmentLock lockenv(*this); // don't lock!
         string filedata = RaveFindLocalFile(filename);
         if( filedata.size() == 0 ) {
             return boost::shared_ptr<TriMesh>();
@@ -1678,7 +1969,7 @@ public:
     /// \param[in] listGeometries geometry list to be filled
     virtual std::string _ReadGeometriesFile(std::list<KinBody::GeometryInfo>& listGeometries, const std::string& filename, const AttributesList& atts)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         string filedata = RaveFindLocalFile(filename);
         if( filedata.size() == 0 ) {
             return std::string();
@@ -1703,8 +1994,8 @@ public:
     virtual void _AddViewer(ViewerBasePtr pnewviewer)
     {
         CHECK_INTERFACE(pnewviewer);
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        EnvironmentLock lockenv(*this);
+        InterfacesLock lock(_mutexInterfaces);
         BOOST_ASSERT(find(_listViewers.begin(),_listViewers.end(),pnewviewer) == _listViewers.end() );
         _CheckUniqueName(ViewerBaseConstPtr(pnewviewer),true);
         _listViewers.push_back(pnewviewer);
@@ -1712,7 +2003,7 @@ public:
 
     virtual ViewerBasePtr GetViewer(const std::string& name) const
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( name.size() == 0 ) {
             return _listViewers.size() > 0 ? _listViewers.front() : ViewerBasePtr();
         }
@@ -1726,13 +2017,13 @@ public:
 
     void GetViewers(std::list<ViewerBasePtr>& listViewers) const
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         listViewers = _listViewers;
     }
 
     virtual OpenRAVE::GraphHandlePtr plot3(const float* ppoints, int numPoints, int stride, float fPointSize, const RaveVector<float>& color, int drawstyle)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( _listViewers.size() == 0 ) {
             return OpenRAVE::GraphHandlePtr();
         }
@@ -1744,7 +2035,7 @@ public:
     }
     virtual OpenRAVE::GraphHandlePtr plot3(const float* ppoints, int numPoints, int stride, float fPointSize, const float* colors, int drawstyle, bool bhasalpha)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( _listViewers.size() == 0 ) {
             return OpenRAVE::GraphHandlePtr();
         }
@@ -1756,7 +2047,7 @@ public:
     }
     virtual OpenRAVE::GraphHandlePtr drawlinestrip(const float* ppoints, int numPoints, int stride, float fwidth, const RaveVector<float>& color)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( _listViewers.size() == 0 ) {
             return OpenRAVE::GraphHandlePtr();
         }
@@ -1768,7 +2059,7 @@ public:
     }
     virtual OpenRAVE::GraphHandlePtr drawlinestrip(const float* ppoints, int numPoints, int stride, float fwidth, const float* colors)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( _listViewers.size() == 0 ) {
             return OpenRAVE::GraphHandlePtr();
         }
@@ -1780,7 +2071,7 @@ public:
     }
     virtual OpenRAVE::GraphHandlePtr drawlinelist(const float* ppoints, int numPoints, int stride, float fwidth, const RaveVector<float>& color)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( _listViewers.size() == 0 ) {
             return OpenRAVE::GraphHandlePtr();
         }
@@ -1792,7 +2083,7 @@ public:
     }
     virtual OpenRAVE::GraphHandlePtr drawlinelist(const float* ppoints, int numPoints, int stride, float fwidth, const float* colors)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( _listViewers.size() == 0 ) {
             return OpenRAVE::GraphHandlePtr();
         }
@@ -1804,7 +2095,7 @@ public:
     }
     virtual OpenRAVE::GraphHandlePtr drawarrow(const RaveVector<float>& p1, const RaveVector<float>& p2, float fwidth, const RaveVector<float>& color)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( _listViewers.size() == 0 ) {
             return OpenRAVE::GraphHandlePtr();
         }
@@ -1816,7 +2107,7 @@ public:
     }
     virtual OpenRAVE::GraphHandlePtr drawbox(const RaveVector<float>& vpos, const RaveVector<float>& vextents)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( _listViewers.size() == 0 ) {
             return OpenRAVE::GraphHandlePtr();
         }
@@ -1828,7 +2119,7 @@ public:
     }
     virtual OpenRAVE::GraphHandlePtr drawplane(const RaveTransform<float>& tplane, const RaveVector<float>& vextents, const boost::multi_array<float,3>& vtexture)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( _listViewers.size() == 0 ) {
             return OpenRAVE::GraphHandlePtr();
         }
@@ -1840,7 +2131,7 @@ public:
     }
     virtual OpenRAVE::GraphHandlePtr drawtrimesh(const float* ppoints, int stride, const int* pIndices, int numTriangles, const RaveVector<float>& color)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( _listViewers.size() == 0 ) {
             return OpenRAVE::GraphHandlePtr();
         }
@@ -1852,7 +2143,7 @@ public:
     }
     virtual OpenRAVE::GraphHandlePtr drawtrimesh(const float* ppoints, int stride, const int* pIndices, int numTriangles, const boost::multi_array<float,2>& colors)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         if( _listViewers.size() == 0 ) {
             return OpenRAVE::GraphHandlePtr();
         }
@@ -1865,7 +2156,7 @@ public:
 
     virtual KinBodyPtr GetBodyFromEnvironmentId(int id)
     {
-        boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+        InterfacesSharedLock lock(_mutexInterfaces);
         boost::mutex::scoped_lock locknetwork(_mutexEnvironmentIds);
         map<int, KinBodyWeakPtr>::iterator it = _mapBodies.find(id);
         if( it != _mapBodies.end() ) {
@@ -1877,7 +2168,7 @@ public:
     virtual void StartSimulation(dReal fDeltaTime, bool bRealTime)
     {
         {
-            EnvironmentMutex::scoped_lock lockenv(GetMutex());
+            EnvironmentLock lockenv(*this);
             _bEnableSimulation = true;
             _fDeltaSimTime = fDeltaTime;
             _bRealTime = bRealTime;
@@ -1894,7 +2185,7 @@ public:
     virtual void StopSimulation(int shutdownthread=1)
     {
         {
-            EnvironmentMutex::scoped_lock lockenv(GetMutex());
+            EnvironmentLock lockenv(*this);
             _bEnableSimulation = false;
             _fDeltaSimTime = 1.0f;
         }
@@ -1917,11 +2208,11 @@ public:
     virtual void GetPublishedBodies(std::vector<KinBody::BodyState>& vbodies, uint64_t timeout)
     {
         if( timeout == 0 ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesSharedLock lock(_mutexInterfaces);
             vbodies = _vPublishedBodies;
         }
         else {
-            boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
+            InterfacesSharedLock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
             if (!lock.owns_lock()) {
                 throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
             }
@@ -1932,7 +2223,7 @@ public:
     virtual bool GetPublishedBody(const std::string &name, KinBody::BodyState& bodystate, uint64_t timeout=0)
     {
         if( timeout == 0 ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesSharedLock lock(_mutexInterfaces);
             for ( size_t ibody = 0; ibody < _vPublishedBodies.size(); ++ibody) {
                 if ( _vPublishedBodies[ibody].strname == name) {
                     bodystate = _vPublishedBodies[ibody];
@@ -1941,7 +2232,7 @@ public:
             }
         }
         else {
-            boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
+            InterfacesSharedLock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
             if (!lock.owns_lock()) {
                 throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
             }
@@ -1959,7 +2250,7 @@ public:
     virtual bool GetPublishedBodyJointValues(const std::string& name, std::vector<dReal> &jointValues, uint64_t timeout=0)
     {
         if( timeout == 0 ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesSharedLock lock(_mutexInterfaces);
             for ( size_t ibody = 0; ibody < _vPublishedBodies.size(); ++ibody) {
                 if ( _vPublishedBodies[ibody].strname == name) {
                     jointValues = _vPublishedBodies[ibody].jointvalues;
@@ -1968,7 +2259,7 @@ public:
             }
         }
         else {
-            boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
+            InterfacesSharedLock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
             if (!lock.owns_lock()) {
                 throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
             }
@@ -1986,7 +2277,7 @@ public:
     void GetPublishedBodyTransformsMatchingPrefix(const std::string& prefix, std::vector<std::pair<std::string, Transform> >& nameTransfPairs, uint64_t timeout = 0)
     {
         if( timeout == 0 ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesSharedLock lock(_mutexInterfaces);
             nameTransfPairs.resize(0);
             if( nameTransfPairs.capacity() < _vPublishedBodies.size() ) {
                 nameTransfPairs.reserve(_vPublishedBodies.size());
@@ -1998,7 +2289,7 @@ public:
             }
         }
         else {
-            boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
+            InterfacesSharedLock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
             if (!lock.owns_lock()) {
                 throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
             }
@@ -2017,13 +2308,13 @@ public:
 
     virtual void UpdatePublishedBodies(uint64_t timeout=0)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         if( timeout == 0 ) {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             _UpdatePublishedBodies();
         }
         else {
-            boost::timed_mutex::scoped_timed_lock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
+            InterfacesLock lock(_mutexInterfaces, boost::get_system_time() + boost::posix_time::microseconds(timeout));
             if (!lock.owns_lock()) {
                 throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
             }
@@ -2113,6 +2404,7 @@ protected:
         if( !!_pCurrentChecker ) {
             _pCurrentChecker->RemoveKinBody(*it);
         }
+        _ClearConcurrentQueryCheckers();
         if( !!_pPhysicsEngine ) {
             _pPhysicsEngine->RemoveKinBody(*it);
         }
@@ -2135,13 +2427,13 @@ protected:
 
     virtual bool _ParseXMLFile(BaseXMLReaderPtr preader, const std::string& filename)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         return OpenRAVEXMLParser::ParseXMLFile(preader, filename);
     }
 
     virtual bool _ParseXMLData(BaseXMLReaderPtr preader, const std::string& pdata)
     {
-        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        EnvironmentLock lockenv(*this);
         return OpenRAVEXMLParser::ParseXMLData(preader, pdata);
     }
 
@@ -2173,7 +2465,7 @@ protected:
         if( !bCheckSharedResources || !(options & Clone_Bodies) ) {
             {
                 // clear internal interface lists
-                boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+                InterfacesLock lock(_mutexInterfaces);
                 // release all grabbed
                 FOREACH(itrobot,_vecbodies) {
                     (*itrobot)->ReleaseAllGrabbed();
@@ -2201,7 +2493,7 @@ protected:
         list<ViewerBasePtr> listViewers = _listViewers;
         list< pair<ModuleBasePtr, std::string> > listModules = _listModules;
         {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesLock lock(_mutexInterfaces);
             _listViewers.clear();
             _listModules.clear();
         }
@@ -2260,15 +2552,31 @@ protected:
         }
 
         if( options & Clone_Bodies ) {
-            boost::timed_mutex::scoped_lock lock(r->_mutexInterfaces);
+            InterfacesSharedLock lock(r->_mutexInterfaces);
             std::vector<RobotBasePtr> vecrobots;
             std::vector<KinBodyPtr> vecbodies;
             std::vector<std::pair<Vector,Vector> > linkvelocities;
+            // the existing bodies indexed by name, so that matching them to the reference bodies does not need a scan per body
+            std::unordered_map<std::string, RobotBasePtr> mapNameRobots;
+            std::unordered_map<std::string, KinBodyPtr> mapNameBodies;
             _mapBodies.clear();
             if( bCheckSharedResources ) {
                 // delete any bodies/robots from mapBodies that are not in r->_vecrobots and r->_vecbodies
                 vecrobots.swap(_vecrobots);
                 vecbodies.swap(_vecbodies);
+                mapNameRobots.reserve(vecrobots.size());
+                FOREACH(itrobot2, vecrobots) {
+                    mapNameRobots[(*itrobot2)->GetName()] = *itrobot2;
+                }
+                mapNameBodies.reserve(vecbodies.size());
+                FOREACH(itbody2, vecbodies) {
+                    if( !(*itbody2) ) {
+                        RAVELOG_WARN_FORMAT("env=%d, a body in vecbodies is not initialized", GetId());
+                    }
+                    else if( !(*itbody2)->IsRobot() ) {
+                        mapNameBodies[(*itbody2)->GetName()] = *itbody2;
+                    }
+                }
             }
             // first initialize the pointers
             list<KinBodyPtr> listToClone, listToCopyState;
@@ -2276,11 +2584,10 @@ protected:
                 try {
                     RobotBasePtr pnewrobot;
                     if( bCheckSharedResources ) {
-                        FOREACH(itrobot2,vecrobots) {
-                            if( (*itrobot2)->GetName() == (*itrobot)->GetName() && (*itrobot2)->GetKinematicsGeometryHash() == (*itrobot)->GetKinematicsGeometryHash() ) {
-                                pnewrobot = *itrobot2;
-                                break;
-                            }
+                        std::unordered_map<std::string, RobotBasePtr>::iterator itrobot2 = mapNameRobots.find((*itrobot)->GetName());
+                        if( itrobot2 != mapNameRobots.end() && itrobot2->second->GetKinematicsGeometryHash() == (*itrobot)->GetKinematicsGeometryHash() ) {
+                            pnewrobot = itrobot2->second;
+                            mapNameRobots.erase(itrobot2);
                         }
                     }
                     if( !pnewrobot ) {
@@ -2310,16 +2617,10 @@ protected:
                 try {
                     KinBodyPtr pnewbody;
                     if( bCheckSharedResources ) {
-                        FOREACH(itbody2,vecbodies) {
-                            if( !(*itbody2) ) {
-                                RAVELOG_WARN_FORMAT("env=%d, a body in vecbodies is not initialized", GetId());
-                            }
-                            else {
-                                if( (*itbody2)->GetName() == (*itbody)->GetName() && (*itbody2)->GetKinematicsGeometryHash() == (*itbody)->GetKinematicsGeometryHash() ) {
-                                    pnewbody = *itbody2;
-                                    break;
-                                }
-                            }
+                        std::unordered_map<std::string, KinBodyPtr>::iterator itbody2 = mapNameBodies.find((*itbody)->GetName());
+                        if( itbody2 != mapNameBodies.end() && itbody2->second->GetKinematicsGeometryHash() == (*itbody)->GetKinematicsGeometryHash() ) {
+                            pnewbody = itbody2->second;
+                            mapNameBodies.erase(itbody2);
                         }
                     }
                     if( !pnewbody ) {
@@ -2417,7 +2718,7 @@ protected:
             }
         }
         if( options & Clone_Sensors ) {
-            boost::timed_mutex::scoped_lock lock(r->_mutexInterfaces);
+            InterfacesSharedLock lock(r->_mutexInterfaces);
             FOREACHC(itsensor,r->_listSensors) {
                 try {
                     SensorBasePtr pnewsensor = RaveCreateSensor(shared_from_this(), (*itsensor)->GetXMLId());
@@ -2665,12 +2966,130 @@ protected:
         }
     }
 
+    /// \brief records that a thread waited waittime microseconds for the environment mutex
+    void _AddLockContention(uint64_t waittime) const
+    {
+        boost::mutex::scoped_lock lock(_mutexLockStatistics);
+        _lockstatistics.numcontended++;
+        _lockstatistics.waittime += waittime;
+        _lockstatistics.maxwaittime = max(_lockstatistics.maxwaittime, waittime);
+    }
+
+    /// \brief true if the calling thread holds a ConcurrentQueriesWriteLock
+    bool _IsConcurrentQueriesWriter() const
+    {
+        return !!_pconcurrentquerieswriter.get();
+    }
+
+    /// \brief blocks the concurrent queries for the calling thread without allocating
+    ///
+    /// \return true if _UnlockConcurrentQueriesWrite has to be called, false if concurrent queries are disabled or the thread already blocks them
+    bool _LockConcurrentQueriesWrite() const
+    {
+        if( !_bConcurrentQueries || _IsConcurrentQueriesWriter() ) {
+            return false;
+        }
+        static bool s_bWriter = true;
+        _mutexQueries.lock();
+        _pconcurrentquerieswriter.reset(&s_bWriter);
+        return true;
+    }
+
+    void _UnlockConcurrentQueriesWrite() const
+    {
+        _pconcurrentquerieswriter.reset();
+        _mutexQueries.unlock();
+    }
+
+    /// \brief _pconcurrentquerieswriter points to a static flag, so there is nothing to delete
+    static void _NoCleanupConcurrentQueriesWriter(bool*)
+    {
+    }
+
+    /// \brief returns a token that lives as long as the calling thread, used to tell which concurrent query checkers belong to exited threads
+    static boost::shared_ptr<int> _GetThreadToken()
+    {
+        static boost::thread_specific_ptr< boost::shared_ptr<int> > s_threadtoken; // never destroyed before the threads exit
+        if( !s_threadtoken.get() ) {
+            s_threadtoken.reset(new boost::shared_ptr<int>(new int(0)));
+        }
+        return *s_threadtoken;
+    }
+
+    /// \brief returns the checker of the calling thread for concurrent queries, empty if it has not been created yet. _mutexQueries has to be locked.
+    CollisionCheckerBasePtr _GetConcurrentQueryChecker() const
+    {
+        boost::shared_ptr<int> threadtoken = _GetThreadToken();
+        boost::mutex::scoped_lock lock(_mutexConcurrentQueryCheckers);
+        std::map<boost::thread::id, ConcurrentQueryChecker>::const_iterator it = _mapConcurrentQueryCheckers.find(boost::this_thread::get_id());
+        // the id can be reused by a new thread after the thread that created the checker exited
+        if( it == _mapConcurrentQueryCheckers.end() || it->second.threadtoken.lock() != threadtoken ) {
+            return CollisionCheckerBasePtr();
+        }
+        return it->second.pchecker;
+    }
+
+    /// \brief creates the checker of the calling thread for concurrent queries from the environment checker. _mutexQueries should not be locked.
+    void _CreateConcurrentQueryChecker()
+    {
+        EnvironmentLock lockenv(*this); // no writer can run and the mode cannot change
+        if( !_bConcurrentQueries || !!_GetConcurrentQueryChecker() ) {
+            return;
+        }
+        CollisionCheckerBasePtr pchecker = RaveCreateCollisionChecker(shared_from_this(), _pCurrentChecker->GetXMLId());
+        if( !pchecker ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("env=%d, failed to create collision checker %s for concurrent queries"), GetId()%_pCurrentChecker->GetXMLId(), ORE_InvalidState);
+        }
+        pchecker->Clone(_pCurrentChecker, 0);
+        pchecker->InitEnvironment();
+        RAVELOG_VERBOSE_FORMAT("env=%d, created %s checker for concurrent queries", GetId()%pchecker->GetXMLId());
+        std::vector<CollisionCheckerBasePtr> vexitedcheckers;
+        {
+            boost::mutex::scoped_lock lock(_mutexConcurrentQueryCheckers);
+            // the checkers of exited threads are not used by any query, so they can be destroyed while other queries run
+            std::map<boost::thread::id, ConcurrentQueryChecker>::iterator it = _mapConcurrentQueryCheckers.begin();
+            while(it != _mapConcurrentQueryCheckers.end()) {
+                if( it->second.threadtoken.expired() ) {
+                    vexitedcheckers.push_back(it->second.pchecker);
+                    _mapConcurrentQueryCheckers.erase(it++);
+                }
+                else {
+                    ++it;
+                }
+            }
+            ConcurrentQueryChecker& querychecker = _mapConcurrentQueryCheckers[boost::this_thread::get_id()];
+            if( !!querychecker.pchecker ) {
+                vexitedcheckers.push_back(querychecker.pchecker); // the checker of an exited thread whose id is reused
+            }
+            querychecker.pchecker = pchecker;
+            querychecker.threadtoken = _GetThreadToken();
+        }
+        FOREACH(itchecker, vexitedcheckers) {
+            (*itchecker)->DestroyEnvironment();
+        }
+    }
+
+    /// \brief destroys the checkers of the concurrent queries, they are created again with the next query.
+    ///
+    /// Called when the bodies or the environment checker change. The concurrent queries have to be blocked with ConcurrentQueriesWriteLock.
+    void _ClearConcurrentQueryCheckers()
+    {
+        std::map<boost::thread::id, ConcurrentQueryChecker> mapcheckers;
+        {
+            boost::mutex::scoped_lock lock(_mutexConcurrentQueryCheckers);
+            mapcheckers.swap(_mapConcurrentQueryCheckers);
+        }
+        FOREACH(itchecker, mapcheckers) {
+            itchecker->second.pchecker->DestroyEnvironment();
+        }
+    }
+
     /// _mutexInterfaces should not be locked
     void _CallBodyCallbacks(KinBodyPtr pbody, int action)
     {
         std::list<UserDataWeakPtr> listRegisteredBodyCallbacks;
         {
-            boost::timed_mutex::scoped_lock lock(_mutexInterfaces);
+            InterfacesSharedLock lock(_mutexInterfaces);
             listRegisteredBodyCallbacks = _listRegisteredBodyCallbacks;
         }
         FOREACH(it, listRegisteredBodyCallbacks) {
@@ -2811,8 +3230,14 @@ protected:
 
     mutable EnvironmentMutex _mutexEnvironment;          ///< protects internal data from multithreading issues
     mutable boost::mutex _mutexEnvironmentIds;      ///< protects _vecbodies/_vecrobots from multithreading issues
-    mutable boost::timed_mutex _mutexInterfaces;     ///< lock when managing interfaces like _listOwnedInterfaces, _listModules, _mapBodies
+    mutable InterfacesMutex _mutexInterfaces;     ///< lock when managing interfaces like _listOwnedInterfaces, _listModules, _mapBodies. Readers take a shared lock.
     mutable boost::mutex _mutexInit;     ///< lock for destroying the environment
+    mutable boost::shared_mutex _mutexQueries; ///< shared by the collision queries when _bConcurrentQueries is set, exclusively locked when toggling it and by ConcurrentQueriesWriteLock
+    mutable boost::thread_specific_ptr<bool> _pconcurrentquerieswriter; ///< set in the thread that holds a ConcurrentQueriesWriteLock, points to a static flag
+    mutable boost::mutex _mutexConcurrentQueryCheckers; ///< protects _mapConcurrentQueryCheckers
+    std::map<boost::thread::id, ConcurrentQueryChecker> _mapConcurrentQueryCheckers; ///< the checker of every thread that ran a concurrent query, see _CreateConcurrentQueryChecker
+    mutable boost::mutex _mutexLockStatistics; ///< protects _lockstatistics
+    mutable LockStatistics _lockstatistics; ///< contention of the environment mutex inside the environment calls
 
     vector<KinBody::BodyState> _vPublishedBodies;
     string _homedirectory;
@@ -2829,6 +3254,7 @@ protected:
     bool _bEnableSimulation;            ///< enable simulation loop
     bool _bShutdownSimulation; ///< if true, the simulation thread should shutdown
     bool _bRealTime;
+    std::atomic<bool> _bConcurrentQueries; ///< if true, the collision queries only take a shared lock on _mutexQueries, see SetConcurrentQueries
 
     friend class EnvironmentXMLReader;
 };
@@ -18,6 +18,8 @@
 #include <boost/lambda/lambda.hpp>
 #include <boost/lexical_cast.hpp>
 #include <openrave/xmlreaders.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 namespace OpenRAVE {
 
@@ -25,6 +27,37 @@ namespace OpenRAVE {
 static const uint16_t MAGIC_NUMBER = 0x62ff;
 static const uint16_t BINARY_TRAJECTORY_VERSION_NUMBER = 0x0003;  // Version number for serialization
 
+// Columnar binary trajectory files, can be memory mapped
+static const uint16_t COLUMNAR_MAGIC_NUMBER = 0x63ff;
+static const uint16_t COLUMNAR_TRAJECTORY_VERSION_NUMBER = 0x0001;
+static const uint64_t COLUMNAR_TRAJECTORY_ALIGNMENT = 64; ///< alignment of the data section from the start of the file
+
+/// \brief how the waypoints are stored in the data section of a columnar trajectory file
+enum ColumnarTrajectoryEncoding
+{
+    CTE_Float64 = 0, ///< float64 values, waypoint after waypoint exactly like GenericTrajectory stores them in memory, so the data can be used directly from the mapped file
+    CTE_Float32 = 1, ///< float32 values, column after column
+    CTE_Float32Delta = 2, ///< column after column, the first value of a column is float64 and the others are float32 differences to the previous value
+};
+
+/// \brief fixed size header at the start of a columnar trajectory file
+///
+/// Followed by the groups of the configuration specification and the description written like the other binary trajectories,
+/// then zeros until dataoffset.
+struct ColumnarTrajectoryHeader
+{
+    uint16_t magic; ///< COLUMNAR_MAGIC_NUMBER
+    uint16_t version; ///< COLUMNAR_TRAJECTORY_VERSION_NUMBER
+    uint16_t encoding; ///< ColumnarTrajectoryEncoding
+    uint16_t numgroups; ///< number of groups of the configuration specification
+    uint32_t dof; ///< dof of the configuration specification
+    uint32_t reserved;
+    uint64_t numpoints; ///< number of waypoints
+    uint64_t dataoffset; ///< start of the data section from the start of the file, multiple of COLUMNAR_TRAJECTORY_ALIGNMENT
+    uint64_t datasize; ///< size of the data section in bytes
+};
+BOOST_STATIC_ASSERT(sizeof(ColumnarTrajectoryHeader) == 40);
+
 static const dReal g_fEpsilonLinear = RavePow(g_fEpsilon,0.9);
 static const dReal g_fEpsilonQuadratic = RavePow(g_fEpsilon,0.45); // should be 0.6...perhaps this is related to parabolic smoother epsilons?
 
@@ -55,6 +88,14 @@ inline void WriteBinaryString(std::ostream& f, const std::string& s)
     }
 }
 
+inline void WriteBinaryData(std::ostream& f, const dReal* pdata, uint32_t numDataPoints)
+{
+    WriteBinaryUInt32(f, numDataPoints);
+    if( numDataPoints > 0 ) {
+        f.write((const char*) pdata, (uint64_t)numDataPoints*sizeof(dReal));
+    }
+}
+
 inline void WriteBinaryVector(std::ostream&f, const std::vector<dReal>& v)
 {
     // Indicate number of data points
@@ -119,7 +160,7 @@ class GenericTrajectory : public TrajectoryBase
 {
     std::map<string,int> _maporder;
 public:
-    GenericTrajectory(EnvironmentBasePtr penv, std::istream& sinput) : TrajectoryBase(penv), _timeoffset(-1)
+    GenericTrajectory(EnvironmentBasePtr penv, std::istream& sinput) : TrajectoryBase(penv), _nPolynomialCoeffs(0), _timeoffset(-1), _ptrajdata(NULL), _ntrajdata(0)
     {
         _maporder["deltatime"] = 0;
         _maporder["joint_snaps"] = 1;
@@ -135,6 +176,10 @@ public:
         _maporder["joint_torques"] = 11;
         _bInit = false;
         _bSamplingVerified = false;
+        RegisterCommand("SaveColumnarTrajectory",boost::bind(&GenericTrajectory::_SaveColumnarTrajectoryCommand,this,_1,_2),
+                        "Format: filename [encoding]\n\nwrites the trajectory to a columnar binary file. encoding is 0 for float64 (default), 1 for float32, 2 for float32 differences between consecutive waypoints. Only float64 files can be memory mapped without decoding.");
+        RegisterCommand("LoadMappedTrajectory",boost::bind(&GenericTrajectory::_LoadMappedTrajectoryCommand,this,_1,_2),
+                        "Format: filename\n\nloads a columnar binary trajectory file by memory mapping it. The waypoints of float64 files are read directly from the mapping until the trajectory is modified. Outputs 1 if the waypoints are used from the mapping, 0 if they had to be decoded.");
     }
 
     bool SortGroups(const ConfigurationSpecification::Group& g1, const ConfigurationSpecification::Group& g2)
@@ -183,7 +228,9 @@ public:
             }
             _InitializeGroupFunctions();
         }
+        _pmappedregion.reset();
         _vtrajdata.resize(0);
+        _UpdateDataPointer();
         _vaccumtime.resize(0);
         _vdeltainvtime.resize(0);
         _bChanged = true;
@@ -199,6 +246,7 @@ public:
         }
         BOOST_ASSERT(_spec.GetDOF()>0);
         OPENRAVE_ASSERT_FORMAT((data.size()%_spec.GetDOF()) == 0, "%d does not divide dof %d", data.size()%_spec.GetDOF(), ORE_InvalidArguments);
+        _CopyMappedData();
         OPENRAVE_ASSERT_OP(index*_spec.GetDOF(),<=,_vtrajdata.size());
         if( bOverwrite && index*_spec.GetDOF() < _vtrajdata.size() ) {
             size_t copysize = min(data.size(),_vtrajdata.size()-index*_spec.GetDOF());
@@ -210,6 +258,7 @@ public:
         else {
             _vtrajdata.insert(_vtrajdata.begin()+index*_spec.GetDOF(),data.begin(),data.end());
         }
+        _UpdateDataPointer();
         _bChanged = true;
     }
 
@@ -221,6 +270,7 @@ public:
         }
         BOOST_ASSERT(spec.GetDOF()>0);
         OPENRAVE_ASSERT_FORMAT((data.size()%spec.GetDOF()) == 0, "%d does not divide dof %d", data.size()%spec.GetDOF(), ORE_InvalidArguments);
+        _CopyMappedData();
         OPENRAVE_ASSERT_OP(index*_spec.GetDOF(),<=,_vtrajdata.size());
         if( _spec == spec ) {
             Insert(index,data,bOverwrite);
@@ -250,6 +300,7 @@ public:
                 _ConvertData(ittargetdata,itsourcedata,vconvertgroups,spec,numelements,true);
                 _vtrajdata.insert(_vtrajdata.begin()+index*_spec.GetDOF(),vtemp.begin(),vtemp.end());
             }
+            _UpdateDataPointer();
             _bChanged = true;
         }
     }
@@ -260,9 +311,11 @@ public:
         if( startindex == endindex ) {
             return;
         }
+        _CopyMappedData();
         BOOST_ASSERT(startindex*_spec.GetDOF() <= _vtrajdata.size() && endindex*_spec.GetDOF() <= _vtrajdata.size());
         OPENRAVE_ASSERT_OP(startindex,<,endindex);
         _vtrajdata.erase(_vtrajdata.begin()+startindex*_spec.GetDOF(),_vtrajdata.begin()+endindex*_spec.GetDOF());
+        _UpdateDataPointer();
         _bChanged = true;
     }
 
@@ -272,25 +325,25 @@ public:
         BOOST_ASSERT(_timeoffset>=0);
         BOOST_ASSERT(time >= 0);
         _ComputeInternal();
-        OPENRAVE_ASSERT_OP_FORMAT0((int)_vtrajdata.size(),>=,_spec.GetDOF(), "trajectory needs at least one point to sample from", ORE_InvalidArguments);
+        OPENRAVE_ASSERT_OP_FORMAT0((int)_ntrajdata,>=,_spec.GetDOF(), "trajectory needs at least one point to sample from", ORE_InvalidArguments);
         if( IS_DEBUGLEVEL(Level_Verbose) || (RaveGetDebugLevel() & Level_VerifyPlans) ) {
             _VerifySampling();
         }
         data.resize(0);
         data.resize(_spec.GetDOF(),0);
         if( time >= GetDuration() ) {
-            std::copy(_vtrajdata.end()-_spec.GetDOF(),_vtrajdata.end(),data.begin());
+            std::copy(_ptrajdata+_ntrajdata-_spec.GetDOF(),_ptrajdata+_ntrajdata,data.begin());
         }
         else {
             std::vector<dReal>::iterator it = std::lower_bound(_vaccumtime.begin(),_vaccumtime.end(),time);
             if( it == _vaccumtime.begin() ) {
-                std::copy(_vtrajdata.begin(),_vtrajdata.begin()+_spec.GetDOF(),data.begin());
+                std::copy(_ptrajdata,_ptrajdata+_spec.GetDOF(),data.begin());
                 data.at(_timeoffset) = time;
             }
             else {
                 size_t index = it-_vaccumtime.begin();
                 dReal deltatime = time-_vaccumtime.at(index-1);
-                dReal waypointdeltatime = _vtrajdata.at(_spec.GetDOF()*index + _timeoffset);
+                dReal waypointdeltatime = _ptrajdata[_spec.GetDOF()*index + _timeoffset];
                 // unfortunately due to floating-point error deltatime might not be in the range [0, waypointdeltatime], so double check!
                 if( deltatime < 0 ) {
                     // most likely small epsilon
@@ -301,7 +354,7 @@ public:
                 }
                 for(size_t i = 0; i < _vgroupinterpolators.size(); ++i) {
                     if( !!_vgroupinterpolators[i] ) {
-                        _vgroupinterpolators[i](index-1,deltatime,data);
+                        _vgroupinterpolators[i](index-1,deltatime,&data[0]);
                     }
                 }
                 // should return the sample time relative to the last endpoint so it is easier to re-insert in the trajectory
@@ -316,7 +369,7 @@ public:
         OPENRAVE_ASSERT_OP(_timeoffset,>=,0);
         OPENRAVE_ASSERT_OP(time, >=, -g_fEpsilon);
         _ComputeInternal();
-        OPENRAVE_ASSERT_OP_FORMAT0((int)_vtrajdata.size(),>=,_spec.GetDOF(), "trajectory needs at least one point to sample from", ORE_InvalidArguments);
+        OPENRAVE_ASSERT_OP_FORMAT0((int)_ntrajdata,>=,_spec.GetDOF(), "trajectory needs at least one point to sample from", ORE_InvalidArguments);
         if( IS_DEBUGLEVEL(Level_Verbose) || (RaveGetDebugLevel() & Level_VerifyPlans) ) {
             _VerifySampling();
         }
@@ -325,19 +378,21 @@ public:
         }
         data.resize(spec.GetDOF(),0);
         if( time >= GetDuration() ) {
-            ConfigurationSpecification::ConvertData(data.begin(),spec,_vtrajdata.end()-_spec.GetDOF(),_spec,1,GetEnv());
+            vector<dReal> vinternaldata(_ptrajdata+_ntrajdata-_spec.GetDOF(),_ptrajdata+_ntrajdata);
+            ConfigurationSpecification::ConvertData(data.begin(),spec,vinternaldata.begin(),_spec,1,GetEnv());
         }
         else {
             std::vector<dReal>::iterator it = std::lower_bound(_vaccumtime.begin(),_vaccumtime.end(),time);
             if( it == _vaccumtime.begin() ) {
-                ConfigurationSpecification::ConvertData(data.begin(),spec,_vtrajdata.begin(),_spec,1,GetEnv());
+                vector<dReal> vinternaldata(_ptrajdata,_ptrajdata+_spec.GetDOF());
+                ConfigurationSpecification::ConvertData(data.begin(),spec,vinternaldata.begin(),_spec,1,GetEnv());
             }
             else {
                 // could be faster
                 vector<dReal> vinternaldata(_spec.GetDOF(),0);
                 size_t index = it-_vaccumtime.begin();
                 dReal deltatime = time-_vaccumtime.at(index-1);
-                dReal waypointdeltatime = _vtrajdata.at(_spec.GetDOF()*index + _timeoffset);
+                dReal waypointdeltatime = _ptrajdata[_spec.GetDOF()*index + _timeoffset];
                 // unfortunately due to floating-point error deltatime might not be in the range [0, waypointdeltatime], so double check!
                 if( deltatime < 0 ) {
                     // most likely small epsilon
@@ -348,7 +403,7 @@ public:
                 }
                 for(size_t i = 0; i < _vgroupinterpolators.size(); ++i) {
                     if( !!_vgroupinterpolators[i] ) {
-                        _vgroupinterpolators[i](index-1,deltatime,vinternaldata);
+                        _vgroupinterpolators[i](index-1,deltatime,&vinternaldata[0]);
                     }
                 }
                 ConfigurationSpecification::ConvertData(data.begin(),spec,vinternaldata.begin(),_spec,1,GetEnv());
@@ -356,6 +411,56 @@ public:
         }
     }
 
+    void SamplePoints(std::vector<dReal>& data, const std::vector<dReal>& times) const
+    {
+        data.resize(0);
+        data.resize(_spec.GetDOF()*times.size(),0);
+        if( times.size() > 0 ) {
+            _SamplePoints(&data[0], times.size(), &times[0], 0, 0);
+        }
+    }
+
+    void SamplePoints(std::vector<dReal>& data, const std::vector<dReal>& times, const ConfigurationSpecification& spec) const
+    {
+        if( spec == _spec ) {
+            SamplePoints(data, times);
+            return;
+        }
+        std::vector<dReal> vinternaldata(_spec.GetDOF()*times.size(),0);
+        data.resize(0);
+        data.resize(spec.GetDOF()*times.size(),0);
+        if( times.size() > 0 ) {
+            _SamplePoints(&vinternaldata[0], times.size(), &times[0], 0, 0);
+            ConfigurationSpecification::ConvertData(data.begin(),spec,vinternaldata.begin(),_spec,times.size(),GetEnv());
+        }
+    }
+
+    void SampleRange(std::vector<dReal>& data, dReal tstart, dReal tend, dReal deltatime) const
+    {
+        size_t numtimes = _GetNumRangeSamples(tstart, tend, deltatime);
+        data.resize(0);
+        data.resize(_spec.GetDOF()*numtimes,0);
+        if( numtimes > 0 ) {
+            _SamplePoints(&data[0], numtimes, NULL, tstart, deltatime);
+        }
+    }
+
+    void SampleRange(std::vector<dReal>& data, dReal tstart, dReal tend, dReal deltatime, const ConfigurationSpecification& spec) const
+    {
+        if( spec == _spec ) {
+            SampleRange(data, tstart, tend, deltatime);
+            return;
+        }
+        size_t numtimes = _GetNumRangeSamples(tstart, tend, deltatime);
+        std::vector<dReal> vinternaldata(_spec.GetDOF()*numtimes,0);
+        data.resize(0);
+        data.resize(spec.GetDOF()*numtimes,0);
+        if( numtimes > 0 ) {
+            _SamplePoints(&vinternaldata[0], numtimes, NULL, tstart, deltatime);
+            ConfigurationSpecification::ConvertData(data.begin(),spec,vinternaldata.begin(),_spec,numtimes,GetEnv());
+        }
+    }
+
     const ConfigurationSpecification& GetConfigurationSpecification() const
     {
         return _spec;
@@ -364,24 +469,31 @@ public:
     size_t GetNumWaypoints() const
     {
         BOOST_ASSERT(_bInit);
-        return _vtrajdata.size()/_spec.GetDOF();
+        return _ntrajdata/_spec.GetDOF();
     }
 
     void GetWaypoints(size_t startindex, size_t endindex, std::vector<dReal>& data) const
     {
         BOOST_ASSERT(_bInit);
-        BOOST_ASSERT(startindex<=endindex && startindex*_spec.GetDOF() <= _vtrajdata.size() && endindex*_spec.GetDOF() <= _vtrajdata.size());
+        BOOST_ASSERT(startindex<=endindex && startindex*_spec.GetDOF() <= _ntrajdata && endindex*_spec.GetDOF() <= _ntrajdata);
         data.resize((endindex-startindex)*_spec.GetDOF(),0);
-        std::copy(_vtrajdata.begin()+startindex*_spec.GetDOF(),_vtrajdata.begin()+endindex*_spec.GetDOF(),data.begin());
+        std::copy(_ptrajdata+startindex*_spec.GetDOF(),_ptrajdata+endindex*_spec.GetDOF(),data.begin());
     }
 
     void GetWaypoints(size_t startindex, size_t endindex, std::vector<dReal>& data, const ConfigurationSpecification& spec) const
     {
         BOOST_ASSERT(_bInit);
-        BOOST_ASSERT(startindex<=endindex && startindex*_spec.GetDOF() <= _vtrajdata.size() && endindex*_spec.GetDOF() <= _vtrajdata.size());
+        BOOST_ASSERT(startindex<=endindex && startindex*_spec.GetDOF() <= _ntrajdata && endindex*_spec.GetDOF() <= _ntrajdata);
         data.resize(spec.GetDOF()*(endindex-startindex),0);
         if( startindex < endindex ) {
-            ConfigurationSpecification::ConvertData(data.begin(),spec,_vtrajdata.begin()+startindex*_spec.GetDOF(),_spec,endindex-startindex,GetEnv());
+            if( !!_pmappedregion ) {
+                // conversion needs vector iterators
+                std::vector<dReal> vinternaldata(_ptrajdata+startindex*_spec.GetDOF(),_ptrajdata+endindex*_spec.GetDOF());
+                ConfigurationSpecification::ConvertData(data.begin(),spec,vinternaldata.begin(),_spec,endindex-startindex,GetEnv());
+            }
+            else {
+                ConfigurationSpecification::ConvertData(data.begin(),spec,_vtrajdata.begin()+startindex*_spec.GetDOF(),_spec,endindex-startindex,GetEnv());
+            }
         }
     }
 
@@ -439,7 +551,7 @@ public:
             }
 
             /* Store data waypoints */
-            WriteBinaryVector(O, this->_vtrajdata);
+            WriteBinaryData(O, _ptrajdata, _ntrajdata);
 
             WriteBinaryString(O, GetDescription());
 
@@ -512,6 +624,7 @@ public:
 
             /* Read trajectory data */
             ReadBinaryVector(I, this->_vtrajdata);
+            _UpdateDataPointer();
             ReadBinaryString(I, __description);
 
             // clear out existing readable interfaces
@@ -565,6 +678,38 @@ public:
                 }
             }
         }
+        else if( binaryFileHeader == COLUMNAR_MAGIC_NUMBER ) {
+            ColumnarTrajectoryHeader header;
+            header.magic = binaryFileHeader;
+            I.read((char*)&header + sizeof(header.magic), sizeof(header) - sizeof(header.magic));
+            if( !I ) {
+                throw OPENRAVE_EXCEPTION_FORMAT0(_("cannot read columnar trajectory header"),ORE_InvalidArguments);
+            }
+            uint64_t metadatasize = _ReadColumnarMetadata(I, header);
+            // the stream length is only known when it can seek, otherwise a truncated stream fails when reading
+            std::streampos posdata = I.tellg();
+            if( posdata != std::streampos(-1) ) {
+                I.seekg(0, std::ios::end);
+                std::streampos posend = I.tellg();
+                I.seekg(posdata);
+                if( posend != std::streampos(-1) ) {
+                    _ValidateColumnarDataRange(header, metadatasize + (uint64_t)(posend - posdata));
+                }
+            }
+            // skip the padding up to the data section
+            std::vector<char> vbuffer(header.dataoffset - metadatasize);
+            if( vbuffer.size() > 0 ) {
+                I.read(&vbuffer[0], vbuffer.size());
+            }
+            vbuffer.resize(header.datasize);
+            if( vbuffer.size() > 0 ) {
+                I.read(&vbuffer[0], vbuffer.size());
+            }
+            if( !I ) {
+                throw OPENRAVE_EXCEPTION_FORMAT0(_("columnar trajectory data is truncated"),ORE_InvalidArguments);
+            }
+            _DecodeColumnarData(vbuffer.size() > 0 ? &vbuffer[0] : NULL, header);
+        }
         else {
             // try XML deserialization
             I.seekg((size_t) pos);                  // Reset to initial positoin
@@ -578,6 +723,7 @@ public:
         TrajectoryBaseConstPtr r = RaveInterfaceConstCast<TrajectoryBase>(preference);
         Init(r->GetConfigurationSpecification());
         r->GetWaypoints(0,r->GetNumWaypoints(),_vtrajdata);
+        _UpdateDataPointer();
         _bChanged = true;
     }
 
@@ -593,6 +739,9 @@ public:
         std::swap(_timeoffset, traj->_timeoffset);
         std::swap(_bInit, traj->_bInit);
         std::swap(_vtrajdata, traj->_vtrajdata);
+        std::swap(_ptrajdata, traj->_ptrajdata);
+        std::swap(_ntrajdata, traj->_ntrajdata);
+        std::swap(_pmappedregion, traj->_pmappedregion);
         std::swap(_vaccumtime, traj->_vaccumtime);
         std::swap(_vdeltainvtime, traj->_vdeltainvtime);
         std::swap(_bChanged, traj->_bChanged);
@@ -601,6 +750,256 @@ public:
     }
 
 protected:
+    /// \brief points _ptrajdata to _vtrajdata, has to be called every time _vtrajdata changes when it is not mapped
+    inline void _UpdateDataPointer()
+    {
+        if( !_pmappedregion ) {
+            _ptrajdata = _vtrajdata.size() > 0 ? &_vtrajdata[0] : NULL;
+            _ntrajdata = _vtrajdata.size();
+        }
+    }
+
+    /// \brief if the waypoints are read from a mapped file, copies them to _vtrajdata so that they can be modified
+    void _CopyMappedData()
+    {
+        if( !!_pmappedregion ) {
+            _vtrajdata.assign(_ptrajdata, _ptrajdata+_ntrajdata);
+            _pmappedregion.reset();
+            _UpdateDataPointer();
+        }
+    }
+
+    /// \brief returns the number of bytes of the header and metadata of a columnar file before the padding
+    uint64_t _GetColumnarMetadataSize() const
+    {
+        uint64_t metadatasize = sizeof(ColumnarTrajectoryHeader);
+        FOREACHC(itgroup, _spec._vgroups) {
+            metadatasize += sizeof(uint16_t) + itgroup->name.size() + 2*sizeof(int) + sizeof(uint16_t) + itgroup->interpolation.size();
+        }
+        metadatasize += sizeof(uint16_t) + GetDescription().size();
+        return metadatasize;
+    }
+
+    static uint64_t _GetColumnarDataSize(int encoding, uint64_t numpoints, uint64_t dof)
+    {
+        // a corrupted header can have sizes whose product overflows
+        if( dof > 0 && numpoints > std::numeric_limits<uint64_t>::max()/(dof*sizeof(double)) ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("columnar trajectory with %d points of dof %d is too big"),numpoints%dof,ORE_InvalidArguments);
+        }
+        switch(encoding) {
+        case CTE_Float64: return numpoints*dof*sizeof(double);
+        case CTE_Float32: return numpoints*dof*sizeof(float);
+        case CTE_Float32Delta: return numpoints > 0 ? dof*(sizeof(double) + (numpoints-1)*sizeof(float)) : 0;
+        }
+        throw OPENRAVE_EXCEPTION_FORMAT(_("unsupported columnar trajectory encoding %d"),encoding,ORE_InvalidArguments);
+    }
+
+    void _WriteColumnar(std::ostream& O, int encoding) const
+    {
+        const size_t dof = _spec.GetDOF();
+        ColumnarTrajectoryHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = COLUMNAR_MAGIC_NUMBER;
+        header.version = COLUMNAR_TRAJECTORY_VERSION_NUMBER;
+        header.encoding = encoding;
+        header.numgroups = _spec._vgroups.size();
+        header.dof = dof;
+        header.numpoints = dof > 0 ? _ntrajdata/dof : 0;
+        uint64_t metadatasize = _GetColumnarMetadataSize();
+        header.dataoffset = ((metadatasize+COLUMNAR_TRAJECTORY_ALIGNMENT-1)/COLUMNAR_TRAJECTORY_ALIGNMENT)*COLUMNAR_TRAJECTORY_ALIGNMENT;
+        header.datasize = _GetColumnarDataSize(encoding, header.numpoints, dof);
+        O.write((const char*)&header, sizeof(header));
+        FOREACHC(itgroup, _spec._vgroups) {
+            WriteBinaryString(O, itgroup->name);
+            WriteBinaryInt(O, itgroup->offset);
+            WriteBinaryInt(O, itgroup->dof);
+            WriteBinaryString(O, itgroup->interpolation);
+        }
+        WriteBinaryString(O, GetDescription());
+        std::vector<char> vpadding(header.dataoffset-metadatasize, 0);
+        if( vpadding.size() > 0 ) {
+            O.write(&vpadding[0], vpadding.size());
+        }
+
+        if( encoding == CTE_Float64 ) {
+            if( sizeof(dReal) == sizeof(double) ) {
+                O.write((const char*)_ptrajdata, header.datasize);
+            }
+            else if( header.datasize > 0 ) {
+                std::vector<double> vdata(_ptrajdata, _ptrajdata+_ntrajdata);
+                O.write((const char*)&vdata[0], header.datasize);
+            }
+        }
+        else if( header.numpoints > 0 ) {
+            std::vector<float> vcolumn(header.numpoints);
+            for(size_t icolumn = 0; icolumn < dof; ++icolumn) {
+                if( encoding == CTE_Float32 ) {
+                    for(size_t ipoint = 0; ipoint < header.numpoints; ++ipoint) {
+                        vcolumn[ipoint] = _ptrajdata[ipoint*dof+icolumn];
+                    }
+                    O.write((const char*)&vcolumn[0], header.numpoints*sizeof(float));
+                }
+                else {
+                    // differences are taken from the decoded values so that the rounding errors do not accumulate
+                    double fvalue = _ptrajdata[icolumn];
+                    O.write((const char*)&fvalue, sizeof(fvalue));
+                    for(size_t ipoint = 1; ipoint < header.numpoints; ++ipoint) {
+                        vcolumn[ipoint-1] = (float)(_ptrajdata[ipoint*dof+icolumn] - fvalue);
+                        fvalue += vcolumn[ipoint-1];
+                    }
+                    if( header.numpoints > 1 ) {
+                        O.write((const char*)&vcolumn[0], (header.numpoints-1)*sizeof(float));
+                    }
+                }
+            }
+        }
+    }
+
+    /// \brief reads the configuration specification and description following the header and initializes the trajectory with them
+    ///
+    /// \return the number of bytes of the header and metadata
+    uint64_t _ReadColumnarMetadata(std::istream& I, const ColumnarTrajectoryHeader& header)
+    {
+        if( header.version > COLUMNAR_TRAJECTORY_VERSION_NUMBER || header.version < 0x0001 ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("unsupported columnar trajectory format version %d "),header.version,ORE_InvalidArguments);
+        }
+        _bInit = false;
+        _spec._vgroups.resize(header.numgroups);
+        FOREACH(itgroup, _spec._vgroups) {
+            ReadBinaryString(I, itgroup->name);
+            ReadBinaryInt(I, itgroup->offset);
+            ReadBinaryInt(I, itgroup->dof);
+            ReadBinaryString(I, itgroup->interpolation);
+        }
+        ReadBinaryString(I, __description);
+        if( !I ) {
+            throw OPENRAVE_EXCEPTION_FORMAT0(_("columnar trajectory metadata is truncated"),ORE_InvalidArguments);
+        }
+        // GetWaypoints and the interpolators index the waypoints with the group offsets
+        FOREACHC(itgroup, _spec._vgroups) {
+            if( itgroup->offset < 0 || itgroup->dof < 0 || (uint64_t)itgroup->offset + (uint64_t)itgroup->dof > header.dof ) {
+                throw OPENRAVE_EXCEPTION_FORMAT(_("columnar trajectory group %s is outside of dof %d"),itgroup->name%header.dof,ORE_InvalidArguments);
+            }
+        }
+        Init(_spec);
+        if( _spec.GetDOF() != (int)header.dof || header.datasize != _GetColumnarDataSize(header.encoding, header.numpoints, header.dof) ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("columnar trajectory dof %d or data size %d is inconsistent"),header.dof%header.datasize,ORE_InvalidArguments);
+        }
+        uint64_t metadatasize = _GetColumnarMetadataSize();
+        if( header.dataoffset < metadatasize || header.dataoffset - metadatasize >= COLUMNAR_TRAJECTORY_ALIGNMENT || (header.dataoffset % COLUMNAR_TRAJECTORY_ALIGNMENT) != 0 ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("columnar trajectory data offset %d does not follow the metadata"),header.dataoffset,ORE_InvalidArguments);
+        }
+        return metadatasize;
+    }
+
+    /// \brief throws if the data section does not fit in the first filesize bytes of the file, written so that corrupted offsets cannot overflow
+    static void _ValidateColumnarDataRange(const ColumnarTrajectoryHeader& header, uint64_t filesize)
+    {
+        if( header.dataoffset > filesize || header.datasize > filesize - header.dataoffset ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("columnar trajectory data at %d of size %d is past the end of the file of size %d"),header.dataoffset%header.datasize%filesize,ORE_InvalidArguments);
+        }
+    }
+
+    /// \brief decodes the data section of a columnar file into _vtrajdata, assumes _ReadColumnarMetadata has been called
+    void _DecodeColumnarData(const char* pdata, const ColumnarTrajectoryHeader& header)
+    {
+        const size_t dof = header.dof, numpoints = header.numpoints;
+        _vtrajdata.resize(numpoints*dof);
+        if( numpoints > 0 ) {
+            if( header.encoding == CTE_Float64 ) {
+                const double* pvalues = (const double*)pdata;
+                std::copy(pvalues, pvalues+numpoints*dof, _vtrajdata.begin());
+            }
+            else {
+                for(size_t icolumn = 0; icolumn < dof; ++icolumn) {
+                    if( header.encoding == CTE_Float32 ) {
+                        const float* pcolumn = (const float*)pdata + icolumn*numpoints;
+                        for(size_t ipoint = 0; ipoint < numpoints; ++ipoint) {
+                            _vtrajdata[ipoint*dof+icolumn] = pcolumn[ipoint];
+                        }
+                    }
+                    else {
+                        const char* pcolumndata = pdata + icolumn*(sizeof(double) + (numpoints-1)*sizeof(float));
+                        double fvalue;
+                        memcpy(&fvalue, pcolumndata, sizeof(fvalue));
+                        const float* pdeltas = (const float*)(pcolumndata + sizeof(double));
+                        _vtrajdata[icolumn] = fvalue;
+                        for(size_t ipoint = 1; ipoint < numpoints; ++ipoint) {
+                            fvalue += pdeltas[ipoint-1];
+                            _vtrajdata[ipoint*dof+icolumn] = fvalue;
+                        }
+                    }
+                }
+            }
+        }
+        _UpdateDataPointer();
+        _bChanged = true;
+    }
+
+    bool _SaveColumnarTrajectoryCommand(std::ostream& sout, std::istream& sinput)
+    {
+        std::string filename;
+        int encoding = CTE_Float64;
+        sinput >> filename;
+        if( !sinput ) {
+            return false;
+        }
+        sinput >> encoding;
+        BOOST_ASSERT(_bInit);
+        std::ofstream f(filename.c_str(), std::ios::binary);
+        if( !f ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("failed to open %s for writing"),filename,ORE_InvalidArguments);
+        }
+        _WriteColumnar(f, encoding);
+        return !!f;
+    }
+
+    bool _LoadMappedTrajectoryCommand(std::ostream& sout, std::istream& sinput)
+    {
+        std::string filename;
+        sinput >> filename;
+        if( !sinput ) {
+            return false;
+        }
+        boost::shared_ptr<boost::interprocess::mapped_region> pmappedregion;
+        try {
+            boost::interprocess::file_mapping filemapping(filename.c_str(), boost::interprocess::read_only);
+            pmappedregion.reset(new boost::interprocess::mapped_region(filemapping, boost::interprocess::read_only));
+        }
+        catch(const boost::interprocess::interprocess_exception& ex) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("failed to map %s: %s"),filename%ex.what(),ORE_InvalidArguments);
+        }
+        const char* pfiledata = (const char*)pmappedregion->get_address();
+        const size_t filesize = pmappedregion->get_size();
+        ColumnarTrajectoryHeader header;
+        if( filesize < sizeof(header) ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("%s is too small to be a columnar trajectory"),filename,ORE_InvalidArguments);
+        }
+        memcpy(&header, pfiledata, sizeof(header));
+        if( header.magic != COLUMNAR_MAGIC_NUMBER || header.dataoffset < sizeof(header) ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("%s is not a columnar trajectory"),filename,ORE_InvalidArguments);
+        }
+        // the metadata is small, so parse it with the stream functions
+        std::stringstream ssmetadata(std::string(pfiledata+sizeof(header), min((uint64_t)filesize, header.dataoffset)-sizeof(header)));
+        _ReadColumnarMetadata(ssmetadata, header);
+        _ValidateColumnarDataRange(header, filesize);
+
+        const char* pdata = pfiledata + header.dataoffset;
+        if( header.encoding == CTE_Float64 && sizeof(dReal) == sizeof(double) && ((uintptr_t)pdata % sizeof(double)) == 0 ) {
+            _vtrajdata.resize(0);
+            _pmappedregion = pmappedregion;
+            _ptrajdata = (const dReal*)pdata;
+            _ntrajdata = header.numpoints*header.dof;
+            _bChanged = true;
+            sout << 1;
+        }
+        else {
+            _DecodeColumnarData(pdata, header);
+            sout << 0;
+        }
+        return true;
+    }
+
     void _ConvertData(std::vector<dReal>::iterator ittargetdata, std::vector<dReal>::const_iterator itsourcedata, const std::vector< std::vector<ConfigurationSpecification::Group>::const_iterator >& vconvertgroups, const ConfigurationSpecification& spec, size_t numelements, bool filluninitialized)
     {
         for(size_t igroup = 0; igroup < vconvertgroups.size(); ++igroup) {
@@ -633,8 +1032,10 @@ protected:
         }
     }
 
+    /// \brief computes _vaccumtime and _vdeltainvtime if the waypoints changed. Guarded by _mutexInternal so that several threads can sample the same trajectory.
     void _ComputeInternal() const
     {
+        boost::mutex::scoped_lock lock(_mutexInternal);
         if( !_bChanged ) {
             return;
         }
@@ -648,10 +1049,10 @@ protected:
             if( _vaccumtime.size() == 0 ) {
                 return;
             }
-            _vaccumtime.at(0) = _vtrajdata.at(_timeoffset);
-            _vdeltainvtime.at(0) = 1/_vtrajdata.at(_timeoffset);
+            _vaccumtime.at(0) = _ptrajdata[_timeoffset];
+            _vdeltainvtime.at(0) = 1/_ptrajdata[_timeoffset];
             for(size_t i = 1; i < _vaccumtime.size(); ++i) {
-                dReal deltatime = _vtrajdata[_spec.GetDOF()*i+_timeoffset];
+                dReal deltatime = _ptrajdata[_spec.GetDOF()*i+_timeoffset];
                 if( deltatime < 0 ) {
                     throw OPENRAVE_EXCEPTION_FORMAT("deltatime (%.15e) is < 0 at point %d/%d", deltatime%i%_vaccumtime.size(), ORE_InvalidState);
                 }
@@ -666,6 +1067,7 @@ protected:
     /// \brief assumes _ComputeInternal has finished
     void _VerifySampling() const
     {
+        boost::mutex::scoped_lock lock(_mutexInternal);
         BOOST_ASSERT(!_bChanged);
         BOOST_ASSERT(_bInit);
         if( _bSamplingVerified ) {
@@ -858,24 +1260,255 @@ protected:
                 }
             }
         }
+        _InitializePolynomialGroups();
+    }
+
+    /// \brief finds the groups whose interpolation is a polynomial of the waypoint data so that _SamplePoints can evaluate them from coefficients
+    ///
+    /// Has to be called after _vderivoffsets, _vddoffsets and _vintegraloffsets are set. The groups without all the data they need are left
+    /// to their interpolators, which throw the usual errors.
+    void _InitializePolynomialGroups()
+    {
+        _vgrouppolynomialdegrees.resize(0);
+        _vgrouppolynomialdegrees.resize(_spec._vgroups.size(),-1);
+        _vgrouppolynomialoffsets.resize(0);
+        _vgrouppolynomialoffsets.resize(_spec._vgroups.size(),0);
+        _nPolynomialCoeffs = 0;
+        for(size_t i = 0; i < _spec._vgroups.size(); ++i) {
+            const ConfigurationSpecification::Group& g = _spec._vgroups[i];
+            if( g.dof <= 0 || (g.name.size() >= 14 && g.name.substr(0,14) == "ikparam_values") ) {
+                continue;
+            }
+            int derivoffset = _vderivoffsets[g.offset], ddoffset = _vddoffsets[g.offset], integraloffset = _vintegraloffsets[g.offset];
+            int degree = -1;
+            if( g.interpolation == "linear" ) {
+                degree = 1;
+            }
+            else if( g.interpolation == "quadratic" ) {
+                if( derivoffset >= 0 || integraloffset >= 0 ) {
+                    degree = 2;
+                }
+            }
+            else if( g.interpolation == "cubic" ) {
+                if( derivoffset >= 0 ) {
+                    degree = 3;
+                }
+            }
+            else if( g.interpolation == "quartic" ) {
+                if( derivoffset >= 0 && ddoffset >= 0 ) {
+                    degree = 4;
+                }
+            }
+            else if( g.interpolation == "quintic" ) {
+                if( derivoffset >= 0 && ddoffset >= 0 ) {
+                    degree = 5;
+                }
+            }
+            if( degree >= 0 ) {
+                _vgrouppolynomialdegrees[i] = degree;
+                _vgrouppolynomialoffsets[i] = _nPolynomialCoeffs;
+                _nPolynomialCoeffs += (degree+1)*g.dof;
+            }
+        }
+    }
+
+    /// \brief computes the coefficients of the polynomial of group g between waypoints ipoint and ipoint+1 in the same way as its interpolator
+    ///
+    /// \param[out] pcoeffs the coefficients of power k of all the dofs of the group start at pcoeffs[k*g.dof]
+    void _ComputePolynomialCoeffs(const ConfigurationSpecification::Group& g, int degree, size_t ipoint, dReal* pcoeffs) const
+    {
+        const int dof = _spec.GetDOF();
+        const dReal* p0 = _ptrajdata + ipoint*dof;
+        const dReal* p1 = p0 + dof;
+        const dReal ideltatime = _vdeltainvtime.at(ipoint+1);
+        int derivoffset = _vderivoffsets[g.offset], ddoffset = _vddoffsets[g.offset];
+        switch(degree) {
+        case 1:
+            for(int i = 0; i < g.dof; ++i) {
+                pcoeffs[i] = p0[g.offset+i];
+                pcoeffs[g.dof+i] = derivoffset >= 0 ? p1[derivoffset+i] : (p1[g.offset+i]-p0[g.offset+i])*ideltatime;
+            }
+            break;
+        case 2:
+            if( derivoffset >= 0 ) {
+                for(int i = 0; i < g.dof; ++i) {
+                    pcoeffs[i] = p0[g.offset+i];
+                    pcoeffs[g.dof+i] = p0[derivoffset+i];
+                    pcoeffs[2*g.dof+i] = 0.5*ideltatime*(p1[derivoffset+i]-p0[derivoffset+i]);
+                }
+            }
+            else {
+                int integraloffset = _vintegraloffsets[g.offset];
+                dReal ideltatime2 = ideltatime*ideltatime;
+                for(int i = 0; i < g.dof; ++i) {
+                    dReal value0 = p0[g.offset+i], value1 = p1[g.offset+i];
+                    dReal c1TimesDelta = 6*(p1[integraloffset+i]-p0[integraloffset+i])*ideltatime - 4*value0 - 2*value1;
+                    pcoeffs[i] = value0;
+                    pcoeffs[g.dof+i] = c1TimesDelta*ideltatime;
+                    pcoeffs[2*g.dof+i] = (value1 - value0 - c1TimesDelta)*ideltatime2;
+                }
+            }
+            break;
+        case 3: {
+            dReal ideltatime2 = ideltatime*ideltatime;
+            dReal ideltatime3 = ideltatime2*ideltatime;
+            for(int i = 0; i < g.dof; ++i) {
+                dReal deriv0 = p0[derivoffset+i], deriv1 = p1[derivoffset+i];
+                dReal px = p1[g.offset+i] - p0[g.offset+i];
+                pcoeffs[i] = p0[g.offset+i];
+                pcoeffs[g.dof+i] = deriv0;
+                pcoeffs[2*g.dof+i] = 3*px*ideltatime2 - (2*deriv0+deriv1)*ideltatime;
+                pcoeffs[3*g.dof+i] = (deriv1+deriv0)*ideltatime2 - 2*px*ideltatime3;
+            }
+            break;
+        }
+        case 4: {
+            dReal ideltatime2 = ideltatime*ideltatime;
+            dReal ideltatime3 = ideltatime2*ideltatime;
+            for(int i = 0; i < g.dof; ++i) {
+                dReal deriv0 = p0[derivoffset+i], deriv1 = p1[derivoffset+i];
+                dReal dd0 = p0[ddoffset+i], dd1 = p1[ddoffset+i];
+                pcoeffs[i] = p0[g.offset+i];
+                pcoeffs[g.dof+i] = deriv0;
+                pcoeffs[2*g.dof+i] = 0.5*dd0;
+                pcoeffs[3*g.dof+i] = (deriv1-deriv0)*ideltatime2 - (2*dd0+dd1)*ideltatime/3.0;
+                pcoeffs[4*g.dof+i] = -0.5*(deriv1-deriv0)*ideltatime3 + (dd0 + dd1)*ideltatime2*0.25;
+            }
+            break;
+        }
+        case 5: {
+            dReal ideltatime2 = ideltatime*ideltatime;
+            dReal ideltatime3 = ideltatime2*ideltatime;
+            dReal ideltatime4 = ideltatime2*ideltatime2;
+            dReal ideltatime5 = ideltatime4*ideltatime;
+            for(int i = 0; i < g.dof; ++i) {
+                dReal px = p1[g.offset+i] - p0[g.offset+i];
+                dReal deriv0 = p0[derivoffset+i], deriv1 = p1[derivoffset+i];
+                dReal dd0 = p0[ddoffset+i], dd1 = p1[ddoffset+i];
+                pcoeffs[i] = p0[g.offset+i];
+                pcoeffs[g.dof+i] = deriv0;
+                pcoeffs[2*g.dof+i] = 0.5*dd0;
+                pcoeffs[3*g.dof+i] = (-1.5*dd0 + dd1*0.5)*ideltatime + (-6*deriv0 - 4*deriv1)*ideltatime2 + px*10*ideltatime3;
+                pcoeffs[4*g.dof+i] = (1.5*dd0 - dd1)*ideltatime2 + (8*deriv0 + 7*deriv1)*ideltatime3 - px*15*ideltatime4;
+                pcoeffs[5*g.dof+i] = (-0.5*dd0 + dd1*0.5)*ideltatime3 - (3*deriv0 + 3*deriv1)*ideltatime4 + px*6*ideltatime5;
+            }
+            break;
+        }
+        default:
+            throw OPENRAVE_EXCEPTION_FORMAT(_("unsupported polynomial degree %d"), degree, ORE_InvalidArguments);
+        }
+    }
+
+    /** \brief samples the trajectory at numtimes times and writes the points consecutively starting at pdata, which has to be filled with 0s.
+
+        Keeps a cursor on the current segment instead of searching for every time, so increasing times cost O(numtimes + numwaypoints) in total.
+        Decreasing times fall back to a binary search. The polynomial groups are evaluated from coefficients that are computed once per segment,
+        the other groups go through their interpolators.
+        \param ptimes the times to sample, if NULL then samples at tstart + i*timestep
+     */
+    void _SamplePoints(dReal* pdata, size_t numtimes, const dReal* ptimes, dReal tstart, dReal timestep) const
+    {
+        BOOST_ASSERT(_bInit);
+        OPENRAVE_ASSERT_OP(_timeoffset,>=,0);
+        _ComputeInternal();
+        OPENRAVE_ASSERT_OP_FORMAT0((int)_ntrajdata,>=,_spec.GetDOF(), "trajectory needs at least one point to sample from", ORE_InvalidArguments);
+        if( IS_DEBUGLEVEL(Level_Verbose) || (RaveGetDebugLevel() & Level_VerifyPlans) ) {
+            _VerifySampling();
+        }
+        const int dof = _spec.GetDOF();
+        const dReal duration = GetDuration();
+        std::vector<dReal> vcoeffs(_nPolynomialCoeffs);
+        size_t index = 0; // first waypoint whose accumulated time is >= the current time
+        size_t icoeffpoint = (size_t)-1; // segment whose coefficients are in vcoeffs
+        for(size_t isample = 0; isample < numtimes; ++isample, pdata += dof) {
+            dReal time = ptimes != NULL ? ptimes[isample] : tstart + isample*timestep;
+            OPENRAVE_ASSERT_OP(time, >=, -g_fEpsilon);
+            if( time >= duration ) {
+                std::copy(_ptrajdata+_ntrajdata-dof,_ptrajdata+_ntrajdata,pdata);
+                continue;
+            }
+            if( index > 0 && time <= _vaccumtime[index-1] ) {
+                index = std::lower_bound(_vaccumtime.begin(),_vaccumtime.begin()+index,time)-_vaccumtime.begin();
+            }
+            else {
+                // terminates since time < duration
+                while( _vaccumtime[index] < time ) {
+                    ++index;
+                }
+            }
+            if( index == 0 ) {
+                std::copy(_ptrajdata,_ptrajdata+dof,pdata);
+                pdata[_timeoffset] = time;
+                continue;
+            }
+
+            size_t ipoint = index-1;
+            dReal deltatime = time-_vaccumtime[ipoint];
+            dReal waypointdeltatime = _ptrajdata[dof*index + _timeoffset];
+            // unfortunately due to floating-point error deltatime might not be in the range [0, waypointdeltatime], so double check!
+            if( deltatime < 0 ) {
+                deltatime = 0;
+            }
+            else if( deltatime > waypointdeltatime ) {
+                deltatime = waypointdeltatime;
+            }
+            if( ipoint != icoeffpoint ) {
+                for(size_t igroup = 0; igroup < _vgrouppolynomialdegrees.size(); ++igroup) {
+                    if( _vgrouppolynomialdegrees[igroup] >= 0 ) {
+                        _ComputePolynomialCoeffs(_spec._vgroups[igroup], _vgrouppolynomialdegrees[igroup], ipoint, &vcoeffs[_vgrouppolynomialoffsets[igroup]]);
+                    }
+                }
+                icoeffpoint = ipoint;
+            }
+            for(size_t igroup = 0; igroup < _vgroupinterpolators.size(); ++igroup) {
+                int degree = _vgrouppolynomialdegrees[igroup];
+                if( degree < 0 ) {
+                    if( !!_vgroupinterpolators[igroup] ) {
+                        _vgroupinterpolators[igroup](ipoint,deltatime,pdata);
+                    }
+                    continue;
+                }
+                const ConfigurationSpecification::Group& g = _spec._vgroups[igroup];
+                dReal* pvalues = pdata + g.offset;
+                const dReal* pcoeffs = &vcoeffs[_vgrouppolynomialoffsets[igroup]];
+                if( degree >= 2 && deltatime <= g_fEpsilon ) {
+                    // same as the interpolators, return the waypoint
+                    std::copy(pcoeffs, pcoeffs+g.dof, pvalues);
+                    continue;
+                }
+                // horner's method, the highest power first
+                pcoeffs += degree*g.dof;
+                for(int i = 0; i < g.dof; ++i) {
+                    pvalues[i] = pcoeffs[i];
+                }
+                for(int k = degree-1; k >= 0; --k) {
+                    pcoeffs -= g.dof;
+                    for(int i = 0; i < g.dof; ++i) {
+                        pvalues[i] = pcoeffs[i] + deltatime*pvalues[i];
+                    }
+                }
+            }
+            // should return the sample time relative to the last endpoint so it is easier to re-insert in the trajectory
+            pdata[_timeoffset] = deltatime;
+        }
     }
 
-    void _InterpolatePrevious(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, std::vector<dReal>& data)
+    void _InterpolatePrevious(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, dReal* data)
     {
         size_t offset = ipoint*_spec.GetDOF()+g.offset;
-        if( (ipoint+1)*_spec.GetDOF() < _vtrajdata.size() ) {
+        if( (ipoint+1)*_spec.GetDOF() < _ntrajdata ) {
             // if point is so close the previous, then choose the next
             dReal f = _vdeltainvtime.at(ipoint+1)*deltatime;
             if( f > 1-g_fEpsilon ) {
                 offset += _spec.GetDOF();
             }
         }
-        std::copy(_vtrajdata.begin()+offset,_vtrajdata.begin()+offset+g.dof,data.begin()+g.offset);
+        std::copy(_ptrajdata+offset,_ptrajdata+offset+g.dof,data+g.offset);
     }
 
-    void _InterpolateNext(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, std::vector<dReal>& data)
+    void _InterpolateNext(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, dReal* data)
     {
-        if( (ipoint+1)*_spec.GetDOF() < _vtrajdata.size() ) {
+        if( (ipoint+1)*_spec.GetDOF() < _ntrajdata ) {
             ipoint += 1;
         }
         size_t offset = ipoint*_spec.GetDOF() + g.offset;
@@ -883,10 +1516,10 @@ protected:
             // if point is so close the previous, then choose the previous
             offset -= _spec.GetDOF();
         }
-        std::copy(_vtrajdata.begin()+offset,_vtrajdata.begin()+offset+g.dof,data.begin()+g.offset);
+        std::copy(_ptrajdata+offset,_ptrajdata+offset+g.dof,data+g.offset);
     }
 
-    void _InterpolateLinear(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, std::vector<dReal>& data)
+    void _InterpolateLinear(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, dReal* data)
     {
         size_t offset = ipoint*_spec.GetDOF();
         int derivoffset = _vderivoffsets[g.offset];
@@ -894,18 +1527,18 @@ protected:
             // expected derivative offset, interpolation can be wrong for circular joints
             dReal f = _vdeltainvtime.at(ipoint+1)*deltatime;
             for(int i = 0; i < g.dof; ++i) {
-                data[g.offset+i] = _vtrajdata[offset+g.offset+i]*(1-f) + f*_vtrajdata[_spec.GetDOF()+offset+g.offset+i];
+                data[g.offset+i] = _ptrajdata[offset+g.offset+i]*(1-f) + f*_ptrajdata[_spec.GetDOF()+offset+g.offset+i];
             }
         }
         else {
             for(int i = 0; i < g.dof; ++i) {
-                dReal deriv0 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
-                data[g.offset+i] = _vtrajdata[offset+g.offset+i] + deltatime*deriv0;
+                dReal deriv0 = _ptrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                data[g.offset+i] = _ptrajdata[offset+g.offset+i] + deltatime*deriv0;
             }
         }
     }
 
-    void _InterpolateLinearIk(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, std::vector<dReal>& data, IkParameterizationType iktype)
+    void _InterpolateLinearIk(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, dReal* data, IkParameterizationType iktype)
     {
         _InterpolateLinear(g,ipoint,deltatime,data);
         if( deltatime > g_fEpsilon ) {
@@ -915,8 +1548,8 @@ protected:
             case IKP_Rotation3D:
             case IKP_Transform6D: {
                 Vector q0, q1;
-                q0.Set4(&_vtrajdata[offset+g.offset]);
-                q1.Set4(&_vtrajdata[_spec.GetDOF()+offset+g.offset]);
+                q0.Set4(&_ptrajdata[offset+g.offset]);
+                q1.Set4(&_ptrajdata[_spec.GetDOF()+offset+g.offset]);
                 Vector q = quatSlerp(q0,q1,f);
                 data[g.offset+0] = q[0];
                 data[g.offset+1] = q[1];
@@ -925,8 +1558,8 @@ protected:
                 break;
             }
             case IKP_TranslationDirection5D: {
-                Vector dir0(_vtrajdata[offset+g.offset+0],_vtrajdata[offset+g.offset+1],_vtrajdata[offset+g.offset+2]);
-                Vector dir1(_vtrajdata[_spec.GetDOF()+offset+g.offset+0],_vtrajdata[_spec.GetDOF()+offset+g.offset+1],_vtrajdata[_spec.GetDOF()+offset+g.offset+2]);
+                Vector dir0(_ptrajdata[offset+g.offset+0],_ptrajdata[offset+g.offset+1],_ptrajdata[offset+g.offset+2]);
+                Vector dir1(_ptrajdata[_spec.GetDOF()+offset+g.offset+0],_ptrajdata[_spec.GetDOF()+offset+g.offset+1],_ptrajdata[_spec.GetDOF()+offset+g.offset+2]);
                 Vector axisangle = dir0.cross(dir1);
                 dReal fsinangle = RaveSqrt(axisangle.lengthsqr3());
                 if( fsinangle > g_fEpsilon ) {
@@ -944,7 +1577,7 @@ protected:
         }
     }
 
-    void _InterpolateQuadratic(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, std::vector<dReal>& data)
+    void _InterpolateQuadratic(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, dReal* data)
     {
         size_t offset = ipoint*_spec.GetDOF();
         if( deltatime > g_fEpsilon ) {
@@ -952,10 +1585,10 @@ protected:
             if( derivoffset >= 0 ) {
                 for(int i = 0; i < g.dof; ++i) {
                     // coeff*t^2 + deriv0*t + pos0
-                    dReal deriv0 = _vtrajdata[offset+derivoffset+i];
-                    dReal deriv1 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                    dReal deriv0 = _ptrajdata[offset+derivoffset+i];
+                    dReal deriv1 = _ptrajdata[_spec.GetDOF()+offset+derivoffset+i];
                     dReal coeff = 0.5*_vdeltainvtime.at(ipoint+1)*(deriv1-deriv0);
-                    data[g.offset+i] = _vtrajdata[offset+g.offset+i] + deltatime*(deriv0 + deltatime*coeff);
+                    data[g.offset+i] = _ptrajdata[offset+g.offset+i] + deltatime*(deriv0 + deltatime*coeff);
                 }
             }
             else {
@@ -969,10 +1602,10 @@ protected:
                     // mult by (3/deltatime): c2*deltatime**2 + 3/2*c1*deltatime + 3*v0 = 3*(p1-p0)/deltatime
                     // subtract by original: 0.5*c1*deltatime + 2*v0 - 3*(p1-p0)/deltatime + v1 = 0
                     // c1*deltatime = 6*(p1-p0)/deltatime - 4*v0 - 2*v1
-                    dReal integral0 = _vtrajdata[offset+integraloffset+i];
-                    dReal integral1 = _vtrajdata[_spec.GetDOF()+offset+integraloffset+i];
-                    dReal value0 = _vtrajdata[offset+g.offset+i];
-                    dReal value1 = _vtrajdata[_spec.GetDOF()+offset+g.offset+i];
+                    dReal integral0 = _ptrajdata[offset+integraloffset+i];
+                    dReal integral1 = _ptrajdata[_spec.GetDOF()+offset+integraloffset+i];
+                    dReal value0 = _ptrajdata[offset+g.offset+i];
+                    dReal value1 = _ptrajdata[_spec.GetDOF()+offset+g.offset+i];
                     dReal c1TimesDelta = 6*(integral1-integral0)*ideltatime - 4*value0 - 2*value1;
                     dReal c1 = c1TimesDelta*ideltatime;
                     dReal c2 = (value1 - value0 - c1TimesDelta)*ideltatime2;
@@ -982,12 +1615,12 @@ protected:
         }
         else {
             for(int i = 0; i < g.dof; ++i) {
-                data[g.offset+i] = _vtrajdata[offset+g.offset+i];
+                data[g.offset+i] = _ptrajdata[offset+g.offset+i];
             }
         }
     }
 
-    void _InterpolateQuadraticIk(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, std::vector<dReal>& data, IkParameterizationType iktype)
+    void _InterpolateQuadraticIk(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, dReal* data, IkParameterizationType iktype)
     {
         _InterpolateQuadratic(g, ipoint, deltatime, data);
         if( deltatime > g_fEpsilon ) {
@@ -997,10 +1630,10 @@ protected:
             switch(iktype) {
             case IKP_Rotation3D:
             case IKP_Transform6D: {
-                q0.Set4(&_vtrajdata[offset+g.offset]);
-                q0vel.Set4(&_vtrajdata[offset+derivoffset]);
-                q1.Set4(&_vtrajdata[_spec.GetDOF()+offset+g.offset]);
-                q1vel.Set4(&_vtrajdata[_spec.GetDOF()+offset+derivoffset]);
+                q0.Set4(&_ptrajdata[offset+g.offset]);
+                q0vel.Set4(&_ptrajdata[offset+derivoffset]);
+                q1.Set4(&_ptrajdata[_spec.GetDOF()+offset+g.offset]);
+                q1vel.Set4(&_ptrajdata[_spec.GetDOF()+offset+derivoffset]);
                 Vector angularvelocity0 = quatMultiply(q0vel,quatInverse(q0))*2;
                 Vector angularvelocity1 = quatMultiply(q1vel,quatInverse(q1))*2;
                 Vector coeff = (angularvelocity1-angularvelocity0)*(0.5*_vdeltainvtime.at(ipoint+1));
@@ -1014,12 +1647,12 @@ protected:
             }
             case IKP_TranslationDirection5D: {
                 Vector dir0, dir1, angularvelocity0, angularvelocity1;
-                dir0.Set3(&_vtrajdata[offset+g.offset]);
-                dir1.Set3(&_vtrajdata[_spec.GetDOF()+offset+g.offset]);
+                dir0.Set3(&_ptrajdata[offset+g.offset]);
+                dir1.Set3(&_ptrajdata[_spec.GetDOF()+offset+g.offset]);
                 Vector axisangle = dir0.cross(dir1);
                 if( axisangle.lengthsqr3() > g_fEpsilon ) {
-                    angularvelocity0.Set3(&_vtrajdata[offset+derivoffset]);
-                    angularvelocity1.Set3(&_vtrajdata[_spec.GetDOF()+offset+derivoffset]);
+                    angularvelocity0.Set3(&_ptrajdata[offset+derivoffset]);
+                    angularvelocity1.Set3(&_ptrajdata[_spec.GetDOF()+offset+derivoffset]);
                     Vector coeff = (angularvelocity1-angularvelocity0)*(0.5*_vdeltainvtime.at(ipoint+1));
                     Vector vtotaldelta = angularvelocity0*deltatime + coeff*(deltatime*deltatime);
                     Vector newdir = quatRotate(quatFromAxisAngle(vtotaldelta),dir0);
@@ -1035,7 +1668,7 @@ protected:
         }
     }
 
-    void _InterpolateCubic(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, std::vector<dReal>& data)
+    void _InterpolateCubic(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, dReal* data)
     {
         // p = c3*t**3 + c2*t**2 + c1*t + c0
         // c3 = (v1*dt + v0*dt - 2*px)/(dt**3)
@@ -1051,12 +1684,12 @@ protected:
                 dReal ideltatime3 = ideltatime2*ideltatime;
                 for(int i = 0; i < g.dof; ++i) {
                     // coeff*t^2 + deriv0*t + pos0
-                    dReal deriv0 = _vtrajdata[offset+derivoffset+i];
-                    dReal deriv1 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
-                    dReal px = _vtrajdata.at(_spec.GetDOF()+offset+g.offset+i) - _vtrajdata[offset+g.offset+i];
+                    dReal deriv0 = _ptrajdata[offset+derivoffset+i];
+                    dReal deriv1 = _ptrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                    dReal px = _ptrajdata[_spec.GetDOF()+offset+g.offset+i] - _ptrajdata[offset+g.offset+i];
                     dReal c3 = (deriv1+deriv0)*ideltatime2 - 2*px*ideltatime3;
                     dReal c2 = 3*px*ideltatime2 - (2*deriv0+deriv1)*ideltatime;
-                    data[g.offset+i] = _vtrajdata[offset+g.offset+i] + deltatime*(deriv0 + deltatime*(c2 + deltatime*c3));
+                    data[g.offset+i] = _ptrajdata[offset+g.offset+i] + deltatime*(deriv0 + deltatime*(c2 + deltatime*c3));
                 }
             }
             else {
@@ -1065,12 +1698,12 @@ protected:
         }
         else {
             for(int i = 0; i < g.dof; ++i) {
-                data[g.offset+i] = _vtrajdata[offset+g.offset+i];
+                data[g.offset+i] = _ptrajdata[offset+g.offset+i];
             }
         }
     }
 
-    void _InterpolateQuartic(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, std::vector<dReal>& data)
+    void _InterpolateQuartic(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, dReal* data)
     {
         // p = c4*t**4 + c3*t**3 + c2*t**2 + c1*t + c0
         //
@@ -1091,13 +1724,13 @@ protected:
                 dReal ideltatime2 = ideltatime*ideltatime;
                 dReal ideltatime3 = ideltatime2*ideltatime;
                 for(int i = 0; i < g.dof; ++i) {
-                    dReal deriv0 = _vtrajdata[offset+derivoffset+i];
-                    dReal deriv1 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
-                    dReal dd0 = _vtrajdata[offset+ddoffset+i];
-                    dReal dd1 = _vtrajdata[_spec.GetDOF()+offset+ddoffset+i];
+                    dReal deriv0 = _ptrajdata[offset+derivoffset+i];
+                    dReal deriv1 = _ptrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                    dReal dd0 = _ptrajdata[offset+ddoffset+i];
+                    dReal dd1 = _ptrajdata[_spec.GetDOF()+offset+ddoffset+i];
                     dReal c4 = -0.5*(deriv1-deriv0)*ideltatime3 + (dd0 + dd1)*ideltatime2*0.25;
                     dReal c3 = (deriv1-deriv0)*ideltatime2 - (2*dd0+dd1)*ideltatime/3.0;
-                    data[g.offset+i] = _vtrajdata[offset+g.offset+i] + deltatime*(deriv0 + deltatime*(0.5*dd0 + deltatime*(c3 + deltatime*c4)));
+                    data[g.offset+i] = _ptrajdata[offset+g.offset+i] + deltatime*(deriv0 + deltatime*(0.5*dd0 + deltatime*(c3 + deltatime*c4)));
                 }
             }
             else {
@@ -1106,12 +1739,12 @@ protected:
         }
         else {
             for(int i = 0; i < g.dof; ++i) {
-                data[g.offset+i] = _vtrajdata[offset+g.offset+i];
+                data[g.offset+i] = _ptrajdata[offset+g.offset+i];
             }
         }
     }
 
-    void _InterpolateQuintic(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, std::vector<dReal>& data)
+    void _InterpolateQuintic(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, dReal* data)
     {
         // p0, p1, v0, v1, a0, a1, dt, t, c5, c4, c3 = symbols('p0, p1, v0, v1, a0, a1, dt, t, c5, c4, c3')
         // p = c5*t**5 + c4*t**4 + c3*t**3 + c2*t**2 + c1*t + c0
@@ -1139,12 +1772,12 @@ protected:
                 dReal ideltatime4 = ideltatime2*ideltatime2;
                 dReal ideltatime5 = ideltatime4*ideltatime;
                 for(int i = 0; i < g.dof; ++i) {
-                    dReal p0 = _vtrajdata[offset+g.offset+i];
-                    dReal px = _vtrajdata[_spec.GetDOF()+offset+g.offset+i] - p0;
-                    dReal deriv0 = _vtrajdata[offset+derivoffset+i];
-                    dReal deriv1 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
-                    dReal dd0 = _vtrajdata[offset+ddoffset+i];
-                    dReal dd1 = _vtrajdata[_spec.GetDOF()+offset+ddoffset+i];
+                    dReal p0 = _ptrajdata[offset+g.offset+i];
+                    dReal px = _ptrajdata[_spec.GetDOF()+offset+g.offset+i] - p0;
+                    dReal deriv0 = _ptrajdata[offset+derivoffset+i];
+                    dReal deriv1 = _ptrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                    dReal dd0 = _ptrajdata[offset+ddoffset+i];
+                    dReal dd1 = _ptrajdata[_spec.GetDOF()+offset+ddoffset+i];
                     dReal c5 = (-0.5*dd0 + dd1*0.5)*ideltatime3 - (3*deriv0 + 3*deriv1)*ideltatime4 + px*6*ideltatime5;
                     dReal c4 = (1.5*dd0 - dd1)*ideltatime2 + (8*deriv0 + 7*deriv1)*ideltatime3 - px*15*ideltatime4;
                     dReal c3 = (-1.5*dd0 + dd1*0.5)*ideltatime + (-6*deriv0 - 4*deriv1)*ideltatime2 + px*10*ideltatime3;
@@ -1157,12 +1790,12 @@ protected:
         }
         else {
             for(int i = 0; i < g.dof; ++i) {
-                data[g.offset+i] = _vtrajdata[offset+g.offset+i];
+                data[g.offset+i] = _ptrajdata[offset+g.offset+i];
             }
         }
     }
 
-    void _InterpolateSextic(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, std::vector<dReal>& data)
+    void _InterpolateSextic(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, dReal* data)
     {
         // p = c6*t**6 + c5*t**5 + c4*t**4 + c3*t**3 + c2*t**2 + c1*t + c0
         //
@@ -1193,14 +1826,14 @@ protected:
                 //dReal deltatime4 = deltatime2*deltatime2;
                 //dReal deltatime5 = deltatime4*deltatime;
                 for(int i = 0; i < g.dof; ++i) {
-                    dReal p0 = _vtrajdata[offset+g.offset+i];
-                    //dReal px = _vtrajdata[_spec.GetDOF()+offset+g.offset+i] - p0;
-                    dReal deriv0 = _vtrajdata[offset+derivoffset+i];
-                    dReal deriv1 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
-                    dReal dd0 = _vtrajdata[offset+ddoffset+i];
-                    dReal dd1 = _vtrajdata[_spec.GetDOF()+offset+ddoffset+i];
-                    dReal ddd0 = _vtrajdata[offset+dddoffset+i];
-                    dReal ddd1 = _vtrajdata[_spec.GetDOF()+offset+dddoffset+i];
+                    dReal p0 = _ptrajdata[offset+g.offset+i];
+                    //dReal px = _ptrajdata[_spec.GetDOF()+offset+g.offset+i] - p0;
+                    dReal deriv0 = _ptrajdata[offset+derivoffset+i];
+                    dReal deriv1 = _ptrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                    dReal dd0 = _ptrajdata[offset+ddoffset+i];
+                    dReal dd1 = _ptrajdata[_spec.GetDOF()+offset+ddoffset+i];
+                    dReal ddd0 = _ptrajdata[offset+dddoffset+i];
+                    dReal ddd1 = _ptrajdata[_spec.GetDOF()+offset+dddoffset+i];
                     // matrix inverse is slow but at least it will work for now
                     // A=Matrix(3,3,[6*dt**5, 5*dt**4, 4*dt**3, 30*dt**4, 20*dt**3, 12*dt**2, 120*dt**3, 60*dt**2, 24*dt])
                     // A.inv() = [   dt**(-5), -1/(2*dt**4), 1/(12*dt**3)]
@@ -1227,7 +1860,7 @@ protected:
         }
         else {
             for(int i = 0; i < g.dof; ++i) {
-                data[g.offset+i] = _vtrajdata[offset+g.offset+i];
+                data[g.offset+i] = _ptrajdata[offset+g.offset+i];
             }
         }
     }
@@ -1238,9 +1871,9 @@ protected:
         int derivoffset = _vderivoffsets[g.offset];
         if( derivoffset >= 0 ) {
             for(int i = 0; i < g.dof; ++i) {
-                dReal deriv0 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
-                dReal expected = _vtrajdata[offset+g.offset+i] + deltatime*deriv0;
-                dReal error = RaveFabs(_vtrajdata[_spec.GetDOF()+offset+g.offset+i] - expected);
+                dReal deriv0 = _ptrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                dReal expected = _ptrajdata[offset+g.offset+i] + deltatime*deriv0;
+                dReal error = RaveFabs(_ptrajdata[_spec.GetDOF()+offset+g.offset+i] - expected);
                 if( RaveFabs(error-2*PI) > g_fEpsilonLinear ) { // TODO, officially track circular joints
                     OPENRAVE_ASSERT_OP_FORMAT(error,<=,g_fEpsilonLinear, "trajectory segment for group %s interpolation %s points %d-%d dof %d is invalid", g.name%g.interpolation%ipoint%(ipoint+1)%i, ORE_InvalidState);
                 }
@@ -1256,10 +1889,10 @@ protected:
             if( derivoffset >= 0 ) {
                 for(int i = 0; i < g.dof; ++i) {
                     // coeff*t^2 + deriv0*t + pos0
-                    dReal deriv0 = _vtrajdata[offset+derivoffset+i];
-                    dReal coeff = 0.5*_vdeltainvtime.at(ipoint+1)*(_vtrajdata[_spec.GetDOF()+offset+derivoffset+i]-deriv0);
-                    dReal expected = _vtrajdata[offset+g.offset+i] + deltatime*(deriv0 + deltatime*coeff);
-                    dReal error = RaveFabs(_vtrajdata.at(_spec.GetDOF()+offset+g.offset+i)-expected);
+                    dReal deriv0 = _ptrajdata[offset+derivoffset+i];
+                    dReal coeff = 0.5*_vdeltainvtime.at(ipoint+1)*(_ptrajdata[_spec.GetDOF()+offset+derivoffset+i]-deriv0);
+                    dReal expected = _ptrajdata[offset+g.offset+i] + deltatime*(deriv0 + deltatime*coeff);
+                    dReal error = RaveFabs(_ptrajdata[_spec.GetDOF()+offset+g.offset+i]-expected);
                     if( RaveFabs(error-2*PI) > 1e-5 ) { // TODO, officially track circular joints
                         OPENRAVE_ASSERT_OP_FORMAT(error,<=,1e-4, "trajectory segment for group %s interpolation %s time %f points %d-%d dof %d is invalid", g.name%g.interpolation%deltatime%ipoint%(ipoint+1)%i, ORE_InvalidState);
                     }
@@ -1291,17 +1924,24 @@ protected:
     }
 
     ConfigurationSpecification _spec;
-    std::vector< boost::function<void(size_t,dReal,std::vector<dReal>&)> > _vgroupinterpolators;
+    std::vector< boost::function<void(size_t,dReal,dReal*)> > _vgroupinterpolators; ///< for every group, writes the interpolated values of the group into the point starting at the pointer
     std::vector< boost::function<void(size_t,dReal)> > _vgroupvalidators;
     std::vector<int> _vderivoffsets, _vddoffsets, _vdddoffsets; ///< for every group that relies on other info to compute its position, this will point to the derivative offset. -1 if invalid and not needed, -2 if invalid and needed
     std::vector<int> _vintegraloffsets; ///< for every group that relies on other info to compute its position, this will point to the integral offset (ie the position for a velocity group). -1 if invalid and not needed, -2 if invalid and needed
+    std::vector<int> _vgrouppolynomialdegrees; ///< for every group, the degree of its polynomial evaluated by _SamplePoints, -1 if sampled by its interpolator
+    std::vector<int> _vgrouppolynomialoffsets; ///< for every polynomial group, the offset of its coefficients in the buffer of _SamplePoints
+    int _nPolynomialCoeffs; ///< number of coefficients of all the polynomial groups of one segment
     int _timeoffset;
 
-    std::vector<dReal> _vtrajdata;
+    std::vector<dReal> _vtrajdata; ///< the waypoints when they are not mapped from a file
+    const dReal* _ptrajdata; ///< the waypoints used by all the reading functions, points to _vtrajdata or inside _pmappedregion
+    size_t _ntrajdata; ///< number of values of _ptrajdata
+    boost::shared_ptr<boost::interprocess::mapped_region> _pmappedregion; ///< if set, the columnar trajectory file _ptrajdata points into
     mutable std::vector<dReal> _vaccumtime, _vdeltainvtime;
     bool _bInit;
     mutable bool _bChanged; ///< if true, then _ComputeInternal() has to be called in order to compute _vaccumtime and _vdeltainvtime
     mutable bool _bSamplingVerified; ///< if false, then _VerifySampling() has not be called yet to verify that all points can be sampled.
+    mutable boost::mutex _mutexInternal; ///< protects the lazily computed _vaccumtime, _vdeltainvtime, _bChanged and _bSamplingVerified when sampling from several threads
 };
 
 TrajectoryBasePtr CreateGenericTrajectory(EnvironmentBasePtr penv, std::istream& sinput)
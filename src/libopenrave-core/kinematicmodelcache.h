@@ -0,0 +1,216 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 agent <agent@local>
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+/**
+   \file   kinematicmodelcache.h
+   \brief  Process-wide cache of the robots read from files by Environment::ReadRobotURI.
+   \author agent <agent@local>, 2026
+ */
+#ifndef RAVE_KINEMATIC_MODEL_CACHE_H
+#define RAVE_KINEMATIC_MODEL_CACHE_H
+
+#include "ravep.h"
+
+#include <sys/stat.h>
+#include <atomic>
+
+namespace OpenRAVE {
+
+/// \brief a robot read from a file, stored as the infos that initialize a new robot without parsing the file again
+///
+/// The infos are never modified once the model is cached. KinBody::Init copies them, so every robot created from a model
+/// holds its own geometry infos and collision meshes, the cache saves the parsing and not the memory of the meshes.
+class KinematicModel
+{
+public:
+    std::string _xmlid; ///< robot interface to create
+    std::string _name, _description, _uri;
+    std::vector<KinBody::LinkInfoConstPtr> _vLinkInfos; ///< the geometries include their collision meshes
+    std::vector<KinBody::JointInfoConstPtr> _vJointInfos; ///< active joints followed by the passive joints
+    std::vector<RobotBase::ManipulatorInfoConstPtr> _vManipulatorInfos;
+    std::vector<RobotBase::AttachedSensorInfoConstPtr> _vAttachedSensorInfos;
+    std::vector<RobotBase::GripperInfoConstPtr> _vGripperInfos;
+    std::vector< std::pair<std::string, std::string> > _vDependencies; ///< resolved mesh files of the geometries and their KinematicModelCache::GetFileStamp
+};
+
+typedef boost::shared_ptr<KinematicModel> KinematicModelPtr;
+typedef boost::shared_ptr<KinematicModel const> KinematicModelConstPtr;
+
+/// \brief maps a resolved file, its modification time, its size and the load attributes to the model read from it
+///
+/// The mesh files of the geometries are checked for modifications when a model is found. Other files included by the
+/// top-level file are not.
+class KinematicModelCache
+{
+public:
+    KinematicModelCache() : _bEnabled(false) {
+    }
+
+    bool IsEnabled() const {
+        return _bEnabled;
+    }
+
+    void SetEnabled(bool bEnabled) {
+        _bEnabled = bEnabled;
+    }
+
+    /// \brief returns the modification time in nanoseconds and the size of a resolved file, empty if the file does not exist
+    static std::string GetFileStamp(const std::string& fullfilename)
+    {
+        struct stat filestat;
+        if( fullfilename.size() == 0 || stat(fullfilename.c_str(), &filestat) != 0 ) {
+            return std::string();
+        }
+        uint64_t mtime = (uint64_t)filestat.st_mtime*1000000000;
+#if defined(__APPLE__)
+        mtime += filestat.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+        mtime += filestat.st_mtim.tv_nsec;
+#endif
+        std::stringstream ss;
+        ss << mtime << " " << (uint64_t)filestat.st_size;
+        return ss.str();
+    }
+
+    /// \brief returns the key of a file and its load attributes, empty if the file cannot be found
+    static std::string GetKey(const std::string& filename, const AttributesList& atts)
+    {
+        std::string fullfilename = RaveFindLocalFile(filename);
+        std::string stamp = GetFileStamp(fullfilename);
+        if( stamp.size() == 0 ) {
+            return std::string();
+        }
+        std::stringstream ss;
+        ss << fullfilename << "\n" << stamp;
+        FOREACHC(itatt, atts) {
+            ss << "\n" << itatt->first << "=" << itatt->second;
+        }
+        return ss.str();
+    }
+
+    /// \brief returns the model of key, empty if there is none or one of its mesh files was modified
+    KinematicModelConstPtr Find(const std::string& key)
+    {
+        KinematicModelConstPtr model;
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            std::map<std::string, ModelEntry>::const_iterator it = _mapModels.find(key);
+            if( it == _mapModels.end() ) {
+                return KinematicModelConstPtr();
+            }
+            model = it->second.second;
+        }
+        FOREACHC(itdependency, model->_vDependencies) {
+            if( GetFileStamp(itdependency->first) != itdependency->second ) {
+                RAVELOG_DEBUG_FORMAT("%s was modified, reading %s again", itdependency->first%model->_uri);
+                return KinematicModelConstPtr();
+            }
+        }
+        return model;
+    }
+
+    /// \brief sets the dependencies of model to the mesh files of its geometries
+    ///
+    /// \param fullfilename the resolved file the model was read from, relative mesh files are resolved from its directory
+    static void SetDependencies(KinematicModel& model, const std::string& fullfilename)
+    {
+        std::string curdir;
+        size_t pos = fullfilename.find_last_of("/\\");
+        if( pos != std::string::npos ) {
+            curdir = fullfilename.substr(0, pos);
+        }
+        std::set<std::string> setfilenames;
+        FOREACHC(itlinkinfo, model._vLinkInfos) {
+            FOREACHC(itgeominfo, (*itlinkinfo)->_vgeometryinfos) {
+                setfilenames.insert((*itgeominfo)->_filenamecollision);
+                setfilenames.insert((*itgeominfo)->_filenamerender);
+            }
+        }
+        model._vDependencies.clear();
+        FOREACHC(itfilename, setfilenames) {
+            if( itfilename->size() > 0 ) {
+                std::string fulldependency = RaveFindLocalFile(*itfilename, curdir);
+                if( fulldependency.size() > 0 ) {
+                    model._vDependencies.push_back(std::make_pair(fulldependency, GetFileStamp(fulldependency)));
+                }
+            }
+        }
+    }
+
+    /// \param parsetime microseconds spent reading the file
+    void Insert(const std::string& key, const std::string& fullfilename, KinematicModelConstPtr model, uint64_t parsetime)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _mapModels[key] = ModelEntry(fullfilename, model);
+        _stats.numentries = _mapModels.size();
+        _stats.nummisses += 1;
+        _stats.parsetime += parsetime;
+    }
+
+    /// \param instantiatetime microseconds spent creating a robot from a cached model
+    void AddHit(uint64_t instantiatetime)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        _stats.numhits += 1;
+        _stats.instantiatetime += instantiatetime;
+    }
+
+    /// \brief removes the models read from uri, or all the models if uri is empty
+    ///
+    /// \return the number of models removed
+    size_t Evict(const std::string& uri)
+    {
+        std::string fullfilename;
+        if( uri.size() > 0 ) {
+            fullfilename = RaveFindLocalFile(uri);
+        }
+        boost::mutex::scoped_lock lock(_mutex);
+        size_t numevicted = 0;
+        std::map<std::string, ModelEntry>::iterator it = _mapModels.begin();
+        while(it != _mapModels.end()) {
+            if( uri.size() == 0 || it->second.first == uri || it->second.first == fullfilename ) {
+                _mapModels.erase(it++);
+                ++numevicted;
+            }
+            else {
+                ++it;
+            }
+        }
+        _stats.numentries = _mapModels.size();
+        return numevicted;
+    }
+
+    KinematicModelCacheStatistics GetStatistics()
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        return _stats;
+    }
+
+private:
+    typedef std::pair<std::string, KinematicModelConstPtr> ModelEntry; ///< resolved filename and model
+
+    boost::mutex _mutex;
+    std::map<std::string, ModelEntry> _mapModels; ///< indexed by GetKey
+    KinematicModelCacheStatistics _stats;
+    std::atomic<bool> _bEnabled; ///< read without _mutex by every ReadRobotURI
+};
+
+/// \brief the cache shared by all environments of the process
+KinematicModelCache& GetKinematicModelCache();
+
+} // end namespace OpenRAVE
+
+#endif
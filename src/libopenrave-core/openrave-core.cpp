@@ -26,6 +26,23 @@ EnvironmentBasePtr RaveCreateEnvironment(int options) {
 EnvironmentBasePtr CreateEnvironment(bool bLoadAllPlugins) {
     return RaveCreateEnvironment();
 }
+
+KinematicModelCache& GetKinematicModelCache() {
+    static KinematicModelCache s_cache;
+    return s_cache;
+}
+
+void RaveSetKinematicModelCacheEnabled(bool bEnabled) {
+    GetKinematicModelCache().SetEnabled(bEnabled);
+}
+
+KinematicModelCacheStatistics RaveGetKinematicModelCacheStatistics() {
+    return GetKinematicModelCache().GetStatistics();
+}
+
+size_t RaveEvictKinematicModelCache(const std::string& uri) {
+    return GetKinematicModelCache().Evict(uri);
+}
 }
 
 #if !defined(OPENRAVE_IS_ASSIMP3) && !defined(OPENRAVE_ASSIMP)
@@ -49,6 +49,40 @@ OPENRAVE_CORE_API EnvironmentBasePtr RaveCreateEnvironment(int options=ECO_Start
 /// \deprecated (10/09/23) see \ref RaveCreateEnvironment
 OPENRAVE_CORE_API EnvironmentBasePtr CreateEnvironment(bool bLoadAllPlugins=true) RAVE_DEPRECATED;
 
+/// \brief Load statistics of the kinematic model cache, see \ref RaveSetKinematicModelCacheEnabled
+class OPENRAVE_CORE_API KinematicModelCacheStatistics
+{
+public:
+    KinematicModelCacheStatistics() : numentries(0), numhits(0), nummisses(0), parsetime(0), instantiatetime(0) {
+    }
+    size_t numentries; ///< number of cached models
+    uint64_t numhits; ///< number of robots created from a cached model
+    uint64_t nummisses; ///< number of robots read from their file and then cached
+    uint64_t parsetime; ///< total microseconds spent reading the files of the misses
+    uint64_t instantiatetime; ///< total microseconds spent creating the robots of the hits
+};
+
+/// \brief Enables the process-wide cache of the robots read with \ref EnvironmentBase::ReadRobotURI. Disabled by default.
+///
+/// The first time a robot file is read, the link, joint, manipulator, sensor and gripper infos of the robot are
+/// cached, including the collision meshes of the geometries. Reading the same file with the same attributes again,
+/// from any environment, initializes the robot from the cached infos instead of parsing the file and importing its
+/// meshes. Only the parsing is saved: every robot created from the cache still holds its own copy of the infos and
+/// collision meshes. A model is read again when the modification time or the size of the file or of one of the mesh
+/// files of its geometries changes. Other files that the robot file includes, like the kinbody files of a robot xml,
+/// are not checked, so call \ref RaveEvictKinematicModelCache after modifying them. Robots with custom XML readables,
+/// connected bodies or trajectory joints are never cached.
+OPENRAVE_CORE_API void RaveSetKinematicModelCacheEnabled(bool bEnabled);
+
+/// \brief Returns the load statistics of the kinematic model cache.
+OPENRAVE_CORE_API KinematicModelCacheStatistics RaveGetKinematicModelCacheStatistics();
+
+/// \brief Removes the cached models of a file from the kinematic model cache.
+///
+/// \param uri the file the models were read from, if empty removes all the models
+/// \return the number of models removed
+OPENRAVE_CORE_API size_t RaveEvictKinematicModelCache(const std::string& uri=std::string());
+
 } // end namespace OpenRAVE
 
 #endif
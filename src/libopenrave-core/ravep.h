@@ -50,6 +50,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 
 #define FOREACH(it, v) for(typeof((v).begin())it = (v).begin(); it != (v).end(); (it)++)
 #define FOREACH_NOINC(it, v) for(typeof((v).begin())it = (v).begin(); it != (v).end(); )
@@ -306,6 +307,8 @@ bool CreateGeometries(EnvironmentBasePtr penv, const std::string& filename, cons
 #include <boost/array.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/tss.hpp>
 #include <boost/thread/condition.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/assert.hpp>
@@ -958,7 +958,7 @@ public:
                     // directly apply transform to all geomteries
                     Transform tnew = _plink->GetTransform();
                     FOREACH(itgeom, _plink->_vGeometries) {
-                        (*itgeom)->_info._t = tnew * (*itgeom)->_info._t;
+                        (*itgeom)->_GetInfoToModify()._t = tnew * (*itgeom)->GetTransform();
                     }
                     _plink->_collision.ApplyTransform(tnew);
                     _plink->SetTransform(tOrigTrans);
@@ -1074,7 +1074,7 @@ public:
 
                         // call before attaching the geom
                         KinBody::Link::GeometryPtr geom(new KinBody::Link::Geometry(_plink,*info));
-                        geom->_info.InitCollisionMesh();
+                        geom->_GetInfoToModify().InitCollisionMesh();
                         FOREACH(it,info->_meshcollision.vertices) {
                             *it = tmres * *it;
                         }
@@ -2321,7 +2321,7 @@ public:
                 // overwrite the color
                 FOREACH(itlink, _pchain->_veclinks) {
                     FOREACH(itgeom, (*itlink)->_vGeometries) {
-                        (*itgeom)->_info._vDiffuseColor = _diffusecol;
+                        (*itgeom)->_GetInfoToModify()._vDiffuseColor = _diffusecol;
                     }
                 }
             }
@@ -2329,7 +2329,7 @@ public:
                 // overwrite the color
                 FOREACH(itlink, _pchain->_veclinks) {
                     FOREACH(itgeom, (*itlink)->_vGeometries) {
-                        (*itgeom)->_info._vAmbientColor = _ambientcol;
+                        (*itgeom)->_GetInfoToModify()._vAmbientColor = _ambientcol;
                     }
                 }
             }
@@ -2337,7 +2337,7 @@ public:
                 // overwrite the color
                 FOREACH(itlink, _pchain->_veclinks) {
                     FOREACH(itgeom, (*itlink)->_vGeometries) {
-                        (*itgeom)->_info._fTransparency = _transparency;
+                        (*itgeom)->_GetInfoToModify()._fTransparency = _transparency;
                     }
                 }
             }
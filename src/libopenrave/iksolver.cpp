@@ -164,6 +164,18 @@ bool IkSolverBase::SolveAll(const IkParameterization& param, const std::vector<d
     return vsolutions.size() > 0;
 }
 
+int IkSolverBase::SolveAllBatch(const std::vector<IkParameterization>& vparams, int filteroptions, std::vector< std::vector< std::vector<dReal> > >& vsolutions)
+{
+    vsolutions.resize(vparams.size());
+    int numsolved = 0;
+    for(size_t i = 0; i < vparams.size(); ++i) {
+        if( SolveAll(vparams[i], filteroptions, vsolutions[i]) ) {
+            ++numsolved;
+        }
+    }
+    return numsolved;
+}
+
 UserDataPtr IkSolverBase::RegisterCustomFilter(int32_t priority, const IkSolverBase::IkFilterCallbackFn &filterfn)
 {
     CustomIkSolverFilterDataPtr pdata(new CustomIkSolverFilterData(priority,filterfn,shared_iksolver()));
@@ -16,6 +16,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "libopenrave.h"
 #include <algorithm>
+#include <boost/thread/tss.hpp>
 
 // used for functions that are also used internally
 #define CHECK_NO_INTERNAL_COMPUTATION OPENRAVE_ASSERT_FORMAT(_nHierarchyComputed == 0, "body %s cannot be added to environment when doing this operation, current value is %d", GetName()%_nHierarchyComputed, ORE_InvalidState);
@@ -33,14 +34,47 @@ public:
         KinBodyConstPtr pbody = _pweakbody.lock();
         if( !!pbody ) {
             boost::unique_lock< boost::shared_mutex > lock(pbody->GetInterfaceMutex());
-            FOREACH(itinfo, _iterators) {
-                pbody->_vlistRegisteredCallbacks.at(itinfo->first).erase(itinfo->second);
+            _UpdateTable(*pbody, UserDataPtr());
+        }
+    }
+
+    /// \brief replaces the callback table of the body with a copy where pdata is added to the _properties bits and the expired callbacks of those bits are removed.
+    ///
+    /// Has to be called with the interface mutex of the body locked so that concurrent registrations are not lost.
+    void _UpdateTable(const KinBody& body, UserDataPtr pdata) const
+    {
+        KinBody::ChangeCallbackTableConstPtr poldtable = boost::atomic_load(&body._pRegisteredCallbacks);
+        boost::shared_ptr<KinBody::ChangeCallbackTable> ptable(new KinBody::ChangeCallbackTable());
+        if( !!poldtable ) {
+            *ptable = *poldtable;
+        }
+        uint32_t index = 0;
+        uint32_t properties = _properties;
+        while(properties) {
+            if( properties & 1 ) {
+                if( index >= ptable->size() ) {
+                    ptable->resize(index+1);
+                }
+                std::vector<UserDataWeakPtr>& vcallbacks = ptable->at(index);
+                vcallbacks.erase(std::remove_if(vcallbacks.begin(), vcallbacks.end(), boost::bind(&UserDataWeakPtr::expired, _1)), vcallbacks.end());
+                if( !!pdata ) {
+                    vcallbacks.push_back(pdata);
+                }
+            }
+            properties >>= 1;
+            index += 1;
+        }
+        uint32_t registeredproperties = 0;
+        for(size_t i = 0; i < ptable->size(); ++i) {
+            if( ptable->at(i).size() > 0 ) {
+                registeredproperties |= 1u<<i;
             }
         }
+        boost::atomic_store(&body._pRegisteredCallbacks, KinBody::ChangeCallbackTableConstPtr(ptable));
+        body._nRegisteredCallbackProperties.store(registeredproperties);
     }
 
-    list< std::pair<uint32_t, list<UserDataWeakPtr>::iterator> > _iterators;
-    int _properties;
+    uint32_t _properties;
     boost::function<void()> _callback;
 protected:
     boost::weak_ptr<KinBody const> _pweakbody;
@@ -129,11 +163,18 @@ KinBody::KinBody(InterfaceType type, EnvironmentBasePtr penv) : InterfaceBase(ty
 {
     _nHierarchyComputed = 0;
     _nParametersChanged = 0;
+    _nRegisteredCallbackProperties = 0;
+    _nDeferChangeCallbacks = 0;
+    _nDeferredParametersChanged = 0;
     _bMakeJoinedLinksAdjacent = true;
     _environmentid = 0;
     _nNonAdjacentLinkCache = 0x80000000;
     _nUpdateStampId = 0;
     _bAreAllJoints1DOFAndNonCircular = false;
+    _bForwardKinematicsProgramValid = false;
+    _bUseForwardKinematicsProgram = true;
+    RegisterCommand("SetUseForwardKinematicsProgram",boost::bind(&KinBody::_SetUseForwardKinematicsProgramCommand,this,_1,_2),
+                    "[0|1] - if 0, SetDOFValues always uses the generic forward kinematics instead of the precompiled program. Returns the previous value.");
 }
 
 KinBody::~KinBody()
@@ -199,7 +240,7 @@ bool KinBody::InitFromBoxes(const std::vector<AABB>& vaabbs, bool visible, const
         info._vDiffuseColor=Vector(1,0.5f,0.5f,1);
         info._vAmbientColor=Vector(0.1,0.0f,0.0f,0);
         Link::GeometryPtr geom(new Link::Geometry(plink,info));
-        geom->_info.InitCollisionMesh();
+        geom->_GetInfoToModify().InitCollisionMesh();
         numvertices += geom->GetCollisionMesh().vertices.size();
         numindices += geom->GetCollisionMesh().indices.size();
         plink->_vGeometries.push_back(geom);
@@ -241,7 +282,7 @@ bool KinBody::InitFromBoxes(const std::vector<OBB>& vobbs, bool visible, const s
         info._vDiffuseColor=Vector(1,0.5f,0.5f,1);
         info._vAmbientColor=Vector(0.1,0.0f,0.0f,0);
         Link::GeometryPtr geom(new Link::Geometry(plink,info));
-        geom->_info.InitCollisionMesh();
+        geom->_GetInfoToModify().InitCollisionMesh();
         numvertices += geom->GetCollisionMesh().vertices.size();
         numindices += geom->GetCollisionMesh().indices.size();
         plink->_vGeometries.push_back(geom);
@@ -278,7 +319,7 @@ bool KinBody::InitFromSpheres(const std::vector<Vector>& vspheres, bool visible,
         info._vDiffuseColor=Vector(1,0.5f,0.5f,1);
         info._vAmbientColor=Vector(0.1,0.0f,0.0f,0);
         Link::GeometryPtr geom(new Link::Geometry(plink,info));
-        geom->_info.InitCollisionMesh();
+        geom->_GetInfoToModify().InitCollisionMesh();
         plink->_vGeometries.push_back(geom);
         trimesh = geom->GetCollisionMesh();
         trimesh.ApplyTransform(geom->GetTransform());
@@ -331,7 +372,7 @@ bool KinBody::InitFromGeometries(const std::vector<KinBody::GeometryInfoConstPtr
     plink->_info._bStatic = true;
     FOREACHC(itinfo,geometries) {
         Link::GeometryPtr geom(new Link::Geometry(plink,**itinfo));
-        geom->_info.InitCollisionMesh();
+        geom->_GetInfoToModify().InitCollisionMesh();
         plink->_vGeometries.push_back(geom);
         plink->_collision.Append(geom->GetCollisionMesh(),geom->GetTransform());
     }
@@ -959,6 +1000,7 @@ void KinBody::SetTransform(const Transform& trans)
     if( _veclinks.size() == 0 ) {
         return;
     }
+    ConcurrentQueriesWriteGuard concurrentqueriesguard(*GetEnv()); // the concurrent collision queries of the environment cannot run while the links move
     Transform tbaseinv = _veclinks.front()->GetTransform().inverse();
     Transform tapply = trans * tbaseinv;
     FOREACH(itlink, _veclinks) {
@@ -1463,6 +1505,7 @@ void KinBody::SetLinkTransformations(const std::vector<Transform>& vbodies)
         RAVELOG_DEBUG("SetLinkTransformations should be called with doflastsetvalues, re-setting all values\n");
     }
     OPENRAVE_ASSERT_OP_FORMAT(vbodies.size(), >=, _veclinks.size(), "not enough links %d<%d", vbodies.size()%_veclinks.size(),ORE_InvalidArguments);
+    ConcurrentQueriesWriteGuard concurrentqueriesguard(*GetEnv()); // the concurrent collision queries of the environment cannot run while the links move
     vector<Transform>::const_iterator it;
     vector<LinkPtr>::iterator itlink;
     for(it = vbodies.begin(), itlink = _veclinks.begin(); it != vbodies.end(); ++it, ++itlink) {
@@ -1480,6 +1523,7 @@ void KinBody::SetLinkTransformations(const std::vector<Transform>& vbodies)
 void KinBody::SetLinkTransformations(const std::vector<Transform>& transforms, const std::vector<dReal>& doflastsetvalues)
 {
     OPENRAVE_ASSERT_OP_FORMAT(transforms.size(), >=, _veclinks.size(), "not enough links %d<%d", transforms.size()%_veclinks.size(),ORE_InvalidArguments);
+    ConcurrentQueriesWriteGuard concurrentqueriesguard(*GetEnv()); // the concurrent collision queries of the environment cannot run while the links move
     vector<Transform>::const_iterator it;
     vector<LinkPtr>::iterator itlink;
     for(it = transforms.begin(), itlink = _veclinks.begin(); it != transforms.end(); ++it, ++itlink) {
@@ -1503,6 +1547,7 @@ void KinBody::SetLinkVelocities(const std::vector<std::pair<Vector,Vector> >& ve
 void KinBody::SetLinkEnableStates(const std::vector<uint8_t>& enablestates)
 {
     OPENRAVE_ASSERT_OP(enablestates.size(),==,_veclinks.size());
+    ConcurrentQueriesWriteGuard concurrentqueriesguard(*GetEnv());
     bool bchanged = false;
     for(size_t ilink = 0; ilink < enablestates.size(); ++ilink) {
         bool bEnable = enablestates[ilink]!=0;
@@ -1522,6 +1567,7 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, const Transfo
     if( _veclinks.size() == 0 ) {
         return;
     }
+    ConcurrentQueriesWriteGuard concurrentqueriesguard(*GetEnv());
     Transform tbase = transBase*_veclinks.at(0)->GetTransform().inverse();
     _veclinks.at(0)->SetTransform(transBase);
 
@@ -1540,6 +1586,7 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
     }
     int expecteddof = dofindices.size() > 0 ? (int)dofindices.size() : GetDOF();
     OPENRAVE_ASSERT_OP_FORMAT((int)vJointValues.size(),>=,expecteddof, "not enough values %d<%d", vJointValues.size()%GetDOF(),ORE_InvalidArguments);
+    ConcurrentQueriesWriteGuard concurrentqueriesguard(*GetEnv()); // the concurrent collision queries of the environment cannot run while the links move
 
     const dReal* pJointValues = &vJointValues[0];
     if( checklimits != CLA_Nothing || dofindices.size() > 0 ) {
@@ -1556,7 +1603,6 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
         dReal* ptempjoints = &_vTempJoints[0];
 
         // check the limits
-        vector<dReal> upperlim, lowerlim;
         FOREACHC(it, _vecjoints) {
             const dReal* p = pJointValues+(*it)->GetDOFIndex();
             if( checklimits == CLA_Nothing ) {
@@ -1567,7 +1613,8 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
                 continue;
             }
             OPENRAVE_ASSERT_OP( (*it)->GetDOF(), <=, 3 );
-            (*it)->GetLimits(lowerlim, upperlim);
+            const boost::array<dReal,3>& lowerlim = (*it)->_info._vlowerlimit;
+            const boost::array<dReal,3>& upperlim = (*it)->_info._vupperlimit;
             if( (*it)->GetType() == JointSpherical ) {
                 dReal fcurang = fmod(RaveSqrt(p[0]*p[0]+p[1]*p[1]+p[2]*p[2]),2*PI);
                 if( fcurang < lowerlim[0] ) {
@@ -1631,38 +1678,24 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
         pJointValues = &_vTempJoints[0];
     }
 
+    if( _bUseForwardKinematicsProgram ) {
+        if( !_bForwardKinematicsProgramValid ) {
+            _BuildForwardKinematicsProgram();
+        }
+        _RunForwardKinematicsProgram(pJointValues, checklimits);
+        _UpdateGrabbedBodies();
+        _PostprocessChangedParameters(Prop_LinkTransforms);
+        return;
+    }
+
     boost::array<dReal,3> dummyvalues; // dummy values for a joint
-    std::vector<dReal> vtempvalues, veval;
 
     // have to compute the angles ahead of time since they are dependent on the link transformations
-    std::vector< std::vector<dReal> > vPassiveJointValues(_vPassiveJoints.size());
-    for(size_t i = 0; i < vPassiveJointValues.size(); ++i) {
-        if( !_vPassiveJoints[i]->IsMimic() ) {
-            _vPassiveJoints[i]->GetValues(vPassiveJointValues[i]);
-            // check if out of limits!
-            for(size_t j = 0; j < vPassiveJointValues[i].size(); ++j) {
-                if( !_vPassiveJoints[i]->IsCircular(j) ) {
-                    if( vPassiveJointValues[i][j] < _vPassiveJoints[i]->_info._vlowerlimit.at(j) ) {
-                        if( vPassiveJointValues[i][j] < _vPassiveJoints[i]->_info._vlowerlimit.at(j)-5e-4f ) {
-                            RAVELOG_WARN(str(boost::format("dummy joint out of lower limit! %e < %e\n")%_vPassiveJoints[i]->_info._vlowerlimit.at(j)%vPassiveJointValues[i][j]));
-                        }
-                        vPassiveJointValues[i][j] = _vPassiveJoints[i]->_info._vlowerlimit.at(j);
-                    }
-                    else if( vPassiveJointValues[i][j] > _vPassiveJoints[i]->_info._vupperlimit.at(j) ) {
-                        if( vPassiveJointValues[i][j] > _vPassiveJoints[i]->_info._vupperlimit.at(j)+5e-4f ) {
-                            RAVELOG_WARN(str(boost::format("dummy joint out of upper limit! %e > %e\n")%_vPassiveJoints[i]->_info._vupperlimit.at(j)%vPassiveJointValues[i][j]));
-                        }
-                        vPassiveJointValues[i][j] = _vPassiveJoints[i]->_info._vupperlimit.at(j);
-                    }
-                }
-            }
-        }
-        else {
-            vPassiveJointValues[i].reserve(_vPassiveJoints[i]->GetDOF()); // do not resize so that we can catch hierarchy errors
-        }
-    }
+    _ComputePassiveJointValues(_vPassiveJointValuesCache, _vTempPassiveJointValues);
 
-    std::vector<uint8_t> vlinkscomputed(_veclinks.size(),0);
+    std::vector<uint8_t>& vlinkscomputed = _vLinksComputedCache;
+    vlinkscomputed.resize(0);
+    vlinkscomputed.resize(_veclinks.size(),0);
     vlinkscomputed[0] = 1;
 
     for(size_t ijoint = 0; ijoint < _vTopologicallySortedJointsAll.size(); ++ijoint) {
@@ -1670,107 +1703,22 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
         int jointindex = _vTopologicallySortedJointIndicesAll[ijoint];
         int dofindex = pjoint->GetDOFIndex();
         const dReal* pvalues=dofindex >= 0 ? pJointValues + dofindex : NULL;
+        dReal* ppassivevalues = dofindex < 0 ? &_vPassiveJointValuesCache.at(3*(jointindex-(int)_vecjoints.size())) : NULL;
         if( pjoint->IsMimic() ) {
             for(int i = 0; i < pjoint->GetDOF(); ++i) {
                 if( pjoint->IsMimic(i) ) {
-                    vtempvalues.resize(0);
-                    const std::vector<Mimic::DOFFormat>& vdofformat = pjoint->_vmimic[i]->_vdofformat;
-                    FOREACHC(itdof,vdofformat) {
-                        if( itdof->dofindex >= 0 ) {
-                            vtempvalues.push_back(pJointValues[itdof->dofindex]);
-                        }
-                        else {
-                            vtempvalues.push_back(vPassiveJointValues.at(itdof->jointindex-_vecjoints.size()).at(itdof->axis));
-                        }
-                    }
-                    int err = pjoint->_Eval(i, 0, vtempvalues, veval);
-                    if( err ) {
-                        RAVELOG_WARN(str(boost::format("failed to evaluate joint %s, fparser error %d")%pjoint->GetName()%err));
-                    }
-                    else {
-                        vector<dReal> vevalcopy = veval;
-                        vector<dReal>::iterator iteval = veval.begin();
-                        while(iteval != veval.end()) {
-                            bool removevalue = false;
-                            if( pjoint->GetType() == JointSpherical || pjoint->IsCircular(i) ) {
-                            }
-                            else if( *iteval < pjoint->_info._vlowerlimit[i] ) {
-                                if(*iteval >= pjoint->_info._vlowerlimit[i]-g_fEpsilonJointLimit ) {
-                                    *iteval = pjoint->_info._vlowerlimit[i];
-                                }
-                                else {
-                                    removevalue=true;
-                                }
-                            }
-                            else if( *iteval > pjoint->_info._vupperlimit[i] ) {
-                                if(*iteval <= pjoint->_info._vupperlimit[i]+g_fEpsilonJointLimit ) {
-                                    *iteval = pjoint->_info._vupperlimit[i];
-                                }
-                                else {
-                                    removevalue=true;
-                                }
-                            }
-
-                            if( removevalue ) {
-                                iteval = veval.erase(iteval); // invalid value so remove from candidates
-                            }
-                            else {
-                                ++iteval;
-                            }
-                        }
-
-                        if( veval.empty() ) {
-                            FORIT(iteval,vevalcopy) {
-                                if( checklimits == CLA_Nothing || pjoint->GetType() == JointSpherical || pjoint->IsCircular(i) ) {
-                                    veval.push_back(*iteval);
-                                }
-                                else if( *iteval < pjoint->_info._vlowerlimit[i]-g_fEpsilonEvalJointLimit ) {
-                                    veval.push_back(pjoint->_info._vlowerlimit[i]);
-                                    if( checklimits == CLA_CheckLimits ) {
-                                        RAVELOG_WARN(str(boost::format("joint %s: lower limit (%e) is not followed: %e")%pjoint->GetName()%pjoint->_info._vlowerlimit[i]%*iteval));
-                                    }
-                                    else if( checklimits == CLA_CheckLimitsThrow ) {
-                                        throw OPENRAVE_EXCEPTION_FORMAT(_("joint %s: lower limit (%e) is not followed: %e"), pjoint->GetName()%pjoint->_info._vlowerlimit[i]%*iteval, ORE_InvalidArguments);
-                                    }
-                                }
-                                else if( *iteval > pjoint->_info._vupperlimit[i]+g_fEpsilonEvalJointLimit ) {
-                                    veval.push_back(pjoint->_info._vupperlimit[i]);
-                                    if( checklimits == CLA_CheckLimits ) {
-                                        RAVELOG_WARN(str(boost::format("joint %s: upper limit (%e) is not followed: %e")%pjoint->GetName()%pjoint->_info._vupperlimit[i]%*iteval));
-                                    }
-                                    else if( checklimits == CLA_CheckLimitsThrow ) {
-                                        throw OPENRAVE_EXCEPTION_FORMAT(_("joint %s: upper limit (%e) is not followed: %e"), pjoint->GetName()%pjoint->_info._vupperlimit[i]%*iteval, ORE_InvalidArguments);
-                                    }
-                                }
-                                else {
-                                    veval.push_back(*iteval);
-                                }
-                            }
-                            OPENRAVE_ASSERT_FORMAT(!veval.empty(), "no valid values for joint %s", pjoint->GetName(),ORE_Assert);
-                        }
-                        if( veval.size() > 1 ) {
-                            stringstream ss; ss << std::setprecision(std::numeric_limits<dReal>::digits10+1);
-                            ss << "multiplie values for joint " << pjoint->GetName() << ": ";
-                            FORIT(iteval,veval) {
-                                ss << *iteval << " ";
-                            }
-                            RAVELOG_WARN(ss.str());
-                        }
-                        dummyvalues[i] = veval.at(0);
-                    }
-
+                    _EvalMimicJointValue(*pjoint, i, pJointValues, &_vPassiveJointValuesCache[0], checklimits, dummyvalues[i]);
                     // if joint is passive, update the stored joint values! This is necessary because joint value might be referenced in the future.
                     if( dofindex < 0 ) {
-                        vPassiveJointValues.at(jointindex-(int)_vecjoints.size()).resize(pjoint->GetDOF());
-                        vPassiveJointValues.at(jointindex-(int)_vecjoints.size()).at(i) = dummyvalues[i];
+                        ppassivevalues[i] = dummyvalues[i];
                     }
                 }
                 else if( dofindex >= 0 ) {
-                    dummyvalues[i] = pvalues[dofindex+i]; // is this correct? what is a joint has a mimic and non-mimic axis?
+                    dummyvalues[i] = pJointValues[dofindex+i];
                 }
                 else {
                     // preserve passive joint values
-                    dummyvalues[i] = vPassiveJointValues.at(jointindex-(int)_vecjoints.size()).at(i);
+                    dummyvalues[i] = ppassivevalues[i];
                 }
             }
             pvalues = &dummyvalues[0];
@@ -1781,9 +1729,8 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
         }
         if( !pvalues ) {
             // has to be a passive joint
-            pvalues = &vPassiveJointValues.at(jointindex-(int)_vecjoints.size()).at(0);
+            pvalues = ppassivevalues;
         }
-
         Transform tjoint;
         if( pjoint->GetType() & JointSpecialBit ) {
             switch(pjoint->GetType()) {
@@ -1864,6 +1811,521 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
     _PostprocessChangedParameters(Prop_LinkTransforms);
 }
 
+void KinBody::_ComputePassiveJointValues(std::vector<dReal>& vPassiveJointValues, std::vector<dReal>& vtempvalues) const
+{
+    vPassiveJointValues.resize(3*_vPassiveJoints.size());
+    for(size_t i = 0; i < _vPassiveJoints.size(); ++i) {
+        const Joint& joint = *_vPassiveJoints[i];
+        if( joint.IsMimic() ) {
+            continue; // computed by the forward kinematics
+        }
+        joint.GetValues(vtempvalues);
+        dReal* pvalues = &vPassiveJointValues[3*i];
+        for(size_t j = 0; j < vtempvalues.size(); ++j) {
+            pvalues[j] = vtempvalues[j];
+            // check if out of limits!
+            if( !joint.IsCircular(j) ) {
+                if( pvalues[j] < joint._info._vlowerlimit.at(j) ) {
+                    if( pvalues[j] < joint._info._vlowerlimit.at(j)-5e-4f ) {
+                        RAVELOG_WARN(str(boost::format("dummy joint out of lower limit! %e < %e\n")%joint._info._vlowerlimit.at(j)%pvalues[j]));
+                    }
+                    pvalues[j] = joint._info._vlowerlimit.at(j);
+                }
+                else if( pvalues[j] > joint._info._vupperlimit.at(j) ) {
+                    if( pvalues[j] > joint._info._vupperlimit.at(j)+5e-4f ) {
+                        RAVELOG_WARN(str(boost::format("dummy joint out of upper limit! %e > %e\n")%joint._info._vupperlimit.at(j)%pvalues[j]));
+                    }
+                    pvalues[j] = joint._info._vupperlimit.at(j);
+                }
+            }
+        }
+    }
+}
+
+bool KinBody::_EvalMimicJointValue(Joint& joint, int iaxis, const dReal* pJointValues, const dReal* pPassiveJointValues, uint32_t checklimits, dReal& fvalue) const
+{
+    std::vector<dReal>& vtempvalues = _vTempMimicValues;
+    std::vector<dReal>& veval = _vTempMimicEval;
+    vtempvalues.resize(0);
+    const std::vector<Mimic::DOFFormat>& vdofformat = joint._vmimic[iaxis]->_vdofformat;
+    FOREACHC(itdof,vdofformat) {
+        if( itdof->dofindex >= 0 ) {
+            vtempvalues.push_back(pJointValues[itdof->dofindex]);
+        }
+        else {
+            vtempvalues.push_back(pPassiveJointValues[3*(itdof->jointindex-(int)_vecjoints.size())+itdof->axis]);
+        }
+    }
+    int err = joint._Eval(iaxis, 0, vtempvalues, veval);
+    if( err ) {
+        RAVELOG_WARN(str(boost::format("failed to evaluate joint %s, fparser error %d")%joint.GetName()%err));
+        return false;
+    }
+
+    std::vector<dReal>& vevalcopy = _vTempMimicEvalCopy;
+    vevalcopy = veval;
+    vector<dReal>::iterator iteval = veval.begin();
+    while(iteval != veval.end()) {
+        bool removevalue = false;
+        if( joint.GetType() == JointSpherical || joint.IsCircular(iaxis) ) {
+        }
+        else if( *iteval < joint._info._vlowerlimit[iaxis] ) {
+            if(*iteval >= joint._info._vlowerlimit[iaxis]-g_fEpsilonJointLimit ) {
+                *iteval = joint._info._vlowerlimit[iaxis];
+            }
+            else {
+                removevalue=true;
+            }
+        }
+        else if( *iteval > joint._info._vupperlimit[iaxis] ) {
+            if(*iteval <= joint._info._vupperlimit[iaxis]+g_fEpsilonJointLimit ) {
+                *iteval = joint._info._vupperlimit[iaxis];
+            }
+            else {
+                removevalue=true;
+            }
+        }
+
+        if( removevalue ) {
+            iteval = veval.erase(iteval); // invalid value so remove from candidates
+        }
+        else {
+            ++iteval;
+        }
+    }
+
+    if( veval.empty() ) {
+        FORIT(iteval,vevalcopy) {
+            if( checklimits == CLA_Nothing || joint.GetType() == JointSpherical || joint.IsCircular(iaxis) ) {
+                veval.push_back(*iteval);
+            }
+            else if( *iteval < joint._info._vlowerlimit[iaxis]-g_fEpsilonEvalJointLimit ) {
+                veval.push_back(joint._info._vlowerlimit[iaxis]);
+                if( checklimits == CLA_CheckLimits ) {
+                    RAVELOG_WARN(str(boost::format("joint %s: lower limit (%e) is not followed: %e")%joint.GetName()%joint._info._vlowerlimit[iaxis]%*iteval));
+                }
+                else if( checklimits == CLA_CheckLimitsThrow ) {
+                    throw OPENRAVE_EXCEPTION_FORMAT(_("joint %s: lower limit (%e) is not followed: %e"), joint.GetName()%joint._info._vlowerlimit[iaxis]%*iteval, ORE_InvalidArguments);
+                }
+            }
+            else if( *iteval > joint._info._vupperlimit[iaxis]+g_fEpsilonEvalJointLimit ) {
+                veval.push_back(joint._info._vupperlimit[iaxis]);
+                if( checklimits == CLA_CheckLimits ) {
+                    RAVELOG_WARN(str(boost::format("joint %s: upper limit (%e) is not followed: %e")%joint.GetName()%joint._info._vupperlimit[iaxis]%*iteval));
+                }
+                else if( checklimits == CLA_CheckLimitsThrow ) {
+                    throw OPENRAVE_EXCEPTION_FORMAT(_("joint %s: upper limit (%e) is not followed: %e"), joint.GetName()%joint._info._vupperlimit[iaxis]%*iteval, ORE_InvalidArguments);
+                }
+            }
+            else {
+                veval.push_back(*iteval);
+            }
+        }
+        OPENRAVE_ASSERT_FORMAT(!veval.empty(), "no valid values for joint %s", joint.GetName(),ORE_Assert);
+    }
+    if( veval.size() > 1 ) {
+        stringstream ss; ss << std::setprecision(std::numeric_limits<dReal>::digits10+1);
+        ss << "multiplie values for joint " << joint.GetName() << ": ";
+        FORIT(iteval,veval) {
+            ss << *iteval << " ";
+        }
+        RAVELOG_WARN(ss.str());
+    }
+    fvalue = veval.at(0);
+    return true;
+}
+
+void KinBody::_BuildForwardKinematicsProgram() const
+{
+    _vForwardKinematicsProgram.resize(0);
+    if( _veclinks.size() == 0 ) {
+        _bForwardKinematicsProgramValid = true;
+        return;
+    }
+    _vPassiveJointValuesCache.resize(3*_vPassiveJoints.size());
+    _vTempPassiveJointValues.reserve(3); // Joint::GetValues returns at most 3 values, so will not allocate later
+
+    // the hierarchy is static, so can decide here which joints end up setting their child link (closed loops only set a link once)
+    std::vector<uint8_t> vlinkscomputed(_veclinks.size(),0);
+    vlinkscomputed[0] = 1;
+    _vForwardKinematicsProgram.reserve(_vTopologicallySortedJointsAll.size());
+    for(size_t ijoint = 0; ijoint < _vTopologicallySortedJointsAll.size(); ++ijoint) {
+        const JointPtr& pjoint = _vTopologicallySortedJointsAll[ijoint];
+        int childlinkindex = pjoint->GetHierarchyChildLink()->GetIndex();
+        if( vlinkscomputed[childlinkindex] ) {
+            if( !pjoint->IsMimic() ) {
+                continue;
+            }
+            // still have to evaluate the mimic values since other joints can reference them
+            childlinkindex = -1;
+        }
+        else {
+            vlinkscomputed[childlinkindex] = 1;
+        }
+
+        ForwardKinematicsOp op;
+        op.pjoint = pjoint.get();
+        op.type = pjoint->GetType();
+        op.dof = pjoint->GetDOF();
+        op.dofindex = pjoint->GetDOFIndex();
+        op.passiveindex = op.dofindex >= 0 ? -1 : _vTopologicallySortedJointIndicesAll[ijoint]-(int)_vecjoints.size();
+        op.parentlinkindex = !pjoint->GetHierarchyParentLink() ? -1 : pjoint->GetHierarchyParentLink()->GetIndex();
+        op.childlinkindex = childlinkindex;
+        op.bmimic = pjoint->IsMimic();
+        for(int iaxis = 0; iaxis < 3; ++iaxis) {
+            op.vmimic[iaxis] = iaxis < op.dof && pjoint->IsMimic(iaxis);
+            op.vrevolute[iaxis] = iaxis < op.dof && pjoint->IsRevolute(iaxis);
+            op.vaxes[iaxis] = iaxis < op.dof ? pjoint->GetInternalHierarchyAxis(iaxis) : Vector();
+        }
+        op.tleft = pjoint->GetInternalHierarchyLeftTransform();
+        op.tright = pjoint->GetInternalHierarchyRightTransform();
+        _vForwardKinematicsProgram.push_back(op);
+    }
+    // set last so that ComputeLinkTransformationsBatch never sees a half built program
+    _bForwardKinematicsProgramValid = true;
+}
+
+Transform KinBody::_ComputeJointTransform(const ForwardKinematicsOp& op, const dReal* pvalues, std::vector<dReal>& vtempdata) const
+{
+    Transform tjoint;
+    switch(op.type) {
+    case JointRevolute:
+        tjoint.rot = quatFromAxisAngle(op.vaxes[0], pvalues[0]);
+        break;
+    case JointPrismatic:
+        tjoint.trans = op.vaxes[0] * pvalues[0];
+        break;
+    case JointHinge2: {
+        Transform tfirst;
+        tfirst.rot = quatFromAxisAngle(op.vaxes[0], pvalues[0]);
+        Transform tsecond;
+        tsecond.rot = quatFromAxisAngle(tfirst.rotate(op.vaxes[1]), pvalues[1]);
+        tjoint = tsecond * tfirst;
+        break;
+    }
+    case JointSpherical: {
+        dReal fang = pvalues[0]*pvalues[0]+pvalues[1]*pvalues[1]+pvalues[2]*pvalues[2];
+        if( fang > 0 ) {
+            fang = RaveSqrt(fang);
+            dReal fiang = 1/fang;
+            tjoint.rot = quatFromAxisAngle(Vector(pvalues[0]*fiang,pvalues[1]*fiang,pvalues[2]*fiang),fang);
+        }
+        break;
+    }
+    case JointTrajectory: {
+        const Joint& joint = *op.pjoint;
+        dReal fvalue = pvalues[0];
+        if( joint.IsCircular(0) ) {
+            // need to normalize the value
+            fvalue = utils::NormalizeCircularAngle(fvalue,joint._vcircularlowerlimit.at(0), joint._vcircularupperlimit.at(0));
+        }
+        joint._info._trajfollow->Sample(vtempdata,fvalue);
+        if( !joint._info._trajfollow->GetConfigurationSpecification().ExtractTransform(tjoint,vtempdata.begin(),KinBodyConstPtr()) ) {
+            RAVELOG_WARN(str(boost::format("trajectory sampling for joint %s failed")%joint.GetName()));
+        }
+        break;
+    }
+    default:
+        if( op.type & JointSpecialBit ) {
+            RAVELOG_WARN(str(boost::format("forward kinematic type 0x%x not supported")%op.type));
+            break;
+        }
+        for(int iaxis = 0; iaxis < op.dof; ++iaxis) {
+            Transform tdelta;
+            if( op.vrevolute[iaxis] ) {
+                tdelta.rot = quatFromAxisAngle(op.vaxes[iaxis], pvalues[iaxis]);
+            }
+            else {
+                tdelta.trans = op.vaxes[iaxis] * pvalues[iaxis];
+            }
+            tjoint = tjoint * tdelta;
+        }
+        break;
+    }
+    return tjoint;
+}
+
+void KinBody::_RunForwardKinematicsProgram(const dReal* pJointValues, uint32_t checklimits)
+{
+    // have to compute the angles ahead of time since they are dependent on the link transformations
+    _ComputePassiveJointValues(_vPassiveJointValuesCache, _vTempPassiveJointValues);
+
+    boost::array<dReal,3> dummyvalues; // values of joints with mimic axes
+    const Transform tbase = _veclinks[0]->GetTransform();
+    FOREACHC(itop, _vForwardKinematicsProgram) {
+        dReal* ppassivevalues = itop->passiveindex >= 0 ? &_vPassiveJointValuesCache[3*itop->passiveindex] : NULL;
+        const dReal* pvalues = itop->dofindex >= 0 ? pJointValues + itop->dofindex : ppassivevalues;
+        if( itop->bmimic ) {
+            for(int i = 0; i < itop->dof; ++i) {
+                if( itop->vmimic[i] ) {
+                    _EvalMimicJointValue(*itop->pjoint, i, pJointValues, &_vPassiveJointValuesCache[0], checklimits, dummyvalues[i]);
+                    if( !!ppassivevalues ) {
+                        ppassivevalues[i] = dummyvalues[i]; // can be referenced by other mimic joints
+                    }
+                }
+                else {
+                    dummyvalues[i] = pvalues[i];
+                }
+            }
+            pvalues = &dummyvalues[0];
+        }
+        if( itop->childlinkindex < 0 ) {
+            continue;
+        }
+
+        Transform tjoint = _ComputeJointTransform(*itop, pvalues, _vTempMimicValues);
+        if( itop->type == JointTrajectory ) {
+            itop->pjoint->_doflastsetvalues[0] = 0;
+        }
+        else if( itop->type != JointUniversal ) {
+            for(int iaxis = 0; iaxis < itop->dof; ++iaxis) {
+                if( itop->vrevolute[iaxis] ) {
+                    itop->pjoint->_doflastsetvalues[iaxis] = pvalues[iaxis];
+                }
+            }
+        }
+
+        const Transform& tparent = itop->parentlinkindex >= 0 ? _veclinks[itop->parentlinkindex]->GetTransform() : tbase;
+        _veclinks[itop->childlinkindex]->SetTransform(tparent * (itop->tleft * tjoint * itop->tright));
+    }
+}
+
+/// \brief number of configurations ComputeLinkTransformationsBatch evaluates at once, bounds the size of the structure-of-arrays buffers
+static const size_t s_nLinkTransformationsBatchSize = 64;
+
+/// \brief scratch space of ComputeLinkTransformationsBatch
+struct LinkTransformationsBatchBuffers
+{
+    std::vector<dReal> vlinktransforms, vjointtransforms, vjointvalues, vpassivejointvalues; ///< structure-of-arrays buffers of one block
+    std::vector<dReal> vcurrentpassivejointvalues, vtempvalues;
+};
+
+/// \brief every thread has its own buffers so that several threads can call ComputeLinkTransformationsBatch on the same body
+static boost::thread_specific_ptr<LinkTransformationsBatchBuffers> s_plinktransformationsbatchbuffers;
+
+/// \brief reads a transform that is the same for all configurations through the same interface as TransformArrayAccessor
+class ConstantTransformAccessor
+{
+public:
+    ConstantTransformAccessor(const Transform& t) {
+        _v[0] = t.rot.x; _v[1] = t.rot.y; _v[2] = t.rot.z; _v[3] = t.rot.w;
+        _v[4] = t.trans.x; _v[5] = t.trans.y; _v[6] = t.trans.z;
+    }
+    inline dReal operator()(int icomponent, size_t) const {
+        return _v[icomponent];
+    }
+private:
+    dReal _v[7];
+};
+
+/// \brief reads transforms stored in structure-of-arrays layout, component c (quaternion then translation) of transform k is at p[c*stride+k]
+class TransformArrayAccessor
+{
+public:
+    TransformArrayAccessor(const dReal* p, size_t stride) : _p(p), _stride(stride) {
+    }
+    inline dReal operator()(int icomponent, size_t k) const {
+        return _p[icomponent*_stride+k];
+    }
+private:
+    const dReal* _p;
+    size_t _stride;
+};
+
+/// \brief pout[k] = left[k] * right[k] for transforms in structure-of-arrays layout. pout can alias right or left.
+///
+/// The loop body has no branches so that the compiler can vectorize it across configurations.
+template <typename L, typename R>
+static void MultiplyTransformArrays(const L& left, const R& right, dReal* pout, size_t stride, size_t num, bool bnormalize)
+{
+    for(size_t k = 0; k < num; ++k) {
+        dReal lqw = left(0,k), lqx = left(1,k), lqy = left(2,k), lqz = left(3,k);
+        dReal rqw = right(0,k), rqx = right(1,k), rqy = right(2,k), rqz = right(3,k);
+        dReal rtx = right(4,k), rty = right(5,k), rtz = right(6,k);
+        // same as RaveTransform::rotate
+        dReal xx = 2*lqx*lqx, xy = 2*lqx*lqy, xz = 2*lqx*lqz, xw = 2*lqx*lqw;
+        dReal yy = 2*lqy*lqy, yz = 2*lqy*lqz, yw = 2*lqy*lqw;
+        dReal zz = 2*lqz*lqz, zw = 2*lqz*lqw;
+        dReal tx = left(4,k) + (1-yy-zz)*rtx + (xy-zw)*rty + (xz+yw)*rtz;
+        dReal ty = left(5,k) + (xy+zw)*rtx + (1-xx-zz)*rty + (yz-xw)*rtz;
+        dReal tz = left(6,k) + (xz-yw)*rtx + (yz+xw)*rty + (1-xx-yy)*rtz;
+        dReal qw = lqw*rqw - lqx*rqx - lqy*rqy - lqz*rqz;
+        dReal qx = lqw*rqx + lqx*rqw + lqy*rqz - lqz*rqy;
+        dReal qy = lqw*rqy + lqy*rqw + lqz*rqx - lqx*rqz;
+        dReal qz = lqw*rqz + lqz*rqw + lqx*rqy - lqy*rqx;
+        if( bnormalize ) {
+            dReal fnorm = 1/RaveSqrt(qw*qw+qx*qx+qy*qy+qz*qz);
+            qw *= fnorm; qx *= fnorm; qy *= fnorm; qz *= fnorm;
+        }
+        pout[k] = qw; pout[stride+k] = qx; pout[2*stride+k] = qy; pout[3*stride+k] = qz;
+        pout[4*stride+k] = tx; pout[5*stride+k] = ty; pout[6*stride+k] = tz;
+    }
+}
+
+void KinBody::ComputeLinkTransformationsBatch(const dReal* pconfigs, size_t numconfigs, Transform* ptransforms) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    if( numconfigs == 0 || _veclinks.size() == 0 ) {
+        return;
+    }
+    if( !_bForwardKinematicsProgramValid ) {
+        boost::mutex::scoped_lock lock(_mutexForwardKinematicsProgram);
+        if( !_bForwardKinematicsProgramValid ) {
+            _BuildForwardKinematicsProgram();
+        }
+    }
+
+    if( !s_plinktransformationsbatchbuffers.get() ) {
+        s_plinktransformationsbatchbuffers.reset(new LinkTransformationsBatchBuffers());
+    }
+    LinkTransformationsBatchBuffers& buffers = *s_plinktransformationsbatchbuffers;
+
+    const size_t numlinks = _veclinks.size();
+    const size_t numdof = GetDOF();
+    const size_t numpassivevalues = 3*_vPassiveJoints.size();
+    const size_t stride = std::min(numconfigs, s_nLinkTransformationsBatchSize);
+    buffers.vlinktransforms.resize(7*numlinks*stride);
+    buffers.vjointtransforms.resize(7*stride);
+    buffers.vjointvalues.resize(3*stride);
+    buffers.vpassivejointvalues.resize(numpassivevalues*stride);
+
+    // the passive joints that are not mimic do not depend on the dof values, so they keep their current values for all configurations
+    _ComputePassiveJointValues(buffers.vcurrentpassivejointvalues, buffers.vtempvalues);
+
+    // the mimic equations and their scratch space are shared by all threads, so have to be evaluated one thread at a time
+    boost::mutex::scoped_lock lockmimic(_mutexForwardKinematicsProgram, boost::defer_lock_t());
+    FOREACHC(itop, _vForwardKinematicsProgram) {
+        if( itop->bmimic ) {
+            lockmimic.lock();
+            break;
+        }
+    }
+
+    boost::array<dReal,3> values;
+    for(size_t blockstart = 0; blockstart < numconfigs; blockstart += stride) {
+        const size_t num = std::min(stride, numconfigs-blockstart);
+        const dReal* pblockconfigs = pconfigs + blockstart*numdof;
+
+        // start from the current transforms, links that are not reached by any joint keep them
+        for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+            ConstantTransformAccessor tlink(_veclinks[ilink]->GetTransform());
+            dReal* plink = &buffers.vlinktransforms[7*ilink*stride];
+            for(int icomponent = 0; icomponent < 7; ++icomponent) {
+                std::fill(plink+icomponent*stride, plink+icomponent*stride+num, tlink(icomponent,0));
+            }
+        }
+        for(size_t k = 0; k < num && numpassivevalues > 0; ++k) {
+            std::copy(buffers.vcurrentpassivejointvalues.begin(), buffers.vcurrentpassivejointvalues.end(), buffers.vpassivejointvalues.begin()+k*numpassivevalues);
+        }
+
+        FOREACHC(itop, _vForwardKinematicsProgram) {
+            for(int iaxis = 0; iaxis < itop->dof; ++iaxis) {
+                dReal* pvalues = &buffers.vjointvalues[iaxis*stride];
+                if( itop->vmimic[iaxis] ) {
+                    for(size_t k = 0; k < num; ++k) {
+                        dReal* ppassivevalues = numpassivevalues > 0 ? &buffers.vpassivejointvalues[k*numpassivevalues] : NULL;
+                        _EvalMimicJointValue(*itop->pjoint, iaxis, pblockconfigs+k*numdof, ppassivevalues, CLA_Nothing, pvalues[k]);
+                        if( itop->passiveindex >= 0 ) {
+                            ppassivevalues[3*itop->passiveindex+iaxis] = pvalues[k]; // can be referenced by other mimic joints
+                        }
+                    }
+                }
+                else if( itop->dofindex >= 0 ) {
+                    const dReal* pconfigvalue = pblockconfigs+itop->dofindex+iaxis;
+                    for(size_t k = 0; k < num; ++k) {
+                        pvalues[k] = pconfigvalue[k*numdof];
+                    }
+                }
+                else {
+                    for(size_t k = 0; k < num; ++k) {
+                        pvalues[k] = buffers.vpassivejointvalues[k*numpassivevalues+3*itop->passiveindex+iaxis];
+                    }
+                }
+            }
+            if( itop->childlinkindex < 0 ) {
+                continue;
+            }
+
+            dReal* pjoint = &buffers.vjointtransforms[0];
+            const dReal* pvalues = &buffers.vjointvalues[0];
+            if( itop->type == JointRevolute ) {
+                const Vector& vaxis = itop->vaxes[0];
+                for(size_t k = 0; k < num; ++k) {
+                    dReal fhalfangle = dReal(0.5)*pvalues[k];
+                    dReal fsin = RaveSin(fhalfangle);
+                    pjoint[k] = RaveCos(fhalfangle);
+                    pjoint[stride+k] = vaxis.x*fsin;
+                    pjoint[2*stride+k] = vaxis.y*fsin;
+                    pjoint[3*stride+k] = vaxis.z*fsin;
+                }
+                std::fill(pjoint+4*stride, pjoint+4*stride+num, dReal(0));
+                std::fill(pjoint+5*stride, pjoint+5*stride+num, dReal(0));
+                std::fill(pjoint+6*stride, pjoint+6*stride+num, dReal(0));
+            }
+            else if( itop->type == JointPrismatic ) {
+                const Vector& vaxis = itop->vaxes[0];
+                std::fill(pjoint, pjoint+num, dReal(1));
+                std::fill(pjoint+stride, pjoint+stride+num, dReal(0));
+                std::fill(pjoint+2*stride, pjoint+2*stride+num, dReal(0));
+                std::fill(pjoint+3*stride, pjoint+3*stride+num, dReal(0));
+                for(size_t k = 0; k < num; ++k) {
+                    pjoint[4*stride+k] = vaxis.x*pvalues[k];
+                    pjoint[5*stride+k] = vaxis.y*pvalues[k];
+                    pjoint[6*stride+k] = vaxis.z*pvalues[k];
+                }
+            }
+            else {
+                for(size_t k = 0; k < num; ++k) {
+                    for(int iaxis = 0; iaxis < itop->dof; ++iaxis) {
+                        values[iaxis] = pvalues[iaxis*stride+k];
+                    }
+                    Transform tjoint = _ComputeJointTransform(*itop, &values[0], buffers.vtempvalues);
+                    pjoint[k] = tjoint.rot.x; pjoint[stride+k] = tjoint.rot.y; pjoint[2*stride+k] = tjoint.rot.z; pjoint[3*stride+k] = tjoint.rot.w;
+                    pjoint[4*stride+k] = tjoint.trans.x; pjoint[5*stride+k] = tjoint.trans.y; pjoint[6*stride+k] = tjoint.trans.z;
+                }
+            }
+
+            // tchild = tparent * tleft * tjoint * tright
+            MultiplyTransformArrays(ConstantTransformAccessor(itop->tleft), TransformArrayAccessor(pjoint, stride), pjoint, stride, num, false);
+            MultiplyTransformArrays(TransformArrayAccessor(pjoint, stride), ConstantTransformAccessor(itop->tright), pjoint, stride, num, false);
+            size_t parentlinkindex = itop->parentlinkindex >= 0 ? itop->parentlinkindex : 0;
+            MultiplyTransformArrays(TransformArrayAccessor(&buffers.vlinktransforms[7*parentlinkindex*stride], stride), TransformArrayAccessor(pjoint, stride), &buffers.vlinktransforms[7*itop->childlinkindex*stride], stride, num, true);
+        }
+
+        for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+            TransformArrayAccessor tlinks(&buffers.vlinktransforms[7*ilink*stride], stride);
+            for(size_t k = 0; k < num; ++k) {
+                Transform& t = ptransforms[(blockstart+k)*numlinks+ilink];
+                t.rot.x = tlinks(0,k); t.rot.y = tlinks(1,k); t.rot.z = tlinks(2,k); t.rot.w = tlinks(3,k);
+                t.trans.x = tlinks(4,k); t.trans.y = tlinks(5,k); t.trans.z = tlinks(6,k);
+            }
+        }
+    }
+}
+
+void KinBody::ComputeLinkTransformationsBatch(const std::vector<dReal>& vconfigs, std::vector<Transform>& vtransforms) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    size_t numconfigs = GetDOF() > 0 ? vconfigs.size()/GetDOF() : 0;
+    OPENRAVE_ASSERT_OP_FORMAT(numconfigs*GetDOF(), ==, vconfigs.size(), "body %s number of values %d is not a multiple of the dof %d", GetName()%vconfigs.size()%GetDOF(), ORE_InvalidArguments);
+    vtransforms.resize(numconfigs*_veclinks.size());
+    if( numconfigs > 0 ) {
+        ComputeLinkTransformationsBatch(&vconfigs[0], numconfigs, &vtransforms[0]);
+    }
+}
+
+bool KinBody::_SetUseForwardKinematicsProgramCommand(std::ostream& sout, std::istream& sinput)
+{
+    sout << _bUseForwardKinematicsProgram;
+    bool buse = true;
+    sinput >> buse;
+    if( !sinput ) {
+        return false;
+    }
+    _bUseForwardKinematicsProgram = buse;
+    return true;
+}
+
 bool KinBody::IsDOFRevolute(int dofindex) const
 {
     int jointindex = _vDOFIndices.at(dofindex);
@@ -4173,6 +4635,7 @@ void KinBody::_ComputeInternalInformation()
         _ResetInternalCollisionCache();
     }
     _nHierarchyComputed = 2;
+    _BuildForwardKinematicsProgram();
     // because of mimic joints, need to call SetDOFValues at least once, also use this to check for links that are off
     {
         vector<Transform> vprevtrans, vnewtrans;
@@ -4244,32 +4707,16 @@ void KinBody::_ComputeInternalInformation()
     }
 
     // notify any callbacks of the changes
-    std::list<UserDataWeakPtr> listRegisteredCallbacks;
-    uint32_t index = 0;
     uint32_t parameters = _nParametersChanged;
-    while(parameters && index < _vlistRegisteredCallbacks.size()) {
-        if( (parameters & 1) &&  _vlistRegisteredCallbacks.at(index).size() > 0 ) {
-            {
-                boost::shared_lock< boost::shared_mutex > lock(GetInterfaceMutex());
-                listRegisteredCallbacks = _vlistRegisteredCallbacks.at(index); // copy since it can be changed
-            }
-            FOREACH(it,listRegisteredCallbacks) {
-                ChangeCallbackDataPtr pdata = boost::dynamic_pointer_cast<ChangeCallbackData>(it->lock());
-                if( !!pdata ) {
-                    pdata->_callback();
-                }
-            }
-        }
-        parameters >>= 1;
-        index += 1;
-    }
     _nParametersChanged = 0;
+    _NotifyChangeCallbacks(parameters);
     RAVELOG_VERBOSE_FORMAT("initialized %s in %fs", GetName()%(1e-6*(utils::GetMicroTime()-starttime)));
 }
 
 void KinBody::_DeinitializeInternalInformation()
 {
     _nHierarchyComputed = 0; // should reset to inform other elements that kinematics information might not be accurate
+    _bForwardKinematicsProgramValid = false;
 }
 
 bool KinBody::IsAttached(const KinBody &body) const
@@ -4357,6 +4804,7 @@ bool KinBody::_RemoveAttachedBody(KinBody &body)
 
 void KinBody::Enable(bool bEnable)
 {
+    ConcurrentQueriesWriteGuard concurrentqueriesguard(*GetEnv());
     bool bchanged = false;
     FOREACH(it, _veclinks) {
         if( (*it)->_info._bIsEnabled != bEnable ) {
@@ -4386,7 +4834,7 @@ bool KinBody::SetVisible(bool visible)
     FOREACH(it, _veclinks) {
         FOREACH(itgeom,(*it)->_vGeometries) {
             if( (*itgeom)->IsVisible() != visible ) {
-                (*itgeom)->_info._bVisible = visible;
+                (*itgeom)->_GetInfoToModify()._bVisible = visible;
                 bchanged = true;
             }
         }
@@ -4566,6 +5014,9 @@ void KinBody::Clone(InterfaceBaseConstPtr preference, int cloningoptions)
     _bMakeJoinedLinksAdjacent = r->_bMakeJoinedLinksAdjacent;
     __hashkinematics = r->__hashkinematics;
     _vTempJoints = r->_vTempJoints;
+    _vForwardKinematicsProgram.resize(0); // points to the joints of r, so will be rebuilt
+    _bForwardKinematicsProgramValid = false;
+    _bUseForwardKinematicsProgram = r->_bUseForwardKinematicsProgram;
 
     _veclinks.resize(0); _veclinks.reserve(r->_veclinks.size());
     FOREACHC(itlink, r->_veclinks) {
@@ -4576,7 +5027,7 @@ void KinBody::Clone(InterfaceBaseConstPtr preference, int cloningoptions)
         // have to copy all the geometries too!
         std::vector<Link::GeometryPtr> vnewgeometries(pnewlink->_vGeometries.size());
         for(size_t igeom = 0; igeom < vnewgeometries.size(); ++igeom) {
-            vnewgeometries[igeom].reset(new Link::Geometry(pnewlink, pnewlink->_vGeometries[igeom]->_info));
+            vnewgeometries[igeom].reset(new Link::Geometry(pnewlink, *pnewlink->_vGeometries[igeom])); // shares the info and collision mesh until one of the geometries is modified
         }
         pnewlink->_vGeometries = vnewgeometries;
         _veclinks.push_back(pnewlink);
@@ -4779,24 +5230,61 @@ void KinBody::_PostprocessChangedParameters(uint32_t parameters)
 //        }
     }
 
-    std::list<UserDataWeakPtr> listRegisteredCallbacks;
-    uint32_t index = 0;
-    while(parameters && index < _vlistRegisteredCallbacks.size()) {
-        if( (parameters & 1) &&  _vlistRegisteredCallbacks.at(index).size() > 0 ) {
-            {
-                boost::shared_lock< boost::shared_mutex > lock(GetInterfaceMutex());
-                listRegisteredCallbacks = _vlistRegisteredCallbacks.at(index); // copy since it can be changed
-            }
-            FOREACH(it,listRegisteredCallbacks) {
-                ChangeCallbackDataPtr pdata = boost::dynamic_pointer_cast<ChangeCallbackData>(it->lock());
+    _NotifyChangeCallbacks(parameters);
+}
+
+void KinBody::_NotifyChangeCallbacks(uint32_t parameters)
+{
+    if( _nDeferChangeCallbacks > 0 ) {
+        _nDeferredParametersChanged |= parameters;
+        return;
+    }
+    parameters &= _nRegisteredCallbackProperties.load();
+    if( !parameters ) {
+        return;
+    }
+    // the table is never modified once published, so it can be traversed without the interface mutex
+    ChangeCallbackTableConstPtr ptable = boost::atomic_load(&_pRegisteredCallbacks);
+    if( !ptable ) {
+        return;
+    }
+    if( !(parameters & (parameters-1)) ) {
+        // one property, every callback is in its list once
+        uint32_t index = 0;
+        while(!(parameters & 1)) {
+            parameters >>= 1;
+            index += 1;
+        }
+        if( index < ptable->size() ) {
+            FOREACHC(it, ptable->at(index)) {
+                // only ChangeCallbackData is ever registered in the table
+                ChangeCallbackDataPtr pdata = boost::static_pointer_cast<ChangeCallbackData>(it->lock());
                 if( !!pdata ) {
                     pdata->_callback();
                 }
             }
         }
+        return;
+    }
+
+    // a callback tracking several of the changed properties is in several lists, call it only once
+    std::vector<ChangeCallbackDataPtr> vcallbacks;
+    uint32_t index = 0;
+    while(parameters && index < ptable->size()) {
+        if( parameters & 1 ) {
+            FOREACHC(it, ptable->at(index)) {
+                ChangeCallbackDataPtr pdata = boost::static_pointer_cast<ChangeCallbackData>(it->lock());
+                if( !!pdata && find(vcallbacks.begin(), vcallbacks.end(), pdata) == vcallbacks.end() ) {
+                    vcallbacks.push_back(pdata);
+                }
+            }
+        }
         parameters >>= 1;
         index += 1;
     }
+    FOREACH(itdata, vcallbacks) {
+        (*itdata)->_callback();
+    }
 }
 
 void KinBody::Serialize(BaseXMLWriterPtr writer, int options) const
@@ -4899,24 +5387,27 @@ UserDataPtr KinBody::RegisterChangeCallback(uint32_t properties, const boost::fu
 {
     ChangeCallbackDataPtr pdata(new ChangeCallbackData(properties,callback,shared_kinbody_const()));
     boost::unique_lock< boost::shared_mutex > lock(GetInterfaceMutex());
+    pdata->_UpdateTable(*this, pdata);
+    return pdata;
+}
 
-    uint32_t index = 0;
-    while(properties) {
-        if( properties & 1 ) {
-            if( index >= _vlistRegisteredCallbacks.size() ) {
-                // have to resize _vlistRegisteredCallbacks, but have to preserve the internal lists since ChangeCallbackData keep track of the list iterators
-                std::vector<std::list<UserDataWeakPtr> > vlistRegisteredCallbacks(index+1);
-                for(size_t i = 0; i < _vlistRegisteredCallbacks.size(); ++i) {
-                    vlistRegisteredCallbacks[i].swap(_vlistRegisteredCallbacks[i]);
-                }
-                _vlistRegisteredCallbacks.swap(vlistRegisteredCallbacks);
-            }
-            pdata->_iterators.emplace_back(index, _vlistRegisteredCallbacks.at(index).insert(_vlistRegisteredCallbacks.at(index).end(), pdata));
+KinBody::ChangeCallbackDeferrer::ChangeCallbackDeferrer(KinBody& body) : _body(body)
+{
+    _body._nDeferChangeCallbacks++;
+}
+
+KinBody::ChangeCallbackDeferrer::~ChangeCallbackDeferrer()
+{
+    if( --_body._nDeferChangeCallbacks == 0 && _body._nDeferredParametersChanged != 0 ) {
+        uint32_t parameters = _body._nDeferredParametersChanged;
+        _body._nDeferredParametersChanged = 0;
+        try {
+            _body._NotifyChangeCallbacks(parameters);
+        }
+        catch(const std::exception& ex) {
+            RAVELOG_WARN_FORMAT("body %s change callbacks failed: %s", _body.GetName()%ex.what());
         }
-        properties >>= 1;
-        index += 1;
     }
-    return pdata;
 }
 
 void KinBody::_InitAndAddLink(LinkPtr plink)
@@ -4937,8 +5428,8 @@ void KinBody::_InitAndAddLink(LinkPtr plink)
     plink->_collision.indices.clear();
     FOREACHC(itgeominfo,info._vgeometryinfos) {
         Link::GeometryPtr geom(new Link::Geometry(plink,**itgeominfo));
-        if( geom->_info._meshcollision.vertices.size() == 0 ) { // try to avoid recomputing
-            geom->_info.InitCollisionMesh();
+        if( geom->GetCollisionMesh().vertices.size() == 0 ) { // try to avoid recomputing
+            geom->_GetInfoToModify().InitCollisionMesh();
         }
         plink->_vGeometries.push_back(geom);
         plink->_collision.Append(geom->GetCollisionMesh(),geom->GetTransform());
@@ -77,32 +77,102 @@ bool KinBody::CheckSelfCollision(CollisionReportPtr report, CollisionCheckerBase
         pusereport = boost::shared_ptr<CollisionReport>(&tempreport,utils::null_deleter());
     }
 
-    // check all grabbed bodies with (TODO: support CO_ActiveDOFs option)
-    FOREACH(itgrabbed, _vGrabbedBodies) {
-        GrabbedConstPtr pgrabbed = boost::dynamic_pointer_cast<Grabbed const>(*itgrabbed);
-        KinBodyPtr pbody = pgrabbed->_pgrabbedbody.lock();
-        if( !pbody ) {
-            RAVELOG_WARN_FORMAT("grabbed body on %s has already been destroyed, ignoring.", GetName());
-            continue;
+    if( !(coloptions & CO_Distance) ) {
+        // gather the robot/grabbed and grabbed/grabbed link pairs so that the checker can cull and test all of them in one call
+        std::vector<KinBodyPtr> vgrabbedbodies(_vGrabbedBodies.size());
+        std::vector< std::pair<KinBody::LinkConstPtr, KinBody::LinkConstPtr> > vlinkpairs;
+        for(size_t igrabbed = 0; igrabbed < _vGrabbedBodies.size(); ++igrabbed) {
+            GrabbedConstPtr pgrabbed = boost::dynamic_pointer_cast<Grabbed const>(_vGrabbedBodies[igrabbed]);
+            KinBodyPtr pbody = pgrabbed->_pgrabbedbody.lock();
+            if( !pbody ) {
+                RAVELOG_WARN_FORMAT("grabbed body on %s has already been destroyed, ignoring.", GetName());
+                continue;
+            }
+            vgrabbedbodies[igrabbed] = pbody;
+            FOREACH(itrobotlink,pgrabbed->_listNonCollidingLinks) {
+                KinBody::LinkConstPtr robotlink = *itrobotlink;
+                KinBodyPtr parentlink = (*itrobotlink)->GetParent(true);
+                if( !parentlink ) {
+                    RAVELOG_WARN_FORMAT("_listNonCollidingLinks has invalid link %s:%d", (*itrobotlink)->GetName()%(*itrobotlink)->GetIndex());
+                    robotlink = _veclinks.at((*itrobotlink)->GetIndex());
+                }
+                // have to use link/link collision since link/body checks attached bodies
+                FOREACHC(itbodylink,pbody->GetLinks()) {
+                    vlinkpairs.push_back(std::make_pair(robotlink, KinBody::LinkConstPtr(*itbodylink)));
+                }
+            }
         }
-        FOREACH(itrobotlink,pgrabbed->_listNonCollidingLinks) {
-            KinBody::LinkConstPtr robotlink = *itrobotlink;
-            KinBodyPtr parentlink = (*itrobotlink)->GetParent(true);
-            if( !parentlink ) {
-                RAVELOG_WARN_FORMAT("_listNonCollidingLinks has invalid link %s:%d", (*itrobotlink)->GetName()%(*itrobotlink)->GetIndex());
-                robotlink = _veclinks.at((*itrobotlink)->GetIndex());
+
+        // check attached bodies with each other, the links of the two bodies have to be initially not colliding. every unordered pair of bodies is gathered only once
+        for(size_t igrabbed = 0; igrabbed < _vGrabbedBodies.size(); ++igrabbed) {
+            if( !vgrabbedbodies[igrabbed] ) {
+                continue;
             }
-            
-            // have to use link/link collision since link/body checks attached bodies
-            FOREACHC(itbodylink,pbody->GetLinks()) {
-                if( collisionchecker->CheckCollision(robotlink,KinBody::LinkConstPtr(*itbodylink),pusereport) ) {
+            GrabbedConstPtr pgrabbed = boost::dynamic_pointer_cast<Grabbed const>(_vGrabbedBodies[igrabbed]);
+            for(size_t igrabbed2 = igrabbed+1; igrabbed2 < _vGrabbedBodies.size(); ++igrabbed2) {
+                if( !vgrabbedbodies[igrabbed2] || vgrabbedbodies[igrabbed] == vgrabbedbodies[igrabbed2] ) {
+                    continue;
+                }
+                GrabbedConstPtr pgrabbed2 = boost::dynamic_pointer_cast<Grabbed const>(_vGrabbedBodies[igrabbed2]);
+                FOREACHC(itlink2, vgrabbedbodies[igrabbed2]->GetLinks()) {
+                    if( find(pgrabbed->_listNonCollidingLinks.begin(),pgrabbed->_listNonCollidingLinks.end(),*itlink2) != pgrabbed->_listNonCollidingLinks.end() ) {
+                        FOREACHC(itlink, vgrabbedbodies[igrabbed]->GetLinks()) {
+                            if( find(pgrabbed2->_listNonCollidingLinks.begin(),pgrabbed2->_listNonCollidingLinks.end(),*itlink) != pgrabbed2->_listNonCollidingLinks.end() ) {
+                                vlinkpairs.push_back(std::make_pair(KinBody::LinkConstPtr(*itlink), KinBody::LinkConstPtr(*itlink2)));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        if( vlinkpairs.size() > 0 && collisionchecker->CheckCollisionLinkPairs(vlinkpairs, pusereport) ) {
+            bCollision = true;
+        }
+        if( !bCollision || bAllLinkCollisions ) {
+            FOREACH(itbody, vgrabbedbodies) {
+                if( !!*itbody && (*itbody)->CheckSelfCollision(pusereport, collisionchecker) ) {
                     bCollision = true;
                     if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
                         break;
                     }
                 }
-                if( !!pusereport && pusereport->minDistance < report->minDistance ) {
-                    *report = *pusereport;
+            }
+        }
+    }
+    else {
+        // check all grabbed bodies with (TODO: support CO_ActiveDOFs option)
+        FOREACH(itgrabbed, _vGrabbedBodies) {
+            GrabbedConstPtr pgrabbed = boost::dynamic_pointer_cast<Grabbed const>(*itgrabbed);
+            KinBodyPtr pbody = pgrabbed->_pgrabbedbody.lock();
+            if( !pbody ) {
+                RAVELOG_WARN_FORMAT("grabbed body on %s has already been destroyed, ignoring.", GetName());
+                continue;
+            }
+            FOREACH(itrobotlink,pgrabbed->_listNonCollidingLinks) {
+                KinBody::LinkConstPtr robotlink = *itrobotlink;
+                KinBodyPtr parentlink = (*itrobotlink)->GetParent(true);
+                if( !parentlink ) {
+                    RAVELOG_WARN_FORMAT("_listNonCollidingLinks has invalid link %s:%d", (*itrobotlink)->GetName()%(*itrobotlink)->GetIndex());
+                    robotlink = _veclinks.at((*itrobotlink)->GetIndex());
+                }
+            
+                // have to use link/link collision since link/body checks attached bodies
+                FOREACHC(itbodylink,pbody->GetLinks()) {
+                    if( collisionchecker->CheckCollision(robotlink,KinBody::LinkConstPtr(*itbodylink),pusereport) ) {
+                        bCollision = true;
+                        if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
+                            break;
+                        }
+                    }
+                    if( !!pusereport && pusereport->minDistance < report->minDistance ) {
+                        *report = *pusereport;
+                    }
+                }
+                if( bCollision ) {
+                    if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
+                        break;
+                    }
                 }
             }
             if( bCollision ) {
@@ -110,50 +180,50 @@ bool KinBody::CheckSelfCollision(CollisionReportPtr report, CollisionCheckerBase
                     break;
                 }
             }
-        }
-        if( bCollision ) {
-            if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
-                break;
-            }
-        }
 
-        if( pbody->CheckSelfCollision(pusereport, collisionchecker) ) {
-            bCollision = true;
-            if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
-                break;
+            if( pbody->CheckSelfCollision(pusereport, collisionchecker) ) {
+                bCollision = true;
+                if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
+                    break;
+                }
+            }
+            if( !!pusereport && pusereport->minDistance < report->minDistance ) {
+                *report = *pusereport;
             }
-        }
-        if( !!pusereport && pusereport->minDistance < report->minDistance ) {
-            *report = *pusereport;
-        }
 
-        // check attached bodies with each other, this is actually tricky since they are attached "with each other", so regular CheckCollision will not work.
-        // Instead, we will compare each of the body's links with every other
-        if( _vGrabbedBodies.size() > 1 ) {
-            FOREACHC(itgrabbed2, _vGrabbedBodies) {
-                GrabbedConstPtr pgrabbed2 = boost::dynamic_pointer_cast<Grabbed const>(*itgrabbed2);
-                KinBodyPtr pbody2 = pgrabbed2->_pgrabbedbody.lock();
-                if( !pbody2 ) {
-                    RAVELOG_WARN_FORMAT("grabbed body on %s has already been destroyed, so ignoring.", GetName());
-                    continue;
-                }
-                if( pbody == pbody2 ) {
-                    continue;
-                }
-                FOREACHC(itlink2, pbody2->GetLinks()) {
-                    // make sure the two bodies were not initially colliding
-                    if( find(pgrabbed->_listNonCollidingLinks.begin(),pgrabbed->_listNonCollidingLinks.end(),*itlink2) != pgrabbed->_listNonCollidingLinks.end() ) {
-                        FOREACHC(itlink, pbody->GetLinks()) {
-                            if( find(pgrabbed2->_listNonCollidingLinks.begin(),pgrabbed2->_listNonCollidingLinks.end(),*itlink) != pgrabbed2->_listNonCollidingLinks.end() ) {
-                                if( collisionchecker->CheckCollision(KinBody::LinkConstPtr(*itlink),KinBody::LinkConstPtr(*itlink2),pusereport) ) {
-                                    bCollision = true;
+            // check attached bodies with each other, this is actually tricky since they are attached "with each other", so regular CheckCollision will not work.
+            // Instead, we will compare each of the body's links with every other
+            if( _vGrabbedBodies.size() > 1 ) {
+                FOREACHC(itgrabbed2, _vGrabbedBodies) {
+                    GrabbedConstPtr pgrabbed2 = boost::dynamic_pointer_cast<Grabbed const>(*itgrabbed2);
+                    KinBodyPtr pbody2 = pgrabbed2->_pgrabbedbody.lock();
+                    if( !pbody2 ) {
+                        RAVELOG_WARN_FORMAT("grabbed body on %s has already been destroyed, so ignoring.", GetName());
+                        continue;
+                    }
+                    if( pbody == pbody2 ) {
+                        continue;
+                    }
+                    FOREACHC(itlink2, pbody2->GetLinks()) {
+                        // make sure the two bodies were not initially colliding
+                        if( find(pgrabbed->_listNonCollidingLinks.begin(),pgrabbed->_listNonCollidingLinks.end(),*itlink2) != pgrabbed->_listNonCollidingLinks.end() ) {
+                            FOREACHC(itlink, pbody->GetLinks()) {
+                                if( find(pgrabbed2->_listNonCollidingLinks.begin(),pgrabbed2->_listNonCollidingLinks.end(),*itlink) != pgrabbed2->_listNonCollidingLinks.end() ) {
+                                    if( collisionchecker->CheckCollision(KinBody::LinkConstPtr(*itlink),KinBody::LinkConstPtr(*itlink2),pusereport) ) {
+                                        bCollision = true;
+                                        if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
+                                            break;
+                                        }
+                                    }
+                                    if( !!pusereport && pusereport->minDistance < report->minDistance ) {
+                                        *report = *pusereport;
+                                    }
+                                }
+                                if( bCollision ) {
                                     if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
                                         break;
                                     }
                                 }
-                                if( !!pusereport && pusereport->minDistance < report->minDistance ) {
-                                    *report = *pusereport;
-                                }
                             }
                             if( bCollision ) {
                                 if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
@@ -161,10 +231,10 @@ bool KinBody::CheckSelfCollision(CollisionReportPtr report, CollisionCheckerBase
                                 }
                             }
                         }
-                        if( bCollision ) {
-                            if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
-                                break;
-                            }
+                    }
+                    if( bCollision ) {
+                        if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
+                            break;
                         }
                     }
                 }
@@ -174,11 +244,6 @@ bool KinBody::CheckSelfCollision(CollisionReportPtr report, CollisionCheckerBase
                     }
                 }
             }
-            if( bCollision ) {
-                if( !bAllLinkCollisions ) { // if checking all collisions, have to continue
-                    break;
-                }
-            }
         }
     }
 
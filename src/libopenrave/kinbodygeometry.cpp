@@ -796,64 +796,77 @@ AABB KinBody::GeometryInfo::ComputeAABB(const Transform& tGeometryWorld) const
 }
 
 
-KinBody::Link::Geometry::Geometry(KinBody::LinkPtr parent, const KinBody::GeometryInfo& info) : _parent(parent), _info(info)
+KinBody::Link::Geometry::Geometry(KinBody::LinkPtr parent, const KinBody::GeometryInfo& info) : _parent(parent), _pinfo(new KinBody::GeometryInfo(info))
 {
 }
 
+KinBody::Link::Geometry::Geometry(KinBody::LinkPtr parent, const KinBody::Link::Geometry& refgeom) : _parent(parent), _pinfo(refgeom._pinfo)
+{
+}
+
+KinBody::GeometryInfo& KinBody::Link::Geometry::_GetInfoToModify()
+{
+    if( !_pinfo.unique() ) {
+        // the other owners are geometries of cloned bodies, which keep the old info
+        _pinfo.reset(new KinBody::GeometryInfo(*_pinfo));
+    }
+    return *_pinfo;
+}
+
 bool KinBody::Link::Geometry::InitCollisionMesh(float fTessellation)
 {
-    return _info.InitCollisionMesh(fTessellation);
+    return _GetInfoToModify().InitCollisionMesh(fTessellation);
 }
 
 bool KinBody::Link::Geometry::ComputeInnerEmptyVolume(Transform& tInnerEmptyVolume, Vector& abInnerEmptyExtents) const
 {
-    return _info.ComputeInnerEmptyVolume(tInnerEmptyVolume, abInnerEmptyExtents);
+    return _pinfo->ComputeInnerEmptyVolume(tInnerEmptyVolume, abInnerEmptyExtents);
 }
 
 AABB KinBody::Link::Geometry::ComputeAABB(const Transform& t) const
 {
-    return _info.ComputeAABB(t);
+    return _pinfo->ComputeAABB(t);
 }
 
 void KinBody::Link::Geometry::serialize(std::ostream& o, int options) const
 {
-    SerializeRound(o,_info._t);
-    o << _info._type << " ";
-    SerializeRound3(o,_info._vRenderScale);
-    if( _info._type == GT_TriMesh ) {
-        _info._meshcollision.serialize(o,options);
+    SerializeRound(o,_pinfo->_t);
+    o << _pinfo->_type << " ";
+    SerializeRound3(o,_pinfo->_vRenderScale);
+    if( _pinfo->_type == GT_TriMesh ) {
+        _pinfo->_meshcollision.serialize(o,options);
     }
     else {
-        SerializeRound3(o,_info._vGeomData);
-        if( _info._type == GT_Cage ) {
-            SerializeRound3(o,_info._vGeomData2);
-            for (size_t iwall = 0; iwall < _info._vSideWalls.size(); ++iwall) {
-                const GeometryInfo::SideWall &s = _info._vSideWalls[iwall];
+        SerializeRound3(o,_pinfo->_vGeomData);
+        if( _pinfo->_type == GT_Cage ) {
+            SerializeRound3(o,_pinfo->_vGeomData2);
+            for (size_t iwall = 0; iwall < _pinfo->_vSideWalls.size(); ++iwall) {
+                const GeometryInfo::SideWall &s = _pinfo->_vSideWalls[iwall];
                 SerializeRound(o,s.transf);
                 SerializeRound3(o,s.vExtents);
                 o << (uint32_t)s.type;
             }
         }
-        else if( _info._type == GT_Container ) {
-            SerializeRound3(o,_info._vGeomData2);
-            SerializeRound3(o,_info._vGeomData3);
-            SerializeRound3(o,_info._vGeomData4);
+        else if( _pinfo->_type == GT_Container ) {
+            SerializeRound3(o,_pinfo->_vGeomData2);
+            SerializeRound3(o,_pinfo->_vGeomData3);
+            SerializeRound3(o,_pinfo->_vGeomData4);
         }
     }
 }
 
 void KinBody::Link::Geometry::SetCollisionMesh(const TriMesh& mesh)
 {
-    OPENRAVE_ASSERT_FORMAT0(_info._bModifiable, "geometry cannot be modified", ORE_Failed);
+    OPENRAVE_ASSERT_FORMAT0(_pinfo->_bModifiable, "geometry cannot be modified", ORE_Failed);
     LinkPtr parent(_parent);
-    _info._meshcollision = mesh;
+    _GetInfoToModify()._meshcollision = mesh;
     parent->_Update();
 }
 
 bool KinBody::Link::Geometry::SetVisible(bool visible)
 {
-    if( _info._bVisible != visible ) {
-        _info._bVisible = visible;
+    if( _pinfo->_bVisible != visible ) {
+        _GetInfoToModify()._bVisible = visible;
         LinkPtr parent(_parent);
         parent->GetParent()->_PostprocessChangedParameters(Prop_LinkDraw);
         return true;
@@ -864,21 +877,21 @@ bool KinBody::Link::Geometry::SetVisible(bool visible)
 void KinBody::Link::Geometry::SetTransparency(float f)
 {
     LinkPtr parent(_parent);
-    _info._fTransparency = f;
+    _GetInfoToModify()._fTransparency = f;
     parent->GetParent()->_PostprocessChangedParameters(Prop_LinkDraw);
 }
 
 void KinBody::Link::Geometry::SetDiffuseColor(const RaveVector<float>& color)
 {
     LinkPtr parent(_parent);
-    _info._vDiffuseColor = color;
+    _GetInfoToModify()._vDiffuseColor = color;
     parent->GetParent()->_PostprocessChangedParameters(Prop_LinkDraw);
 }
 
 void KinBody::Link::Geometry::SetAmbientColor(const RaveVector<float>& color)
 {
     LinkPtr parent(_parent);
-    _info._vAmbientColor = color;
+    _GetInfoToModify()._vAmbientColor = color;
     parent->GetParent()->_PostprocessChangedParameters(Prop_LinkDraw);
 }
 
@@ -917,11 +930,11 @@ void KinBody::Link::Geometry::SetAmbientColor(const RaveVector<float>& color)
 
 bool KinBody::Link::Geometry::ValidateContactNormal(const Vector& _position, Vector& _normal) const
 {
-    Transform tinv = _info._t.inverse();
+    Transform tinv = _pinfo->_t.inverse();
     Vector position = tinv*_position;
     Vector normal = tinv.rotate(_normal);
     const dReal feps=0.00005f;
-    switch(_info._type) {
+    switch(_pinfo->_type) {
     case GT_Box: {
         // transform position in +x+y+z octant
         Vector tposition=position, tnormal=normal;
@@ -938,9 +951,9 @@ bool KinBody::Link::Geometry::ValidateContactNormal(const Vector& _position, Vec
             tnormal.z = -tnormal.z;
         }
         // find the normal to the surface depending on the region the position is in
-        dReal xaxis = -_info._vGeomData.z*tposition.y+_info._vGeomData.y*tposition.z;
-        dReal yaxis = -_info._vGeomData.x*tposition.z+_info._vGeomData.z*tposition.x;
-        dReal zaxis = -_info._vGeomData.y*tposition.x+_info._vGeomData.x*tposition.y;
+        dReal xaxis = -_pinfo->_vGeomData.z*tposition.y+_pinfo->_vGeomData.y*tposition.z;
+        dReal yaxis = -_pinfo->_vGeomData.x*tposition.z+_pinfo->_vGeomData.z*tposition.x;
+        dReal zaxis = -_pinfo->_vGeomData.y*tposition.x+_pinfo->_vGeomData.x*tposition.y;
         dReal penetration=0;
         if((zaxis < feps)&&(yaxis > -feps)) { // x-plane
             if( RaveFabs(tnormal.x) > RaveFabs(penetration) ) {
@@ -964,8 +977,8 @@ bool KinBody::Link::Geometry::ValidateContactNormal(const Vector& _position, Vec
         break;
     }
     case GT_Cylinder: { // z-axis
-        dReal fInsideCircle = position.x*position.x+position.y*position.y-_info._vGeomData.x*_info._vGeomData.x;
-        dReal fInsideHeight = 2.0f*RaveFabs(position.z)-_info._vGeomData.y;
+        dReal fInsideCircle = position.x*position.x+position.y*position.y-_pinfo->_vGeomData.x*_pinfo->_vGeomData.x;
+        dReal fInsideHeight = 2.0f*RaveFabs(position.z)-_pinfo->_vGeomData.y;
         if((fInsideCircle < -feps)&&(fInsideHeight > -feps)&&(normal.z*position.z<0)) {
             _normal = -_normal;
             return true;
@@ -992,14 +1005,14 @@ bool KinBody::Link::Geometry::ValidateContactNormal(const Vector& _position, Vec
 void KinBody::Link::Geometry::SetRenderFilename(const std::string& renderfilename)
 {
     LinkPtr parent(_parent);
-    _info._filenamerender = renderfilename;
+    _GetInfoToModify()._filenamerender = renderfilename;
     parent->GetParent()->_PostprocessChangedParameters(Prop_LinkGeometry);
 }
 
 void KinBody::Link::Geometry::SetName(const std::string& name)
 {
     LinkPtr parent(_parent);
-    _info._name = name;
+    _GetInfoToModify()._name = name;
     parent->GetParent()->_PostprocessChangedParameters(Prop_LinkGeometry);
 
 }
@@ -1007,8 +1020,8 @@ void KinBody::Link::Geometry::SetName(const std::string& name)
 uint8_t KinBody::Link::Geometry::GetSideWallExists() const
 {
     uint8_t mask = 0;
-    for (size_t i = 0; i < _info._vSideWalls.size(); ++i) {
-        mask |= 1 << _info._vSideWalls[i].type;
+    for (size_t i = 0; i < _pinfo->_vSideWalls.size(); ++i) {
+        mask |= 1 << _pinfo->_vSideWalls[i].type;
     }
     return mask;
 }
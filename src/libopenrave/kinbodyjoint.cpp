@@ -1012,6 +1012,7 @@ void KinBody::Joint::_ComputeInternalInformation(LinkPtr plink0, LinkPtr plink1,
     }
     _tinvRight = _tRight.inverse();
     _tinvLeft = _tLeft.inverse();
+    parent->_bForwardKinematicsProgramValid = false; // the program caches the axes and transforms
 
     _vcircularlowerlimit = _info._vlowerlimit;
     _vcircularupperlimit = _info._vupperlimit;
@@ -1324,6 +1325,7 @@ void KinBody::Joint::SetWrapOffset(dReal newoffset, int iaxis)
             }
             _tinvRight = _tRight.inverse();
         }
+        GetParent()->_bForwardKinematicsProgramValid = false; // the program caches _tLeft and _tRight
         GetParent()->_PostprocessChangedParameters(Prop_JointOffset);
     }
 }
@@ -187,6 +187,7 @@ void KinBody::Link::Enable(bool bEnable)
 {
     if( _info._bIsEnabled != bEnable ) {
         KinBodyPtr parent = GetParent();
+        ConcurrentQueriesWriteGuard concurrentqueriesguard(*parent->GetEnv());
         parent->_nNonAdjacentLinkCache &= ~AO_Enabled;
         _info._bIsEnabled = bEnable;
         GetParent()->_PostprocessChangedParameters(Prop_LinkEnable);
@@ -202,8 +203,8 @@ bool KinBody::Link::SetVisible(bool visible)
 {
     bool bchanged = false;
     FOREACH(itgeom,_vGeometries) {
-        if( (*itgeom)->_info._bVisible != visible ) {
-            (*itgeom)->_info._bVisible = visible;
+        if( (*itgeom)->IsVisible() != visible ) {
+            (*itgeom)->_GetInfoToModify()._bVisible = visible;
             bchanged = true;
         }
     }
@@ -442,7 +443,7 @@ void KinBody::Link::InitGeometries(std::vector<KinBody::GeometryInfoConstPtr>& g
     vgeometryinfos.resize(_vGeometries.size());
     for(size_t i = 0; i < vgeometryinfos.size(); ++i) {
         vgeometryinfos[i].reset(new KinBody::GeometryInfo());
-        *vgeometryinfos[i] = _vGeometries[i]->_info;
+        *vgeometryinfos[i] = _vGeometries[i]->GetInfo();
     }
     SetGroupGeometries("self", vgeometryinfos);
     _Update();
@@ -466,7 +467,7 @@ void KinBody::Link::InitGeometries(std::list<KinBody::GeometryInfo>& geometries,
     vgeometryinfos.resize(_vGeometries.size());
     for(size_t i = 0; i < vgeometryinfos.size(); ++i) {
         vgeometryinfos[i].reset(new KinBody::GeometryInfo());
-        *vgeometryinfos[i] = _vGeometries[i]->_info;
+        *vgeometryinfos[i] = _vGeometries[i]->GetInfo();
     }
     SetGroupGeometries("self", vgeometryinfos);
     _Update();
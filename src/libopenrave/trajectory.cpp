@@ -116,6 +116,36 @@ void TrajectoryBase::SamplePoints(std::vector<dReal>& data, const std::vector<dR
     }
 }
 
+void TrajectoryBase::SampleRange(std::vector<dReal>& data, dReal tstart, dReal tend, dReal deltatime) const
+{
+    std::vector<dReal> times(_GetNumRangeSamples(tstart, tend, deltatime));
+    for(size_t i = 0; i < times.size(); ++i) {
+        times[i] = tstart + i*deltatime;
+    }
+    SamplePoints(data, times);
+}
+
+void TrajectoryBase::SampleRange(std::vector<dReal>& data, dReal tstart, dReal tend, dReal deltatime, const ConfigurationSpecification& spec) const
+{
+    std::vector<dReal> times(_GetNumRangeSamples(tstart, tend, deltatime));
+    for(size_t i = 0; i < times.size(); ++i) {
+        times[i] = tstart + i*deltatime;
+    }
+    SamplePoints(data, times, spec);
+}
+
+size_t TrajectoryBase::_GetNumRangeSamples(dReal tstart, dReal tend, dReal deltatime)
+{
+    if( !(deltatime > 0) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("sampling deltatime %.15e has to be positive"), deltatime, ORE_InvalidArguments);
+    }
+    if( tend < tstart ) {
+        return 0;
+    }
+    // tend should be sampled even if (tend-tstart)/deltatime is slightly below an integer due to floating-point error
+    return (size_t)((tend-tstart)/deltatime + g_fEpsilonLinear) + 1;
+}
+
 void TrajectoryBase::GetWaypoints(size_t startindex, size_t endindex, std::vector<dReal>& data, const ConfigurationSpecification& spec) const
 {
     RAVELOG_VERBOSE(str(boost::format("TrajectoryBase::GetWaypoints: calling slow implementation %s")%GetXMLId()));
@@ -12,6 +12,7 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 from common_test_openrave import *
+import struct
 
 class TestBinaryTrajectory(EnvironmentSetup):
 	def test_binary_traj(self):
@@ -107,3 +108,60 @@ class TestBinaryTrajectory(EnvironmentSetup):
                 trajBinary1 = trajectory1.serialize()
                 trajectory1Copy.deserialize(trajBinary1)
                 assert(trajectory1Copy.GetDescription()=='test')
+
+	def test_columnar_traj(self):
+		env = self.env
+		spec = ConfigurationSpecification()
+		spec.AddGroup('joint_values robot 0 1 2', 3, 'linear')
+		spec.AddDeltaTimeGroup()
+		traj = RaveCreateTrajectory(env, '')
+		traj.Init(spec)
+		data = []
+		for i in range(100):
+			data += [sin(0.1*i), cos(0.1*i), 0.01*i, 0 if i == 0 else 0.01]
+		traj.Insert(0, data)
+		traj.SetDescription('columnar')
+		numpoints = traj.GetNumWaypoints()
+		filename = os.path.join(RaveGetHomeDirectory(), 'test_columnar_traj.bin')
+		for encoding, tolerance in [(0, 0), (1, 1e-6), (2, 1e-6)]:
+			traj.SendCommand('SaveColumnarTrajectory %s %d'%(filename, encoding))
+			
+			trajMapped = RaveCreateTrajectory(env, '')
+			mapped = int(trajMapped.SendCommand('LoadMappedTrajectory %s'%filename))
+			# only float64 data can be used from the mapping as is
+			assert(mapped == (encoding == 0))
+			
+			trajStream = RaveCreateTrajectory(env, '')
+			trajStream.deserialize(open(filename, 'rb').read())
+			for trajCopy in [trajMapped, trajStream]:
+				assert(trajCopy.GetConfigurationSpecification() == traj.GetConfigurationSpecification())
+				assert(trajCopy.GetDescription() == 'columnar')
+				assert(trajCopy.GetNumWaypoints() == numpoints)
+				assert(max(abs(array(trajCopy.GetWaypoints(0, numpoints)) - array(traj.GetWaypoints(0, numpoints)))) <= tolerance)
+				assert(abs(trajCopy.GetDuration() - traj.GetDuration()) <= 100*tolerance+g_epsilon)
+				assert(max(abs(array(trajCopy.Sample(0.555)) - array(traj.Sample(0.555)))) <= 100*tolerance+g_epsilon)
+			
+			# modifying a mapped trajectory copies the data
+			trajMapped.Insert(numpoints, data[-4:])
+			assert(trajMapped.GetNumWaypoints() == numpoints+1)
+		os.remove(filename)
+
+	def test_columnar_traj_corrupted(self):
+		env = self.env
+		spec = ConfigurationSpecification()
+		spec.AddGroup('joint_values robot 0 1 2', 3, 'linear')
+		spec.AddDeltaTimeGroup()
+		traj = RaveCreateTrajectory(env, '')
+		traj.Init(spec)
+		traj.Insert(0, [0.1*i for i in range(40)])
+		filename = os.path.join(RaveGetHomeDirectory(), 'test_columnar_traj_corrupted.bin')
+		traj.SendCommand('SaveColumnarTrajectory %s 0'%filename)
+		filedata = open(filename, 'rb').read()
+		corruptions = [filedata[:-8], # truncated data
+		               filedata[:24] + struct.pack('<Q', 2**64-64) + filedata[32:], # data offset past the end that overflows when the size is added
+		               filedata[:16] + struct.pack('<Q', 2**62) + filedata[24:32] + struct.pack('<Q', 2**62*4*8 % 2**64)] # sizes that overflow
+		for corrupted in corruptions:
+			open(filename, 'wb').write(corrupted)
+			assert_raises(openrave_exception, RaveCreateTrajectory(env, '').SendCommand, 'LoadMappedTrajectory %s'%filename)
+			assert_raises(openrave_exception, RaveCreateTrajectory(env, '').deserialize, corrupted)
+		os.remove(filename)
@@ -278,6 +278,152 @@ class test_fcl(RunCollision):
     def __init__(self):
         RunCollision.__init__(self, 'fcl_')
 
+    def test_meshcache(self):
+        env=self.env
+        self.LoadEnv('robots/barrettwam.robot.xml')
+        def GetMeshCacheStatistics(env):
+            return [int(x) for x in env.GetCollisionChecker().SendCommand('GetMeshCacheStatistics').split()]
+        
+        numhits, nummisses, numentries, residentbytes = GetMeshCacheStatistics(env)
+        assert(numentries > 0 and residentbytes > 0)
+        # clones share the same BVH models
+        clonedenv = env.CloneSelf(CloningOptions.Bodies)
+        try:
+            numhits2, nummisses2, numentries2, residentbytes2 = GetMeshCacheStatistics(clonedenv)
+            assert(numhits2 > numhits)
+            assert(nummisses2 == nummisses and numentries2 == numentries and residentbytes2 == residentbytes)
+        finally:
+            clonedenv.Destroy()
+
+    def test_narrowphasethreads(self):
+        env=self.env
+        self.LoadEnv('robots/barrettwam.robot.xml')
+        robot=env.GetRobots()[0]
+        checker=env.GetCollisionChecker()
+        lower,upper = robot.GetDOFLimits()
+        with env:
+            # grab a box that is initially free so the grabbed links go through the batched link pairs
+            box = RaveCreateKinBody(env,'')
+            box.InitFromBoxes(array([[0,0,0,0.02,0.02,0.02]]),True)
+            box.SetName('smallbox')
+            env.Add(box)
+            box.SetTransform(robot.GetActiveManipulator().GetEndEffectorTransform())
+            robot.Grab(box)
+            configs = [lower+random.rand(len(lower))*(upper-lower) for i in range(100)]
+            results = []
+            for numthreads in [1,4]:
+                assert(checker.SendCommand('SetNarrowPhaseThreads %d'%numthreads) is not None)
+                report=CollisionReport()
+                collisions = []
+                for config in configs:
+                    robot.SetDOFValues(config)
+                    if robot.CheckSelfCollision(report):
+                        assert(report.plink1 is not None and report.plink2 is not None)
+                        collisions.append((report.plink1.GetName(),report.plink2.GetName()))
+                    else:
+                        collisions.append(None)
+                results.append(collisions)
+            # the threads report the lowest colliding pair, so the reports are the ones of the serial check
+            assert(results[0] == results[1])
+            checker.SendCommand('SetNarrowPhaseThreads 1')
+
+    def test_continuouscollision(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        checker=env.GetCollisionChecker()
+        lower,upper = robot.GetDOFLimits()
+        lower = maximum(lower,-pi)
+        upper = minimum(upper,pi)
+        resolutions = robot.GetDOFResolutions()
+        with env:
+            numcolliding = 0
+            collidingmotion = None
+            checker.SetCollisionOptions(CollisionOptions.Contacts)
+            for itry in range(40):
+                q0 = lower+random.rand(len(lower))*(upper-lower)
+                q1 = lower+random.rand(len(lower))*(upper-lower)
+                robot.SetDOFValues(q0)
+                if env.CheckCollision(robot):
+                    continue
+                # first colliding configuration when discretizing at the DOF resolutions
+                numsteps = max(1,int(ceil(max(abs(q1-q0)/resolutions))))
+                firsthit = None
+                for istep in range(1,numsteps+1):
+                    robot.SetDOFValues(q0+(q1-q0)*istep/float(numsteps))
+                    if env.CheckCollision(robot):
+                        firsthit = istep/float(numsteps)
+                        break
+                robot.SetDOFValues(q0)
+                report=CollisionReport()
+                bcollision, timeofcontact = checker.CheckContinuousCollision(robot,q0,q1,report)
+                assert(transdist(robot.GetDOFValues(),q0) <= g_epsilon) # the state is not changed
+                if firsthit is not None:
+                    numcolliding += 1
+                    assert(bcollision)
+                    assert(timeofcontact <= firsthit+0.01)
+                    assert(report.plink1 is not None and report.plink1.GetParent() == robot)
+                if bcollision:
+                    # the contacts are the ones at the time of contact
+                    assert(len(report.contacts) > 0)
+                else:
+                    assert(timeofcontact == 1)
+                if bcollision and collidingmotion is None:
+                    collidingmotion = (q0,q1,timeofcontact)
+            checker.SetCollisionOptions(0)
+            assert(collidingmotion is not None)
+            q0,q1,timeofcontact = collidingmotion
+            # with CO_ActiveDOFs only the links moved by the active DOFs are checked
+            robot.SetActiveDOFs(range(robot.GetDOF()))
+            checker.SetCollisionOptions(CollisionOptions.ActiveDOFs)
+            bcollision, activetimeofcontact = checker.CheckContinuousCollision(robot,q0,q1)
+            assert(bcollision and abs(activetimeofcontact-timeofcontact) <= g_epsilon)
+            robot.SetActiveDOFs([])
+            assert(not checker.CheckContinuousCollision(robot,q0,q1)[0])
+            checker.SetCollisionOptions(0)
+            # the collision callbacks see the contacts and can ignore them
+            reports = []
+            def collisioncallback(report,fromphysics):
+                reports.append((report.plink1,report.plink2))
+                return CollisionAction.Ignore
+            handle = env.RegisterCollisionCallback(collisioncallback)
+            bcollision, ignoredtimeofcontact = checker.CheckContinuousCollision(robot,q0,q1)
+            assert(not bcollision and ignoredtimeofcontact == 1)
+            assert(len(reports) > 0 and reports[0][0].GetParent() == robot)
+            handle.Close()
+            assert(checker.CheckContinuousCollision(robot,q0,q1)[0])
+
+    def test_rays(self):
+        env=self.env
+        with env:
+            box=RaveCreateKinBody(env,'')
+            box.InitFromBoxes(array([[0,0,0.5,0.5,0.5,0.5]]),True)
+            box.SetName('box')
+            env.Add(box)
+            sphere=RaveCreateKinBody(env,'')
+            sphere.InitFromSpheres(array([[2,0,0.5,0.5]]),True)
+            sphere.SetName('sphere')
+            env.Add(sphere)
+            checker=env.GetCollisionChecker()
+            report=CollisionReport()
+            assert(checker.CheckCollision(Ray([0,0,3],[0,0,-5]),report))
+            assert(report.plink1.GetParent() == box)
+            assert(abs(report.minDistance-2) <= g_epsilon)
+            assert(transdist(report.contacts[0].norm,[0,0,1]) <= g_epsilon)
+            assert(not checker.CheckCollision(Ray([0,0,3],[0,0,-1])))
+            assert(checker.CheckCollision(Ray([2,0,3],[0,0,-5]),sphere))
+            assert(not checker.CheckCollision(Ray([2,0,3],[0,0,-5]),box))
+            
+            rays = array([[x,0,3,0,0,-5] for x in linspace(-1,3,41)])
+            for numthreads in [1,4]:
+                assert(checker.SendCommand('SetNarrowPhaseThreads %d'%numthreads) is not None)
+                collision,info = checker.CheckCollisionRays(rays,None)
+                for iray,ray in enumerate(rays):
+                    assert(collision[iray] == checker.CheckCollision(Ray(ray[0:3],ray[3:6])))
+                    if abs(ray[0]) < 0.45:
+                        assert(collision[iray] and abs(info[iray,2]-1) <= g_epsilon)
+            checker.SendCommand('SetNarrowPhaseThreads 1')
+
 # class test_bullet(RunCollision):
 #     def __init__(self):
 #         RunCollision.__init__(self, 'bullet')
@@ -13,6 +13,8 @@
 # limitations under the License.
 from common_test_openrave import *
 from openravepy import openravepy_configurationcache
+import threading
+import struct
 
 class TestConfigurationCache(EnvironmentSetup):
     def setup(self):
@@ -135,6 +137,175 @@ class TestConfigurationCache(EnvironmentSetup):
             self.log.info('writing cache to file...')
             cachechecker.SendCommand('SaveCache')
 
+    def test_mapcache(self):
+        self.LoadEnv('data/lab1.env.xml')
+        env=self.env
+        robot=env.GetRobots()[0]
+        robot.SetActiveDOFs(range(7))
+        cache=openravepy_configurationcache.ConfigurationCache(robot)
+        filename = os.path.join(RaveGetHomeDirectory(), 'test_configurationcache.flat')
+        logfilename = filename + '.log'
+        for f in [filename, logfilename]:
+            if os.path.exists(f):
+                os.remove(f)
+        cache.SetWriteAheadLog(logfilename)
+
+        originalvalues = array([0,pi/2,0,pi/6,0,0,0])
+        sampler = RaveCreateSpaceSampler(env, u'MT19937')
+        sampler.SetSpaceDOF(robot.GetActiveDOF())
+        report=CollisionReport()
+        with env:
+            for iter in range(0, 2000):
+                robot.SetActiveDOFValues(originalvalues + 0.05*(sampler.SampleSequence(SampleDataType.Real,1)-0.5))
+                samplevalues = robot.GetActiveDOFValues()
+                incollision = env.CheckCollision(robot, report=report)
+                cache.InsertConfiguration(samplevalues, report if incollision else None)
+            assert(cache.SaveCache(filename))
+            cache.FlushWriteAheadLog()
+
+            # the mapped file answers the same as the tree it was saved from
+            mappedcache=openravepy_configurationcache.ConfigurationCache(robot)
+            assert(mappedcache.MapCache(filename))
+            assert(mappedcache.GetNumNodes() == 0)
+            loadedcache=openravepy_configurationcache.ConfigurationCache(robot)
+            assert(loadedcache.LoadCache(filename))
+            assert(loadedcache.GetNumNodes() == cache.GetNumNodes())
+            assert(loadedcache.Validate())
+            for iter in range(0, 200):
+                samplevalues = originalvalues + 0.05*(sampler.SampleSequence(SampleDataType.Real,1)-0.5)
+                ret, closestdist, collisioninfo = cache.CheckCollision(samplevalues)
+                for othercache in [mappedcache, loadedcache]:
+                    otherret, otherclosestdist, othercollisioninfo = othercache.CheckCollision(samplevalues)
+                    assert(otherret == ret)
+
+            # inconsistent files are rejected instead of being followed: a child index out of range, a child that is the root which makes a
+            # cycle, and a node offset that overflows
+            filedata = open(filename, 'rb').read()
+            numchildren, rootindex = struct.unpack('<II', filedata[24:32])
+            nodesoffset, statesoffset, childrenoffset = struct.unpack('<QQQ', filedata[64:88])
+            assert(numchildren > 0)
+            corruptions = [filedata[:childrenoffset] + struct.pack('<I', 0xffffffff) + filedata[childrenoffset+4:],
+                           filedata[:childrenoffset] + struct.pack('<I', rootindex) + filedata[childrenoffset+4:],
+                           filedata[:64] + struct.pack('<Q', 2**64-8) + filedata[72:]]
+            corruptedfilename = filename + '.corrupted'
+            for corrupted in corruptions:
+                open(corruptedfilename, 'wb').write(corrupted)
+                assert(not openravepy_configurationcache.ConfigurationCache(robot).MapCache(corruptedfilename))
+                assert(not openravepy_configurationcache.ConfigurationCache(robot).LoadCache(corruptedfilename))
+            os.remove(corruptedfilename)
+
+            # merging the log of the inserted configurations into an empty file gives back all the configurations
+            os.remove(filename)
+            mergedcache=openravepy_configurationcache.ConfigurationCache(robot)
+            numinserted = mergedcache.MergeCache(filename, logfilename)
+            assert(numinserted > 0 and mergedcache.GetNumNodes() == cache.GetNumNodes())
+            assert(not os.path.exists(logfilename))
+            assert(mergedcache.Validate())
+        os.remove(filename)
+
+    def test_mergecache(self):
+        self.LoadEnv('data/lab1.env.xml')
+        env=self.env
+        robot=env.GetRobots()[0]
+        robot.SetActiveDOFs(range(7))
+        filename = os.path.join(RaveGetHomeDirectory(), 'test_mergecache.flat')
+        logfilename = filename + '.log'
+        for f in [filename, logfilename, logfilename + '.merge', logfilename + '.lock']:
+            if os.path.exists(f):
+                os.remove(f)
+
+        # two independent caches log to the same file like two processes sharing the flat cache file
+        caches = [openravepy_configurationcache.ConfigurationCache(robot) for i in range(2)]
+        for cache in caches:
+            cache.SetWriteAheadLog(logfilename)
+        sampler = RaveCreateSpaceSampler(env, u'MT19937')
+        sampler.SetSpaceDOF(robot.GetActiveDOF())
+        report=CollisionReport()
+        def InsertConfigurations(cache, originalvalues, numconfigurations):
+            for iter in range(0, numconfigurations):
+                robot.SetActiveDOFValues(originalvalues + 0.05*(sampler.SampleSequence(SampleDataType.Real,1)-0.5))
+                samplevalues = robot.GetActiveDOFValues()
+                incollision = env.CheckCollision(robot, report=report)
+                cache.InsertConfiguration(samplevalues, report if incollision else None)
+            cache.FlushWriteAheadLog()
+
+        with env:
+            InsertConfigurations(caches[0], array([0,pi/2,0,pi/6,0,0,0]), 500)
+            # a merge that did not finish leaves the renamed log behind
+            os.rename(logfilename, logfilename + '.merge')
+            InsertConfigurations(caches[1], array([1,pi/2,0,pi/6,0,0,0]), 500)
+
+            # the renamed log and the current log are both merged
+            mergedcache=openravepy_configurationcache.ConfigurationCache(robot)
+            numinserted = mergedcache.MergeCache(filename, logfilename)
+            assert(numinserted > 0 and mergedcache.GetNumNodes() == caches[0].GetNumNodes() + caches[1].GetNumNodes())
+            assert(not os.path.exists(logfilename) and not os.path.exists(logfilename + '.merge'))
+            assert(mergedcache.Validate())
+
+            # records written after the merge go to a new log and are merged the next time
+            numnodes = caches[0].GetNumNodes()
+            InsertConfigurations(caches[0], array([-1,pi/2,0,pi/6,0,0,0]), 500)
+            assert(os.path.exists(logfilename))
+            numinserted = mergedcache.MergeCache(filename, logfilename)
+            assert(numinserted == caches[0].GetNumNodes() - numnodes)
+            assert(mergedcache.GetNumNodes() == caches[0].GetNumNodes() + caches[1].GetNumNodes())
+            assert(not os.path.exists(logfilename))
+        for f in [filename, logfilename + '.lock']:
+            os.remove(f)
+
+    def test_sharedselfcache(self):
+        self.LoadEnv('data/lab1.env.xml')
+        env=self.env
+        with env:
+            robot=env.GetRobots()[0]
+            lower,upper = robot.GetDOFLimits()
+            lower = maximum(lower,-pi)
+            upper = minimum(upper,pi)
+            sampler = RaveCreateSpaceSampler(env, u'MT19937')
+            sampler.SetSpaceDOF(robot.GetDOF())
+            samples = [lower+(upper-lower)*sampler.SampleSequence(SampleDataType.Real,1) for i in range(200)]
+            incollisions = []
+            for sample in samples:
+                robot.SetDOFValues(sample)
+                incollisions.append(robot.CheckSelfCollision())
+            cachechecker = RaveCreateCollisionChecker(env,'CacheChecker')
+            assert(cachechecker.SendCommand('TrackRobotState %s'%robot.GetName()) is not None)
+            assert(cachechecker.SendCommand('SetSelfCacheConcurrent 1') is not None)
+            env.SetCollisionChecker(cachechecker)
+            robot.SetSelfCollisionChecker(cachechecker)
+
+        # the checkers of the cloned environments share the self collision cache, every thread inserts the configurations of its own robot
+        clonedenvs = [env.CloneSelf(CloningOptions.Bodies) for ithread in range(4)]
+        def checkthread(clonedenv, ithread):
+            with clonedenv:
+                clonedrobot = clonedenv.GetRobot(robot.GetName())
+                for isample in range(3*len(samples)):
+                    clonedrobot.SetDOFValues(samples[(isample+ithread*len(samples)/4)%len(samples)])
+                    clonedrobot.CheckSelfCollision()
+        threads = [threading.Thread(target=checkthread,args=(clonedenv,ithread)) for ithread,clonedenv in enumerate(clonedenvs)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        numnodes = [int(clonedenv.GetCollisionChecker().SendCommand('GetSelfCacheStatistics').split()[3]) for clonedenv in clonedenvs]
+        assert(numnodes[0] > 0 and all([n == numnodes[0] for n in numnodes]))
+
+        # the cache only holds links of the original environment, so it outlives the cloned environments
+        for clonedenv in clonedenvs:
+            clonedenv.Destroy()
+        with env:
+            assert(int(cachechecker.SendCommand('ValidateSelfCache')) == 1)
+            assert(cachechecker.SendCommand('SaveCache') is not None)
+            report = CollisionReport()
+            for sample, expectedcollision in izip(samples, incollisions):
+                robot.SetDOFValues(sample)
+                incollision = robot.CheckSelfCollision(report)
+                if incollision:
+                    # the links reported from the cache belong to this environment
+                    assert(report.plink1.GetParent().GetEnv() == env and report.plink2.GetParent().GetEnv() == env)
+                # the cache can be conservative, but never gives an unexpected free space
+                assert(incollision or not expectedcollision)
+
     def test_find_insert(self):
 
         self.LoadEnv('data/lab1.env.xml')
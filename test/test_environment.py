@@ -191,6 +191,52 @@ class TestEnvironment(EnvironmentSetup):
             assert(endtime <= 0.05)
             misc.CompareEnvironments(env,clonedenv,epsilon=g_epsilon)
             
+    def test_clone_manybodies(self):
+        env=self.env
+        with env:
+            for ibody in range(300):
+                body = RaveCreateKinBody(env,'')
+                body.SetName('box%d'%ibody)
+                body.InitFromBoxes(array([[0,0,0,0.05,0.05,0.05]]),True)
+                body.SetTransform(matrixFromPose([1,0,0,0,0.2*(ibody%20),0.2*(ibody/20),0]))
+                env.Add(body)
+            
+            clonedenv = Environment()
+            clonedenv.Clone(env, CloningOptions.Bodies)
+            misc.CompareEnvironments(env,clonedenv,epsilon=g_epsilon)
+
+            # bodies are matched by name, so only the states are copied
+            body = env.GetKinBody('box150')
+            T = body.GetTransform()
+            T[2,3] += 1
+            body.SetTransform(T)
+            starttime=time.time()
+            clonedenv.Clone(env, CloningOptions.Bodies)
+            endtime=time.time()-starttime
+            self.log.info('new clone time: %fs',endtime)
+            misc.CompareEnvironments(env,clonedenv,epsilon=g_epsilon)
+            assert(transdist(clonedenv.GetKinBody('box150').GetTransform(),T) <= g_epsilon)
+
+            # the cloned geometries share their infos and collision meshes with the reference geometries until one of them is modified
+            for body in env.GetBodies():
+                clonedgeom = clonedenv.GetKinBody(body.GetName()).GetLinks()[0].GetGeometries()[0]
+                assert(clonedgeom.SharesInfo(body.GetLinks()[0].GetGeometries()[0]))
+            geom = env.GetKinBody('box10').GetLinks()[0].GetGeometries()[0]
+            clonedgeom = clonedenv.GetKinBody('box10').GetLinks()[0].GetGeometries()[0]
+            refmesh = geom.GetCollisionMesh()
+            newmesh = TriMesh(refmesh.vertices*2,refmesh.indices)
+            clonedgeom.SetCollisionMesh(newmesh)
+            assert(not clonedgeom.SharesInfo(geom))
+            assert(transdist(clonedgeom.GetCollisionMesh().vertices,newmesh.vertices) <= g_epsilon)
+            assert(transdist(geom.GetCollisionMesh().vertices,refmesh.vertices) <= g_epsilon)
+            geom2 = env.GetKinBody('box11').GetLinks()[0].GetGeometries()[0]
+            clonedgeom2 = clonedenv.GetKinBody('box11').GetLinks()[0].GetGeometries()[0]
+            geom2.SetTransparency(0.5)
+            assert(not clonedgeom2.SharesInfo(geom2))
+            assert(geom2.GetTransparency() == 0.5 and clonedgeom2.GetTransparency() == 0)
+
+            clonedenv.Destroy()
+
     def test_multithread(self):
         self.log.info('test multiple threads accessing same resource')
         def mythread(env,threadid):
@@ -262,3 +308,142 @@ class TestEnvironment(EnvironmentSetup):
         # thread is done, so should be able to lock
         assert(env.Lock(1.0))
         env.Unlock()
+
+    def test_concurrentqueries(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        with env:
+            box = RaveCreateKinBody(env,'')
+            box.InitFromBoxes(array([[0,0,0,0.1,0.1,0.1]]),True)
+            box.SetName('movingbox')
+            env.Add(box)
+            robottrans = robot.GetTransform()
+            Tfree = eye(4); Tfree[0:3,3] = robottrans[0:3,3]+array([0,0,10])
+            Tcolliding = eye(4); Tcolliding[0:3,3] = robot.GetLinks()[0].GetGlobalCOM()
+            box.SetTransform(Tfree)
+            assert(not env.CheckCollision(box,robot))
+            box.SetTransform(Tcolliding)
+            assert(env.CheckCollision(box,robot))
+            box.SetTransform(Tfree)
+        env.ResetLockStatistics()
+        env.SetConcurrentQueries(True)
+        try:
+            assert(env.IsConcurrentQueries())
+            # the queries run at the same time as a writer that moves the box and adds and removes bodies
+            errors = []
+            numqueries = [0]*4
+            done = threading.Event()
+            def querythread(ithread):
+                try:
+                    report = CollisionReport()
+                    while not done.is_set():
+                        if env.CheckCollision(box,robot,report=report):
+                            assert(report.plink1 is not None and report.plink2 is not None)
+                            assert(set([report.plink1.GetParent().GetName(),report.plink2.GetParent().GetName()]) == set([box.GetName(),robot.GetName()]))
+                        env.CheckCollision(robot)
+                        numqueries[ithread] += 1
+                except Exception as e:
+                    errors.append(e)
+            threads = [threading.Thread(target=querythread,args=(ithread,)) for ithread in range(len(numqueries))]
+            for t in threads:
+                t.start()
+            try:
+                for iter in range(200):
+                    with env:
+                        box.SetTransform(Tcolliding if iter%2 == 0 else Tfree)
+                        if iter%20 == 0:
+                            box2 = RaveCreateKinBody(env,'')
+                            box2.InitFromBoxes(array([[0,0,0,0.05,0.05,0.05]]),True)
+                            box2.SetName('tempbox')
+                            env.Add(box2)
+                            env.Remove(box2)
+                    time.sleep(0.001)
+            finally:
+                done.set()
+                for t in threads:
+                    t.join()
+            assert(len(errors) == 0)
+            assert(all(numqueries))
+            # every thread sees the last state of the writer
+            results = [None]*4
+            def finalquery(ithread):
+                results[ithread] = env.CheckCollision(box,robot)
+            threads = [threading.Thread(target=finalquery,args=(ithread,)) for ithread in range(len(results))]
+            for t in threads:
+                t.start()
+            for t in threads:
+                t.join()
+            assert(results == [False]*len(results))
+        finally:
+            env.SetConcurrentQueries(False)
+        assert(not env.IsConcurrentQueries())
+        with env:
+            assert(not env.CheckCollision(box,robot))
+        stats = env.GetLockStatistics()
+        assert(stats['waittime'] >= stats['maxwaittime'])
+        env.ResetLockStatistics()
+        stats = env.GetLockStatistics()
+        assert(stats['numcontended'] == 0 and stats['waittime'] == 0 and stats['maxwaittime'] == 0)
+
+    def test_kinematicmodelcache(self):
+        env=self.env
+        RaveEvictKinematicModelCache()
+        RaveSetKinematicModelCacheEnabled(True)
+        try:
+            stats0 = RaveGetKinematicModelCacheStatistics()
+            robot1 = env.ReadRobotURI('robots/barrettwam.robot.xml')
+            env.Add(robot1,True)
+            stats1 = RaveGetKinematicModelCacheStatistics()
+            assert(stats1['nummisses'] == stats0['nummisses']+1 and stats1['numentries'] == 1)
+            # a second environment creates the robot from the cached model
+            env2 = Environment()
+            try:
+                robot2 = env2.ReadRobotURI('robots/barrettwam.robot.xml')
+                env2.Add(robot2,True)
+                stats2 = RaveGetKinematicModelCacheStatistics()
+                assert(stats2['numhits'] == stats1['numhits']+1 and stats2['nummisses'] == stats1['nummisses'])
+                assert(robot2.GetName() == robot1.GetName() and robot2.GetURI() == robot1.GetURI())
+                assert(robot2.GetKinematicsGeometryHash() == robot1.GetKinematicsGeometryHash())
+                assert(robot2.GetRobotStructureHash() == robot1.GetRobotStructureHash())
+                assert(len(robot2.GetPassiveJoints()) == len(robot1.GetPassiveJoints()))
+                assert(transdist(env2.Triangulate(robot2).vertices,env.Triangulate(robot1).vertices) <= g_epsilon)
+            finally:
+                env2.Destroy()
+            assert(RaveEvictKinematicModelCache('robots/barrettwam.robot.xml') == 1)
+            assert(RaveGetKinematicModelCacheStatistics()['numentries'] == 0)
+        finally:
+            RaveSetKinematicModelCacheEnabled(False)
+
+    def test_kinematicmodelcachemodified(self):
+        import tempfile, shutil
+        env=self.env
+        robotxml = '''<robot name="cachedrobot">
+  <kinbody>
+    <body name="base">
+      <geom type="box"><extents>%s 0.1 0.1</extents></geom>
+    </body>
+  </kinbody>
+</robot>
+'''
+        tempdir = tempfile.mkdtemp()
+        RaveEvictKinematicModelCache()
+        RaveSetKinematicModelCacheEnabled(True)
+        try:
+            filename = os.path.join(tempdir,'cachedrobot.robot.xml')
+            open(filename,'w').write(robotxml%'0.1')
+            robot1 = env.ReadRobotURI(filename)
+            stats1 = RaveGetKinematicModelCacheStatistics()
+            # rewriting the file within the same second still reads it again since its size and sub-second modification time change
+            open(filename,'w').write(robotxml%'0.25')
+            robot2 = env.ReadRobotURI(filename)
+            stats2 = RaveGetKinematicModelCacheStatistics()
+            assert(stats2['nummisses'] == stats1['nummisses']+1 and stats2['numhits'] == stats1['numhits'])
+            assert(abs(robot2.GetLinks()[0].GetGeometries()[0].GetBoxExtents()[0]-0.25) <= g_epsilon)
+            robot3 = env.ReadRobotURI(filename)
+            assert(RaveGetKinematicModelCacheStatistics()['numhits'] == stats2['numhits']+1)
+            assert(abs(robot3.GetLinks()[0].GetGeometries()[0].GetBoxExtents()[0]-0.25) <= g_epsilon)
+        finally:
+            RaveSetKinematicModelCacheEnabled(False)
+            RaveEvictKinematicModelCache()
+            shutil.rmtree(tempdir)
@@ -282,6 +282,97 @@ class TestIkSolver(EnvironmentSetup):
                     f += 1.0/numCloseSolutions
                     assert(numCloseSolutions==1)
     
+    def test_solveallbatch(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        ikmodel = databases.inversekinematics.InverseKinematicsModel(robot,IkParameterization.Type.Transform6D)
+        if not ikmodel.load():
+            ikmodel.autogenerate()
+
+        with env:
+            manip = ikmodel.manip
+            lower,upper = robot.GetDOFLimits(manip.GetArmIndices())
+            ikparams = []
+            for i in range(50):
+                robot.SetDOFValues(lower+random.rand(len(lower))*(upper-lower),manip.GetArmIndices())
+                ikparams.append(manip.GetIkParameterization(IkParameterizationType.Transform6D,False))
+            
+            filteroptions = IkFilterOptions.IgnoreSelfCollisions|IkFilterOptions.IgnoreCustomFilters
+            manip.GetIkSolver().SendCommand('SetBatchThreads 4')
+            batchsolutions = manip.GetIkSolver().SolveAllBatch(ikparams,filteroptions)
+            assert(len(batchsolutions) == len(ikparams))
+            for ikparam, solutions in zip(ikparams, batchsolutions):
+                ikreturns = manip.GetIkSolver().SolveAll(ikparam,filteroptions)
+                assert(len(solutions) == len(ikreturns) and len(solutions) > 0)
+                # same solutions in the same order as SolveAll
+                for solution, ikreturn in zip(solutions, ikreturns):
+                    assert(transdist(solution, ikreturn.GetSolution()) <= 1e-9)
+                for solution in solutions:
+                    robot.SetDOFValues(solution,manip.GetArmIndices())
+                    assert(transdist(manip.GetIkParameterization(IkParameterizationType.Transform6D,False).GetTransform6D(),ikparam.GetTransform6D()) <= 1e-6)
+                    
+    def test_findiksolutionsbatch(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        ikmodel = databases.inversekinematics.InverseKinematicsModel(robot,IkParameterization.Type.Transform6D)
+        if not ikmodel.load():
+            ikmodel.autogenerate()
+
+        with env:
+            manip = ikmodel.manip
+            lower,upper = robot.GetDOFLimits(manip.GetArmIndices())
+            Tposes = []
+            for i in range(20):
+                robot.SetDOFValues(lower+random.rand(len(lower))*(upper-lower),manip.GetArmIndices())
+                Tposes.append(manip.GetTransform())
+
+            filteroptions = IkFilterOptions.IgnoreSelfCollisions|IkFilterOptions.IgnoreCustomFilters
+            batchsolutions = manip.FindIKSolutionsBatch(Tposes,filteroptions)
+            assert(len(batchsolutions) == len(Tposes))
+            for Tpose, solutions in izip(Tposes, batchsolutions):
+                assert(len(solutions) == len(manip.FindIKSolutions(Tpose,filteroptions)) and len(solutions) > 0)
+                for solution in solutions:
+                    robot.SetDOFValues(solution,manip.GetArmIndices())
+                    assert(transdist(manip.GetTransform(),Tpose) <= 1e-6)
+
+    def test_freesearch(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        ikmodel = databases.inversekinematics.InverseKinematicsModel(robot,IkParameterization.Type.Transform6D)
+        if not ikmodel.load():
+            ikmodel.autogenerate()
+
+        with env:
+            manip = ikmodel.manip
+            assert(manip.GetIkSolver().GetNumFreeParameters() > 0)
+            manip.GetIkSolver().SendCommand('SetFreeSearchTolerance 0.01')
+            assert(manip.GetIkSolver().SendCommand('SetSolutionCache 16 0.01') is not None)
+            lower,upper = robot.GetDOFLimits(manip.GetArmIndices())
+            for i in range(10):
+                values = lower+(0.1+0.8*random.rand(len(lower)))*(upper-lower)
+                robot.SetDOFValues(values,manip.GetArmIndices())
+                T = manip.GetTransform()
+                # solving twice, the second time the free values come from the cache
+                for j in range(2):
+                    sol = manip.FindIKSolution(T,IkFilterOptions.IgnoreSelfCollisions)
+                    assert(sol is not None and sum((sol-values)**2) <= 1e-6)
+
+            # with the default unbounded tolerance the first solution of the walk from the current values is returned, also when it comes from the cache
+            manip.GetIkSolver().SendCommand('SetFreeSearchTolerance 1e30')
+            for i in range(10):
+                values = lower+(0.1+0.8*random.rand(len(lower)))*(upper-lower)
+                robot.SetDOFValues(values,manip.GetArmIndices())
+                T = manip.GetTransform()
+                for j in range(2):
+                    sol = manip.FindIKSolution(T,IkFilterOptions.IgnoreSelfCollisions)
+                    assert(sol is not None)
+                    with robot:
+                        robot.SetDOFValues(sol,manip.GetArmIndices())
+                        assert(transdist(manip.GetTransform(),T) <= 1e-6)
+                    
     def test_circularfree(self):
         # test when free joint is circular and IK doesn't succeed (thanks to Chris Dellin)
         robotxmldata = '''<Robot name="BarrettWAM">
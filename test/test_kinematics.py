@@ -876,6 +876,63 @@ class TestKinematics(EnvironmentSetup):
         assert(J0a.GetMimicDOFIndices() == [0])
         assert(J0b.GetMimicDOFIndices() == [0])
 
+    def test_forwardkinematicsprogram(self):
+        self.log.info('check that the precompiled forward kinematics matches the generic forward kinematics')
+        env=self.env
+        for robotfile in ['robots/barrettwam.robot.xml', 'robots/pr2-beta-static.zae', 'robots/puma.robot.xml']:
+            env.Reset()
+            robot=self.LoadRobot(robotfile)
+            with env:
+                lowerlimit,upperlimit = robot.GetDOFLimits()
+                lowerlimit = numpy.maximum(lowerlimit,-numpy.pi)
+                upperlimit = numpy.minimum(upperlimit,numpy.pi)
+                for i in range(20):
+                    dofvalues = lowerlimit+numpy.random.rand(len(lowerlimit))*(upperlimit-lowerlimit)
+                    robot.SendCommand('SetUseForwardKinematicsProgram 0')
+                    robot.SetDOFValues(dofvalues)
+                    Tgeneric,doflastvaluesgeneric = robot.GetLinkTransformations(True)
+                    robot.SendCommand('SetUseForwardKinematicsProgram 1')
+                    robot.SetDOFValues(dofvalues)
+                    Tprogram,doflastvaluesprogram = robot.GetLinkTransformations(True)
+                    assert( transdist(Tgeneric,Tprogram) <= g_epsilon*len(Tgeneric) )
+                    assert( transdist(doflastvaluesgeneric,doflastvaluesprogram) <= g_epsilon*len(doflastvaluesgeneric) )
+
+                # the program caches the joint offsets, so has to follow SetWrapOffset
+                offsets = lowerlimit+numpy.random.rand(len(lowerlimit))*(upperlimit-lowerlimit)
+                for i,offset in enumerate(offsets):
+                    joint=robot.GetJointFromDOFIndex(i)
+                    joint.SetWrapOffset(offset,i-joint.GetDOFIndex())
+                for i in range(5):
+                    dofvalues = lowerlimit+numpy.random.rand(len(lowerlimit))*(upperlimit-lowerlimit)
+                    robot.SendCommand('SetUseForwardKinematicsProgram 0')
+                    robot.SetDOFValues(dofvalues)
+                    Tgeneric = robot.GetLinkTransformations()
+                    robot.SendCommand('SetUseForwardKinematicsProgram 1')
+                    robot.SetDOFValues(dofvalues)
+                    Tprogram = robot.GetLinkTransformations()
+                    assert( transdist(Tgeneric,Tprogram) <= g_epsilon*len(Tgeneric) )
+
+    def test_computelinktransformationsbatch(self):
+        self.log.info('check that ComputeLinkTransformationsBatch matches SetDOFValues and GetLinkTransformations')
+        env=self.env
+        for robotfile in ['robots/barrettwam.robot.xml', 'robots/pr2-beta-static.zae', 'robots/puma.robot.xml']:
+            env.Reset()
+            robot=self.LoadRobot(robotfile)
+            with env:
+                lowerlimit,upperlimit = robot.GetDOFLimits()
+                lowerlimit = numpy.maximum(lowerlimit,-numpy.pi)
+                upperlimit = numpy.minimum(upperlimit,numpy.pi)
+                # more than one block of configurations
+                configs = [lowerlimit+numpy.random.rand(len(lowerlimit))*(upperlimit-lowerlimit) for i in range(100)]
+                Tstart = robot.GetLinkTransformations()
+                Tbatch = robot.ComputeLinkTransformationsBatch(configs)
+                assert( transdist(Tstart,robot.GetLinkTransformations()) <= g_epsilon )
+                assert( len(Tbatch) == len(configs) )
+                for config,Tconfig in zip(configs,Tbatch):
+                    robot.SetDOFValues(config)
+                    Tlinks = robot.GetLinkTransformations()
+                    assert( transdist(Tlinks,Tconfig) <= g_epsilon*len(Tlinks) )
+
     def test_specification(self):
         env=self.env
         self.LoadEnv('data/lab1.env.xml')
@@ -900,6 +957,55 @@ class TestKinematics(EnvironmentSetup):
             assert(not env.CheckCollision(robot) and not env.CheckCollision(link))
             robot.GetLinks()[0].Enable(True)
             assert(env.CheckCollision(link) and env.CheckCollision(robot))
+
+    def test_changecallbacks(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        Prop_LinkTransforms = 0x100
+        Prop_LinkEnable = 0x800
+        with env:
+            robot=env.GetRobots()[0]
+            link=robot.GetLinks()[0]
+            calls = []
+            handle = robot.RegisterChangeCallback(Prop_LinkTransforms|Prop_LinkEnable, lambda: calls.append(1))
+            # without a deferrer every change is dispatched immediately
+            robot.SetTransform(robot.GetTransform())
+            assert(len(calls) == 1)
+            link.Enable(False)
+            assert(len(calls) == 2)
+            link.Enable(True)
+            del calls[:]
+
+            # a callback tracking several changed properties is called once per flush
+            deferrer = robot.DeferChangeCallbacks()
+            robot.SetTransform(robot.GetTransform())
+            link.Enable(False)
+            link.Enable(True)
+            assert(len(calls) == 0)
+            deferrer.Close()
+            assert(len(calls) == 1)
+            del calls[:]
+
+            # nested deferrers dispatch when the outermost one is released
+            outer = robot.DeferChangeCallbacks()
+            inner = robot.DeferChangeCallbacks()
+            robot.SetTransform(robot.GetTransform())
+            inner.Close()
+            assert(len(calls) == 0)
+            link.Enable(False)
+            link.Enable(True)
+            outer.Close()
+            assert(len(calls) == 1)
+            del calls[:]
+
+            # a callback unregistered while a deferrer is alive is not called
+            deferrer = robot.DeferChangeCallbacks()
+            robot.SetTransform(robot.GetTransform())
+            handle.Close()
+            deferrer.Close()
+            assert(len(calls) == 0)
+            robot.SetTransform(robot.GetTransform())
+            assert(len(calls) == 0)
             
     def test_inertia(self):
         env=self.env
@@ -621,6 +621,128 @@ class RunPlanning(EnvironmentSetup):
             assert(success)
             assert(not env.CheckCollision(collisionbody))
 
+    def test_parallelbirrt(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        with env:
+            robot = env.GetRobots()[0]
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            q0 = robot.GetActiveDOFValues()
+            goal = array(q0)
+            goal[0] += 1.0
+            goal[3] -= 0.5
+            robot.SetActiveDOFValues(goal)
+            assert(not env.CheckCollision(robot) and not robot.CheckSelfCollision())
+            robot.SetActiveDOFValues(q0)
+
+            params = Planner.PlannerParameters()
+            params.SetRobotActiveJoints(robot)
+            params.SetGoalConfig(goal)
+            params.SetExtraParameters('<numthreads>4</numthreads><seedstrategy>0</seedstrategy>')
+            planner = RaveCreatePlanner(env,'parallelbirrt')
+            assert(planner.InitPlan(robot, params))
+            for itry in range(3):
+                traj = RaveCreateTrajectory(env,'')
+                status = planner.PlanPath(traj)
+                assert(status.statusCode & PlannerStatusCode.HasSolution)
+                assert(traj.GetNumWaypoints() >= 2)
+                assert(transdist(traj.GetWaypoint(0,params.GetConfigurationSpecification()),q0) <= g_epsilon)
+                assert(transdist(traj.GetWaypoint(-1,params.GetConfigurationSpecification()),goal) <= g_epsilon)
+                # the robot of the environment is not moved by the workers
+                assert(transdist(robot.GetActiveDOFValues(),q0) <= g_epsilon)
+
+    def test_parallelbirrtcomparison(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        with env:
+            robot = env.GetRobots()[0]
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            q0 = robot.GetActiveDOFValues()
+            lower,upper = robot.GetActiveDOFLimits()
+            randomstate = random.RandomState(0)
+            goals = []
+            while len(goals) < 10:
+                goal = lower+randomstate.rand(len(lower))*(upper-lower)
+                robot.SetActiveDOFValues(goal)
+                if not env.CheckCollision(robot) and not robot.CheckSelfCollision():
+                    goals.append(goal)
+            robot.SetActiveDOFValues(q0)
+
+            # same iteration budget and seeds for both planners, the worker 0 of parallelbirrt runs with the seed of birrt
+            results = {}
+            for plannername in ['birrt','parallelbirrt']:
+                planner = RaveCreatePlanner(env,plannername)
+                numsuccess = 0
+                totaltime = 0
+                for igoal,goal in enumerate(goals):
+                    params = Planner.PlannerParameters()
+                    params.SetRobotActiveJoints(robot)
+                    params.SetGoalConfig(goal)
+                    params.SetMaxIterations(200)
+                    params.SetRandomGeneratorSeed(igoal+1)
+                    params.SetPostProcessing('','')
+                    params.SetExtraParameters('<numthreads>4</numthreads><seedstrategy>0</seedstrategy>')
+                    traj = RaveCreateTrajectory(env,'')
+                    starttime = time.time()
+                    if planner.InitPlan(robot, params) and planner.PlanPath(traj).statusCode & PlannerStatusCode.HasSolution:
+                        numsuccess += 1
+                    totaltime += time.time()-starttime
+                    robot.SetActiveDOFValues(q0)
+                results[plannername] = (numsuccess,totaltime)
+                self.log.info('%s: success rate %d/%d, average time %fs', plannername, numsuccess, len(goals), totaltime/len(goals))
+            assert(results['parallelbirrt'][0] >= results['birrt'][0])
+
+    def test_parallelshortcut(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        with env:
+            robot = env.GetRobots()[0]
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            q0 = robot.GetActiveDOFValues()
+            goal = array(q0)
+            goal[0] += 1.0
+            goal[3] -= 0.5
+            params = Planner.PlannerParameters()
+            params.SetRobotActiveJoints(robot)
+            params.SetGoalConfig(goal)
+            params.SetRandomGeneratorSeed(1)
+            params.SetPostProcessing('','')
+            planner = RaveCreatePlanner(env,'birrt')
+            assert(planner.InitPlan(robot, params))
+            rawtraj = RaveCreateTrajectory(env,'')
+            assert(planner.PlanPath(rawtraj).statusCode & PlannerStatusCode.HasSolution)
+
+            # for a fixed seed, every number of threads greater than 1 checks the same batches of shortcuts
+            waypoints = None
+            for numthreads in [2,3,4]:
+                traj = RaveCreateTrajectory(env,'')
+                traj.Clone(rawtraj,0)
+                status = planningutils.SmoothActiveDOFTrajectory(traj,robot,1,1,'parabolicsmoother2','<_nmaxiterations>100</_nmaxiterations><_nrandomgeneratorseed>7</_nrandomgeneratorseed><nshortcutthreads>%d</nshortcutthreads>'%numthreads)
+                assert(status.statusCode & PlannerStatusCode.HasSolution)
+                with robot:
+                    parameters = Planner.PlannerParameters()
+                    parameters.SetRobotActiveJoints(robot)
+                    planningutils.VerifyTrajectory(parameters,traj,samplingstep=0.002)
+                assert(transdist(traj.GetWaypoint(0,params.GetConfigurationSpecification()),q0) <= g_epsilon)
+                assert(transdist(traj.GetWaypoint(-1,params.GetConfigurationSpecification()),goal) <= g_epsilon)
+                if waypoints is None:
+                    waypoints = traj.GetWaypoints(0,traj.GetNumWaypoints())
+                else:
+                    assert(transdist(traj.GetWaypoints(0,traj.GetNumWaypoints()),waypoints) <= g_epsilon)
+                # the robot of the environment is not moved by the workers
+                assert(transdist(robot.GetActiveDOFValues(),q0) <= g_epsilon)
+
+    def test_spatialtreenearestneighbor(self):
+        env=self.env
+        planner = RaveCreatePlanner(env,'birrt')
+        out = planner.SendCommand('BenchmarkNearestNeighbor 7 200 100 2000')
+        values = [float(f) for f in out.split()]
+        assert(len(values) == 8)
+        assert(values[0] > 0 and values[4] > values[0])
+        assert(all(values[i] > 0 for i in [1,2,5,6]))
+        # the direct distances find the same nearest neighbors as the distance metric function
+        assert(values[3] == 0 and values[7] == 0)
+
 #generate_classes(RunPlanning, globals(), [('ode','ode'),('bullet','bullet')])
 
 class test_ode(RunPlanning):
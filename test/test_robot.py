@@ -671,6 +671,37 @@ class RunRobot(EnvironmentSetup):
         assert robot.CheckSelfCollision() # succeeds
         assert cloned_robot.CheckSelfCollision() # fails
 
+    def test_checkcollisionbatch(self):
+        self.log.info('test collision checking many configurations with the gil released')
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        with env:
+            manip = robot.GetActiveManipulator()
+            lower,upper = robot.GetDOFLimits(manip.GetArmIndices())
+            configs = lower+random.rand(100,len(lower))*(upper-lower)
+            initvalues = robot.GetDOFValues()
+            collisions = robot.CheckCollisionBatch(configs,manip.GetArmIndices())
+            assert(len(collisions) == len(configs))
+            assert(transdist(robot.GetDOFValues(),initvalues) <= g_epsilon)
+            for config, collision in izip(configs, collisions):
+                robot.SetDOFValues(config,manip.GetArmIndices())
+                assert(collision == (env.CheckCollision(robot) or robot.CheckSelfCollision()))
+            robot.SetDOFValues(initvalues)
+
+        # the checks lock the environment themselves and let the other threads run
+        import threading
+        results = [None]*4
+        def checkthread(ithread):
+            results[ithread] = robot.CheckCollisionBatch(configs,manip.GetArmIndices())
+        threads = [threading.Thread(target=checkthread,args=(ithread,)) for ithread in range(len(results))]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        for result in results:
+            assert(all(result == collisions))
+
     def test_4dikparameterization(self):
         self.log.info('test 4dikparameterization')
         env=self.env
@@ -0,0 +1,147 @@
+# -*- coding: utf-8 -*-
+# Copyright (C) 2026 agent <agent@local>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+from common_test_openrave import *
+
+class TestSensors(EnvironmentSetup):
+    def _AddWall(self, pos, extents):
+        """adds a box centered at pos with half extents"""
+        env=self.env
+        with env:
+            wall=RaveCreateKinBody(env,'')
+            wall.InitFromBoxes(array([list(pos)+list(extents)]),True)
+            wall.SetName('wall')
+            env.Add(wall)
+        return wall
+
+    def test_laser2d(self):
+        env=self.env
+        # the front face of the wall is the plane x=2
+        self._AddWall([2.5,0,0],[0.5,20,1])
+        sensor=RaveCreateSensor(env,'BaseLaser2D')
+        sensor.Configure(Sensor.ConfigureCommand.PowerOn)
+        sensor.SimulationStep(0.01)
+        data=sensor.GetSensorData(Sensor.Type.Laser)
+        geom=sensor.GetSensorGeometry(Sensor.Type.Laser)
+        assert(len(data.ranges) == len(data.intensity) and len(data.ranges) > 0)
+        assert(transdist(data.positions[0],zeros(3)) <= g_epsilon)
+        angles = arctan2(data.ranges[:,1],data.ranges[:,0])
+        # the beams scan the xy plane of the sensor from min_angle at a constant resolution
+        assert(abs(angles[0]-geom.min_angle[0]) <= 1e-4 and angles[-1] <= geom.max_angle[0]+1e-4)
+        assert(max(abs(diff(angles)-(angles[1]-angles[0]))) <= 1e-4)
+        numhits = 0
+        for r,intensity,angle in izip(data.ranges,data.intensity,angles):
+            assert(abs(r[2]) <= g_epsilon)
+            if abs(2*tan(angle)) < 19:
+                assert(intensity == 1)
+                assert(abs(r[0]-2) <= 1e-4)
+                numhits += 1
+            elif abs(2*tan(angle)) > 21:
+                assert(intensity == 0)
+                assert(abs(linalg.norm(r)-geom.max_range) <= 1e-4)
+        assert(numhits > len(data.ranges)/2)
+
+        # moving the sensor back moves the wall away by the same distance
+        T=eye(4); T[0,3]=-1
+        sensor.SetTransform(T)
+        sensor.SimulationStep(0.01)
+        data=sensor.GetSensorData(Sensor.Type.Laser)
+        assert(transdist(data.positions[0],T[0:3,3]) <= g_epsilon)
+        imiddle = len(data.ranges)/2
+        assert(data.intensity[imiddle] == 1 and abs(data.ranges[imiddle][0]-3) <= 1e-4)
+
+    def test_flashlidar3d(self):
+        env=self.env
+        # the front face of the wall is the plane z=2, the lidar looks along its z-axis
+        self._AddWall([0,0,2.5],[20,20,0.5])
+        sensor=RaveCreateSensor(env,'BaseFlashLidar3D')
+        sensor.Configure(Sensor.ConfigureCommand.PowerOn)
+        sensor.SimulationStep(0.01)
+        data=sensor.GetSensorData(Sensor.Type.Laser)
+        # default geometry of the sensor
+        width,height = 64,64
+        fx,fy,cx,cy = 500.0,500.0,250.0,250.0
+        assert(len(data.ranges) == width*height)
+        for w in range(width):
+            for h in range(height):
+                index = w*height+h
+                r = data.ranges[index]
+                assert(data.intensity[index] == 1)
+                assert(abs(r[2]-2) <= 1e-4)
+                # every beam goes through its element of the intrinsic matrix
+                assert(abs(r[0]/r[2]-(w-cx)/fx) <= 1e-5)
+                assert(abs(r[1]/r[2]-(h-cy)/fy) <= 1e-5)
+
+    def test_depthcamera(self):
+        env=self.env
+        # a plane at depth 2 and a small box in front of it at depth 1, the camera looks along its z-axis
+        self._AddWall([0,0,2.5],[20,20,0.5])
+        with env:
+            box=RaveCreateKinBody(env,'')
+            box.InitFromBoxes(array([[0,0,1.1,0.1,0.1,0.1]]),True)
+            box.SetName('box')
+            env.Add(box)
+        sensor=RaveCreateSensor(env,'BaseDepthCamera')
+        width,height = 32,24
+        fx,fy,cx,cy = 40.0,40.0,16.0,12.0
+        geom=sensor.GetSensorGeometry(Sensor.Type.Camera)
+        geom.width = width
+        geom.height = height
+        intrinsics = geom.intrinsics
+        intrinsics.K = array([[fx,0,cx],[0,fy,cy],[0,0,1]])
+        geom.intrinsics = intrinsics
+        sensor.SetSensorGeometry(geom)
+        geom=sensor.GetSensorGeometry(Sensor.Type.Camera)
+        assert(geom.width == width and geom.height == height)
+        assert(transdist(geom.intrinsics.K,array([[fx,0,cx],[0,fy,cy],[0,0,1]])) <= g_epsilon)
+
+        sensor.Configure(Sensor.ConfigureCommand.PowerOn)
+        sensor.SimulationStep(0.01)
+        data=sensor.GetSensorData(Sensor.Type.Laser)
+        assert(len(data.ranges) == width*height)
+        for v in range(height):
+            for u in range(width):
+                index = v*width+u
+                r = data.ranges[index]
+                assert(data.intensity[index] == 1)
+                # every pixel goes through its position in the intrinsic matrix
+                assert(abs(fx*r[0]/r[2]+cx-u) <= 1e-4 and abs(fy*r[1]/r[2]+cy-v) <= 1e-4)
+                # the box covers the pixels within 0.1*fx of the center at depth 1
+                if abs(u-cx) < 3.5 and abs(v-cy) < 3.5:
+                    assert(abs(r[2]-1) <= 1e-4)
+                elif abs(u-cx) > 4.5 or abs(v-cy) > 4.5:
+                    assert(abs(r[2]-2) <= 1e-4)
+        fullimage = array(data.ranges)
+
+        # a progressive image is refined over the next steps until it is the full resolution image
+        sensor.SendCommand('SetProgressive 1')
+        sensor.Configure(Sensor.ConfigureCommand.PowerOff)
+        sensor.Configure(Sensor.ConfigureCommand.PowerOn)
+        sensor.SimulationStep(0.01)
+        coarseimage = array(sensor.GetSensorData(Sensor.Type.Laser).ranges)
+        assert(coarseimage.shape == fullimage.shape)
+        for istep in range(2):
+            sensor.SimulationStep(0.01)
+        assert(transdist(array(sensor.GetSensorData(Sensor.Type.Laser).ranges),fullimage) <= 1e-4)
+
+        # turning progressive off in the middle of an image still casts every pixel of the next image
+        sensor.Configure(Sensor.ConfigureCommand.PowerOff)
+        sensor.Configure(Sensor.ConfigureCommand.PowerOn)
+        sensor.SimulationStep(0.01)
+        sensor.SimulationStep(0.01)
+        sensor.SendCommand('SetProgressive 0')
+        with env:
+            box.SetTransform(matrixFromPose([1,0,0,0,100,100,0]))
+        sensor.SimulationStep(1.0)
+        ranges = array(sensor.GetSensorData(Sensor.Type.Laser).ranges)
+        assert(all(abs(ranges[:,2]-2) <= 1e-4))
@@ -0,0 +1,199 @@
+# -*- coding: utf-8 -*-
+# Copyright (C) 2026 agent <agent@local>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+from common_test_openrave import *
+import socket
+import struct
+
+class TestTextServer(EnvironmentSetup):
+    port = 4781
+    def setup(self):
+        EnvironmentSetup.setup(self)
+        self.server = RaveCreateModule(self.env,'textserver')
+        self.env.AddModule(self.server,'%d querythreads 2'%self.port)
+        self.sockets = []
+
+    def teardown(self):
+        for s in self.sockets:
+            s.close()
+        EnvironmentSetup.teardown(self)
+
+    def _Connect(self):
+        s = socket.create_connection(('127.0.0.1',self.port))
+        s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        s.settimeout(10)
+        self.sockets.append(s)
+        return s
+
+    def _Receive(self, s, size):
+        data = ''
+        while len(data) < size:
+            chunk = s.recv(size-len(data))
+            assert(len(chunk) > 0)
+            data += chunk
+        return data
+
+    def _ReceiveReply(self, s):
+        """every reply is preceded by its size"""
+        size = struct.unpack('<i', self._Receive(s,4))[0]
+        return self._Receive(s,size)
+
+    def _GetTestValues(self, robot, count):
+        """returns count different dof values within the limits of the robot"""
+        lower,upper = robot.GetDOFLimits()
+        lower = maximum(lower,-1)
+        upper = minimum(upper,1)
+        return [lower+(upper-lower)*(i+1.0)/(count+1) for i in range(count)]
+
+    def test_pipelining(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot = env.GetRobots()[0]
+        robotid = robot.GetEnvironmentId()
+        dof = robot.GetDOF()
+        s = self._Connect()
+        # all the requests are sent at once, alternating commands that set the values with queries that read them on a clone of the environment
+        requests = ''
+        expectedvalues = self._GetTestValues(robot, 10)
+        for values in expectedvalues:
+            requests += 'body_setjoints %d %d %s\n'%(robotid, dof, ' '.join(['%.6f'%v for v in values]))
+            requests += 'body_getjoints %d\n'%robotid
+        requests += 'body_getdof %d\n'%robotid
+        s.sendall(requests)
+        # body_setjoints does not reply, every query replies in order with the values of the command sent before it
+        for values in expectedvalues:
+            reply = array([float(x) for x in self._ReceiveReply(s).split()])
+            assert(transdist(reply, values) <= 1e-4)
+        assert(int(self._ReceiveReply(s)) == dof)
+        assert(transdist(robot.GetDOFValues(), expectedvalues[-1]) <= 1e-4)
+
+    def test_interleaving(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot = env.GetRobots()[0]
+        robotid = robot.GetEnvironmentId()
+        dof = robot.GetDOF()
+        sockets = [self._Connect() for i in range(3)]
+        # commands and queries of several clients interleave, every client sees its own commands
+        for ivalues, values in enumerate(self._GetTestValues(robot, 5)):
+            for s in sockets:
+                s.sendall('body_setjoints %d %d %s\nbody_getdof %d\n'%(robotid, dof, ' '.join(['%.6f'%v for v in values]), robotid))
+            for s in sockets:
+                assert(int(self._ReceiveReply(s)) == dof)
+            sockets[ivalues%len(sockets)].sendall('body_getjoints %d\n'%robotid)
+            reply = array([float(x) for x in self._ReceiveReply(sockets[ivalues%len(sockets)]).split()])
+            assert(transdist(reply, values) <= 1e-4)
+
+        # the waits of two clients do not keep the two query threads from answering a third client
+        with env:
+            robot.SetActiveDOFs(range(dof))
+            initvalues = robot.GetActiveDOFValues()
+            goalvalues = array(initvalues)
+            goalvalues[0] += 0.3 if goalvalues[0]+0.3 <= robot.GetDOFLimits()[1][0] else -0.3
+            traj=RaveCreateTrajectory(env, '')
+            traj.Init(robot.GetActiveConfigurationSpecification('quadratic'))
+            traj.Insert(0,r_[initvalues,goalvalues])
+            planningutils.RetimeActiveDOFTrajectory(traj,robot,False,0.1,0.1,'ParabolicTrajectoryRetimer2')
+            assert(traj.GetDuration() > 0.5)
+            robot.GetController().SetPath(traj)
+        env.StartSimulation(0.01,realtime=True)
+        try:
+            for s in sockets[:2]:
+                s.sendall('wait %d 10\n'%robotid)
+            time.sleep(0.1)
+            sockets[2].sendall('body_getdof %d\n'%robotid)
+            assert(int(self._ReceiveReply(sockets[2])) == dof)
+            assert(not robot.GetController().IsDone())
+            for s in sockets[:2]:
+                assert(self._ReceiveReply(s) == '1')
+            assert(robot.GetController().IsDone())
+        finally:
+            env.StopSimulation()
+
+    def test_stats(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot = env.GetRobots()[0]
+        s = self._Connect()
+        s.sendall('stats reset\n')
+        self._ReceiveReply(s)
+        numqueries = 20
+        s.sendall(''.join(['body_getdof %d\n'%robot.GetEnvironmentId()]*numqueries))
+        for i in range(numqueries):
+            self._ReceiveReply(s)
+        s.sendall('stats\n')
+        stats = {}
+        for line in self._ReceiveReply(s).splitlines():
+            values = line.split()
+            # name count mean max p50 p99 and the 24 bins of the histogram
+            assert(len(values) == 30)
+            stats[values[0]] = [int(v) for v in values[1:]]
+        assert(sorted(stats.keys()) == ['body_getdof', 'stats'])
+        count, meantime, maxtime, p50, p99 = stats['body_getdof'][0:5]
+        assert(count == numqueries and sum(stats['body_getdof'][5:]) == numqueries)
+        assert(meantime <= maxtime and p50 <= p99 and p99 <= maxtime)
+        assert(stats['stats'][0] == 1)
+
+    def _SendFrame(self, s, opcode, ints, values):
+        """sends a binary frame: size of the rest of the frame, opcode, reserved, number of ints, the ints and the values"""
+        data = struct.pack('<HHI', opcode, 0, len(ints)) + struct.pack('<%di'%len(ints), *ints) + struct.pack('<%dd'%len(values), *values)
+        s.sendall(struct.pack('<I', len(data)) + data)
+
+    def _ReceiveFrame(self, s):
+        """returns the opcode, status, ints and values of a binary reply frame"""
+        size = struct.unpack('<I', self._Receive(s,4))[0]
+        data = self._Receive(s,size)
+        opcode, status, numints = struct.unpack('<HHI', data[0:8])
+        ints = struct.unpack('<%di'%numints, data[8:8+4*numints])
+        values = struct.unpack('<%dd'%((size-8-4*numints)/8), data[8+4*numints:])
+        return opcode, status, list(ints), array(values)
+
+    def test_binary(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot = env.GetRobots()[0]
+        robotid = robot.GetEnvironmentId()
+        dof = robot.GetDOF()
+        s = self._Connect()
+        values0, values1 = self._GetTestValues(robot, 2)
+        # the first frame is sent right after the line of the binary command, before its reply
+        s.sendall('binary\n')
+        self._SendFrame(s, 2, [robotid], values0) # BC_SetDOFValues
+        assert(self._ReceiveReply(s).split() == ['1', '8'])
+        assert(self._ReceiveFrame(s)[0:3] == (2, 0, []))
+        self._SendFrame(s, 1, [robotid], []) # BC_GetDOFValues
+        opcode, status, ints, values = self._ReceiveFrame(s)
+        assert(opcode == 1 and status == 0)
+        assert(transdist(values, values0) <= g_epsilon)
+
+        # pipelined frames reply in order
+        self._SendFrame(s, 2, [robotid], values1)
+        self._SendFrame(s, 1, [robotid, 0], [])
+        self._SendFrame(s, 3, [robotid], []) # BC_GetTransform
+        assert(self._ReceiveFrame(s)[0:2] == (2, 0))
+        opcode, status, ints, values = self._ReceiveFrame(s)
+        assert(opcode == 1 and status == 0 and len(values) == 1 and abs(values[0]-values1[0]) <= g_epsilon)
+        opcode, status, ints, values = self._ReceiveFrame(s)
+        T = robot.GetTransform()
+        assert(opcode == 3 and status == 0)
+        assert(transdist(matrixFromQuat(values[0:4])[0:3,0:3], T[0:3,0:3]) <= g_epsilon and transdist(values[4:7], T[0:3,3]) <= g_epsilon)
+        assert(transdist(robot.GetDOFValues(), values1) <= g_epsilon)
+
+        # unknown opcodes and bodies fail without closing the connection
+        self._SendFrame(s, 100, [robotid], [])
+        opcode, status, ints, values = self._ReceiveFrame(s)
+        assert(opcode == 100 and status == 1 and len(ints) == 0 and len(values) == 0)
+        self._SendFrame(s, 1, [-1], [])
+        assert(self._ReceiveFrame(s)[0:2] == (1, 1))
+        self._SendFrame(s, 1, [robotid], [])
+        assert(self._ReceiveFrame(s)[0:2] == (1, 0))
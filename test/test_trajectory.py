@@ -866,3 +866,124 @@ class TestTrajectory(EnvironmentSetup):
         planningutils.SegmentTrajectory(traj, startoffset, duration)
         assert( abs(traj.GetDuration() - (duration-startoffset)) <= g_epsilon )
 
+
+    def test_samplerange(self):
+        env=self.env
+        trajstr = '''<trajectory>
+<configuration>
+<group name="deltatime" offset="12" dof="1" interpolation=""/>
+<group name="joint_velocities muratecpicker0 0 1 2 3 4 5" offset="6" dof="6" interpolation="linear"/>
+<group name="joint_values muratecpicker0 0 1 2 3 4 5" offset="0" dof="6" interpolation="quadratic"/>
+<group name="iswaypoint" offset="13" dof="1" interpolation="next"/>
+</configuration>
+<data count="3">
+0.6117269650558744 0.9266602002674107 0.8438166789174414 0 1.371115774404944 -0.9590693617390226 0 0 0 0 0 0 0 1 1.17529158313744 0.189183598445679 1.49708779104353 -0.001910739864792349 1.446569660068643 0.1559566101894805 2.196724161297836 -2.874617422095069 2.546392001631284 -0.00744789202919198 0.294112455578719 4.346270887885016 0.5130954791780579 0 1.738856201219005 -0.5482930033760525 2.150358903169619 -0.003821479729584697 1.522023545732342 1.270982582117983 0 0 0 0 0 0 0.5130954791780579 1 </data>
+</trajectory>
+        '''
+        traj=RaveCreateTrajectory(env, '')
+        traj.deserialize(trajstr)
+        duration = traj.GetDuration()
+        deltatime = 0.01
+        times = arange(0,duration+deltatime,deltatime)
+        times = times[times <= duration]
+        data = traj.SampleRange2D(0,duration,deltatime)
+        assert(data.shape == (len(times),traj.GetConfigurationSpecification().GetDOF()))
+        for i,t in enumerate(times):
+            assert(transdist(data[i],traj.Sample(t)) <= g_epsilon)
+
+        # times that are not increasing have to give the same result
+        shuffledtimes = array(times)
+        numpy.random.shuffle(shuffledtimes)
+        shuffleddata = traj.SamplePoints2D(shuffledtimes)
+        for i,t in enumerate(shuffledtimes):
+            assert(transdist(shuffleddata[i],traj.Sample(t)) <= g_epsilon)
+
+        spec = ConfigurationSpecification(traj.GetConfigurationSpecification().GetGroupFromName('joint_values'))
+        specdata = traj.SampleRange2D(0.1,duration,0.05,spec)
+        for i in range(specdata.shape[0]):
+            assert(transdist(specdata[i],traj.Sample(0.1+i*0.05,spec)) <= g_epsilon)
+
+        # the higher degree polynomials, the velocities and accelerations are given so every degree is used
+        randomstate = numpy.random.RandomState(0)
+        for interpolation in ['cubic','quartic','quintic']:
+            numpoints = 5
+            data = randomstate.rand(numpoints,10)
+            data[:,9] = 0.1+randomstate.rand(numpoints)
+            data[0,9] = 0
+            trajstr = '''<trajectory>
+<configuration>
+<group name="joint_values dummy 0 1 2" offset="0" dof="3" interpolation="%s"/>
+<group name="joint_velocities dummy 0 1 2" offset="3" dof="3" interpolation="quadratic"/>
+<group name="joint_accelerations dummy 0 1 2" offset="6" dof="3" interpolation="linear"/>
+<group name="deltatime" offset="9" dof="1" interpolation=""/>
+</configuration>
+<data count="%d">
+%s
+</data>
+</trajectory>
+'''%(interpolation,numpoints,' '.join(str(f) for f in data.flat))
+            traj=RaveCreateTrajectory(env, '')
+            traj.deserialize(trajstr)
+            duration = traj.GetDuration()
+            times = arange(0,duration+deltatime,deltatime)
+            times = times[times <= duration]
+            data = traj.SampleRange2D(0,duration,deltatime)
+            assert(data.shape[0] == len(times))
+            for i,t in enumerate(times):
+                assert(transdist(data[i],traj.Sample(t)) <= g_epsilon)
+            shuffledtimes = array(times)
+            randomstate.shuffle(shuffledtimes)
+            shuffleddata = traj.SamplePoints2D(shuffledtimes)
+            for i,t in enumerate(shuffledtimes):
+                assert(transdist(shuffleddata[i],traj.Sample(t)) <= g_epsilon)
+
+    def test_numpyinsert(self):
+        env=self.env
+        self.LoadEnv('robots/barrettwam.robot.xml')
+        robot=env.GetRobots()[0]
+        spec=robot.GetActiveConfigurationSpecification()
+        spec.AddDeltaTimeGroup()
+        dof=spec.GetDOF()
+        data=numpy.random.rand(20,dof)
+        reference=RaveCreateTrajectory(env,'')
+        reference.Init(spec)
+        reference.Insert(0,list(data.flat))
+        # contiguous, converted, strided and flat-iterated numpy arrays have to give the same waypoints as a list, float32 loses precision
+        for odata in [data.flatten(), data.flatten().astype(float32), data.T.copy().T.flat, data.flat, data[:,::-1][:,::-1].flat]:
+            traj=RaveCreateTrajectory(env,'')
+            traj.Init(spec)
+            traj.Insert(0,odata)
+            assert(traj.GetNumWaypoints() == data.shape[0])
+            assert(transdist(traj.GetWaypoints(0,traj.GetNumWaypoints()),reference.GetWaypoints(0,reference.GetNumWaypoints())) <= 1e-4)
+
+        # a flat iterator gives its remaining values like list(it)
+        it=data.flat
+        for i in range(dof):
+            it.next()
+        traj=RaveCreateTrajectory(env,'')
+        traj.Init(spec)
+        traj.Insert(0,it)
+        assert(traj.GetNumWaypoints() == data.shape[0]-1)
+        assert(transdist(traj.GetWaypoints(0,traj.GetNumWaypoints()),reference.GetWaypoints(1,reference.GetNumWaypoints())) <= g_epsilon)
+
+        # multi-dimensional arrays are not flattened silently
+        traj=RaveCreateTrajectory(env,'')
+        traj.Init(spec)
+        try:
+            traj.Insert(0,data)
+            assert(False)
+        except openrave_exception:
+            pass
+        assert(traj.GetNumWaypoints() == 0)
+
+        with robot:
+            lower,upper=robot.GetDOFLimits()
+            values=0.5*(lower+upper)
+            for ovalues in [values, values.astype(float32), list(values)]:
+                robot.SetDOFValues(ovalues)
+                assert(transdist(robot.GetDOFValues(),values) <= 1e-4)
+            T=matrixFromAxisAngle([0.1,0.2,0.3])
+            T[0:3,3]=[0.1,-0.2,0.3]
+            for oT in [T, T[0:3,:], T.astype(float32), poseFromMatrix(T), T.tolist()]:
+                robot.SetTransform(oT)
+                assert(transdist(robot.GetTransform(),T) <= 1e-4)